@@ -41,6 +41,8 @@
 #define PDUMP_RING_SIZE_ARG "ring-size"
 #define PDUMP_MSIZE_ARG "mbuf-size"
 #define PDUMP_NUM_MBUFS_ARG "total-num-mbufs"
+#define PDUMP_SNAPLEN_ARG "snaplen"
+#define PDUMP_ZERO_COPY_ARG "zero-copy"
 
 #define VDEV_NAME_FMT "net_pcap_%s_%d"
 #define VDEV_PCAP_ARGS_FMT "tx_pcap=%s"
@@ -97,6 +99,8 @@ static const char * const valid_pdump_arguments[] = {
 	PDUMP_RING_SIZE_ARG,
 	PDUMP_MSIZE_ARG,
 	PDUMP_NUM_MBUFS_ARG,
+	PDUMP_SNAPLEN_ARG,
+	PDUMP_ZERO_COPY_ARG,
 	NULL
 };
 
@@ -116,6 +120,8 @@ struct pdump_tuples {
 	uint32_t ring_size;
 	uint16_t mbuf_data_size;
 	uint32_t total_num_mbufs;
+	uint32_t snaplen;
+	bool zero_copy;
 
 	/* params for library API call */
 	uint32_t dir;
@@ -160,7 +166,9 @@ pdump_usage(const char *prgname)
 			" tx-dev=<iface or pcap file>,"
 			"[ring-size=<ring size>default:16384],"
 			"[mbuf-size=<mbuf data size>default:2176],"
-			"[total-num-mbufs=<number of mbufs>default:65535]'\n",
+			"[total-num-mbufs=<number of mbufs>default:65535],"
+			"[snaplen=<bytes captured per packet>default:0],"
+			"[zero-copy=<0|1>default:0]'\n",
 			prgname);
 }
 
@@ -370,6 +378,32 @@ parse_pdump(const char *optarg)
 	} else
 		pt->total_num_mbufs = MBUFS_PER_POOL;
 
+	/* snaplen parsing and validation */
+	cnt1 = rte_kvargs_count(kvlist, PDUMP_SNAPLEN_ARG);
+	if (cnt1 == 1) {
+		v.min = 0;
+		v.max = UINT32_MAX;
+		ret = rte_kvargs_process(kvlist, PDUMP_SNAPLEN_ARG,
+						&parse_uint_value, &v);
+		if (ret < 0)
+			goto free_kvlist;
+		pt->snaplen = (uint32_t) v.val;
+	} else
+		pt->snaplen = 0;
+
+	/* zero_copy parsing and validation */
+	cnt1 = rte_kvargs_count(kvlist, PDUMP_ZERO_COPY_ARG);
+	if (cnt1 == 1) {
+		v.min = 0;
+		v.max = 1;
+		ret = rte_kvargs_process(kvlist, PDUMP_ZERO_COPY_ARG,
+						&parse_uint_value, &v);
+		if (ret < 0)
+			goto free_kvlist;
+		pt->zero_copy = (v.val == 1);
+	} else
+		pt->zero_copy = false;
+
 	num_tuples++;
 
 free_kvlist:
@@ -827,52 +861,60 @@ enable_pdump(void)
 	int i;
 	struct pdump_tuples *pt;
 	int ret = 0, ret1 = 0;
+	uint32_t zero_copy;
 
 	for (i = 0; i < num_tuples; i++) {
 		pt = &pdump_t[i];
+		zero_copy = pt->zero_copy ? RTE_PDUMP_FLAG_ZERO_COPY : 0;
 		if (pt->dir == RTE_PDUMP_FLAG_RXTX) {
 			if (pt->dump_by_type == DEVICE_ID) {
-				ret = rte_pdump_enable_by_deviceid(
+				ret = rte_pdump_enable_bpf_by_deviceid(
 						pt->device_id,
 						pt->queue,
-						RTE_PDUMP_FLAG_RX,
+						RTE_PDUMP_FLAG_RX | zero_copy,
+						pt->snaplen,
 						pt->rx_ring,
 						pt->mp, NULL);
-				ret1 = rte_pdump_enable_by_deviceid(
+				ret1 = rte_pdump_enable_bpf_by_deviceid(
 						pt->device_id,
 						pt->queue,
 						RTE_PDUMP_FLAG_TX,
+						pt->snaplen,
 						pt->tx_ring,
 						pt->mp, NULL);
 			} else if (pt->dump_by_type == PORT_ID) {
-				ret = rte_pdump_enable(pt->port, pt->queue,
-						RTE_PDUMP_FLAG_RX,
+				ret = rte_pdump_enable_bpf(pt->port, pt->queue,
+						RTE_PDUMP_FLAG_RX | zero_copy,
+						pt->snaplen,
 						pt->rx_ring, pt->mp, NULL);
-				ret1 = rte_pdump_enable(pt->port, pt->queue,
+				ret1 = rte_pdump_enable_bpf(pt->port, pt->queue,
 						RTE_PDUMP_FLAG_TX,
+						pt->snaplen,
 						pt->tx_ring, pt->mp, NULL);
 			}
 		} else if (pt->dir == RTE_PDUMP_FLAG_RX) {
 			if (pt->dump_by_type == DEVICE_ID)
-				ret = rte_pdump_enable_by_deviceid(
+				ret = rte_pdump_enable_bpf_by_deviceid(
 						pt->device_id,
 						pt->queue,
-						pt->dir, pt->rx_ring,
+						pt->dir | zero_copy,
+						pt->snaplen, pt->rx_ring,
 						pt->mp, NULL);
 			else if (pt->dump_by_type == PORT_ID)
-				ret = rte_pdump_enable(pt->port, pt->queue,
-						pt->dir,
+				ret = rte_pdump_enable_bpf(pt->port, pt->queue,
+						pt->dir | zero_copy,
+						pt->snaplen,
 						pt->rx_ring, pt->mp, NULL);
 		} else if (pt->dir == RTE_PDUMP_FLAG_TX) {
 			if (pt->dump_by_type == DEVICE_ID)
-				ret = rte_pdump_enable_by_deviceid(
+				ret = rte_pdump_enable_bpf_by_deviceid(
 						pt->device_id,
 						pt->queue,
-						pt->dir,
+						pt->dir, pt->snaplen,
 						pt->tx_ring, pt->mp, NULL);
 			else if (pt->dump_by_type == PORT_ID)
-				ret = rte_pdump_enable(pt->port, pt->queue,
-						pt->dir,
+				ret = rte_pdump_enable_bpf(pt->port, pt->queue,
+						pt->dir, pt->snaplen,
 						pt->tx_ring, pt->mp, NULL);
 		}
 		if (ret < 0 || ret1 < 0) {
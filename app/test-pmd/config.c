@@ -3097,7 +3097,7 @@ setup_gro(const char *onoff, portid_t port_id)
 			return;
 		}
 		if (gro_flush_cycles == GRO_DEFAULT_FLUSH_CYCLES) {
-			gro_ports[port_id].param.gro_types = RTE_GRO_TCP_IPV4;
+			gro_ports[port_id].param.gro_types = GRO_DEFAULT_TYPES;
 			gro_ports[port_id].param.max_flow_num =
 				GRO_DEFAULT_FLOW_NUM;
 			gro_ports[port_id].param.max_item_per_flow =
@@ -3148,7 +3148,8 @@ show_gro(portid_t port_id)
 		return;
 	}
 	if (gro_ports[port_id].enable) {
-		printf("GRO type: TCP/IPv4\n");
+		printf("GRO type: TCP/IPv4, TCP/IPv6, UDP/IPv4 and UDP/IPv6 "
+				"fragments\n");
 		if (gro_flush_cycles == GRO_DEFAULT_FLUSH_CYCLES) {
 			max_pkts_num = param->max_flow_num *
 				param->max_item_per_flow;
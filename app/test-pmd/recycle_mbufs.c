@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_branch_prediction.h>
+#include <rte_mbuf.h>
+#include <rte_ethdev.h>
+
+#include "testpmd.h"
+
+/*
+ * Get the Rx queue information needed to recycle mbufs for all the
+ * streams receiving on this port. Streams whose Rx queue does not
+ * support recycling fall back to plain I/O forwarding.
+ */
+static void
+recycle_mbufs_fwd_begin(portid_t pi)
+{
+	struct fwd_stream *fs;
+	streamid_t sm_id;
+	int ret;
+
+	for (sm_id = 0; sm_id < cur_fwd_config.nb_fwd_streams; sm_id++) {
+		fs = fwd_streams[sm_id];
+		if (fs->rx_port != pi)
+			continue;
+
+		ret = rte_eth_recycle_rx_queue_info_get(fs->rx_port,
+				fs->rx_queue, &fs->recycle_rxq_info);
+		if (ret != 0) {
+			memset(&fs->recycle_rxq_info, 0,
+			       sizeof(fs->recycle_rxq_info));
+			printf("Port %u Rx queue %u does not support mbufs "
+			       "recycling (%d), using I/O forwarding\n",
+			       fs->rx_port, fs->rx_queue, ret);
+		}
+	}
+}
+
+/*
+ * Forwarding of packets in I/O mode, with the mbufs freed by the Tx queue
+ * moved straight into the Rx queue mbuf ring instead of going through the
+ * mempool.
+ */
+static void
+pkt_burst_recycle_mbufs(struct fwd_stream *fs)
+{
+	struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+	uint16_t nb_rx;
+	uint16_t nb_tx;
+	uint32_t retry;
+
+#ifdef RTE_TEST_PMD_RECORD_CORE_CYCLES
+	uint64_t start_tsc;
+	uint64_t end_tsc;
+	uint64_t core_cycles;
+#endif
+
+#ifdef RTE_TEST_PMD_RECORD_CORE_CYCLES
+	start_tsc = rte_rdtsc();
+#endif
+
+	/*
+	 * Recycle mbufs from the Tx queue into the Rx queue.
+	 */
+	if (likely(fs->recycle_rxq_info.mbuf_ring != NULL))
+		rte_eth_recycle_mbufs(fs->rx_port, fs->rx_queue,
+				fs->tx_port, fs->tx_queue,
+				&fs->recycle_rxq_info);
+
+	/*
+	 * Receive a burst of packets and forward them.
+	 */
+	nb_rx = rte_eth_rx_burst(fs->rx_port, fs->rx_queue,
+			pkts_burst, nb_pkt_per_burst);
+#ifdef RTE_TEST_PMD_RECORD_BURST_STATS
+	fs->rx_burst_stats.pkt_burst_spread[nb_rx]++;
+#endif
+	if (unlikely(nb_rx == 0))
+		return;
+	fs->rx_packets += nb_rx;
+
+	nb_tx = rte_eth_tx_burst(fs->tx_port, fs->tx_queue,
+			pkts_burst, nb_rx);
+	/*
+	 * Retry if necessary
+	 */
+	if (unlikely(nb_tx < nb_rx) && fs->retry_enabled) {
+		retry = 0;
+		while (nb_tx < nb_rx && retry++ < burst_tx_retry_num) {
+			rte_delay_us(burst_tx_delay_time);
+			nb_tx += rte_eth_tx_burst(fs->tx_port, fs->tx_queue,
+					&pkts_burst[nb_tx], nb_rx - nb_tx);
+		}
+	}
+	fs->tx_packets += nb_tx;
+#ifdef RTE_TEST_PMD_RECORD_BURST_STATS
+	fs->tx_burst_stats.pkt_burst_spread[nb_tx]++;
+#endif
+	if (unlikely(nb_tx < nb_rx)) {
+		fs->fwd_dropped += (nb_rx - nb_tx);
+		do {
+			rte_pktmbuf_free(pkts_burst[nb_tx]);
+		} while (++nb_tx < nb_rx);
+	}
+#ifdef RTE_TEST_PMD_RECORD_CORE_CYCLES
+	end_tsc = rte_rdtsc();
+	core_cycles = (end_tsc - start_tsc);
+	fs->core_cycles = (uint64_t) (fs->core_cycles + core_cycles);
+#endif
+}
+
+struct fwd_engine recycle_mbufs_engine = {
+	.fwd_mode_name  = "recycle_mbufs",
+	.port_fwd_begin = recycle_mbufs_fwd_begin,
+	.port_fwd_end   = NULL,
+	.packet_fwd     = pkt_burst_recycle_mbufs,
+};
@@ -180,6 +180,7 @@ struct fwd_engine * fwd_engines[] = {
 	&icmp_echo_engine,
 	&noisy_vnf_engine,
 	&five_tuple_swap_fwd_engine,
+	&recycle_mbufs_engine,
 #ifdef RTE_LIBRTE_IEEE1588
 	&ieee1588_fwd_engine,
 #endif
@@ -1553,7 +1554,7 @@ init_config(void)
 	fwd_config_setup();
 
 	/* create a gro context for each lcore */
-	gro_param.gro_types = RTE_GRO_TCP_IPV4;
+	gro_param.gro_types = GRO_DEFAULT_TYPES;
 	gro_param.max_flow_num = GRO_MAX_FLUSH_CYCLES;
 	gro_param.max_item_per_flow = MAX_PKT_BURST;
 	for (lc_id = 0; lc_id < nb_lcores; lc_id++) {
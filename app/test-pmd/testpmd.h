@@ -119,6 +119,8 @@ struct fwd_stream {
 	streamid_t peer_addr; /**< index of peer ethernet address of packets */
 
 	unsigned int retry_enabled;
+	struct rte_eth_recycle_rxq_info recycle_rxq_info;
+	/**< Rx queue information to recycle mbufs, used by recycle_mbufs */
 
 	/* "read-write" results */
 	uint64_t rx_packets;  /**< received packets */
@@ -248,6 +250,7 @@ extern struct fwd_engine csum_fwd_engine;
 extern struct fwd_engine icmp_echo_engine;
 extern struct fwd_engine noisy_vnf_engine;
 extern struct fwd_engine five_tuple_swap_fwd_engine;
+extern struct fwd_engine recycle_mbufs_engine;
 #ifdef RTE_LIBRTE_IEEE1588
 extern struct fwd_engine ieee1588_fwd_engine;
 #endif
@@ -463,6 +466,8 @@ extern struct rte_ether_addr peer_eth_addrs[RTE_MAX_ETHPORTS];
 extern uint32_t burst_tx_delay_time; /**< Burst tx delay time(us) for mac-retry. */
 extern uint32_t burst_tx_retry_num;  /**< Burst tx retry number for mac-retry. */
 
+#define GRO_DEFAULT_TYPES (RTE_GRO_TCP_IPV4 | RTE_GRO_TCP_IPV6 | \
+		RTE_GRO_UDP_IPV4 | RTE_GRO_UDP_IPV6)
 #define GRO_DEFAULT_ITEM_NUM_PER_FLOW 32
 #define GRO_DEFAULT_FLOW_NUM (RTE_GRO_MAX_BURST_ITEM_NUM / \
 		GRO_DEFAULT_ITEM_NUM_PER_FLOW)
@@ -584,6 +584,12 @@
         "Func":    default_autotest,
         "Report":  None,
     },
+    {
+        "Name":    "GSO autotest",
+        "Command": "gso_autotest",
+        "Func":    default_autotest,
+        "Report":  None,
+    },
     #
     #Please always keep all dump tests at the end and together!
     #
@@ -717,6 +723,12 @@
         "Func":    default_autotest,
         "Report":  None,
     },
+    {
+        "Name":    "GSO performance autotest",
+        "Command": "gso_perf_autotest",
+        "Func":    default_autotest,
+        "Report":  None,
+    },
     {
 
         "Name":    "Pmd perf autotest",
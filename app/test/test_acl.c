@@ -266,101 +266,129 @@ rte_acl_ipv4vlan_build(struct rte_acl_ctx *ctx,
 }
 
 /*
- * Test scalar and SSE ACL lookup.
+ * Check classify results for the first dim entries of the test data.
  */
 static int
-test_classify_run(struct rte_acl_ctx *acx, struct ipv4_7tuple test_data[],
-	size_t dim)
+test_classify_verify(const struct ipv4_7tuple test_data[],
+	const uint32_t results[], size_t dim)
 {
-	int ret, i;
-	uint32_t result, count;
+	int i;
+	uint32_t result;
+
+	/* check if we allow everything we should allow */
+	for (i = 0; i < (int) dim; i++) {
+		result = results[i * RTE_ACL_MAX_CATEGORIES + ACL_ALLOW];
+		if (result != test_data[i].allow) {
+			printf("Line %i: Error in allow results at %i "
+				"(expected %"PRIu32" got %"PRIu32")!\n",
+				__LINE__, i, test_data[i].allow,
+				result);
+			return -EINVAL;
+		}
+	}
+
+	/* check if we deny everything we should deny */
+	for (i = 0; i < (int) dim; i++) {
+		result = results[i * RTE_ACL_MAX_CATEGORIES + ACL_DENY];
+		if (result != test_data[i].deny) {
+			printf("Line %i: Error in deny results at %i "
+				"(expected %"PRIu32" got %"PRIu32")!\n",
+				__LINE__, i, test_data[i].deny,
+				result);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Test ACL lookup with given classify method.
+ * Silently skip the methods not supported by the given platform.
+ */
+static int
+test_classify_alg(struct rte_acl_ctx *acx, struct ipv4_7tuple test_data[],
+	const uint8_t *data[], size_t dim, enum rte_acl_classify_alg alg)
+{
+	int ret;
+	uint32_t count;
 	uint32_t results[dim * RTE_ACL_MAX_CATEGORIES];
-	const uint8_t *data[dim];
-	/* swap all bytes in the data to network order */
-	bswap_test_data(test_data, dim, 1);
 
-	/* store pointers to test data */
-	for (i = 0; i < (int) dim; i++)
-		data[i] = (uint8_t *)&test_data[i];
+	ret = rte_acl_set_ctx_classify(acx, alg);
+	if (ret == -ENOTSUP)
+		return 0;
+	else if (ret != 0) {
+		printf("Line %i: rte_acl_set_ctx_classify(%d) failed!\n",
+			__LINE__, alg);
+		return ret;
+	}
 
 	/**
 	 * these will run quite a few times, it's necessary to test code paths
-	 * from num=0 to num>8
+	 * from num=0 to num>32
 	 */
 	for (count = 0; count <= dim; count++) {
 		ret = rte_acl_classify(acx, data, results,
 				count, RTE_ACL_MAX_CATEGORIES);
 		if (ret != 0) {
-			printf("Line %i: SSE classify failed!\n", __LINE__);
-			goto err;
-		}
-
-		/* check if we allow everything we should allow */
-		for (i = 0; i < (int) count; i++) {
-			result =
-				results[i * RTE_ACL_MAX_CATEGORIES + ACL_ALLOW];
-			if (result != test_data[i].allow) {
-				printf("Line %i: Error in allow results at %i "
-					"(expected %"PRIu32" got %"PRIu32")!\n",
-					__LINE__, i, test_data[i].allow,
-					result);
-				ret = -EINVAL;
-				goto err;
-			}
+			printf("Line %i: classify(alg=%d) failed!\n",
+				__LINE__, alg);
+			return ret;
 		}
 
-		/* check if we deny everything we should deny */
-		for (i = 0; i < (int) count; i++) {
-			result = results[i * RTE_ACL_MAX_CATEGORIES + ACL_DENY];
-			if (result != test_data[i].deny) {
-				printf("Line %i: Error in deny results at %i "
-					"(expected %"PRIu32" got %"PRIu32")!\n",
-					__LINE__, i, test_data[i].deny,
-					result);
-				ret = -EINVAL;
-				goto err;
-			}
+		ret = test_classify_verify(test_data, results, count);
+		if (ret != 0) {
+			printf("Line %i: classify(alg=%d) returned "
+				"wrong results!\n", __LINE__, alg);
+			return ret;
 		}
 	}
 
-	/* make a quick check for scalar */
+	/* make a quick check for the explicit classify method call */
 	ret = rte_acl_classify_alg(acx, data, results,
-			dim, RTE_ACL_MAX_CATEGORIES,
-			RTE_ACL_CLASSIFY_SCALAR);
+			dim, RTE_ACL_MAX_CATEGORIES, alg);
 	if (ret != 0) {
-		printf("Line %i: scalar classify failed!\n", __LINE__);
-		goto err;
+		printf("Line %i: classify_alg(alg=%d) failed!\n",
+			__LINE__, alg);
+		return ret;
 	}
 
-	/* check if we allow everything we should allow */
-	for (i = 0; i < (int) dim; i++) {
-		result = results[i * RTE_ACL_MAX_CATEGORIES + ACL_ALLOW];
-		if (result != test_data[i].allow) {
-			printf("Line %i: Error in allow results at %i "
-					"(expected %"PRIu32" got %"PRIu32")!\n",
-					__LINE__, i, test_data[i].allow,
-					result);
-			ret = -EINVAL;
-			goto err;
-		}
-	}
+	return test_classify_verify(test_data, results, dim);
+}
 
-	/* check if we deny everything we should deny */
-	for (i = 0; i < (int) dim; i++) {
-		result = results[i * RTE_ACL_MAX_CATEGORIES + ACL_DENY];
-		if (result != test_data[i].deny) {
-			printf("Line %i: Error in deny results at %i "
-					"(expected %"PRIu32" got %"PRIu32")!\n",
-					__LINE__, i, test_data[i].deny,
-					result);
-			ret = -EINVAL;
-			goto err;
-		}
-	}
+/*
+ * Test ACL lookup with all classify methods available.
+ */
+static int
+test_classify_run(struct rte_acl_ctx *acx, struct ipv4_7tuple test_data[],
+	size_t dim)
+{
+	static const enum rte_acl_classify_alg alg[] = {
+		RTE_ACL_CLASSIFY_SCALAR,
+		RTE_ACL_CLASSIFY_SSE,
+		RTE_ACL_CLASSIFY_AVX2,
+		RTE_ACL_CLASSIFY_NEON,
+		RTE_ACL_CLASSIFY_ALTIVEC,
+		RTE_ACL_CLASSIFY_AVX512,
+	};
+
+	int ret, i;
+	const uint8_t *data[dim];
+
+	/* swap all bytes in the data to network order */
+	bswap_test_data(test_data, dim, 1);
+
+	/* store pointers to test data */
+	for (i = 0; i < (int) dim; i++)
+		data[i] = (uint8_t *)&test_data[i];
 
 	ret = 0;
+	for (i = 0; i != RTE_DIM(alg); i++) {
+		ret = test_classify_alg(acx, test_data, data, dim, alg[i]);
+		if (ret != 0)
+			break;
+	}
 
-err:
 	/* swap data back to cpu order so that next time tests don't fail */
 	bswap_test_data(test_data, dim, 0);
 	return ret;
@@ -8,11 +8,14 @@
 #include <inttypes.h>
 
 #include <rte_memory.h>
+#include <rte_malloc.h>
 #include <rte_debug.h>
 #include <rte_hexdump.h>
 #include <rte_random.h>
 #include <rte_byteorder.h>
 #include <rte_errno.h>
+#include <rte_lcore.h>
+#include <rte_rcu_qsbr.h>
 #include <rte_bpf.h>
 #include <rte_ether.h>
 #include <rte_ip.h>
@@ -3169,6 +3172,480 @@ static const struct bpf_test tests[] = {
 	},
 };
 
+/* map test-cases */
+
+/* indexes of the map handle loads within test_map1_prog */
+#define TEST_MAP1_LOOKUP_IDX	3
+#define TEST_MAP1_UPDATE_IDX	14
+#define TEST_MAP1_CHECK_IDX	8
+
+/*
+ * count calls per key (dummy_offset.u32):
+ * increment the value when the key is present, try to insert
+ * the value of 1 otherwise.
+ */
+static const struct ebpf_insn test_map1_prog[] = {
+
+	{
+		.code = (EBPF_ALU64 | EBPF_MOV | BPF_X),
+		.dst_reg = EBPF_REG_6,
+		.src_reg = EBPF_REG_1,
+	},
+	{
+		.code = (BPF_LDX | BPF_MEM | BPF_W),
+		.dst_reg = EBPF_REG_2,
+		.src_reg = EBPF_REG_6,
+		.off = offsetof(struct dummy_offset, u32),
+	},
+	{
+		.code = (BPF_STX | BPF_MEM | BPF_W),
+		.dst_reg = EBPF_REG_10,
+		.src_reg = EBPF_REG_2,
+		.off = -4,
+	},
+	[TEST_MAP1_LOOKUP_IDX] = {
+		.code = (BPF_LD | BPF_IMM | EBPF_DW),
+		.dst_reg = EBPF_REG_1,
+	},
+	{
+		.imm = 0,
+	},
+	{
+		.code = (EBPF_ALU64 | EBPF_MOV | BPF_X),
+		.dst_reg = EBPF_REG_2,
+		.src_reg = EBPF_REG_10,
+	},
+	{
+		.code = (EBPF_ALU64 | BPF_ADD | BPF_K),
+		.dst_reg = EBPF_REG_2,
+		.imm = -4,
+	},
+	{
+		.code = (BPF_JMP | EBPF_CALL),
+		.src_reg = EBPF_HELPER_CALL,
+		.imm = EBPF_FUNC_MAP_LOOKUP_ELEM,
+	},
+	[TEST_MAP1_CHECK_IDX] = {
+		.code = (BPF_JMP | BPF_JEQ | BPF_K),
+		.dst_reg = EBPF_REG_0,
+		.imm = 0,
+		.off = 4,
+	},
+	{
+		.code = (EBPF_ALU64 | EBPF_MOV | BPF_K),
+		.dst_reg = EBPF_REG_1,
+		.imm = 1,
+	},
+	{
+		.code = (BPF_STX | EBPF_XADD | EBPF_DW),
+		.dst_reg = EBPF_REG_0,
+		.src_reg = EBPF_REG_1,
+	},
+	{
+		.code = (BPF_LDX | BPF_MEM | EBPF_DW),
+		.dst_reg = EBPF_REG_0,
+		.src_reg = EBPF_REG_0,
+	},
+	{
+		.code = (BPF_JMP | EBPF_EXIT),
+	},
+	{
+		.code = (BPF_ST | BPF_MEM | EBPF_DW),
+		.dst_reg = EBPF_REG_10,
+		.off = -16,
+		.imm = 1,
+	},
+	[TEST_MAP1_UPDATE_IDX] = {
+		.code = (BPF_LD | BPF_IMM | EBPF_DW),
+		.dst_reg = EBPF_REG_1,
+	},
+	{
+		.imm = 0,
+	},
+	{
+		.code = (EBPF_ALU64 | EBPF_MOV | BPF_X),
+		.dst_reg = EBPF_REG_2,
+		.src_reg = EBPF_REG_10,
+	},
+	{
+		.code = (EBPF_ALU64 | BPF_ADD | BPF_K),
+		.dst_reg = EBPF_REG_2,
+		.imm = -4,
+	},
+	{
+		.code = (EBPF_ALU64 | EBPF_MOV | BPF_X),
+		.dst_reg = EBPF_REG_3,
+		.src_reg = EBPF_REG_10,
+	},
+	{
+		.code = (EBPF_ALU64 | BPF_ADD | BPF_K),
+		.dst_reg = EBPF_REG_3,
+		.imm = -16,
+	},
+	{
+		.code = (EBPF_ALU64 | EBPF_MOV | BPF_K),
+		.dst_reg = EBPF_REG_4,
+		.imm = RTE_BPF_MAP_UPDATE_NOEXIST,
+	},
+	{
+		.code = (BPF_JMP | EBPF_CALL),
+		.src_reg = EBPF_HELPER_CALL,
+		.imm = EBPF_FUNC_MAP_UPDATE_ELEM,
+	},
+	{
+		.code = (BPF_JMP | EBPF_EXIT),
+	},
+};
+
+/*
+ * expected return value of test_map1_prog for the n-th call with
+ * the same key: present keys are incremented, hash keys are inserted
+ * by the first call, which returns 0.
+ */
+static uint64_t
+test_map1_expected(enum rte_bpf_map_type type, uint32_t n)
+{
+	if (type == RTE_BPF_MAP_TYPE_HASH && n == 1)
+		return 0;
+	return n;
+}
+
+static void
+test_map1_set_handle(struct ebpf_insn *ins, const struct rte_bpf_map *map)
+{
+	ins[0].imm = (uintptr_t)map;
+	ins[1].imm = (uint64_t)(uintptr_t)map >> 32;
+}
+
+static int
+test_map1_run(struct rte_bpf *bpf, struct rte_bpf_map *map,
+	enum rte_bpf_map_type type)
+{
+	const uint32_t nb_calls = 3;
+	uint32_t i, n;
+	uint64_t rc, *v;
+	struct rte_bpf_jit jit;
+	struct dummy_offset dv;
+
+	memset(&dv, 0, sizeof(dv));
+	dv.u32 = 1;
+
+	rte_bpf_get_jit(bpf, &jit);
+
+	/* interpreter first, then JIT (when available) on the same map */
+	n = 0;
+	for (i = 0; i != 2 * nb_calls; i++) {
+		if (i < nb_calls)
+			rc = rte_bpf_exec(bpf, &dv);
+		else if (jit.func != NULL)
+			rc = jit.func(&dv);
+		else
+			break;
+
+		n++;
+		if (rc != test_map1_expected(type, n)) {
+			printf("%s@%d: map type %d, call %u: invalid return "
+				"value, expected: %" PRIu64 ", result: %"
+				PRIu64 "\n", __func__, __LINE__, type, n,
+				test_map1_expected(type, n), rc);
+			return -1;
+		}
+	}
+
+	/* check the value seen by the control path */
+	if (type == RTE_BPF_MAP_TYPE_PERCPU_ARRAY)
+		v = rte_bpf_map_lookup_lcore_elem(map, &dv.u32,
+			rte_lcore_id());
+	else
+		v = rte_bpf_map_lookup_elem(map, &dv.u32);
+	if (v == NULL || *v != n) {
+		printf("%s@%d: map type %d: invalid map value\n",
+			__func__, __LINE__, type);
+		return -1;
+	}
+
+	/* key out of range of the arrays */
+	dv.u32 = 8;
+	rc = rte_bpf_exec(bpf, &dv);
+	if (type != RTE_BPF_MAP_TYPE_HASH && (int64_t)rc != -E2BIG) {
+		printf("%s@%d: map type %d: out of range key accepted\n",
+			__func__, __LINE__, type);
+		return -1;
+	}
+
+	/* deleted key is inserted again */
+	if (type == RTE_BPF_MAP_TYPE_HASH) {
+		if (rte_bpf_map_delete_elem(map, &dv.u32) != 0 ||
+				rte_bpf_exec(bpf, &dv) != 0) {
+			printf("%s@%d: failed to re-insert deleted key\n",
+				__func__, __LINE__);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_map1(enum rte_bpf_map_type type)
+{
+	int32_t ret;
+	struct rte_bpf *bpf;
+	struct rte_bpf_map *map;
+	struct ebpf_insn ins[RTE_DIM(test_map1_prog)];
+	struct rte_bpf_xsym xsym;
+	struct rte_bpf_prm prm;
+	struct rte_bpf_map_prm mprm = {
+		.name = "test_map1",
+		.type = type,
+		.key_size = sizeof(uint32_t),
+		.value_size = sizeof(uint64_t),
+		.max_entries = 4,
+		.socket_id = SOCKET_ID_ANY,
+	};
+
+	map = rte_bpf_map_create(&mprm);
+	if (map == NULL) {
+		printf("%s@%d: failed to create map type %d, error=%d(%s);\n",
+			__func__, __LINE__, type, rte_errno,
+			strerror(rte_errno));
+		return -1;
+	}
+
+	memcpy(ins, test_map1_prog, sizeof(ins));
+	test_map1_set_handle(ins + TEST_MAP1_LOOKUP_IDX, map);
+	test_map1_set_handle(ins + TEST_MAP1_UPDATE_IDX, map);
+
+	memset(&xsym, 0, sizeof(xsym));
+	xsym.name = mprm.name;
+	xsym.type = RTE_BPF_XTYPE_MAP;
+	xsym.map.val = map;
+
+	memset(&prm, 0, sizeof(prm));
+	prm.ins = ins;
+	prm.nb_ins = RTE_DIM(ins);
+	prm.xsym = &xsym;
+	prm.nb_xsym = 1;
+	prm.prog_arg.type = RTE_BPF_ARG_PTR;
+	prm.prog_arg.size = sizeof(struct dummy_offset);
+
+	bpf = rte_bpf_load(&prm);
+	if (bpf == NULL) {
+		printf("%s@%d: failed to load bpf code, error=%d(%s);\n",
+			__func__, __LINE__, rte_errno, strerror(rte_errno));
+		rte_bpf_map_destroy(map);
+		return -1;
+	}
+
+	/* the program keeps the map alive */
+	rte_bpf_map_destroy(map);
+	if (rte_bpf_get_map(bpf, mprm.name) != map) {
+		printf("%s@%d: map is not referenced by the program\n",
+			__func__, __LINE__);
+		rte_bpf_destroy(bpf);
+		return -1;
+	}
+
+	ret = test_map1_run(bpf, map, type);
+	rte_bpf_destroy(bpf);
+	if (ret != 0)
+		return ret;
+
+	/* access to the map value without check against NULL */
+	map = rte_bpf_map_create(&mprm);
+	if (map == NULL)
+		return -1;
+
+	test_map1_set_handle(ins + TEST_MAP1_LOOKUP_IDX, map);
+	test_map1_set_handle(ins + TEST_MAP1_UPDATE_IDX, map);
+	xsym.map.val = map;
+	ins[TEST_MAP1_CHECK_IDX].dst_reg = EBPF_REG_6;
+
+	bpf = rte_bpf_load(&prm);
+	rte_bpf_map_destroy(map);
+	if (bpf != NULL) {
+		printf("%s@%d: unchecked map value access is accepted\n",
+			__func__, __LINE__);
+		rte_bpf_destroy(bpf);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * slots of deleted hash map elements are not reused while
+ * the reader hasn't reported a quiescent state.
+ */
+static int
+test_map2(void)
+{
+	int32_t ret;
+	uint32_t i, key;
+	uint64_t val, *v;
+	size_t sz;
+	struct rte_rcu_qsbr *qsv;
+	struct rte_bpf_map *map;
+	struct rte_bpf_map_prm mprm = {
+		.name = "test_map2",
+		.type = RTE_BPF_MAP_TYPE_HASH,
+		.key_size = sizeof(uint32_t),
+		.value_size = sizeof(uint64_t),
+		.max_entries = 8,
+		.socket_id = SOCKET_ID_ANY,
+	};
+
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = rte_zmalloc(NULL, sz, RTE_CACHE_LINE_SIZE);
+	if (qsv == NULL)
+		return -ENOMEM;
+	rte_rcu_qsbr_init(qsv, 1);
+	rte_rcu_qsbr_thread_register(qsv, 0);
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	ret = -1;
+	map = rte_bpf_map_create(&mprm);
+	if (map == NULL) {
+		printf("%s@%d: failed to create map, error=%d(%s);\n",
+			__func__, __LINE__, rte_errno, strerror(rte_errno));
+		goto out;
+	}
+
+	if (rte_bpf_map_rcu_qsbr_add(map, qsv) != 0 ||
+			rte_bpf_map_rcu_qsbr_add(map, qsv) != -EEXIST) {
+		printf("%s@%d: failed to attach RCU to the map\n",
+			__func__, __LINE__);
+		goto out;
+	}
+
+	key = 1;
+	val = UINT64_MAX;
+	rte_bpf_map_update_elem(map, &key, &val, RTE_BPF_MAP_UPDATE_ANY);
+	v = rte_bpf_map_lookup_elem(map, &key);
+	if (v == NULL || rte_bpf_map_delete_elem(map, &key) != 0 ||
+			rte_bpf_map_lookup_elem(map, &key) != NULL) {
+		printf("%s@%d: failed to delete the key\n",
+			__func__, __LINE__);
+		goto out;
+	}
+
+	/* churn the map until it runs out of slots */
+	for (i = 0; i != UINT16_MAX; i++) {
+		key = i + 2;
+		val = i;
+		if (rte_bpf_map_update_elem(map, &key, &val,
+				RTE_BPF_MAP_UPDATE_ANY) != 0)
+			break;
+		rte_bpf_map_delete_elem(map, &key);
+	}
+
+	if (i == UINT16_MAX || *v != UINT64_MAX) {
+		printf("%s@%d: deleted slots are reused "
+			"before the quiescent state\n", __func__, __LINE__);
+		goto out;
+	}
+
+	/* the slots are reclaimed once the reader is quiescent */
+	rte_rcu_qsbr_quiescent(qsv, 0);
+	if (rte_bpf_map_update_elem(map, &key, &val,
+			RTE_BPF_MAP_UPDATE_ANY) != 0) {
+		printf("%s@%d: deleted slots are not reclaimed\n",
+			__func__, __LINE__);
+		goto out;
+	}
+
+	ret = 0;
+out:
+	rte_bpf_map_destroy(map);
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	rte_rcu_qsbr_thread_unregister(qsv, 0);
+	rte_free(qsv);
+	return ret;
+}
+
+static int
+test_bpf_map(void)
+{
+	int32_t rc;
+
+	printf("%s start\n", __func__);
+
+	rc = test_map1(RTE_BPF_MAP_TYPE_ARRAY);
+	rc |= test_map1(RTE_BPF_MAP_TYPE_PERCPU_ARRAY);
+	rc |= test_map1(RTE_BPF_MAP_TYPE_HASH);
+	rc |= test_map2();
+
+	return rc;
+}
+
+/*
+ * run the test over a burst of inputs with the burst JIT code.
+ * all inputs are prepared with the same random seed, so each of them
+ * is expected to produce the same result as the interpreter does for
+ * the extra reference input.
+ */
+static int
+run_test_jit_burst(const struct bpf_test *tst, const struct rte_bpf *bpf,
+	const struct rte_bpf_jit_burst *jit)
+{
+	const uint32_t num = RTE_BPF_JIT_BURST_MAX;
+	int32_t ret, rv;
+	uint32_t i;
+	uint64_t msk, rc, seed;
+	size_t sz;
+	uint8_t *buf;
+	void *ctx[num + 1];
+
+	sz = RTE_ALIGN_CEIL(tst->arg_sz, RTE_CACHE_LINE_SIZE);
+	buf = rte_zmalloc(NULL, (num + 1) * sz, RTE_CACHE_LINE_SIZE);
+	if (buf == NULL) {
+		printf("%s@%d: failed to allocate %u inputs for %s;\n",
+			__func__, __LINE__, num, tst->name);
+		return -ENOMEM;
+	}
+
+	seed = rte_rand();
+	for (i = 0; i != num + 1; i++) {
+		ctx[i] = buf + i * sz;
+		rte_srand(seed);
+		tst->prepare(ctx[i]);
+	}
+
+	rc = rte_bpf_exec(bpf, ctx[num]);
+	ret = 0;
+
+	/* empty burst */
+	msk = jit->func(ctx, 0);
+	if (msk != 0) {
+		printf("%s@%d: %s: non-zero mask %#" PRIx64
+			" for empty burst;\n",
+			__func__, __LINE__, tst->name, msk);
+		ret = -1;
+	}
+
+	msk = jit->func(ctx, num);
+
+	for (i = 0; i != num; i++) {
+		if (((msk >> i) & 1) != (rc != 0)) {
+			printf("%s@%d: %s: invalid mask %#" PRIx64
+				" for input %u, return value: %#" PRIx64 ";\n",
+				__func__, __LINE__, tst->name, msk, i, rc);
+			ret = -1;
+		}
+		rv = tst->check_result(rc, ctx[i]);
+		if (rv != 0) {
+			printf("%s@%d: check_result(%s) failed for input %u, "
+				"error: %d(%s);\n",
+				__func__, __LINE__, tst->name, i,
+				rv, strerror(rv));
+			ret |= rv;
+		}
+	}
+
+	rte_free(buf);
+	return ret;
+}
+
 static int
 run_test(const struct bpf_test *tst)
 {
@@ -3176,6 +3653,7 @@ run_test(const struct bpf_test *tst)
 	int64_t rc;
 	struct rte_bpf *bpf;
 	struct rte_bpf_jit jit;
+	struct rte_bpf_jit_burst jit_burst;
 	uint8_t tbuf[tst->arg_sz];
 
 	printf("%s(%s) start\n", __func__, tst->name);
@@ -3211,6 +3689,11 @@ run_test(const struct bpf_test *tst)
 		}
 	}
 
+	/* and with burst jit, when possible */
+	rte_bpf_get_jit_burst(bpf, &jit_burst);
+	if (jit_burst.func != NULL)
+		ret |= run_test_jit_burst(tst, bpf, &jit_burst);
+
 	rte_bpf_destroy(bpf);
 	return ret;
 
@@ -3229,6 +3712,10 @@ test_bpf(void)
 			rc |= rv;
 	}
 
+	/* maps are accessed through function calls, 64 bit only */
+	if (sizeof(uint64_t) == sizeof(uintptr_t))
+		rc |= test_bpf_map();
+
 	return rc;
 }
 
@@ -563,6 +563,61 @@ int test_error_distributor_create_numworkers(void)
 }
 
 
+static
+int test_error_distributor_create_params(void)
+{
+	int worker_socket_id[RTE_MAX_LCORE] = { 0 };
+	struct rte_distributor_params params = {
+		.name = "test_params",
+		.socket_id = rte_socket_id(),
+		.num_workers = rte_lcore_count() - 1,
+		.alg_type = RTE_DIST_ALG_BURST,
+	};
+	struct rte_distributor *d;
+
+	params.burst_size = RTE_DIST_BURST_SIZE_MAX * 2;
+	d = rte_distributor_create_with_params(&params);
+	if (d != NULL || rte_errno != EINVAL) {
+		printf("ERROR: No error on create() with burst_size > MAX\n");
+		return -1;
+	}
+
+	params.burst_size = 12;
+	d = rte_distributor_create_with_params(&params);
+	if (d != NULL || rte_errno != EINVAL) {
+		printf("ERROR: No error on create() with invalid burst_size\n");
+		return -1;
+	}
+
+	params.burst_size = 0;
+	params.flags = ~RTE_DIST_FLAG_FLOW_TABLE;
+	d = rte_distributor_create_with_params(&params);
+	if (d != NULL || rte_errno != EINVAL) {
+		printf("ERROR: No error on create() with unknown flags\n");
+		return -1;
+	}
+
+	params.flags = 0;
+	params.worker_socket_id = worker_socket_id;
+	worker_socket_id[0] = RTE_MAX_NUMA_NODES;
+	d = rte_distributor_create_with_params(&params);
+	if (d != NULL || rte_errno != EINVAL) {
+		printf("ERROR: No error on create() with invalid worker socket\n");
+		return -1;
+	}
+
+	params.worker_socket_id = NULL;
+	params.alg_type = RTE_DIST_ALG_SINGLE;
+	params.flags = RTE_DIST_FLAG_FLOW_TABLE;
+	d = rte_distributor_create_with_params(&params);
+	if (d != NULL || rte_errno != EINVAL) {
+		printf("ERROR: No error on create() with flags in single mode\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 /* Useful function which ensures that all worker functions terminate */
 static void
 quit_workers(struct worker_params *wp, struct rte_mempool *p)
@@ -593,7 +648,8 @@ test_distributor(void)
 {
 	static struct rte_distributor *ds;
 	static struct rte_distributor *db;
-	static struct rte_distributor *dist[2];
+	static struct rte_distributor *dft;
+	static struct rte_distributor *dist[3];
 	static struct rte_mempool *p;
 	int i;
 
@@ -629,6 +685,25 @@ test_distributor(void)
 		rte_distributor_clear_returns(ds);
 	}
 
+	if (dft == NULL) {
+		struct rte_distributor_params params = {
+			.name = "Test_dist_flow_table",
+			.socket_id = rte_socket_id(),
+			.num_workers = rte_lcore_count() - 1,
+			.alg_type = RTE_DIST_ALG_BURST,
+			.flags = RTE_DIST_FLAG_FLOW_TABLE,
+		};
+
+		dft = rte_distributor_create_with_params(&params);
+		if (dft == NULL) {
+			printf("Error creating flow table distributor\n");
+			return -1;
+		}
+	} else {
+		rte_distributor_flush(dft);
+		rte_distributor_clear_returns(dft);
+	}
+
 	const unsigned nb_bufs = (511 * rte_lcore_count()) < BIG_BATCH ?
 			(BIG_BATCH * 2) - 1 : (511 * rte_lcore_count());
 	if (p == NULL) {
@@ -642,11 +717,15 @@ test_distributor(void)
 
 	dist[0] = ds;
 	dist[1] = db;
+	dist[2] = dft;
 
-	for (i = 0; i < 2; i++) {
+	for (i = 0; i < 3; i++) {
 
 		worker_params.dist = dist[i];
-		if (i)
+		if (i == 2)
+			strlcpy(worker_params.name, "burst flow table",
+					sizeof(worker_params.name));
+		else if (i)
 			strlcpy(worker_params.name, "burst",
 					sizeof(worker_params.name));
 		else
@@ -689,7 +768,8 @@ test_distributor(void)
 	}
 
 	if (test_error_distributor_create_numworkers() == -1 ||
-			test_error_distributor_create_name() == -1) {
+			test_error_distributor_create_name() == -1 ||
+			test_error_distributor_create_params() == -1) {
 		printf("rte_distributor_create parameter check tests failed");
 		return -1;
 	}
@@ -27,6 +27,9 @@ struct worker_stats {
 } __rte_cache_aligned;
 static struct worker_stats worker_stats[RTE_MAX_LCORE];
 
+/* worker id of each worker lcore, in lcore order */
+static unsigned int worker_ids[RTE_MAX_LCORE];
+
 /*
  * worker thread used for testing the time to do a round-trip of a cache
  * line between two cores and back again
@@ -111,10 +114,11 @@ handle_work(void *arg)
 	unsigned int count = 0;
 	unsigned int num = 0;
 	int i;
-	unsigned int id = __atomic_fetch_add(&worker_idx, 1, __ATOMIC_RELAXED);
-	struct rte_mbuf *buf[8] __rte_cache_aligned;
+	unsigned int id = worker_ids[rte_lcore_id()];
+	struct rte_mbuf *buf[RTE_DIST_BURST_SIZE_MAX] __rte_cache_aligned;
 
-	for (i = 0; i < 8; i++)
+	__atomic_fetch_add(&worker_idx, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < RTE_DIST_BURST_SIZE_MAX; i++)
 		buf[i] = NULL;
 
 	num = rte_distributor_get_pkt(d, id, buf, buf, num);
@@ -200,18 +204,67 @@ quit_workers(struct rte_distributor *d, struct rte_mempool *p)
 	worker_idx = 0;
 }
 
+/* burst distributor configurations to compare */
+static struct burst_perf_config {
+	const char *name;
+	unsigned int burst_size;
+	uint32_t flags;
+	int numa_grouping;
+	struct rte_distributor *d;
+} burst_perf_configs[] = {
+	{ "burst mode, 32 packets bursts", 32, 0, 0, NULL },
+	{ "flow table mode", 0, RTE_DIST_FLAG_FLOW_TABLE, 0, NULL },
+	{ "flow table mode, 32 packets bursts", 32,
+		RTE_DIST_FLAG_FLOW_TABLE, 0, NULL },
+	{ "flow table mode, NUMA grouping", 0,
+		RTE_DIST_FLAG_FLOW_TABLE, 1, NULL },
+};
+
+static struct rte_distributor *
+create_burst_perf_distributor(const struct burst_perf_config *config,
+		unsigned int index)
+{
+	int worker_socket_id[RTE_MAX_LCORE];
+	struct rte_distributor_params params = {
+		.socket_id = rte_socket_id(),
+		.num_workers = rte_lcore_count() - 1,
+		.alg_type = RTE_DIST_ALG_BURST,
+		.burst_size = config->burst_size,
+		.flags = config->flags,
+	};
+	char name[RTE_MEMZONE_NAMESIZE];
+	unsigned int lcore_id;
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+		worker_socket_id[worker_ids[lcore_id]] =
+			rte_lcore_to_socket_id(lcore_id);
+	if (config->numa_grouping)
+		params.worker_socket_id = worker_socket_id;
+
+	snprintf(name, sizeof(name), "Test_burst_%u", index);
+	params.name = name;
+
+	return rte_distributor_create_with_params(&params);
+}
+
 static int
 test_distributor_perf(void)
 {
 	static struct rte_distributor *ds;
 	static struct rte_distributor *db;
 	static struct rte_mempool *p;
+	struct burst_perf_config *config;
+	unsigned int i, lcore_id;
 
 	if (rte_lcore_count() < 2) {
 		printf("Not enough cores for distributor_perf_autotest, expecting at least 2\n");
 		return TEST_SKIPPED;
 	}
 
+	i = 0;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+		worker_ids[lcore_id] = i++;
+
 	/* first time how long it takes to round-trip a cache line */
 	time_cache_line_switch();
 
@@ -262,6 +315,26 @@ test_distributor_perf(void)
 		return -1;
 	quit_workers(db, p);
 
+	for (i = 0; i < RTE_DIM(burst_perf_configs); i++) {
+		config = &burst_perf_configs[i];
+		if (config->d == NULL) {
+			config->d = create_burst_perf_distributor(config, i);
+			if (config->d == NULL) {
+				printf("Error creating burst distributor\n");
+				return -1;
+			}
+		} else {
+			rte_distributor_clear_returns(config->d);
+		}
+
+		printf("=== Performance test of distributor (%s) ===\n",
+				config->name);
+		rte_eal_mp_remote_launch(handle_work, config->d, SKIP_MASTER);
+		if (perf_test(config->d, p) < 0)
+			return -1;
+		quit_workers(config->d, p);
+	}
+
 	return 0;
 }
 
@@ -3,11 +3,14 @@
  */
 #include <string.h>
 #include <rte_common.h>
+#include <rte_cycles.h>
 #include <rte_mempool.h>
 #include <rte_mbuf.h>
 #include <rte_ethdev.h>
 #include <rte_eventdev.h>
 #include <rte_bus_vdev.h>
+#include <rte_service.h>
+#include <rte_time.h>
 
 #include <rte_event_eth_rx_adapter.h>
 
@@ -676,6 +679,361 @@ adapter_stats(void)
 	return TEST_SUCCESS;
 }
 
+#define VEC_INST_ID		1
+#define VEC_NB_MBUFS		2048
+#define VEC_SZ			8
+#define VEC_TIMEOUT_NS		100000
+#define VEC_RETRY		1000
+
+struct event_eth_rx_adapter_vector_params {
+	struct rte_mempool *mp;
+	struct rte_mempool *vec_mp;
+	uint16_t eth_port;
+	uint8_t dev_id;
+	uint32_t evdev_service_id;
+	uint32_t rxa_service_id;
+	/* packets the null port may still deliver */
+	uint16_t rx_budget;
+	uint64_t rx_seq;
+};
+
+static struct event_eth_rx_adapter_vector_params vec_params;
+
+/* Turn the endless null port into a source of rx_budget numbered packets */
+static uint16_t
+vector_rx_limit_cb(uint16_t port __rte_unused, uint16_t queue __rte_unused,
+		   struct rte_mbuf *pkts[], uint16_t nb_pkts,
+		   uint16_t max_pkts __rte_unused, void *user_param)
+{
+	struct event_eth_rx_adapter_vector_params *p = user_param;
+	uint16_t i, n;
+
+	n = RTE_MIN(nb_pkts, p->rx_budget);
+	for (i = 0; i < n; i++)
+		pkts[i]->udata64 = p->rx_seq++;
+	rte_pktmbuf_free_bulk(&pkts[n], nb_pkts - n);
+	p->rx_budget -= n;
+	return n;
+}
+
+static int
+testsuite_setup_vector(void)
+{
+	struct rte_event_dev_config config = {
+		.nb_event_queues = 1,
+		.nb_event_ports = 1,
+		.nb_events_limit = 4096,
+		.nb_event_queue_flows = 1024,
+		.nb_event_port_dequeue_depth = 32,
+		.nb_event_port_enqueue_depth = 32,
+	};
+	struct rte_event_port_conf rx_p_conf = {
+		.new_event_threshold = 4096,
+		.dequeue_depth = 32,
+		.enqueue_depth = 32,
+	};
+	struct rte_eth_conf port_conf = { 0 };
+	int err;
+
+	memset(&vec_params, 0, sizeof(vec_params));
+
+	/* vectors are built by the service function of the sw eventdev */
+	if (rte_vdev_init("event_sw_rxa_vector", NULL) != 0 ||
+	    rte_vdev_init("net_null_rxa_vector", NULL) != 0) {
+		printf("event_sw or net_null driver unavailable, skipping\n");
+		return TEST_SKIPPED;
+	}
+	err = rte_event_dev_get_dev_id("event_sw_rxa_vector");
+	TEST_ASSERT(err >= 0, "Failed to get event device id %d", err);
+	vec_params.dev_id = err;
+	err = rte_eth_dev_get_port_by_name("net_null_rxa_vector",
+					   &vec_params.eth_port);
+	TEST_ASSERT(err == 0, "Failed to get eth port id %d", err);
+
+	vec_params.mp = rte_pktmbuf_pool_create("rxa_vector_pool",
+			VEC_NB_MBUFS, 0, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+			rte_socket_id());
+	vec_params.vec_mp = rte_event_vector_pool_create("rxa_vector_vec",
+			VEC_NB_MBUFS / VEC_SZ, 0, VEC_SZ, rte_socket_id());
+	TEST_ASSERT(vec_params.mp != NULL && vec_params.vec_mp != NULL,
+		    "Failed to create mempools");
+
+	err = rte_eth_dev_configure(vec_params.eth_port, 1, 1, &port_conf);
+	TEST_ASSERT(err == 0, "Eth device configuration failed err %d", err);
+	err = rte_eth_rx_queue_setup(vec_params.eth_port, 0, 512,
+			rte_socket_id(), NULL, vec_params.mp);
+	TEST_ASSERT(err == 0, "Eth Rx queue setup failed err %d", err);
+	err = rte_eth_tx_queue_setup(vec_params.eth_port, 0, 512,
+			rte_socket_id(), NULL);
+	TEST_ASSERT(err == 0, "Eth Tx queue setup failed err %d", err);
+	TEST_ASSERT(rte_eth_add_rx_callback(vec_params.eth_port, 0,
+			vector_rx_limit_cb, &vec_params) != NULL,
+		    "Failed to add Rx callback");
+	err = rte_eth_dev_start(vec_params.eth_port);
+	TEST_ASSERT(err == 0, "Eth device start failed err %d", err);
+
+	err = rte_event_dev_configure(vec_params.dev_id, &config);
+	TEST_ASSERT(err == 0, "Event device configuration failed err %d",
+		    err);
+	/* reconfigures the event device with a port of its own */
+	err = rte_event_eth_rx_adapter_create(VEC_INST_ID, vec_params.dev_id,
+					      &rx_p_conf);
+	TEST_ASSERT(err == 0, "Rx adapter creation failed err %d", err);
+
+	return TEST_SUCCESS;
+}
+
+static void
+testsuite_teardown_vector(void)
+{
+	rte_event_eth_rx_adapter_free(VEC_INST_ID);
+	rte_event_dev_close(vec_params.dev_id);
+	rte_vdev_uninit("event_sw_rxa_vector");
+	rte_eth_dev_stop(vec_params.eth_port);
+	rte_eth_dev_close(vec_params.eth_port);
+	rte_vdev_uninit("net_null_rxa_vector");
+	rte_mempool_free(vec_params.vec_mp);
+	rte_mempool_free(vec_params.mp);
+}
+
+static void
+vector_queue_conf(struct rte_event_eth_rx_adapter_queue_conf *queue_config,
+		  uint64_t timeout_ns)
+{
+	memset(queue_config, 0, sizeof(*queue_config));
+	queue_config->rx_queue_flags =
+		RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR;
+	queue_config->servicing_weight = 1;
+	queue_config->ev.queue_id = 0;
+	queue_config->ev.sched_type = RTE_SCHED_TYPE_ATOMIC;
+	queue_config->vector_sz = VEC_SZ;
+	queue_config->vector_timeout_ns = timeout_ns;
+	queue_config->vector_mp = vec_params.vec_mp;
+}
+
+static int
+vector_start(uint64_t timeout_ns)
+{
+	struct rte_event_eth_rx_adapter_queue_conf queue_config;
+	int err;
+
+	vector_queue_conf(&queue_config, timeout_ns);
+	err = rte_event_eth_rx_adapter_queue_add(VEC_INST_ID,
+			vec_params.eth_port, 0, &queue_config);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+
+	err = rte_event_queue_setup(vec_params.dev_id, 0, NULL);
+	TEST_ASSERT(err == 0, "Event queue setup failed err %d", err);
+	err = rte_event_port_setup(vec_params.dev_id, 0, NULL);
+	TEST_ASSERT(err == 0, "Event port setup failed err %d", err);
+	err = rte_event_port_link(vec_params.dev_id, 0, NULL, NULL, 0);
+	TEST_ASSERT(err == 1, "Event port link failed err %d", err);
+
+	err = rte_event_dev_service_id_get(vec_params.dev_id,
+					   &vec_params.evdev_service_id);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	err = rte_event_eth_rx_adapter_service_id_get(VEC_INST_ID,
+					&vec_params.rxa_service_id);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	rte_service_runstate_set(vec_params.evdev_service_id, 1);
+	rte_service_set_runstate_mapped_check(vec_params.evdev_service_id, 0);
+	rte_service_runstate_set(vec_params.rxa_service_id, 1);
+	rte_service_set_runstate_mapped_check(vec_params.rxa_service_id, 0);
+
+	err = rte_event_dev_start(vec_params.dev_id);
+	TEST_ASSERT(err == 0, "Event device start failed err %d", err);
+	err = rte_event_eth_rx_adapter_start(VEC_INST_ID);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+
+	return TEST_SUCCESS;
+}
+
+static void
+vector_stop(void)
+{
+	rte_event_eth_rx_adapter_stop(VEC_INST_ID);
+	rte_event_eth_rx_adapter_queue_del(VEC_INST_ID, vec_params.eth_port,
+					   0);
+	rte_event_dev_stop(vec_params.dev_id);
+}
+
+static int
+vector_start_short_timeout(void)
+{
+	return vector_start(VEC_TIMEOUT_NS);
+}
+
+static int
+vector_start_long_timeout(void)
+{
+	return vector_start(NSEC_PER_SEC);
+}
+
+/* Run the services until nb_ev events are dequeued or retries run out */
+static uint16_t
+vector_dequeue(struct rte_event *ev, uint16_t nb_ev)
+{
+	uint16_t n = 0;
+	int i;
+
+	for (i = 0; i < VEC_RETRY && n < nb_ev; i++) {
+		rte_service_run_iter_on_app_lcore(vec_params.rxa_service_id,
+						  1);
+		rte_service_run_iter_on_app_lcore(vec_params.evdev_service_id,
+						  1);
+		n += rte_event_dequeue_burst(vec_params.dev_id, 0, &ev[n],
+					     nb_ev - n, 0);
+		rte_delay_us(1);
+	}
+	return n;
+}
+
+/* Check the mbufs of a vector event, then free them */
+static int
+vector_check_free(struct rte_event *ev, uint16_t nb_elem, uint64_t *seq)
+{
+	struct rte_event_vector *vec = ev->vec;
+	struct rte_mbuf *m;
+	uint16_t i;
+
+	TEST_ASSERT(ev->event_type == RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR,
+		    "Expected vector event type got %u", ev->event_type);
+	TEST_ASSERT(vec->nb_elem == nb_elem, "Expected %u mbufs got %u",
+		    nb_elem, vec->nb_elem);
+	TEST_ASSERT(vec->attr_valid && vec->port == vec_params.eth_port &&
+		    vec->queue == 0, "Wrong vector attributes");
+
+	RTE_EVENT_VECTOR_FOREACH_MBUF(vec, m, i)
+		TEST_ASSERT(m->udata64 == (*seq)++,
+			    "Mbuf %u of the vector out of order", i);
+
+	rte_pktmbuf_free_bulk(vec->mbufs, vec->nb_elem);
+	rte_mempool_put(rte_mempool_from_obj(vec), vec);
+	return TEST_SUCCESS;
+}
+
+static int
+adapter_vector_config(void)
+{
+	struct rte_event_eth_rx_adapter_vector_limits limits;
+	struct rte_event_eth_rx_adapter_queue_conf queue_config;
+	int err;
+
+	err = rte_event_eth_rx_adapter_vector_limits_get(vec_params.dev_id,
+			vec_params.eth_port, NULL);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+	err = rte_event_eth_rx_adapter_vector_limits_get(vec_params.dev_id,
+			vec_params.eth_port, &limits);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	TEST_ASSERT(limits.min_sz <= VEC_SZ && VEC_SZ <= limits.max_sz &&
+		    limits.min_timeout_ns <= VEC_TIMEOUT_NS &&
+		    VEC_TIMEOUT_NS <= limits.max_timeout_ns,
+		    "Unexpected vector limits");
+
+	vector_queue_conf(&queue_config, VEC_TIMEOUT_NS);
+	queue_config.vector_mp = NULL;
+	err = rte_event_eth_rx_adapter_queue_add(VEC_INST_ID,
+			vec_params.eth_port, 0, &queue_config);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+
+	/* larger than the vectors of the mempool */
+	vector_queue_conf(&queue_config, VEC_TIMEOUT_NS);
+	queue_config.vector_sz = VEC_SZ * 2;
+	err = rte_event_eth_rx_adapter_queue_add(VEC_INST_ID,
+			vec_params.eth_port, 0, &queue_config);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+
+	vector_queue_conf(&queue_config, VEC_TIMEOUT_NS);
+	queue_config.vector_sz = limits.min_sz - 1;
+	err = rte_event_eth_rx_adapter_queue_add(VEC_INST_ID,
+			vec_params.eth_port, 0, &queue_config);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+
+	vector_queue_conf(&queue_config, limits.max_timeout_ns + 1);
+	err = rte_event_eth_rx_adapter_queue_add(VEC_INST_ID,
+			vec_params.eth_port, 0, &queue_config);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+
+	vector_queue_conf(&queue_config, VEC_TIMEOUT_NS);
+	err = rte_event_eth_rx_adapter_queue_add(VEC_INST_ID,
+			vec_params.eth_port, 0, &queue_config);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	err = rte_event_eth_rx_adapter_queue_del(VEC_INST_ID,
+			vec_params.eth_port, 0);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+
+	return TEST_SUCCESS;
+}
+
+static int
+adapter_vector_full(void)
+{
+	struct rte_event ev[4];
+	uint64_t seq = 0;
+	uint16_t n, i;
+
+	vec_params.rx_seq = 0;
+	vec_params.rx_budget = 2 * VEC_SZ;
+
+	/* two full vectors, nothing left waiting for the timeout */
+	n = vector_dequeue(ev, RTE_DIM(ev));
+	TEST_ASSERT(n == 2, "Expected 2 vector events got %u", n);
+	for (i = 0; i < n; i++)
+		TEST_ASSERT_SUCCESS(vector_check_free(&ev[i], VEC_SZ, &seq),
+				    "Vector %u check failed", i);
+
+	return TEST_SUCCESS;
+}
+
+static int
+adapter_vector_timeout(void)
+{
+	struct rte_event ev;
+	uint64_t seq = 0;
+	uint16_t n;
+
+	vec_params.rx_seq = 0;
+	vec_params.rx_budget = VEC_SZ / 2;
+
+	n = vector_dequeue(&ev, 1);
+	TEST_ASSERT(n == 1, "Expected 1 vector event got %u", n);
+	return vector_check_free(&ev, VEC_SZ / 2, &seq);
+}
+
+static int
+adapter_vector_queue_del(void)
+{
+	struct rte_event_eth_rx_adapter_stats stats;
+	struct rte_event ev;
+	uint64_t dropped;
+	int err;
+
+	err = rte_event_eth_rx_adapter_stats_get(VEC_INST_ID, &stats);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	dropped = stats.rx_dropped;
+
+	vec_params.rx_seq = 0;
+	vec_params.rx_budget = VEC_SZ / 2;
+
+	/* the vector waits for the timeout */
+	TEST_ASSERT(vector_dequeue(&ev, 1) == 0, "Unexpected event");
+	TEST_ASSERT(vec_params.rx_budget == 0, "Packets not received");
+
+	/* deleting the queue drops the partial vector */
+	err = rte_event_eth_rx_adapter_queue_del(VEC_INST_ID,
+			vec_params.eth_port, 0);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	err = rte_event_eth_rx_adapter_stats_get(VEC_INST_ID, &stats);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	TEST_ASSERT(stats.rx_dropped == dropped + VEC_SZ / 2,
+		    "Expected %u dropped packets got %" PRIu64, VEC_SZ / 2,
+		    stats.rx_dropped - dropped);
+	TEST_ASSERT(rte_mempool_avail_count(vec_params.vec_mp) ==
+		    vec_params.vec_mp->size, "Vector not freed");
+
+	return TEST_SUCCESS;
+}
+
 static struct unit_test_suite event_eth_rx_tests = {
 	.suite_name = "rx event eth adapter test suite",
 	.setup = testsuite_setup,
@@ -703,6 +1061,22 @@ static struct unit_test_suite event_eth_rx_intr_tests = {
 	}
 };
 
+static struct unit_test_suite event_eth_rx_vector_tests = {
+	.suite_name = "rx event eth adapter vector test suite",
+	.setup = testsuite_setup_vector,
+	.teardown = testsuite_teardown_vector,
+	.unit_test_cases = {
+		TEST_CASE_ST(NULL, NULL, adapter_vector_config),
+		TEST_CASE_ST(vector_start_short_timeout, vector_stop,
+			adapter_vector_full),
+		TEST_CASE_ST(vector_start_short_timeout, vector_stop,
+			adapter_vector_timeout),
+		TEST_CASE_ST(vector_start_long_timeout, vector_stop,
+			adapter_vector_queue_del),
+		TEST_CASES_END() /**< NULL terminate unit test array */
+	}
+};
+
 static int
 test_event_eth_rx_adapter_common(void)
 {
@@ -715,7 +1089,15 @@ test_event_eth_rx_intr_adapter_common(void)
 	return unit_test_suite_runner(&event_eth_rx_intr_tests);
 }
 
+static int
+test_event_eth_rx_vector_adapter_common(void)
+{
+	return unit_test_suite_runner(&event_eth_rx_vector_tests);
+}
+
 REGISTER_TEST_COMMAND(event_eth_rx_adapter_autotest,
 		test_event_eth_rx_adapter_common);
 REGISTER_TEST_COMMAND(event_eth_rx_intr_adapter_autotest,
 		test_event_eth_rx_intr_adapter_common);
+REGISTER_TEST_COMMAND(event_eth_rx_vector_adapter_autotest,
+		test_event_eth_rx_vector_adapter_common);
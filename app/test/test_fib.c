@@ -9,6 +9,7 @@
 
 #include <rte_ip.h>
 #include <rte_log.h>
+#include <rte_malloc.h>
 #include <rte_fib.h>
 
 #include "test.h"
@@ -21,6 +22,8 @@ static int32_t test_free_null(void);
 static int32_t test_add_del_invalid(void);
 static int32_t test_get_invalid(void);
 static int32_t test_lookup(void);
+static int32_t test_invalid_rcu(void);
+static int32_t test_fib_rcu_qsbr_dq(void);
 
 #define MAX_ROUTES	(1 << 16)
 #define MAX_TBL8	(1 << 15)
@@ -311,6 +314,37 @@ check_fib(struct rte_fib *fib)
 	return TEST_SUCCESS;
 }
 
+/*
+ * Run check_fib() for every lookup function implementation,
+ * skipping the vector one if it is not supported.
+ */
+static int
+check_fib_lookup_fns(struct rte_fib *fib)
+{
+	static const enum rte_fib_lookup_type types[] = {
+		RTE_FIB_LOOKUP_DIR24_8_SCALAR_MACRO,
+		RTE_FIB_LOOKUP_DIR24_8_SCALAR_INLINE,
+		RTE_FIB_LOOKUP_DIR24_8_SCALAR_UNI,
+		RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512,
+		RTE_FIB_LOOKUP_DEFAULT,
+	};
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < RTE_DIM(types); i++) {
+		ret = rte_fib_set_lookup_fn(fib, types[i]);
+		if ((ret == -EINVAL) &&
+				(types[i] == RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512))
+			continue;
+		RTE_TEST_ASSERT(ret == 0, "Failed to set lookup function\n");
+		ret = check_fib(fib);
+		RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+			"Check_fib fails for lookup type %d\n", types[i]);
+	}
+
+	return TEST_SUCCESS;
+}
+
 int32_t
 test_lookup(void)
 {
@@ -328,15 +362,22 @@ test_lookup(void)
 	ret = check_fib(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for DUMMY type\n");
+	ret = rte_fib_set_lookup_fn(fib, RTE_FIB_LOOKUP_DEFAULT);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Set lookup function for DUMMY type should fail\n");
 	rte_fib_free(fib);
 
+	ret = rte_fib_set_lookup_fn(NULL, RTE_FIB_LOOKUP_DEFAULT);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Set lookup function for NULL FIB should fail\n");
+
 	config.type = RTE_FIB_DIR24_8;
 
 	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_1B;
 	config.dir24_8.num_tbl8 = 127;
 	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
-	ret = check_fib(fib);
+	ret = check_fib_lookup_fns(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for DIR24_8_1B type\n");
 	rte_fib_free(fib);
@@ -345,7 +386,7 @@ test_lookup(void)
 	config.dir24_8.num_tbl8 = MAX_TBL8 - 1;
 	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
-	ret = check_fib(fib);
+	ret = check_fib_lookup_fns(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for DIR24_8_2B type\n");
 	rte_fib_free(fib);
@@ -354,7 +395,7 @@ test_lookup(void)
 	config.dir24_8.num_tbl8 = MAX_TBL8;
 	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
-	ret = check_fib(fib);
+	ret = check_fib_lookup_fns(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for DIR24_8_4B type\n");
 	rte_fib_free(fib);
@@ -363,7 +404,7 @@ test_lookup(void)
 	config.dir24_8.num_tbl8 = MAX_TBL8;
 	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
-	ret = check_fib(fib);
+	ret = check_fib_lookup_fns(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for DIR24_8_8B type\n");
 	rte_fib_free(fib);
@@ -371,6 +412,193 @@ test_lookup(void)
 	return TEST_SUCCESS;
 }
 
+/*
+ * rte_fib_rcu_qsbr_add positive and negative tests.
+ *  - Add RCU QSBR variable to FIB
+ *  - Add another RCU QSBR variable to FIB
+ *  - Check returns
+ */
+int32_t
+test_invalid_rcu(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	size_t sz;
+	struct rte_rcu_qsbr *qsv;
+	struct rte_rcu_qsbr *qsv2;
+	int32_t status;
+	struct rte_fib_rcu_config rcu_cfg = {0};
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = 0;
+	config.type = RTE_FIB_DUMMY;
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+		RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Can not allocate memory for RCU\n");
+
+	status = rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+	RTE_TEST_ASSERT(status == 0, "Can not initialize RCU\n");
+
+	rcu_cfg.v = qsv;
+
+	/* Not supported by the DUMMY type */
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	status = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -ENOTSUP,
+		"rte_fib_rcu_qsbr_add returned wrong status\n");
+	rte_fib_free(fib);
+
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
+	config.dir24_8.num_tbl8 = MAX_TBL8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* Call rte_fib_rcu_qsbr_add without fib or config */
+	status = rte_fib_rcu_qsbr_add(NULL, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added without fib\n");
+	status = rte_fib_rcu_qsbr_add(fib, NULL);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added without config\n");
+
+	/* Invalid QSBR mode */
+	rcu_cfg.mode = 2;
+	status = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added with incorrect mode\n");
+
+	rcu_cfg.mode = RTE_FIB_QSBR_MODE_DQ;
+
+	/* Attach RCU QSBR to FIB */
+	status = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == 0, "Can not attach RCU to FIB\n");
+
+	/* Create and attach another RCU QSBR to FIB table */
+	qsv2 = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+		RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv2 != NULL, "Can not allocate memory for RCU\n");
+
+	rcu_cfg.v = qsv2;
+	rcu_cfg.mode = RTE_FIB_QSBR_MODE_SYNC;
+	status = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EEXIST, "Secondary RCU was mistakenly attached\n");
+
+	rte_fib_free(fib);
+	rte_free(qsv);
+	rte_free(qsv2);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * rte_fib_rcu_qsbr_add DQ mode functional test.
+ * Reader and writer are in the same thread in this test.
+ *  - Create FIB which supports the minimal number of tbl8 groups
+ *  - Add RCU QSBR variable to FIB
+ *  - Add a rule with depth=28 (> 24) in every /24 until tbl8s run out
+ *  - Register a reader thread (not a real thread)
+ *  - Reader lookup existing rule
+ *  - Writer delete the rules
+ *  - Reader lookup the rule
+ *  - Writer re-add the rule (no available tbl8 group)
+ *  - Reader report quiescent state and unregister
+ *  - Writer re-add the rule
+ *  - Reader lookup the rule
+ */
+int32_t
+test_fib_rcu_qsbr_dq(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	size_t sz;
+	struct rte_rcu_qsbr *qsv;
+	int32_t status;
+	uint32_t ip, i, nb_routes;
+	uint64_t next_hop = 1, next_hop_return;
+	uint64_t def_nh = 100;
+	uint8_t depth = 28;
+	struct rte_fib_rcu_config rcu_cfg = {0};
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = def_nh;
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
+	config.dir24_8.num_tbl8 = 1;
+
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+		RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Can not allocate memory for RCU\n");
+
+	status = rte_rcu_qsbr_init(qsv, 1);
+	RTE_TEST_ASSERT(status == 0, "Can not initialize RCU\n");
+
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_FIB_QSBR_MODE_DQ;
+	/* Attach RCU QSBR to FIB table */
+	status = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == 0, "Can not attach RCU to FIB\n");
+
+	/* Use all the tbl8 groups, one per /24 */
+	for (nb_routes = 0; ; nb_routes++) {
+		ip = RTE_IPV4(192, 0, nb_routes, 100);
+		if (rte_fib_add(fib, ip, depth, next_hop) != 0)
+			break;
+	}
+	RTE_TEST_ASSERT(nb_routes != 0, "Failed to add a route\n");
+
+	/* Register pseudo reader */
+	status = rte_rcu_qsbr_thread_register(qsv, 0);
+	RTE_TEST_ASSERT(status == 0, "Can not register RCU reader\n");
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	ip = RTE_IPV4(192, 0, 0, 100);
+	status = rte_fib_lookup_bulk(fib, &ip, &next_hop_return, 1);
+	RTE_TEST_ASSERT(status == 0, "Lookup failed\n");
+	RTE_TEST_ASSERT(next_hop_return == next_hop, "Lookup returned wrong nh\n");
+
+	/* Writer update */
+	for (i = 0; i < nb_routes; i++) {
+		ip = RTE_IPV4(192, 0, i, 100);
+		status = rte_fib_delete(fib, ip, depth);
+		RTE_TEST_ASSERT(status == 0, "Failed to delete a route\n");
+	}
+
+	ip = RTE_IPV4(192, 0, 0, 100);
+	status = rte_fib_lookup_bulk(fib, &ip, &next_hop_return, 1);
+	RTE_TEST_ASSERT(status == 0, "Lookup failed\n");
+	RTE_TEST_ASSERT(next_hop_return == def_nh, "Lookup returned wrong nh\n");
+
+	/* tbl8 groups are still referenced by the reader */
+	status = rte_fib_add(fib, ip, depth, next_hop);
+	RTE_TEST_ASSERT(status != 0, "Route added while tbl8s are in use\n");
+
+	/* Reader quiescent */
+	rte_rcu_qsbr_quiescent(qsv, 0);
+
+	status = rte_fib_add(fib, ip, depth, next_hop);
+	RTE_TEST_ASSERT(status == 0, "Failed to add a route\n");
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	status = rte_rcu_qsbr_thread_unregister(qsv, 0);
+	RTE_TEST_ASSERT(status == 0, "Can not unregister RCU reader\n");
+
+	status = rte_fib_lookup_bulk(fib, &ip, &next_hop_return, 1);
+	RTE_TEST_ASSERT(status == 0, "Lookup failed\n");
+	RTE_TEST_ASSERT(next_hop_return == next_hop, "Lookup returned wrong nh\n");
+
+	rte_fib_free(fib);
+	rte_free(qsv);
+
+	return TEST_SUCCESS;
+}
+
 static struct unit_test_suite fib_fast_tests = {
 	.suite_name = "fib autotest",
 	.setup = NULL,
@@ -381,6 +609,8 @@ static struct unit_test_suite fib_fast_tests = {
 	TEST_CASE(test_add_del_invalid),
 	TEST_CASE(test_get_invalid),
 	TEST_CASE(test_lookup),
+	TEST_CASE(test_invalid_rcu),
+	TEST_CASE(test_fib_rcu_qsbr_dq),
 	TEST_CASES_END()
 	}
 };
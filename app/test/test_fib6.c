@@ -9,6 +9,7 @@
 
 #include <rte_memory.h>
 #include <rte_log.h>
+#include <rte_malloc.h>
 #include <rte_rib6.h>
 #include <rte_fib6.h>
 
@@ -22,6 +23,8 @@ static int32_t test_free_null(void);
 static int32_t test_add_del_invalid(void);
 static int32_t test_get_invalid(void);
 static int32_t test_lookup(void);
+static int32_t test_invalid_rcu(void);
+static int32_t test_fib6_rcu_qsbr_dq(void);
 
 #define MAX_ROUTES	(1 << 16)
 /** Maximum number of tbl8 for 2-byte entries */
@@ -329,6 +332,35 @@ check_fib(struct rte_fib6 *fib)
 	return TEST_SUCCESS;
 }
 
+/*
+ * Run check_fib() for every lookup function implementation,
+ * skipping the vector one if it is not supported.
+ */
+static int
+check_fib_lookup_fns(struct rte_fib6 *fib)
+{
+	static const enum rte_fib6_lookup_type types[] = {
+		RTE_FIB6_LOOKUP_TRIE_SCALAR,
+		RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512,
+		RTE_FIB6_LOOKUP_DEFAULT,
+	};
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < RTE_DIM(types); i++) {
+		ret = rte_fib6_set_lookup_fn(fib, types[i]);
+		if ((ret == -EINVAL) &&
+				(types[i] == RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512))
+			continue;
+		RTE_TEST_ASSERT(ret == 0, "Failed to set lookup function\n");
+		ret = check_fib(fib);
+		RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+			"Check_fib fails for lookup type %d\n", types[i]);
+	}
+
+	return TEST_SUCCESS;
+}
+
 int32_t
 test_lookup(void)
 {
@@ -346,15 +378,22 @@ test_lookup(void)
 	ret = check_fib(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for DUMMY type\n");
+	ret = rte_fib6_set_lookup_fn(fib, RTE_FIB6_LOOKUP_DEFAULT);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Set lookup function for DUMMY type should fail\n");
 	rte_fib6_free(fib);
 
+	ret = rte_fib6_set_lookup_fn(NULL, RTE_FIB6_LOOKUP_DEFAULT);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Set lookup function for NULL FIB should fail\n");
+
 	config.type = RTE_FIB6_TRIE;
 
 	config.trie.nh_sz = RTE_FIB6_TRIE_2B;
 	config.trie.num_tbl8 = MAX_TBL8 - 1;
 	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
-	ret = check_fib(fib);
+	ret = check_fib_lookup_fns(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for TRIE_2B type\n");
 	rte_fib6_free(fib);
@@ -363,7 +402,7 @@ test_lookup(void)
 	config.trie.num_tbl8 = MAX_TBL8;
 	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
-	ret = check_fib(fib);
+	ret = check_fib_lookup_fns(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for TRIE_4B type\n");
 	rte_fib6_free(fib);
@@ -372,7 +411,7 @@ test_lookup(void)
 	config.trie.num_tbl8 = MAX_TBL8;
 	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
-	ret = check_fib(fib);
+	ret = check_fib_lookup_fns(fib);
 	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
 		"Check_fib fails for TRIE_8B type\n");
 	rte_fib6_free(fib);
@@ -380,6 +419,198 @@ test_lookup(void)
 	return TEST_SUCCESS;
 }
 
+/*
+ * rte_fib6_rcu_qsbr_add positive and negative tests.
+ *  - Add RCU QSBR variable to FIB
+ *  - Add another RCU QSBR variable to FIB
+ *  - Check returns
+ */
+int32_t
+test_invalid_rcu(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+	size_t sz;
+	struct rte_rcu_qsbr *qsv;
+	struct rte_rcu_qsbr *qsv2;
+	int32_t status;
+	struct rte_fib6_rcu_config rcu_cfg = {0};
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = 0;
+	config.type = RTE_FIB6_DUMMY;
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+		RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Can not allocate memory for RCU\n");
+
+	status = rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+	RTE_TEST_ASSERT(status == 0, "Can not initialize RCU\n");
+
+	rcu_cfg.v = qsv;
+
+	/* Not supported by the DUMMY type */
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -ENOTSUP,
+		"rte_fib6_rcu_qsbr_add returned wrong status\n");
+	rte_fib6_free(fib);
+
+	config.type = RTE_FIB6_TRIE;
+	config.trie.nh_sz = RTE_FIB6_TRIE_4B;
+	config.trie.num_tbl8 = MAX_TBL8;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* Call rte_fib6_rcu_qsbr_add without fib or config */
+	status = rte_fib6_rcu_qsbr_add(NULL, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added without fib\n");
+	status = rte_fib6_rcu_qsbr_add(fib, NULL);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added without config\n");
+
+	/* Invalid QSBR mode */
+	rcu_cfg.mode = 2;
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added with incorrect mode\n");
+
+	rcu_cfg.mode = RTE_FIB6_QSBR_MODE_DQ;
+
+	/* Attach RCU QSBR to FIB */
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == 0, "Can not attach RCU to FIB\n");
+
+	/* Create and attach another RCU QSBR to FIB table */
+	qsv2 = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+		RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv2 != NULL, "Can not allocate memory for RCU\n");
+
+	rcu_cfg.v = qsv2;
+	rcu_cfg.mode = RTE_FIB6_QSBR_MODE_SYNC;
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EEXIST, "Secondary RCU was mistakenly attached\n");
+
+	rte_fib6_free(fib);
+	rte_free(qsv);
+	rte_free(qsv2);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * rte_fib6_rcu_qsbr_add DQ mode functional test.
+ * Reader and writer are in the same thread in this test.
+ *  - Create FIB which supports 4 tbl8 groups at max
+ *  - Add RCU QSBR variable to FIB
+ *  - Add 2 rules with depth=32 (> 24), each of them uses a tbl8 group.
+ *    Every add or delete of such a rule temporarily takes one more tbl8
+ *    group which is released at the end of the operation.
+ *  - Register a reader thread (not a real thread)
+ *  - Reader lookup existing rules
+ *  - Writer delete the rules
+ *  - Reader lookup the rules
+ *  - Writer re-add a rule (no available tbl8 group)
+ *  - Reader report quiescent state and unregister
+ *  - Writer re-add the rules
+ *  - Reader lookup the rules
+ */
+int32_t
+test_fib6_rcu_qsbr_dq(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+	size_t sz;
+	struct rte_rcu_qsbr *qsv;
+	int32_t status;
+	uint8_t ip[2][RTE_FIB6_IPV6_ADDR_SIZE] = {
+		{ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+		  0, 0, 0, 0, 0, 0, 0, 0x01 },
+		{ 0x20, 0x01, 0x0e, 0xb8, 0, 0, 0, 0,
+		  0, 0, 0, 0, 0, 0, 0, 0x01 } };
+	uint64_t next_hop = 1, next_hop_return[2];
+	uint64_t def_nh = 100;
+	uint8_t depth = 32;
+	struct rte_fib6_rcu_config rcu_cfg = {0};
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = def_nh;
+	config.type = RTE_FIB6_TRIE;
+	config.trie.nh_sz = RTE_FIB6_TRIE_4B;
+	config.trie.num_tbl8 = 4;
+
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+		RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Can not allocate memory for RCU\n");
+
+	status = rte_rcu_qsbr_init(qsv, 1);
+	RTE_TEST_ASSERT(status == 0, "Can not initialize RCU\n");
+
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_FIB6_QSBR_MODE_DQ;
+	/* Attach RCU QSBR to FIB table */
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == 0, "Can not attach RCU to FIB\n");
+
+	status = rte_fib6_add(fib, ip[0], depth, next_hop);
+	RTE_TEST_ASSERT(status == 0, "Failed to add a route\n");
+	status = rte_fib6_add(fib, ip[1], depth, next_hop);
+	RTE_TEST_ASSERT(status == 0, "Failed to add a route\n");
+
+	/* Register pseudo reader */
+	status = rte_rcu_qsbr_thread_register(qsv, 0);
+	RTE_TEST_ASSERT(status == 0, "Can not register RCU reader\n");
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	status = rte_fib6_lookup_bulk(fib, ip, next_hop_return, 2);
+	RTE_TEST_ASSERT(status == 0, "Lookup failed\n");
+	RTE_TEST_ASSERT((next_hop_return[0] == next_hop) &&
+		(next_hop_return[1] == next_hop), "Lookup returned wrong nh\n");
+
+	/* Writer update */
+	status = rte_fib6_delete(fib, ip[0], depth);
+	RTE_TEST_ASSERT(status == 0, "Failed to delete a route\n");
+	status = rte_fib6_delete(fib, ip[1], depth);
+	RTE_TEST_ASSERT(status == 0, "Failed to delete a route\n");
+
+	status = rte_fib6_lookup_bulk(fib, ip, next_hop_return, 2);
+	RTE_TEST_ASSERT(status == 0, "Lookup failed\n");
+	RTE_TEST_ASSERT((next_hop_return[0] == def_nh) &&
+		(next_hop_return[1] == def_nh), "Lookup returned wrong nh\n");
+
+	/* The deleted tbl8 groups are still referenced by the reader */
+	status = rte_fib6_add(fib, ip[0], depth, next_hop);
+	RTE_TEST_ASSERT(status != 0, "Route added while tbl8 is in use\n");
+
+	/* Reader quiescent */
+	rte_rcu_qsbr_quiescent(qsv, 0);
+
+	status = rte_fib6_add(fib, ip[0], depth, next_hop);
+	RTE_TEST_ASSERT(status == 0, "Failed to add a route\n");
+	status = rte_fib6_add(fib, ip[1], depth, next_hop);
+	RTE_TEST_ASSERT(status == 0, "Failed to add a route\n");
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	status = rte_rcu_qsbr_thread_unregister(qsv, 0);
+	RTE_TEST_ASSERT(status == 0, "Can not unregister RCU reader\n");
+
+	status = rte_fib6_lookup_bulk(fib, ip, next_hop_return, 2);
+	RTE_TEST_ASSERT(status == 0, "Lookup failed\n");
+	RTE_TEST_ASSERT((next_hop_return[0] == next_hop) &&
+		(next_hop_return[1] == next_hop), "Lookup returned wrong nh\n");
+
+	rte_fib6_free(fib);
+	rte_free(qsv);
+
+	return TEST_SUCCESS;
+}
+
 static struct unit_test_suite fib6_fast_tests = {
 	.suite_name = "fib6 autotest",
 	.setup = NULL,
@@ -390,6 +621,8 @@ static struct unit_test_suite fib6_fast_tests = {
 	TEST_CASE(test_add_del_invalid),
 	TEST_CASE(test_get_invalid),
 	TEST_CASE(test_lookup),
+	TEST_CASE(test_invalid_rcu),
+	TEST_CASE(test_fib6_rcu_qsbr_dq),
 	TEST_CASES_END()
 	}
 };
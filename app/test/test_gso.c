@@ -0,0 +1,480 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_byteorder.h>
+#include <rte_common.h>
+#include <rte_ethdev.h>
+#include <rte_ether.h>
+#include <rte_gso.h>
+#include <rte_ip.h>
+#include <rte_mbuf.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+
+#include "test.h"
+
+#define NB_MBUFS 1024
+#define MBUF_DATA_SIZE (RTE_PKTMBUF_HEADROOM + 8192)
+#define PAYLOAD_LEN 5000
+#define GSO_SEG_SIZE 1400
+#define MAX_SEGS_OUT 16
+
+#define VXLAN_HDR_LEN 8
+#define VXLAN_PORT 4789
+#define GRE_HDR_LEN 4
+#define GRE_PROTO_TEB 0x6558
+#define IPV6_FRAG_HDR_LEN 8
+#define IPV4_HDR_MF (1 << 13)
+#define TCP_SEQ 1000
+#define IP_ID 0x100
+
+#define VXLAN_L2_LEN (sizeof(struct rte_udp_hdr) + VXLAN_HDR_LEN + \
+		sizeof(struct rte_ether_hdr))
+#define GRE_L2_LEN (GRE_HDR_LEN + sizeof(struct rte_ether_hdr))
+
+/* Header layout and ol_flags describing one IPv6 GSO packet type */
+struct gso_test_type {
+	const char *name;
+	uint64_t ol_flags;
+	uint8_t outer_l2_len;
+	uint8_t outer_l3_len;
+	uint8_t l2_len;
+	uint8_t l3_len;
+	uint8_t l4_len;
+};
+
+static const struct gso_test_type gso_test_types[] = {
+	{ "TCP/IPv6", PKT_TX_IPV6 | PKT_TX_TCP_SEG,
+		0, 0, sizeof(struct rte_ether_hdr),
+		sizeof(struct rte_ipv6_hdr), sizeof(struct rte_tcp_hdr) },
+	{ "UDP/IPv6", PKT_TX_IPV6 | PKT_TX_UDP_SEG,
+		0, 0, sizeof(struct rte_ether_hdr),
+		sizeof(struct rte_ipv6_hdr), sizeof(struct rte_udp_hdr) },
+	{ "IPv6/VxLAN/TCP/IPv4", PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_VXLAN |
+		PKT_TX_IPV4 | PKT_TX_TCP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv6_hdr),
+		VXLAN_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_tcp_hdr) },
+	{ "IPv6/VxLAN/UDP/IPv4", PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_VXLAN |
+		PKT_TX_IPV4 | PKT_TX_UDP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv6_hdr),
+		VXLAN_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_udp_hdr) },
+	{ "IPv6/GRE/TCP/IPv4", PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_GRE |
+		PKT_TX_IPV4 | PKT_TX_TCP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv6_hdr),
+		GRE_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_tcp_hdr) },
+	{ "IPv6/GRE/UDP/IPv4", PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_GRE |
+		PKT_TX_IPV4 | PKT_TX_UDP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv6_hdr),
+		GRE_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_udp_hdr) },
+};
+
+/* IPv6 fragment extension header, as inserted by GSO */
+struct gso_test_frag_hdr {
+	uint8_t next_header;
+	uint8_t reserved;
+	rte_be16_t frag_data;
+	rte_be32_t id;
+} __rte_packed;
+
+static struct rte_mempool *pkt_pool;
+static struct rte_mempool *direct_pool;
+static struct rte_mempool *indirect_pool;
+
+/* the packet before segmentation, and the segment being checked */
+static uint8_t orig[MBUF_DATA_SIZE];
+static uint8_t seg_data[MBUF_DATA_SIZE];
+
+static inline int
+is_tunnel(const struct gso_test_type *type)
+{
+	return type->outer_l3_len != 0;
+}
+
+static inline int
+is_tcp(const struct gso_test_type *type)
+{
+	return (type->ol_flags & PKT_TX_TCP_SEG) != 0;
+}
+
+static void
+gso_test_fill_ipv6(struct rte_ipv6_hdr *ip, uint16_t payload_len,
+		uint8_t proto)
+{
+	ip->vtc_flow = rte_cpu_to_be_32(6 << 28);
+	ip->payload_len = rte_cpu_to_be_16(payload_len);
+	ip->proto = proto;
+	ip->hop_limits = 64;
+}
+
+static void
+gso_test_fill_ipv4(struct rte_ipv4_hdr *ip, uint16_t total_len,
+		uint8_t proto)
+{
+	ip->version_ihl = RTE_IPV4_VHL_DEF;
+	ip->total_length = rte_cpu_to_be_16(total_len);
+	ip->packet_id = rte_cpu_to_be_16(IP_ID);
+	ip->time_to_live = 64;
+	ip->next_proto_id = proto;
+}
+
+/* Build a packet of the given type with a PAYLOAD_LEN byte payload */
+static struct rte_mbuf *
+gso_test_build_pkt(const struct gso_test_type *type)
+{
+	struct rte_ether_hdr *eth;
+	struct rte_udp_hdr *udp;
+	struct rte_tcp_hdr *tcp;
+	struct rte_mbuf *m;
+	uint16_t hdr_len, len, off;
+	uint8_t l4_proto, *data;
+	unsigned int i;
+
+	m = rte_pktmbuf_alloc(pkt_pool);
+	if (m == NULL)
+		return NULL;
+
+	hdr_len = type->outer_l2_len + type->outer_l3_len + type->l2_len +
+		type->l3_len + type->l4_len;
+	len = hdr_len + PAYLOAD_LEN;
+	data = (uint8_t *)rte_pktmbuf_append(m, len);
+	if (data == NULL) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+	memset(data, 0, hdr_len);
+	for (i = hdr_len; i < len; i++)
+		data[i] = i;
+
+	l4_proto = is_tcp(type) ? IPPROTO_TCP : IPPROTO_UDP;
+	off = 0;
+	if (is_tunnel(type)) {
+		eth = (struct rte_ether_hdr *)data;
+		eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+		off += type->outer_l2_len;
+		gso_test_fill_ipv6((struct rte_ipv6_hdr *)(data + off),
+			len - off - type->outer_l3_len,
+			(type->ol_flags & PKT_TX_TUNNEL_VXLAN) ?
+			IPPROTO_UDP : IPPROTO_GRE);
+		off += type->outer_l3_len;
+		if (type->ol_flags & PKT_TX_TUNNEL_VXLAN) {
+			udp = (struct rte_udp_hdr *)(data + off);
+			udp->dst_port = rte_cpu_to_be_16(VXLAN_PORT);
+			udp->dgram_len = rte_cpu_to_be_16(len - off);
+			/* VxLAN header: valid VNI flag */
+			data[off + sizeof(*udp)] = 0x08;
+		} else {
+			/* GRE header: no flag, Ethernet payload */
+			*(rte_be16_t *)(data + off + 2) =
+				rte_cpu_to_be_16(GRE_PROTO_TEB);
+		}
+		off += type->l2_len;
+		eth = (struct rte_ether_hdr *)(data + off -
+			sizeof(struct rte_ether_hdr));
+		eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+		gso_test_fill_ipv4((struct rte_ipv4_hdr *)(data + off),
+			len - off, l4_proto);
+	} else {
+		eth = (struct rte_ether_hdr *)data;
+		eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+		off += type->l2_len;
+		gso_test_fill_ipv6((struct rte_ipv6_hdr *)(data + off),
+			len - off - type->l3_len, l4_proto);
+	}
+	off += type->l3_len;
+
+	if (is_tcp(type)) {
+		tcp = (struct rte_tcp_hdr *)(data + off);
+		tcp->sent_seq = rte_cpu_to_be_32(TCP_SEQ);
+		tcp->data_off = (type->l4_len / 4) << 4;
+		tcp->tcp_flags = RTE_TCP_ACK_FLAG | RTE_TCP_PSH_FLAG;
+	} else {
+		udp = (struct rte_udp_hdr *)(data + off);
+		udp->dgram_len = rte_cpu_to_be_16(len - off);
+	}
+
+	m->ol_flags = type->ol_flags;
+	m->outer_l2_len = type->outer_l2_len;
+	m->outer_l3_len = type->outer_l3_len;
+	m->l2_len = type->l2_len;
+	m->l3_len = type->l3_len;
+	m->l4_len = type->l4_len;
+
+	return m;
+}
+
+/*
+ * Check the headers of a TCP/IPv6 or UDP/IPv6 segment. The payload of
+ * the segment starts at byte ofs of the part of the packet following the
+ * copied headers. Returns the payload length, or -1 on error.
+ */
+static int
+gso_test_check_ipv6(const struct gso_test_type *type, const uint8_t *seg,
+		uint32_t seg_len, uint32_t ofs, int last, uint32_t *frag_id)
+{
+	const struct rte_ipv6_hdr *ip;
+	const struct gso_test_frag_hdr *frag;
+	const struct rte_tcp_hdr *tcp;
+	uint16_t frag_data;
+	uint32_t hdr_len;
+
+	ip = (const struct rte_ipv6_hdr *)(seg + type->l2_len);
+	if (rte_be_to_cpu_16(ip->payload_len) !=
+			seg_len - type->l2_len - sizeof(*ip)) {
+		printf("wrong IPv6 payload length %u\n",
+			rte_be_to_cpu_16(ip->payload_len));
+		return -1;
+	}
+
+	if (is_tcp(type)) {
+		hdr_len = type->l2_len + type->l3_len + type->l4_len;
+		tcp = (const struct rte_tcp_hdr *)(seg + type->l2_len +
+			type->l3_len);
+		if (ip->proto != IPPROTO_TCP ||
+				rte_be_to_cpu_32(tcp->sent_seq) !=
+				TCP_SEQ + ofs) {
+			printf("wrong TCP sequence number %u\n",
+				rte_be_to_cpu_32(tcp->sent_seq));
+			return -1;
+		}
+		if (!last && (tcp->tcp_flags & RTE_TCP_PSH_FLAG)) {
+			printf("PSH flag set in a non-tail segment\n");
+			return -1;
+		}
+		return seg_len - hdr_len;
+	}
+
+	/* the fragmentable part starts at the UDP header */
+	hdr_len = type->l2_len + type->l3_len + IPV6_FRAG_HDR_LEN;
+	frag = (const struct gso_test_frag_hdr *)(seg + type->l2_len +
+		type->l3_len);
+	frag_data = rte_be_to_cpu_16(frag->frag_data);
+	if (ip->proto != IPPROTO_FRAGMENT ||
+			frag->next_header != IPPROTO_UDP) {
+		printf("no fragment header\n");
+		return -1;
+	}
+	if ((frag_data & ~7) != ofs || (frag_data & 1) != !last) {
+		printf("wrong fragment offset/M flag %#x at offset %u\n",
+			frag_data, ofs);
+		return -1;
+	}
+	if (ofs == 0)
+		*frag_id = frag->id;
+	else if (frag->id != *frag_id) {
+		printf("fragment ID %#x differs from the first one %#x\n",
+			rte_be_to_cpu_32(frag->id),
+			rte_be_to_cpu_32(*frag_id));
+		return -1;
+	}
+	if (!last && ((seg_len - hdr_len) & 7) != 0) {
+		printf("non-tail fragment of %u bytes\n", seg_len - hdr_len);
+		return -1;
+	}
+
+	return seg_len - hdr_len;
+}
+
+/* Same as gso_test_check_ipv6() for tunnels with an outer IPv6 header */
+static int
+gso_test_check_tunnel(const struct gso_test_type *type, const uint8_t *seg,
+		uint32_t seg_len, uint32_t ofs, int last, uint16_t seg_idx)
+{
+	const struct rte_ipv6_hdr *outer_ip;
+	const struct rte_ipv4_hdr *ip;
+	const struct rte_udp_hdr *udp;
+	const struct rte_tcp_hdr *tcp;
+	uint32_t outer_l4_ofs, inner_ofs, hdr_len;
+	uint16_t frag_off;
+
+	outer_ip = (const struct rte_ipv6_hdr *)(seg + type->outer_l2_len);
+	outer_l4_ofs = type->outer_l2_len + type->outer_l3_len;
+	if (rte_be_to_cpu_16(outer_ip->payload_len) !=
+			seg_len - outer_l4_ofs) {
+		printf("wrong outer IPv6 payload length %u\n",
+			rte_be_to_cpu_16(outer_ip->payload_len));
+		return -1;
+	}
+
+	udp = (const struct rte_udp_hdr *)(seg + outer_l4_ofs);
+	if ((type->ol_flags & PKT_TX_TUNNEL_VXLAN) &&
+			rte_be_to_cpu_16(udp->dgram_len) !=
+			seg_len - outer_l4_ofs) {
+		printf("wrong outer UDP length %u\n",
+			rte_be_to_cpu_16(udp->dgram_len));
+		return -1;
+	}
+
+	inner_ofs = outer_l4_ofs + type->l2_len;
+	ip = (const struct rte_ipv4_hdr *)(seg + inner_ofs);
+	if (rte_be_to_cpu_16(ip->total_length) != seg_len - inner_ofs) {
+		printf("wrong inner IPv4 length %u\n",
+			rte_be_to_cpu_16(ip->total_length));
+		return -1;
+	}
+
+	frag_off = rte_be_to_cpu_16(ip->fragment_offset);
+	if (is_tcp(type)) {
+		hdr_len = inner_ofs + type->l3_len + type->l4_len;
+		tcp = (const struct rte_tcp_hdr *)(seg + inner_ofs +
+			type->l3_len);
+		if (frag_off != 0 ||
+				rte_be_to_cpu_16(ip->packet_id) !=
+				IP_ID + seg_idx ||
+				rte_be_to_cpu_32(tcp->sent_seq) !=
+				TCP_SEQ + ofs) {
+			printf("wrong inner headers, ID %#x, seq %u\n",
+				rte_be_to_cpu_16(ip->packet_id),
+				rte_be_to_cpu_32(tcp->sent_seq));
+			return -1;
+		}
+		return seg_len - hdr_len;
+	}
+
+	/* inner IPv4 fragments, all of the same ID */
+	hdr_len = inner_ofs + type->l3_len;
+	if (rte_be_to_cpu_16(ip->packet_id) != IP_ID ||
+			(frag_off & RTE_IPV4_HDR_OFFSET_MASK) * 8 != ofs ||
+			((frag_off & IPV4_HDR_MF) != 0) == last) {
+		printf("wrong inner fragment, ID %#x, offset/MF %#x at %u\n",
+			rte_be_to_cpu_16(ip->packet_id), frag_off, ofs);
+		return -1;
+	}
+	if (!last && ((seg_len - hdr_len) & 7) != 0) {
+		printf("non-tail fragment of %u bytes\n", seg_len - hdr_len);
+		return -1;
+	}
+
+	return seg_len - hdr_len;
+}
+
+/*
+ * Segment one packet of the given type, check the headers of each segment
+ * and that their payloads put back together give the original data.
+ */
+static int
+gso_test_run(const struct gso_test_type *type, struct rte_gso_ctx *ctx)
+{
+	struct rte_mbuf *segs[MAX_SEGS_OUT];
+	struct rte_mbuf *pkt;
+	const uint8_t *seg;
+	uint32_t split, pkt_len, ofs, frag_id = 0;
+	int ret, len, i, err = 0;
+
+	pkt = gso_test_build_pkt(type);
+	if (pkt == NULL)
+		return -1;
+
+	/* headers copied in each segment, the rest is split */
+	pkt_len = rte_pktmbuf_pkt_len(pkt);
+	split = type->outer_l2_len + type->outer_l3_len + type->l2_len +
+		type->l3_len + (is_tcp(type) ? type->l4_len : 0);
+	memcpy(orig, rte_pktmbuf_mtod(pkt, void *), pkt_len);
+
+	ret = rte_gso_segment(pkt, ctx, segs, MAX_SEGS_OUT);
+	if (ret <= 1) {
+		printf("%s: packet not segmented (%d)\n", type->name, ret);
+		rte_pktmbuf_free(pkt);
+		return -1;
+	}
+
+	ofs = 0;
+	for (i = 0; i < ret && err == 0; i++) {
+		seg = rte_pktmbuf_read(segs[i], 0, segs[i]->pkt_len,
+			seg_data);
+		if (seg == NULL || segs[i]->pkt_len > ctx->gso_size) {
+			printf("%s: segment %d of %u bytes\n", type->name, i,
+				segs[i]->pkt_len);
+			err = -1;
+			break;
+		}
+
+		if (is_tunnel(type))
+			len = gso_test_check_tunnel(type, seg,
+				segs[i]->pkt_len, ofs, i == ret - 1, i);
+		else
+			len = gso_test_check_ipv6(type, seg,
+				segs[i]->pkt_len, ofs, i == ret - 1,
+				&frag_id);
+		if (len <= 0 || split + ofs + len > pkt_len ||
+				memcmp(seg + segs[i]->pkt_len - len,
+					orig + split + ofs, len) != 0) {
+			printf("%s: invalid segment %d\n", type->name, i);
+			err = -1;
+		}
+		ofs += len;
+	}
+	if (err == 0 && split + ofs != pkt_len) {
+		printf("%s: %u bytes segmented out of %u\n", type->name,
+			ofs, pkt_len - split);
+		err = -1;
+	}
+
+	for (i = 0; i < ret; i++)
+		rte_pktmbuf_free(segs[i]);
+
+	if (err != 0)
+		return -1;
+
+	printf("%s: %d segments OK\n", type->name, ret);
+	return 0;
+}
+
+static int
+test_gso(void)
+{
+	struct rte_gso_ctx ctx;
+	unsigned int i;
+	int ret = TEST_SUCCESS;
+
+	pkt_pool = rte_pktmbuf_pool_create("gso_test_pkt", NB_MBUFS, 0, 0,
+			MBUF_DATA_SIZE, SOCKET_ID_ANY);
+	direct_pool = rte_pktmbuf_pool_create("gso_test_direct", NB_MBUFS,
+			0, 0, RTE_MBUF_DEFAULT_BUF_SIZE, SOCKET_ID_ANY);
+	indirect_pool = rte_pktmbuf_pool_create("gso_test_indirect",
+			NB_MBUFS, 0, 0, 0, SOCKET_ID_ANY);
+	if (pkt_pool == NULL || direct_pool == NULL ||
+			indirect_pool == NULL) {
+		printf("Cannot create mbuf pools\n");
+		ret = TEST_FAILED;
+		goto out;
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.direct_pool = direct_pool;
+	ctx.indirect_pool = indirect_pool;
+	ctx.gso_types = DEV_TX_OFFLOAD_TCP_TSO | DEV_TX_OFFLOAD_UDP_TSO |
+		DEV_TX_OFFLOAD_VXLAN_TNL_TSO | DEV_TX_OFFLOAD_GRE_TNL_TSO;
+	ctx.gso_size = GSO_SEG_SIZE;
+
+	for (i = 0; i < RTE_DIM(gso_test_types); i++) {
+		if (gso_test_run(&gso_test_types[i], &ctx) < 0) {
+			ret = TEST_FAILED;
+			break;
+		}
+	}
+
+	/* all the segments must have been freed */
+	if (ret == TEST_SUCCESS &&
+			(rte_mempool_in_use_count(pkt_pool) != 0 ||
+			 rte_mempool_in_use_count(direct_pool) != 0 ||
+			 rte_mempool_in_use_count(indirect_pool) != 0)) {
+		printf("mbufs leaked\n");
+		ret = TEST_FAILED;
+	}
+
+out:
+	rte_mempool_free(pkt_pool);
+	rte_mempool_free(direct_pool);
+	rte_mempool_free(indirect_pool);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(gso_autotest, test_gso);
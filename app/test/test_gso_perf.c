@@ -0,0 +1,239 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+#include <rte_ether.h>
+#include <rte_gso.h>
+#include <rte_ip.h>
+#include <rte_mbuf.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+
+#include "test.h"
+
+#define NB_MBUFS 8192
+#define MBUF_CACHE_SIZE 256
+#define MBUF_DATA_SIZE (RTE_PKTMBUF_HEADROOM + 16384)
+#define PAYLOAD_LEN 9000
+#define GSO_SEG_SIZE 1514
+#define MAX_SEGS_OUT 64
+#define ITERATIONS 20000
+
+#define VXLAN_HDR_LEN 8
+#define GRE_HDR_LEN 4
+
+/* Header layout and ol_flags describing one GSO packet type */
+struct gso_perf_type {
+	const char *name;
+	uint64_t ol_flags;
+	uint8_t outer_l2_len;
+	uint8_t outer_l3_len;
+	uint8_t l2_len;
+	uint8_t l3_len;
+	uint8_t l4_len;
+};
+
+#define VXLAN_L2_LEN (sizeof(struct rte_udp_hdr) + VXLAN_HDR_LEN + \
+		sizeof(struct rte_ether_hdr))
+#define GRE_L2_LEN (GRE_HDR_LEN + sizeof(struct rte_ether_hdr))
+
+static const struct gso_perf_type gso_perf_types[] = {
+	{ "TCP/IPv4", PKT_TX_IPV4 | PKT_TX_TCP_SEG,
+		0, 0, sizeof(struct rte_ether_hdr),
+		sizeof(struct rte_ipv4_hdr), sizeof(struct rte_tcp_hdr) },
+	{ "TCP/IPv6", PKT_TX_IPV6 | PKT_TX_TCP_SEG,
+		0, 0, sizeof(struct rte_ether_hdr),
+		sizeof(struct rte_ipv6_hdr), sizeof(struct rte_tcp_hdr) },
+	{ "UDP/IPv4", PKT_TX_IPV4 | PKT_TX_UDP_SEG,
+		0, 0, sizeof(struct rte_ether_hdr),
+		sizeof(struct rte_ipv4_hdr), sizeof(struct rte_udp_hdr) },
+	{ "UDP/IPv6", PKT_TX_IPV6 | PKT_TX_UDP_SEG,
+		0, 0, sizeof(struct rte_ether_hdr),
+		sizeof(struct rte_ipv6_hdr), sizeof(struct rte_udp_hdr) },
+	{ "IPv4/VxLAN/TCP/IPv4", PKT_TX_OUTER_IPV4 | PKT_TX_TUNNEL_VXLAN |
+		PKT_TX_IPV4 | PKT_TX_TCP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv4_hdr),
+		VXLAN_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_tcp_hdr) },
+	{ "IPv6/VxLAN/TCP/IPv4", PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_VXLAN |
+		PKT_TX_IPV4 | PKT_TX_TCP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv6_hdr),
+		VXLAN_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_tcp_hdr) },
+	{ "IPv4/VxLAN/UDP/IPv4", PKT_TX_OUTER_IPV4 | PKT_TX_TUNNEL_VXLAN |
+		PKT_TX_IPV4 | PKT_TX_UDP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv4_hdr),
+		VXLAN_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_udp_hdr) },
+	{ "IPv6/VxLAN/UDP/IPv4", PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_VXLAN |
+		PKT_TX_IPV4 | PKT_TX_UDP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv6_hdr),
+		VXLAN_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_udp_hdr) },
+	{ "IPv4/GRE/UDP/IPv4", PKT_TX_OUTER_IPV4 | PKT_TX_TUNNEL_GRE |
+		PKT_TX_IPV4 | PKT_TX_UDP_SEG,
+		sizeof(struct rte_ether_hdr), sizeof(struct rte_ipv4_hdr),
+		GRE_L2_LEN, sizeof(struct rte_ipv4_hdr),
+		sizeof(struct rte_udp_hdr) },
+};
+
+static struct rte_mempool *pkt_pool;
+static struct rte_mempool *direct_pool;
+static struct rte_mempool *indirect_pool;
+
+static struct rte_mbuf *
+gso_perf_build_pkt(const struct gso_perf_type *type)
+{
+	struct rte_mbuf *m;
+	struct rte_tcp_hdr *tcp_hdr;
+	uint16_t hdr_len;
+	char *data;
+
+	m = rte_pktmbuf_alloc(pkt_pool);
+	if (m == NULL)
+		return NULL;
+
+	hdr_len = type->outer_l2_len + type->outer_l3_len + type->l2_len +
+		type->l3_len + type->l4_len;
+	data = rte_pktmbuf_append(m, hdr_len + PAYLOAD_LEN);
+	if (data == NULL) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+
+	/*
+	 * GSO only rewrites length, ID, offset and sequence fields, so
+	 * zeroed headers are enough, apart from the TCP header length.
+	 */
+	memset(data, 0, hdr_len);
+	if (type->ol_flags & PKT_TX_TCP_SEG) {
+		tcp_hdr = (struct rte_tcp_hdr *)(data + hdr_len -
+				type->l4_len);
+		tcp_hdr->data_off = (type->l4_len / 4) << 4;
+	}
+
+	m->ol_flags = type->ol_flags;
+	m->outer_l2_len = type->outer_l2_len;
+	m->outer_l3_len = type->outer_l3_len;
+	m->l2_len = type->l2_len;
+	m->l3_len = type->l3_len;
+	m->l4_len = type->l4_len;
+
+	return m;
+}
+
+/*
+ * Measure the cycles rte_gso_segment() spends on one packet type, both
+ * when it segments the packet in software and when the packet is left
+ * untouched because it fits in the segment size, which is the path taken
+ * when segmentation is offloaded to NIC TSO/USO.
+ */
+static int
+gso_perf_run(const struct gso_perf_type *type, struct rte_gso_ctx *ctx)
+{
+	struct rte_mbuf *segs[MAX_SEGS_OUT];
+	struct rte_mbuf *pkt;
+	uint64_t start, gso_cycles = 0, bypass_cycles = 0, nb_segs = 0;
+	uint16_t gso_size = ctx->gso_size;
+	unsigned int i;
+	int ret, j;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		pkt = gso_perf_build_pkt(type);
+		if (pkt == NULL)
+			return -1;
+
+		start = rte_rdtsc_precise();
+		ret = rte_gso_segment(pkt, ctx, segs, MAX_SEGS_OUT);
+		gso_cycles += rte_rdtsc_precise() - start;
+		if (ret <= 1) {
+			printf("%s: packet not segmented (%d)\n",
+					type->name, ret);
+			rte_pktmbuf_free(pkt);
+			return -1;
+		}
+		nb_segs += ret;
+		for (j = 0; j < ret; j++)
+			rte_pktmbuf_free(segs[j]);
+
+		/* NIC TSO: the packet is handed to the device as is */
+		pkt = gso_perf_build_pkt(type);
+		if (pkt == NULL)
+			return -1;
+
+		ctx->gso_size = UINT16_MAX;
+		start = rte_rdtsc_precise();
+		ret = rte_gso_segment(pkt, ctx, segs, MAX_SEGS_OUT);
+		bypass_cycles += rte_rdtsc_precise() - start;
+		ctx->gso_size = gso_size;
+		rte_pktmbuf_free(pkt);
+		if (ret != 1)
+			return -1;
+	}
+
+	printf("%-22s %8.1f %10.1f %12.1f %10.1f\n", type->name,
+			(double)nb_segs / ITERATIONS,
+			(double)gso_cycles / ITERATIONS,
+			(double)gso_cycles / nb_segs,
+			(double)bypass_cycles / ITERATIONS);
+
+	return 0;
+}
+
+static int
+test_gso_perf(void)
+{
+	struct rte_gso_ctx ctx;
+	unsigned int i;
+	int ret = TEST_SUCCESS;
+
+	pkt_pool = rte_pktmbuf_pool_create("gso_perf_pkt", NB_MBUFS,
+			MBUF_CACHE_SIZE, 0, MBUF_DATA_SIZE, SOCKET_ID_ANY);
+	direct_pool = rte_pktmbuf_pool_create("gso_perf_direct", NB_MBUFS,
+			MBUF_CACHE_SIZE, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+			SOCKET_ID_ANY);
+	indirect_pool = rte_pktmbuf_pool_create("gso_perf_indirect",
+			NB_MBUFS, MBUF_CACHE_SIZE, 0, 0, SOCKET_ID_ANY);
+	if (pkt_pool == NULL || direct_pool == NULL ||
+			indirect_pool == NULL) {
+		printf("Cannot create mbuf pools\n");
+		ret = TEST_FAILED;
+		goto out;
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.direct_pool = direct_pool;
+	ctx.indirect_pool = indirect_pool;
+	ctx.gso_types = DEV_TX_OFFLOAD_TCP_TSO | DEV_TX_OFFLOAD_UDP_TSO |
+		DEV_TX_OFFLOAD_VXLAN_TNL_TSO | DEV_TX_OFFLOAD_GRE_TNL_TSO;
+	ctx.gso_size = GSO_SEG_SIZE;
+
+	printf("\n%u byte payload, %u byte segments, cycles per operation\n",
+			PAYLOAD_LEN, GSO_SEG_SIZE);
+	printf("%-22s %8s %10s %12s %10s\n", "type", "segs/pkt",
+			"GSO/pkt", "GSO/segment", "TSO/pkt");
+
+	for (i = 0; i < RTE_DIM(gso_perf_types); i++) {
+		if (gso_perf_run(&gso_perf_types[i], &ctx) < 0) {
+			printf("GSO perf test failed for %s\n",
+					gso_perf_types[i].name);
+			ret = TEST_FAILED;
+			break;
+		}
+	}
+
+out:
+	rte_mempool_free(pkt_pool);
+	rte_mempool_free(direct_pool);
+	rte_mempool_free(indirect_pool);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(gso_perf_autotest, test_gso_perf);
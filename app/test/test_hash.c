@@ -18,6 +18,7 @@
 #include <rte_eal.h>
 #include <rte_ip.h>
 #include <rte_string_fns.h>
+#include <rte_rcu_qsbr.h>
 
 #include "test.h"
 
@@ -1801,6 +1802,262 @@ test_hash_add_delete_jhash_3word(void)
 	return ret;
 }
 
+/*
+ * rte_hash_rcu_qsbr_add positive and negative tests.
+ *  - Add RCU QSBR variable to Hash
+ *  - Add another RCU QSBR variable to Hash
+ *  - Check returns
+ */
+static int
+test_hash_rcu_qsbr_add(void)
+{
+	size_t sz;
+	struct rte_rcu_qsbr *qsv2 = NULL;
+	int32_t status;
+	struct rte_hash_rcu_config rcu_cfg = {0};
+	struct rte_hash *handle = NULL;
+	struct rte_rcu_qsbr *qsv = NULL;
+
+	ut_params.name = "test_hash_rcu_qsbr_add";
+	handle = rte_hash_create(&ut_params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+					RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RETURN_IF_ERROR(qsv == NULL, "RCU QSBR variable creation failed");
+
+	status = rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+	RETURN_IF_ERROR(status != 0, "RCU QSBR variable initialization failed");
+
+	/* Invalid QSBR mode */
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = 2;
+	status = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+	RETURN_IF_ERROR(status == 0, "Invalid QSBR mode test failed");
+
+	rcu_cfg.mode = RTE_HASH_QSBR_MODE_DQ;
+	/* Attach RCU QSBR to hash table */
+	status = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+	RETURN_IF_ERROR(status != 0, "Attach RCU QSBR to hash table failed");
+
+	/* Create and attach another RCU QSBR to hash table */
+	qsv2 = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+					RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RETURN_IF_ERROR(qsv2 == NULL, "RCU QSBR variable creation failed");
+
+	rcu_cfg.v = qsv2;
+	rcu_cfg.mode = RTE_HASH_QSBR_MODE_SYNC;
+	status = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+	rte_free(qsv2);
+	RETURN_IF_ERROR(status == 0,
+			"Attach RCU QSBR to hash table succeeded where failure"
+			" is expected");
+
+	rte_hash_free(handle);
+	rte_free(qsv);
+
+	return 0;
+}
+
+static uint32_t hash_rcu_free_count;
+
+static void
+test_hash_rcu_free_key_data(void *p, void *key_data)
+{
+	RTE_SET_USED(p);
+	RTE_SET_USED(key_data);
+	hash_rcu_free_count++;
+}
+
+/*
+ * rte_hash_rcu_qsbr_add DQ mode functional test.
+ * Reader and writer are in the same thread in this test.
+ *  - Create hash which supports maximum 64 entries, with extendable
+ *    buckets so that the table can be filled completely
+ *  - Add RCU QSBR variable to hash
+ *  - Register a reader thread (not a real thread)
+ *  - Reader lookup existing entry
+ *  - Writer deletes all entries
+ *  - Adding a new key fails since the slots are not reclaimed yet
+ *  - Reader reports quiescent state
+ *  - Adding the keys again succeeds using the reclaimed slots
+ */
+static int
+test_hash_rcu_qsbr_dq_mode(void)
+{
+	uint32_t total_entries = 64;
+	uint8_t hash_extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF |
+				RTE_HASH_EXTRA_FLAGS_EXT_TABLE;
+	struct rte_hash_parameters params_pseudo_hash = ut_params;
+	struct rte_hash_rcu_config rcu_cfg = {0};
+	struct rte_hash *handle = NULL;
+	struct rte_rcu_qsbr *qsv = NULL;
+	struct flow_key key;
+	int32_t pos[64];
+	int32_t status;
+	size_t sz;
+	uint32_t i;
+
+	printf("\n# Running RCU QSBR DQ mode functional test\n");
+
+	params_pseudo_hash.name = "test_hash_rcu_qsbr_dq_mode";
+	params_pseudo_hash.entries = total_entries;
+	params_pseudo_hash.extra_flag = hash_extra_flag;
+	handle = rte_hash_create(&params_pseudo_hash);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+					RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RETURN_IF_ERROR(qsv == NULL, "RCU QSBR variable creation failed");
+
+	status = rte_rcu_qsbr_init(qsv, 1);
+	RETURN_IF_ERROR(status != 0, "RCU QSBR variable initialization failed");
+
+	/* Attach RCU QSBR to hash table */
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_HASH_QSBR_MODE_DQ;
+	rcu_cfg.free_key_data_func = test_hash_rcu_free_key_data;
+	rcu_cfg.key_data_ptr = NULL;
+	status = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+	RETURN_IF_ERROR(status != 0, "Attach RCU QSBR to hash table failed");
+
+	/* Register pseudo reader */
+	status = rte_rcu_qsbr_thread_register(qsv, 0);
+	RETURN_IF_ERROR(status != 0, "RCU QSBR thread registration failed");
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	hash_rcu_free_count = 0;
+	key = keys[0];
+
+	/* Fill the table */
+	for (i = 0; i < total_entries; i++) {
+		key.ip_src = keys[0].ip_src + i;
+		pos[i] = rte_hash_add_key(handle, &key);
+		RETURN_IF_ERROR(pos[i] < 0, "failed to add key");
+	}
+
+	/* Lookup */
+	key.ip_src = keys[0].ip_src;
+	status = rte_hash_lookup(handle, &key);
+	RETURN_IF_ERROR(status != pos[0], "failed to find key");
+
+	/* Writer deletes all the entries while the reader is still active */
+	for (i = 0; i < total_entries; i++) {
+		key.ip_src = keys[0].ip_src + i;
+		status = rte_hash_del_key(handle, &key);
+		RETURN_IF_ERROR(status != pos[i], "failed to delete key");
+	}
+	RETURN_IF_ERROR(hash_rcu_free_count != 0,
+			"key freed before reader reported quiescent state");
+
+	/* No slot can be reclaimed until the reader reports quiescent */
+	key.ip_src = keys[0].ip_src + total_entries;
+	status = rte_hash_add_key(handle, &key);
+	RETURN_IF_ERROR(status != -ENOSPC,
+			"key added while deleted slots are still referenced");
+
+	/* Reader quiescent */
+	rte_rcu_qsbr_quiescent(qsv, 0);
+
+	/* Writer re-adds the keys reusing the reclaimed slots */
+	for (i = 0; i < total_entries; i++) {
+		key.ip_src = keys[0].ip_src + i;
+		status = rte_hash_add_key(handle, &key);
+		RETURN_IF_ERROR(status < 0, "failed to add key after reclaim");
+	}
+	RETURN_IF_ERROR(hash_rcu_free_count == 0,
+			"free key data function was not called");
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	(void)rte_rcu_qsbr_thread_unregister(qsv, 0);
+
+	rte_hash_free(handle);
+	rte_free(qsv);
+
+	return 0;
+}
+
+/*
+ * rte_hash_rcu_qsbr_add SYNC mode functional test.
+ * The reader thread is offline, hence the delete returns only once the
+ * slot has been reclaimed and it can be reused immediately.
+ */
+static int
+test_hash_rcu_qsbr_sync_mode(uint8_t ext_bkt)
+{
+	uint32_t total_entries = 64;
+	uint8_t hash_extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF;
+	struct rte_hash_parameters params_pseudo_hash = ut_params;
+	struct rte_hash_rcu_config rcu_cfg = {0};
+	struct rte_hash *handle = NULL;
+	struct rte_rcu_qsbr *qsv = NULL;
+	struct flow_key key;
+	int32_t status;
+	size_t sz;
+	uint32_t i;
+
+	if (ext_bkt)
+		hash_extra_flag |= RTE_HASH_EXTRA_FLAGS_EXT_TABLE;
+
+	printf("\n# Running RCU QSBR sync mode functional test with"
+	       " ext_bkt=%d\n", ext_bkt);
+
+	params_pseudo_hash.name = "test_hash_rcu_qsbr_sync_mode";
+	params_pseudo_hash.entries = total_entries;
+	params_pseudo_hash.extra_flag = hash_extra_flag;
+	handle = rte_hash_create(&params_pseudo_hash);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+					RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RETURN_IF_ERROR(qsv == NULL, "RCU QSBR variable creation failed");
+
+	status = rte_rcu_qsbr_init(qsv, 1);
+	RETURN_IF_ERROR(status != 0, "RCU QSBR variable initialization failed");
+
+	/* Attach RCU QSBR to hash table */
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_HASH_QSBR_MODE_SYNC;
+	rcu_cfg.free_key_data_func = test_hash_rcu_free_key_data;
+	rcu_cfg.key_data_ptr = NULL;
+	status = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+	RETURN_IF_ERROR(status != 0, "Attach RCU QSBR to hash table failed");
+
+	/* Register pseudo reader, it stays offline */
+	status = rte_rcu_qsbr_thread_register(qsv, 0);
+	RETURN_IF_ERROR(status != 0, "RCU QSBR thread registration failed");
+
+	hash_rcu_free_count = 0;
+	key = keys[0];
+
+	/*
+	 * Add and delete more keys than the table can hold. This fails if
+	 * the deleted slots are not returned to the free list.
+	 */
+	for (i = 0; i < 2 * total_entries; i++) {
+		key.ip_src = keys[0].ip_src + i;
+		status = rte_hash_add_key(handle, &key);
+		RETURN_IF_ERROR(status < 0, "failed to add key");
+		status = rte_hash_del_key(handle, &key);
+		RETURN_IF_ERROR(status < 0, "failed to delete key");
+	}
+	RETURN_IF_ERROR(hash_rcu_free_count != 2 * total_entries,
+			"free key data function was not called on delete");
+
+	(void)rte_rcu_qsbr_thread_unregister(qsv, 0);
+
+	rte_hash_free(handle);
+	rte_free(qsv);
+
+	return 0;
+}
+
 /*
  * Do all unit and performance tests.
  */
@@ -1862,6 +2119,18 @@ test_hash(void)
 	if (test_crc32_hash_alg_equiv() < 0)
 		return -1;
 
+	if (test_hash_rcu_qsbr_add() < 0)
+		return -1;
+
+	if (test_hash_rcu_qsbr_dq_mode() < 0)
+		return -1;
+
+	if (test_hash_rcu_qsbr_sync_mode(0) < 0)
+		return -1;
+
+	if (test_hash_rcu_qsbr_sync_mode(1) < 0)
+		return -1;
+
 	return 0;
 }
 
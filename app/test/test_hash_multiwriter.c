@@ -45,8 +45,10 @@ uint32_t rounded_nb_total_tsx_insertion;
 
 static rte_atomic64_t gcycles;
 static rte_atomic64_t ginsertions;
+static rte_atomic64_t gdel_failures;
 
 static int use_htm;
+static int use_mw_concur;
 
 static int
 test_hash_multiwriter_worker(void *arg)
@@ -94,6 +96,38 @@ test_hash_multiwriter_worker(void *arg)
 	return 0;
 }
 
+static int
+test_hash_multiwriter_del_worker(void *arg)
+{
+	uint64_t i, offset;
+	int32_t pos;
+	uint16_t pos_core;
+	uint32_t lcore_id = rte_lcore_id();
+	uint16_t *enabled_core_ids = (uint16_t *)arg;
+
+	for (pos_core = 0; pos_core < rte_lcore_count(); pos_core++) {
+		if (enabled_core_ids[pos_core] == lcore_id)
+			break;
+	}
+
+	offset = pos_core * tbl_multiwriter_test_params.nb_tsx_insertion;
+
+	for (i = offset;
+	     i < offset + tbl_multiwriter_test_params.nb_tsx_insertion;
+	     i++) {
+		/* Skip the keys which failed to be inserted */
+		if (tbl_multiwriter_test_params.found[i] == 0)
+			continue;
+		pos = rte_hash_del_key(tbl_multiwriter_test_params.h,
+				       tbl_multiwriter_test_params.keys + i);
+		/* Key slots are not freed on delete in lock free mode */
+		if (pos < 0 || rte_hash_free_key_with_position(
+				tbl_multiwriter_test_params.h, pos) != 0)
+			rte_atomic64_inc(&gdel_failures);
+	}
+
+	return 0;
+}
 
 static int
 test_hash_multiwriter(void)
@@ -120,6 +154,9 @@ test_hash_multiwriter(void)
 	else
 		hash_params.extra_flag =
 			RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD;
+	if (use_mw_concur)
+		hash_params.extra_flag =
+			RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY;
 
 	struct rte_hash *handle;
 	char name[RTE_HASH_NAMESIZE];
@@ -243,6 +280,31 @@ test_hash_multiwriter(void)
 
 	printf(" cycles per insertion: %llu\n", cycles_per_insertion);
 
+	if (use_mw_concur) {
+		/* Delete all the keys concurrently from all the cores. */
+		rte_atomic64_init(&gdel_failures);
+		rte_atomic64_clear(&gdel_failures);
+		rte_eal_mp_remote_launch(test_hash_multiwriter_del_worker,
+					 enabled_core_ids, CALL_MASTER);
+		rte_eal_mp_wait_lcore();
+
+		if (rte_atomic64_read(&gdel_failures) != 0) {
+			printf("%"PRId64" keys failed to be deleted\n",
+				rte_atomic64_read(&gdel_failures));
+			goto err3;
+		}
+
+		count = rte_hash_count(handle);
+		iter = 0;
+		if (count != 0 || rte_hash_iterate(handle, &next_key,
+				&next_data, &iter) >= 0) {
+			printf("%u keys left after concurrent deletion\n",
+				count);
+			goto err3;
+		}
+		printf("No key left after multiwriter deletion.\n");
+	}
+
 	rte_free(tbl_multiwriter_test_params.found);
 	rte_free(tbl_multiwriter_test_params.keys);
 	rte_hash_free(handle);
@@ -287,6 +349,14 @@ test_hash_multiwriter_main(void)
 	if (test_hash_multiwriter() < 0)
 		return -1;
 
+	printf("Test multi-writer with per bucket writer locks\n");
+	use_mw_concur = 1;
+	if (test_hash_multiwriter() < 0) {
+		use_mw_concur = 0;
+		return -1;
+	}
+	use_mw_concur = 0;
+
 	return 0;
 }
 
@@ -20,6 +20,10 @@
 #define RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF 0
 #endif
 
+#ifndef RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY
+#define RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY 0
+#endif
+
 #define BULK_LOOKUP_SIZE 32
 
 #define RUN_WITH_HTM_DISABLED 0
@@ -48,6 +52,9 @@
 #define WRITE_EXT_BKT 2
 
 #define NUM_TEST 3
+
+/* Number of keys added by the writers in the insert scaling test */
+#define MULTI_WRITER_ADD_KEYS (TOTAL_INSERT / 10 * 9)
 static unsigned int rwc_core_cnt[NUM_TEST] = {1, 2, 4};
 
 struct rwc_perf {
@@ -58,6 +65,7 @@ struct rwc_perf {
 	uint32_t w_ks_r_miss[2][NUM_TEST];
 	uint32_t multi_rw[NUM_TEST - 1][2][NUM_TEST];
 	uint32_t w_ks_r_hit_extbkt[2][NUM_TEST];
+	uint32_t multi_writer_add[2][RTE_MAX_LCORE];
 };
 
 static struct rwc_perf rwc_lf_results, rwc_non_lf_results;
@@ -689,6 +697,18 @@ test_rwc_multi_writer(__rte_unused void *arg)
 	return 0;
 }
 
+static int
+test_rwc_multi_writer_add(void *arg)
+{
+	uint32_t i, offset;
+	uint32_t pos_core = (uint32_t)((uintptr_t)arg);
+	offset = pos_core * tbl_rwc_test_param.single_insert;
+	for (i = offset; i < offset + tbl_rwc_test_param.single_insert; i++)
+		rte_hash_add_key(tbl_rwc_test_param.h,
+				 tbl_rwc_test_param.keys + i);
+	return 0;
+}
+
 /*
  * Test lookup perf:
  * Reader(s) lookup keys present in the table.
@@ -1240,6 +1260,70 @@ test_hash_add_ks_lookup_hit_extbkt(struct rwc_perf *rwc_perf_results,
 	return -1;
 }
 
+/*
+ * Test insert perf:
+ * Writers add keys in parallel, on different data plane cores, while the
+ * number of writers goes from 1 to the number of available cores.
+ * mw_concur indicates if writers take per bucket locks instead of the
+ * table wide lock.
+ */
+static int
+test_hash_multi_writer_add(struct rwc_perf *rwc_perf_results, int mw_concur)
+{
+	unsigned int n, i;
+	uint64_t begin, cycles;
+	unsigned int max_writers = rte_lcore_count() - 1;
+	struct rte_hash_parameters hash_params = {
+		.name = "tests",
+		.entries = TOTAL_ENTRY,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_hash_crc,
+		.hash_func_init_val = 0,
+		.socket_id = rte_socket_id(),
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF |
+			      RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD,
+	};
+
+	if (mw_concur)
+		hash_params.extra_flag |=
+			RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY;
+
+	tbl_rwc_test_param.h = rte_hash_create(&hash_params);
+	if (tbl_rwc_test_param.h == NULL) {
+		printf("hash creation failed");
+		return -1;
+	}
+
+	printf("\nTest: Multi-writer add, %s\n", mw_concur ?
+	       "per bucket writer locks" : "table writer lock");
+	for (n = 1; n <= max_writers; n++) {
+		printf("\nNumber of writers: %u\n", n);
+
+		rte_hash_reset(tbl_rwc_test_param.h);
+		tbl_rwc_test_param.single_insert = MULTI_WRITER_ADD_KEYS / n;
+
+		begin = rte_rdtsc_precise();
+		for (i = 1; i <= n; i++)
+			rte_eal_remote_launch(test_rwc_multi_writer_add,
+					      (void *)(uintptr_t)(i - 1),
+					      enabled_core_ids[i]);
+		for (i = 1; i <= n; i++)
+			rte_eal_wait_lcore(enabled_core_ids[i]);
+		cycles = rte_rdtsc_precise() - begin;
+
+		unsigned long long cycles_per_insert = cycles /
+			(tbl_rwc_test_param.single_insert * n);
+		rwc_perf_results->multi_writer_add[mw_concur][n - 1] =
+			cycles_per_insert;
+		printf("Cycles per insert: %llu (%u keys in the table)\n",
+		       cycles_per_insert,
+		       rte_hash_count(tbl_rwc_test_param.h));
+	}
+
+	rte_hash_free(tbl_rwc_test_param.h);
+	return 0;
+}
+
 static int
 test_hash_readwrite_lf_perf_main(void)
 {
@@ -1299,6 +1383,12 @@ test_hash_readwrite_lf_perf_main(void)
 		if (test_hash_add_ks_lookup_hit_extbkt(&rwc_lf_results, rwc_lf,
 							htm, ext_bkt) < 0)
 			return -1;
+		if (test_hash_multi_writer_add(&rwc_lf_results, 0) < 0)
+			return -1;
+		if (RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY &&
+				test_hash_multi_writer_add(&rwc_lf_results,
+							   1) < 0)
+			return -1;
 	}
 	printf("\nTest lookup with read-write concurrency lock free support"
 	       " disabled\n");
@@ -1420,6 +1510,22 @@ test_hash_readwrite_lf_perf_main(void)
 			}
 		}
 	}
+
+	if (RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF) {
+		printf("\n\t\t\t\t\t#######********** Multi-writer add "
+		       "**********#######\n\n");
+		printf("_______\t\t_________________\t\t"
+		       "_________________________\n");
+		printf("Writers\t\tCycles per insert\t\t"
+		       "Cycles per insert\n");
+		printf("\t\t(table lock)\t\t\t(per bucket locks)\n");
+		printf("_______\t\t_________________\t\t"
+		       "_________________________\n");
+		for (i = 0; i < (int)rte_lcore_count() - 1; i++)
+			printf("%u\t\t%u\t\t\t\t%u\n", i + 1,
+			       rwc_lf_results.multi_writer_add[0][i],
+			       rwc_lf_results.multi_writer_add[1][i]);
+	}
 	rte_free(tbl_rwc_test_param.keys);
 	rte_free(tbl_rwc_test_param.keys_no_ks);
 	rte_free(tbl_rwc_test_param.keys_ks);
@@ -238,6 +238,264 @@ test_ip_frag(void)
 	return result;
 }
 
+static void
+test_set_frag_lens(struct rte_mbuf *mb[], uint32_t num, uint16_t l3_len)
+{
+	uint32_t i;
+
+	for (i = 0; i < num; i++) {
+		mb[i]->l2_len = 0;
+		mb[i]->l3_len = l3_len;
+	}
+}
+
+static int
+test_ip_frag_fragment(int ipv, uint16_t pktid, size_t pkt_size,
+		      uint16_t mtu_size, struct rte_mbuf *pkts_out[],
+		      uint16_t nb_pkts_out)
+{
+	struct rte_mbuf *b = rte_pktmbuf_alloc(pkt_pool);
+	int32_t len;
+
+	if (b == NULL)
+		return -ENOMEM;
+
+	if (ipv == 4) {
+		v4_allocate_packet_of(b, 0x41414141, pkt_size, 0, 64,
+				      IPPROTO_ICMP, pktid);
+		len = rte_ipv4_fragment_packet(b, pkts_out, nb_pkts_out,
+					       mtu_size, direct_pool,
+					       indirect_pool);
+		if (len > 0)
+			test_set_frag_lens(pkts_out, len,
+					   sizeof(struct rte_ipv4_hdr));
+	} else {
+		v6_allocate_packet_of(b, 0x41414141, pkt_size, 64,
+				      IPPROTO_ICMP, pktid);
+		len = rte_ipv6_fragment_packet(b, pkts_out, nb_pkts_out,
+					       mtu_size, direct_pool,
+					       indirect_pool);
+		if (len > 0)
+			test_set_frag_lens(pkts_out, len,
+					   sizeof(struct rte_ipv6_hdr) +
+					   sizeof(struct ipv6_extension_fragment));
+	}
+
+	rte_pktmbuf_free(b);
+	return len;
+}
+
+/*
+ * Fragment a packet into pkts from the last fragment to the first one,
+ * followed by a packet that is not fragmented.
+ */
+static int
+test_ip_frag_reassembly_burst(int ipv, uint16_t pktid, size_t pkt_size,
+			      uint16_t mtu_size, struct rte_mbuf *pkts[])
+{
+	struct rte_mbuf *b;
+	int32_t i, len;
+
+	len = test_ip_frag_fragment(ipv, pktid, pkt_size, mtu_size, pkts,
+				    BURST - 1);
+	if (len <= 0)
+		return len;
+
+	for (i = 0; i < len / 2; i++) {
+		b = pkts[i];
+		pkts[i] = pkts[len - 1 - i];
+		pkts[len - 1 - i] = b;
+	}
+
+	b = rte_pktmbuf_alloc(pkt_pool);
+	if (b == NULL) {
+		test_free_fragments(pkts, len);
+		return -ENOMEM;
+	}
+
+	v4_allocate_packet_of(b, 0x41414141, 100, 1, 64, IPPROTO_ICMP, 0);
+	b->l2_len = 0;
+	b->l3_len = sizeof(struct rte_ipv4_hdr);
+	pkts[len] = b;
+
+	return len + 1;
+}
+
+static int
+test_ip_frag_reassemble(void)
+{
+	static struct rte_ip_frag_death_row dr;
+	struct rte_ip_frag_tbl *tbl, *small_tbl;
+	struct rte_mbuf *pkts[BURST];
+	struct rte_mbuf *b;
+	int32_t len;
+	uint16_t n;
+	size_t i;
+
+	struct test_ip_reassembly {
+		int      ipv;
+		size_t   mtu_size;
+		size_t   pkt_size;
+		int      expected_frags;
+		size_t   hdr_size;
+	} tests[] = {
+		     {4, 600, 1400, 3, sizeof(struct rte_ipv4_hdr)},
+		     {4, 200, 1400, 8, sizeof(struct rte_ipv4_hdr)},
+		     {6, 1280, 1400, 2, sizeof(struct rte_ipv6_hdr)},
+	};
+
+	struct rte_ip_frag_tbl_params params = {
+		.bucket_num = 16,
+		.bucket_entries = 4,
+		.max_entries = 64,
+		.max_cycles = rte_get_tsc_hz(),
+		.socket_id = SOCKET_ID_ANY,
+		.max_frags = 16,
+	};
+
+	tbl = rte_ip_frag_table_create_with_params(&params);
+	RTE_TEST_ASSERT_NOT_EQUAL(tbl, NULL, "Failed to create table.");
+
+	/* with the default number of fragments per packet */
+	params.max_frags = 0;
+	small_tbl = rte_ip_frag_table_create_with_params(&params);
+	RTE_TEST_ASSERT_NOT_EQUAL(small_tbl, NULL,
+				  "Failed to create table.");
+
+	params.max_frags = RTE_IP_FRAG_TBL_MAX_FRAGS + 1;
+	RTE_TEST_ASSERT_EQUAL(rte_ip_frag_table_create_with_params(&params),
+			      NULL, "Created table with too many fragments.");
+
+	for (i = 0; i < RTE_DIM(tests); i++) {
+		if (tests[i].expected_frags > IP_MAX_FRAG_NUM) {
+			len = test_ip_frag_reassembly_burst(tests[i].ipv, i,
+					tests[i].pkt_size, tests[i].mtu_size,
+					pkts);
+			RTE_TEST_ASSERT_EQUAL(len, tests[i].expected_frags + 1,
+				"Failed to fragment case %zd.\n", i);
+			b = pkts[len - 1];
+
+			n = rte_ip_frag_reassemble_burst(small_tbl, &dr, pkts,
+							 len, rte_rdtsc());
+			rte_ip_frag_free_death_row(&dr, 0);
+
+			RTE_TEST_ASSERT_EQUAL(n, 1,
+				"Reassembled too many fragments in case %zd.\n",
+				i);
+			RTE_TEST_ASSERT_EQUAL(pkts[0], b,
+				"Lost packet in case %zd.\n", i);
+			rte_pktmbuf_free(b);
+		}
+
+		len = test_ip_frag_reassembly_burst(tests[i].ipv, i,
+						    tests[i].pkt_size,
+						    tests[i].mtu_size, pkts);
+		RTE_TEST_ASSERT_EQUAL(len, tests[i].expected_frags + 1,
+				      "Failed to fragment case %zd.\n", i);
+		b = pkts[len - 1];
+
+		n = rte_ip_frag_reassemble_burst(tbl, &dr, pkts, len,
+						 rte_rdtsc());
+		rte_ip_frag_free_death_row(&dr, 0);
+
+		printf("%zd: reassembled %d fragments, %u packets\n", i,
+		       len - 1, n);
+		RTE_TEST_ASSERT_EQUAL(n, 2,
+				      "Failed to reassemble case %zd.\n", i);
+		RTE_TEST_ASSERT_EQUAL(pkts[0]->pkt_len,
+				      tests[i].pkt_size + tests[i].hdr_size,
+				      "Wrong reassembled length in case %zd.\n",
+				      i);
+		RTE_TEST_ASSERT_EQUAL(pkts[1], b,
+				      "Lost packet in case %zd.\n", i);
+		test_free_fragments(pkts, n);
+	}
+
+	rte_ip_frag_table_destroy(small_tbl);
+	rte_ip_frag_table_destroy(tbl);
+
+	return TEST_SUCCESS;
+}
+
+#define NB_SHARDS 2
+#define NB_SHARD_PKTS 8
+
+static int
+test_ip_frag_shards(void)
+{
+	static struct rte_ip_frag_death_row dr;
+	struct rte_ip_frag_shards *shards;
+	struct rte_mbuf *pkts[NB_SHARD_PKTS * 3];
+	struct rte_mbuf *out[RTE_DIM(pkts)];
+	uint32_t i, nb_out;
+	uint64_t tms;
+	int32_t len;
+	uint16_t n;
+
+	struct rte_ip_frag_shards_params params = {
+		.name = "test_frag_shards",
+		.nb_shards = NB_SHARDS,
+		.ring_size = 64,
+		.tbl = {
+			.bucket_num = 16,
+			.bucket_entries = 4,
+			.max_entries = 64,
+			.max_cycles = rte_get_tsc_hz(),
+			.socket_id = SOCKET_ID_ANY,
+		},
+	};
+
+	shards = rte_ip_frag_shards_create(&params);
+	RTE_TEST_ASSERT_NOT_EQUAL(shards, NULL, "Failed to create shards.");
+	RTE_TEST_ASSERT_NOT_EQUAL(rte_ip_frag_shards_get_table(shards, 0),
+				  NULL, "No table for shard 0.");
+	RTE_TEST_ASSERT_EQUAL(rte_ip_frag_shards_get_table(shards,
+							   NB_SHARDS),
+			      NULL, "Table for an invalid shard.");
+
+	/* datagrams of different ids, all received by shard 0 */
+	n = 0;
+	for (i = 0; i < NB_SHARD_PKTS; i++) {
+		len = test_ip_frag_fragment(4, i + 1, 1400, 600, pkts + n,
+					    RTE_DIM(pkts) - n);
+		RTE_TEST_ASSERT_EQUAL(len, 3, "Failed to fragment packet.");
+		n += len;
+	}
+
+	tms = rte_rdtsc();
+
+	/* shard 0 keeps its datagrams and hands the others over */
+	nb_out = rte_ip_frag_shards_reassemble_burst(shards, 0, &dr, pkts, n,
+						     out, RTE_DIM(out), tms);
+	RTE_TEST_ASSERT(nb_out < NB_SHARD_PKTS,
+			"No fragment handed over to shard 1.");
+
+	/* nothing is dequeued without room in the out array */
+	RTE_TEST_ASSERT_EQUAL(rte_ip_frag_shards_reassemble_burst(shards, 1,
+					&dr, NULL, 0, out + nb_out, 0, tms),
+			      0, "Reassembled packets without room.");
+
+	/* shard 1 polls the datagrams handed over to it */
+	nb_out += rte_ip_frag_shards_reassemble_burst(shards, 1, &dr, NULL, 0,
+						      out + nb_out,
+						      RTE_DIM(out) - nb_out,
+						      tms);
+	rte_ip_frag_free_death_row(&dr, 0);
+
+	printf("reassembled %u fragments, %u packets\n", n, nb_out);
+	RTE_TEST_ASSERT_EQUAL(nb_out, NB_SHARD_PKTS,
+			      "Failed to reassemble on shards.");
+	for (i = 0; i < nb_out; i++)
+		RTE_TEST_ASSERT_EQUAL(out[i]->pkt_len,
+				      1400 + sizeof(struct rte_ipv4_hdr),
+				      "Wrong reassembled length.");
+
+	test_free_fragments(out, nb_out);
+	rte_ip_frag_shards_destroy(shards);
+
+	return TEST_SUCCESS;
+}
+
 static struct unit_test_suite ipfrag_testsuite  = {
 	.suite_name = "IP Frag Unit Test Suite",
 	.setup = testsuite_setup,
@@ -245,6 +503,10 @@ static struct unit_test_suite ipfrag_testsuite  = {
 	.unit_test_cases = {
 		TEST_CASE_ST(ut_setup, ut_teardown,
 			     test_ip_frag),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			     test_ip_frag_reassemble),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			     test_ip_frag_shards),
 
 		TEST_CASES_END() /**< NULL terminate unit test array */
 	}
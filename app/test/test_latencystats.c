@@ -13,7 +13,7 @@
 #include "sample_packet_forward.h"
 #include "test.h"
 
-#define NUM_STATS 4
+#define NUM_STATS 9
 #define LATENCY_NUM_PACKETS 10
 #define QUEUE_ID 0
 
@@ -25,6 +25,11 @@ static struct rte_metric_name lat_stats_strings[] = {
 	{"avg_latency_ns"},
 	{"max_latency_ns"},
 	{"jitter_ns"},
+	{"p50_latency_ns"},
+	{"p90_latency_ns"},
+	{"p99_latency_ns"},
+	{"p999_latency_ns"},
+	{"p9999_latency_ns"},
 };
 
 /* Test case for latency init with metrics init */
@@ -80,7 +85,7 @@ static int test_latencystats_get_names(void)
 	/* Success Test: Valid names and size */
 	size = NUM_STATS;
 	ret = rte_latencystats_get_names(names, size);
-	for (i = 0; i <= NUM_STATS; i++) {
+	for (i = 0; i < NUM_STATS; i++) {
 		if (strcmp(lat_stats_strings[i].name, names[i].name) == 0)
 			printf(" %s\n", names[i].name);
 		else
@@ -119,6 +124,18 @@ static int test_latencystats_get(void)
 	TEST_ASSERT((ret == NUM_STATS), "Test Failed to get latency metrics"
 			" values");
 
+	/* Percentiles are ordered and bounded by the minimum and maximum */
+	for (i = 4; i < NUM_STATS; i++) {
+		TEST_ASSERT(values[i].value >= values[i - 1].value ||
+			i == 4, "Test Failed: %s lower than %s",
+			lat_stats_strings[i].name,
+			lat_stats_strings[i - 1].name);
+		TEST_ASSERT(values[i].value >= values[0].value &&
+			values[i].value <= values[2].value,
+			"Test Failed: %s out of the latency range",
+			lat_stats_strings[i].name);
+	}
+
 	/* Failure Test: Invalid values and valid size */
 	ret = rte_latencystats_get(NULL, size);
 	TEST_ASSERT((ret == NUM_STATS), "Test Failed to get the stats count,"
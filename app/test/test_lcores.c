@@ -2,10 +2,12 @@
  * Copyright (c) 2020 Red Hat, Inc.
  */
 
+#include <inttypes.h>
 #include <pthread.h>
 #include <string.h>
 
 #include <rte_common.h>
+#include <rte_cycles.h>
 #include <rte_errno.h>
 #include <rte_lcore.h>
 
@@ -340,6 +342,51 @@ test_non_eal_lcores_callback(unsigned int eal_threads_count)
 	return -1;
 }
 
+static int
+test_lcore_busy_stats(void)
+{
+	struct rte_lcore_busy_stats before, after;
+	unsigned int lcore_id = rte_lcore_id();
+
+	if (rte_lcore_busy_stats_get(RTE_MAX_LCORE, &before) != -EINVAL) {
+		printf("Error: busy stats of invalid lcore should have failed\n");
+		return -1;
+	}
+
+	/* first report starts the accounting, if not done yet */
+	rte_lcore_busy_report(0);
+	if (rte_lcore_busy_stats_get(lcore_id, &before) != 0) {
+		printf("Error: could not get busy stats of lcore %u\n",
+			lcore_id);
+		return -1;
+	}
+
+	/* empty poll, then one with work, then empty again */
+	rte_lcore_busy_report(1);
+	rte_delay_us(100);
+	rte_lcore_busy_report(0);
+	rte_delay_us(100);
+	rte_lcore_busy_report(0);
+	rte_lcore_busy_stats_get(lcore_id, &after);
+
+	if (after.busy_polls - before.busy_polls != 1 ||
+			after.idle_polls - before.idle_polls != 2) {
+		printf("Error: busy stats polls, expected 1, 2, got %"PRIu64", %"PRIu64"\n",
+			after.busy_polls - before.busy_polls,
+			after.idle_polls - before.idle_polls);
+		return -1;
+	}
+	if (after.busy_cycles - before.busy_cycles < rte_get_tsc_hz() / 10000 ||
+			after.idle_cycles - before.idle_cycles <
+			rte_get_tsc_hz() / 10000) {
+		printf("Error: busy stats cycles, got %"PRIu64", %"PRIu64"\n",
+			after.busy_cycles - before.busy_cycles,
+			after.idle_cycles - before.idle_cycles);
+		return -1;
+	}
+	return 0;
+}
+
 static int
 test_lcores(void)
 {
@@ -367,6 +414,9 @@ test_lcores(void)
 	if (test_non_eal_lcores_callback(eal_threads_count) < 0)
 		return TEST_FAILED;
 
+	if (test_lcore_busy_stats() < 0)
+		return TEST_FAILED;
+
 	return TEST_SUCCESS;
 }
 
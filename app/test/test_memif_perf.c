@@ -0,0 +1,235 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_bus_vdev.h>
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_ethdev.h>
+#include <rte_mbuf.h>
+
+#include "test.h"
+
+#define MEMIF_PERF_MASTER "net_memif_perf0"
+#define MEMIF_PERF_SLAVE "net_memif_perf1"
+
+#define NB_TX_MBUFS 2048
+#define NB_RX_MBUFS 8192
+#define MBUF_CACHE_SIZE 256
+#define TX_DATA_SIZE (RTE_PKTMBUF_HEADROOM + 9216)
+#define NB_DESC 1024
+#define MAX_BURST 32
+#define NB_PKTS (1 << 18)
+#define LINK_WAIT_MS 5000
+
+static const uint16_t pkt_sizes[] = {
+	64, 128, 256, 512, 1024, 1518, 2048, 4096, 9000
+};
+
+static struct rte_mempool *tx_pool;
+static struct rte_mempool *rx_pool;
+
+static int
+memif_perf_port_setup(const char *name, const char *args, uint16_t *port)
+{
+	struct rte_eth_conf conf = {0};
+
+	if (rte_vdev_init(name, args) != 0)
+		return -1;
+	if (rte_eth_dev_get_port_by_name(name, port) != 0)
+		return -1;
+
+	if (rte_eth_dev_configure(*port, 1, 1, &conf) != 0 ||
+			rte_eth_rx_queue_setup(*port, 0, NB_DESC,
+				rte_socket_id(), NULL, rx_pool) != 0 ||
+			rte_eth_tx_queue_setup(*port, 0, NB_DESC,
+				rte_socket_id(), NULL) != 0 ||
+			rte_eth_dev_start(*port) != 0)
+		return -1;
+	return 0;
+}
+
+static void
+memif_perf_port_remove(const char *name)
+{
+	uint16_t port;
+
+	if (rte_eth_dev_get_port_by_name(name, &port) == 0) {
+		rte_eth_dev_stop(port);
+		rte_eth_dev_close(port);
+	}
+	rte_vdev_uninit(name);
+}
+
+static int
+memif_perf_wait_link(uint16_t port)
+{
+	struct rte_eth_link link;
+	unsigned int i;
+
+	for (i = 0; i != LINK_WAIT_MS / 10; i++) {
+		memset(&link, 0, sizeof(link));
+		if (rte_eth_link_get_nowait(port, &link) == 0 &&
+				link.link_status == ETH_LINK_UP)
+			return 0;
+		rte_delay_ms(10);
+	}
+	return -1;
+}
+
+/* send NB_PKTS packets of given size from one port to the other */
+static int
+memif_perf_run(uint16_t tx_port, uint16_t rx_port, uint16_t size)
+{
+	struct rte_mbuf *tx_pkts[MAX_BURST];
+	struct rte_mbuf *rx_pkts[MAX_BURST];
+	uint64_t start, rx_start, rx_cycles, cycles;
+	uint32_t nb_tx, nb_rx, idle;
+	uint16_t i, n;
+
+	nb_tx = 0;
+	nb_rx = 0;
+	idle = 0;
+	rx_cycles = 0;
+	start = rte_rdtsc();
+
+	while (nb_rx != NB_PKTS) {
+		if (nb_tx != NB_PKTS) {
+			n = RTE_MIN((uint32_t)MAX_BURST, NB_PKTS - nb_tx);
+			if (rte_pktmbuf_alloc_bulk(tx_pool, tx_pkts, n) != 0)
+				return -1;
+			for (i = 0; i != n; i++) {
+				tx_pkts[i]->data_len = size;
+				tx_pkts[i]->pkt_len = size;
+			}
+			i = rte_eth_tx_burst(tx_port, 0, tx_pkts, n);
+			nb_tx += i;
+			for (; i != n; i++)
+				rte_pktmbuf_free(tx_pkts[i]);
+		}
+
+		rx_start = rte_rdtsc();
+		n = rte_eth_rx_burst(rx_port, 0, rx_pkts, MAX_BURST);
+		for (i = 0; i != n; i++) {
+			if (rx_pkts[i]->pkt_len != size) {
+				printf("Received packet of %u bytes, expected %u\n",
+					rx_pkts[i]->pkt_len, size);
+				return -1;
+			}
+			rte_pktmbuf_free(rx_pkts[i]);
+		}
+		rx_cycles += rte_rdtsc() - rx_start;
+		nb_rx += n;
+
+		/* give up if packets stop arriving */
+		idle = (n == 0) ? idle + 1 : 0;
+		if (idle > 1000000) {
+			printf("Stalled after %u of %u packets\n",
+				nb_rx, NB_PKTS);
+			return -1;
+		}
+	}
+
+	cycles = rte_rdtsc() - start;
+	printf("%6u %12.2f %14.1f %18.1f\n", size,
+		(double)NB_PKTS * rte_get_tsc_hz() / cycles / 1e6,
+		(double)cycles / NB_PKTS, (double)rx_cycles / NB_PKTS);
+	return 0;
+}
+
+static int
+memif_perf_mode(const char *extbuf)
+{
+	char path[PATH_MAX];
+	char master_args[PATH_MAX + 64];
+	char slave_args[PATH_MAX + 64];
+	uint16_t master, slave;
+	unsigned int i;
+	int ret = -1;
+
+	/*
+	 * Both ends live in this process, the socket hash is keyed on the
+	 * file name so the slave uses an equivalent path to get its own
+	 * (client) socket instead of the master's listener.
+	 */
+	snprintf(path, sizeof(path), "%s/memif_perf.sock",
+		rte_eal_get_runtime_dir());
+	snprintf(master_args, sizeof(master_args),
+		"role=master,socket=%s,extbuf=%s", path, extbuf);
+	snprintf(slave_args, sizeof(slave_args),
+		"role=slave,socket=%s/./memif_perf.sock,extbuf=%s",
+		rte_eal_get_runtime_dir(), extbuf);
+	/* left behind by an interrupted run */
+	unlink(path);
+
+	if (memif_perf_port_setup(MEMIF_PERF_MASTER, master_args,
+			&master) != 0 ||
+			memif_perf_port_setup(MEMIF_PERF_SLAVE, slave_args,
+			&slave) != 0) {
+		printf("Cannot create memif ports\n");
+		goto out;
+	}
+	if (memif_perf_wait_link(master) != 0 ||
+			memif_perf_wait_link(slave) != 0) {
+		printf("Memif ports failed to connect\n");
+		goto out;
+	}
+
+	printf("\nextbuf=%s, slave to master\n", extbuf);
+	printf("%6s %12s %14s %18s\n", "size", "Mpps", "cycles/pkt",
+		"rx cycles/pkt");
+	for (i = 0; i != RTE_DIM(pkt_sizes); i++)
+		if (memif_perf_run(slave, master, pkt_sizes[i]) != 0)
+			goto out;
+
+	printf("\nextbuf=%s, master to slave\n", extbuf);
+	printf("%6s %12s %14s %18s\n", "size", "Mpps", "cycles/pkt",
+		"rx cycles/pkt");
+	for (i = 0; i != RTE_DIM(pkt_sizes); i++)
+		if (memif_perf_run(master, slave, pkt_sizes[i]) != 0)
+			goto out;
+
+	ret = 0;
+out:
+	/* let the master handle the disconnect before it goes away too */
+	memif_perf_port_remove(MEMIF_PERF_SLAVE);
+	rte_delay_ms(100);
+	memif_perf_port_remove(MEMIF_PERF_MASTER);
+	return ret;
+}
+
+static int
+test_memif_perf(void)
+{
+	int ret = TEST_FAILED;
+
+	if (rte_eal_process_type() != RTE_PROC_PRIMARY) {
+		printf("Memif perf test needs the primary process, skipping\n");
+		return TEST_SKIPPED;
+	}
+
+	tx_pool = rte_pktmbuf_pool_create("memif_perf_tx", NB_TX_MBUFS,
+		MBUF_CACHE_SIZE, 0, TX_DATA_SIZE, rte_socket_id());
+	rx_pool = rte_pktmbuf_pool_create("memif_perf_rx", NB_RX_MBUFS,
+		MBUF_CACHE_SIZE, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+		rte_socket_id());
+	if (tx_pool == NULL || rx_pool == NULL) {
+		printf("Cannot create mbuf pools\n");
+		goto out;
+	}
+
+	if (memif_perf_mode("no") == 0 && memif_perf_mode("yes") == 0)
+		ret = TEST_SUCCESS;
+out:
+	rte_mempool_free(tx_pool);
+	rte_mempool_free(rx_pool);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(memif_perf_autotest, test_memif_perf);
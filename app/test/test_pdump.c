@@ -5,8 +5,11 @@
 #include <unistd.h>
 #include <stdint.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include <rte_ethdev_driver.h>
+#include <rte_bpf.h>
+#include <rte_malloc.h>
 #include <rte_pdump.h>
 #include "rte_eal.h"
 #include "rte_lcore.h"
@@ -20,6 +23,10 @@
 
 #define launch_p(ARGV) process_dup(ARGV, RTE_DIM(ARGV), __func__)
 
+/* length of the packets sent by the primary, half of them are captured */
+#define TEST_PKT_LEN 128
+#define TEST_SNAPLEN 64
+
 struct rte_ring *ring_server;
 uint16_t portid;
 uint16_t flag_for_send_pkts = 1;
@@ -43,6 +50,178 @@ test_pdump_init(void)
 	return ret;
 }
 
+/* eBPF program accepting all packets */
+static const struct ebpf_insn accept_all[] = {
+	{
+		.code = (BPF_ALU | EBPF_MOV | BPF_K),
+		.dst_reg = EBPF_REG_0,
+		.imm = 1,
+	},
+	{
+		.code = (BPF_JMP | EBPF_EXIT),
+	},
+};
+
+/* eBPF program accepting the packets with a non-zero first byte */
+static const struct ebpf_insn accept_odd[] = {
+	{
+		.code = (BPF_LDX | BPF_MEM | BPF_B),
+		.dst_reg = EBPF_REG_0,
+		.src_reg = EBPF_REG_1,
+		.off = 0,
+	},
+	{
+		.code = (BPF_JMP | EBPF_EXIT),
+	},
+};
+
+static void
+test_pdump_drain(struct rte_ring *ring)
+{
+	struct rte_mbuf *m;
+
+	while (rte_ring_dequeue(ring, (void **)&m) == 0)
+		rte_pktmbuf_free(m);
+}
+
+/*
+ * Capture the packets forwarded by the primary process, then check that
+ * only the packets matching the filter were captured, cut to snaplen.
+ */
+static int
+test_pdump_capture(struct rte_ring *ring, struct rte_mempool *mp,
+	struct rte_bpf_prm *prm, uint32_t flags, uint32_t snaplen)
+{
+	struct rte_mbuf *m;
+	unsigned int i, nb = 0;
+	int ret = 0;
+
+	test_pdump_drain(ring);
+	if (rte_pdump_enable_bpf(portid, QUEUE_ID, flags, snaplen, ring, mp,
+			prm) < 0) {
+		printf("rte_pdump_enable_bpf failed\n");
+		return -1;
+	}
+
+	for (i = 0; i < 500 && rte_ring_count(ring) < NUM_PACKETS; i++)
+		usleep(10000);
+
+	if (rte_pdump_disable(portid, QUEUE_ID, flags) < 0) {
+		printf("rte_pdump_disable failed\n");
+		ret = -1;
+	}
+
+	while (rte_ring_dequeue(ring, (void **)&m) == 0) {
+		nb++;
+		if (rte_pktmbuf_pkt_len(m) !=
+				(snaplen != 0 ? snaplen : TEST_PKT_LEN)) {
+			printf("captured %u bytes, snaplen %u\n",
+				rte_pktmbuf_pkt_len(m), snaplen);
+			ret = -1;
+		} else if (*rte_pktmbuf_mtod(m, uint8_t *) == 0) {
+			printf("captured a packet rejected by the filter\n");
+			ret = -1;
+		} else if (!RTE_MBUF_CLONED(m) !=
+				!(flags & RTE_PDUMP_FLAG_ZERO_COPY)) {
+			printf("captured packet is %s\n",
+				RTE_MBUF_CLONED(m) ? "not copied" :
+				"copied with zero-copy");
+			ret = -1;
+		}
+		rte_pktmbuf_free(m);
+	}
+
+	if (nb == 0) {
+		printf("no packet captured\n");
+		ret = -1;
+	}
+	return ret;
+}
+
+static int
+test_pdump_bpf(struct rte_ring *ring, struct rte_mempool *mp)
+{
+	char deviceid[] = "net_ring_net_ringa";
+	uint32_t flags = RTE_PDUMP_FLAG_RXTX | RTE_PDUMP_FLAG_ZERO_COPY;
+	struct rte_bpf_prm *prm;
+	struct ebpf_insn *ins;
+	int ret = -1;
+
+	/* the filter is loaded by the primary process */
+	prm = rte_zmalloc(NULL, sizeof(*prm), 0);
+	ins = rte_malloc(NULL, sizeof(accept_all), 0);
+	if (prm == NULL || ins == NULL) {
+		printf("failed to allocate filter\n");
+		goto out;
+	}
+	memcpy(ins, accept_all, sizeof(accept_all));
+	prm->ins = ins;
+	prm->nb_ins = RTE_DIM(accept_all);
+	prm->prog_arg.type = RTE_BPF_ARG_RAW;
+	prm->prog_arg.size = sizeof(uint64_t);
+
+	if (rte_pdump_enable_bpf(portid, QUEUE_ID, flags, 64, ring, mp,
+			prm) == 0 || rte_errno != EINVAL) {
+		printf("rte_pdump_enable_bpf accepted an invalid filter\n");
+		goto out;
+	}
+
+	prm->prog_arg.type = RTE_BPF_ARG_PTR_MBUF;
+	prm->prog_arg.size = sizeof(struct rte_mbuf);
+	prm->prog_arg.buf_size = RTE_MBUF_DEFAULT_BUF_SIZE;
+
+	if (rte_pdump_enable_bpf(portid, QUEUE_ID, flags, 64, ring, mp,
+			prm) < 0) {
+		printf("rte_pdump_enable_bpf failed\n");
+		goto out;
+	}
+	printf("pdump_enable_bpf success\n");
+
+	if (rte_pdump_disable(portid, QUEUE_ID, flags) < 0) {
+		printf("rte_pdump_disable failed\n");
+		goto out;
+	}
+
+	if (rte_pdump_enable_bpf_by_deviceid(deviceid, QUEUE_ID, flags, 0,
+			ring, mp, prm) < 0) {
+		printf("rte_pdump_enable_bpf_by_deviceid failed\n");
+		goto out;
+	}
+	printf("pdump_enable_bpf_by_deviceid success\n");
+
+	if (rte_pdump_disable_by_deviceid(deviceid, QUEUE_ID, flags) < 0) {
+		printf("rte_pdump_disable_by_deviceid failed\n");
+		goto out;
+	}
+
+	/* received packets captured without copy, transmitted ones copied */
+	rte_free(ins);
+	ins = rte_malloc(NULL, sizeof(accept_odd), 0);
+	if (ins == NULL)
+		goto out;
+	memcpy(ins, accept_odd, sizeof(accept_odd));
+	prm->ins = ins;
+	prm->nb_ins = RTE_DIM(accept_odd);
+	prm->prog_arg.type = RTE_BPF_ARG_PTR;
+	prm->prog_arg.size = TEST_PKT_LEN;
+	prm->prog_arg.buf_size = 0;
+
+	if (test_pdump_capture(ring, mp, prm,
+			RTE_PDUMP_FLAG_RX | RTE_PDUMP_FLAG_ZERO_COPY,
+			TEST_SNAPLEN) < 0 ||
+			test_pdump_capture(ring, mp, prm, RTE_PDUMP_FLAG_TX,
+			0) < 0)
+		goto out;
+	printf("pdump filter, snaplen and zero-copy success\n");
+
+	ret = 0;
+out:
+	test_pdump_drain(ring);
+	rte_free(ins);
+	rte_free(prm);
+	return ret;
+}
+
 int
 run_pdump_client_tests(void)
 {
@@ -111,6 +290,10 @@ run_pdump_client_tests(void)
 			printf("\n***** flags = RTE_PDUMP_FLAG_RXTX *****\n");
 		}
 	}
+
+	printf("\n***** filter, snaplen and zero-copy *****\n");
+	ret = test_pdump_bpf(ring_client, mp);
+
 	if (ring_client != NULL)
 		test_ring_free(ring_client);
 	if (mp != NULL)
@@ -144,9 +327,22 @@ send_pkts(void *empty)
 	struct rte_mempool *mp;
 	char poolname[] = "mbuf_pool_server";
 
+	uint8_t *data;
+	unsigned int i;
+
 	ret = test_get_mbuf_from_pool(&mp, pbuf, poolname);
-	if (ret < 0)
+	if (ret < 0) {
 		printf("get_mbuf_from_pool failed\n");
+		return empty;
+	}
+
+	/* every other packet has a non-zero first byte */
+	for (i = 0; i < NUM_PACKETS; i++) {
+		data = (uint8_t *)rte_pktmbuf_append(pbuf[i], TEST_PKT_LEN);
+		memset(data, 0, TEST_PKT_LEN);
+		data[0] = i & 1;
+	}
+
 	do {
 		ret = test_packet_forward(pbuf, portid, QUEUE_ID);
 		if (ret < 0)
@@ -166,6 +362,7 @@ run_pdump_server_tests(void)
 {
 	int ret = 0;
 	char coremask[10];
+	pthread_t thread;
 
 #ifdef RTE_EXEC_ENV_LINUX
 	char tmp[PATH_MAX] = { 0 };
@@ -187,7 +384,20 @@ run_pdump_server_tests(void)
 		 (1 << rte_get_master_lcore()));
 
 	ret = test_pdump_init();
-	ret |= launch_p(argv1);
+	if (ret < 0)
+		return ret;
+
+	/* the callbacks run in this process, feed them while capturing */
+	flag_for_send_pkts = 1;
+	if (pthread_create(&thread, NULL, send_pkts, NULL) != 0) {
+		printf("failed to create the sending thread\n");
+		test_pdump_uninit();
+		return -1;
+	}
+
+	ret = launch_p(argv1);
+	flag_for_send_pkts = 0;
+	pthread_join(thread, NULL);
 	ret |= test_pdump_uninit();
 	return ret;
 }
@@ -0,0 +1,202 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_ethdev.h>
+#include <rte_bus_vdev.h>
+#include <rte_mbuf.h>
+#include <rte_string_fns.h>
+
+#define SOCKET0 0
+#define RING_SIZE 256
+#define NB_MBUF 512
+#define NB_PKTS 8
+#define PKT_LEN_MIN 64
+#define PCAP_FILE_TEMPLATE "/tmp/test_pmd_pcap_XXXXXX"
+
+/* Capture file headers, see pcap-savefile(5) */
+struct test_pcap_file_hdr {
+	uint32_t magic;
+	uint16_t version_major;
+	uint16_t version_minor;
+	int32_t thiszone;
+	uint32_t sigfigs;
+	uint32_t snaplen;
+	uint32_t linktype;
+};
+
+struct test_pcap_pkt_hdr {
+	uint32_t ts_sec;
+	uint32_t ts_usec;
+	uint32_t caplen;
+	uint32_t len;
+};
+
+static struct rte_mempool *mp;
+static char pcap_file[sizeof(PCAP_FILE_TEMPLATE)];
+
+/* Write NB_PKTS packets, each one of different length and content. */
+static int
+test_pcap_write_file(void)
+{
+	struct test_pcap_file_hdr fh = {
+		.magic = 0xa1b2c3d4,
+		.version_major = 2,
+		.version_minor = 4,
+		.snaplen = UINT16_MAX,
+		.linktype = 1, /* Ethernet */
+	};
+	struct test_pcap_pkt_hdr ph;
+	uint8_t data[PKT_LEN_MIN + NB_PKTS];
+	FILE *f;
+	int fd;
+	uint32_t i;
+
+	strlcpy(pcap_file, PCAP_FILE_TEMPLATE, sizeof(pcap_file));
+	fd = mkstemp(pcap_file);
+	if (fd < 0)
+		return -1;
+
+	f = fdopen(fd, "w");
+	if (f == NULL) {
+		close(fd);
+		return -1;
+	}
+
+	fwrite(&fh, sizeof(fh), 1, f);
+	for (i = 0; i != NB_PKTS; i++) {
+		ph.ts_sec = 0;
+		ph.ts_usec = i;
+		ph.caplen = PKT_LEN_MIN + i;
+		ph.len = ph.caplen;
+		memset(data, i, ph.caplen);
+		fwrite(&ph, sizeof(ph), 1, f);
+		fwrite(data, ph.caplen, 1, f);
+	}
+
+	return fclose(f) == 0 ? 0 : -1;
+}
+
+static int
+test_pcap_configure_port(uint16_t port)
+{
+	struct rte_eth_conf null_conf;
+
+	memset(&null_conf, 0, sizeof(struct rte_eth_conf));
+
+	if (rte_eth_dev_configure(port, 1, 1, &null_conf) < 0) {
+		printf("Configure failed for port %u\n", port);
+		return -1;
+	}
+
+	if (rte_eth_tx_queue_setup(port, 0, RING_SIZE, SOCKET0, NULL) < 0) {
+		printf("TX queue setup failed port %u\n", port);
+		return -1;
+	}
+
+	if (rte_eth_rx_queue_setup(port, 0, RING_SIZE, SOCKET0,
+				NULL, mp) < 0) {
+		printf("RX queue setup failed port %u\n", port);
+		return -1;
+	}
+
+	if (rte_eth_dev_start(port) < 0) {
+		printf("Error starting port %u\n", port);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Check that n packets are received from the file, looping over it. */
+static int
+test_pcap_rx_mmap(const char *name, const char *args, uint32_t n)
+{
+	struct rte_mbuf *bufs[2 * NB_PKTS];
+	uint32_t i, j, len;
+	uint16_t port, nb_rx;
+	uint8_t *p;
+	int ret = -1;
+
+	if (rte_vdev_init(name, args) < 0) {
+		printf("Failed to create %s with %s\n", name, args);
+		return -1;
+	}
+
+	if (rte_eth_dev_get_port_by_name(name, &port) != 0 ||
+			test_pcap_configure_port(port) < 0)
+		goto out;
+
+	nb_rx = rte_eth_rx_burst(port, 0, bufs, RTE_DIM(bufs));
+	if (nb_rx != n) {
+		printf("%s: received %u packets, expected %u\n",
+			name, nb_rx, n);
+		rte_pktmbuf_free_bulk(bufs, nb_rx);
+		goto out;
+	}
+
+	ret = 0;
+	for (i = 0; i != nb_rx; i++) {
+		len = PKT_LEN_MIN + i % NB_PKTS;
+		p = rte_pktmbuf_mtod(bufs[i], uint8_t *);
+		if (!RTE_MBUF_HAS_EXTBUF(bufs[i]) ||
+				rte_pktmbuf_pkt_len(bufs[i]) != len) {
+			printf("%s: packet %u is not attached to the file\n",
+				name, i);
+			ret = -1;
+			continue;
+		}
+		for (j = 0; j != len && p[j] == i % NB_PKTS; j++)
+			;
+		if (j != len) {
+			printf("%s: invalid data in packet %u\n", name, i);
+			ret = -1;
+		}
+	}
+
+	/* the file is kept mapped while the mbufs refer to it */
+	rte_eth_dev_stop(port);
+	rte_vdev_uninit(name);
+	rte_pktmbuf_free_bulk(bufs, nb_rx);
+	return ret;
+
+out:
+	rte_vdev_uninit(name);
+	return ret;
+}
+
+static int
+test_pmd_pcap(void)
+{
+	char args[64 + sizeof(pcap_file)];
+	int ret;
+
+	mp = rte_pktmbuf_pool_create("mbuf_pool_pcap", NB_MBUF, 32,
+		0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+	if (mp == NULL)
+		return -1;
+
+	if (test_pcap_write_file() < 0) {
+		printf("Failed to write %s\n", pcap_file);
+		rte_mempool_free(mp);
+		return -1;
+	}
+
+	snprintf(args, sizeof(args), "rx_pcap=%s,mmap_rx=1", pcap_file);
+	ret = test_pcap_rx_mmap("net_pcap_mmap0", args, NB_PKTS);
+
+	snprintf(args, sizeof(args), "rx_pcap=%s,mmap_rx=1,infinite_rx=1",
+		pcap_file);
+	ret |= test_pcap_rx_mmap("net_pcap_mmap1", args, 2 * NB_PKTS);
+
+	unlink(pcap_file);
+	rte_mempool_free(mp);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(pcap_pmd_autotest, test_pmd_pcap);
@@ -0,0 +1,249 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_ethdev.h>
+#include <rte_bus_vdev.h>
+#include <rte_cycles.h>
+#include <rte_mbuf.h>
+#include <rte_string_fns.h>
+
+#define SOCKET0 0
+#define RING_SIZE 16
+#define NB_MBUF 512
+#define NB_PKTS 64
+#define FRAME_LEN 128
+#define MAX_POLLS 100000
+#define URING_VDEV "net_uring_test0"
+#define URING_FILE_TEMPLATE "/tmp/test_pmd_uring_XXXXXX"
+
+static struct rte_mempool *mp;
+static char rx_file[sizeof(URING_FILE_TEMPLATE)];
+static char tx_file[sizeof(URING_FILE_TEMPLATE)];
+
+/* Write NB_PKTS frames of FRAME_LEN bytes, frame i filled with byte i. */
+static int
+test_uring_write_file(void)
+{
+	uint8_t data[FRAME_LEN];
+	FILE *f;
+	int fd;
+	uint32_t i;
+
+	strlcpy(rx_file, URING_FILE_TEMPLATE, sizeof(rx_file));
+	fd = mkstemp(rx_file);
+	if (fd < 0)
+		return -1;
+
+	f = fdopen(fd, "w");
+	if (f == NULL) {
+		close(fd);
+		return -1;
+	}
+
+	for (i = 0; i != NB_PKTS; i++) {
+		memset(data, i, sizeof(data));
+		fwrite(data, sizeof(data), 1, f);
+	}
+
+	return fclose(f) == 0 ? 0 : -1;
+}
+
+/* Check that the TX file holds the first n frames, in order. */
+static int
+test_uring_check_file(uint32_t n)
+{
+	uint8_t data[FRAME_LEN];
+	FILE *f;
+	uint32_t i, j;
+	int ret = 0;
+
+	f = fopen(tx_file, "r");
+	if (f == NULL)
+		return -1;
+
+	for (i = 0; i != n && ret == 0; i++) {
+		if (fread(data, sizeof(data), 1, f) != 1) {
+			printf("%s: frame %u is missing\n", tx_file, i);
+			ret = -1;
+			break;
+		}
+		for (j = 0; j != FRAME_LEN && data[j] == i; j++)
+			;
+		if (j != FRAME_LEN) {
+			printf("%s: invalid data in frame %u\n", tx_file, i);
+			ret = -1;
+		}
+	}
+
+	if (ret == 0 && fread(data, 1, 1, f) != 0) {
+		printf("%s: more than %u frames\n", tx_file, n);
+		ret = -1;
+	}
+
+	fclose(f);
+	return ret;
+}
+
+static int
+test_uring_configure_port(uint16_t port)
+{
+	struct rte_eth_conf null_conf;
+
+	memset(&null_conf, 0, sizeof(struct rte_eth_conf));
+
+	if (rte_eth_dev_configure(port, 1, 1, &null_conf) < 0) {
+		printf("Configure failed for port %u\n", port);
+		return -1;
+	}
+
+	if (rte_eth_tx_queue_setup(port, 0, RING_SIZE, SOCKET0, NULL) < 0) {
+		printf("TX queue setup failed port %u\n", port);
+		return -1;
+	}
+
+	if (rte_eth_rx_queue_setup(port, 0, RING_SIZE, SOCKET0,
+				NULL, mp) < 0) {
+		printf("RX queue setup failed port %u\n", port);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Receive frames first to last from the file, check them and send them
+ * back; the reads and writes complete asynchronously, so poll for them.
+ */
+static int
+test_uring_loop(uint16_t port, uint32_t first, uint32_t last)
+{
+	struct rte_mbuf *bufs[RING_SIZE];
+	uint32_t i, j, n, polls;
+	uint16_t nb_rx, nb_tx;
+	uint8_t *p;
+
+	for (n = first, polls = 0; n != last && polls != MAX_POLLS; polls++) {
+		nb_rx = rte_eth_rx_burst(port, 0, bufs,
+			RTE_MIN(RTE_DIM(bufs), last - n));
+
+		for (i = 0; i != nb_rx; i++) {
+			p = rte_pktmbuf_mtod(bufs[i], uint8_t *);
+			for (j = 0; j != FRAME_LEN && p[j] == n + i; j++)
+				;
+			if (rte_pktmbuf_pkt_len(bufs[i]) != FRAME_LEN ||
+					j != FRAME_LEN) {
+				printf("Invalid frame %u received\n", n + i);
+				rte_pktmbuf_free_bulk(bufs, nb_rx);
+				return -1;
+			}
+		}
+
+		for (nb_tx = 0; nb_tx != nb_rx && polls != MAX_POLLS; polls++)
+			nb_tx += rte_eth_tx_burst(port, 0, bufs + nb_tx,
+				nb_rx - nb_tx);
+		if (nb_tx != nb_rx) {
+			rte_pktmbuf_free_bulk(bufs + nb_tx, nb_rx - nb_tx);
+			break;
+		}
+
+		n += nb_rx;
+		if (nb_rx == 0)
+			rte_delay_us(10);
+	}
+
+	if (n != last) {
+		printf("Looped frames %u to %u, stopped at %u\n",
+			first, last, n);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+test_pmd_uring(void)
+{
+	char args[64 + sizeof(rx_file) + sizeof(tx_file)];
+	struct rte_mbuf *buf;
+	uint16_t port;
+	uint32_t polls;
+	int fd, ret = -1;
+
+	mp = rte_pktmbuf_pool_create("mbuf_pool_uring", NB_MBUF, 32,
+		0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+	if (mp == NULL)
+		return -1;
+
+	if (test_uring_write_file() < 0) {
+		printf("Failed to write %s\n", rx_file);
+		rte_mempool_free(mp);
+		return -1;
+	}
+
+	strlcpy(tx_file, URING_FILE_TEMPLATE, sizeof(tx_file));
+	fd = mkstemp(tx_file);
+	if (fd < 0) {
+		unlink(rx_file);
+		rte_mempool_free(mp);
+		return -1;
+	}
+	close(fd);
+
+	snprintf(args, sizeof(args), "rx_file=%s,tx_file=%s,framesz=%u",
+		rx_file, tx_file, FRAME_LEN);
+	if (rte_vdev_init(URING_VDEV, args) < 0) {
+		printf("io_uring is not available, skipping\n");
+		ret = TEST_SKIPPED;
+		goto out;
+	}
+
+	if (rte_eth_dev_get_port_by_name(URING_VDEV, &port) != 0 ||
+			test_uring_configure_port(port) < 0)
+		goto uninit;
+
+	/* first half, then check the writes are flushed on stop */
+	if (rte_eth_dev_start(port) < 0 ||
+			test_uring_loop(port, 0, NB_PKTS / 2) < 0)
+		goto stop;
+	rte_eth_dev_stop(port);
+	if (test_uring_check_file(NB_PKTS / 2) < 0)
+		goto uninit;
+
+	/* the reads pending on stop are not lost on restart */
+	if (rte_eth_dev_start(port) < 0 ||
+			test_uring_loop(port, NB_PKTS / 2, NB_PKTS) < 0)
+		goto stop;
+
+	/* nothing more at the end of the file */
+	for (polls = 0; polls != RING_SIZE; polls++) {
+		if (rte_eth_rx_burst(port, 0, &buf, 1) != 0) {
+			printf("Frame received past the end of %s\n",
+				rx_file);
+			rte_pktmbuf_free(buf);
+			goto stop;
+		}
+		rte_delay_us(10);
+	}
+	rte_eth_dev_stop(port);
+
+	ret = test_uring_check_file(NB_PKTS);
+	goto uninit;
+
+stop:
+	rte_eth_dev_stop(port);
+uninit:
+	rte_vdev_uninit(URING_VDEV);
+out:
+	unlink(rx_file);
+	unlink(tx_file);
+	rte_mempool_free(mp);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(uring_pmd_autotest, test_pmd_uring);
@@ -0,0 +1,228 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include <rte_common.h>
+#include <rte_eal.h>
+#include <rte_telemetry.h>
+
+#include "test.h"
+
+#define TEST_STR_LEN (RTE_TEL_MAX_STRING_LEN - 1)
+#define TEST_BUF_LEN (1024 * 64)
+
+static uint8_t rx_buf[TEST_BUF_LEN];
+
+/* array of strings, its JSON form doesn't fit in 16K */
+static int
+handle_big(const char *cmd __rte_unused, const char *params __rte_unused,
+		struct rte_tel_data *d)
+{
+	char str[TEST_STR_LEN + 1];
+	unsigned int i;
+
+	memset(str, 'a', TEST_STR_LEN);
+	str[TEST_STR_LEN] = 0;
+
+	rte_tel_data_start_array(d, RTE_TEL_STRING_VAL);
+	for (i = 0; i != RTE_TEL_MAX_ARRAY_ENTRIES; i++)
+		rte_tel_data_add_array_string(d, str);
+	return 0;
+}
+
+static int
+handle_dict(const char *cmd __rte_unused, const char *params __rte_unused,
+		struct rte_tel_data *d)
+{
+	rte_tel_data_start_dict(d);
+	rte_tel_data_add_dict_int(d, "neg", -5);
+	rte_tel_data_add_dict_u64(d, "u64", UINT64_C(1) << 40);
+	return 0;
+}
+
+static int
+telemetry_connect(void)
+{
+	struct sockaddr_un sun = {.sun_family = AF_UNIX};
+	struct timeval tv = {.tv_sec = 2};
+	int s;
+
+	snprintf(sun.sun_path, sizeof(sun.sun_path),
+		"%s/dpdk_telemetry.v2", rte_eal_get_runtime_dir());
+
+	s = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (s < 0)
+		return -1;
+	if (connect(s, (struct sockaddr *)&sun, sizeof(sun)) < 0 ||
+			setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv,
+			sizeof(tv)) < 0) {
+		close(s);
+		return -1;
+	}
+	return s;
+}
+
+static ssize_t
+telemetry_request(int s, const char *req)
+{
+	if (write(s, req, strlen(req)) < 0)
+		return -1;
+	return recv(s, rx_buf, sizeof(rx_buf), 0);
+}
+
+/* check reply is the same as expected, binary safe */
+static int
+check_reply(const char *req, ssize_t len, const void *expected, size_t sz)
+{
+	if (len != (ssize_t)sz || memcmp(rx_buf, expected, sz) != 0) {
+		printf("%s: unexpected reply of %zd bytes\n", req, len);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_json_reply(int s)
+{
+	static const char req[] = "/test_telemetry/big";
+	ssize_t len;
+	size_t exp;
+
+	len = telemetry_request(s, req);
+
+	/* {"<cmd>":["aaa...","aaa...",...]} */
+	exp = strlen(req) + 6 + RTE_TEL_MAX_ARRAY_ENTRIES * (TEST_STR_LEN + 3);
+	if (len != (ssize_t)exp || rx_buf[len - 3] != '"' ||
+			memcmp(rx_buf + len - 2, "]}", 2) != 0) {
+		printf("%s: invalid reply of %zd bytes, expected %zu\n",
+			req, len, exp);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_cbor_reply(int s)
+{
+	static const uint8_t format_rep[] = {
+		0xa1, 0x67, '/', 'f', 'o', 'r', 'm', 'a', 't',
+		0x64, 'c', 'b', 'o', 'r',
+	};
+	static const uint8_t big_hdr[] = {
+		0xa1, 0x73, '/', 't', 'e', 's', 't', '_', 't', 'e', 'l', 'e',
+		'm', 'e', 't', 'r', 'y', '/', 'b', 'i', 'g',
+		0x99, 0x02, 0x00, /* array of 512 */
+		0x78, TEST_STR_LEN, /* string of 63 */
+	};
+	static const uint8_t dict_rep[] = {
+		0xa1, 0x74, '/', 't', 'e', 's', 't', '_', 't', 'e', 'l', 'e',
+		'm', 'e', 't', 'r', 'y', '/', 'd', 'i', 'c', 't',
+		0xa2,
+		0x63, 'n', 'e', 'g', 0x24,
+		0x63, 'u', '6', '4', 0x1b, 0, 0, 1, 0, 0, 0, 0, 0,
+	};
+	ssize_t len;
+
+	len = telemetry_request(s, "/format,cbor");
+	if (check_reply("/format", len, format_rep, sizeof(format_rep)) != 0)
+		return -1;
+
+	len = telemetry_request(s, "/test_telemetry/big");
+	if (len != (ssize_t)(sizeof(big_hdr) + TEST_STR_LEN +
+			(RTE_TEL_MAX_ARRAY_ENTRIES - 1) * (TEST_STR_LEN + 2)) ||
+			memcmp(rx_buf, big_hdr, sizeof(big_hdr)) != 0) {
+		printf("/test_telemetry/big: invalid CBOR reply of %zd bytes\n",
+			len);
+		return -1;
+	}
+
+	len = telemetry_request(s, "/test_telemetry/dict");
+	return check_reply("/test_telemetry/dict", len, dict_rep,
+		sizeof(dict_rep));
+}
+
+static int
+test_subscribe(int s)
+{
+	static const char unsub_rep[] =
+		"{\"/unsubscribe\":{\"subscriptions\":0}}";
+	static const char push_rep[] =
+		"{\"/test_telemetry/dict\":{\"neg\":-5,\"u64\":1099511627776}}";
+	unsigned int i;
+	ssize_t len;
+
+	if (telemetry_request(s, "/format,json") <= 0)
+		return -1;
+
+	/* command replies are not pushed */
+	len = telemetry_request(s, "/subscribe,10,/format");
+	if (check_reply("/subscribe", len, "{\"/subscribe\":null}", 19) != 0)
+		return -1;
+
+	len = telemetry_request(s, "/subscribe,10,/test_telemetry/dict");
+	if (len <= 0 || strstr((char *)rx_buf, "\"subscriptions\":1") == NULL) {
+		printf("/subscribe: subscription failed\n");
+		return -1;
+	}
+
+	for (i = 0; i != 3; i++) {
+		len = recv(s, rx_buf, sizeof(rx_buf), 0);
+		if (check_reply("push", len, push_rep,
+				sizeof(push_rep) - 1) != 0)
+			return -1;
+	}
+
+	/* pushes may still come before the reply */
+	if (write(s, "/unsubscribe", strlen("/unsubscribe")) < 0)
+		return -1;
+	do {
+		len = recv(s, rx_buf, sizeof(rx_buf), 0);
+	} while (len == sizeof(push_rep) - 1 &&
+			memcmp(rx_buf, push_rep, len) == 0);
+
+	return check_reply("/unsubscribe", len, unsub_rep,
+		sizeof(unsub_rep) - 1);
+}
+
+static int
+test_telemetry(void)
+{
+	ssize_t len;
+	int ret, s;
+
+	rte_telemetry_register_cmd("/test_telemetry/big", handle_big,
+		"Returns array of long strings");
+	rte_telemetry_register_cmd("/test_telemetry/dict", handle_dict,
+		"Returns dict of numbers");
+
+	s = telemetry_connect();
+	if (s < 0) {
+		printf("Telemetry socket not available, skipping\n");
+		return TEST_SKIPPED;
+	}
+
+	/* info message sent on connection */
+	len = recv(s, rx_buf, sizeof(rx_buf), 0);
+	if (len <= 0) {
+		close(s);
+		return TEST_FAILED;
+	}
+
+	ret = test_json_reply(s);
+	if (ret == 0)
+		ret = test_cbor_reply(s);
+	if (ret == 0)
+		ret = test_subscribe(s);
+
+	close(s);
+	return ret == 0 ? TEST_SUCCESS : TEST_FAILED;
+}
+
+REGISTER_TEST_COMMAND(telemetry_autotest, test_telemetry);
@@ -27,6 +27,17 @@ timer_cb(struct rte_timer *t __rte_unused, void *param __rte_unused)
 
 #define DELAY_SECONDS 1
 
+/* number of pending timers used to compare timer data backends */
+#define NB_PENDING_TIMERS (1 << 21)
+
+static unsigned int alt_outstanding_count;
+
+static void
+alt_timer_cb(struct rte_timer *t __rte_unused)
+{
+	alt_outstanding_count--;
+}
+
 #ifdef RTE_EXEC_ENV_LINUX
 #define do_delay() usleep(10)
 #else
@@ -131,4 +142,153 @@ test_timer_perf(void)
 	return 0;
 }
 
-REGISTER_TEST_COMMAND(timer_perf_autotest, test_timer_perf);
+static void
+print_per_timer(const char *what, uint64_t cycles, unsigned int nb)
+{
+	printf("  %-40s %"PRIu64" cycles/timer\n", what,
+			(cycles + nb / 2) / nb);
+}
+
+/*
+ * Measure arm, re-arm, stop and expiry costs with NB_PENDING_TIMERS pending
+ * timers in the given timer data instance.
+ */
+static int
+test_timer_perf_pending(uint32_t timer_data_id, const char *name,
+		struct rte_timer *tms, const uint64_t *delays)
+{
+	const uint64_t ticks = rte_get_timer_hz() * DELAY_SECONDS;
+	unsigned int lcore_id = rte_lcore_id();
+	uint64_t start_tsc, end_tsc, delay_start;
+	unsigned int i;
+
+	printf("%s, %u pending timers:\n", name, NB_PENDING_TIMERS);
+
+	for (i = 0; i < NB_PENDING_TIMERS; i++)
+		rte_timer_init(&tms[i]);
+
+	/* arm timers expiring in one to two delays */
+	start_tsc = rte_rdtsc();
+	for (i = 0; i < NB_PENDING_TIMERS; i++)
+		rte_timer_alt_reset(timer_data_id, &tms[i], ticks + delays[i],
+				SINGLE, lcore_id, NULL, NULL);
+	end_tsc = rte_rdtsc();
+	print_per_timer("arm:", end_tsc - start_tsc, NB_PENDING_TIMERS);
+
+	/* re-arm pending timers, with reversed delays */
+	start_tsc = rte_rdtsc();
+	for (i = 0; i < NB_PENDING_TIMERS; i++)
+		rte_timer_alt_reset(timer_data_id, &tms[i],
+				ticks + delays[NB_PENDING_TIMERS - 1 - i],
+				SINGLE, lcore_id, NULL, NULL);
+	end_tsc = rte_rdtsc();
+	print_per_timer("re-arm:", end_tsc - start_tsc, NB_PENDING_TIMERS);
+
+	/* poll while nothing is expired */
+	start_tsc = rte_rdtsc();
+	for (i = 0; i < MAX_ITERATIONS; i++)
+		rte_timer_alt_manage(timer_data_id, NULL, 0, alt_timer_cb);
+	end_tsc = rte_rdtsc();
+	printf("  %-40s %"PRIu64" cycles/call\n", "manage, zero callbacks:",
+			(end_tsc - start_tsc + MAX_ITERATIONS / 2) /
+			MAX_ITERATIONS);
+
+	/* stop pending timers in random order */
+	start_tsc = rte_rdtsc();
+	for (i = 0; i < NB_PENDING_TIMERS; i++)
+		rte_timer_alt_stop(timer_data_id,
+				&tms[delays[i] % NB_PENDING_TIMERS]);
+	end_tsc = rte_rdtsc();
+	/* timers picked twice above were stopped only once, finish the job */
+	rte_timer_stop_all(timer_data_id, &lcore_id, 1, NULL, NULL);
+	print_per_timer("stop:", end_tsc - start_tsc, NB_PENDING_TIMERS);
+
+	for (i = 0; i < NB_PENDING_TIMERS; i++) {
+		if (rte_timer_pending(&tms[i])) {
+			printf("Error: timer %u still pending\n", i);
+			return -1;
+		}
+	}
+
+	/* arm timers expiring within one delay and let all of them expire */
+	for (i = 0; i < NB_PENDING_TIMERS; i++)
+		rte_timer_alt_reset(timer_data_id, &tms[i], delays[i],
+				SINGLE, lcore_id, NULL, NULL);
+	alt_outstanding_count = NB_PENDING_TIMERS;
+
+	delay_start = rte_get_timer_cycles();
+	while (rte_get_timer_cycles() < delay_start + ticks)
+		do_delay();
+
+	start_tsc = rte_rdtsc();
+	rte_timer_alt_manage(timer_data_id, NULL, 0, alt_timer_cb);
+	end_tsc = rte_rdtsc();
+	print_per_timer("expire:", end_tsc - start_tsc, NB_PENDING_TIMERS);
+
+	if (alt_outstanding_count != 0) {
+		printf("Error: outstanding callback count = %u\n",
+				alt_outstanding_count);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* compare the skiplist and timing wheel timer data backends */
+static int
+test_timer_perf_backends(void)
+{
+	const uint64_t ticks = rte_get_timer_hz() * DELAY_SECONDS;
+	struct rte_timer *tms;
+	uint64_t *delays;
+	uint32_t timer_data_id;
+	unsigned int i;
+	int ret;
+
+	tms = rte_malloc(NULL, sizeof(*tms) * NB_PENDING_TIMERS, 0);
+	delays = rte_malloc(NULL, sizeof(*delays) * NB_PENDING_TIMERS, 0);
+	if (tms == NULL || delays == NULL) {
+		printf("Cannot allocate timers\n");
+		ret = -1;
+		goto out;
+	}
+
+	/* precompute delays so that rte_rand() is out of the measurements */
+	for (i = 0; i < NB_PENDING_TIMERS; i++)
+		delays[i] = rte_rand() % ticks;
+
+	ret = rte_timer_data_alloc(&timer_data_id);
+	if (ret < 0) {
+		printf("Cannot allocate skiplist timer data\n");
+		goto out;
+	}
+	ret = test_timer_perf_pending(timer_data_id, "Skiplist", tms, delays);
+	rte_timer_data_dealloc(timer_data_id);
+	if (ret < 0)
+		goto out;
+
+	ret = rte_timer_data_alloc_wheel(&timer_data_id, 0);
+	if (ret < 0) {
+		printf("Cannot allocate timing wheel timer data\n");
+		goto out;
+	}
+	ret = test_timer_perf_pending(timer_data_id, "Timing wheel", tms,
+			delays);
+	rte_timer_data_dealloc(timer_data_id);
+
+out:
+	rte_free(delays);
+	rte_free(tms);
+	return ret;
+}
+
+static int
+test_timer_perf_all(void)
+{
+	if (test_timer_perf() < 0)
+		return -1;
+
+	return test_timer_perf_backends();
+}
+
+REGISTER_TEST_COMMAND(timer_perf_autotest, test_timer_perf_all);
@@ -0,0 +1,446 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_bus_vdev.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_ethdev.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_vhost.h>
+#include <rte_vhost_async.h>
+
+#include "../../examples/vhost/main.h"
+#include "../../examples/vhost/cpu_copy.h"
+
+/*
+ * A virtio-user port of this process is the guest of a vhost-user socket
+ * whose queues are copied by the CPU copy engine of the vhost example.
+ * The engine is made to refuse part of the bursts, so that vhost has to
+ * roll back the rings to the first refused packet.
+ */
+
+#define SOCKET0 0
+#define RING_SIZE 256
+#define NB_MBUF 8192
+#define NB_ROUNDS 64
+#define MAX_BURST 32
+#define MAX_PKT_LEN 4000
+#define ASYNC_THRESHOLD 256
+#define TIMEOUT_S 5
+#define VDEV_NAME "net_virtio_user_async0"
+#define SOCK_TEMPLATE "/tmp/test_vhost_async_%d.sock"
+
+static const uint32_t pkt_lens[] = {60, 300, 1500, MAX_PKT_LEN};
+
+static struct rte_mempool *mp;
+static char sock_path[64];
+static volatile int ready_vid = -1;
+/* transfer_data() calls and descriptors refused, per queue */
+static uint32_t nr_calls[VIRTIO_QNUM];
+static uint32_t nr_refused[VIRTIO_QNUM];
+
+/* Accept all, none, one or half of the descriptors, in turn. */
+static uint32_t
+test_async_transfer_data(int vid, uint16_t queue_id,
+		struct rte_vhost_async_desc *descs,
+		struct rte_vhost_async_status *opaque_data, uint16_t count)
+{
+	uint16_t n;
+
+	switch (nr_calls[queue_id]++ % 4) {
+	case 0:
+		n = count;
+		break;
+	case 1:
+		n = 0;
+		break;
+	case 2:
+		n = RTE_MIN(count, 1);
+		break;
+	default:
+		n = count / 2;
+		break;
+	}
+
+	n = cpu_copy_transfer_data_cb(vid, queue_id, descs, opaque_data, n);
+	nr_refused[queue_id] += count - n;
+
+	return n;
+}
+
+static int
+test_async_new_device(int vid)
+{
+	struct rte_vhost_async_channel_ops channel_ops = {
+		.transfer_data = test_async_transfer_data,
+		.check_completed_copies = cpu_copy_check_completed_copies_cb,
+	};
+	struct rte_vhost_async_features f;
+	uint16_t queue_id;
+
+	f.intval = 0;
+	f.async_inorder = 1;
+	f.async_threshold = ASYNC_THRESHOLD;
+
+	for (queue_id = VIRTIO_RXQ; queue_id < VIRTIO_QNUM; queue_id++) {
+		if (cpu_copy_attach(vid, queue_id) != 0)
+			goto err;
+		if (rte_vhost_async_channel_register(vid, queue_id,
+				f.intval, &channel_ops) != 0) {
+			cpu_copy_detach(vid, queue_id);
+			goto err;
+		}
+	}
+
+	ready_vid = vid;
+	return 0;
+
+err:
+	while (queue_id-- > VIRTIO_RXQ) {
+		rte_vhost_async_channel_unregister(vid, queue_id);
+		cpu_copy_detach(vid, queue_id);
+	}
+	return -1;
+}
+
+static void
+test_async_destroy_device(int vid)
+{
+	uint16_t queue_id;
+
+	for (queue_id = VIRTIO_RXQ; queue_id < VIRTIO_QNUM; queue_id++) {
+		rte_vhost_async_channel_unregister(vid, queue_id);
+		cpu_copy_detach(vid, queue_id);
+	}
+	ready_vid = -1;
+}
+
+static const struct vhost_device_ops test_async_device_ops = {
+	.new_device = test_async_new_device,
+	.destroy_device = test_async_destroy_device,
+};
+
+/* Build a packet of len bytes, chaining mbufs as needed. */
+static struct rte_mbuf *
+test_async_pkt_alloc(uint32_t len, uint32_t seed)
+{
+	struct rte_mbuf *head = NULL, *m;
+	uint32_t i, j, n;
+	uint8_t *p;
+
+	for (i = 0; i != len; i += n) {
+		m = rte_pktmbuf_alloc(mp);
+		if (m == NULL)
+			goto err;
+		n = RTE_MIN(len - i, (uint32_t)rte_pktmbuf_tailroom(m));
+		p = (uint8_t *)rte_pktmbuf_append(m, n);
+		for (j = 0; j != n; j++)
+			p[j] = seed + i + j;
+		if (head == NULL)
+			head = m;
+		else if (rte_pktmbuf_chain(head, m) != 0) {
+			rte_pktmbuf_free(m);
+			goto err;
+		}
+	}
+
+	return head;
+
+err:
+	rte_pktmbuf_free(head);
+	return NULL;
+}
+
+static int
+test_async_pkt_check(const struct rte_mbuf *m, uint32_t len, uint32_t seed)
+{
+	uint8_t buf[MAX_PKT_LEN];
+	const uint8_t *p;
+	uint32_t i;
+
+	if (rte_pktmbuf_pkt_len(m) != len) {
+		printf("Packet %u of length %u, expected %u\n",
+			seed, rte_pktmbuf_pkt_len(m), len);
+		return -1;
+	}
+
+	p = rte_pktmbuf_read(m, 0, len, buf);
+	for (i = 0; i != len && p[i] == (uint8_t)(seed + i); i++)
+		;
+	if (i != len) {
+		printf("Invalid data in packet %u at offset %u\n", seed, i);
+		return -1;
+	}
+
+	return 0;
+}
+
+static uint32_t
+test_async_pkt_len(uint32_t seq)
+{
+	return pkt_lens[seq % RTE_DIM(pkt_lens)];
+}
+
+/* Send nb packets from the host, the refused ones are submitted again. */
+static int
+test_async_enqueue(int vid, uint16_t port, uint32_t seq, uint16_t nb)
+{
+	struct rte_mbuf *pkts[MAX_BURST], *done[MAX_BURST];
+	uint64_t deadline = rte_get_timer_cycles() +
+		TIMEOUT_S * rte_get_timer_hz();
+	uint16_t i, n, sent = 0, completed = 0, received = 0;
+	int ret = 0;
+
+	for (i = 0; i != nb; i++) {
+		pkts[i] = test_async_pkt_alloc(test_async_pkt_len(seq + i),
+			seq + i);
+		if (pkts[i] == NULL) {
+			rte_pktmbuf_free_bulk(pkts, i);
+			return -1;
+		}
+	}
+
+	while (received != nb && rte_get_timer_cycles() < deadline) {
+		sent += rte_vhost_submit_enqueue_burst(vid, VIRTIO_RXQ,
+			pkts + sent, nb - sent);
+
+		n = rte_vhost_poll_enqueue_completed(vid, VIRTIO_RXQ, done,
+			RTE_DIM(done));
+		rte_pktmbuf_free_bulk(done, n);
+		completed += n;
+
+		n = rte_eth_rx_burst(port, 0, done, RTE_DIM(done));
+		for (i = 0; i != n; i++) {
+			if (received + i >= completed ||
+					test_async_pkt_check(done[i],
+					test_async_pkt_len(seq + received + i),
+					seq + received + i) != 0)
+				ret = -1;
+		}
+		rte_pktmbuf_free_bulk(done, n);
+		received += n;
+	}
+
+	if (received != nb) {
+		printf("Guest received %u of %u packets\n", received, nb);
+		rte_pktmbuf_free_bulk(pkts + sent, nb - sent);
+		return -1;
+	}
+
+	return ret;
+}
+
+/* Send nb packets from the guest, dequeued asynchronously. */
+static int
+test_async_dequeue(int vid, uint16_t port, uint32_t seq, uint16_t nb)
+{
+	struct rte_mbuf *pkts[MAX_BURST];
+	uint64_t deadline = rte_get_timer_cycles() +
+		TIMEOUT_S * rte_get_timer_hz();
+	uint16_t i, n, sent = 0, received = 0;
+	int nr_inflight, ret = 0;
+
+	for (i = 0; i != nb; i++) {
+		pkts[i] = test_async_pkt_alloc(test_async_pkt_len(seq + i),
+			seq + i);
+		if (pkts[i] == NULL) {
+			rte_pktmbuf_free_bulk(pkts, i);
+			return -1;
+		}
+	}
+
+	while (sent != nb && rte_get_timer_cycles() < deadline)
+		sent += rte_eth_tx_burst(port, 0, pkts + sent, nb - sent);
+	if (sent != nb) {
+		printf("Guest sent %u of %u packets\n", sent, nb);
+		rte_pktmbuf_free_bulk(pkts + sent, nb - sent);
+		return -1;
+	}
+
+	do {
+		n = rte_vhost_async_try_dequeue_burst(vid, VIRTIO_TXQ, mp,
+			pkts, RTE_DIM(pkts), &nr_inflight);
+		if (nr_inflight < 0 || received + n > nb) {
+			printf("Dequeued %u of %u packets, %d in flight\n",
+				received + n, nb, nr_inflight);
+			rte_pktmbuf_free_bulk(pkts, n);
+			return -1;
+		}
+		for (i = 0; i != n; i++) {
+			if (test_async_pkt_check(pkts[i],
+					test_async_pkt_len(seq + received + i),
+					seq + received + i) != 0)
+				ret = -1;
+		}
+		rte_pktmbuf_free_bulk(pkts, n);
+		received += n;
+	} while ((received != nb || nr_inflight != 0) &&
+			rte_get_timer_cycles() < deadline);
+
+	if (received != nb || nr_inflight != 0) {
+		printf("Dequeued %u of %u packets, %d in flight\n",
+			received, nb, nr_inflight);
+		return -1;
+	}
+
+	return ret;
+}
+
+static int
+test_async_configure_port(uint16_t port)
+{
+	struct rte_eth_conf port_conf;
+
+	memset(&port_conf, 0, sizeof(struct rte_eth_conf));
+	port_conf.rxmode.max_rx_pkt_len = MAX_PKT_LEN + RTE_ETHER_CRC_LEN;
+
+	if (rte_eth_dev_configure(port, 1, 1, &port_conf) < 0) {
+		printf("Configure failed for port %u\n", port);
+		return -1;
+	}
+
+	if (rte_eth_tx_queue_setup(port, 0, RING_SIZE, SOCKET0, NULL) < 0) {
+		printf("TX queue setup failed port %u\n", port);
+		return -1;
+	}
+
+	if (rte_eth_rx_queue_setup(port, 0, RING_SIZE, SOCKET0,
+				NULL, mp) < 0) {
+		printf("RX queue setup failed port %u\n", port);
+		return -1;
+	}
+
+	if (rte_eth_dev_start(port) < 0) {
+		printf("Error starting port %u\n", port);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+test_async_ring(int packed)
+{
+	char args[128 + sizeof(sock_path)];
+	uint64_t deadline;
+	uint32_t round, seq = 0;
+	uint16_t port, nb;
+	int ret = -1;
+
+	memset(nr_calls, 0, sizeof(nr_calls));
+	memset(nr_refused, 0, sizeof(nr_refused));
+
+	unlink(sock_path);
+	if (rte_vhost_driver_register(sock_path,
+				RTE_VHOST_USER_ASYNC_COPY) != 0)
+		return -1;
+	if (rte_vhost_driver_callback_register(sock_path,
+				&test_async_device_ops) != 0 ||
+			rte_vhost_driver_start(sock_path) != 0)
+		goto unregister;
+
+	snprintf(args, sizeof(args),
+		"path=%s,queues=1,queue_size=%u,mrg_rxbuf=1,packed_vq=%d",
+		sock_path, RING_SIZE, packed);
+	if (rte_vdev_init(VDEV_NAME, args) != 0) {
+		printf("Cannot create %s, skipping\n", VDEV_NAME);
+		ret = TEST_SKIPPED;
+		goto unregister;
+	}
+
+	if (rte_eth_dev_get_port_by_name(VDEV_NAME, &port) != 0 ||
+			test_async_configure_port(port) != 0)
+		goto uninit;
+
+	deadline = rte_get_timer_cycles() + TIMEOUT_S * rte_get_timer_hz();
+	while (ready_vid < 0 && rte_get_timer_cycles() < deadline)
+		rte_delay_ms(1);
+	if (ready_vid < 0) {
+		printf("vhost device not ready\n");
+		goto stop;
+	}
+
+	for (round = 0; round != NB_ROUNDS; round++) {
+		nb = 1 + round % MAX_BURST;
+		if (test_async_enqueue(ready_vid, port, seq, nb) != 0 ||
+				test_async_dequeue(ready_vid, port, seq,
+					nb) != 0)
+			goto stop;
+		seq += nb;
+	}
+
+	if (nr_refused[VIRTIO_RXQ] == 0 || nr_refused[VIRTIO_TXQ] == 0) {
+		printf("No copy refused, %u and %u\n",
+			nr_refused[VIRTIO_RXQ], nr_refused[VIRTIO_TXQ]);
+		goto stop;
+	}
+
+	printf("%s ring: %u packets each way, %u and %u copies refused\n",
+		packed ? "packed" : "split", seq, nr_refused[VIRTIO_RXQ],
+		nr_refused[VIRTIO_TXQ]);
+	ret = 0;
+
+stop:
+	rte_eth_dev_stop(port);
+uninit:
+	rte_vdev_uninit(VDEV_NAME);
+unregister:
+	rte_vhost_driver_unregister(sock_path);
+	unlink(sock_path);
+	return ret;
+}
+
+static int
+test_vhost_async(void)
+{
+	unsigned int lcore_id;
+	int ret;
+
+	/* the engine copies from IO addresses */
+	if (rte_eal_iova_mode() != RTE_IOVA_VA) {
+		printf("IOVA as VA mode required, skipping\n");
+		return TEST_SKIPPED;
+	}
+
+	lcore_id = rte_get_next_lcore(-1, 1, 0);
+	if (lcore_id == RTE_MAX_LCORE) {
+		printf("No lcore for the copy engine, skipping\n");
+		return TEST_SKIPPED;
+	}
+
+	snprintf(sock_path, sizeof(sock_path), SOCK_TEMPLATE, getpid());
+
+	mp = rte_pktmbuf_pool_create("mbuf_pool_vhost_async", NB_MBUF, 32,
+		0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+	if (mp == NULL)
+		return -1;
+
+	if (cpu_copy_start(lcore_id) != 0) {
+		rte_mempool_free(mp);
+		return -1;
+	}
+
+	ret = test_async_ring(0);
+	if (ret == 0)
+		ret = test_async_ring(1);
+
+	cpu_copy_stop();
+
+	if (ret == 0 && rte_mempool_avail_count(mp) != NB_MBUF) {
+		printf("%u mbufs leaked\n",
+			NB_MBUF - rte_mempool_avail_count(mp));
+		ret = -1;
+	}
+
+	rte_mempool_free(mp);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(vhost_async_autotest, test_vhost_async);
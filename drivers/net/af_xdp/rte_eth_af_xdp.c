@@ -6,10 +6,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <poll.h>
+#include <pthread.h>
 #include <netinet/in.h>
 #include <net/if.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/queue.h>
 #include <linux/if_ether.h>
 #include <linux/if_xdp.h>
 #include <linux/if_link.h>
@@ -50,6 +52,14 @@
 #define PF_XDP AF_XDP
 #endif
 
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+
 RTE_LOG_REGISTER(af_xdp_logtype, pmd.net.af_xdp, NOTICE);
 
 #define AF_XDP_LOG(level, fmt, args...)			\
@@ -61,21 +71,29 @@ RTE_LOG_REGISTER(af_xdp_logtype, pmd.net.af_xdp, NOTICE);
 #define ETH_AF_XDP_DFLT_NUM_DESCS	XSK_RING_CONS__DEFAULT_NUM_DESCS
 #define ETH_AF_XDP_DFLT_START_QUEUE_IDX	0
 #define ETH_AF_XDP_DFLT_QUEUE_COUNT	1
+#define ETH_AF_XDP_DFLT_BUSY_BUDGET	0
+#define ETH_AF_XDP_BUSY_TIMEOUT		20
 
 #define ETH_AF_XDP_RX_BATCH_SIZE	32
 #define ETH_AF_XDP_TX_BATCH_SIZE	32
 
 
 struct xsk_umem_info {
-	struct xsk_ring_prod fq;
-	struct xsk_ring_cons cq;
 	struct xsk_umem *umem;
 	struct rte_ring *buf_ring;
 	const struct rte_memzone *mz;
 	struct rte_mempool *mb_pool;
 	void *buffer;
+	uint32_t refcnt;
+	uint8_t shared;
+	TAILQ_ENTRY(xsk_umem_info) next;
 };
 
+/* UMEMs shared between queues and ports, one per mempool */
+static TAILQ_HEAD(, xsk_umem_info) shared_umems =
+	TAILQ_HEAD_INITIALIZER(shared_umems);
+static pthread_mutex_t shared_umems_lock = PTHREAD_MUTEX_INITIALIZER;
+
 struct rx_stats {
 	uint64_t rx_pkts;
 	uint64_t rx_bytes;
@@ -87,6 +105,10 @@ struct pkt_rx_queue {
 	struct xsk_umem_info *umem;
 	struct xsk_socket *xsk;
 	struct rte_mempool *mb_pool;
+	/* fill and completion rings of this socket, the tx side uses cq */
+	struct xsk_ring_prod fq;
+	struct xsk_ring_cons cq;
+	uint32_t busy_budget;
 
 	struct rx_stats stats;
 
@@ -118,6 +140,8 @@ struct pmd_internals {
 	int queue_cnt;
 	int max_queue_cnt;
 	int combined_queue_cnt;
+	int shared_umem;
+	int busy_budget;
 
 	struct rte_ether_addr eth_addr;
 
@@ -128,11 +152,15 @@ struct pmd_internals {
 #define ETH_AF_XDP_IFACE_ARG			"iface"
 #define ETH_AF_XDP_START_QUEUE_ARG		"start_queue"
 #define ETH_AF_XDP_QUEUE_COUNT_ARG		"queue_count"
+#define ETH_AF_XDP_SHARED_UMEM_ARG		"shared_umem"
+#define ETH_AF_XDP_BUSY_BUDGET_ARG		"busy_budget"
 
 static const char * const valid_arguments[] = {
 	ETH_AF_XDP_IFACE_ARG,
 	ETH_AF_XDP_START_QUEUE_ARG,
 	ETH_AF_XDP_QUEUE_COUNT_ARG,
+	ETH_AF_XDP_SHARED_UMEM_ARG,
+	ETH_AF_XDP_BUSY_BUDGET_ARG,
 	NULL
 };
 
@@ -146,9 +174,8 @@ static const struct rte_eth_link pmd_link = {
 #if defined(XDP_UMEM_UNALIGNED_CHUNK_FLAG)
 static inline int
 reserve_fill_queue_zc(struct xsk_umem_info *umem, uint16_t reserve_size,
-		      struct rte_mbuf **bufs)
+		      struct rte_mbuf **bufs, struct xsk_ring_prod *fq)
 {
-	struct xsk_ring_prod *fq = &umem->fq;
 	uint32_t idx;
 	uint16_t i;
 
@@ -176,9 +203,9 @@ reserve_fill_queue_zc(struct xsk_umem_info *umem, uint16_t reserve_size,
 #else
 static inline int
 reserve_fill_queue_cp(struct xsk_umem_info *umem, uint16_t reserve_size,
-		      struct rte_mbuf **bufs __rte_unused)
+		      struct rte_mbuf **bufs __rte_unused,
+		      struct xsk_ring_prod *fq)
 {
-	struct xsk_ring_prod *fq = &umem->fq;
 	void *addrs[reserve_size];
 	uint32_t idx;
 	uint16_t i;
@@ -211,12 +238,31 @@ reserve_fill_queue_cp(struct xsk_umem_info *umem, uint16_t reserve_size,
 
 static inline int
 reserve_fill_queue(struct xsk_umem_info *umem, uint16_t reserve_size,
-		   struct rte_mbuf **bufs)
+		   struct rte_mbuf **bufs, struct xsk_ring_prod *fq)
 {
 #if defined(XDP_UMEM_UNALIGNED_CHUNK_FLAG)
-	return reserve_fill_queue_zc(umem, reserve_size, bufs);
+	return reserve_fill_queue_zc(umem, reserve_size, bufs, fq);
 #else
-	return reserve_fill_queue_cp(umem, reserve_size, bufs);
+	return reserve_fill_queue_cp(umem, reserve_size, bufs, fq);
+#endif
+}
+
+/*
+ * Nothing was received, let the kernel process the queue. With busy
+ * polling the application drives the driver's NAPI context, otherwise
+ * the socket is only woken up when the kernel asks for it.
+ */
+static inline void
+rx_kick(struct pkt_rx_queue *rxq)
+{
+	if (rxq->busy_budget != 0) {
+		(void)recvfrom(xsk_socket__fd(rxq->xsk), NULL, 0,
+			       MSG_DONTWAIT, NULL, NULL);
+		return;
+	}
+#if defined(XDP_USE_NEED_WAKEUP)
+	if (xsk_ring_prod__needs_wakeup(&rxq->fq))
+		(void)poll(rxq->fds, 1, 1000);
 #endif
 }
 
@@ -227,6 +273,7 @@ af_xdp_rx_zc(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	struct pkt_rx_queue *rxq = queue;
 	struct xsk_ring_cons *rx = &rxq->rx;
 	struct xsk_umem_info *umem = rxq->umem;
+	struct xsk_ring_prod *fq = &rxq->fq;
 	uint32_t idx_rx = 0;
 	unsigned long rx_bytes = 0;
 	int rcvd, i;
@@ -242,11 +289,7 @@ af_xdp_rx_zc(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	rcvd = xsk_ring_cons__peek(rx, nb_pkts, &idx_rx);
 
 	if (rcvd == 0) {
-#if defined(XDP_USE_NEED_WAKEUP)
-		if (xsk_ring_prod__needs_wakeup(&umem->fq))
-			(void)poll(rxq->fds, 1, 1000);
-#endif
-
+		rx_kick(rxq);
 		goto out;
 	}
 
@@ -277,7 +320,7 @@ af_xdp_rx_zc(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 
 	xsk_ring_cons__release(rx, rcvd);
 
-	(void)reserve_fill_queue(umem, rcvd, fq_bufs);
+	(void)reserve_fill_queue(umem, rcvd, fq_bufs, fq);
 
 	/* statistics */
 	rxq->stats.rx_pkts += rcvd;
@@ -297,7 +340,7 @@ af_xdp_rx_cp(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	struct pkt_rx_queue *rxq = queue;
 	struct xsk_ring_cons *rx = &rxq->rx;
 	struct xsk_umem_info *umem = rxq->umem;
-	struct xsk_ring_prod *fq = &umem->fq;
+	struct xsk_ring_prod *fq = &rxq->fq;
 	uint32_t idx_rx = 0;
 	unsigned long rx_bytes = 0;
 	int rcvd, i;
@@ -309,16 +352,13 @@ af_xdp_rx_cp(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 
 	rcvd = xsk_ring_cons__peek(rx, nb_pkts, &idx_rx);
 	if (rcvd == 0) {
-#if defined(XDP_USE_NEED_WAKEUP)
-		if (xsk_ring_prod__needs_wakeup(fq))
-			(void)poll(rxq->fds, 1, 1000);
-#endif
-
+		rx_kick(rxq);
 		goto out;
 	}
 
 	if (xsk_prod_nb_free(fq, free_thresh) >= free_thresh)
-		(void)reserve_fill_queue(umem, ETH_AF_XDP_RX_BATCH_SIZE, NULL);
+		(void)reserve_fill_queue(umem, ETH_AF_XDP_RX_BATCH_SIZE,
+					 NULL, fq);
 
 	for (i = 0; i < rcvd; i++) {
 		const struct xdp_desc *desc;
@@ -367,9 +407,8 @@ eth_af_xdp_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 }
 
 static void
-pull_umem_cq(struct xsk_umem_info *umem, int size)
+pull_umem_cq(struct xsk_umem_info *umem, int size, struct xsk_ring_cons *cq)
 {
-	struct xsk_ring_cons *cq = &umem->cq;
 	size_t i, n;
 	uint32_t idx_cq = 0;
 
@@ -395,8 +434,9 @@ static void
 kick_tx(struct pkt_tx_queue *txq)
 {
 	struct xsk_umem_info *umem = txq->umem;
+	struct xsk_ring_cons *cq = &txq->pair->cq;
 
-	pull_umem_cq(umem, XSK_RING_CONS__DEFAULT_NUM_DESCS);
+	pull_umem_cq(umem, XSK_RING_CONS__DEFAULT_NUM_DESCS, cq);
 
 #if defined(XDP_USE_NEED_WAKEUP)
 	if (xsk_ring_prod__needs_wakeup(&txq->tx))
@@ -410,7 +450,8 @@ kick_tx(struct pkt_tx_queue *txq)
 			/* pull from completion queue to leave more space */
 			if (errno == EAGAIN)
 				pull_umem_cq(umem,
-					     XSK_RING_CONS__DEFAULT_NUM_DESCS);
+					     XSK_RING_CONS__DEFAULT_NUM_DESCS,
+					     cq);
 		}
 }
 
@@ -427,10 +468,11 @@ af_xdp_tx_zc(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	uint16_t count = 0;
 	struct xdp_desc *desc;
 	uint64_t addr, offset;
-	uint32_t free_thresh = umem->cq.size >> 1;
+	struct xsk_ring_cons *cq = &txq->pair->cq;
+	uint32_t free_thresh = cq->size >> 1;
 
-	if (xsk_cons_nb_avail(&umem->cq, free_thresh) >= free_thresh)
-		pull_umem_cq(umem, XSK_RING_CONS__DEFAULT_NUM_DESCS);
+	if (xsk_cons_nb_avail(cq, free_thresh) >= free_thresh)
+		pull_umem_cq(umem, XSK_RING_CONS__DEFAULT_NUM_DESCS, cq);
 
 	for (i = 0; i < nb_pkts; i++) {
 		mbuf = bufs[i];
@@ -511,7 +553,7 @@ af_xdp_tx_cp(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 
 	nb_pkts = RTE_MIN(nb_pkts, ETH_AF_XDP_TX_BATCH_SIZE);
 
-	pull_umem_cq(umem, nb_pkts);
+	pull_umem_cq(umem, nb_pkts, &txq->pair->cq);
 
 	nb_pkts = rte_ring_dequeue_bulk(umem->buf_ring, addrs,
 					nb_pkts, NULL);
@@ -701,6 +743,23 @@ xdp_umem_destroy(struct xsk_umem_info *umem)
 	umem = NULL;
 }
 
+/* drop a queue's reference to its umem, the last one destroys it */
+static void
+xdp_umem_put(struct xsk_umem_info *umem)
+{
+	pthread_mutex_lock(&shared_umems_lock);
+	if (--umem->refcnt != 0) {
+		pthread_mutex_unlock(&shared_umems_lock);
+		return;
+	}
+	if (umem->shared)
+		TAILQ_REMOVE(&shared_umems, umem, next);
+	pthread_mutex_unlock(&shared_umems_lock);
+
+	(void)xsk_umem__delete(umem->umem);
+	xdp_umem_destroy(umem);
+}
+
 static void
 eth_dev_close(struct rte_eth_dev *dev)
 {
@@ -716,8 +775,7 @@ eth_dev_close(struct rte_eth_dev *dev)
 		if (rxq->umem == NULL)
 			break;
 		xsk_socket__delete(rxq->xsk);
-		(void)xsk_umem__delete(rxq->umem->umem);
-		xdp_umem_destroy(rxq->umem);
+		xdp_umem_put(rxq->umem);
 
 		/* free pkt_tx_queue */
 		rte_free(rxq->pair);
@@ -755,8 +813,8 @@ static inline uint64_t get_base_addr(struct rte_mempool *mp)
 }
 
 static struct
-xsk_umem_info *xdp_umem_configure(struct pmd_internals *internals __rte_unused,
-				  struct pkt_rx_queue *rxq)
+xsk_umem_info *xdp_umem_create(struct pmd_internals *internals __rte_unused,
+			       struct pkt_rx_queue *rxq)
 {
 	struct xsk_umem_info *umem;
 	int ret;
@@ -786,7 +844,7 @@ xsk_umem_info *xdp_umem_configure(struct pmd_internals *internals __rte_unused,
 
 	ret = xsk_umem__create(&umem->umem, base_addr,
 			       mb_pool->populated_size * usr_config.frame_size,
-			       &umem->fq, &umem->cq,
+			       &rxq->fq, &rxq->cq,
 			       &usr_config);
 
 	if (ret) {
@@ -797,8 +855,8 @@ xsk_umem_info *xdp_umem_configure(struct pmd_internals *internals __rte_unused,
 
 #else
 static struct
-xsk_umem_info *xdp_umem_configure(struct pmd_internals *internals,
-				  struct pkt_rx_queue *rxq)
+xsk_umem_info *xdp_umem_create(struct pmd_internals *internals,
+			       struct pkt_rx_queue *rxq)
 {
 	struct xsk_umem_info *umem;
 	const struct rte_memzone *mz;
@@ -846,7 +904,7 @@ xsk_umem_info *xdp_umem_configure(struct pmd_internals *internals,
 
 	ret = xsk_umem__create(&umem->umem, mz->addr,
 			       ETH_AF_XDP_NUM_BUFFERS * ETH_AF_XDP_FRAME_SIZE,
-			       &umem->fq, &umem->cq,
+			       &rxq->fq, &rxq->cq,
 			       &usr_config);
 
 	if (ret) {
@@ -856,6 +914,7 @@ xsk_umem_info *xdp_umem_configure(struct pmd_internals *internals,
 	umem->mz = mz;
 
 #endif
+	umem->refcnt = 1;
 	return umem;
 
 err:
@@ -863,6 +922,74 @@ xsk_umem_info *xdp_umem_configure(struct pmd_internals *internals,
 	return NULL;
 }
 
+/*
+ * With shared umem, all queues of the sharing ports which get their
+ * buffers from the same mempool use a single umem, each socket having
+ * its own fill and completion rings. Otherwise every queue gets its own.
+ */
+static struct xsk_umem_info *
+xdp_umem_configure(struct pmd_internals *internals, struct pkt_rx_queue *rxq)
+{
+	struct xsk_umem_info *umem;
+
+	if (!internals->shared_umem)
+		return xdp_umem_create(internals, rxq);
+
+	pthread_mutex_lock(&shared_umems_lock);
+	TAILQ_FOREACH(umem, &shared_umems, next) {
+		if (umem->mb_pool == rxq->mb_pool)
+			break;
+	}
+	if (umem != NULL) {
+		umem->refcnt++;
+		AF_XDP_LOG(INFO, "Sharing umem of mempool %s\n",
+			   rxq->mb_pool->name);
+	} else {
+		umem = xdp_umem_create(internals, rxq);
+		if (umem != NULL) {
+			umem->shared = 1;
+			TAILQ_INSERT_TAIL(&shared_umems, umem, next);
+		}
+	}
+	pthread_mutex_unlock(&shared_umems_lock);
+
+	return umem;
+}
+
+/*
+ * Let the application drive the driver's NAPI context from rx/tx burst
+ * rather than the softirq, needs kernel 5.11 or later.
+ */
+static int
+configure_busy_poll(struct pkt_rx_queue *rxq)
+{
+	const struct {
+		int name;
+		int val;
+		const char *str;
+	} opts[] = {
+		{ SO_PREFER_BUSY_POLL, 1, "SO_PREFER_BUSY_POLL" },
+		{ SO_BUSY_POLL, ETH_AF_XDP_BUSY_TIMEOUT, "SO_BUSY_POLL" },
+		{ SO_BUSY_POLL_BUDGET, rxq->busy_budget, "SO_BUSY_POLL_BUDGET" },
+	};
+	int fd = xsk_socket__fd(rxq->xsk);
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < RTE_DIM(opts); i++) {
+		if (setsockopt(fd, SOL_SOCKET, opts[i].name, &opts[i].val,
+			       sizeof(opts[i].val)) < 0) {
+			ret = -errno;
+			AF_XDP_LOG(ERR, "Failed to set %s: %s\n",
+				   opts[i].str, strerror(-ret));
+			return ret;
+		}
+	}
+
+	AF_XDP_LOG(INFO, "Busy polling budget set to %u\n", rxq->busy_budget);
+	return 0;
+}
+
 static int
 xsk_configure(struct pmd_internals *internals, struct pkt_rx_queue *rxq,
 	      int ring_size)
@@ -888,21 +1015,38 @@ xsk_configure(struct pmd_internals *internals, struct pkt_rx_queue *rxq,
 	cfg.bind_flags |= XDP_USE_NEED_WAKEUP;
 #endif
 
-	ret = xsk_socket__create(&rxq->xsk, internals->if_name,
-			rxq->xsk_queue_idx, rxq->umem->umem, &rxq->rx,
-			&txq->tx, &cfg);
+#if defined(RTE_LIBRTE_AF_XDP_PMD_SHARED_UMEM)
+	if (internals->shared_umem)
+		ret = xsk_socket__create_shared(&rxq->xsk, internals->if_name,
+				rxq->xsk_queue_idx, rxq->umem->umem, &rxq->rx,
+				&txq->tx, &rxq->fq, &rxq->cq, &cfg);
+	else
+#endif
+		ret = xsk_socket__create(&rxq->xsk, internals->if_name,
+				rxq->xsk_queue_idx, rxq->umem->umem, &rxq->rx,
+				&txq->tx, &cfg);
 	if (ret) {
 		AF_XDP_LOG(ERR, "Failed to create xsk socket.\n");
 		goto err;
 	}
 
+	if (rxq->busy_budget != 0) {
+		ret = configure_busy_poll(rxq);
+		if (ret) {
+			xsk_socket__delete(rxq->xsk);
+			goto err;
+		}
+	}
+
 #if defined(XDP_UMEM_UNALIGNED_CHUNK_FLAG)
 	if (rte_pktmbuf_alloc_bulk(rxq->umem->mb_pool, fq_bufs, reserve_size)) {
+		xsk_socket__delete(rxq->xsk);
 		AF_XDP_LOG(DEBUG, "Failed to get enough buffers for fq.\n");
+		ret = -ENOMEM;
 		goto err;
 	}
 #endif
-	ret = reserve_fill_queue(rxq->umem, reserve_size, fq_bufs);
+	ret = reserve_fill_queue(rxq->umem, reserve_size, fq_bufs, &rxq->fq);
 	if (ret) {
 		xsk_socket__delete(rxq->xsk);
 		AF_XDP_LOG(ERR, "Failed to reserve fill queue.\n");
@@ -912,7 +1056,8 @@ xsk_configure(struct pmd_internals *internals, struct pkt_rx_queue *rxq,
 	return 0;
 
 err:
-	xdp_umem_destroy(rxq->umem);
+	xdp_umem_put(rxq->umem);
+	rxq->umem = NULL;
 
 	return ret;
 }
@@ -1142,7 +1287,7 @@ xdp_get_channels_info(const char *if_name, int *max_queues,
 
 static int
 parse_parameters(struct rte_kvargs *kvlist, char *if_name, int *start_queue,
-			int *queue_cnt)
+			int *queue_cnt, int *shared_umem, int *busy_budget)
 {
 	int ret;
 
@@ -1163,6 +1308,18 @@ parse_parameters(struct rte_kvargs *kvlist, char *if_name, int *start_queue,
 		goto free_kvlist;
 	}
 
+	ret = rte_kvargs_process(kvlist, ETH_AF_XDP_SHARED_UMEM_ARG,
+				 &parse_integer_arg, shared_umem);
+	if (ret < 0)
+		goto free_kvlist;
+
+	ret = rte_kvargs_process(kvlist, ETH_AF_XDP_BUSY_BUDGET_ARG,
+				 &parse_integer_arg, busy_budget);
+	if (ret < 0 || *busy_budget > UINT16_MAX) {
+		ret = -EINVAL;
+		goto free_kvlist;
+	}
+
 free_kvlist:
 	rte_kvargs_free(kvlist);
 	return ret;
@@ -1200,7 +1357,8 @@ get_iface_info(const char *if_name,
 
 static struct rte_eth_dev *
 init_internals(struct rte_vdev_device *dev, const char *if_name,
-			int start_queue_idx, int queue_cnt)
+			int start_queue_idx, int queue_cnt, int shared_umem,
+			int busy_budget)
 {
 	const char *name = rte_vdev_device_name(dev);
 	const unsigned int numa_node = dev->device.numa_node;
@@ -1215,6 +1373,8 @@ init_internals(struct rte_vdev_device *dev, const char *if_name,
 
 	internals->start_queue_idx = start_queue_idx;
 	internals->queue_cnt = queue_cnt;
+	internals->shared_umem = shared_umem;
+	internals->busy_budget = busy_budget;
 	strlcpy(internals->if_name, if_name, IFNAMSIZ);
 
 	if (xdp_get_channels_info(if_name, &internals->max_queue_cnt,
@@ -1250,6 +1410,7 @@ init_internals(struct rte_vdev_device *dev, const char *if_name,
 		internals->rx_queues[i].pair = &internals->tx_queues[i];
 		internals->rx_queues[i].xsk_queue_idx = start_queue_idx + i;
 		internals->tx_queues[i].xsk_queue_idx = start_queue_idx + i;
+		internals->rx_queues[i].busy_budget = busy_budget;
 	}
 
 	ret = get_iface_info(if_name, &internals->eth_addr,
@@ -1292,6 +1453,8 @@ rte_pmd_af_xdp_probe(struct rte_vdev_device *dev)
 	char if_name[IFNAMSIZ] = {'\0'};
 	int xsk_start_queue_idx = ETH_AF_XDP_DFLT_START_QUEUE_IDX;
 	int xsk_queue_cnt = ETH_AF_XDP_DFLT_QUEUE_COUNT;
+	int shared_umem = 0;
+	int busy_budget = ETH_AF_XDP_DFLT_BUSY_BUDGET;
 	struct rte_eth_dev *eth_dev = NULL;
 	const char *name;
 
@@ -1321,18 +1484,26 @@ rte_pmd_af_xdp_probe(struct rte_vdev_device *dev)
 		dev->device.numa_node = rte_socket_id();
 
 	if (parse_parameters(kvlist, if_name, &xsk_start_queue_idx,
-			     &xsk_queue_cnt) < 0) {
+			     &xsk_queue_cnt, &shared_umem, &busy_budget) < 0) {
 		AF_XDP_LOG(ERR, "Invalid kvargs value\n");
 		return -EINVAL;
 	}
 
+#if !defined(XDP_UMEM_UNALIGNED_CHUNK_FLAG) || \
+	!defined(RTE_LIBRTE_AF_XDP_PMD_SHARED_UMEM)
+	if (shared_umem) {
+		AF_XDP_LOG(WARNING, "Shared umem needs zero copy and libbpf with xsk_socket__create_shared(), ignored\n");
+		shared_umem = 0;
+	}
+#endif
+
 	if (strlen(if_name) == 0) {
 		AF_XDP_LOG(ERR, "Network interface must be specified\n");
 		return -EINVAL;
 	}
 
 	eth_dev = init_internals(dev, if_name, xsk_start_queue_idx,
-					xsk_queue_cnt);
+					xsk_queue_cnt, shared_umem, busy_budget);
 	if (eth_dev == NULL) {
 		AF_XDP_LOG(ERR, "Failed to init internals\n");
 		return -1;
@@ -1375,4 +1546,6 @@ RTE_PMD_REGISTER_VDEV(net_af_xdp, pmd_af_xdp_drv);
 RTE_PMD_REGISTER_PARAM_STRING(net_af_xdp,
 			      "iface=<string> "
 			      "start_queue=<int> "
-			      "queue_count=<int> ");
+			      "queue_count=<int> "
+			      "shared_umem=<int> "
+			      "busy_budget=<int> ");
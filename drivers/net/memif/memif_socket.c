@@ -280,6 +280,7 @@ memif_msg_receive_add_region(struct rte_eth_dev *dev, memif_msg_t *msg,
 	r->fd = fd;
 	r->region_size = ar->size;
 	r->addr = NULL;
+	r->refcnt = 1;
 
 	proc_private->regions[ar->index] = r;
 	proc_private->regions_num++;
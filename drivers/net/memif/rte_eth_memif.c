@@ -39,6 +39,7 @@
 #define ETH_MEMIF_MAC_ARG		"mac"
 #define ETH_MEMIF_ZC_ARG		"zero-copy"
 #define ETH_MEMIF_SECRET_ARG		"secret"
+#define ETH_MEMIF_RX_EXTBUF_ARG		"extbuf"
 
 static const char * const valid_arguments[] = {
 	ETH_MEMIF_ID_ARG,
@@ -49,6 +50,7 @@ static const char * const valid_arguments[] = {
 	ETH_MEMIF_MAC_ARG,
 	ETH_MEMIF_ZC_ARG,
 	ETH_MEMIF_SECRET_ARG,
+	ETH_MEMIF_RX_EXTBUF_ARG,
 	NULL
 };
 
@@ -166,6 +168,7 @@ memif_mp_request_regions(struct rte_eth_dev *dev)
 				return -ENOMEM;
 			}
 			r->region_size = reply_param->size;
+			r->refcnt = 1;
 			if (reply->num_fds < 1) {
 				MIF_LOG(ERR, "Missing file descriptor.");
 				free(reply);
@@ -245,6 +248,52 @@ memif_get_buffer(struct pmd_process_private *proc_private, memif_desc_t *d)
 	return ((uint8_t *)proc_private->regions[d->region]->addr + d->offset);
 }
 
+/* Drop a reference to a region, the last one unmaps it. */
+static void
+memif_region_put(struct memif_region *r)
+{
+	if (__atomic_sub_fetch(&r->refcnt, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+
+	if (r->addr != NULL) {
+		if (r->extmem)
+			rte_extmem_unregister(r->addr,
+				RTE_ALIGN_CEIL(r->region_size,
+					(size_t)sysconf(_SC_PAGESIZE)));
+		munmap(r->addr, r->region_size);
+		if (r->fd > 0) {
+			close(r->fd);
+			r->fd = -1;
+		}
+	}
+	rte_free(r);
+}
+
+static void
+memif_extbuf_ring_put(struct memif_extbuf_ring *er)
+{
+	int i;
+
+	if (__atomic_sub_fetch(&er->refcnt, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+
+	for (i = 0; i < er->regions_num; i++)
+		if (er->regions[i] != NULL)
+			memif_region_put(er->regions[i]);
+	rte_free(er);
+}
+
+/* Called when the last mbuf attached to a ring slot buffer is freed. */
+static void
+memif_extbuf_free(void *addr __rte_unused, void *opaque)
+{
+	struct memif_extbuf *eb = opaque;
+	struct memif_extbuf_ring *er = eb->ring;
+
+	__atomic_store_n(&eb->in_use, 0, __ATOMIC_RELEASE);
+	memif_extbuf_ring_put(er);
+}
+
 /* Free mbufs received by master */
 static void
 memif_free_stored_mbufs(struct pmd_process_private *proc_private, struct memif_queue *mq)
@@ -420,6 +469,128 @@ eth_memif_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	return n_rx_pkts;
 }
 
+/*
+ * Receive without copy: each descriptor buffer is attached to an mbuf as
+ * external buffer. Slots go back to the ring in order once the application
+ * has freed their mbufs, so the ring only stalls on the oldest buffer held.
+ */
+static uint16_t
+eth_memif_rx_extbuf(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct memif_queue *mq = queue;
+	struct pmd_internals *pmd = rte_eth_devices[mq->in_port].data->dev_private;
+	struct pmd_process_private *proc_private =
+		rte_eth_devices[mq->in_port].process_private;
+	memif_ring_t *ring = memif_get_ring_from_queue(proc_private, mq);
+	struct memif_extbuf_ring *er = mq->extbufs;
+	uint16_t cur_slot, last_slot, pkt_slot, n_slots, ring_size, mask, s0;
+	uint16_t n_rx_pkts = 0;
+	memif_ring_type_t type = mq->type;
+	memif_desc_t *d0;
+	struct memif_extbuf *eb;
+	struct rte_mbuf *mbuf, *mbuf_head, *mbuf_tail;
+	void *addr;
+	uint16_t head;
+
+	if (unlikely((pmd->flags & ETH_MEMIF_FLAG_CONNECTED) == 0 ||
+			ring == NULL || er == NULL))
+		return 0;
+
+	/* consume interrupt */
+	if ((ring->flags & MEMIF_RING_FLAG_MASK_INT) == 0) {
+		uint64_t b;
+		ssize_t size __rte_unused;
+		size = read(mq->intr_handle.fd, &b, sizeof(b));
+	}
+
+	ring_size = 1 << mq->log2_ring_size;
+	mask = ring_size - 1;
+
+	if (type == MEMIF_RING_S2M) {
+		cur_slot = mq->last_head;
+		last_slot = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	} else {
+		cur_slot = mq->last_tail;
+		last_slot = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	}
+
+	/* reclaim the slots of the buffers freed since the last call */
+	while (mq->last_free != cur_slot &&
+			__atomic_load_n(&er->bufs[mq->last_free & mask].in_use,
+				__ATOMIC_ACQUIRE) == 0)
+		mq->last_free++;
+
+	n_slots = last_slot - cur_slot;
+	while (n_slots && n_rx_pkts < nb_pkts) {
+		pkt_slot = cur_slot;
+		mbuf_head = NULL;
+		mbuf_tail = NULL;
+
+		do {
+			s0 = cur_slot & mask;
+			d0 = &ring->desc[s0];
+
+			mbuf = rte_pktmbuf_alloc(mq->mempool);
+			if (unlikely(mbuf == NULL)) {
+				/* give back the partial packet, retry later */
+				rte_pktmbuf_free(mbuf_head);
+				cur_slot = pkt_slot;
+				goto no_free_bufs;
+			}
+
+			eb = &er->bufs[s0];
+			eb->in_use = 1;
+			__atomic_add_fetch(&er->refcnt, 1, __ATOMIC_RELAXED);
+			rte_mbuf_ext_refcnt_set(&eb->shinfo, 1);
+
+			addr = memif_get_buffer(proc_private, d0);
+			rte_pktmbuf_attach_extbuf(mbuf, addr,
+				er->iova_va ? (rte_iova_t)(uintptr_t)addr :
+				RTE_BAD_IOVA, d0->length, &eb->shinfo);
+			mbuf->port = mq->in_port;
+			rte_pktmbuf_data_len(mbuf) = d0->length;
+			rte_pktmbuf_pkt_len(mbuf) = d0->length;
+
+			if (mbuf_head == NULL) {
+				mbuf_head = mbuf;
+			} else {
+				/* can't overflow, a ring is smaller */
+				memif_pktmbuf_chain(mbuf_head, mbuf_tail, mbuf);
+			}
+			mbuf_tail = mbuf;
+
+			cur_slot++;
+			n_slots--;
+		} while ((d0->flags & MEMIF_DESC_FLAG_NEXT) && n_slots);
+
+		mq->n_bytes += rte_pktmbuf_pkt_len(mbuf_head);
+		*bufs++ = mbuf_head;
+		n_rx_pkts++;
+	}
+
+no_free_bufs:
+	if (type == MEMIF_RING_S2M) {
+		/* master: return consumed slots to the slave */
+		__atomic_store_n(&ring->tail, mq->last_free, __ATOMIC_RELEASE);
+		mq->last_head = cur_slot;
+	} else {
+		/* slave: refill the ring with the returned slots */
+		mq->last_tail = cur_slot;
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		n_slots = ring_size - head + mq->last_free;
+
+		while (n_slots--) {
+			s0 = head++ & mask;
+			d0 = &ring->desc[s0];
+			d0->length = pmd->run.pkt_buffer_size;
+		}
+		__atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+	}
+
+	mq->n_pkts += n_rx_pkts;
+	return n_rx_pkts;
+}
+
 static uint16_t
 eth_memif_rx_zc(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 {
@@ -806,9 +977,22 @@ memif_free_regions(struct rte_eth_dev *dev)
 {
 	struct pmd_process_private *proc_private = dev->process_private;
 	struct pmd_internals *pmd = dev->data->dev_private;
+	struct memif_queue *mq;
 	int i;
 	struct memif_region *r;
 
+	/* regions stay mapped while rx queues have buffers lent */
+	if (rte_eal_process_type() == RTE_PROC_PRIMARY &&
+			dev->data->rx_queues != NULL) {
+		for (i = 0; i < dev->data->nb_rx_queues; i++) {
+			mq = dev->data->rx_queues[i];
+			if (mq != NULL && mq->extbufs != NULL) {
+				memif_extbuf_ring_put(mq->extbufs);
+				mq->extbufs = NULL;
+			}
+		}
+	}
+
 	/* regions are allocated contiguously, so it's
 	 * enough to loop until 'proc_private->regions_num'
 	 */
@@ -821,20 +1005,74 @@ memif_free_regions(struct rte_eth_dev *dev)
 				if (r->fd > 0)
 					close(r->fd);
 			}
-			if (r->addr != NULL) {
-				munmap(r->addr, r->region_size);
-				if (r->fd > 0) {
-					close(r->fd);
-					r->fd = -1;
-				}
-			}
-			rte_free(r);
+			memif_region_put(r);
 			proc_private->regions[i] = NULL;
 		}
 	}
 	proc_private->regions_num = 0;
 }
 
+/*
+ * Register the regions as external memory, so that the buffers attached
+ * to received mbufs are known to DPDK, e.g. to be mapped for device DMA.
+ */
+static void
+memif_regions_register_extmem(struct pmd_process_private *proc_private)
+{
+	size_t page_sz = sysconf(_SC_PAGESIZE);
+	struct memif_region *r;
+	int i;
+
+	for (i = 0; i < proc_private->regions_num; i++) {
+		r = proc_private->regions[i];
+		if (r == NULL || r->addr == NULL || r->extmem)
+			continue;
+		if (rte_extmem_register(r->addr,
+				RTE_ALIGN_CEIL(r->region_size, page_sz),
+				NULL, 0, page_sz) < 0) {
+			MIF_LOG(WARNING, "Failed to register region %d "
+				"as external memory: %s", i,
+				rte_strerror(rte_errno));
+			continue;
+		}
+		r->extmem = 1;
+	}
+}
+
+static int
+memif_extbuf_ring_init(struct rte_eth_dev *dev, struct memif_queue *mq)
+{
+	struct pmd_process_private *proc_private = dev->process_private;
+	struct memif_extbuf_ring *er;
+	uint32_t i, n = 1 << mq->log2_ring_size;
+
+	er = rte_zmalloc_socket("memif-extbufs",
+		sizeof(*er) + n * sizeof(er->bufs[0]), RTE_CACHE_LINE_SIZE,
+		dev->device->numa_node);
+	if (er == NULL)
+		return -ENOMEM;
+
+	er->refcnt = 1;
+	er->iova_va = rte_eal_iova_mode() == RTE_IOVA_VA;
+	for (i = 0; i < n; i++) {
+		er->bufs[i].ring = er;
+		er->bufs[i].shinfo.free_cb = memif_extbuf_free;
+		er->bufs[i].shinfo.fcb_opaque = &er->bufs[i];
+	}
+
+	er->regions_num = proc_private->regions_num;
+	for (i = 0; i < er->regions_num; i++) {
+		er->regions[i] = proc_private->regions[i];
+		if (er->regions[i] != NULL)
+			__atomic_add_fetch(&er->regions[i]->refcnt, 1,
+				__ATOMIC_RELAXED);
+	}
+
+	mq->extbufs = er;
+	mq->last_free = 0;
+	return 0;
+}
+
 static int
 memif_region_init_zc(const struct rte_memseg_list *msl, const struct rte_memseg *ms,
 		     void *arg)
@@ -861,6 +1099,7 @@ memif_region_init_zc(const struct rte_memseg_list *msl, const struct rte_memseg
 
 		r->addr = msl->base_va;
 		r->region_size = ms->len;
+		r->refcnt = 1;
 		r->fd = rte_memseg_get_fd(ms);
 		if (r->fd < 0)
 			return -1;
@@ -893,6 +1132,7 @@ memif_region_init_shm(struct rte_eth_dev *dev, uint8_t has_buffers)
 		MIF_LOG(ERR, "Failed to alloc memif region.");
 		return -ENOMEM;
 	}
+	r->refcnt = 1;
 
 	/* calculate buffer offset */
 	r->pkt_buffer_offset = (pmd->run.num_s2m_rings + pmd->run.num_m2s_rings) *
@@ -1114,7 +1354,7 @@ memif_connect(struct rte_eth_dev *dev)
 	struct memif_region *mr;
 	struct memif_queue *mq;
 	memif_ring_t *ring;
-	int i;
+	int i, n;
 
 	for (i = 0; i < proc_private->regions_num; i++) {
 		mr = proc_private->regions[i];
@@ -1173,6 +1413,20 @@ memif_connect(struct rte_eth_dev *dev)
 				ring->flags = MEMIF_RING_FLAG_MASK_INT;
 		}
 
+		if (pmd->flags & ETH_MEMIF_FLAG_RX_EXTBUF) {
+			memif_regions_register_extmem(proc_private);
+			n = (pmd->role == MEMIF_ROLE_SLAVE) ?
+			    pmd->run.num_m2s_rings : pmd->run.num_s2m_rings;
+			for (i = 0; i < n; i++) {
+				if (memif_extbuf_ring_init(dev,
+						dev->data->rx_queues[i]) < 0) {
+					MIF_LOG(ERR, "Failed to alloc rx queue "
+						"%d buffers.", i);
+					return -ENOMEM;
+				}
+			}
+		}
+
 		pmd->flags &= ~ETH_MEMIF_FLAG_CONNECTING;
 		pmd->flags |= ETH_MEMIF_FLAG_CONNECTED;
 		dev->data->dev_link.link_status = ETH_LINK_UP;
@@ -1476,6 +1730,12 @@ memif_create(struct rte_vdev_device *vdev, enum memif_role_t role,
 	/* Zero-copy flag irelevant to master. */
 	if (pmd->role == MEMIF_ROLE_MASTER)
 		pmd->flags &= ~ETH_MEMIF_FLAG_ZERO_COPY;
+	/* Zero-copy slave already receives in its own mbufs. */
+	if ((pmd->flags & ETH_MEMIF_FLAG_ZERO_COPY) &&
+			(pmd->flags & ETH_MEMIF_FLAG_RX_EXTBUF)) {
+		MIF_LOG(WARNING, "%s: extbuf ignored with zero-copy.", name);
+		pmd->flags &= ~ETH_MEMIF_FLAG_RX_EXTBUF;
+	}
 
 	ret = memif_socket_init(eth_dev, socket_filename);
 	if (ret < 0)
@@ -1506,7 +1766,10 @@ memif_create(struct rte_vdev_device *vdev, enum memif_role_t role,
 		eth_dev->rx_pkt_burst = eth_memif_rx_zc;
 		eth_dev->tx_pkt_burst = eth_memif_tx_zc;
 	} else {
-		eth_dev->rx_pkt_burst = eth_memif_rx;
+		if (pmd->flags & ETH_MEMIF_FLAG_RX_EXTBUF)
+			eth_dev->rx_pkt_burst = eth_memif_rx_extbuf;
+		else
+			eth_dev->rx_pkt_burst = eth_memif_rx;
 		eth_dev->tx_pkt_burst = eth_memif_tx;
 	}
 
@@ -1555,6 +1818,23 @@ memif_set_zc(const char *key __rte_unused, const char *value, void *extra_args)
 	return 0;
 }
 
+static int
+memif_set_rx_extbuf(const char *key __rte_unused, const char *value,
+		    void *extra_args)
+{
+	uint32_t *flags = (uint32_t *)extra_args;
+
+	if (strstr(value, "yes") != NULL) {
+		*flags |= ETH_MEMIF_FLAG_RX_EXTBUF;
+	} else if (strstr(value, "no") != NULL) {
+		*flags &= ~ETH_MEMIF_FLAG_RX_EXTBUF;
+	} else {
+		MIF_LOG(ERR, "Failed to parse extbuf param: %s.", value);
+		return -EINVAL;
+	}
+	return 0;
+}
+
 static int
 memif_set_id(const char *key __rte_unused, const char *value, void *extra_args)
 {
@@ -1763,6 +2043,10 @@ rte_pmd_memif_probe(struct rte_vdev_device *vdev)
 					 &memif_set_secret, (void *)(&secret));
 		if (ret < 0)
 			goto exit;
+		ret = rte_kvargs_process(kvlist, ETH_MEMIF_RX_EXTBUF_ARG,
+					 &memif_set_rx_extbuf, &flags);
+		if (ret < 0)
+			goto exit;
 	}
 
 	/* create interface */
@@ -1804,6 +2088,7 @@ RTE_PMD_REGISTER_PARAM_STRING(net_memif,
 			      ETH_MEMIF_SOCKET_ARG "=<string>"
 			      ETH_MEMIF_MAC_ARG "=xx:xx:xx:xx:xx:xx"
 			      ETH_MEMIF_ZC_ARG "=yes|no"
-			      ETH_MEMIF_SECRET_ARG "=<string>");
+			      ETH_MEMIF_SECRET_ARG "=<string>"
+			      ETH_MEMIF_RX_EXTBUF_ARG "=yes|no");
 
 RTE_LOG_REGISTER(memif_logtype, pmd.net.memif, NOTICE);
@@ -13,6 +13,7 @@
 
 #include <rte_ethdev_driver.h>
 #include <rte_ether.h>
+#include <rte_mbuf.h>
 #include <rte_interrupts.h>
 
 #include "memif.h"
@@ -46,6 +47,32 @@ struct memif_region {
 	int fd;					/**< shared memory file descriptor */
 	uint32_t pkt_buffer_offset;
 	/**< offset from 'addr' to first packet buffer */
+	uint32_t refcnt;
+	/**< device and rx queues lending its buffers (extbuf mode) */
+	uint8_t extmem;				/**< registered as external memory */
+};
+
+struct memif_extbuf_ring;
+
+/** Buffer of an rx ring slot, attached to an mbuf in extbuf mode. */
+struct memif_extbuf {
+	struct rte_mbuf_ext_shared_info shinfo;	/**< attachment info */
+	struct memif_extbuf_ring *ring;		/**< owning ring */
+	uint32_t in_use;			/**< lent to the application */
+};
+
+/**
+ * Slots of an rx ring for one connection, in extbuf mode.
+ * It holds the regions mapped until the last lent buffer is freed,
+ * even if the connection is gone by then.
+ */
+struct memif_extbuf_ring {
+	uint32_t refcnt;
+	/**< buffers lent, plus one while the queue is connected */
+	uint8_t iova_va;			/**< buffers IOVA is their VA */
+	memif_region_index_t regions_num;	/**< number of regions held */
+	struct memif_region *regions[ETH_MEMIF_MAX_REGION_NUM];
+	struct memif_extbuf bufs[];		/**< one per ring slot */
 };
 
 struct memif_queue {
@@ -68,6 +95,11 @@ struct memif_queue {
 	 * mbufs to free them once master has received them.
 	 */
 
+	struct memif_extbuf_ring *extbufs;
+	/**< Buffers of the ring lent to the application in extbuf mode. */
+	uint16_t last_free;
+	/**< first slot not returned to the ring yet, in extbuf mode */
+
 	/* rx/tx info */
 	uint64_t n_pkts;			/**< number of rx/tx packets */
 	uint64_t n_bytes;			/**< number of rx/tx bytes */
@@ -89,6 +121,8 @@ struct pmd_internals {
 /**< device is zero-copy enabled */
 #define ETH_MEMIF_FLAG_DISABLED		(1 << 3)
 /**< device has not been configured and can not accept connection requests */
+#define ETH_MEMIF_FLAG_RX_EXTBUF	(1 << 4)
+/**< received packets are attached to the shared memory, not copied */
 
 	char *socket_filename;			/**< pointer to socket filename */
 	char secret[ETH_MEMIF_SECRET_SIZE]; /**< secret (optional security parameter) */
@@ -6,9 +6,12 @@
 
 #include <time.h>
 
+#include <fcntl.h>
 #include <net/if.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #if defined(RTE_EXEC_ENV_FREEBSD)
@@ -18,6 +21,7 @@
 
 #include <pcap.h>
 
+#include <rte_byteorder.h>
 #include <rte_cycles.h>
 #include <rte_ethdev_driver.h>
 #include <rte_ethdev_vdev.h>
@@ -40,6 +44,8 @@
 #define ETH_PCAP_IFACE_ARG    "iface"
 #define ETH_PCAP_PHY_MAC_ARG  "phy_mac"
 #define ETH_PCAP_INFINITE_RX_ARG  "infinite_rx"
+#define ETH_PCAP_MMAP_RX_ARG  "mmap_rx"
+#define ETH_PCAP_REPLAY_SPEED_ARG  "replay_speed"
 
 #define ETH_PCAP_ARG_MAXLEN	64
 
@@ -86,12 +92,18 @@ struct pmd_internals {
 	int single_iface;
 	int phy_mac;
 	unsigned int infinite_rx;
+	unsigned int mmap_rx;
+	/* Replay speed in percent of the capture timing, 0 to disable */
+	unsigned int replay_speed;
 };
 
+struct pcap_mmap_file;
+
 struct pmd_process_private {
 	pcap_t *rx_pcap[RTE_PMD_PCAP_MAX_QUEUES];
 	pcap_t *tx_pcap[RTE_PMD_PCAP_MAX_QUEUES];
 	pcap_dumper_t *tx_dumper[RTE_PMD_PCAP_MAX_QUEUES];
+	struct pcap_mmap_file *rx_mmap[RTE_PMD_PCAP_MAX_QUEUES];
 };
 
 struct pmd_devargs {
@@ -114,6 +126,8 @@ struct pmd_devargs_all {
 	unsigned int is_rx_pcap;
 	unsigned int is_rx_iface;
 	unsigned int infinite_rx;
+	unsigned int mmap_rx;
+	unsigned int replay_speed;
 };
 
 static const char *valid_arguments[] = {
@@ -125,6 +139,8 @@ static const char *valid_arguments[] = {
 	ETH_PCAP_IFACE_ARG,
 	ETH_PCAP_PHY_MAC_ARG,
 	ETH_PCAP_INFINITE_RX_ARG,
+	ETH_PCAP_MMAP_RX_ARG,
+	ETH_PCAP_REPLAY_SPEED_ARG,
 	NULL
 };
 
@@ -306,6 +322,435 @@ calculate_timestamp(struct timeval *ts) {
 	}
 }
 
+/* Capture file formats read by the mmap rx mode */
+#define PCAP_MAGIC_USEC		0xa1b2c3d4
+#define PCAP_MAGIC_NSEC		0xa1b23c4d
+#define PCAP_FILE_HDR_LEN	24
+#define PCAP_REC_HDR_LEN	16
+
+#define PCAPNG_BLOCK_SHB	0x0a0d0d0a
+#define PCAPNG_BLOCK_IDB	0x00000001
+#define PCAPNG_BLOCK_SPB	0x00000003
+#define PCAPNG_BLOCK_EPB	0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC	0x1a2b3c4d
+#define PCAPNG_BLOCK_MIN_LEN	12
+#define PCAPNG_IDB_MIN_LEN	20
+#define PCAPNG_SPB_MIN_LEN	16
+#define PCAPNG_EPB_MIN_LEN	32
+#define PCAPNG_OPT_END		0
+#define PCAPNG_OPT_IF_TSRESOL	9
+#define PCAPNG_MAX_IFACES	16
+
+#define USEC_PER_SEC		1000000UL
+
+/*
+ * A capture file mapped in memory. Its packets are attached to mbufs as
+ * external buffers sharing one reference count, so the file is unmapped
+ * once the queue is closed and all the mbufs are freed.
+ */
+struct pcap_mmap_file {
+	struct rte_mbuf_ext_shared_info shinfo;
+	uint8_t *base;
+	size_t size;
+	/* Offsets of the first and the next packet record or block */
+	size_t first;
+	size_t pos;
+	unsigned int pcapng;
+	unsigned int swapped;
+	/* Timestamp units per second of the file or pcapng interfaces */
+	uint64_t ts_units;
+	uint64_t if_ts_units[PCAPNG_MAX_IFACES];
+	unsigned int nb_ifaces;
+	/* Timestamp of the last packet, pcapng simple blocks have none */
+	uint64_t last_ts_ns;
+	/* Capture and TSC time of the packet replay is paced from */
+	uint64_t replay_ts_ns;
+	uint64_t replay_cycles;
+};
+
+struct pcap_mmap_pkt {
+	uint8_t *data;
+	uint32_t caplen;
+	uint64_t ts_ns;
+	/* Offset of the record or block following the packet */
+	size_t next;
+};
+
+static inline uint32_t
+pcap_mmap_read32(const struct pcap_mmap_file *f, size_t off)
+{
+	uint32_t v;
+
+	memcpy(&v, f->base + off, sizeof(v));
+	return f->swapped ? rte_bswap32(v) : v;
+}
+
+static inline uint16_t
+pcap_mmap_read16(const struct pcap_mmap_file *f, size_t off)
+{
+	uint16_t v;
+
+	memcpy(&v, f->base + off, sizeof(v));
+	return f->swapped ? rte_bswap16(v) : v;
+}
+
+static inline uint64_t
+pcap_mmap_ts_to_ns(uint64_t ts, uint64_t units)
+{
+	return ts / units * NSEC_PER_SEC + ts % units * NSEC_PER_SEC / units;
+}
+
+/* Read the timestamp resolution of a pcapng interface description block */
+static int
+pcap_mmap_parse_idb(struct pcap_mmap_file *f, size_t pos, uint32_t len)
+{
+	uint64_t units = USEC_PER_SEC;
+	size_t opt = pos + PCAPNG_IDB_MIN_LEN - sizeof(uint32_t);
+	size_t end = pos + len - sizeof(uint32_t);
+	uint16_t code, opt_len;
+	uint8_t resol;
+
+	while (opt + sizeof(uint32_t) <= end) {
+		code = pcap_mmap_read16(f, opt);
+		opt_len = pcap_mmap_read16(f, opt + sizeof(uint16_t));
+		if (code == PCAPNG_OPT_END ||
+				opt + sizeof(uint32_t) + opt_len > end)
+			break;
+		if (code == PCAPNG_OPT_IF_TSRESOL && opt_len >= 1) {
+			resol = f->base[opt + sizeof(uint32_t)];
+			/* Resolutions finer than a nanosecond are not handled */
+			if (resol & 0x80) {
+				if ((resol & 0x7f) > 30)
+					return -1;
+				units = 1ULL << (resol & 0x7f);
+			} else {
+				if (resol > 9)
+					return -1;
+				for (units = 1; resol > 0; resol--)
+					units *= 10;
+			}
+		}
+		opt += sizeof(uint32_t) + RTE_ALIGN_CEIL(opt_len, 4);
+	}
+
+	if (f->nb_ifaces < PCAPNG_MAX_IFACES)
+		f->if_ts_units[f->nb_ifaces++] = units;
+
+	return 0;
+}
+
+/*
+ * Look up the next packet of a pcapng file, processing the blocks which
+ * precede it. Return -1 at the end of the file or on a malformed block.
+ */
+static int
+pcap_mmap_peek_pcapng(struct pcap_mmap_file *f, struct pcap_mmap_pkt *pkt)
+{
+	uint64_t units;
+	uint32_t type, len, if_id, magic;
+	size_t pos = f->pos;
+
+	while (f->size - pos >= PCAPNG_BLOCK_MIN_LEN) {
+		memcpy(&type, f->base + pos, sizeof(type));
+		if (type == PCAPNG_BLOCK_SHB) {
+			/* A section header sets the byte order of the section */
+			memcpy(&magic, f->base + pos + 2 * sizeof(uint32_t),
+					sizeof(magic));
+			if (magic == PCAPNG_BYTE_ORDER_MAGIC)
+				f->swapped = 0;
+			else if (magic == rte_bswap32(PCAPNG_BYTE_ORDER_MAGIC))
+				f->swapped = 1;
+			else
+				return -1;
+			f->nb_ifaces = 0;
+		}
+		type = pcap_mmap_read32(f, pos);
+		len = pcap_mmap_read32(f, pos + sizeof(uint32_t));
+		if (len < PCAPNG_BLOCK_MIN_LEN || (len & 3) != 0 ||
+				len > f->size - pos)
+			return -1;
+
+		switch (type) {
+		case PCAPNG_BLOCK_EPB:
+			if (len < PCAPNG_EPB_MIN_LEN)
+				return -1;
+			if_id = pcap_mmap_read32(f, pos + 8);
+			pkt->caplen = pcap_mmap_read32(f, pos + 20);
+			if (pkt->caplen > len - PCAPNG_EPB_MIN_LEN)
+				return -1;
+			units = if_id < f->nb_ifaces ?
+				f->if_ts_units[if_id] : USEC_PER_SEC;
+			pkt->ts_ns = pcap_mmap_ts_to_ns(
+				(uint64_t)pcap_mmap_read32(f, pos + 12) << 32 |
+				pcap_mmap_read32(f, pos + 16), units);
+			pkt->data = f->base + pos + 28;
+			pkt->next = pos + len;
+			f->pos = pos;
+			return 0;
+		case PCAPNG_BLOCK_SPB:
+			if (len < PCAPNG_SPB_MIN_LEN)
+				return -1;
+			pkt->caplen = RTE_MIN(pcap_mmap_read32(f, pos + 8),
+					len - PCAPNG_SPB_MIN_LEN);
+			pkt->ts_ns = f->last_ts_ns;
+			pkt->data = f->base + pos + 12;
+			pkt->next = pos + len;
+			f->pos = pos;
+			return 0;
+		case PCAPNG_BLOCK_IDB:
+			if (len < PCAPNG_IDB_MIN_LEN ||
+					pcap_mmap_parse_idb(f, pos, len) < 0)
+				return -1;
+			break;
+		default:
+			break;
+		}
+		pos += len;
+	}
+
+	f->pos = pos;
+	return -1;
+}
+
+/*
+ * Look up the next packet without consuming it, so a packet which is not
+ * due yet is received by a later burst.
+ */
+static inline int
+pcap_mmap_peek(struct pcap_mmap_file *f, struct pcap_mmap_pkt *pkt)
+{
+	size_t pos = f->pos;
+
+	if (f->pcapng)
+		return pcap_mmap_peek_pcapng(f, pkt);
+
+	if (f->size - pos < PCAP_REC_HDR_LEN)
+		return -1;
+
+	pkt->caplen = pcap_mmap_read32(f, pos + 8);
+	if (pkt->caplen > f->size - pos - PCAP_REC_HDR_LEN)
+		return -1;
+
+	pkt->ts_ns = (uint64_t)pcap_mmap_read32(f, pos) * NSEC_PER_SEC +
+		(uint64_t)pcap_mmap_read32(f, pos + 4) *
+		(NSEC_PER_SEC / f->ts_units);
+	pkt->data = f->base + pos + PCAP_REC_HDR_LEN;
+	pkt->next = pos + PCAP_REC_HDR_LEN + pkt->caplen;
+
+	return 0;
+}
+
+static void
+pcap_mmap_rewind(struct pcap_mmap_file *f)
+{
+	f->pos = f->first;
+	f->last_ts_ns = 0;
+	f->replay_cycles = 0;
+	/* pcapng interfaces are described again from the file start */
+	if (f->pcapng)
+		f->nb_ifaces = 0;
+}
+
+/*
+ * Check if a packet is due, relative to the first packet received since
+ * the replay started, with inter-packet gaps scaled by the replay speed.
+ */
+static inline int
+pcap_mmap_pkt_due(struct pcap_mmap_file *f, uint64_t ts_ns, uint64_t now,
+		unsigned int speed)
+{
+	uint64_t delay_ns, delay;
+
+	if (f->replay_cycles == 0) {
+		f->replay_cycles = now;
+		f->replay_ts_ns = ts_ns;
+		return 1;
+	}
+
+	delay_ns = ts_ns > f->replay_ts_ns ? ts_ns - f->replay_ts_ns : 0;
+	delay = delay_ns / NSEC_PER_SEC * hz +
+		delay_ns % NSEC_PER_SEC * hz / NSEC_PER_SEC;
+
+	return now - f->replay_cycles >= delay * 100 / speed;
+}
+
+static void
+pcap_mmap_free_cb(void *addr __rte_unused, void *opaque)
+{
+	struct pcap_mmap_file *f = opaque;
+
+	munmap(f->base, f->size);
+	rte_free(f);
+}
+
+static int
+pcap_mmap_open(const char *pcap_filename, int read_only,
+		struct pcap_mmap_file **file)
+{
+	struct pcap_mmap_file *f;
+	struct stat st;
+	uint32_t magic;
+	void *base;
+	int fd;
+
+	fd = open(pcap_filename, O_RDONLY);
+	if (fd < 0) {
+		PMD_LOG(ERR, "Couldn't open %s: %s", pcap_filename,
+			strerror(errno));
+		return -1;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size < PCAP_FILE_HDR_LEN) {
+		PMD_LOG(ERR, "Couldn't get a capture from %s", pcap_filename);
+		close(fd);
+		return -1;
+	}
+
+	/*
+	 * Private writable mapping, so applications can modify packets.
+	 * When the file is replayed in a loop, the same data is received
+	 * again, so it is mapped read-only to keep every pass identical.
+	 */
+	base = mmap(NULL, st.st_size,
+			read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+			MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		PMD_LOG(ERR, "Couldn't map %s: %s", pcap_filename,
+			strerror(errno));
+		return -1;
+	}
+	madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+	f = rte_zmalloc(NULL, sizeof(*f), RTE_CACHE_LINE_SIZE);
+	if (f == NULL) {
+		munmap(base, st.st_size);
+		return -1;
+	}
+	f->base = base;
+	f->size = st.st_size;
+
+	memcpy(&magic, base, sizeof(magic));
+	if (magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC) {
+		f->swapped = 0;
+	} else if (magic == rte_bswap32(PCAP_MAGIC_USEC) ||
+			magic == rte_bswap32(PCAP_MAGIC_NSEC)) {
+		f->swapped = 1;
+		magic = rte_bswap32(magic);
+	} else if (magic == PCAPNG_BLOCK_SHB) {
+		f->pcapng = 1;
+	} else {
+		PMD_LOG(ERR, "Unsupported capture format in %s",
+			pcap_filename);
+		pcap_mmap_free_cb(NULL, f);
+		return -1;
+	}
+
+	if (!f->pcapng) {
+		f->ts_units = magic == PCAP_MAGIC_NSEC ?
+			NSEC_PER_SEC : USEC_PER_SEC;
+		f->first = PCAP_FILE_HDR_LEN;
+	}
+
+	f->shinfo.free_cb = pcap_mmap_free_cb;
+	f->shinfo.fcb_opaque = f;
+	rte_mbuf_ext_refcnt_set(&f->shinfo, 1);
+	pcap_mmap_rewind(f);
+
+	*file = f;
+	return 0;
+}
+
+/* Drop the queue reference, the file is unmapped with the last mbuf. */
+static void
+pcap_mmap_close(struct pcap_mmap_file *f)
+{
+	if (rte_mbuf_ext_refcnt_update(&f->shinfo, -1) == 0)
+		pcap_mmap_free_cb(NULL, f);
+}
+
+/*
+ * Receive packets from a mapped capture file without copying them, by
+ * attaching their data to mbufs as external buffers.
+ */
+static uint16_t
+eth_pcap_rx_mmap(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pcap_rx_queue *pcap_q = queue;
+	struct rte_eth_dev *dev = &rte_eth_devices[pcap_q->port_id];
+	struct pmd_process_private *pp = dev->process_private;
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int speed = internals->replay_speed;
+	struct pcap_mmap_file *f;
+	struct pcap_mmap_pkt pkt;
+	struct rte_mbuf *mbuf;
+	uint16_t num_rx = 0;
+	uint32_t rx_bytes = 0;
+	uint64_t now = 0;
+	int iova_va, progress = 1;
+
+	f = pp->rx_mmap[pcap_q->queue_id];
+	if (unlikely(f == NULL || nb_pkts == 0))
+		return 0;
+
+	/* Keep the shared reference count of the file within its range */
+	nb_pkts = RTE_MIN(nb_pkts,
+			UINT16_MAX - rte_mbuf_ext_refcnt_read(&f->shinfo));
+	if (unlikely(nb_pkts == 0))
+		return 0;
+
+	if (rte_pktmbuf_alloc_bulk(pcap_q->mb_pool, bufs, nb_pkts) != 0)
+		return 0;
+
+	if (speed != 0)
+		now = rte_get_timer_cycles();
+	iova_va = rte_eal_iova_mode() == RTE_IOVA_VA;
+
+	while (num_rx < nb_pkts) {
+		if (pcap_mmap_peek(f, &pkt) < 0) {
+			/* Stop if a whole pass over the file gave nothing */
+			if (!internals->infinite_rx || !progress)
+				break;
+			pcap_mmap_rewind(f);
+			progress = 0;
+			continue;
+		}
+
+		if (speed != 0 && !pcap_mmap_pkt_due(f, pkt.ts_ns, now, speed))
+			break;
+
+		f->pos = pkt.next;
+		f->last_ts_ns = pkt.ts_ns;
+		if (unlikely(pkt.caplen > UINT16_MAX)) {
+			pcap_q->rx_stat.err_pkts++;
+			continue;
+		}
+
+		mbuf = bufs[num_rx++];
+		rte_pktmbuf_attach_extbuf(mbuf, pkt.data,
+				iova_va ? (rte_iova_t)(uintptr_t)pkt.data :
+				RTE_BAD_IOVA, (uint16_t)pkt.caplen, &f->shinfo);
+		mbuf->data_len = (uint16_t)pkt.caplen;
+		mbuf->pkt_len = pkt.caplen;
+		mbuf->timestamp = pkt.ts_ns / (NSEC_PER_SEC / USEC_PER_SEC);
+		mbuf->ol_flags |= PKT_RX_TIMESTAMP;
+		mbuf->port = pcap_q->port_id;
+		rx_bytes += pkt.caplen;
+		progress = 1;
+	}
+
+	if (num_rx > 0)
+		rte_mbuf_ext_refcnt_update(&f->shinfo, num_rx);
+	if (num_rx < nb_pkts)
+		rte_mempool_put_bulk(pcap_q->mb_pool, (void **)&bufs[num_rx],
+				nb_pkts - num_rx);
+
+	pcap_q->rx_stat.pkts += num_rx;
+	pcap_q->rx_stat.bytes += rx_bytes;
+
+	return num_rx;
+}
+
 /*
  * Callback to handle writing packets to a pcap file.
  */
@@ -590,6 +1035,12 @@ eth_dev_start(struct rte_eth_dev *dev)
 		}
 	}
 
+	/* Mapped capture files are replayed from their start */
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		if (pp->rx_mmap[i] != NULL)
+			pcap_mmap_rewind(pp->rx_mmap[i]);
+	}
+
 status_up:
 	for (i = 0; i < dev->data->nb_rx_queues; i++)
 		dev->data->rx_queue_state[i] = RTE_ETH_QUEUE_STATE_STARTED;
@@ -733,9 +1184,17 @@ eth_dev_close(struct rte_eth_dev *dev)
 {
 	unsigned int i;
 	struct pmd_internals *internals = dev->data->dev_private;
+	struct pmd_process_private *pp = dev->process_private;
+
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		if (pp->rx_mmap[i] != NULL) {
+			pcap_mmap_close(pp->rx_mmap[i]);
+			pp->rx_mmap[i] = NULL;
+		}
+	}
 
 	/* Device wide flag, but cleanup must be performed per queue. */
-	if (internals->infinite_rx) {
+	if (internals->infinite_rx && !internals->mmap_rx) {
 		for (i = 0; i < dev->data->nb_rx_queues; i++) {
 			struct pcap_rx_queue *pcap_q = &internals->rx_queue[i];
 			struct rte_mbuf *pcap_buf;
@@ -778,7 +1237,8 @@ eth_rx_queue_setup(struct rte_eth_dev *dev,
 	pcap_q->queue_id = rx_queue_id;
 	dev->data->rx_queues[rx_queue_id] = pcap_q;
 
-	if (internals->infinite_rx) {
+	/* The mmap rx mode loops over the mapped file instead of a ring. */
+	if (internals->infinite_rx && !internals->mmap_rx) {
 		struct pmd_process_private *pp;
 		char ring_name[NAME_MAX];
 		static uint32_t ring_number;
@@ -1082,6 +1542,35 @@ get_infinite_rx_arg(const char *key __rte_unused,
 	return 0;
 }
 
+static int
+get_mmap_rx_arg(const char *key __rte_unused,
+		const char *value, void *extra_args)
+{
+	if (extra_args) {
+		const int mmap_rx = atoi(value);
+		int *enable_mmap_rx = extra_args;
+
+		if (mmap_rx > 0)
+			*enable_mmap_rx = 1;
+	}
+	return 0;
+}
+
+static int
+get_replay_speed_arg(const char *key __rte_unused,
+		const char *value, void *extra_args)
+{
+	if (extra_args) {
+		const int replay_speed = atoi(value);
+		unsigned int *speed = extra_args;
+
+		if (replay_speed < 0)
+			return -1;
+		*speed = replay_speed;
+	}
+	return 0;
+}
+
 static int
 pmd_init_internals(struct rte_vdev_device *vdev,
 		const unsigned int nb_rx_queues,
@@ -1281,6 +1770,9 @@ eth_from_pcaps(struct rte_vdev_device *vdev,
 	struct pmd_devargs *rx_queues = &devargs_all->rx_queues;
 	int single_iface = devargs_all->single_iface;
 	unsigned int infinite_rx = devargs_all->infinite_rx;
+	unsigned int mmap_rx = devargs_all->mmap_rx;
+	struct pmd_process_private *pp;
+	unsigned int i;
 	int ret;
 
 	ret = eth_from_pcaps_common(vdev, devargs_all, &internals, &eth_dev);
@@ -1288,6 +1780,22 @@ eth_from_pcaps(struct rte_vdev_device *vdev,
 	if (ret < 0)
 		return ret;
 
+	pp = eth_dev->process_private;
+	for (i = 0; mmap_rx && i < rx_queues->num_of_queue; i++) {
+		if (pcap_mmap_open(rx_queues->queue[i].name, infinite_rx,
+				&pp->rx_mmap[i]) < 0) {
+			/* close the pcaps and unmap the files opened so far */
+			eth_dev_stop(eth_dev);
+			eth_dev_close(eth_dev);
+			/* not dynamically allocated, must not be freed */
+			eth_dev->data->mac_addrs = NULL;
+			rte_free(pp);
+			eth_dev->process_private = NULL;
+			rte_eth_dev_release_port(eth_dev);
+			return -1;
+		}
+	}
+
 	/* store weather we are using a single interface for rx/tx or not */
 	internals->single_iface = single_iface;
 
@@ -1304,8 +1812,12 @@ eth_from_pcaps(struct rte_vdev_device *vdev,
 	}
 
 	internals->infinite_rx = infinite_rx;
+	internals->mmap_rx = mmap_rx;
+	internals->replay_speed = devargs_all->replay_speed;
 	/* Assign rx ops. */
-	if (infinite_rx)
+	if (mmap_rx)
+		eth_dev->rx_pkt_burst = eth_pcap_rx_mmap;
+	else if (infinite_rx)
 		eth_dev->rx_pkt_burst = eth_pcap_rx_infinite;
 	else if (devargs_all->is_rx_pcap || devargs_all->is_rx_iface ||
 			single_iface)
@@ -1341,6 +1853,8 @@ pmd_pcap_probe(struct rte_vdev_device *dev)
 		.is_tx_pcap = 0,
 		.is_tx_iface = 0,
 		.infinite_rx = 0,
+		.mmap_rx = 0,
+		.replay_speed = 0,
 	};
 
 	name = rte_vdev_device_name(dev);
@@ -1436,6 +1950,36 @@ pmd_pcap_probe(struct rte_vdev_device *dev)
 					"for %s", name);
 		}
 
+		/*
+		 * We check whether we want to receive from the mapped pcap
+		 * files without copying, optionally at the capture pace.
+		 */
+		if (rte_kvargs_count(kvlist, ETH_PCAP_MMAP_RX_ARG) == 1) {
+			ret = rte_kvargs_process(kvlist, ETH_PCAP_MMAP_RX_ARG,
+					&get_mmap_rx_arg,
+					&devargs_all.mmap_rx);
+			if (ret < 0)
+				goto free_kvlist;
+			PMD_LOG(INFO, "mmap_rx has been %s for %s",
+					devargs_all.mmap_rx ? "enabled" : "disabled",
+					name);
+		}
+
+		if (rte_kvargs_count(kvlist, ETH_PCAP_REPLAY_SPEED_ARG) == 1) {
+			ret = rte_kvargs_process(kvlist,
+					ETH_PCAP_REPLAY_SPEED_ARG,
+					&get_replay_speed_arg,
+					&devargs_all.replay_speed);
+			if (ret < 0)
+				goto free_kvlist;
+			if (!devargs_all.mmap_rx &&
+					devargs_all.replay_speed != 0) {
+				PMD_LOG(WARNING, "replay_speed is only used with mmap_rx for %s",
+						name);
+				devargs_all.replay_speed = 0;
+			}
+		}
+
 		ret = rte_kvargs_process(kvlist, ETH_PCAP_RX_PCAP_ARG,
 				&open_rx_pcap, &pcaps);
 	} else if (devargs_all.is_rx_iface) {
@@ -1587,4 +2131,6 @@ RTE_PMD_REGISTER_PARAM_STRING(net_pcap,
 	ETH_PCAP_TX_IFACE_ARG "=<ifc> "
 	ETH_PCAP_IFACE_ARG "=<ifc> "
 	ETH_PCAP_PHY_MAC_ARG "=<int>"
-	ETH_PCAP_INFINITE_RX_ARG "=<0|1>");
+	ETH_PCAP_INFINITE_RX_ARG "=<0|1> "
+	ETH_PCAP_MMAP_RX_ARG "=<0|1> "
+	ETH_PCAP_REPLAY_SPEED_ARG "=<int>");
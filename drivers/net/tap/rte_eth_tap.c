@@ -54,6 +54,8 @@
 #define ETH_TAP_REMOTE_ARG      "remote"
 #define ETH_TAP_MAC_ARG         "mac"
 #define ETH_TAP_MAC_FIXED       "fixed"
+#define ETH_TAP_VNET_HDR_ARG    "vnet_hdr"
+#define ETH_TAP_NAPI_ARG        "napi"
 
 #define ETH_TAP_USR_MAC_FMT     "xx:xx:xx:xx:xx:xx"
 #define ETH_TAP_CMP_MAC_FMT     "0123456789ABCDEFabcdef"
@@ -70,12 +72,21 @@
 
 #define TAP_IOV_DEFAULT_MAX 1024
 
+/* Largest frame the kernel takes or gives with a virtio-net header */
+#define TAP_VNET_MAX_PKT_SIZE (RTE_ETHER_HDR_LEN + UINT16_MAX)
+
+#ifndef IFF_NAPI
+#define IFF_NAPI 0x0010
+#endif
+
 static int tap_devices_count;
 
 static const char *valid_arguments[] = {
 	ETH_TAP_IFACE_ARG,
 	ETH_TAP_REMOTE_ARG,
 	ETH_TAP_MAC_ARG,
+	ETH_TAP_VNET_HDR_ARG,
+	ETH_TAP_NAPI_ARG,
 	NULL
 };
 
@@ -144,6 +155,7 @@ tun_alloc(struct pmd_internals *pmd, int is_keepalive)
 	 */
 	ifr.ifr_flags = (pmd->type == ETH_TUNTAP_TYPE_TAP) ?
 		IFF_TAP : IFF_TUN | IFF_POINTOPOINT;
+	ifr.ifr_flags |= pmd->tun_flags;
 	strlcpy(ifr.ifr_name, pmd->name, IFNAMSIZ);
 
 	fd = open(TUN_TAP_DEV_PATH, O_RDWR);
@@ -306,6 +318,9 @@ tap_verify_csum(struct rte_mbuf *mbuf)
 		/* IPv6 extensions are not supported */
 		return;
 	}
+	/* Already known from the virtio-net header */
+	if (mbuf->ol_flags & PKT_RX_L4_CKSUM_MASK)
+		return;
 	if (l4 == RTE_PTYPE_L4_UDP || l4 == RTE_PTYPE_L4_TCP) {
 		l4_hdr = rte_pktmbuf_mtod_offset(mbuf, void *, l2_len + l3_len);
 		/* Don't verify checksum for multi-segment packets. */
@@ -339,6 +354,23 @@ tap_rx_offload_get_queue_capa(void)
 	       DEV_RX_OFFLOAD_TCP_CKSUM;
 }
 
+/* Rx offload flags from the virtio-net header in front of a packet */
+static void
+tap_rx_vnet_hdr(struct rte_mbuf *mbuf, const struct virtio_net_hdr *hdr)
+{
+	/* Data is valid but the L4 checksum holds the pseudo-header sum */
+	if (hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)
+		mbuf->ol_flags |= PKT_RX_L4_CKSUM_NONE;
+	else if (hdr->flags & VIRTIO_NET_HDR_F_DATA_VALID)
+		mbuf->ol_flags |= PKT_RX_L4_CKSUM_GOOD;
+
+	/* Coalesced by the kernel, only with TUNSETOFFLOAD */
+	if (hdr->gso_type != VIRTIO_NET_HDR_GSO_NONE) {
+		mbuf->ol_flags |= PKT_RX_LRO;
+		mbuf->tso_segsz = hdr->gso_size;
+	}
+}
+
 static void
 tap_rxq_pool_free(struct rte_mbuf *pool)
 {
@@ -381,9 +413,10 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 
 		len = readv(process_private->rxq_fds[rxq->queue_id],
 			*rxq->iovecs,
-			1 + (rxq->rxmode->offloads & DEV_RX_OFFLOAD_SCATTER ?
-			     rxq->nb_rx_desc : 1));
-		if (len < (int)sizeof(struct tun_pi))
+			rxq->hdr_iovs +
+			(rxq->rxmode->offloads & DEV_RX_OFFLOAD_SCATTER ?
+			 rxq->nb_rx_desc : 1));
+		if (len < rxq->hdr_len)
 			break;
 
 		/* Packet couldn't fit in the provided mbuf */
@@ -392,7 +425,7 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 			continue;
 		}
 
-		len -= sizeof(struct tun_pi);
+		len -= rxq->hdr_len;
 
 		mbuf->pkt_len = len;
 		mbuf->port = rxq->in_port;
@@ -418,11 +451,14 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 			new_tail = buf;
 			new_tail->next = seg->next;
 
-			/* iovecs[0] is reserved for packet info (pi) */
-			(*rxq->iovecs)[mbuf->nb_segs].iov_len =
-				buf->buf_len - data_off;
-			(*rxq->iovecs)[mbuf->nb_segs].iov_base =
-				(char *)buf->buf_addr + data_off;
+			/*
+			 * iovecs[0] is reserved for packet info (pi),
+			 * iovecs[1] for the virtio-net header if any.
+			 */
+			(*rxq->iovecs)[mbuf->nb_segs + rxq->hdr_iovs - 1]
+				.iov_len = buf->buf_len - data_off;
+			(*rxq->iovecs)[mbuf->nb_segs + rxq->hdr_iovs - 1]
+				.iov_base = (char *)buf->buf_addr + data_off;
 
 			seg->data_len = RTE_MIN(seg->buf_len - data_off, len);
 			seg->data_off = data_off;
@@ -437,6 +473,8 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 		seg->next = NULL;
 		mbuf->packet_type = rte_net_get_ptype(mbuf, NULL,
 						      RTE_PTYPE_ALL_MASK);
+		if (rxq->hdr_iovs > 1)
+			tap_rx_vnet_hdr(mbuf, &rxq->vnet_hdr);
 		if (rxq->rxmode->offloads & DEV_RX_OFFLOAD_CHECKSUM)
 			tap_verify_csum(mbuf);
 
@@ -538,6 +576,60 @@ tap_tx_l3_cksum(char *packet, uint64_t ol_flags, unsigned int l2_len,
 	}
 }
 
+/*
+ * Leave the L4 checksum, and TCP segmentation if requested, to the kernel:
+ * the checksum field gets the pseudo header sum and the virtio-net header
+ * tells where to complete it.
+ */
+static void
+tap_tx_vnet_offload(struct virtio_net_hdr *hdr, char *packet,
+		    const struct rte_mbuf *mbuf, uint16_t *l4_cksum)
+{
+	uint64_t ol_flags = mbuf->ol_flags;
+	void *l3_hdr = packet + mbuf->l2_len;
+	uint32_t cksum;
+	uint16_t l4_len;
+
+	/*
+	 * Pseudo header sum on the L4 length of this (super) frame.
+	 * Out of TSO, the length is taken from the IP header, as the
+	 * frame may carry Ethernet padding.
+	 */
+	if (ol_flags & PKT_TX_TCP_SEG)
+		l4_len = rte_pktmbuf_pkt_len(mbuf) -
+			mbuf->l2_len - mbuf->l3_len;
+	else if (ol_flags & PKT_TX_IPV4)
+		l4_len = rte_be_to_cpu_16(((struct rte_ipv4_hdr *)
+			l3_hdr)->total_length) - mbuf->l3_len;
+	else
+		l4_len = rte_be_to_cpu_16(((struct rte_ipv6_hdr *)
+			l3_hdr)->payload_len) -
+			(mbuf->l3_len - sizeof(struct rte_ipv6_hdr));
+
+	if (ol_flags & PKT_TX_IPV4)
+		cksum = rte_ipv4_phdr_cksum(l3_hdr, PKT_TX_TCP_SEG);
+	else
+		cksum = rte_ipv6_phdr_cksum(l3_hdr, PKT_TX_TCP_SEG);
+	cksum += rte_cpu_to_be_16(l4_len);
+	cksum = ((cksum & 0xffff0000) >> 16) + (cksum & 0xffff);
+	cksum = ((cksum & 0xffff0000) >> 16) + (cksum & 0xffff);
+	*l4_cksum = (uint16_t)cksum;
+
+	hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+	hdr->csum_start = mbuf->l2_len + mbuf->l3_len;
+	if ((ol_flags & PKT_TX_L4_MASK) == PKT_TX_UDP_CKSUM)
+		hdr->csum_offset = offsetof(struct rte_udp_hdr, dgram_cksum);
+	else
+		hdr->csum_offset = offsetof(struct rte_tcp_hdr, cksum);
+
+	if (ol_flags & PKT_TX_TCP_SEG) {
+		hdr->gso_type = (ol_flags & PKT_TX_IPV4) ?
+			VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+		hdr->gso_size = mbuf->tso_segsz;
+		hdr->hdr_len = mbuf->l2_len + mbuf->l3_len + mbuf->l4_len;
+	}
+}
+
 static inline int
 tap_write_mbufs(struct tx_queue *txq, uint16_t num_mbufs,
 			struct rte_mbuf **pmbufs,
@@ -551,8 +643,9 @@ tap_write_mbufs(struct tx_queue *txq, uint16_t num_mbufs,
 
 	for (i = 0; i < num_mbufs; i++) {
 		struct rte_mbuf *mbuf = pmbufs[i];
-		struct iovec iovecs[mbuf->nb_segs + 2];
+		struct iovec iovecs[mbuf->nb_segs + 3];
 		struct tun_pi pi = { .flags = 0, .proto = 0x00 };
+		struct virtio_net_hdr vnet_hdr;
 		struct rte_mbuf *seg = mbuf;
 		char m_copy[mbuf->data_len];
 		int proto;
@@ -591,8 +684,15 @@ tap_write_mbufs(struct tx_queue *txq, uint16_t num_mbufs,
 		iovecs[k].iov_base = &pi;
 		iovecs[k].iov_len = sizeof(pi);
 		k++;
+		if (txq->vnet) {
+			memset(&vnet_hdr, 0, sizeof(vnet_hdr));
+			iovecs[k].iov_base = &vnet_hdr;
+			iovecs[k].iov_len = sizeof(vnet_hdr);
+			k++;
+		}
 
-		nb_segs = mbuf->nb_segs;
+		/* last index in iovecs for the segments */
+		nb_segs = mbuf->nb_segs + k - 1;
 		if (txq->csum &&
 		    ((mbuf->ol_flags & (PKT_TX_IP_CKSUM | PKT_TX_IPV4) ||
 		     (mbuf->ol_flags & PKT_TX_L4_MASK) == PKT_TX_UDP_CKSUM ||
@@ -616,6 +716,11 @@ tap_write_mbufs(struct tx_queue *txq, uint16_t num_mbufs,
 				       mbuf->l2_len, mbuf->l3_len, mbuf->l4_len,
 				       &l4_cksum, &l4_phdr_cksum,
 				       &l4_raw_cksum);
+			if (txq->vnet && l4_cksum) {
+				tap_tx_vnet_offload(&vnet_hdr, m_copy, mbuf,
+						    l4_cksum);
+				l4_cksum = NULL;
+			}
 			iovecs[k].iov_base = m_copy;
 			iovecs[k].iov_len = l234_hlen;
 			k++;
@@ -687,7 +792,19 @@ pmd_tx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 		uint64_t tso;
 
 		tso = mbuf_in->ol_flags & PKT_TX_TCP_SEG;
-		if (tso) {
+		if (tso && txq->vnet) {
+			/* the kernel segments it, send as is */
+			mbuf_in->ol_flags |= PKT_TX_TCP_CKSUM;
+			if (unlikely(mbuf_in->tso_segsz == 0 ||
+				     rte_pktmbuf_pkt_len(mbuf_in) >
+				     TAP_VNET_MAX_PKT_SIZE)) {
+				txq->stats.errs++;
+				break;
+			}
+			num_tso_mbufs = 0;
+			mbuf = &mbuf_in;
+			num_mbufs = 1;
+		} else if (tso) {
 			struct rte_gso_ctx *gso_ctx = &txq->gso_ctx;
 
 			/* TCP segmentation implies TCP checksum offload */
@@ -959,6 +1076,10 @@ tap_dev_info(struct rte_eth_dev *dev, struct rte_eth_dev_info *dev_info)
 	dev_info->tx_queue_offload_capa = tap_tx_offload_get_queue_capa();
 	dev_info->tx_offload_capa = tap_tx_offload_get_port_capa() |
 				    dev_info->tx_queue_offload_capa;
+	if (internals->tun_flags & IFF_VNET_HDR) {
+		dev_info->rx_offload_capa |= DEV_RX_OFFLOAD_TCP_LRO;
+		dev_info->max_lro_pkt_size = TAP_VNET_MAX_PKT_SIZE;
+	}
 	dev_info->hash_key_size = TAP_RSS_HASH_KEY_SIZE;
 	/*
 	 * limitation: TAP supports all of IP, UDP and TCP hash
@@ -1440,8 +1561,11 @@ tap_rx_queue_setup(struct rte_eth_dev *dev,
 			TAP_IOV_DEFAULT_MAX);
 		iov_max = TAP_IOV_DEFAULT_MAX;
 	}
-	uint16_t nb_desc = RTE_MIN(nb_rx_desc, iov_max - 1);
-	struct iovec (*iovecs)[nb_desc + 1];
+	/* packet info (pi), then virtio-net header if enabled */
+	uint16_t hdr_iovs = (internals->tun_flags & IFF_VNET_HDR) ? 2 : 1;
+	uint16_t nb_desc = RTE_MIN(nb_rx_desc, iov_max - hdr_iovs);
+	struct iovec (*iovecs)[nb_desc + hdr_iovs];
+	uint64_t offloads = dev->data->dev_conf.rxmode.offloads;
 	int data_off = RTE_PKTMBUF_HEADROOM;
 	int ret = 0;
 	int fd;
@@ -1453,12 +1577,22 @@ tap_rx_queue_setup(struct rte_eth_dev *dev,
 			dev->data->nb_rx_queues);
 		return -1;
 	}
+	if ((offloads & DEV_RX_OFFLOAD_TCP_LRO) &&
+	    !(offloads & DEV_RX_OFFLOAD_SCATTER)) {
+		TAP_LOG(ERR, "%s: LRO needs scattered Rx",
+			dev->device->name);
+		return -EINVAL;
+	}
 
 	rxq->mp = mp;
 	rxq->trigger_seen = 1; /* force initial burst */
 	rxq->in_port = dev->data->port_id;
 	rxq->queue_id = rx_queue_id;
 	rxq->nb_rx_desc = nb_desc;
+	rxq->hdr_iovs = hdr_iovs;
+	rxq->hdr_len = sizeof(struct tun_pi);
+	if (hdr_iovs > 1)
+		rxq->hdr_len += sizeof(struct virtio_net_hdr);
 	iovecs = rte_zmalloc_socket(dev->device->name, sizeof(*iovecs), 0,
 				    socket_id);
 	if (!iovecs) {
@@ -1478,8 +1612,23 @@ tap_rx_queue_setup(struct rte_eth_dev *dev,
 
 	(*rxq->iovecs)[0].iov_len = sizeof(struct tun_pi);
 	(*rxq->iovecs)[0].iov_base = &rxq->pi;
+	if (hdr_iovs > 1) {
+		(*rxq->iovecs)[1].iov_len = sizeof(struct virtio_net_hdr);
+		(*rxq->iovecs)[1].iov_base = &rxq->vnet_hdr;
+
+		/* Let the kernel hand over partial checksums and LRO */
+		ret = ioctl(fd, TUNSETOFFLOAD,
+			    (offloads & DEV_RX_OFFLOAD_TCP_LRO) ?
+			    TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6 : 0);
+		if (ret < 0) {
+			TAP_LOG(ERR, "%s: TUNSETOFFLOAD failed: %s",
+				dev->device->name, strerror(errno));
+			ret = -errno;
+			goto error;
+		}
+	}
 
-	for (i = 1; i <= nb_desc; i++) {
+	for (i = hdr_iovs; i < nb_desc + hdr_iovs; i++) {
 		*tmp = rte_pktmbuf_alloc(rxq->mp);
 		if (!*tmp) {
 			TAP_LOG(WARNING,
@@ -1528,12 +1677,14 @@ tap_tx_queue_setup(struct rte_eth_dev *dev,
 	txq = dev->data->tx_queues[tx_queue_id];
 	txq->out_port = dev->data->port_id;
 	txq->queue_id = tx_queue_id;
+	txq->vnet = !!(internals->tun_flags & IFF_VNET_HDR);
 
 	offloads = tx_conf->offloads | dev->data->dev_conf.txmode.offloads;
 	txq->csum = !!(offloads &
 			(DEV_TX_OFFLOAD_IPV4_CKSUM |
 			 DEV_TX_OFFLOAD_UDP_CKSUM |
-			 DEV_TX_OFFLOAD_TCP_CKSUM));
+			 DEV_TX_OFFLOAD_TCP_CKSUM |
+			 (txq->vnet ? DEV_TX_OFFLOAD_TCP_TSO : 0)));
 
 	ret = tap_setup_queue(dev, internals, tx_queue_id, 0);
 	if (ret == -1)
@@ -1807,7 +1958,7 @@ static const char *tuntap_types[ETH_TUNTAP_TYPE_MAX] = {
 static int
 eth_dev_tap_create(struct rte_vdev_device *vdev, const char *tap_name,
 		   char *remote_iface, struct rte_ether_addr *mac_addr,
-		   enum rte_tuntap_type type)
+		   enum rte_tuntap_type type, unsigned int tun_flags)
 {
 	int numa_node = rte_socket_id();
 	struct rte_eth_dev *dev;
@@ -1840,6 +1991,7 @@ eth_dev_tap_create(struct rte_vdev_device *vdev, const char *tap_name,
 	pmd->dev = dev;
 	strlcpy(pmd->name, tap_name, sizeof(pmd->name));
 	pmd->type = type;
+	pmd->tun_flags = tun_flags;
 	pmd->ka_fd = -1;
 	pmd->nlsk_fd = -1;
 
@@ -2142,6 +2294,25 @@ set_mac_type(const char *key __rte_unused,
 	return -1;
 }
 
+static int
+set_tun_flag(const char *key, const char *value, void *extra_args)
+{
+	unsigned int *tun_flags = extra_args;
+	unsigned int flag;
+
+	flag = strcmp(key, ETH_TAP_NAPI_ARG) == 0 ? IFF_NAPI : IFF_VNET_HDR;
+	if (value && strcmp(value, "1") == 0) {
+		*tun_flags |= flag;
+	} else if (value && strcmp(value, "0") == 0) {
+		*tun_flags &= ~flag;
+	} else {
+		TAP_LOG(ERR, "Invalid %s value (%s), expected 0 or 1",
+			key, value ? value : "");
+		return -1;
+	}
+	return 0;
+}
+
 /*
  * Open a TUN interface device. TUN PMD
  * 1) sets tap_type as false
@@ -2157,6 +2328,7 @@ rte_pmd_tun_probe(struct rte_vdev_device *dev)
 	char tun_name[RTE_ETH_NAME_MAX_LEN];
 	char remote_iface[RTE_ETH_NAME_MAX_LEN];
 	struct rte_eth_dev *eth_dev;
+	unsigned int tun_flags = 0;
 
 	name = rte_vdev_device_name(dev);
 	params = rte_vdev_device_args(dev);
@@ -2192,6 +2364,17 @@ rte_pmd_tun_probe(struct rte_vdev_device *dev)
 				if (ret == -1)
 					goto leave;
 			}
+
+			ret = rte_kvargs_process(kvlist, ETH_TAP_VNET_HDR_ARG,
+						 &set_tun_flag, &tun_flags);
+			if (ret == 0)
+				ret = rte_kvargs_process(kvlist,
+					ETH_TAP_NAPI_ARG,
+					&set_tun_flag, &tun_flags);
+			if (ret < 0) {
+				ret = -1;
+				goto leave;
+			}
 		}
 	}
 	pmd_link.link_speed = ETH_SPEED_NUM_10G;
@@ -2199,7 +2382,7 @@ rte_pmd_tun_probe(struct rte_vdev_device *dev)
 	TAP_LOG(DEBUG, "Initializing pmd_tun for %s", name);
 
 	ret = eth_dev_tap_create(dev, tun_name, remote_iface, 0,
-				 ETH_TUNTAP_TYPE_TUN);
+				 ETH_TUNTAP_TYPE_TUN, tun_flags);
 
 leave:
 	if (ret == -1) {
@@ -2332,6 +2515,7 @@ rte_pmd_tap_probe(struct rte_vdev_device *dev)
 	struct rte_ether_addr user_mac = { .addr_bytes = {0} };
 	struct rte_eth_dev *eth_dev;
 	int tap_devices_count_increased = 0;
+	unsigned int tun_flags = 0;
 
 	name = rte_vdev_device_name(dev);
 	params = rte_vdev_device_args(dev);
@@ -2405,6 +2589,17 @@ rte_pmd_tap_probe(struct rte_vdev_device *dev)
 				if (ret == -1)
 					goto leave;
 			}
+
+			ret = rte_kvargs_process(kvlist, ETH_TAP_VNET_HDR_ARG,
+						 &set_tun_flag, &tun_flags);
+			if (ret == 0)
+				ret = rte_kvargs_process(kvlist,
+					ETH_TAP_NAPI_ARG,
+					&set_tun_flag, &tun_flags);
+			if (ret < 0) {
+				ret = -1;
+				goto leave;
+			}
 		}
 	}
 	pmd_link.link_speed = speed;
@@ -2423,7 +2618,7 @@ rte_pmd_tap_probe(struct rte_vdev_device *dev)
 	tap_devices_count++;
 	tap_devices_count_increased = 1;
 	ret = eth_dev_tap_create(dev, tap_name, remote_iface, &user_mac,
-		ETH_TUNTAP_TYPE_TAP);
+		ETH_TUNTAP_TYPE_TAP, tun_flags);
 
 leave:
 	if (ret == -1) {
@@ -2489,9 +2684,13 @@ RTE_PMD_REGISTER_VDEV(net_tap, pmd_tap_drv);
 RTE_PMD_REGISTER_VDEV(net_tun, pmd_tun_drv);
 RTE_PMD_REGISTER_ALIAS(net_tap, eth_tap);
 RTE_PMD_REGISTER_PARAM_STRING(net_tun,
-			      ETH_TAP_IFACE_ARG "=<string> ");
+			      ETH_TAP_IFACE_ARG "=<string> "
+			      ETH_TAP_VNET_HDR_ARG "=<0|1> "
+			      ETH_TAP_NAPI_ARG "=<0|1>");
 RTE_PMD_REGISTER_PARAM_STRING(net_tap,
 			      ETH_TAP_IFACE_ARG "=<string> "
 			      ETH_TAP_MAC_ARG "=" ETH_TAP_MAC_ARG_FMT " "
-			      ETH_TAP_REMOTE_ARG "=<string>");
+			      ETH_TAP_REMOTE_ARG "=<string> "
+			      ETH_TAP_VNET_HDR_ARG "=<0|1> "
+			      ETH_TAP_NAPI_ARG "=<0|1>");
 RTE_LOG_REGISTER(tap_logtype, pmd.net.tap, NOTICE);
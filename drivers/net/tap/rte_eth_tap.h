@@ -12,6 +12,7 @@
 #include <net/if.h>
 
 #include <linux/if_tun.h>
+#include <linux/virtio_net.h>
 
 #include <rte_ethdev_driver.h>
 #include <rte_ether.h>
@@ -53,12 +54,16 @@ struct rx_queue {
 	struct rte_mbuf *pool;          /* mbufs pool for this queue */
 	struct iovec (*iovecs)[];       /* descriptors for this queue */
 	struct tun_pi pi;               /* packet info for iovecs */
+	struct virtio_net_hdr vnet_hdr; /* virtio-net header for iovecs */
+	uint16_t hdr_iovs;              /* iovecs before packet data */
+	uint16_t hdr_len;               /* bytes before packet data */
 };
 
 struct tx_queue {
 	int type;                       /* Type field - TUN|TAP */
 	uint16_t *mtu;                  /* Pointer to MTU from dev_data */
 	uint16_t csum:1;                /* Enable checksum offloading */
+	uint16_t vnet:1;                /* Prepend virtio-net header */
 	struct pkt_stats stats;         /* Stats for this TX queue */
 	struct rte_gso_ctx gso_ctx;     /* GSO context */
 	uint16_t out_port;              /* Port ID */
@@ -70,6 +75,7 @@ struct pmd_internals {
 	char remote_iface[RTE_ETH_NAME_MAX_LEN]; /* Remote netdevice name */
 	char name[RTE_ETH_NAME_MAX_LEN];  /* Internal Tap device name */
 	int type;                         /* Type field - TUN|TAP */
+	unsigned int tun_flags;           /* Optional IFF_* flags (vnet, napi) */
 	struct rte_ether_addr eth_addr;   /* Mac address of the device port */
 	struct ifreq remote_initial_flags;/* Remote netdevice flags on init */
 	int remote_if_index;              /* remote netdevice IF_INDEX */
@@ -0,0 +1,1462 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <rte_string_fns.h>
+#include <rte_mbuf.h>
+#include <rte_ethdev_driver.h>
+#include <rte_ethdev_vdev.h>
+#include <rte_malloc.h>
+#include <rte_kvargs.h>
+#include <rte_bus_vdev.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/io_uring.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ETH_URING_IFACE_ARG		"iface"
+#define ETH_URING_NUM_Q_ARG		"qpairs"
+#define ETH_URING_RX_FILE_ARG		"rx_file"
+#define ETH_URING_TX_FILE_ARG		"tx_file"
+#define ETH_URING_FRAMESIZE_ARG		"framesz"
+#define ETH_URING_SQPOLL_ARG		"sqpoll"
+
+#define URING_MAX_QUEUES	16
+#define URING_MAX_DESC		4096
+#define URING_MAX_REGIONS	64
+#define URING_TX_MAX_SEGS	16
+#define URING_SQPOLL_IDLE_MS	100
+
+/* user_data of cancel requests, slots use their index */
+#define URING_CANCEL_TAG	UINT64_MAX
+/* results of a slot whose read is in flight, or not queued yet */
+#define URING_INFLIGHT		INT32_MIN
+#define URING_IDLE		(INT32_MIN + 1)
+
+#ifndef PACKET_IGNORE_OUTGOING
+#define PACKET_IGNORE_OUTGOING	23
+#endif
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup	425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter	426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register	427
+#endif
+
+/* Submission and completion rings shared with the kernel */
+struct uring {
+	int fd;
+	unsigned int setup_flags;
+
+	uint32_t *sq_head;
+	uint32_t *sq_tail;
+	uint32_t *sq_flags;
+	uint32_t sq_mask;
+	uint32_t sq_entries;
+	uint32_t sqe_tail;       /* next SQE to fill */
+	uint32_t sqe_submitted;  /* SQEs handed to the kernel */
+	struct io_uring_sqe *sqes;
+
+	uint32_t *cq_head;
+	uint32_t *cq_tail;
+	uint32_t cq_mask;
+	struct io_uring_cqe *cqes;
+
+	void *sq_map;
+	size_t sq_map_sz;
+	void *cq_map;
+	size_t cq_map_sz;
+	size_t sqes_sz;
+};
+
+/* Buffers registered with a ring for fixed reads and writes */
+struct uring_regions {
+	unsigned int nb;
+	struct iovec iov[URING_MAX_REGIONS];
+};
+
+struct pkt_rx_queue {
+	struct uring ring;
+	int fd;
+	int is_file;
+	unsigned int framesize;  /* bytes per read, files only */
+	uint64_t offset;         /* next read offset, files only */
+
+	struct rte_mempool *mb_pool;
+	struct uring_regions regions;
+	int fixed;               /* regions are registered */
+
+	uint16_t nb_desc;
+	uint16_t head;           /* next slot to hand out */
+	uint16_t nb_inflight;
+	struct rte_mbuf **bufs;  /* one mbuf per read slot */
+	int32_t *res;            /* read result per slot */
+	struct iovec *iovs;      /* per slot, without fixed buffers */
+
+	uint16_t in_port;
+
+	volatile unsigned long rx_pkts;
+	volatile unsigned long rx_bytes;
+	volatile unsigned long rx_nombuf;
+	volatile unsigned long err_pkts;
+};
+
+struct pkt_tx_queue {
+	struct uring ring;
+	int fd;
+	int is_file;
+	uint64_t offset;         /* next write offset, files only */
+
+	const struct uring_regions *regions;
+
+	uint16_t nb_desc;
+	uint16_t nb_free;
+	uint16_t *free_slots;
+	struct rte_mbuf **bufs;  /* mbuf per write slot */
+	struct iovec *iovs;      /* URING_TX_MAX_SEGS per slot */
+
+	volatile unsigned long tx_pkts;
+	volatile unsigned long err_pkts;
+	volatile unsigned long tx_bytes;
+};
+
+struct pmd_internals {
+	unsigned int nb_queues;
+	unsigned int sqpoll;
+
+	int if_index;
+	char *if_name;
+	struct rte_ether_addr eth_addr;
+
+	struct pkt_rx_queue *rx_queue;
+	struct pkt_tx_queue *tx_queue;
+};
+
+static const char *valid_arguments[] = {
+	ETH_URING_IFACE_ARG,
+	ETH_URING_NUM_Q_ARG,
+	ETH_URING_RX_FILE_ARG,
+	ETH_URING_TX_FILE_ARG,
+	ETH_URING_FRAMESIZE_ARG,
+	ETH_URING_SQPOLL_ARG,
+	NULL
+};
+
+static struct rte_eth_link pmd_link = {
+	.link_speed = ETH_SPEED_NUM_10G,
+	.link_duplex = ETH_LINK_FULL_DUPLEX,
+	.link_status = ETH_LINK_DOWN,
+	.link_autoneg = ETH_LINK_FIXED,
+};
+
+RTE_LOG_REGISTER(uring_logtype, pmd.net.uring, NOTICE);
+
+#define PMD_LOG(level, fmt, args...) \
+	rte_log(RTE_LOG_ ## level, uring_logtype, \
+		"%s(): " fmt "\n", __func__, ##args)
+
+#define PMD_LOG_ERRNO(level, fmt, args...) \
+	rte_log(RTE_LOG_ ## level, uring_logtype, \
+		"%s(): " fmt ":%s\n", __func__, ##args, strerror(errno))
+
+/*
+ * Minimal io_uring support, on top of the raw system calls so that
+ * there is no dependency on liburing.
+ */
+
+static int
+uring_enter(struct uring *r, unsigned int to_submit,
+	    unsigned int min_complete, unsigned int flags)
+{
+	return syscall(__NR_io_uring_enter, r->fd, to_submit, min_complete,
+		       flags, NULL, 0);
+}
+
+static void
+uring_release(struct uring *r)
+{
+	if (r->sqes != NULL)
+		munmap(r->sqes, r->sqes_sz);
+	if (r->cq_map != NULL && r->cq_map != r->sq_map)
+		munmap(r->cq_map, r->cq_map_sz);
+	if (r->sq_map != NULL)
+		munmap(r->sq_map, r->sq_map_sz);
+	if (r->fd >= 0)
+		close(r->fd);
+	memset(r, 0, sizeof(*r));
+	r->fd = -1;
+}
+
+/*
+ * Create a ring of at least the given number of entries, with the file
+ * registered as fixed file 0.
+ */
+static int
+uring_setup(struct uring *r, unsigned int entries, int file, int sqpoll)
+{
+	struct io_uring_params p;
+	uint32_t *sq_array;
+	unsigned int i;
+
+	memset(r, 0, sizeof(*r));
+	memset(&p, 0, sizeof(p));
+	if (sqpoll) {
+		p.flags = IORING_SETUP_SQPOLL;
+		p.sq_thread_idle = URING_SQPOLL_IDLE_MS;
+	}
+
+	r->fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (r->fd < 0) {
+		PMD_LOG_ERRNO(ERR, "io_uring_setup failed");
+		r->fd = -1;
+		return -errno;
+	}
+	r->setup_flags = p.flags;
+
+	r->sq_map_sz = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+	r->cq_map_sz = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->sq_map_sz = r->cq_map_sz = RTE_MAX(r->sq_map_sz,
+						      r->cq_map_sz);
+
+	r->sq_map = mmap(NULL, r->sq_map_sz, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_map == MAP_FAILED) {
+		r->sq_map = NULL;
+		goto error;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		r->cq_map = r->sq_map;
+	} else {
+		r->cq_map = mmap(NULL, r->cq_map_sz, PROT_READ | PROT_WRITE,
+				 MAP_SHARED | MAP_POPULATE, r->fd,
+				 IORING_OFF_CQ_RING);
+		if (r->cq_map == MAP_FAILED) {
+			r->cq_map = NULL;
+			goto error;
+		}
+	}
+	r->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_sz, PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED) {
+		r->sqes = NULL;
+		goto error;
+	}
+
+	r->sq_head = RTE_PTR_ADD(r->sq_map, p.sq_off.head);
+	r->sq_tail = RTE_PTR_ADD(r->sq_map, p.sq_off.tail);
+	r->sq_flags = RTE_PTR_ADD(r->sq_map, p.sq_off.flags);
+	r->sq_mask = *(uint32_t *)RTE_PTR_ADD(r->sq_map,
+					      p.sq_off.ring_mask);
+	r->sq_entries = p.sq_entries;
+	r->sqe_tail = *r->sq_tail;
+	r->sqe_submitted = r->sqe_tail;
+
+	/* SQEs are always submitted in order */
+	sq_array = RTE_PTR_ADD(r->sq_map, p.sq_off.array);
+	for (i = 0; i != p.sq_entries; i++)
+		sq_array[i] = i;
+
+	r->cq_head = RTE_PTR_ADD(r->cq_map, p.cq_off.head);
+	r->cq_tail = RTE_PTR_ADD(r->cq_map, p.cq_off.tail);
+	r->cq_mask = *(uint32_t *)RTE_PTR_ADD(r->cq_map,
+					      p.cq_off.ring_mask);
+	r->cqes = RTE_PTR_ADD(r->cq_map, p.cq_off.cqes);
+
+	/* Fixed files spare a lookup per request, and SQPOLL needs them */
+	if (syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_FILES,
+		    &file, 1) < 0) {
+		PMD_LOG_ERRNO(ERR, "could not register file");
+		goto error;
+	}
+
+	return 0;
+
+error:
+	i = errno;
+	uring_release(r);
+	return -(int)i;
+}
+
+static int
+uring_register_buffers(struct uring *r, const struct uring_regions *regions)
+{
+	/* fails harmlessly when nothing is registered */
+	syscall(__NR_io_uring_register, r->fd, IORING_UNREGISTER_BUFFERS,
+		NULL, 0);
+	if (regions == NULL || regions->nb == 0)
+		return -EINVAL;
+	if (syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_BUFFERS,
+		    regions->iov, regions->nb) < 0)
+		return -errno;
+	return 0;
+}
+
+static inline struct io_uring_sqe *
+uring_get_sqe(struct uring *r)
+{
+	struct io_uring_sqe *sqe;
+	uint32_t head;
+
+	head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+	if (r->sqe_tail - head >= r->sq_entries)
+		return NULL;
+	sqe = &r->sqes[r->sqe_tail & r->sq_mask];
+	r->sqe_tail++;
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->flags = IOSQE_FIXED_FILE;
+	sqe->fd = 0;
+	return sqe;
+}
+
+/*
+ * Hand the filled SQEs over, and with get_events let the kernel post
+ * the completions it has pending for this thread.
+ */
+static inline void
+uring_submit(struct uring *r, int get_events)
+{
+	unsigned int to_submit = r->sqe_tail - r->sqe_submitted;
+	unsigned int flags = 0;
+
+	if (to_submit != 0) {
+		__atomic_store_n(r->sq_tail, r->sqe_tail, __ATOMIC_RELEASE);
+		r->sqe_submitted = r->sqe_tail;
+	}
+
+	if (r->setup_flags & IORING_SETUP_SQPOLL) {
+		/* the kernel thread picks them up unless it went idle */
+		if (to_submit == 0 ||
+		    !(__atomic_load_n(r->sq_flags, __ATOMIC_ACQUIRE) &
+		      IORING_SQ_NEED_WAKEUP))
+			return;
+		to_submit = 0;
+		flags = IORING_ENTER_SQ_WAKEUP;
+	} else if (get_events) {
+		flags = IORING_ENTER_GETEVENTS;
+	} else if (to_submit == 0) {
+		return;
+	}
+	uring_enter(r, to_submit, 0, flags);
+}
+
+static inline struct io_uring_cqe *
+uring_peek_cqe(struct uring *r)
+{
+	uint32_t head = *r->cq_head;
+
+	if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE))
+		return NULL;
+	return &r->cqes[head & r->cq_mask];
+}
+
+static inline void
+uring_cqe_seen(struct uring *r)
+{
+	__atomic_store_n(r->cq_head, *r->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+/* Index of the registered buffer holding the given memory, or -1 */
+static inline int
+uring_region_find(const struct uring_regions *regions, const void *addr,
+		  size_t len)
+{
+	unsigned int i;
+
+	if (regions == NULL)
+		return -1;
+	for (i = 0; i != regions->nb; i++) {
+		uintptr_t base = (uintptr_t)regions->iov[i].iov_base;
+
+		if ((uintptr_t)addr >= base &&
+		    (uintptr_t)addr + len <= base + regions->iov[i].iov_len)
+			return i;
+	}
+	return -1;
+}
+
+static void
+uring_region_add(struct rte_mempool *mp __rte_unused, void *opaque,
+		 struct rte_mempool_memhdr *memhdr,
+		 unsigned int mem_idx __rte_unused)
+{
+	struct uring_regions *regions = opaque;
+
+	/* too many chunks, fixed buffers won't be used */
+	if (regions->nb == URING_MAX_REGIONS) {
+		regions->nb++;
+		return;
+	}
+	if (regions->nb > URING_MAX_REGIONS)
+		return;
+	regions->iov[regions->nb].iov_base = memhdr->addr;
+	regions->iov[regions->nb].iov_len = memhdr->len;
+	regions->nb++;
+}
+
+/* Length of the read of a slot */
+static inline uint32_t
+uring_rx_len(const struct pkt_rx_queue *pkt_q, uint16_t slot)
+{
+	uint32_t len = rte_pktmbuf_tailroom(pkt_q->bufs[slot]);
+
+	return pkt_q->is_file ? RTE_MIN(len, pkt_q->framesize) : len;
+}
+
+/* Queue a read into the mbuf of a slot */
+static inline int
+uring_rx_prep(struct pkt_rx_queue *pkt_q, uint16_t slot)
+{
+	struct rte_mbuf *mbuf = pkt_q->bufs[slot];
+	struct io_uring_sqe *sqe;
+	void *data = rte_pktmbuf_mtod(mbuf, void *);
+	uint32_t len = uring_rx_len(pkt_q, slot);
+	int idx = -1;
+
+	sqe = uring_get_sqe(&pkt_q->ring);
+	if (sqe == NULL)
+		return -1;
+
+	if (pkt_q->is_file) {
+		sqe->off = pkt_q->offset;
+		pkt_q->offset += len;
+	}
+	if (pkt_q->fixed)
+		idx = uring_region_find(&pkt_q->regions, data, len);
+	if (idx >= 0) {
+		sqe->opcode = IORING_OP_READ_FIXED;
+		sqe->addr = (uintptr_t)data;
+		sqe->len = len;
+		sqe->buf_index = idx;
+	} else {
+		pkt_q->iovs[slot].iov_base = data;
+		pkt_q->iovs[slot].iov_len = len;
+		sqe->opcode = IORING_OP_READV;
+		sqe->addr = (uintptr_t)&pkt_q->iovs[slot];
+		sqe->len = 1;
+	}
+	sqe->user_data = slot;
+	pkt_q->res[slot] = URING_INFLIGHT;
+	pkt_q->nb_inflight++;
+	return 0;
+}
+
+static inline void
+uring_rx_reap(struct pkt_rx_queue *pkt_q)
+{
+	struct io_uring_cqe *cqe;
+
+	while ((cqe = uring_peek_cqe(&pkt_q->ring)) != NULL) {
+		if (cqe->user_data != URING_CANCEL_TAG) {
+			pkt_q->res[cqe->user_data] = cqe->res;
+			pkt_q->nb_inflight--;
+		}
+		uring_cqe_seen(&pkt_q->ring);
+	}
+}
+
+static uint16_t
+eth_uring_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pkt_rx_queue *pkt_q = queue;
+	struct rte_mbuf *mbuf, *new_mbuf;
+	uint16_t head = pkt_q->head;
+	uint16_t num_rx = 0;
+	unsigned long num_rx_bytes = 0;
+	int32_t res;
+	uint16_t i;
+
+	if (unlikely(nb_pkts == 0))
+		return 0;
+
+	uring_rx_reap(pkt_q);
+
+	/*
+	 * Slots are handed out in the order their reads were queued,
+	 * which keeps file data in order. At most nb_pkts of them are
+	 * queued again, so that an idle socket costs a burst of reads
+	 * rather than the whole ring.
+	 */
+	for (i = 0; i < nb_pkts; i++) {
+		res = pkt_q->res[head];
+		if (res == URING_INFLIGHT)
+			break;
+		/* end of file: keep the slot done and stop there */
+		if (res == 0 && pkt_q->is_file)
+			break;
+
+		if (res > 0) {
+			new_mbuf = rte_pktmbuf_alloc(pkt_q->mb_pool);
+			if (unlikely(new_mbuf == NULL)) {
+				pkt_q->rx_nombuf++;
+				break;
+			}
+			mbuf = pkt_q->bufs[head];
+			rte_pktmbuf_pkt_len(mbuf) = res;
+			rte_pktmbuf_data_len(mbuf) = res;
+			mbuf->port = pkt_q->in_port;
+			bufs[num_rx++] = mbuf;
+			num_rx_bytes += res;
+			pkt_q->bufs[head] = new_mbuf;
+			pkt_q->res[head] = URING_IDLE;
+		} else if (res < 0 && res != URING_IDLE && res != -EAGAIN) {
+			pkt_q->err_pkts++;
+		}
+
+		if (uring_rx_prep(pkt_q, head) < 0)
+			break;
+		if (++head == pkt_q->nb_desc)
+			head = 0;
+	}
+	pkt_q->head = head;
+
+	/* also runs the completions pending for this thread */
+	uring_submit(&pkt_q->ring, num_rx < nb_pkts);
+
+	pkt_q->rx_pkts += num_rx;
+	pkt_q->rx_bytes += num_rx_bytes;
+	return num_rx;
+}
+
+static inline void
+uring_tx_reap(struct pkt_tx_queue *pkt_q)
+{
+	struct io_uring_cqe *cqe;
+	struct rte_mbuf *mbuf;
+	uint16_t slot;
+
+	while ((cqe = uring_peek_cqe(&pkt_q->ring)) != NULL) {
+		slot = cqe->user_data;
+		mbuf = pkt_q->bufs[slot];
+		if (cqe->res >= 0 && (uint32_t)cqe->res == mbuf->pkt_len) {
+			pkt_q->tx_pkts++;
+			pkt_q->tx_bytes += mbuf->pkt_len;
+		} else {
+			pkt_q->err_pkts++;
+		}
+		rte_pktmbuf_free(mbuf);
+		pkt_q->free_slots[pkt_q->nb_free++] = slot;
+		uring_cqe_seen(&pkt_q->ring);
+	}
+}
+
+/*
+ * Callback to handle sending packets, mbufs are freed once the kernel
+ * has completed their write.
+ */
+static uint16_t
+eth_uring_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pkt_tx_queue *pkt_q = queue;
+	struct io_uring_sqe *sqe;
+	struct rte_mbuf *mbuf, *seg;
+	struct iovec *iov;
+	uint16_t slot;
+	uint16_t i;
+	int idx;
+
+	uring_tx_reap(pkt_q);
+
+	for (i = 0; i < nb_pkts; i++) {
+		mbuf = bufs[i];
+
+		/* drop what can't be described in one request */
+		if (unlikely(mbuf->nb_segs > URING_TX_MAX_SEGS)) {
+			pkt_q->err_pkts++;
+			rte_pktmbuf_free(mbuf);
+			continue;
+		}
+
+		if (pkt_q->nb_free == 0)
+			break;
+		sqe = uring_get_sqe(&pkt_q->ring);
+		if (sqe == NULL)
+			break;
+		slot = pkt_q->free_slots[--pkt_q->nb_free];
+		pkt_q->bufs[slot] = mbuf;
+
+		idx = -1;
+		if (mbuf->nb_segs == 1)
+			idx = uring_region_find(pkt_q->regions,
+				rte_pktmbuf_mtod(mbuf, void *),
+				mbuf->data_len);
+		if (idx >= 0) {
+			sqe->opcode = IORING_OP_WRITE_FIXED;
+			sqe->addr = rte_pktmbuf_mtod(mbuf, uintptr_t);
+			sqe->len = mbuf->data_len;
+			sqe->buf_index = idx;
+		} else {
+			iov = &pkt_q->iovs[slot * URING_TX_MAX_SEGS];
+			for (seg = mbuf; seg != NULL; seg = seg->next) {
+				iov->iov_base = rte_pktmbuf_mtod(seg, void *);
+				iov->iov_len = seg->data_len;
+				iov++;
+			}
+			sqe->opcode = IORING_OP_WRITEV;
+			sqe->addr = (uintptr_t)
+				&pkt_q->iovs[slot * URING_TX_MAX_SEGS];
+			sqe->len = mbuf->nb_segs;
+		}
+		if (pkt_q->is_file) {
+			sqe->off = pkt_q->offset;
+			pkt_q->offset += mbuf->pkt_len;
+		}
+		sqe->user_data = slot;
+	}
+
+	/* writes that went async complete in the context of this thread */
+	uring_submit(&pkt_q->ring, pkt_q->nb_free != pkt_q->nb_desc);
+	return i;
+}
+
+/* Cancel the reads in flight and wait for all of them to complete */
+static void
+uring_rx_drain(struct pkt_rx_queue *pkt_q)
+{
+	struct io_uring_sqe *sqe;
+	uint16_t slot;
+
+	if (pkt_q->ring.fd < 0)
+		return;
+
+	for (slot = 0; slot != pkt_q->nb_desc; slot++) {
+		if (pkt_q->res[slot] != URING_INFLIGHT)
+			continue;
+		while ((sqe = uring_get_sqe(&pkt_q->ring)) == NULL) {
+			uring_submit(&pkt_q->ring, 1);
+			uring_rx_reap(pkt_q);
+		}
+		sqe->flags = 0;
+		sqe->fd = -1;
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->addr = slot;
+		sqe->user_data = URING_CANCEL_TAG;
+	}
+	uring_submit(&pkt_q->ring, 0);
+
+	while (pkt_q->nb_inflight != 0) {
+		if (uring_enter(&pkt_q->ring, 0, 1,
+				IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+			break;
+		uring_rx_reap(pkt_q);
+	}
+
+	/*
+	 * The reads of a file not handed out yet are queued again on start,
+	 * from the first of them, so that no data is skipped.
+	 */
+	if (pkt_q->is_file)
+		for (slot = 0; slot != pkt_q->nb_desc; slot++)
+			if (pkt_q->res[slot] != URING_IDLE)
+				pkt_q->offset -= uring_rx_len(pkt_q, slot);
+}
+
+static void
+uring_tx_drain(struct pkt_tx_queue *pkt_q)
+{
+	if (pkt_q->ring.fd < 0)
+		return;
+
+	while (pkt_q->nb_free != pkt_q->nb_desc) {
+		if (uring_enter(&pkt_q->ring, 0, 1,
+				IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+			break;
+		uring_tx_reap(pkt_q);
+	}
+}
+
+static int
+eth_dev_start(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct pkt_rx_queue *rxq;
+	struct pkt_tx_queue *txq;
+	unsigned int q;
+	uint16_t slot;
+
+	for (q = 0; q < internals->nb_queues; q++) {
+		rxq = &internals->rx_queue[q];
+		txq = &internals->tx_queue[q];
+
+		/* Writes of mbufs received on the same queue pair are fixed */
+		if (txq->ring.fd >= 0) {
+			txq->regions = NULL;
+			if (rxq->fixed && uring_register_buffers(&txq->ring,
+					&rxq->regions) == 0)
+				txq->regions = &rxq->regions;
+		}
+
+		if (rxq->ring.fd < 0)
+			continue;
+		rxq->head = 0;
+		for (slot = 0; slot != rxq->nb_desc; slot++) {
+			rxq->res[slot] = URING_IDLE;
+			uring_rx_prep(rxq, slot);
+		}
+		uring_submit(&rxq->ring, 0);
+	}
+
+	dev->data->dev_link.link_status = ETH_LINK_UP;
+	return 0;
+}
+
+/*
+ * This function gets called when the current port gets stopped.
+ */
+static void
+eth_dev_stop(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int q;
+
+	for (q = 0; q < internals->nb_queues; q++) {
+		uring_rx_drain(&internals->rx_queue[q]);
+		uring_tx_drain(&internals->tx_queue[q]);
+	}
+
+	dev->data->dev_link.link_status = ETH_LINK_DOWN;
+}
+
+static int
+eth_dev_configure(struct rte_eth_dev *dev __rte_unused)
+{
+	return 0;
+}
+
+static int
+eth_dev_info(struct rte_eth_dev *dev, struct rte_eth_dev_info *dev_info)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	dev_info->if_index = internals->if_index;
+	dev_info->max_mac_addrs = 1;
+	dev_info->max_rx_pktlen = (uint32_t)ETH_FRAME_LEN;
+	dev_info->max_rx_queues = (uint16_t)internals->nb_queues;
+	dev_info->max_tx_queues = (uint16_t)internals->nb_queues;
+	dev_info->min_rx_bufsize = 0;
+	dev_info->tx_offload_capa = DEV_TX_OFFLOAD_MULTI_SEGS;
+	dev_info->rx_desc_lim.nb_max = URING_MAX_DESC;
+	dev_info->rx_desc_lim.nb_min = 1;
+	dev_info->tx_desc_lim.nb_max = URING_MAX_DESC;
+	dev_info->tx_desc_lim.nb_min = 1;
+
+	return 0;
+}
+
+static int
+eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *igb_stats)
+{
+	unsigned int i, imax;
+	unsigned long rx_total = 0, tx_total = 0, tx_err_total = 0;
+	unsigned long rx_bytes_total = 0, tx_bytes_total = 0;
+	unsigned long rx_err_total = 0, rx_nombuf_total = 0;
+	const struct pmd_internals *internal = dev->data->dev_private;
+
+	imax = (internal->nb_queues < RTE_ETHDEV_QUEUE_STAT_CNTRS ?
+		internal->nb_queues : RTE_ETHDEV_QUEUE_STAT_CNTRS);
+	for (i = 0; i < imax; i++) {
+		igb_stats->q_ipackets[i] = internal->rx_queue[i].rx_pkts;
+		igb_stats->q_ibytes[i] = internal->rx_queue[i].rx_bytes;
+		igb_stats->q_errors[i] = internal->rx_queue[i].err_pkts;
+		igb_stats->q_opackets[i] = internal->tx_queue[i].tx_pkts;
+		igb_stats->q_obytes[i] = internal->tx_queue[i].tx_bytes;
+	}
+
+	for (i = 0; i < internal->nb_queues; i++) {
+		rx_total += internal->rx_queue[i].rx_pkts;
+		rx_bytes_total += internal->rx_queue[i].rx_bytes;
+		rx_err_total += internal->rx_queue[i].err_pkts;
+		rx_nombuf_total += internal->rx_queue[i].rx_nombuf;
+		tx_total += internal->tx_queue[i].tx_pkts;
+		tx_err_total += internal->tx_queue[i].err_pkts;
+		tx_bytes_total += internal->tx_queue[i].tx_bytes;
+	}
+
+	igb_stats->ipackets = rx_total;
+	igb_stats->ibytes = rx_bytes_total;
+	igb_stats->ierrors = rx_err_total;
+	igb_stats->rx_nombuf = rx_nombuf_total;
+	igb_stats->opackets = tx_total;
+	igb_stats->oerrors = tx_err_total;
+	igb_stats->obytes = tx_bytes_total;
+	return 0;
+}
+
+static int
+eth_stats_reset(struct rte_eth_dev *dev)
+{
+	unsigned int i;
+	struct pmd_internals *internal = dev->data->dev_private;
+
+	for (i = 0; i < internal->nb_queues; i++) {
+		internal->rx_queue[i].rx_pkts = 0;
+		internal->rx_queue[i].rx_bytes = 0;
+		internal->rx_queue[i].rx_nombuf = 0;
+		internal->rx_queue[i].err_pkts = 0;
+		internal->tx_queue[i].tx_pkts = 0;
+		internal->tx_queue[i].err_pkts = 0;
+		internal->tx_queue[i].tx_bytes = 0;
+	}
+
+	return 0;
+}
+
+static void
+eth_rx_queue_release(void *queue)
+{
+	struct pkt_rx_queue *pkt_q = queue;
+	uint16_t slot;
+
+	if (pkt_q == NULL)
+		return;
+
+	uring_rx_drain(pkt_q);
+	uring_release(&pkt_q->ring);
+	if (pkt_q->bufs != NULL)
+		for (slot = 0; slot != pkt_q->nb_desc; slot++)
+			rte_pktmbuf_free(pkt_q->bufs[slot]);
+	rte_free(pkt_q->bufs);
+	rte_free(pkt_q->res);
+	rte_free(pkt_q->iovs);
+	pkt_q->bufs = NULL;
+	pkt_q->res = NULL;
+	pkt_q->iovs = NULL;
+	pkt_q->nb_desc = 0;
+	pkt_q->fixed = 0;
+}
+
+static void
+eth_tx_queue_release(void *queue)
+{
+	struct pkt_tx_queue *pkt_q = queue;
+
+	if (pkt_q == NULL)
+		return;
+
+	uring_tx_drain(pkt_q);
+	uring_release(&pkt_q->ring);
+	rte_free(pkt_q->bufs);
+	rte_free(pkt_q->free_slots);
+	rte_free(pkt_q->iovs);
+	pkt_q->bufs = NULL;
+	pkt_q->free_slots = NULL;
+	pkt_q->iovs = NULL;
+	pkt_q->regions = NULL;
+	pkt_q->nb_desc = 0;
+	pkt_q->nb_free = 0;
+}
+
+static void
+eth_dev_close(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int q;
+
+	for (q = 0; q < internals->nb_queues; q++) {
+		eth_tx_queue_release(&internals->tx_queue[q]);
+		eth_rx_queue_release(&internals->rx_queue[q]);
+	}
+}
+
+static int
+eth_link_update(struct rte_eth_dev *dev __rte_unused,
+		int wait_to_complete __rte_unused)
+{
+	return 0;
+}
+
+/*
+ * Frames queue up in the socket while the reads are not refilled, size
+ * its buffer for a ring worth of them. Going over net.core.rmem_max
+ * needs CAP_NET_ADMIN, without it the buffer is capped there.
+ */
+static void
+uring_set_rcvbuf(struct rte_eth_dev *dev, struct pkt_rx_queue *pkt_q,
+		 int size)
+{
+	if (setsockopt(pkt_q->fd, SOL_SOCKET, SO_RCVBUFFORCE,
+		       &size, sizeof(size)) == 0)
+		return;
+	if (setsockopt(pkt_q->fd, SOL_SOCKET, SO_RCVBUF,
+		       &size, sizeof(size)) == -1)
+		PMD_LOG_ERRNO(WARNING, "%s: could not set socket buffer size",
+			      dev->device->name);
+}
+
+static int
+eth_rx_queue_setup(struct rte_eth_dev *dev,
+		   uint16_t rx_queue_id,
+		   uint16_t nb_rx_desc,
+		   unsigned int socket_id,
+		   const struct rte_eth_rxconf *rx_conf __rte_unused,
+		   struct rte_mempool *mb_pool)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct pkt_rx_queue *pkt_q = &internals->rx_queue[rx_queue_id];
+	unsigned int buf_size;
+	uint16_t slot;
+	int ret;
+
+	eth_rx_queue_release(pkt_q);
+
+	buf_size = rte_pktmbuf_data_room_size(mb_pool) -
+		RTE_PKTMBUF_HEADROOM;
+	if (!pkt_q->is_file && buf_size < ETH_FRAME_LEN)
+		PMD_LOG(WARNING,
+			"%s: frames over %u bytes will be truncated",
+			dev->device->name, buf_size);
+
+	pkt_q->mb_pool = mb_pool;
+	pkt_q->in_port = dev->data->port_id;
+	pkt_q->nb_desc = RTE_MIN(nb_rx_desc, URING_MAX_DESC);
+	if (!pkt_q->is_file)
+		uring_set_rcvbuf(dev, pkt_q,
+			pkt_q->nb_desc * rte_pktmbuf_data_room_size(mb_pool));
+	pkt_q->bufs = rte_zmalloc_socket(dev->device->name,
+		pkt_q->nb_desc * sizeof(*pkt_q->bufs), 0, socket_id);
+	pkt_q->res = rte_zmalloc_socket(dev->device->name,
+		pkt_q->nb_desc * sizeof(*pkt_q->res), 0, socket_id);
+	pkt_q->iovs = rte_zmalloc_socket(dev->device->name,
+		pkt_q->nb_desc * sizeof(*pkt_q->iovs), 0, socket_id);
+	if (pkt_q->bufs == NULL || pkt_q->res == NULL ||
+	    pkt_q->iovs == NULL) {
+		ret = -ENOMEM;
+		goto error;
+	}
+	if (rte_pktmbuf_alloc_bulk(mb_pool, pkt_q->bufs,
+				   pkt_q->nb_desc) != 0) {
+		PMD_LOG(ERR, "%s: could not allocate %u mbufs",
+			dev->device->name, pkt_q->nb_desc);
+		ret = -ENOMEM;
+		goto error;
+	}
+	for (slot = 0; slot != pkt_q->nb_desc; slot++)
+		pkt_q->res[slot] = URING_IDLE;
+
+	ret = uring_setup(&pkt_q->ring, pkt_q->nb_desc, pkt_q->fd,
+			  internals->sqpoll);
+	if (ret < 0)
+		goto error;
+
+	/*
+	 * Reads go straight to the mbufs: with the mempool registered the
+	 * kernel maps them once, rather than on every read.
+	 */
+	memset(&pkt_q->regions, 0, sizeof(pkt_q->regions));
+	rte_mempool_mem_iter(mb_pool, uring_region_add, &pkt_q->regions);
+	if (pkt_q->regions.nb <= URING_MAX_REGIONS &&
+	    uring_register_buffers(&pkt_q->ring, &pkt_q->regions) == 0)
+		pkt_q->fixed = 1;
+	else
+		PMD_LOG(INFO, "%s: mempool %s not registered, using readv",
+			dev->device->name, mb_pool->name);
+
+	dev->data->rx_queues[rx_queue_id] = pkt_q;
+	return 0;
+
+error:
+	eth_rx_queue_release(pkt_q);
+	return ret;
+}
+
+static int
+eth_tx_queue_setup(struct rte_eth_dev *dev,
+		   uint16_t tx_queue_id,
+		   uint16_t nb_tx_desc,
+		   unsigned int socket_id,
+		   const struct rte_eth_txconf *tx_conf __rte_unused)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct pkt_tx_queue *pkt_q = &internals->tx_queue[tx_queue_id];
+	uint16_t slot;
+	int ret;
+
+	eth_tx_queue_release(pkt_q);
+
+	pkt_q->nb_desc = RTE_MIN(nb_tx_desc, URING_MAX_DESC);
+	pkt_q->bufs = rte_zmalloc_socket(dev->device->name,
+		pkt_q->nb_desc * sizeof(*pkt_q->bufs), 0, socket_id);
+	pkt_q->free_slots = rte_zmalloc_socket(dev->device->name,
+		pkt_q->nb_desc * sizeof(*pkt_q->free_slots), 0, socket_id);
+	pkt_q->iovs = rte_zmalloc_socket(dev->device->name,
+		pkt_q->nb_desc * URING_TX_MAX_SEGS * sizeof(*pkt_q->iovs),
+		0, socket_id);
+	if (pkt_q->bufs == NULL || pkt_q->free_slots == NULL ||
+	    pkt_q->iovs == NULL) {
+		ret = -ENOMEM;
+		goto error;
+	}
+	for (slot = 0; slot != pkt_q->nb_desc; slot++)
+		pkt_q->free_slots[slot] = slot;
+	pkt_q->nb_free = pkt_q->nb_desc;
+
+	ret = uring_setup(&pkt_q->ring, pkt_q->nb_desc, pkt_q->fd,
+			  internals->sqpoll);
+	if (ret < 0)
+		goto error;
+
+	dev->data->tx_queues[tx_queue_id] = pkt_q;
+	return 0;
+
+error:
+	eth_tx_queue_release(pkt_q);
+	return ret;
+}
+
+static int
+eth_dev_mtu_set(struct rte_eth_dev *dev, uint16_t mtu)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct ifreq ifr = { .ifr_mtu = mtu };
+	int ret;
+	int s;
+
+	if (internals->if_name == NULL)
+		return -ENOTSUP;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	if (s < 0)
+		return -EINVAL;
+
+	strlcpy(ifr.ifr_name, internals->if_name, IFNAMSIZ);
+	ret = ioctl(s, SIOCSIFMTU, &ifr);
+	close(s);
+
+	if (ret < 0)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int
+eth_dev_change_flags(char *if_name, uint32_t flags, uint32_t mask)
+{
+	struct ifreq ifr;
+	int ret = 0;
+	int s;
+
+	if (if_name == NULL)
+		return -ENOTSUP;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	if (s < 0)
+		return -errno;
+
+	strlcpy(ifr.ifr_name, if_name, IFNAMSIZ);
+	if (ioctl(s, SIOCGIFFLAGS, &ifr) < 0) {
+		ret = -errno;
+		goto out;
+	}
+	ifr.ifr_flags &= mask;
+	ifr.ifr_flags |= flags;
+	if (ioctl(s, SIOCSIFFLAGS, &ifr) < 0) {
+		ret = -errno;
+		goto out;
+	}
+out:
+	close(s);
+	return ret;
+}
+
+static int
+eth_dev_promiscuous_enable(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	return eth_dev_change_flags(internals->if_name, IFF_PROMISC, ~0);
+}
+
+static int
+eth_dev_promiscuous_disable(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	return eth_dev_change_flags(internals->if_name, 0, ~IFF_PROMISC);
+}
+
+static const struct eth_dev_ops ops = {
+	.dev_start = eth_dev_start,
+	.dev_stop = eth_dev_stop,
+	.dev_close = eth_dev_close,
+	.dev_configure = eth_dev_configure,
+	.dev_infos_get = eth_dev_info,
+	.mtu_set = eth_dev_mtu_set,
+	.promiscuous_enable = eth_dev_promiscuous_enable,
+	.promiscuous_disable = eth_dev_promiscuous_disable,
+	.rx_queue_setup = eth_rx_queue_setup,
+	.tx_queue_setup = eth_tx_queue_setup,
+	.rx_queue_release = eth_rx_queue_release,
+	.tx_queue_release = eth_tx_queue_release,
+	.link_update = eth_link_update,
+	.stats_get = eth_stats_get,
+	.stats_reset = eth_stats_reset,
+};
+
+/*
+ * Open one AF_PACKET socket per queue pair on the interface, traffic is
+ * spread over them with a fanout group.
+ */
+static int
+open_packet_iface(const char *name, const char *iface,
+		  struct pmd_internals *internals)
+{
+	struct sockaddr_ll sockaddr;
+	struct ifreq ifr;
+	unsigned int q;
+	int fanout_arg;
+	int one = 1;
+	int sockfd;
+
+	if (strlen(iface) >= sizeof(ifr.ifr_name)) {
+		PMD_LOG(ERR, "%s: I/F name too long (%s)", name, iface);
+		return -1;
+	}
+
+	sockfd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+	if (sockfd == -1) {
+		PMD_LOG_ERRNO(ERR, "%s: could not open AF_PACKET socket",
+			      name);
+		return -1;
+	}
+	memset(&ifr, 0, sizeof(ifr));
+	strlcpy(ifr.ifr_name, iface, sizeof(ifr.ifr_name));
+	if (ioctl(sockfd, SIOCGIFINDEX, &ifr) == -1) {
+		PMD_LOG_ERRNO(ERR, "%s: ioctl failed (SIOCGIFINDEX)", name);
+		close(sockfd);
+		return -1;
+	}
+	internals->if_index = ifr.ifr_ifindex;
+	if (ioctl(sockfd, SIOCGIFHWADDR, &ifr) == -1) {
+		PMD_LOG_ERRNO(ERR, "%s: ioctl failed (SIOCGIFHWADDR)", name);
+		close(sockfd);
+		return -1;
+	}
+	memcpy(&internals->eth_addr, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+	close(sockfd);
+
+	internals->if_name = strdup(iface);
+	if (internals->if_name == NULL)
+		return -1;
+
+	memset(&sockaddr, 0, sizeof(sockaddr));
+	sockaddr.sll_family = AF_PACKET;
+	sockaddr.sll_protocol = htons(ETH_P_ALL);
+	sockaddr.sll_ifindex = internals->if_index;
+
+	fanout_arg = (getpid() ^ internals->if_index) & 0xffff;
+	fanout_arg |= (PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG |
+		       PACKET_FANOUT_FLAG_ROLLOVER) << 16;
+
+	for (q = 0; q < internals->nb_queues; q++) {
+		/*
+		 * Reads fail with EAGAIN rather than waiting in the Kernel:
+		 * a read parked on the socket would be woken for every
+		 * frame, whichever read ends up consuming it.
+		 */
+		sockfd = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK,
+				htons(ETH_P_ALL));
+		if (sockfd == -1) {
+			PMD_LOG_ERRNO(ERR,
+				"%s: could not open AF_PACKET socket", name);
+			return -1;
+		}
+		internals->rx_queue[q].fd = sockfd;
+
+		if (setsockopt(sockfd, SOL_PACKET, PACKET_IGNORE_OUTGOING,
+			       &one, sizeof(one)) == -1)
+			PMD_LOG_ERRNO(WARNING,
+				"%s: could not ignore outgoing frames on %s",
+				name, iface);
+		if (bind(sockfd, (const struct sockaddr *)&sockaddr,
+			 sizeof(sockaddr)) == -1) {
+			PMD_LOG_ERRNO(ERR,
+				"%s: could not bind AF_PACKET socket to %s",
+				name, iface);
+			return -1;
+		}
+		if (setsockopt(sockfd, SOL_PACKET, PACKET_FANOUT,
+			       &fanout_arg, sizeof(fanout_arg)) == -1) {
+			PMD_LOG_ERRNO(ERR,
+				"%s: could not set PACKET_FANOUT on AF_PACKET socket for %s",
+				name, iface);
+			return -1;
+		}
+
+		/* protocol 0: the Tx socket receives nothing */
+		sockfd = socket(AF_PACKET, SOCK_RAW, 0);
+		if (sockfd == -1) {
+			PMD_LOG_ERRNO(ERR,
+				"%s: could not open AF_PACKET socket", name);
+			return -1;
+		}
+		internals->tx_queue[q].fd = sockfd;
+
+		sockaddr.sll_protocol = 0;
+		if (bind(sockfd, (const struct sockaddr *)&sockaddr,
+			 sizeof(sockaddr)) == -1) {
+			PMD_LOG_ERRNO(ERR,
+				"%s: could not bind AF_PACKET socket to %s",
+				name, iface);
+			return -1;
+		}
+		sockaddr.sll_protocol = htons(ETH_P_ALL);
+	}
+
+	return 0;
+}
+
+/* Open the files of the only queue pair, /dev/null if not given */
+static int
+open_files(const char *name, const char *rx_file, const char *tx_file,
+	   struct pmd_internals *internals)
+{
+	struct pkt_rx_queue *rxq = &internals->rx_queue[0];
+	struct pkt_tx_queue *txq = &internals->tx_queue[0];
+
+	if (rx_file == NULL)
+		rx_file = "/dev/null";
+	if (tx_file == NULL)
+		tx_file = "/dev/null";
+
+	rxq->fd = open(rx_file, O_RDONLY);
+	if (rxq->fd < 0) {
+		PMD_LOG_ERRNO(ERR, "%s: could not open %s", name, rx_file);
+		return -1;
+	}
+	rxq->is_file = 1;
+
+	txq->fd = open(tx_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (txq->fd < 0) {
+		PMD_LOG_ERRNO(ERR, "%s: could not open %s", name, tx_file);
+		return -1;
+	}
+	txq->is_file = 1;
+
+	rte_eth_random_addr(internals->eth_addr.addr_bytes);
+	return 0;
+}
+
+static void
+uring_close_fds(struct pmd_internals *internals)
+{
+	unsigned int q;
+
+	for (q = 0; q < internals->nb_queues; q++) {
+		if (internals->tx_queue[q].fd >= 0 &&
+		    internals->tx_queue[q].fd != internals->rx_queue[q].fd)
+			close(internals->tx_queue[q].fd);
+		if (internals->rx_queue[q].fd >= 0)
+			close(internals->rx_queue[q].fd);
+		internals->rx_queue[q].fd = -1;
+		internals->tx_queue[q].fd = -1;
+	}
+}
+
+static int
+get_uint_arg(const char *key, const char *value, void *extra_args)
+{
+	unsigned int *u = extra_args;
+	char *end;
+	unsigned long v;
+
+	errno = 0;
+	v = strtoul(value, &end, 0);
+	if (errno != 0 || *end != '\0' || end == value || v > UINT32_MAX) {
+		PMD_LOG(ERR, "invalid %s value: %s", key, value);
+		return -1;
+	}
+	*u = v;
+	return 0;
+}
+
+static int
+get_string_arg(const char *key __rte_unused, const char *value,
+	       void *extra_args)
+{
+	*(const char **)extra_args = value;
+	return 0;
+}
+
+static int
+rte_pmd_uring_probe(struct rte_vdev_device *dev)
+{
+	const char *name = rte_vdev_device_name(dev);
+	const unsigned int numa_node = dev->device.numa_node;
+	const char *iface = NULL, *rx_file = NULL, *tx_file = NULL;
+	unsigned int qpairs = 1, framesize = 0, sqpoll = 0;
+	struct pmd_internals *internals = NULL;
+	struct rte_eth_dev_data *data;
+	struct rte_eth_dev *eth_dev;
+	struct rte_kvargs *kvlist;
+	unsigned int q;
+	int ret = -1;
+
+	PMD_LOG(INFO, "Initializing pmd_uring for %s", name);
+
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
+		PMD_LOG(ERR, "%s: secondary processes are not supported",
+			name);
+		return -ENOTSUP;
+	}
+
+	kvlist = rte_kvargs_parse(rte_vdev_device_args(dev), valid_arguments);
+	if (kvlist == NULL)
+		return -1;
+
+	if (rte_kvargs_process(kvlist, ETH_URING_IFACE_ARG,
+			       &get_string_arg, &iface) < 0 ||
+	    rte_kvargs_process(kvlist, ETH_URING_RX_FILE_ARG,
+			       &get_string_arg, &rx_file) < 0 ||
+	    rte_kvargs_process(kvlist, ETH_URING_TX_FILE_ARG,
+			       &get_string_arg, &tx_file) < 0 ||
+	    rte_kvargs_process(kvlist, ETH_URING_NUM_Q_ARG,
+			       &get_uint_arg, &qpairs) < 0 ||
+	    rte_kvargs_process(kvlist, ETH_URING_FRAMESIZE_ARG,
+			       &get_uint_arg, &framesize) < 0 ||
+	    rte_kvargs_process(kvlist, ETH_URING_SQPOLL_ARG,
+			       &get_uint_arg, &sqpoll) < 0)
+		goto exit;
+
+	if ((iface == NULL) == (rx_file == NULL && tx_file == NULL)) {
+		PMD_LOG(ERR, "%s: either %s or %s/%s must be given", name,
+			ETH_URING_IFACE_ARG, ETH_URING_RX_FILE_ARG,
+			ETH_URING_TX_FILE_ARG);
+		goto exit;
+	}
+	if (qpairs < 1 || qpairs > URING_MAX_QUEUES ||
+	    (iface == NULL && qpairs != 1)) {
+		PMD_LOG(ERR, "%s: invalid qpairs value", name);
+		goto exit;
+	}
+	if (sqpoll > 1) {
+		PMD_LOG(ERR, "%s: invalid sqpoll value", name);
+		goto exit;
+	}
+
+	internals = rte_zmalloc_socket(name, sizeof(*internals), 0,
+				       numa_node);
+	if (internals == NULL)
+		goto exit;
+	internals->rx_queue = rte_calloc_socket("uring_rx", qpairs,
+		sizeof(struct pkt_rx_queue), 0, numa_node);
+	internals->tx_queue = rte_calloc_socket("uring_tx", qpairs,
+		sizeof(struct pkt_tx_queue), 0, numa_node);
+	if (internals->rx_queue == NULL || internals->tx_queue == NULL)
+		goto free_internals;
+
+	internals->nb_queues = qpairs;
+	internals->sqpoll = sqpoll;
+	for (q = 0; q < qpairs; q++) {
+		internals->rx_queue[q].fd = -1;
+		internals->rx_queue[q].ring.fd = -1;
+		internals->rx_queue[q].framesize =
+			framesize != 0 ? framesize : UINT32_MAX;
+		internals->tx_queue[q].fd = -1;
+		internals->tx_queue[q].ring.fd = -1;
+	}
+
+	if (iface != NULL)
+		ret = open_packet_iface(name, iface, internals);
+	else
+		ret = open_files(name, rx_file, tx_file, internals);
+	if (ret < 0)
+		goto close_fds;
+
+	eth_dev = rte_eth_vdev_allocate(dev, 0);
+	if (eth_dev == NULL) {
+		ret = -1;
+		goto close_fds;
+	}
+
+	data = eth_dev->data;
+	data->dev_private = internals;
+	data->nb_rx_queues = (uint16_t)qpairs;
+	data->nb_tx_queues = (uint16_t)qpairs;
+	data->dev_link = pmd_link;
+	data->mac_addrs = &internals->eth_addr;
+
+	eth_dev->dev_ops = &ops;
+	eth_dev->rx_pkt_burst = eth_uring_rx;
+	eth_dev->tx_pkt_burst = eth_uring_tx;
+
+	rte_eth_dev_probing_finish(eth_dev);
+	rte_kvargs_free(kvlist);
+	return 0;
+
+close_fds:
+	uring_close_fds(internals);
+free_internals:
+	free(internals->if_name);
+	rte_free(internals->rx_queue);
+	rte_free(internals->tx_queue);
+	rte_free(internals);
+	ret = -1;
+exit:
+	rte_kvargs_free(kvlist);
+	return ret;
+}
+
+static int
+rte_pmd_uring_remove(struct rte_vdev_device *dev)
+{
+	struct rte_eth_dev *eth_dev;
+	struct pmd_internals *internals;
+
+	PMD_LOG(INFO, "Closing io_uring ethdev on numa socket %u",
+		rte_socket_id());
+
+	if (dev == NULL)
+		return -1;
+
+	/* find the ethdev entry */
+	eth_dev = rte_eth_dev_allocated(rte_vdev_device_name(dev));
+	if (eth_dev == NULL)
+		return -1;
+
+	/* mac_addrs must not be freed alone because part of dev_private */
+	eth_dev->data->mac_addrs = NULL;
+
+	internals = eth_dev->data->dev_private;
+	eth_dev_close(eth_dev);
+	uring_close_fds(internals);
+	free(internals->if_name);
+	rte_free(internals->rx_queue);
+	rte_free(internals->tx_queue);
+
+	rte_eth_dev_release_port(eth_dev);
+
+	return 0;
+}
+
+static struct rte_vdev_driver pmd_uring_drv = {
+	.probe = rte_pmd_uring_probe,
+	.remove = rte_pmd_uring_remove,
+};
+
+RTE_PMD_REGISTER_VDEV(net_uring, pmd_uring_drv);
+RTE_PMD_REGISTER_ALIAS(net_uring, eth_uring);
+RTE_PMD_REGISTER_PARAM_STRING(net_uring,
+	"iface=<string> "
+	"qpairs=<int> "
+	"rx_file=<string> "
+	"tx_file=<string> "
+	"framesz=<int> "
+	"sqpoll=<0|1>");
@@ -35,6 +35,7 @@
 #include "virtio_logs.h"
 #include "virtqueue.h"
 #include "virtio_rxtx.h"
+#include "virtio_rxtx_simple.h"
 #include "virtio_user/virtio_user_dev.h"
 
 static int eth_virtio_dev_uninit(struct rte_eth_dev *eth_dev);
@@ -87,6 +88,8 @@ static int virtio_dev_queue_stats_mapping_set(
 
 static void virtio_notify_peers(struct rte_eth_dev *dev);
 static void virtio_ack_link_announce(struct rte_eth_dev *dev);
+static void virtio_recycle_rxq_info_get(struct rte_eth_dev *dev,
+	uint16_t queue_id, struct rte_eth_recycle_rxq_info *recycle_rxq_info);
 
 /*
  * The set of PCI devices this driver supports
@@ -923,6 +926,7 @@ static const struct eth_dev_ops virtio_eth_dev_ops = {
 	.rx_descriptor_done      = virtio_dev_rx_queue_done,
 	.tx_queue_setup          = virtio_dev_tx_queue_setup,
 	.tx_queue_release        = virtio_dev_queue_release,
+	.recycle_rxq_info_get    = virtio_recycle_rxq_info_get,
 	/* collect stats per queue */
 	.queue_stats_mapping_set = virtio_dev_queue_stats_mapping_set,
 	.vlan_filter_set         = virtio_vlan_filter_set,
@@ -1507,6 +1511,21 @@ virtio_interrupt_handler(void *param)
 	}
 }
 
+static void
+virtio_recycle_rxq_info_get(struct rte_eth_dev *dev, uint16_t queue_id,
+	struct rte_eth_recycle_rxq_info *recycle_rxq_info)
+{
+	struct virtnet_rx *rxvq = dev->data->rx_queues[queue_id];
+	struct virtqueue *vq = rxvq->vq;
+
+	recycle_rxq_info->mbuf_ring = vq->sw_ring;
+	recycle_rxq_info->mp = rxvq->mpool;
+	recycle_rxq_info->mbuf_ring_size = vq->vq_nentries;
+	recycle_rxq_info->refill_requirement = RTE_VIRTIO_VPMD_RX_REARM_THRESH;
+	recycle_rxq_info->refill_head = &vq->vq_avail_idx;
+	recycle_rxq_info->receive_tail = &vq->vq_used_cons_idx;
+}
+
 /* set rx and tx handlers according to what is supported */
 static void
 set_rxtx_funcs(struct rte_eth_dev *eth_dev)
@@ -1514,6 +1533,8 @@ set_rxtx_funcs(struct rte_eth_dev *eth_dev)
 	struct virtio_hw *hw = eth_dev->data->dev_private;
 
 	eth_dev->tx_pkt_prepare = virtio_xmit_pkts_prepare;
+	eth_dev->recycle_tx_mbufs_reuse = NULL;
+	eth_dev->recycle_rx_descriptors_refill = NULL;
 	if (vtpci_packed_queue(hw)) {
 		PMD_INIT_LOG(INFO,
 			"virtio: using packed ring %s Tx path on port %u",
@@ -1532,6 +1553,8 @@ set_rxtx_funcs(struct rte_eth_dev *eth_dev)
 			PMD_INIT_LOG(INFO, "virtio: using standard Tx path on port %u",
 				eth_dev->data->port_id);
 			eth_dev->tx_pkt_burst = virtio_xmit_pkts;
+			eth_dev->recycle_tx_mbufs_reuse =
+				virtio_recycle_tx_mbufs_reuse;
 		}
 	}
 
@@ -1559,6 +1582,8 @@ set_rxtx_funcs(struct rte_eth_dev *eth_dev)
 			PMD_INIT_LOG(INFO, "virtio: using vectorized Rx path on port %u",
 				eth_dev->data->port_id);
 			eth_dev->rx_pkt_burst = virtio_recv_pkts_vec;
+			eth_dev->recycle_rx_descriptors_refill =
+				virtio_recycle_rx_descriptors_refill_vec;
 		} else if (hw->use_inorder_rx) {
 			PMD_INIT_LOG(INFO,
 				"virtio: using inorder Rx path on port %u",
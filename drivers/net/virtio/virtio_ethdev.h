@@ -111,6 +111,10 @@ uint16_t virtio_recv_pkts_packed_vec(void *rx_queue, struct rte_mbuf **rx_pkts,
 uint16_t virtio_xmit_pkts_packed_vec(void *tx_queue, struct rte_mbuf **tx_pkts,
 		uint16_t nb_pkts);
 
+uint16_t virtio_recycle_tx_mbufs_reuse(void *tx_queue,
+		struct rte_eth_recycle_rxq_info *recycle_rxq_info);
+void virtio_recycle_rx_descriptors_refill_vec(void *rx_queue, uint16_t nb);
+
 int eth_virtio_dev_init(struct rte_eth_dev *eth_dev);
 
 void virtio_interrupt_handler(void *param);
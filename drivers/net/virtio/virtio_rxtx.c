@@ -1893,6 +1893,91 @@ virtio_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
 	return nb_tx;
 }
 
+/*
+ * Cleanup completed transmits of a split ring and move the freed mbufs
+ * into the Rx mbuf ring described by recycle_rxq_info, instead of putting
+ * them back to the mempool. Only single segment mbufs, of which Tx held
+ * the last reference and which belong to the Rx queue mempool, can be
+ * recycled; the other ones are freed as usual.
+ */
+uint16_t
+virtio_recycle_tx_mbufs_reuse(void *tx_queue,
+		struct rte_eth_recycle_rxq_info *recycle_rxq_info)
+{
+	struct virtnet_tx *txvq = tx_queue;
+	struct virtqueue *vq = txvq->vq;
+	struct rte_mempool *mp = recycle_rxq_info->mp;
+	struct vring_used_elem *uep;
+	struct vq_desc_extra *dxp;
+	struct rte_mbuf **rxep, *m;
+	uint16_t mbuf_ring_size = recycle_rxq_info->mbuf_ring_size;
+	uint16_t mask = mbuf_ring_size - 1;
+	uint16_t refill_requirement = recycle_rxq_info->refill_requirement;
+	uint16_t refill_head = *recycle_rxq_info->refill_head;
+	uint16_t receive_tail = *recycle_rxq_info->receive_tail;
+	uint16_t avail, nb_used, n, i, used_idx, desc_idx;
+	uint16_t nb_recycle = 0;
+
+	/* Get available recycling Rx buffers. */
+	avail = (mbuf_ring_size - (uint16_t)(refill_head - receive_tail)) &
+		mask;
+	refill_head &= mask;
+
+	nb_used = virtqueue_nused(vq);
+
+	if (refill_requirement != 0) {
+		n = refill_requirement;
+		if (avail < n || nb_used < n)
+			return 0;
+	} else {
+		n = RTE_MIN(avail, nb_used);
+		if (n == 0)
+			return 0;
+	}
+
+	/* Refilling does not support Rx mbuf ring wrapping around */
+	if (refill_head + n > mbuf_ring_size) {
+		if (refill_requirement != 0)
+			return 0;
+		n = mbuf_ring_size - refill_head;
+	}
+
+	rxep = &recycle_rxq_info->mbuf_ring[refill_head];
+
+	for (i = 0; i < n; i++) {
+		used_idx = (uint16_t)(vq->vq_used_cons_idx &
+				(vq->vq_nentries - 1));
+		uep = &vq->vq_split.ring.used->ring[used_idx];
+
+		desc_idx = (uint16_t)uep->id;
+		dxp = &vq->vq_descx[desc_idx];
+		vq->vq_used_cons_idx++;
+		vq_ring_free_chain(vq, desc_idx);
+
+		m = dxp->cookie;
+		dxp->cookie = NULL;
+		if (unlikely(m == NULL))
+			continue;
+
+		if (likely(m->nb_segs == 1 && m->pool == mp)) {
+			m = rte_pktmbuf_prefree_seg(m);
+			if (likely(m != NULL))
+				rxep[nb_recycle++] = m;
+		} else {
+			rte_pktmbuf_free(m);
+		}
+	}
+
+	/* Rx can only be refilled with a full batch of mbufs */
+	if (refill_requirement != 0 && nb_recycle != refill_requirement) {
+		for (i = 0; i < nb_recycle; i++)
+			rte_mbuf_raw_free(rxep[i]);
+		nb_recycle = 0;
+	}
+
+	return nb_recycle;
+}
+
 static __rte_always_inline int
 virtio_xmit_try_cleanup_inorder(struct virtqueue *vq, uint16_t need)
 {
@@ -46,6 +46,18 @@ virtio_rxq_vec_setup(struct virtnet_rx *rxq)
 	return 0;
 }
 
+void
+virtio_recycle_rx_descriptors_refill_vec(void *rx_queue, uint16_t nb)
+{
+	struct virtnet_rx *rxvq = rx_queue;
+	struct virtqueue *vq = rxvq->vq;
+
+	/* The recycled mbufs have been stored at the avail index */
+	virtio_rxq_refill_vec(rxvq, nb);
+	if (unlikely(virtqueue_kick_prepare(vq)))
+		virtqueue_notify(vq);
+}
+
 /* Stub for linkage when arch specific implementation is not available */
 __rte_weak uint16_t
 virtio_recv_pkts_vec(void *rx_queue __rte_unused,
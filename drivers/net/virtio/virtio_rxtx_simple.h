@@ -15,29 +15,23 @@
 #define RTE_VIRTIO_VPMD_RX_BURST 32
 #define RTE_VIRTIO_VPMD_RX_REARM_THRESH RTE_VIRTIO_VPMD_RX_BURST
 
+/* Hand the mbufs already stored in the sw ring at the avail index
+ * over to the device.
+ */
 static inline void
-virtio_rxq_rearm_vec(struct virtnet_rx *rxvq)
+virtio_rxq_refill_vec(struct virtnet_rx *rxvq, uint16_t nb)
 {
-	int i;
+	uint16_t i;
 	uint16_t desc_idx;
 	struct rte_mbuf **sw_ring;
 	struct vring_desc *start_dp;
-	int ret;
 	struct virtqueue *vq = rxvq->vq;
 
 	desc_idx = vq->vq_avail_idx & (vq->vq_nentries - 1);
 	sw_ring = &vq->sw_ring[desc_idx];
 	start_dp = &vq->vq_split.ring.desc[desc_idx];
 
-	ret = rte_mempool_get_bulk(rxvq->mpool, (void **)sw_ring,
-		RTE_VIRTIO_VPMD_RX_REARM_THRESH);
-	if (unlikely(ret)) {
-		rte_eth_devices[rxvq->port_id].data->rx_mbuf_alloc_failed +=
-			RTE_VIRTIO_VPMD_RX_REARM_THRESH;
-		return;
-	}
-
-	for (i = 0; i < RTE_VIRTIO_VPMD_RX_REARM_THRESH; i++) {
+	for (i = 0; i < nb; i++) {
 		uintptr_t p;
 
 		p = (uintptr_t)&sw_ring[i]->rearm_data;
@@ -50,9 +44,31 @@ virtio_rxq_rearm_vec(struct virtnet_rx *rxvq)
 			RTE_PKTMBUF_HEADROOM + vq->hw->vtnet_hdr_size;
 	}
 
-	vq->vq_avail_idx += RTE_VIRTIO_VPMD_RX_REARM_THRESH;
-	vq->vq_free_cnt -= RTE_VIRTIO_VPMD_RX_REARM_THRESH;
+	vq->vq_avail_idx += nb;
+	vq->vq_free_cnt -= nb;
 	vq_update_avail_idx(vq);
 }
 
+static inline void
+virtio_rxq_rearm_vec(struct virtnet_rx *rxvq)
+{
+	uint16_t desc_idx;
+	struct rte_mbuf **sw_ring;
+	int ret;
+	struct virtqueue *vq = rxvq->vq;
+
+	desc_idx = vq->vq_avail_idx & (vq->vq_nentries - 1);
+	sw_ring = &vq->sw_ring[desc_idx];
+
+	ret = rte_mempool_get_bulk(rxvq->mpool, (void **)sw_ring,
+		RTE_VIRTIO_VPMD_RX_REARM_THRESH);
+	if (unlikely(ret)) {
+		rte_eth_devices[rxvq->port_id].data->rx_mbuf_alloc_failed +=
+			RTE_VIRTIO_VPMD_RX_REARM_THRESH;
+		return;
+	}
+
+	virtio_rxq_refill_vec(rxvq, RTE_VIRTIO_VPMD_RX_REARM_THRESH);
+}
+
 #endif /* _VIRTIO_RXTX_SIMPLE_H_ */
@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <sys/uio.h>
+
+#include <rte_eal.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_memcpy.h>
+#include <rte_pause.h>
+#include <rte_vhost.h>
+
+#include "main.h"
+#include "cpu_copy.h"
+
+/* segments queued per channel, power of 2 */
+#define CPU_COPY_RING_SIZE 4096
+#define CPU_COPY_RING_MASK (CPU_COPY_RING_SIZE - 1)
+/* segments copied for a channel before moving to the next one */
+#define CPU_COPY_BURST 64
+#define CPU_COPY_MAX_CHANNELS (MAX_VHOST_DEVICE * VIRTIO_QNUM)
+
+struct cpu_copy_seg {
+	void *src;
+	void *dst;
+	size_t len;
+};
+
+/*
+ * Segments go from the vhost data core to the copy core through a single
+ * producer, single consumer ring. The copy core moves the tail once the
+ * data is copied, completions are the segments behind the tail.
+ */
+struct cpu_copy_channel {
+	/* owned by the vhost data core */
+	uint32_t head;
+	uint32_t nr_reported;
+	/* owned by the copy core */
+	uint32_t tail __rte_cache_aligned;
+	struct cpu_copy_seg segs[CPU_COPY_RING_SIZE] __rte_cache_aligned;
+};
+
+static struct cpu_copy_channel *channels[CPU_COPY_MAX_CHANNELS];
+/* channels[] slots ever used, scanned by the copy core */
+static uint32_t nr_channels;
+/* bumped on each pass of the copy core over the channels */
+static uint32_t copy_epoch;
+static unsigned int copy_lcore = RTE_MAX_LCORE;
+static int copy_quit;
+
+static int
+cpu_copy_worker(void *arg __rte_unused)
+{
+	struct cpu_copy_channel *ch;
+	struct cpu_copy_seg *seg;
+	uint32_t i, n, head, tail;
+
+	RTE_LOG(INFO, VHOST_DATA, "CPU copy engine on core %u started\n",
+		rte_lcore_id());
+
+	while (!__atomic_load_n(&copy_quit, __ATOMIC_RELAXED)) {
+		n = __atomic_load_n(&nr_channels, __ATOMIC_ACQUIRE);
+		for (i = 0; i < n; i++) {
+			ch = __atomic_load_n(&channels[i], __ATOMIC_ACQUIRE);
+			if (ch == NULL)
+				continue;
+
+			head = __atomic_load_n(&ch->head, __ATOMIC_ACQUIRE);
+			tail = ch->tail;
+			if (head - tail > CPU_COPY_BURST)
+				head = tail + CPU_COPY_BURST;
+
+			for (; tail != head; tail++) {
+				seg = &ch->segs[tail & CPU_COPY_RING_MASK];
+				rte_memcpy(seg->dst, seg->src, seg->len);
+			}
+			__atomic_store_n(&ch->tail, tail, __ATOMIC_RELEASE);
+		}
+		__atomic_add_fetch(&copy_epoch, 1, __ATOMIC_RELEASE);
+	}
+
+	return 0;
+}
+
+int
+cpu_copy_start(unsigned int lcore_id)
+{
+	/* vhost passes IO addresses, the CPU can only use them as VA */
+	if (rte_eal_iova_mode() != RTE_IOVA_VA) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"CPU copy engine needs IOVA as VA mode\n");
+		return -1;
+	}
+
+	if (lcore_id == rte_get_master_lcore() ||
+			!rte_lcore_is_enabled(lcore_id)) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"Invalid core %u for the CPU copy engine\n", lcore_id);
+		return -1;
+	}
+
+	copy_lcore = lcore_id;
+	__atomic_store_n(&copy_quit, 0, __ATOMIC_RELAXED);
+	return rte_eal_remote_launch(cpu_copy_worker, NULL, lcore_id);
+}
+
+void
+cpu_copy_stop(void)
+{
+	if (copy_lcore == RTE_MAX_LCORE)
+		return;
+
+	__atomic_store_n(&copy_quit, 1, __ATOMIC_RELAXED);
+	rte_eal_wait_lcore(copy_lcore);
+	copy_lcore = RTE_MAX_LCORE;
+}
+
+int
+cpu_copy_attach(int vid, uint16_t queue_id)
+{
+	uint32_t idx = vid * VIRTIO_QNUM + queue_id;
+	struct cpu_copy_channel *ch;
+
+	if (queue_id >= VIRTIO_QNUM || idx >= CPU_COPY_MAX_CHANNELS)
+		return -1;
+
+	ch = rte_zmalloc_socket("cpu_copy_channel", sizeof(*ch),
+			RTE_CACHE_LINE_SIZE, rte_lcore_to_socket_id(copy_lcore));
+	if (ch == NULL)
+		return -1;
+
+	__atomic_store_n(&channels[idx], ch, __ATOMIC_RELEASE);
+	if (idx >= __atomic_load_n(&nr_channels, __ATOMIC_RELAXED))
+		__atomic_store_n(&nr_channels, idx + 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+void
+cpu_copy_detach(int vid, uint16_t queue_id)
+{
+	uint32_t idx = vid * VIRTIO_QNUM + queue_id;
+	struct cpu_copy_channel *ch;
+	uint32_t epoch;
+
+	if (queue_id >= VIRTIO_QNUM || idx >= CPU_COPY_MAX_CHANNELS)
+		return;
+
+	ch = channels[idx];
+	if (ch == NULL)
+		return;
+
+	__atomic_store_n(&channels[idx], NULL, __ATOMIC_RELEASE);
+
+	/* the pass in progress may still use the channel, wait for the next */
+	epoch = __atomic_load_n(&copy_epoch, __ATOMIC_ACQUIRE);
+	while (__atomic_load_n(&copy_epoch, __ATOMIC_ACQUIRE) - epoch < 2)
+		rte_pause();
+
+	rte_free(ch);
+}
+
+uint32_t
+cpu_copy_transfer_data_cb(int vid, uint16_t queue_id,
+		struct rte_vhost_async_desc *descs,
+		struct rte_vhost_async_status *opaque_data __rte_unused,
+		uint16_t count)
+{
+	struct cpu_copy_channel *ch = channels[vid * VIRTIO_QNUM + queue_id];
+	struct rte_vhost_iov_iter *src, *dst;
+	struct cpu_copy_seg *seg;
+	uint32_t head, tail;
+	uint16_t i;
+	unsigned long j;
+
+	head = ch->head;
+	tail = __atomic_load_n(&ch->tail, __ATOMIC_ACQUIRE);
+
+	for (i = 0; i < count; i++) {
+		src = descs[i].src;
+		dst = descs[i].dst;
+
+		/* a packet is queued whole or not at all */
+		if (src->nr_segs > CPU_COPY_RING_SIZE - (head - tail))
+			break;
+
+		for (j = 0; j < src->nr_segs; j++) {
+			seg = &ch->segs[head++ & CPU_COPY_RING_MASK];
+			seg->src = src->iov[j].iov_base;
+			seg->dst = dst->iov[j].iov_base;
+			seg->len = src->iov[j].iov_len;
+		}
+	}
+
+	__atomic_store_n(&ch->head, head, __ATOMIC_RELEASE);
+
+	return i;
+}
+
+uint32_t
+cpu_copy_check_completed_copies_cb(int vid, uint16_t queue_id,
+		struct rte_vhost_async_status *opaque_data __rte_unused,
+		uint16_t max_packets)
+{
+	struct cpu_copy_channel *ch = channels[vid * VIRTIO_QNUM + queue_id];
+	uint32_t n;
+
+	n = __atomic_load_n(&ch->tail, __ATOMIC_ACQUIRE) - ch->nr_reported;
+	n = RTE_MIN(n, (uint32_t)max_packets);
+	ch->nr_reported += n;
+
+	return n;
+}
@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#ifndef _CPU_COPY_H_
+#define _CPU_COPY_H_
+
+#include <rte_vhost.h>
+#include <rte_vhost_async.h>
+
+/*
+ * Reference async copy engine: one lcore does the copies of all the
+ * vhost queues attached to it, with memcpy. It needs no DMA hardware,
+ * which makes it a baseline for the async data path.
+ */
+
+int cpu_copy_start(unsigned int lcore_id);
+
+/* The channels must be detached before the engine is stopped. */
+void cpu_copy_stop(void);
+
+int cpu_copy_attach(int vid, uint16_t queue_id);
+
+void cpu_copy_detach(int vid, uint16_t queue_id);
+
+uint32_t
+cpu_copy_transfer_data_cb(int vid, uint16_t queue_id,
+		struct rte_vhost_async_desc *descs,
+		struct rte_vhost_async_status *opaque_data, uint16_t count);
+
+uint32_t
+cpu_copy_check_completed_copies_cb(int vid, uint16_t queue_id,
+		struct rte_vhost_async_status *opaque_data,
+		uint16_t max_packets);
+#endif /* _CPU_COPY_H_ */
@@ -26,6 +26,7 @@
 #include <rte_pause.h>
 
 #include "main.h"
+#include "cpu_copy.h"
 
 #ifndef MAX_QUEUES
 #define MAX_QUEUES 128
@@ -96,6 +97,11 @@ static int dequeue_zero_copy;
 
 static int builtin_net_driver;
 
+/* Async copy of the vhost queues on a CPU copy core, disabled if invalid. */
+static unsigned int async_copy_lcore = RTE_MAX_LCORE;
+/* Copies shorter than this are done by the data core itself. */
+static uint32_t async_threshold = 256;
+
 /* Specify timeout (in useconds) between retries on RX. */
 static uint32_t burst_rx_delay_time = BURST_RX_WAIT_US;
 /* Specify the number of retries on RX. */
@@ -458,7 +464,9 @@ us_vhost_usage(const char *prgname)
 	"		--tx-csum [0|1] disable/enable TX checksum offload.\n"
 	"		--tso [0|1] disable/enable TCP segment offload.\n"
 	"		--client register a vhost-user socket as client mode.\n"
-	"		--dequeue-zero-copy enables dequeue zero copy\n",
+	"		--dequeue-zero-copy enables dequeue zero copy\n"
+	"		--async-copy-lcore ID: copy the vhost queue data on core ID, needs IOVA as VA mode\n"
+	"		--async-threshold [0-4095]: copies shorter than this are done by the data core (default 256)\n",
 	       prgname);
 }
 
@@ -485,6 +493,8 @@ us_vhost_parse_args(int argc, char **argv)
 		{"client", no_argument, &client_mode, 1},
 		{"dequeue-zero-copy", no_argument, &dequeue_zero_copy, 1},
 		{"builtin-net-driver", no_argument, &builtin_net_driver, 1},
+		{"async-copy-lcore", required_argument, NULL, 0},
+		{"async-threshold", required_argument, NULL, 0},
 		{NULL, 0, 0, 0},
 	};
 
@@ -627,6 +637,35 @@ us_vhost_parse_args(int argc, char **argv)
 				}
 			}
 
+			/* Set the core doing the async copies. */
+			if (!strncmp(long_option[option_index].name,
+						"async-copy-lcore", MAX_LONG_OPT_SZ)) {
+				ret = parse_num_opt(optarg, RTE_MAX_LCORE - 1);
+				if (ret == -1) {
+					RTE_LOG(INFO, VHOST_CONFIG,
+						"Invalid argument for async-copy-lcore [0-%u]\n",
+						RTE_MAX_LCORE - 1);
+					us_vhost_usage(prgname);
+					return -1;
+				} else {
+					async_copy_lcore = ret;
+				}
+			}
+
+			/* Set the async copy threshold. */
+			if (!strncmp(long_option[option_index].name,
+						"async-threshold", MAX_LONG_OPT_SZ)) {
+				ret = parse_num_opt(optarg, 4095);
+				if (ret == -1) {
+					RTE_LOG(INFO, VHOST_CONFIG,
+						"Invalid argument for async-threshold [0-4095]\n");
+					us_vhost_usage(prgname);
+					return -1;
+				} else {
+					async_threshold = ret;
+				}
+			}
+
 			break;
 
 			/* Invalid option - print options. */
@@ -641,6 +680,14 @@ us_vhost_parse_args(int argc, char **argv)
 			ports[num_ports++] = i;
 	}
 
+	if (async_copy_lcore != RTE_MAX_LCORE &&
+			(builtin_net_driver || dequeue_zero_copy)) {
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"async-copy-lcore does not work with builtin-net-driver "
+			"or dequeue-zero-copy\n");
+		return -1;
+	}
+
 	if ((num_ports ==  0) || (num_ports > MAX_SUP_PORTS)) {
 		RTE_LOG(INFO, VHOST_PORT, "Current enabled port number is %u,"
 			"but only %u port can be enabled\n",num_ports, MAX_SUP_PORTS);
@@ -785,6 +832,16 @@ virtio_xmit(struct vhost_dev *dst_vdev, struct vhost_dev *src_vdev,
 
 	if (builtin_net_driver) {
 		ret = vs_enqueue_pkts(dst_vdev, VIRTIO_RXQ, &m, 1);
+	} else if (async_copy_lcore != RTE_MAX_LCORE) {
+		/* the caller frees m, keep it until the copy completes */
+		rte_mbuf_refcnt_update(m, 1);
+		ret = rte_vhost_submit_enqueue_burst(dst_vdev->vid, VIRTIO_RXQ,
+						&m, 1);
+		if (ret)
+			__atomic_add_fetch(&dst_vdev->nr_async_pkts, ret,
+					__ATOMIC_RELAXED);
+		else
+			rte_mbuf_refcnt_update(m, -1);
 	} else {
 		ret = rte_vhost_enqueue_burst(dst_vdev->vid, VIRTIO_RXQ, &m, 1);
 	}
@@ -1033,6 +1090,22 @@ drain_mbuf_table(struct mbuf_table *tx_q)
 	}
 }
 
+/* free the packets whose async copy to the guest has completed */
+static __rte_always_inline void
+complete_async_pkts(struct vhost_dev *vdev)
+{
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	uint16_t complete_count;
+
+	complete_count = rte_vhost_poll_enqueue_completed(vdev->vid,
+					VIRTIO_RXQ, pkts, MAX_PKT_BURST);
+	if (complete_count) {
+		__atomic_sub_fetch(&vdev->nr_async_pkts, complete_count,
+				__ATOMIC_RELAXED);
+		free_pkts(pkts, complete_count);
+	}
+}
+
 static __rte_always_inline void
 drain_eth_rx(struct vhost_dev *vdev)
 {
@@ -1065,6 +1138,11 @@ drain_eth_rx(struct vhost_dev *vdev)
 	if (builtin_net_driver) {
 		enqueue_count = vs_enqueue_pkts(vdev, VIRTIO_RXQ,
 						pkts, rx_count);
+	} else if (async_copy_lcore != RTE_MAX_LCORE) {
+		enqueue_count = rte_vhost_submit_enqueue_burst(vdev->vid,
+					VIRTIO_RXQ, pkts, rx_count);
+		__atomic_add_fetch(&vdev->nr_async_pkts, enqueue_count,
+				__ATOMIC_RELAXED);
 	} else {
 		enqueue_count = rte_vhost_enqueue_burst(vdev->vid, VIRTIO_RXQ,
 						pkts, rx_count);
@@ -1074,7 +1152,11 @@ drain_eth_rx(struct vhost_dev *vdev)
 		rte_atomic64_add(&vdev->stats.rx_atomic, enqueue_count);
 	}
 
-	free_pkts(pkts, rx_count);
+	/* packets in flight are freed once their copy has completed */
+	if (async_copy_lcore != RTE_MAX_LCORE)
+		free_pkts(&pkts[enqueue_count], rx_count - enqueue_count);
+	else
+		free_pkts(pkts, rx_count);
 }
 
 static __rte_always_inline void
@@ -1083,10 +1165,15 @@ drain_virtio_tx(struct vhost_dev *vdev)
 	struct rte_mbuf *pkts[MAX_PKT_BURST];
 	uint16_t count;
 	uint16_t i;
+	int nr_inflight;
 
 	if (builtin_net_driver) {
 		count = vs_dequeue_pkts(vdev, VIRTIO_TXQ, mbuf_pool,
 					pkts, MAX_PKT_BURST);
+	} else if (async_copy_lcore != RTE_MAX_LCORE) {
+		count = rte_vhost_async_try_dequeue_burst(vdev->vid,
+					VIRTIO_TXQ, mbuf_pool, pkts,
+					MAX_PKT_BURST, &nr_inflight);
 	} else {
 		count = rte_vhost_dequeue_burst(vdev->vid, VIRTIO_TXQ,
 					mbuf_pool, pkts, MAX_PKT_BURST);
@@ -1158,6 +1245,9 @@ switch_worker(void *arg __rte_unused)
 				continue;
 			}
 
+			if (async_copy_lcore != RTE_MAX_LCORE)
+				complete_async_pkts(vdev);
+
 			if (likely(vdev->ready == DEVICE_RX))
 				drain_eth_rx(vdev);
 
@@ -1169,6 +1259,64 @@ switch_worker(void *arg __rte_unused)
 	return 0;
 }
 
+static void
+async_vhost_remove(struct vhost_dev *vdev)
+{
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	uint16_t count;
+	int nr_inflight = 0;
+
+	/* no data core uses the device anymore, wait for its copies */
+	while (__atomic_load_n(&vdev->nr_async_pkts, __ATOMIC_RELAXED))
+		complete_async_pkts(vdev);
+
+	do {
+		count = rte_vhost_async_try_dequeue_burst(vdev->vid,
+				VIRTIO_TXQ, mbuf_pool, pkts, MAX_PKT_BURST,
+				&nr_inflight);
+		free_pkts(pkts, count);
+	} while (nr_inflight > 0);
+
+	rte_vhost_async_channel_unregister(vdev->vid, VIRTIO_RXQ);
+	rte_vhost_async_channel_unregister(vdev->vid, VIRTIO_TXQ);
+	cpu_copy_detach(vdev->vid, VIRTIO_RXQ);
+	cpu_copy_detach(vdev->vid, VIRTIO_TXQ);
+}
+
+static int
+async_vhost_setup(struct vhost_dev *vdev)
+{
+	struct rte_vhost_async_channel_ops channel_ops = {
+		.transfer_data = cpu_copy_transfer_data_cb,
+		.check_completed_copies = cpu_copy_check_completed_copies_cb,
+	};
+	struct rte_vhost_async_features f;
+	uint16_t queue_id;
+
+	f.intval = 0;
+	f.async_inorder = 1;
+	f.async_threshold = async_threshold;
+
+	for (queue_id = VIRTIO_RXQ; queue_id < VIRTIO_QNUM; queue_id++) {
+		if (cpu_copy_attach(vdev->vid, queue_id) != 0)
+			goto err;
+		if (rte_vhost_async_channel_register(vdev->vid, queue_id,
+				f.intval, &channel_ops) != 0) {
+			cpu_copy_detach(vdev->vid, queue_id);
+			goto err;
+		}
+	}
+
+	return 0;
+
+err:
+	while (queue_id-- > VIRTIO_RXQ) {
+		rte_vhost_async_channel_unregister(vdev->vid, queue_id);
+		cpu_copy_detach(vdev->vid, queue_id);
+	}
+	return -1;
+}
+
 /*
  * Remove a device from the specific data core linked list and from the
  * main linked list. Synchonization  occurs through the use of the
@@ -1202,8 +1350,11 @@ destroy_device(int vid)
 
 
 	/* Set the dev_removal_flag on each lcore. */
-	RTE_LCORE_FOREACH_SLAVE(lcore)
+	RTE_LCORE_FOREACH_SLAVE(lcore) {
+		if ((unsigned int)lcore == async_copy_lcore)
+			continue;
 		lcore_info[lcore].dev_removal_flag = REQUEST_DEV_REMOVAL;
+	}
 
 	/*
 	 * Once each core has set the dev_removal_flag to ACK_DEV_REMOVAL
@@ -1211,10 +1362,15 @@ destroy_device(int vid)
 	 * from the linked lists and that the devices are no longer in use.
 	 */
 	RTE_LCORE_FOREACH_SLAVE(lcore) {
+		if ((unsigned int)lcore == async_copy_lcore)
+			continue;
 		while (lcore_info[lcore].dev_removal_flag != ACK_DEV_REMOVAL)
 			rte_pause();
 	}
 
+	if (async_copy_lcore != RTE_MAX_LCORE)
+		async_vhost_remove(vdev);
+
 	lcore_info[vdev->coreid].device_num--;
 
 	RTE_LOG(INFO, VHOST_DATA,
@@ -1247,6 +1403,14 @@ new_device(int vid)
 	if (builtin_net_driver)
 		vs_vhost_net_setup(vdev);
 
+	if (async_copy_lcore != RTE_MAX_LCORE &&
+			async_vhost_setup(vdev) != 0) {
+		RTE_LOG(INFO, VHOST_DATA,
+			"(%d) couldn't register async channels\n", vid);
+		rte_free(vdev);
+		return -1;
+	}
+
 	TAILQ_INSERT_TAIL(&vhost_dev_list, vdev, global_vdev_entry);
 	vdev->vmdq_rx_q = vid * queues_per_pool + vmdq_queue_base;
 
@@ -1256,6 +1420,8 @@ new_device(int vid)
 
 	/* Find a suitable lcore to add the device. */
 	RTE_LCORE_FOREACH_SLAVE(lcore) {
+		if ((unsigned int)lcore == async_copy_lcore)
+			continue;
 		if (lcore_info[lcore].device_num < device_num_min) {
 			device_num_min = lcore_info[lcore].device_num;
 			core_add = lcore;
@@ -1503,9 +1669,19 @@ main(int argc, char *argv[])
 				"Cannot create print-stats thread\n");
 	}
 
+	if (async_copy_lcore != RTE_MAX_LCORE) {
+		if (cpu_copy_start(async_copy_lcore) != 0)
+			rte_exit(EXIT_FAILURE,
+				"Cannot start the CPU copy engine\n");
+		flags |= RTE_VHOST_USER_ASYNC_COPY;
+	}
+
 	/* Launch all data cores. */
-	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (lcore_id == async_copy_lcore)
+			continue;
 		rte_eal_remote_launch(switch_worker, NULL, lcore_id);
+	}
 
 	if (client_mode)
 		flags |= RTE_VHOST_USER_CLIENT;
@@ -18,6 +18,8 @@ enum {VIRTIO_RXQ, VIRTIO_TXQ, VIRTIO_QNUM};
 
 #define MAX_PKT_BURST 32		/* Max burst size for RX/TX */
 
+#define MAX_VHOST_DEVICE 1024
+
 struct device_statistics {
 	uint64_t	tx;
 	uint64_t	tx_total;
@@ -51,6 +53,8 @@ struct vhost_dev {
 	uint64_t features;
 	size_t hdr_len;
 	uint16_t nr_vrings;
+	/**< Packets submitted to the guest RX queue and not yet copied. */
+	uint64_t nr_async_pkts;
 	struct rte_vhost_memory *mem;
 	struct device_statistics stats;
 	TAILQ_ENTRY(vhost_dev) global_vdev_entry;
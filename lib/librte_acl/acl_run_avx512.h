@@ -0,0 +1,259 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include "acl_run_sse.h"
+
+/* number of flows processed by one 512-bit register */
+#define ZMM_FLOWS	(ZMM_SIZE / sizeof(uint32_t))
+
+/* max number of 512-bit registers used by one search */
+#define ZMM_MAX_NUM	(MAX_SEARCHES_AVX512X32 / ZMM_FLOWS)
+
+static const rte_zmm_t zmm_shuffle_input = {
+	.u32 = {
+		0x00000000, 0x04040404, 0x08080808, 0x0c0c0c0c,
+		0x00000000, 0x04040404, 0x08080808, 0x0c0c0c0c,
+		0x00000000, 0x04040404, 0x08080808, 0x0c0c0c0c,
+		0x00000000, 0x04040404, 0x08080808, 0x0c0c0c0c,
+	},
+};
+
+static const rte_zmm_t zmm_range_base = {
+	.u32 = {
+		0xffffff00, 0xffffff04, 0xffffff08, 0xffffff0c,
+		0xffffff00, 0xffffff04, 0xffffff08, 0xffffff0c,
+		0xffffff00, 0xffffff04, 0xffffff08, 0xffffff0c,
+		0xffffff00, 0xffffff04, 0xffffff08, 0xffffff0c,
+	},
+};
+
+/*
+ * Calculate the address of the next transition for 16 flows.
+ * Same algorithm as ACL_TR_CALC_ADDR(), but with comparison results
+ * kept in the mask registers instead of the vector ones:
+ * - DFA nodes: index minus the range base selected by the
+ *   two most significant bits of the input byte.
+ * - QUAD/SINGLE nodes: number of range boundaries (signed bytes
+ *   of tr_hi) that are less than the input byte.
+ */
+static __rte_always_inline zmm_t
+calc_addr_avx512x16(zmm_t index_mask, zmm_t next_input, zmm_t tr_lo,
+	zmm_t tr_hi)
+{
+	__mmask64 qmsk;
+	__mmask16 dfa_msk;
+	zmm_t addr, in, node_type, r, t;
+	zmm_t dfa_ofs, quad_ofs;
+
+	in = _mm512_shuffle_epi8(next_input, zmm_shuffle_input.z);
+
+	/* Calc node type and node addr */
+	node_type = _mm512_andnot_si512(index_mask, tr_lo);
+	addr = _mm512_and_si512(index_mask, tr_lo);
+
+	/* mask for DFA type(0) nodes */
+	dfa_msk = _mm512_testn_epi32_mask(node_type, node_type);
+
+	/* DFA calculations. */
+	r = _mm512_srli_epi32(in, 30);
+	r = _mm512_add_epi8(r, zmm_range_base.z);
+	t = _mm512_srli_epi32(in, 24);
+	r = _mm512_shuffle_epi8(tr_hi, r);
+
+	dfa_ofs = _mm512_sub_epi32(t, r);
+
+	/* QUAD/SINGLE calculations. */
+	qmsk = _mm512_cmpgt_epi8_mask(in, tr_hi);
+	t = _mm512_maskz_set1_epi8(qmsk, 1);
+	t = _mm512_maddubs_epi16(t, t);
+	quad_ofs = _mm512_madd_epi16(t, _mm512_set1_epi16(1));
+
+	/* blend DFA and QUAD/SINGLE. */
+	t = _mm512_mask_mov_epi32(quad_ofs, dfa_msk, dfa_ofs);
+
+	/* calculate address for next transitions. */
+	return _mm512_add_epi32(addr, t);
+}
+
+/*
+ * Process 16 transitions in parallel.
+ * tr_lo contains low 32 bits for 16 transitions.
+ * tr_hi contains high 32 bits for 16 transitions.
+ * next_input contains up to 4 input bytes for 16 flows.
+ */
+static __rte_always_inline zmm_t
+transition16(zmm_t next_input, const uint64_t *trans, zmm_t *tr_lo,
+	zmm_t *tr_hi)
+{
+	const int32_t *tr;
+	zmm_t addr;
+
+	tr = (const int32_t *)(uintptr_t)trans;
+
+	/* Calculate the address (array index) for all 16 transitions. */
+	addr = calc_addr_avx512x16(_mm512_set1_epi32(RTE_ACL_NODE_INDEX),
+		next_input, *tr_lo, *tr_hi);
+
+	/* load lower 32 bits of 16 transactions at once. */
+	*tr_lo = _mm512_i32gather_epi32(addr, tr, sizeof(trans[0]));
+
+	next_input = _mm512_srli_epi32(next_input, CHAR_BIT);
+
+	/* load high 32 bits of 16 transactions at once. */
+	*tr_hi = _mm512_i32gather_epi32(addr, tr + 1, sizeof(trans[0]));
+
+	return next_input;
+}
+
+/*
+ * Process matches for 16 flows.
+ * Only the flows selected by the matches mask are touched,
+ * all other transitions are kept intact.
+ */
+static inline void
+acl_process_matches_avx512x16(const struct rte_acl_ctx *ctx,
+	struct parms *parms, struct acl_flow_data *flows, uint32_t slot,
+	__mmask16 matches, zmm_t *tr_lo, zmm_t *tr_hi)
+{
+	uint32_t i, msk;
+	uint64_t tr;
+	rte_zmm_t lo, hi;
+
+	lo.z = *tr_lo;
+	hi.z = *tr_hi;
+
+	for (msk = matches; msk != 0; msk &= msk - 1) {
+
+		i = __builtin_ctz(msk);
+		tr = (uint64_t)hi.u32[i] << 32 | lo.u32[i];
+
+		tr = acl_match_check(tr, slot + i,
+			ctx, parms, flows, resolve_priority_sse);
+
+		lo.u32[i] = (uint32_t)tr;
+		hi.u32[i] = tr >> 32;
+	}
+
+	*tr_lo = lo.z;
+	*tr_hi = hi.z;
+}
+
+static inline void
+acl_match_check_avx512x16(const struct rte_acl_ctx *ctx, struct parms *parms,
+	struct acl_flow_data *flows, uint32_t slot,
+	zmm_t *tr_lo, zmm_t *tr_hi, zmm_t match_mask)
+{
+	__mmask16 matches;
+
+	/* test for match node */
+	matches = _mm512_test_epi32_mask(*tr_lo, match_mask);
+
+	while (matches != 0) {
+
+		acl_process_matches_avx512x16(ctx, parms, flows, slot,
+			matches, tr_lo, tr_hi);
+		matches = _mm512_test_epi32_mask(*tr_lo, match_mask);
+	}
+}
+
+/*
+ * Gather 4 bytes of input data for 16 flows.
+ */
+static __rte_always_inline zmm_t
+get_next_4bytes_avx512x16(struct parms *parms, uint32_t slot)
+{
+	uint32_t i;
+	rte_zmm_t in;
+
+	for (i = 0; i != ZMM_FLOWS; i++)
+		in.u32[i] = GET_NEXT_4BYTES(parms, slot + i);
+
+	return in.z;
+}
+
+/*
+ * Execute trie traversal for up to (16 * num) flows in parallel,
+ * where num is the number of 512-bit registers to use (1 or 2).
+ */
+static __rte_always_inline int
+search_avx512x16xn(const struct rte_acl_ctx *ctx, const uint8_t **data,
+	uint32_t *results, uint32_t total_packets, uint32_t categories,
+	uint32_t num)
+{
+	uint32_t i, j, n;
+	uint64_t tr;
+	struct acl_flow_data flows;
+	struct completion cmplt[MAX_SEARCHES_AVX512X32];
+	struct parms parms[MAX_SEARCHES_AVX512X32];
+	rte_zmm_t lo[ZMM_MAX_NUM], hi[ZMM_MAX_NUM];
+	zmm_t input[ZMM_MAX_NUM], tr_lo[ZMM_MAX_NUM], tr_hi[ZMM_MAX_NUM];
+	zmm_t match_mask;
+
+	match_mask = _mm512_set1_epi32(RTE_ACL_NODE_MATCH);
+
+	acl_set_flow(&flows, cmplt, num * ZMM_FLOWS, data, results,
+		total_packets, categories, ctx->trans_table);
+
+	for (j = 0; j != num; j++) {
+		for (i = 0; i != ZMM_FLOWS; i++) {
+			n = j * ZMM_FLOWS + i;
+			cmplt[n].count = 0;
+			tr = acl_start_next_trie(&flows, parms, n, ctx);
+			lo[j].u32[i] = (uint32_t)tr;
+			hi[j].u32[i] = tr >> 32;
+		}
+		tr_lo[j] = lo[j].z;
+		tr_hi[j] = hi[j].z;
+	}
+
+	/* Check for any matches. */
+	for (j = 0; j != num; j++)
+		acl_match_check_avx512x16(ctx, parms, &flows, j * ZMM_FLOWS,
+			&tr_lo[j], &tr_hi[j], match_mask);
+
+	while (flows.started > 0) {
+
+		/* Gather 4 bytes of input data for all flows. */
+		for (j = 0; j != num; j++)
+			input[j] = get_next_4bytes_avx512x16(parms,
+				j * ZMM_FLOWS);
+
+		/* Process the 4 bytes of input on each flow. */
+		for (i = 0; i != sizeof(uint32_t); i++) {
+			for (j = 0; j != num; j++)
+				input[j] = transition16(input[j], flows.trans,
+					&tr_lo[j], &tr_hi[j]);
+		}
+
+		/* Check for any matches. */
+		for (j = 0; j != num; j++)
+			acl_match_check_avx512x16(ctx, parms, &flows,
+				j * ZMM_FLOWS, &tr_lo[j], &tr_hi[j],
+				match_mask);
+	}
+
+	return 0;
+}
+
+/*
+ * Execute trie traversal for up to 16 flows in parallel.
+ */
+static inline int
+search_avx512x16(const struct rte_acl_ctx *ctx, const uint8_t **data,
+	uint32_t *results, uint32_t total_packets, uint32_t categories)
+{
+	return search_avx512x16xn(ctx, data, results, total_packets,
+		categories, MAX_SEARCHES_AVX512X16 / ZMM_FLOWS);
+}
+
+/*
+ * Execute trie traversal for up to 32 flows in parallel.
+ */
+static inline int
+search_avx512x32(const struct rte_acl_ctx *ctx, const uint8_t **data,
+	uint32_t *results, uint32_t total_packets, uint32_t categories)
+{
+	return search_avx512x16xn(ctx, data, results, total_packets,
+		categories, MAX_SEARCHES_AVX512X32 / ZMM_FLOWS);
+}
@@ -16,6 +16,22 @@ static struct rte_tailq_elem rte_acl_tailq = {
 };
 EAL_REGISTER_TAILQ(rte_acl_tailq)
 
+#ifndef CC_AVX512_SUPPORT
+/*
+ * If the compiler doesn't support AVX512 instructions,
+ * then the dummy one would be used instead for AVX512 classify method.
+ */
+int
+rte_acl_classify_avx512(__rte_unused const struct rte_acl_ctx *ctx,
+	__rte_unused const uint8_t **data,
+	__rte_unused uint32_t *results,
+	__rte_unused uint32_t num,
+	__rte_unused uint32_t categories)
+{
+	return -ENOTSUP;
+}
+#endif
+
 #ifndef RTE_ARCH_X86
 #ifndef CC_AVX2_SUPPORT
 /*
@@ -77,6 +93,7 @@ static const rte_acl_classify_t classify_fns[] = {
 	[RTE_ACL_CLASSIFY_AVX2] = rte_acl_classify_avx2,
 	[RTE_ACL_CLASSIFY_NEON] = rte_acl_classify_neon,
 	[RTE_ACL_CLASSIFY_ALTIVEC] = rte_acl_classify_altivec,
+	[RTE_ACL_CLASSIFY_AVX512] = rte_acl_classify_avx512,
 };
 
 /* by default, use always available scalar code path. */
@@ -89,21 +106,76 @@ rte_acl_set_default_classify(enum rte_acl_classify_alg alg)
 	rte_acl_default_classify = alg;
 }
 
+/*
+ * Check that given classify method can be run on the given platform:
+ * both compiler and target cpu have to support it.
+ */
+static int
+acl_check_alg(enum rte_acl_classify_alg alg)
+{
+	switch (alg) {
+	case RTE_ACL_CLASSIFY_DEFAULT:
+	case RTE_ACL_CLASSIFY_SCALAR:
+		return 0;
+	case RTE_ACL_CLASSIFY_NEON:
+#if defined(RTE_ARCH_ARM64)
+		return 0;
+#elif defined(RTE_ARCH_ARM)
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_NEON))
+			return 0;
+#endif
+		return -ENOTSUP;
+	case RTE_ACL_CLASSIFY_ALTIVEC:
+#if defined(RTE_ARCH_PPC_64)
+		return 0;
+#endif
+		return -ENOTSUP;
+	case RTE_ACL_CLASSIFY_SSE:
+#if defined(RTE_ARCH_X86)
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE4_1))
+			return 0;
+#endif
+		return -ENOTSUP;
+	case RTE_ACL_CLASSIFY_AVX2:
+#ifdef CC_AVX2_SUPPORT
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2))
+			return 0;
+#endif
+		return -ENOTSUP;
+	case RTE_ACL_CLASSIFY_AVX512:
+#ifdef CC_AVX512_SUPPORT
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512BW))
+			return 0;
+#endif
+		return -ENOTSUP;
+	default:
+		return -EINVAL;
+	}
+}
+
 extern int
 rte_acl_set_ctx_classify(struct rte_acl_ctx *ctx, enum rte_acl_classify_alg alg)
 {
+	int32_t rc;
+
 	if (ctx == NULL || (uint32_t)alg >= RTE_DIM(classify_fns))
 		return -EINVAL;
 
+	rc = acl_check_alg(alg);
+	if (rc != 0)
+		return rc;
+
 	ctx->alg = alg;
 	return 0;
 }
 
 /*
  * Select highest available classify method as default one.
- * Note that CLASSIFY_AVX2 should be set as a default only
+ * Note that CLASSIFY_AVX2/CLASSIFY_AVX512 should be set as a default only
  * if both conditions are met:
- * at build time compiler supports AVX2 and target cpu supports AVX2.
+ * at build time compiler supports AVX2/AVX512 and target cpu supports
+ * AVX2/AVX512.
  */
 RTE_INIT(rte_acl_init)
 {
@@ -117,6 +189,11 @@ RTE_INIT(rte_acl_init)
 #elif defined(RTE_ARCH_PPC_64)
 	alg = RTE_ACL_CLASSIFY_ALTIVEC;
 #else
+#ifdef CC_AVX512_SUPPORT
+	if (acl_check_alg(RTE_ACL_CLASSIFY_AVX512) == 0)
+		alg = RTE_ACL_CLASSIFY_AVX512;
+	else
+#endif
 #ifdef CC_AVX2_SUPPORT
 	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2))
 		alg = RTE_ACL_CLASSIFY_AVX2;
@@ -241,6 +241,7 @@ enum rte_acl_classify_alg {
 	RTE_ACL_CLASSIFY_AVX2 = 3,    /**< requires AVX2 support. */
 	RTE_ACL_CLASSIFY_NEON = 4,    /**< requires NEON support. */
 	RTE_ACL_CLASSIFY_ALTIVEC = 5,    /**< requires ALTIVEC support. */
+	RTE_ACL_CLASSIFY_AVX512 = 6,  /**< requires AVX512F/AVX512BW support. */
 	RTE_ACL_CLASSIFY_NUM          /* should always be the last one. */
 };
 
@@ -327,9 +328,10 @@ rte_acl_classify_alg(const struct rte_acl_ctx *ctx,
  * @param alg
  *   New default classify algorithm for given ACL context.
  *   It is the caller responsibility to ensure that the value refers to the
- *   existing algorithm, and that it could be run on the given CPU.
+ *   existing algorithm.
  * @return
  *   - -EINVAL if the parameters are invalid.
+ *   - -ENOTSUP if the requested algorithm can't be run on the given CPU.
  *   - Zero if operation completed successfully.
  */
 extern int
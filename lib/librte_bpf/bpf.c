@@ -17,9 +17,18 @@
 void
 rte_bpf_destroy(struct rte_bpf *bpf)
 {
+	uint32_t i;
+
 	if (bpf != NULL) {
+		/* release maps referenced by the program */
+		for (i = 0; i != bpf->prm.nb_xsym; i++) {
+			if (bpf->prm.xsym[i].type == RTE_BPF_XTYPE_MAP)
+				rte_bpf_map_destroy(bpf->prm.xsym[i].map.val);
+		}
 		if (bpf->jit.func != NULL)
 			munmap(bpf->jit.func, bpf->jit.sz);
+		if (bpf->jit_burst.func != NULL)
+			munmap(bpf->jit_burst.func, bpf->jit_burst.sz);
 		munmap(bpf, bpf->sz);
 	}
 }
@@ -34,6 +43,35 @@ rte_bpf_get_jit(const struct rte_bpf *bpf, struct rte_bpf_jit *jit)
 	return 0;
 }
 
+int
+rte_bpf_get_jit_burst(const struct rte_bpf *bpf,
+	struct rte_bpf_jit_burst *jit)
+{
+	if (bpf == NULL || jit == NULL)
+		return -EINVAL;
+
+	jit[0] = bpf->jit_burst;
+	return 0;
+}
+
+struct rte_bpf_map *
+rte_bpf_get_map(const struct rte_bpf *bpf, const char *name)
+{
+	uint32_t i;
+
+	if (bpf == NULL || name == NULL)
+		return NULL;
+
+	for (i = 0; i != bpf->prm.nb_xsym; i++) {
+		if (bpf->prm.xsym[i].type == RTE_BPF_XTYPE_MAP &&
+				strcmp(bpf->prm.xsym[i].map.val->name,
+				name) == 0)
+			return bpf->prm.xsym[i].map.val;
+	}
+
+	return NULL;
+}
+
 int
 bpf_jit(struct rte_bpf *bpf)
 {
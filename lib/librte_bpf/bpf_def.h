@@ -128,6 +128,26 @@ enum {
  */
 #define	EBPF_PSEUDO_CALL	EBPF_REG_1
 
+/*
+ * When EBPF_CALL instruction has src_reg == EBPF_HELPER_CALL,
+ * imm value contains the id of the helper function provided by
+ * DPDK EBPF library itself (one of EBPF_FUNC_*), instead of an index
+ * in the external symbols table.
+ */
+#define	EBPF_HELPER_CALL	EBPF_REG_2
+
+/*
+ * helper functions ids, same as in Linux.
+ */
+enum {
+	EBPF_FUNC_UNSPEC,
+	EBPF_FUNC_MAP_LOOKUP_ELEM, /* void *(map, const void *key) */
+	EBPF_FUNC_MAP_UPDATE_ELEM,
+	/* int (map, const void *key, const void *value, uint64_t flags) */
+	EBPF_FUNC_MAP_DELETE_ELEM, /* int (map, const void *key) */
+	EBPF_FUNC_NUM,
+};
+
 /*
  * eBPF instruction format
  */
@@ -17,10 +17,41 @@ extern "C" {
 struct rte_bpf {
 	struct rte_bpf_prm prm;
 	struct rte_bpf_jit jit;
+	struct rte_bpf_jit_burst jit_burst;
 	size_t sz;
 	uint32_t stack_sz;
 };
 
+struct rte_hash;
+
+/*
+ * Values of array maps are stored in *values* indexed by the key,
+ * per lcore arrays keep RTE_MAX_LCORE + 1 copies of them, the last one
+ * is shared by non-EAL threads.
+ * Hash maps store values in the same way, indexed by the position
+ * of the key in the hash table.
+ */
+struct rte_bpf_map {
+	char name[RTE_BPF_MAP_NAMESIZE];
+	enum rte_bpf_map_type type;
+	uint32_t key_size;
+	uint32_t value_size;
+	uint32_t max_entries;
+	uint32_t elem_size; /* value_size rounded up to 8 bytes */
+	uint32_t refcnt;
+	uint32_t rcu; /* slot reclamation is deferred through RCU QSBR */
+	struct rte_hash *hash;
+	uint8_t *values;
+};
+
+typedef uint64_t (*bpf_helper_t)(uint64_t, uint64_t, uint64_t, uint64_t,
+	uint64_t);
+
+/* helper functions, indexed by EBPF_FUNC_* */
+extern const bpf_helper_t bpf_helper_func[EBPF_FUNC_NUM];
+
+extern void bpf_map_get(struct rte_bpf_map *map);
+
 extern int bpf_validate(struct rte_bpf *bpf);
 
 extern int bpf_jit(struct rte_bpf *bpf);
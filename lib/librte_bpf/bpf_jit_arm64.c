@@ -1370,7 +1370,12 @@ emit(struct a64_jit_ctx *ctx, struct rte_bpf *bpf)
 			break;
 		/* Call imm */
 		case (BPF_JMP | EBPF_CALL):
-			emit_call(ctx, tmp1, bpf->prm.xsym[ins->imm].func.val);
+			if (ins->src_reg == EBPF_HELPER_CALL)
+				emit_call(ctx, tmp1,
+					(void *)bpf_helper_func[ins->imm]);
+			else
+				emit_call(ctx, tmp1,
+					bpf->prm.xsym[ins->imm].func.val);
 			break;
 		/* Return r0 */
 		case (BPF_JMP | EBPF_EXIT):
@@ -95,6 +95,32 @@ enum {
 	LDMB_OFS_NUM
 };
 
+/* map lookup offsets */
+enum {
+	MAPL_FSP_OFS, /* fast-path */
+	MAPL_NUL_OFS, /* key not found */
+	MAPL_SLP_OFS, /* slow-path */
+	MAPL_FIN_OFS, /* final part */
+	MAPL_OFS_NUM
+};
+
+/*
+ * burst mode loop state, kept on the stack above the saved registers.
+ */
+enum {
+	BURST_CUR_SLOT, /* pointer to the current ctx[] element */
+	BURST_END_SLOT, /* pointer past the last ctx[] element */
+	BURST_MSK_SLOT, /* result bitmask */
+	BURST_SLOT_NUM
+};
+
+/*
+ * in burst mode r12 holds the result bit for the current packet.
+ */
+enum {
+	REG_BURST_BIT = R12,
+};
+
 /*
  * callee saved registers list.
  * keep RBP as the last one.
@@ -111,6 +137,11 @@ struct bpf_jit_state {
 	struct {
 		uint32_t stack_ofs;
 	} ldmb;
+	struct {
+		uint32_t enable;
+		int32_t loop;
+		int32_t fin;
+	} burst;
 	uint32_t reguse;
 	int32_t *off;
 	uint8_t *ins;
@@ -695,6 +726,37 @@ emit_call(struct bpf_jit_state *st, uintptr_t trg)
 	emit_modregrm(st, MOD_DIRECT, mods, RAX);
 }
 
+/*
+ * emit imul %<sreg>, %<dreg>
+ */
+static void
+emit_imul_reg(struct bpf_jit_state *st, uint32_t op, uint32_t sreg,
+	uint32_t dreg)
+{
+	const uint8_t ops[] = {0x0F, 0xAF};
+
+	emit_rex(st, op, dreg, sreg);
+	emit_bytes(st, ops, sizeof(ops));
+	emit_modregrm(st, MOD_DIRECT, dreg, sreg);
+}
+
+/*
+ * emit prefetcht0 0(%<sreg>)
+ */
+static void
+emit_prefetch(struct bpf_jit_state *st, uint32_t sreg)
+{
+	const uint8_t ops[] = {0x0F, 0x18};
+	const uint8_t mods = 1;
+
+	emit_rex(st, BPF_ALU, 0, sreg);
+	emit_bytes(st, ops, sizeof(ops));
+	emit_modregrm(st, MOD_IDISP8, mods, sreg);
+	if (sreg == RSP || sreg == R12)
+		emit_sib(st, SIB_SCALE_1, sreg, sreg);
+	emit_imm(st, 0, sizeof(uint8_t));
+}
+
 /*
  * emit jmp <ofs>
  * where 'ofs' is the target offset for the native code.
@@ -1195,23 +1257,162 @@ emit_ld_mbuf(struct bpf_jit_state *st, uint32_t op, uint32_t sreg, uint32_t imm)
 	emit_ldmb_fin(st, rg[EBPF_REG_0], opsz, sz);
 }
 
+/*
+ * helper function, used by emit_map_lookup().
+ * generates code for 'fast_path':
+ * check that the map is an array and compute the value address.
+ */
 static void
-emit_prolog(struct bpf_jit_state *st, int32_t stack_size)
+emit_mapl_fast_path(struct bpf_jit_state *st, const uint32_t rg[EBPF_REG_3],
+	const int32_t ofs[MAPL_OFS_NUM])
+{
+	/* JNE map->type, RTE_BPF_MAP_TYPE_ARRAY, <slow_path> */
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | BPF_W, rg[EBPF_REG_1],
+		rg[EBPF_REG_0], offsetof(struct rte_bpf_map, type));
+	emit_cmp_imm(st, EBPF_ALU64, rg[EBPF_REG_0], RTE_BPF_MAP_TYPE_ARRAY);
+	emit_abs_jcc(st, BPF_JMP | EBPF_JNE | BPF_K, ofs[MAPL_SLP_OFS]);
+
+	/* R0 = *(uint32_t *)R2 */
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | BPF_W, rg[EBPF_REG_2],
+		rg[EBPF_REG_0], 0);
+
+	/* JGE R0, map->max_entries, <key_not_found> */
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | BPF_W, rg[EBPF_REG_1],
+		REG_TMP0, offsetof(struct rte_bpf_map, max_entries));
+	emit_cmp_reg(st, EBPF_ALU64, REG_TMP0, rg[EBPF_REG_0]);
+	emit_abs_jcc(st, BPF_JMP | BPF_JGE | BPF_K, ofs[MAPL_NUL_OFS]);
+
+	/* R0 = map->values + R0 * map->elem_size */
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | BPF_W, rg[EBPF_REG_1],
+		REG_TMP0, offsetof(struct rte_bpf_map, elem_size));
+	emit_imul_reg(st, EBPF_ALU64, REG_TMP0, rg[EBPF_REG_0]);
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, rg[EBPF_REG_1],
+		REG_TMP0, offsetof(struct rte_bpf_map, values));
+	emit_alu_reg(st, EBPF_ALU64 | BPF_ADD | BPF_X, REG_TMP0,
+		rg[EBPF_REG_0]);
+
+	/* JMP <fin_part> */
+	emit_abs_jmp(st, ofs[MAPL_FIN_OFS]);
+}
+
+/*
+ * helper function, used by emit_map_lookup().
+ * generates code for 'key_not_found' part: return NULL.
+ */
+static void
+emit_mapl_not_found(struct bpf_jit_state *st, const uint32_t rg[EBPF_REG_3],
+	const int32_t ofs[MAPL_OFS_NUM])
+{
+	emit_mov_imm(st, EBPF_ALU64 | EBPF_MOV | BPF_K, rg[EBPF_REG_0], 0);
+	emit_abs_jmp(st, ofs[MAPL_FIN_OFS]);
+}
+
+/*
+ * emit code for EBPF_FUNC_MAP_LOOKUP_ELEM helper call.
+ * lookup in arrays is inlined, generates the following construction:
+ * fast_path:
+ *   if (map->type != RTE_BPF_MAP_TYPE_ARRAY)
+ *      goto slow_path;
+ *   if (*(uint32_t *)key >= map->max_entries)
+ *      goto key_not_found;
+ *   res = map->values + *(uint32_t *)key * map->elem_size;
+ *   goto fin_part;
+ * key_not_found:
+ *   res = NULL;
+ *   goto fin_part;
+ * slow_path:
+ *   res = bpf_helper_func[EBPF_FUNC_MAP_LOOKUP_ELEM](map, key);
+ * fin_part:
+ */
+static void
+emit_map_lookup(struct bpf_jit_state *st)
 {
 	uint32_t i;
-	int32_t spil, ofs;
+	uint32_t rg[EBPF_REG_3];
+	int32_t ofs[MAPL_OFS_NUM];
+	uintptr_t func;
+
+	for (i = 0; i != RTE_DIM(rg); i++)
+		rg[i] = ebpf2x86[i];
+
+	func = (uintptr_t)bpf_helper_func[EBPF_FUNC_MAP_LOOKUP_ELEM];
+
+	/* fill with fake offsets */
+	for (i = 0; i != RTE_DIM(ofs); i++)
+		ofs[i] = st->sz + INT8_MAX;
+
+	/* dry run first to calculate jump offsets */
+
+	ofs[MAPL_FSP_OFS] = st->sz;
+	emit_mapl_fast_path(st, rg, ofs);
+	ofs[MAPL_NUL_OFS] = st->sz;
+	emit_mapl_not_found(st, rg, ofs);
+	ofs[MAPL_SLP_OFS] = st->sz;
+	emit_call(st, func);
+	ofs[MAPL_FIN_OFS] = st->sz;
+
+	RTE_VERIFY(ofs[MAPL_FIN_OFS] - ofs[MAPL_FSP_OFS] <= INT8_MAX);
+
+	/* reset dry-run code and do a proper run */
+
+	st->sz = ofs[MAPL_FSP_OFS];
+	emit_mapl_fast_path(st, rg, ofs);
+	emit_mapl_not_found(st, rg, ofs);
+	emit_call(st, func);
+}
+
+/*
+ * number of callee saved registers that have to be spilled.
+ */
+static int32_t
+spill_num(const struct bpf_jit_state *st)
+{
+	uint32_t i;
+	int32_t spil;
 
 	spil = 0;
 	for (i = 0; i != RTE_DIM(save_regs); i++)
 		spil += INUSE(st->reguse, save_regs[i]);
 
+	return spil;
+}
+
+/*
+ * size of the stack area allocated for spilled registers
+ * and burst mode loop state.
+ */
+static int32_t
+spill_size(const struct bpf_jit_state *st, int32_t spil)
+{
+	if (st->burst.enable != 0)
+		spil += BURST_SLOT_NUM;
+	return spil * sizeof(uint64_t);
+}
+
+/*
+ * offset of the burst mode loop state slot, relative to RBP.
+ */
+static int32_t
+burst_slot_ofs(const struct bpf_jit_state *st, uint32_t slot)
+{
+	return (spill_num(st) + slot) * sizeof(uint64_t);
+}
+
+static void
+emit_prolog(struct bpf_jit_state *st, int32_t stack_size)
+{
+	uint32_t i;
+	int32_t spil, ofs;
+
+	spil = spill_num(st);
+
 	/* we can avoid touching the stack at all */
 	if (spil == 0)
 		return;
 
 
 	emit_alu_imm(st, EBPF_ALU64 | BPF_SUB | BPF_K, RSP,
-		spil * sizeof(uint64_t));
+		spill_size(st, spil));
 
 	ofs = 0;
 	for (i = 0; i != RTE_DIM(save_regs); i++) {
@@ -1239,24 +1440,16 @@ emit_ret(struct bpf_jit_state *st)
 	emit_bytes(st, &ops, sizeof(ops));
 }
 
+/*
+ * restore callee saved registers and return.
+ */
 static void
-emit_epilog(struct bpf_jit_state *st)
+emit_leave(struct bpf_jit_state *st)
 {
 	uint32_t i;
 	int32_t spil, ofs;
 
-	/* if we allready have an epilog generate a jump to it */
-	if (st->exit.num++ != 0) {
-		emit_abs_jmp(st, st->exit.off);
-		return;
-	}
-
-	/* store offset of epilog block */
-	st->exit.off = st->sz;
-
-	spil = 0;
-	for (i = 0; i != RTE_DIM(save_regs); i++)
-		spil += INUSE(st->reguse, save_regs[i]);
+	spil = spill_num(st);
 
 	if (spil != 0) {
 
@@ -1274,12 +1467,155 @@ emit_epilog(struct bpf_jit_state *st)
 		}
 
 		emit_alu_imm(st, EBPF_ALU64 | BPF_ADD | BPF_K, RSP,
-			spil * sizeof(uint64_t));
+			spill_size(st, spil));
 	}
 
 	emit_ret(st);
 }
 
+static void
+emit_epilog(struct bpf_jit_state *st)
+{
+	/* if we allready have an epilog generate a jump to it */
+	if (st->exit.num++ != 0) {
+		emit_abs_jmp(st, st->exit.off);
+		return;
+	}
+
+	/* store offset of epilog block */
+	st->exit.off = st->sz;
+
+	emit_leave(st);
+}
+
+/*
+ * emit prolog and loop header for the burst mode.
+ * R1 points to ctx[] array, R2 contains number of its elements.
+ * generates the following construction:
+ *   cur = ctx;
+ *   end = ctx + num;
+ *   msk = 0;
+ *   bit = 1;
+ *   if (cur >= end)
+ *      goto fin;
+ * loop:
+ *   R1 = *cur;
+ *   prefetch(*(cur + 1 < end ? cur + 1 : cur));
+ */
+static void
+emit_burst_prolog(struct bpf_jit_state *st, int32_t stack_size)
+{
+	const uint32_t r1 = ebpf2x86[EBPF_REG_1];
+	const uint32_t r2 = ebpf2x86[EBPF_REG_2];
+
+	/* loop state is addressed through RBP, result bit is kept in R12 */
+	USED(st->reguse, RBP);
+	USED(st->reguse, REG_BURST_BIT);
+
+	emit_prolog(st, stack_size);
+
+	/* cur = ctx */
+	emit_st_reg(st, BPF_STX | BPF_MEM | EBPF_DW, r1, RBP,
+		burst_slot_ofs(st, BURST_CUR_SLOT));
+
+	/* end = ctx + num */
+	emit_mov_reg(st, BPF_ALU | EBPF_MOV | BPF_X, r2, REG_TMP0);
+	emit_shift_imm(st, EBPF_ALU64 | BPF_LSH | BPF_K, REG_TMP0,
+		rte_bsf32(sizeof(uint64_t)));
+	emit_alu_reg(st, EBPF_ALU64 | BPF_ADD | BPF_X, r1, REG_TMP0);
+	emit_st_reg(st, BPF_STX | BPF_MEM | EBPF_DW, REG_TMP0, RBP,
+		burst_slot_ofs(st, BURST_END_SLOT));
+
+	/* msk = 0 */
+	emit_st_imm(st, BPF_ST | BPF_MEM | EBPF_DW, RBP, 0,
+		burst_slot_ofs(st, BURST_MSK_SLOT));
+
+	/* bit = 1 */
+	emit_mov_imm(st, EBPF_ALU64 | EBPF_MOV | BPF_K, REG_BURST_BIT, 1);
+
+	/* JGE cur, end, <fin> */
+	emit_cmp_reg(st, EBPF_ALU64, REG_TMP0, r1);
+	emit_abs_jcc(st, BPF_JMP | BPF_JGE | BPF_K, st->burst.fin);
+
+	st->burst.loop = st->sz;
+
+	/* R1 = *cur */
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, RBP, REG_TMP0,
+		burst_slot_ofs(st, BURST_CUR_SLOT));
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, REG_TMP0, r1, 0);
+
+	/*
+	 * prefetch the next ctx while the current one is processed,
+	 * that is either the packet data or the first line of the mbuf.
+	 * stay on the current element at the last iteration to avoid
+	 * reading beyond ctx[] array.
+	 */
+	emit_mov_reg(st, EBPF_ALU64 | EBPF_MOV | BPF_X, REG_TMP0, REG_TMP1);
+	emit_alu_imm(st, EBPF_ALU64 | BPF_ADD | BPF_K, REG_TMP1,
+		sizeof(uint64_t));
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, RBP, REG_DIV_IMM,
+		burst_slot_ofs(st, BURST_END_SLOT));
+	emit_cmp_reg(st, EBPF_ALU64, REG_DIV_IMM, REG_TMP1);
+	emit_movcc_reg(st, EBPF_ALU64 | BPF_JGE | BPF_X, REG_TMP0, REG_TMP1);
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, REG_TMP1, REG_TMP1, 0);
+	emit_prefetch(st, REG_TMP1);
+}
+
+/*
+ * emit per packet tail and epilog for the burst mode,
+ * program exit jumps to the start of it.
+ * generates the following construction:
+ *   if (R0 != 0)
+ *      msk |= bit;
+ *   bit <<= 1;
+ *   if (++cur < end)
+ *      goto loop;
+ * fin:
+ *   return msk;
+ */
+static void
+emit_burst_epilog(struct bpf_jit_state *st)
+{
+	const uint32_t r0 = ebpf2x86[EBPF_REG_0];
+
+	st->exit.off = st->sz;
+
+	/* msk |= (R0 != 0) ? bit : 0 */
+	emit_mov_imm(st, EBPF_ALU64 | EBPF_MOV | BPF_K, REG_TMP0, 0);
+	emit_tst_reg(st, EBPF_ALU64, r0, r0);
+	emit_movcc_reg(st, EBPF_ALU64 | EBPF_JNE | BPF_X, REG_BURST_BIT,
+		REG_TMP0);
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, RBP, REG_TMP1,
+		burst_slot_ofs(st, BURST_MSK_SLOT));
+	emit_alu_reg(st, EBPF_ALU64 | BPF_OR | BPF_X, REG_TMP0, REG_TMP1);
+	emit_st_reg(st, BPF_STX | BPF_MEM | EBPF_DW, REG_TMP1, RBP,
+		burst_slot_ofs(st, BURST_MSK_SLOT));
+
+	/* bit <<= 1 */
+	emit_shift_imm(st, EBPF_ALU64 | BPF_LSH | BPF_K, REG_BURST_BIT, 1);
+
+	/* cur++ */
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, RBP, REG_TMP0,
+		burst_slot_ofs(st, BURST_CUR_SLOT));
+	emit_alu_imm(st, EBPF_ALU64 | BPF_ADD | BPF_K, REG_TMP0,
+		sizeof(uint64_t));
+	emit_st_reg(st, BPF_STX | BPF_MEM | EBPF_DW, REG_TMP0, RBP,
+		burst_slot_ofs(st, BURST_CUR_SLOT));
+
+	/* JLT cur, end, <loop> */
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, RBP, REG_TMP1,
+		burst_slot_ofs(st, BURST_END_SLOT));
+	emit_cmp_reg(st, EBPF_ALU64, REG_TMP1, REG_TMP0);
+	emit_abs_jcc(st, BPF_JMP | EBPF_JLT | BPF_K, st->burst.loop);
+
+	st->burst.fin = st->sz;
+
+	/* R0 = msk */
+	emit_ld_reg(st, BPF_LDX | BPF_MEM | EBPF_DW, RBP, r0,
+		burst_slot_ofs(st, BURST_MSK_SLOT));
+	emit_leave(st);
+}
+
 /*
  * walk through bpf code and translate them x86_64 one.
  */
@@ -1294,7 +1630,10 @@ emit(struct bpf_jit_state *st, const struct rte_bpf *bpf)
 	st->exit.num = 0;
 	st->ldmb.stack_ofs = bpf->stack_sz;
 
-	emit_prolog(st, bpf->stack_sz);
+	if (st->burst.enable != 0)
+		emit_burst_prolog(st, bpf->stack_sz);
+	else
+		emit_prolog(st, bpf->stack_sz);
 
 	for (i = 0; i != bpf->prm.nb_ins; i++) {
 
@@ -1473,12 +1812,22 @@ emit(struct bpf_jit_state *st, const struct rte_bpf *bpf)
 			break;
 		/* call instructions */
 		case (BPF_JMP | EBPF_CALL):
-			emit_call(st,
-				(uintptr_t)bpf->prm.xsym[ins->imm].func.val);
+			if (ins->src_reg != EBPF_HELPER_CALL)
+				emit_call(st, (uintptr_t)
+					bpf->prm.xsym[ins->imm].func.val);
+			else if (ins->imm == EBPF_FUNC_MAP_LOOKUP_ELEM)
+				emit_map_lookup(st);
+			else
+				emit_call(st,
+					(uintptr_t)bpf_helper_func[ins->imm]);
 			break;
 		/* return instruction */
 		case (BPF_JMP | EBPF_EXIT):
-			emit_epilog(st);
+			if (st->burst.enable == 0)
+				emit_epilog(st);
+			/* last exit falls through to the burst loop tail */
+			else if (i + 1 != bpf->prm.nb_ins)
+				emit_abs_jmp(st, st->exit.off);
 			break;
 		default:
 			RTE_BPF_LOG(ERR,
@@ -1488,14 +1837,19 @@ emit(struct bpf_jit_state *st, const struct rte_bpf *bpf)
 		}
 	}
 
+	if (st->burst.enable != 0)
+		emit_burst_epilog(st);
+
 	return 0;
 }
 
 /*
- * produce a native ISA version of the given BPF code.
+ * translate given BPF code into native ISA one,
+ * either into single ctx function or into burst loop.
  */
-int
-bpf_jit_x86(struct rte_bpf *bpf)
+static int
+jit_x86_gen(const struct rte_bpf *bpf, uint32_t burst, void **code,
+	size_t *size)
 {
 	int32_t rc;
 	uint32_t i;
@@ -1510,6 +1864,8 @@ bpf_jit_x86(struct rte_bpf *bpf)
 
 	/* fill with fake offsets */
 	st.exit.off = INT32_MAX;
+	st.burst.enable = burst;
+	st.burst.fin = INT32_MAX;
 	for (i = 0; i != bpf->prm.nb_ins; i++)
 		st.off[i] = INT32_MAX;
 
@@ -1540,10 +1896,39 @@ bpf_jit_x86(struct rte_bpf *bpf)
 	if (rc != 0)
 		munmap(st.ins, st.sz);
 	else {
-		bpf->jit.func = (void *)st.ins;
-		bpf->jit.sz = st.sz;
+		*code = st.ins;
+		*size = st.sz;
 	}
 
 	free(st.off);
 	return rc;
 }
+
+/*
+ * produce a native ISA version of the given BPF code.
+ */
+int
+bpf_jit_x86(struct rte_bpf *bpf)
+{
+	int32_t rc;
+	void *code;
+	size_t sz;
+
+	rc = jit_x86_gen(bpf, 0, &code, &sz);
+	if (rc != 0)
+		return rc;
+
+	bpf->jit.func = code;
+	bpf->jit.sz = sz;
+
+	rc = jit_x86_gen(bpf, 1, &code, &sz);
+	if (rc != 0) {
+		munmap(bpf->jit.func, bpf->jit.sz);
+		memset(&bpf->jit, 0, sizeof(bpf->jit));
+		return rc;
+	}
+
+	bpf->jit_burst.func = code;
+	bpf->jit_burst.sz = sz;
+	return 0;
+}
@@ -24,6 +24,7 @@ static struct rte_bpf *
 bpf_load(const struct rte_bpf_prm *prm)
 {
 	uint8_t *buf;
+	uint32_t i;
 	struct rte_bpf *bpf;
 	size_t sz, bsz, insz, xsz;
 
@@ -48,6 +49,12 @@ bpf_load(const struct rte_bpf_prm *prm)
 	bpf->prm.xsym = (void *)(buf + bsz);
 	bpf->prm.ins = (void *)(buf + bsz + xsz);
 
+	/* maps stay alive as long as the program that references them */
+	for (i = 0; i != prm->nb_xsym; i++) {
+		if (prm->xsym[i].type == RTE_BPF_XTYPE_MAP)
+			bpf_map_get(prm->xsym[i].map.val);
+	}
+
 	return bpf;
 }
 
@@ -80,6 +87,9 @@ bpf_check_xsym(const struct rte_bpf_xsym *xsym)
 		if (xsym->func.ret.type != RTE_BPF_ARG_UNDEF &&
 				xsym->func.ret.size == 0)
 			return -EINVAL;
+	} else if (xsym->type == RTE_BPF_XTYPE_MAP) {
+		if (xsym->map.val == NULL)
+			return -EINVAL;
 	} else
 		return -EINVAL;
 
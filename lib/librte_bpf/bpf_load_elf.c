@@ -4,6 +4,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <stdint.h>
@@ -32,6 +33,21 @@
 #define	EM_BPF	247
 #endif
 
+/* name of the section with map definitions */
+#define	ELF_MAPS_SECTION	"maps"
+
+/* map definition in the ELF maps section, same layout as in Linux */
+struct bpf_elf_map_def {
+	uint32_t type;
+	uint32_t key_size;
+	uint32_t value_size;
+	uint32_t max_entries;
+	uint32_t map_flags;
+};
+
+/* map_flags are not used, so allow definitions without them */
+#define	ELF_MAP_DEF_MIN_SIZE	offsetof(struct bpf_elf_map_def, map_flags)
+
 static uint32_t
 bpf_find_xsym(const char *sn, enum rte_bpf_xtype type,
 	const struct rte_bpf_xsym fp[], uint32_t fn)
@@ -58,6 +74,7 @@ resolve_xsym(const char *sn, size_t ofs, struct ebpf_insn *ins, size_t ins_sz,
 	const struct rte_bpf_prm *prm)
 {
 	uint32_t idx, fidx;
+	uintptr_t addr;
 	enum rte_bpf_xtype type;
 
 	if (ofs % sizeof(ins[0]) != 0 || ofs >= ins_sz)
@@ -73,6 +90,13 @@ resolve_xsym(const char *sn, size_t ofs, struct ebpf_insn *ins, size_t ins_sz,
 		return -EINVAL;
 
 	fidx = bpf_find_xsym(sn, type, prm->xsym, prm->nb_xsym);
+
+	/* 64-bit immediate load can reference a map as well */
+	if (fidx == UINT32_MAX && type == RTE_BPF_XTYPE_VAR) {
+		type = RTE_BPF_XTYPE_MAP;
+		fidx = bpf_find_xsym(sn, type, prm->xsym, prm->nb_xsym);
+	}
+
 	if (fidx == UINT32_MAX)
 		return -ENOENT;
 
@@ -83,18 +107,20 @@ resolve_xsym(const char *sn, size_t ofs, struct ebpf_insn *ins, size_t ins_sz,
 		 * so treat EBPF_PSEUDO_CALL to extrernal function
 		 * as an ordinary EBPF_CALL.
 		 */
-		if (ins[idx].src_reg == EBPF_PSEUDO_CALL) {
+		if (ins[idx].src_reg == EBPF_PSEUDO_CALL)
 			RTE_BPF_LOG(INFO, "%s(%u): "
 				"EBPF_PSEUDO_CALL to external function: %s\n",
 				__func__, idx, sn);
-			ins[idx].src_reg = EBPF_REG_0;
-		}
+		ins[idx].src_reg = EBPF_REG_0;
 		ins[idx].imm = fidx;
-	/* for variable we need to store its absolute address */
+	/* for variable and map we need to store its absolute address */
 	} else {
-		ins[idx].imm = (uintptr_t)prm->xsym[fidx].var.val;
-		ins[idx + 1].imm =
-			(uint64_t)(uintptr_t)prm->xsym[fidx].var.val >> 32;
+		if (type == RTE_BPF_XTYPE_VAR)
+			addr = (uintptr_t)prm->xsym[fidx].var.val;
+		else
+			addr = (uintptr_t)prm->xsym[fidx].map.val;
+		ins[idx].imm = addr;
+		ins[idx + 1].imm = (uint64_t)addr >> 32;
 	}
 
 	return 0;
@@ -263,6 +289,174 @@ elf_reloc_code(Elf *elf, Elf_Data *ed, size_t sidx,
 	return rc;
 }
 
+/*
+ * helper function, calls to the helper functions are not relocated,
+ * imm value of such call contains helper function id (as in Linux).
+ */
+static void
+elf_mark_helper_calls(Elf_Data *sd)
+{
+	uint32_t i, n;
+	struct ebpf_insn *ins;
+
+	ins = sd->d_buf;
+	n = sd->d_size / sizeof(ins[0]);
+
+	for (i = 0; i != n; i++) {
+		if (ins[i].code == (BPF_JMP | EBPF_CALL) &&
+				ins[i].src_reg == EBPF_REG_0 &&
+				ins[i].imm > EBPF_FUNC_UNSPEC &&
+				ins[i].imm < EBPF_FUNC_NUM)
+			ins[i].src_reg = EBPF_HELPER_CALL;
+	}
+}
+
+/*
+ * helper function, find section by name and type.
+ */
+static Elf_Scn *
+find_elf_section(Elf *elf, const char *name, uint32_t type)
+{
+	Elf_Scn *sc;
+	const Elf64_Ehdr *eh;
+	const Elf64_Shdr *sh;
+	const char *sn;
+
+	eh = elf64_getehdr(elf);
+
+	for (sc = elf_nextscn(elf, NULL); sc != NULL;
+			sc = elf_nextscn(elf, sc)) {
+		sh = elf64_getshdr(sc);
+		if (sh->sh_type != type)
+			continue;
+		sn = elf_strptr(elf, eh->e_shstrndx, sh->sh_name);
+		if (name == NULL || (sn != NULL && strcmp(name, sn) == 0))
+			break;
+	}
+
+	return sc;
+}
+
+/*
+ * helper function, check that map provided by the user
+ * matches its definition in the ELF file.
+ */
+static int
+check_elf_map(const struct rte_bpf_map *map,
+	const struct bpf_elf_map_def *def)
+{
+	if (map->type != def->type || map->key_size != def->key_size ||
+			map->value_size != def->value_size ||
+			map->max_entries < def->max_entries)
+		return -EINVAL;
+	return 0;
+}
+
+/*
+ * helper function, create maps defined in the ELF maps section,
+ * unless the user provided them, and append them to the xsym table.
+ */
+static int
+elf_create_maps(Elf *elf, const struct rte_bpf_prm *prm,
+	struct rte_bpf_xsym **pxsym, uint32_t *pnb_xsym)
+{
+	int32_t rc;
+	uint32_t i, n, idx, nb_xsym;
+	size_t msidx;
+	const Elf64_Ehdr *eh;
+	const Elf64_Sym *sm;
+	const Elf_Data *md, *sd;
+	Elf_Scn *ms, *ss;
+	struct bpf_elf_map_def def;
+	struct rte_bpf_map_prm mprm;
+	struct rte_bpf_xsym *xsym;
+	const char *sn;
+
+	*pxsym = NULL;
+	*pnb_xsym = prm->nb_xsym;
+	sn = NULL;
+
+	ms = find_elf_section(elf, ELF_MAPS_SECTION, SHT_PROGBITS);
+	ss = find_elf_section(elf, NULL, SHT_SYMTAB);
+	if (ms == NULL || ss == NULL)
+		return 0;
+
+	md = elf_getdata(ms, NULL);
+	sd = elf_getdata(ss, NULL);
+	if (md == NULL || sd == NULL)
+		return -EINVAL;
+
+	eh = elf64_getehdr(elf);
+	msidx = elf_ndxscn(ms);
+	sm = sd->d_buf;
+	n = sd->d_size / sizeof(sm[0]);
+
+	xsym = calloc(prm->nb_xsym + n, sizeof(xsym[0]));
+	if (xsym == NULL)
+		return -ENOMEM;
+
+	if (prm->nb_xsym != 0)
+		memcpy(xsym, prm->xsym, prm->nb_xsym * sizeof(xsym[0]));
+	nb_xsym = prm->nb_xsym;
+
+	rc = 0;
+	for (i = 0; i != n && rc == 0; i++) {
+
+		if (sm[i].st_shndx != msidx)
+			continue;
+
+		sn = elf_strptr(elf, eh->e_shstrndx, sm[i].st_name);
+		if (sn == NULL ||
+				sm[i].st_value + ELF_MAP_DEF_MIN_SIZE >
+				md->d_size) {
+			rc = -EINVAL;
+			break;
+		}
+
+		memset(&def, 0, sizeof(def));
+		memcpy(&def, (const uint8_t *)md->d_buf + sm[i].st_value,
+			RTE_MIN(sizeof(def), md->d_size - sm[i].st_value));
+
+		/* map is provided by the user */
+		idx = bpf_find_xsym(sn, RTE_BPF_XTYPE_MAP, prm->xsym,
+			prm->nb_xsym);
+		if (idx != UINT32_MAX) {
+			rc = check_elf_map(prm->xsym[idx].map.val, &def);
+			continue;
+		}
+
+		mprm.name = sn;
+		mprm.type = def.type;
+		mprm.key_size = def.key_size;
+		mprm.value_size = def.value_size;
+		mprm.max_entries = def.max_entries;
+		mprm.socket_id = SOCKET_ID_ANY;
+
+		xsym[nb_xsym].map.val = rte_bpf_map_create(&mprm);
+		if (xsym[nb_xsym].map.val == NULL) {
+			rc = -rte_errno;
+			break;
+		}
+
+		xsym[nb_xsym].name = xsym[nb_xsym].map.val->name;
+		xsym[nb_xsym].type = RTE_BPF_XTYPE_MAP;
+		nb_xsym++;
+	}
+
+	if (rc != 0) {
+		RTE_BPF_LOG(ERR, "%s(%p) failed to setup map \"%s\", "
+			"error code: %d\n", __func__, elf, sn, rc);
+		for (i = prm->nb_xsym; i != nb_xsym; i++)
+			rte_bpf_map_destroy(xsym[i].map.val);
+		free(xsym);
+		return rc;
+	}
+
+	*pxsym = xsym;
+	*pnb_xsym = nb_xsym;
+	return 0;
+}
+
 static struct rte_bpf *
 bpf_load_elf(const struct rte_bpf_prm *prm, int32_t fd, const char *section)
 {
@@ -270,18 +464,29 @@ bpf_load_elf(const struct rte_bpf_prm *prm, int32_t fd, const char *section)
 	Elf_Data *sd;
 	size_t sidx;
 	int32_t rc;
+	uint32_t i;
 	struct rte_bpf *bpf;
 	struct rte_bpf_prm np;
+	struct rte_bpf_xsym *xsym;
 
 	elf_version(EV_CURRENT);
 	elf = elf_begin(fd, ELF_C_READ, NULL);
 
+	np = prm[0];
+	xsym = NULL;
+
 	rc = find_elf_code(elf, section, &sd, &sidx);
 	if (rc == 0)
-		rc = elf_reloc_code(elf, sd, sidx, prm);
+		rc = elf_create_maps(elf, prm, &xsym, &np.nb_xsym);
+
+	if (rc == 0) {
+		if (xsym != NULL)
+			np.xsym = xsym;
+		elf_mark_helper_calls(sd);
+		rc = elf_reloc_code(elf, sd, sidx, &np);
+	}
 
 	if (rc == 0) {
-		np = prm[0];
 		np.ins = sd->d_buf;
 		np.nb_ins = sd->d_size / sizeof(struct ebpf_insn);
 		bpf = rte_bpf_load(&np);
@@ -290,6 +495,13 @@ bpf_load_elf(const struct rte_bpf_prm *prm, int32_t fd, const char *section)
 		rte_errno = -rc;
 	}
 
+	/* the BPF program keeps its own references to the maps */
+	if (xsym != NULL) {
+		for (i = prm->nb_xsym; i != np.nb_xsym; i++)
+			rte_bpf_map_destroy(xsym[i].map.val);
+		free(xsym);
+	}
+
 	elf_end(elf);
 	return bpf;
 }
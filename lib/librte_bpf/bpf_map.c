@@ -0,0 +1,342 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_errno.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_string_fns.h>
+#include <rte_hash.h>
+#include <rte_jhash.h>
+
+#include "bpf_impl.h"
+
+/* copy of per lcore arrays, used by non-EAL threads */
+#define BPF_MAP_LCORE_ANY	RTE_MAX_LCORE
+
+/* min number of entries accepted by rte_hash */
+#define BPF_MAP_HASH_MIN_ENTRIES	8
+
+static int
+bpf_map_check_prm(const struct rte_bpf_map_prm *prm)
+{
+	if (prm == NULL || prm->name == NULL || prm->key_size == 0 ||
+			prm->value_size == 0 || prm->max_entries == 0)
+		return -EINVAL;
+
+	if (strnlen(prm->name, RTE_BPF_MAP_NAMESIZE) == RTE_BPF_MAP_NAMESIZE)
+		return -ENAMETOOLONG;
+
+	switch (prm->type) {
+	case RTE_BPF_MAP_TYPE_ARRAY:
+	case RTE_BPF_MAP_TYPE_PERCPU_ARRAY:
+		if (prm->key_size != sizeof(uint32_t))
+			return -EINVAL;
+		break;
+	case RTE_BPF_MAP_TYPE_HASH:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static struct rte_hash *
+bpf_map_hash_create(const struct rte_bpf_map *map, int socket_id)
+{
+	char name[RTE_HASH_NAMESIZE];
+	struct rte_hash_parameters hprm;
+
+	/* map names are not unique, so name the table after the map handle */
+	snprintf(name, sizeof(name), "bpfmap_%p", map);
+
+	memset(&hprm, 0, sizeof(hprm));
+	hprm.name = name;
+	hprm.entries = RTE_MAX(map->max_entries,
+		(uint32_t)BPF_MAP_HASH_MIN_ENTRIES);
+	hprm.key_len = map->key_size;
+	hprm.hash_func = rte_jhash;
+	hprm.socket_id = socket_id;
+
+	/*
+	 * lookups come from the data path on any lcore,
+	 * updates may come from the data path and the control path.
+	 */
+	hprm.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF |
+		RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD;
+
+	return rte_hash_create(&hprm);
+}
+
+struct rte_bpf_map *
+rte_bpf_map_create(const struct rte_bpf_map_prm *prm)
+{
+	int32_t rc;
+	size_t nb_elem;
+	struct rte_bpf_map *map;
+
+	rc = bpf_map_check_prm(prm);
+	if (rc != 0) {
+		rte_errno = -rc;
+		return NULL;
+	}
+
+	map = rte_zmalloc_socket(NULL, sizeof(*map), RTE_CACHE_LINE_SIZE,
+		prm->socket_id);
+	if (map == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	strlcpy(map->name, prm->name, sizeof(map->name));
+	map->type = prm->type;
+	map->key_size = prm->key_size;
+	map->value_size = prm->value_size;
+	map->max_entries = prm->max_entries;
+	map->elem_size = RTE_ALIGN_CEIL(prm->value_size, sizeof(uint64_t));
+	map->refcnt = 1;
+
+	nb_elem = map->max_entries;
+	if (map->type == RTE_BPF_MAP_TYPE_PERCPU_ARRAY)
+		nb_elem *= BPF_MAP_LCORE_ANY + 1;
+	else if (map->type == RTE_BPF_MAP_TYPE_HASH) {
+		map->hash = bpf_map_hash_create(map, prm->socket_id);
+		if (map->hash == NULL) {
+			rc = rte_errno;
+			RTE_BPF_LOG(ERR, "%s(%s): can't create hash table, "
+				"error code: %d\n", __func__, prm->name, rc);
+			rte_free(map);
+			rte_errno = rc;
+			return NULL;
+		}
+		nb_elem = rte_hash_max_key_id(map->hash) + 1;
+	}
+
+	map->values = rte_zmalloc_socket(NULL, nb_elem * map->elem_size,
+		RTE_CACHE_LINE_SIZE, prm->socket_id);
+	if (map->values == NULL) {
+		rte_hash_free(map->hash);
+		rte_free(map);
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	return map;
+}
+
+void
+bpf_map_get(struct rte_bpf_map *map)
+{
+	__atomic_add_fetch(&map->refcnt, 1, __ATOMIC_RELAXED);
+}
+
+void
+rte_bpf_map_destroy(struct rte_bpf_map *map)
+{
+	if (map == NULL ||
+			__atomic_sub_fetch(&map->refcnt, 1,
+			__ATOMIC_ACQ_REL) != 0)
+		return;
+
+	rte_hash_free(map->hash);
+	rte_free(map->values);
+	rte_free(map);
+}
+
+static void *
+bpf_map_array_elem(struct rte_bpf_map *map, uint32_t idx, uint32_t lcore_id)
+{
+	if (idx >= map->max_entries)
+		return NULL;
+
+	if (map->type == RTE_BPF_MAP_TYPE_PERCPU_ARRAY) {
+		if (lcore_id >= RTE_MAX_LCORE)
+			lcore_id = BPF_MAP_LCORE_ANY;
+		idx += lcore_id * map->max_entries;
+	}
+
+	return map->values + (size_t)idx * map->elem_size;
+}
+
+void *
+rte_bpf_map_lookup_elem(struct rte_bpf_map *map, const void *key)
+{
+	void *data;
+
+	if (map == NULL || key == NULL)
+		return NULL;
+
+	if (map->type == RTE_BPF_MAP_TYPE_HASH) {
+		/* a key being added has no value yet, it is not present */
+		if (rte_hash_lookup_data(map->hash, key, &data) < 0)
+			return NULL;
+		return data;
+	}
+
+	return bpf_map_array_elem(map, *(const uint32_t *)key,
+		rte_lcore_id());
+}
+
+void *
+rte_bpf_map_lookup_lcore_elem(struct rte_bpf_map *map, const void *key,
+	unsigned int lcore_id)
+{
+	if (map == NULL || key == NULL ||
+			map->type != RTE_BPF_MAP_TYPE_PERCPU_ARRAY)
+		return NULL;
+
+	return bpf_map_array_elem(map, *(const uint32_t *)key, lcore_id);
+}
+
+static int
+bpf_map_hash_update(struct rte_bpf_map *map, const void *key,
+	const void *value, uint64_t flags)
+{
+	int32_t pos;
+	void *elem;
+
+	pos = rte_hash_lookup(map->hash, key);
+	if (pos >= 0 && flags == RTE_BPF_MAP_UPDATE_NOEXIST)
+		return -EEXIST;
+	if (pos >= 0) {
+		memcpy(map->values + (size_t)pos * map->elem_size, value,
+			map->value_size);
+		return 0;
+	}
+
+	if (flags == RTE_BPF_MAP_UPDATE_EXIST)
+		return -ENOENT;
+
+	/*
+	 * The key is added with no data, so that readers don't see it
+	 * until its value is written, then the value is published.
+	 */
+	pos = rte_hash_add_key(map->hash, key);
+	if (pos < 0)
+		return -ENOSPC;
+
+	elem = map->values + (size_t)pos * map->elem_size;
+	memcpy(elem, value, map->value_size);
+
+	if (rte_hash_add_key_data(map->hash, key, elem) != 0)
+		return -ENOSPC;
+	return 0;
+}
+
+int
+rte_bpf_map_update_elem(struct rte_bpf_map *map, const void *key,
+	const void *value, uint64_t flags)
+{
+	void *elem;
+
+	if (map == NULL || key == NULL || value == NULL ||
+			flags > RTE_BPF_MAP_UPDATE_EXIST)
+		return -EINVAL;
+
+	if (map->type == RTE_BPF_MAP_TYPE_HASH)
+		return bpf_map_hash_update(map, key, value, flags);
+
+	elem = bpf_map_array_elem(map, *(const uint32_t *)key,
+		rte_lcore_id());
+	if (elem == NULL)
+		return -E2BIG;
+
+	/* array elements always exist */
+	if (flags == RTE_BPF_MAP_UPDATE_NOEXIST)
+		return -EEXIST;
+
+	memcpy(elem, value, map->value_size);
+	return 0;
+}
+
+int
+rte_bpf_map_delete_elem(struct rte_bpf_map *map, const void *key)
+{
+	int32_t pos;
+
+	if (map == NULL || key == NULL || map->type != RTE_BPF_MAP_TYPE_HASH)
+		return -EINVAL;
+
+	pos = rte_hash_del_key(map->hash, key);
+	if (pos < 0)
+		return -ENOENT;
+
+	/*
+	 * With RCU, the hash table frees the slot once the readers are
+	 * done with its value. Otherwise it is reused right away.
+	 */
+	if (!map->rcu)
+		rte_hash_free_key_with_position(map->hash, pos);
+	return 0;
+}
+
+int
+rte_bpf_map_rcu_qsbr_add(struct rte_bpf_map *map, struct rte_rcu_qsbr *v)
+{
+	struct rte_hash_rcu_config cfg;
+
+	if (map == NULL || v == NULL || map->type != RTE_BPF_MAP_TYPE_HASH)
+		return -EINVAL;
+
+	if (map->rcu)
+		return -EEXIST;
+
+	/*
+	 * Deletes may come from the data path, on an lcore that is itself
+	 * a reader, so they can't wait for the grace period.
+	 */
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.v = v;
+	cfg.mode = RTE_HASH_QSBR_MODE_DQ;
+
+	if (rte_hash_rcu_qsbr_add(map->hash, &cfg) != 0)
+		return -rte_errno;
+
+	map->rcu = 1;
+	return 0;
+}
+
+/*
+ * wrappers to call map functions from BPF code.
+ */
+
+static uint64_t
+bpf_map_lookup_helper(uint64_t map, uint64_t key,
+	__rte_unused uint64_t arg3, __rte_unused uint64_t arg4,
+	__rte_unused uint64_t arg5)
+{
+	return (uintptr_t)rte_bpf_map_lookup_elem((void *)(uintptr_t)map,
+		(const void *)(uintptr_t)key);
+}
+
+static uint64_t
+bpf_map_update_helper(uint64_t map, uint64_t key, uint64_t value,
+	uint64_t flags, __rte_unused uint64_t arg5)
+{
+	return (int64_t)rte_bpf_map_update_elem((void *)(uintptr_t)map,
+		(const void *)(uintptr_t)key, (const void *)(uintptr_t)value,
+		flags);
+}
+
+static uint64_t
+bpf_map_delete_helper(uint64_t map, uint64_t key,
+	__rte_unused uint64_t arg3, __rte_unused uint64_t arg4,
+	__rte_unused uint64_t arg5)
+{
+	return (int64_t)rte_bpf_map_delete_elem((void *)(uintptr_t)map,
+		(const void *)(uintptr_t)key);
+}
+
+const bpf_helper_t bpf_helper_func[EBPF_FUNC_NUM] = {
+	[EBPF_FUNC_MAP_LOOKUP_ELEM] = bpf_map_lookup_helper,
+	[EBPF_FUNC_MAP_UPDATE_ELEM] = bpf_map_update_helper,
+	[EBPF_FUNC_MAP_DELETE_ELEM] = bpf_map_delete_helper,
+};
@@ -17,6 +17,18 @@
 
 #define BPF_ARG_PTR_STACK RTE_BPF_ARG_RESERVED
 
+/*
+ * map handle, register value holds the map address.
+ * result of map lookup, pointer to the map value or NULL,
+ * becomes RTE_BPF_ARG_PTR once checked against NULL.
+ * Neither of them can be dereferenced.
+ */
+#define BPF_ARG_MAP			(RTE_BPF_ARG_RAW + 1)
+#define BPF_ARG_MAP_VALUE_OR_NULL	(RTE_BPF_ARG_RAW + 2)
+
+#define BPF_ARG_MAP_TYPE(x)	\
+	((x) == BPF_ARG_MAP || (x) == BPF_ARG_MAP_VALUE_OR_NULL)
+
 struct bpf_reg_val {
 	struct rte_bpf_arg v;
 	uint64_t mask;
@@ -200,6 +212,13 @@ eval_ld_imm64(struct bpf_verifier *bvf, const struct ebpf_insn *ins)
 			eval_fill_imm64(rd, UINT64_MAX, 0);
 			break;
 		}
+
+		/* load of map handle */
+		if (bvf->prm->xsym[i].type == RTE_BPF_XTYPE_MAP &&
+				(uintptr_t)bvf->prm->xsym[i].map.val == val) {
+			rd->v.type = BPF_ARG_MAP;
+			break;
+		}
 	}
 
 	return NULL;
@@ -666,6 +685,13 @@ eval_alu(struct bpf_verifier *bvf, const struct ebpf_insn *ins)
 	if (err != NULL)
 		return err;
 
+	/* map handles and lookup results can only be copied as a whole */
+	if ((op != EBPF_MOV && BPF_ARG_MAP_TYPE(rd->v.type)) ||
+			(BPF_SRC(ins->code) == BPF_X &&
+			BPF_ARG_MAP_TYPE(rs.v.type) &&
+			(op != EBPF_MOV || msk != UINT64_MAX)))
+		return "invalid operation on map handle or map value";
+
 	if (op == BPF_ADD)
 		eval_add(rd, &rs, msk);
 	else if (op == BPF_SUB)
@@ -964,6 +990,62 @@ eval_func_arg(struct bpf_verifier *bvf, const struct rte_bpf_arg *arg,
 	return err;
 }
 
+/*
+ * evaluate call of the map helper function:
+ * R1 has to be a map handle, R2 (and R3 for update) point to
+ * the key (value) of the map size.
+ */
+static const char *
+eval_helper_call(struct bpf_verifier *bvf, const struct ebpf_insn *ins)
+{
+	uint32_t i;
+	const struct rte_bpf_map *map;
+	struct bpf_reg_val *rv;
+	struct rte_bpf_arg arg;
+	const char *err;
+
+	if (ins->imm <= EBPF_FUNC_UNSPEC || ins->imm >= EBPF_FUNC_NUM)
+		return "invalid helper function id";
+
+	rv = bvf->evst->rv;
+	if (rv[EBPF_REG_1].v.type != BPF_ARG_MAP)
+		return "invalid map handle";
+
+	map = (const struct rte_bpf_map *)(uintptr_t)rv[EBPF_REG_1].u.max;
+
+	arg.type = RTE_BPF_ARG_PTR;
+	arg.size = map->key_size;
+	err = eval_func_arg(bvf, &arg, rv + EBPF_REG_2);
+
+	if (err == NULL && ins->imm == EBPF_FUNC_MAP_UPDATE_ELEM) {
+		arg.size = map->value_size;
+		err = eval_func_arg(bvf, &arg, rv + EBPF_REG_3);
+		if (err == NULL) {
+			arg.type = RTE_BPF_ARG_RAW;
+			arg.size = sizeof(uint64_t);
+			err = eval_func_arg(bvf, &arg, rv + EBPF_REG_4);
+		}
+	}
+
+	/* R1-R5 argument/scratch registers */
+	for (i = EBPF_REG_1; i != EBPF_REG_6; i++)
+		rv[i].v.type = RTE_BPF_ARG_UNDEF;
+
+	/* update return value */
+	rv += EBPF_REG_0;
+	if (ins->imm == EBPF_FUNC_MAP_LOOKUP_ELEM) {
+		rv->v.type = BPF_ARG_MAP_VALUE_OR_NULL;
+		rv->v.size = map->value_size;
+		eval_fill_imm64(rv, UINTPTR_MAX, 0);
+	} else {
+		rv->v.type = RTE_BPF_ARG_RAW;
+		rv->v.size = sizeof(uint64_t);
+		eval_fill_max_bound(rv, UINT64_MAX);
+	}
+
+	return err;
+}
+
 static const char *
 eval_call(struct bpf_verifier *bvf, const struct ebpf_insn *ins)
 {
@@ -972,16 +1054,19 @@ eval_call(struct bpf_verifier *bvf, const struct ebpf_insn *ins)
 	const struct rte_bpf_xsym *xsym;
 	const char *err;
 
+	/* for now don't support function calls on 32 bit platform */
+	if (sizeof(uint64_t) != sizeof(uintptr_t))
+		return "function calls are supported only for 64 bit apps";
+
+	if (ins->src_reg == EBPF_HELPER_CALL)
+		return eval_helper_call(bvf, ins);
+
 	idx = ins->imm;
 
 	if (idx >= bvf->prm->nb_xsym ||
 			bvf->prm->xsym[idx].type != RTE_BPF_XTYPE_FUNC)
 		return "invalid external function index";
 
-	/* for now don't support function calls on 32 bit platform */
-	if (sizeof(uint64_t) != sizeof(uintptr_t))
-		return "function calls are supported only for 64 bit apps";
-
 	xsym = bvf->prm->xsym + idx;
 
 	/* evaluate function arguments */
@@ -1068,6 +1153,17 @@ eval_jslt_jsge(struct bpf_reg_val *trd, struct bpf_reg_val *trs,
 	trd->s.max = RTE_MIN(trd->s.max, trs->s.max - 1);
 }
 
+/*
+ * after the check against NULL, the map value is either NULL
+ * or a valid pointer to the value.
+ */
+static void
+eval_map_value_null(struct bpf_reg_val *rnull, struct bpf_reg_val *rval)
+{
+	eval_fill_imm(rnull, UINT64_MAX, 0);
+	rval->v.type = RTE_BPF_ARG_PTR;
+}
+
 static const char *
 eval_jcc(struct bpf_verifier *bvf, const struct ebpf_insn *ins)
 {
@@ -1099,6 +1195,17 @@ eval_jcc(struct bpf_verifier *bvf, const struct ebpf_insn *ins)
 
 	op = BPF_OP(ins->code);
 
+	/* check of map lookup result against NULL */
+	if (trd->v.type == BPF_ARG_MAP_VALUE_OR_NULL &&
+			BPF_SRC(ins->code) == BPF_K && ins->imm == 0 &&
+			(op == BPF_JEQ || op == EBPF_JNE)) {
+		if (op == BPF_JEQ)
+			eval_map_value_null(trd, frd);
+		else
+			eval_map_value_null(frd, trd);
+		return NULL;
+	}
+
 	if (op == BPF_JEQ)
 		eval_jeq_jne(trd, trs);
 	else if (op == EBPF_JNE)
@@ -1707,7 +1814,8 @@ static const struct bpf_ins_check ins_chk[UINT8_MAX + 1] = {
 	},
 	/* call instruction */
 	[(BPF_JMP | EBPF_CALL)] = {
-		.mask = { .dreg = ZERO_REG, .sreg = ZERO_REG},
+		.mask = { .dreg = ZERO_REG,
+			.sreg = ZERO_REG | 1 << EBPF_HELPER_CALL},
 		.off = { .min = 0, .max = 0},
 		.imm = { .min = 0, .max = UINT32_MAX},
 		.eval = eval_call,
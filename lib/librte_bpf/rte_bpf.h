@@ -64,9 +64,12 @@ struct rte_bpf_arg {
 enum rte_bpf_xtype {
 	RTE_BPF_XTYPE_FUNC, /**< function */
 	RTE_BPF_XTYPE_VAR,  /**< variable */
+	RTE_BPF_XTYPE_MAP,  /**< map */
 	RTE_BPF_XTYPE_NUM
 };
 
+struct rte_bpf_map;
+
 /**
  * Definition for external symbols available in the BPF program.
  */
@@ -86,6 +89,9 @@ struct rte_bpf_xsym {
 			void *val; /**< actual memory location */
 			struct rte_bpf_arg desc; /**< type, size, etc. */
 		} var; /**< external variable */
+		struct {
+			struct rte_bpf_map *val; /**< map handle */
+		} map; /**< map */
 	};
 };
 
@@ -109,7 +115,60 @@ struct rte_bpf_jit {
 	size_t sz;                /**< size of JIT-ed code */
 };
 
+/** Max number of inputs processed by one call of burst JIT-ed code. */
+#define RTE_BPF_JIT_BURST_MAX	64
+
+/**
+ * Information about natively compiled code that runs eBPF program
+ * over a burst of inputs in a single call.
+ * *func* returns a bitmask with bit *i* set when the program returned
+ * non-zero value for ctx[i], *num* must not exceed RTE_BPF_JIT_BURST_MAX.
+ */
+struct rte_bpf_jit_burst {
+	uint64_t (*func)(void *ctx[], uint32_t num);
+	/**< JIT-ed native code */
+	size_t sz; /**< size of JIT-ed code */
+};
+
 struct rte_bpf;
+struct rte_rcu_qsbr;
+
+/** Max length of the map name. */
+#define RTE_BPF_MAP_NAMESIZE	32
+
+/**
+ * Possible types of maps.
+ * Values match the ones used by Linux for the same map types,
+ * so map definitions from ELF files can be used as is.
+ */
+enum rte_bpf_map_type {
+	RTE_BPF_MAP_TYPE_UNSPEC,
+	RTE_BPF_MAP_TYPE_HASH = 1,         /**< hash table */
+	RTE_BPF_MAP_TYPE_ARRAY = 2,        /**< array */
+	RTE_BPF_MAP_TYPE_PERCPU_ARRAY = 6, /**< array with a copy per lcore */
+};
+
+/**
+ * Flags for rte_bpf_map_update_elem().
+ */
+enum {
+	RTE_BPF_MAP_UPDATE_ANY,     /**< create new element or update existing */
+	RTE_BPF_MAP_UPDATE_NOEXIST, /**< create new element only */
+	RTE_BPF_MAP_UPDATE_EXIST,   /**< update existing element only */
+};
+
+/**
+ * Input parameters for creating a map.
+ */
+struct rte_bpf_map_prm {
+	const char *name;           /**< map name */
+	enum rte_bpf_map_type type; /**< map type */
+	uint32_t key_size;
+	/**< key size in bytes, for arrays it must be sizeof(uint32_t) */
+	uint32_t value_size;        /**< value size in bytes */
+	uint32_t max_entries;       /**< max number of elements */
+	int socket_id;              /**< socket to allocate memory from */
+};
 
 /**
  * De-allocate all memory used by this eBPF execution context.
@@ -143,6 +202,10 @@ rte_bpf_load(const struct rte_bpf_prm *prm);
  * Note that if the function will encounter EBPF_PSEUDO_CALL instruction
  * that references external symbol, it will treat is as standard BPF_CALL
  * to the external helper function.
+ * Maps defined in the "maps" section of the file are referenced
+ * through RTE_BPF_XTYPE_MAP symbols of the same name from *prm*,
+ * missing ones are created by the function and released when the
+ * BPF program is destroyed.
  *
  * @param prm
  *  Parameters used to create and initialise the BPF execution context.
@@ -209,6 +272,208 @@ __rte_experimental
 int
 rte_bpf_get_jit(const struct rte_bpf *bpf, struct rte_bpf_jit *jit);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Provide information about natively compiled code that executes
+ * given BPF program over a burst of inputs.
+ * Compared to calling rte_bpf_jit func for each input, it avoids
+ * per input call overhead and prefetches the next input while
+ * the current one is processed.
+ * Right now such code is generated only for x86_64, for other
+ * platforms *func* is set to NULL.
+ *
+ * @param bpf
+ *   handle for the BPF code.
+ * @param jit
+ *   pointer to the rte_bpf_jit_burst structure to be filled
+ *   with related data.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - Zero if operation completed successfully.
+ */
+__rte_experimental
+int
+rte_bpf_get_jit_burst(const struct rte_bpf *bpf,
+	struct rte_bpf_jit_burst *jit);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a new map.
+ * To make the map accessible from the BPF program, pass it in the
+ * *xsym* array of rte_bpf_prm as RTE_BPF_XTYPE_MAP symbol.
+ * The program loads the map handle with EBPF_LD_IMM64 instruction
+ * (or with ELF relocation) and passes it to the EBPF_FUNC_MAP_*
+ * helper functions.
+ *
+ * @param prm
+ *   Parameters of the map.
+ * @return
+ *   Map handle, or NULL on error, with error code set in rte_errno.
+ *   Possible rte_errno errors include:
+ *   - EINVAL - invalid parameter passed to function
+ *   - ENOMEM - can't reserve enough memory
+ */
+__rte_experimental
+struct rte_bpf_map *
+rte_bpf_map_create(const struct rte_bpf_map_prm *prm);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Release the map.
+ * Each BPF program that references the map holds its own reference,
+ * so the map memory is freed only when all such programs are destroyed.
+ *
+ * @param map
+ *   Map handle to release.
+ */
+__rte_experimental
+void
+rte_bpf_map_destroy(struct rte_bpf_map *map);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Find the value of the given key.
+ * For RTE_BPF_MAP_TYPE_PERCPU_ARRAY the copy of the calling lcore
+ * is returned.
+ *
+ * @param map
+ *   Map handle.
+ * @param key
+ *   Pointer to the key.
+ * @return
+ *   Pointer to the value, or NULL if the key is not present.
+ */
+__rte_experimental
+void *
+rte_bpf_map_lookup_elem(struct rte_bpf_map *map, const void *key);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Find the value of the given key of RTE_BPF_MAP_TYPE_PERCPU_ARRAY map,
+ * as seen by the given lcore.
+ * Used by the control path to collect per lcore values.
+ *
+ * @param map
+ *   Map handle.
+ * @param key
+ *   Pointer to the key.
+ * @param lcore_id
+ *   Lcore to get the value for, LCORE_ID_ANY for the copy shared by
+ *   non-EAL threads.
+ * @return
+ *   Pointer to the value, or NULL if the key is not present or the map
+ *   is not RTE_BPF_MAP_TYPE_PERCPU_ARRAY.
+ */
+__rte_experimental
+void *
+rte_bpf_map_lookup_lcore_elem(struct rte_bpf_map *map, const void *key,
+		unsigned int lcore_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create or update the element with the given key.
+ * The value is copied without any synchronisation, concurrent readers
+ * may observe a partially updated value.
+ *
+ * @param map
+ *   Map handle.
+ * @param key
+ *   Pointer to the key.
+ * @param value
+ *   Pointer to the new value.
+ * @param flags
+ *   One of RTE_BPF_MAP_UPDATE_* values.
+ * @return
+ *   - Zero on success.
+ *   - -EINVAL if the parameters are invalid.
+ *   - -E2BIG if the key is out of range of the array.
+ *   - -EEXIST if the element exists and RTE_BPF_MAP_UPDATE_NOEXIST is set.
+ *   - -ENOENT if the element doesn't exist and RTE_BPF_MAP_UPDATE_EXIST
+ *     is set.
+ *   - -ENOSPC if there is no space left in the hash table.
+ */
+__rte_experimental
+int
+rte_bpf_map_update_elem(struct rte_bpf_map *map, const void *key,
+		const void *value, uint64_t flags);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Delete the element with the given key from RTE_BPF_MAP_TYPE_HASH map.
+ * Unless RCU is attached with rte_bpf_map_rcu_qsbr_add(), the element
+ * slot is reused right away, so the application has to make sure that
+ * no reader still uses the value returned by rte_bpf_map_lookup_elem().
+ *
+ * @param map
+ *   Map handle.
+ * @param key
+ *   Pointer to the key.
+ * @return
+ *   - Zero on success.
+ *   - -EINVAL if the parameters are invalid or the map is an array.
+ *   - -ENOENT if the key is not present.
+ */
+__rte_experimental
+int
+rte_bpf_map_delete_elem(struct rte_bpf_map *map, const void *key);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Attach RCU QSBR variable to RTE_BPF_MAP_TYPE_HASH map.
+ * Once attached, slots of deleted elements are reused only after all
+ * the readers registered with the QSBR variable have reported
+ * a quiescent state, so values returned by rte_bpf_map_lookup_elem()
+ * stay valid until then.
+ *
+ * @param map
+ *   Map handle.
+ * @param v
+ *   RCU QSBR variable used by the readers of the map.
+ * @return
+ *   - Zero on success.
+ *   - -EINVAL if the parameters are invalid or the map is an array.
+ *   - -EEXIST if RCU is already attached to the map.
+ *   - -ENOMEM if the defer queue can't be allocated.
+ */
+__rte_experimental
+int
+rte_bpf_map_rcu_qsbr_add(struct rte_bpf_map *map, struct rte_rcu_qsbr *v);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Find the map referenced by the BPF program, either passed by the user
+ * or created by rte_bpf_elf_load() from the ELF "maps" section.
+ *
+ * @param bpf
+ *   handle for the BPF code.
+ * @param name
+ *   Name of the map.
+ * @return
+ *   Map handle, valid until the BPF program is destroyed,
+ *   or NULL if the program doesn't reference such map.
+ */
+__rte_experimental
+struct rte_bpf_map *
+rte_bpf_get_map(const struct rte_bpf *bpf, const char *name);
+
 #ifdef __cplusplus
 }
 #endif
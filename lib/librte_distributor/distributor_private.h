@@ -32,11 +32,13 @@ extern "C" {
 #define RTE_DISTRIB_GET_BUF (1)    /**< worker requests a buffer, returns old */
 #define RTE_DISTRIB_RETURN_BUF (2) /**< worker returns a buffer, no request */
 #define RTE_DISTRIB_VALID_BUF (4)  /**< set if bufptr contains ptr */
+#define RTE_DISTRIB_LEAVE (8)      /**< worker returns old, stops requesting */
 
 #define RTE_DISTRIB_BACKLOG_SIZE 8
 #define RTE_DISTRIB_BACKLOG_MASK (RTE_DISTRIB_BACKLOG_SIZE - 1)
 
-#define RTE_DISTRIB_MAX_RETURNS 128
+/* room for the returns of a few bursts of RTE_DIST_BURST_SIZE_MAX packets */
+#define RTE_DISTRIB_MAX_RETURNS 256
 #define RTE_DISTRIB_RETURNS_MASK (RTE_DISTRIB_MAX_RETURNS - 1)
 
 /**
@@ -61,16 +63,27 @@ union rte_distributor_buffer_single {
 } __rte_cache_aligned;
 
 /*
- * Transfer up to 8 mbufs at a time to/from workers, and
+ * Transfer up to 8 mbufs at a time to/from workers by default, and
  * flow matching algorithm optimized for 8 flow IDs at a time
  */
 #define RTE_DIST_BURST_SIZE 8
 
+/*
+ * Number of buckets of the flow tables, each one mapping the flows hashing
+ * to it onto a worker, see RTE_DIST_FLAG_FLOW_TABLE.
+ */
+#define RTE_DIST_FLOW_TABLE_BITS 13
+#define RTE_DIST_FLOW_TABLE_SIZE (1 << RTE_DIST_FLOW_TABLE_BITS)
+
+/* Worker group of the workers of all NUMA nodes */
+#define RTE_DIST_GROUP_ALL RTE_MAX_NUMA_NODES
+#define RTE_DIST_NUM_GROUPS (RTE_MAX_NUMA_NODES + 1)
+
 struct rte_distributor_backlog {
 	unsigned int start;
 	unsigned int count;
-	int64_t pkts[RTE_DIST_BURST_SIZE] __rte_cache_aligned;
-	uint16_t *tags; /* will point to second cacheline of inflights */
+	int64_t pkts[RTE_DIST_BURST_SIZE_MAX] __rte_cache_aligned;
+	uint16_t *tags; /* will point to second half of inflights */
 } __rte_cache_aligned;
 
 
@@ -113,21 +126,34 @@ enum rte_distributor_match_function {
  * line aligned, but to improve performance and prevent adjacent cache-line
  * prefetches of buffers for other workers, e.g. when worker 1's buffer is on
  * the next cache line to worker 0, we pad this out to two cache lines.
- * We can pass up to 8 mbufs at a time in one cacheline.
- * There is a separate cacheline for returns in the burst API.
+ * We can pass up to 8 mbufs at a time in one cacheline, bigger bursts take
+ * the following ones.
+ * There is a separate set of cachelines for returns in the burst API.
  */
 struct rte_distributor_buffer {
-	volatile int64_t bufptr64[RTE_DIST_BURST_SIZE]
+	volatile int64_t bufptr64[RTE_DIST_BURST_SIZE_MAX]
 		__rte_cache_aligned; /* <= outgoing to worker */
 
 	int64_t pad1 __rte_cache_aligned;    /* <= one cache line  */
 
-	volatile int64_t retptr64[RTE_DIST_BURST_SIZE]
+	volatile int64_t retptr64[RTE_DIST_BURST_SIZE_MAX]
 		__rte_cache_aligned; /* <= incoming from worker */
 
 	int64_t pad2 __rte_cache_aligned;    /* <= one cache line  */
 
 	int count __rte_cache_aligned;       /* <= number of current mbufs */
+	int left;      /* <= worker stopped requesting, flow table mode */
+};
+
+/*
+ * Set of workers among which the new flows are shared, either all the
+ * workers or those of a NUMA node.
+ */
+struct rte_distributor_group {
+	unsigned int count;   /**< Number of workers in the group */
+	unsigned int next;    /**< Index of the worker taking new flows */
+	uint16_t *workers;    /**< Worker ids */
+	uint16_t *flow_table; /**< Worker id per flow bucket, flow table mode */
 };
 
 struct rte_distributor {
@@ -136,26 +162,36 @@ struct rte_distributor {
 	char name[RTE_DISTRIBUTOR_NAMESIZE];  /**< Name of the ring. */
 	unsigned int num_workers;             /**< Number of workers polling */
 	unsigned int alg_type;                /**< Number of alg types */
+	unsigned int burst_size;              /**< Max packets per burst */
+	uint32_t flags;                       /**< RTE_DIST_FLAG_* */
+	int numa_grouping;    /**< New flows stay on the node of the packet */
 
 	/**>
-	 * First cache line in the this array are the tags inflight
-	 * on the worker core. Second cache line are the backlog
-	 * that are going to go to the worker core.
+	 * For each worker, burst_size tags inflight on the worker
+	 * core, followed by burst_size tags of the backlog that are
+	 * going to go to the worker core. Sized for num_workers.
 	 */
-	uint16_t in_flight_tags[RTE_DISTRIB_MAX_WORKERS][RTE_DIST_BURST_SIZE*2]
-			__rte_cache_aligned;
+	uint16_t *in_flight_tags;
 
-	struct rte_distributor_backlog backlog[RTE_DISTRIB_MAX_WORKERS]
-			__rte_cache_aligned;
+	/**< Per worker backlogs and buffers, sized for num_workers */
+	struct rte_distributor_backlog *backlog;
+	struct rte_distributor_buffer *bufs;
 
-	struct rte_distributor_buffer bufs[RTE_DISTRIB_MAX_WORKERS];
+	struct rte_distributor_group groups[RTE_DIST_NUM_GROUPS];
 
 	struct rte_distributor_returned_pkts returns;
 
 	enum rte_distributor_match_function dist_match_fn;
 
 	struct rte_distributor_single *d_single;
-};
+} __rte_cache_aligned;
+
+/* tags in flight on a worker, followed by the tags of its backlog */
+static inline uint16_t *
+dist_tags(const struct rte_distributor *d, unsigned int wkr)
+{
+	return &d->in_flight_tags[wkr * d->burst_size * 2];
+}
 
 void
 find_match_scalar(struct rte_distributor *d,
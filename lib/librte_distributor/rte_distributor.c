@@ -64,7 +64,7 @@ rte_distributor_request_pkt(struct rte_distributor *d,
 	 * handshake bits. Populate the retptrs with returning packets.
 	 */
 
-	for (i = count; i < RTE_DIST_BURST_SIZE; i++)
+	for (i = count; i < d->burst_size; i++)
 		buf->retptr64[i] = 0;
 
 	/* Set Return bit for each packet returned */
@@ -104,12 +104,15 @@ rte_distributor_poll_pkt(struct rte_distributor *d,
 		& RTE_DISTRIB_GET_BUF)
 		return -1;
 
-	/* since bufptr64 is signed, this should be an arithmetic shift */
-	for (i = 0; i < RTE_DIST_BURST_SIZE; i++) {
-		if (likely(buf->bufptr64[i] & RTE_DISTRIB_VALID_BUF)) {
-			ret = buf->bufptr64[i] >> RTE_DISTRIB_FLAG_BITS;
-			pkts[count++] = (struct rte_mbuf *)((uintptr_t)(ret));
-		}
+	/*
+	 * since bufptr64 is signed, this should be an arithmetic shift,
+	 * the valid buffers are at the start of the burst
+	 */
+	for (i = 0; i < d->burst_size; i++) {
+		if (!(buf->bufptr64[i] & RTE_DISTRIB_VALID_BUF))
+			break;
+		ret = buf->bufptr64[i] >> RTE_DISTRIB_FLAG_BITS;
+		pkts[count++] = (struct rte_mbuf *)((uintptr_t)(ret));
 	}
 
 	/*
@@ -171,7 +174,7 @@ rte_distributor_return_pkt(struct rte_distributor *d,
 
 	/* Sync with distributor to acquire retptrs */
 	__atomic_thread_fence(__ATOMIC_ACQUIRE);
-	for (i = 0; i < RTE_DIST_BURST_SIZE; i++)
+	for (i = 0; i < d->burst_size; i++)
 		/* Switch off the return bit first */
 		buf->retptr64[i] &= ~RTE_DISTRIB_RETURN_BUF;
 
@@ -179,17 +182,26 @@ rte_distributor_return_pkt(struct rte_distributor *d,
 		buf->retptr64[i] = (((int64_t)(uintptr_t)oldpkt[i]) <<
 			RTE_DISTRIB_FLAG_BITS) | RTE_DISTRIB_RETURN_BUF;
 
-	/* set the GET_BUF but even if we got no returns.
+	/* set the GET_BUF but even if we got no returns, in flow table
+	 * mode along with LEAVE so that the flows of the worker are moved
+	 * to the other ones until it requests packets again.
 	 * Sync with distributor on GET_BUF flag. Release retptrs.
 	 */
 	__atomic_store_n(&(buf->retptr64[0]),
-		buf->retptr64[0] | RTE_DISTRIB_GET_BUF, __ATOMIC_RELEASE);
+		buf->retptr64[0] | RTE_DISTRIB_GET_BUF |
+		((d->flags & RTE_DIST_FLAG_FLOW_TABLE) ? RTE_DISTRIB_LEAVE : 0),
+		__ATOMIC_RELEASE);
 
 	return 0;
 }
 
 /**** APIs called on distributor core ***/
 
+static void handle_worker_leave(struct rte_distributor *d, unsigned int wkr);
+static unsigned int redirect_backlog(struct rte_distributor *d,
+		unsigned int wkr);
+static void dist_update_flow_tables(struct rte_distributor *d);
+
 /* stores a packet returned from a worker inside the returns array */
 static inline void
 store_return(uintptr_t oldbuf, struct rte_distributor *d,
@@ -215,35 +227,26 @@ find_match_scalar(struct rte_distributor *d,
 			uint16_t *data_ptr,
 			uint16_t *output_ptr)
 {
-	struct rte_distributor_backlog *bl;
-	uint16_t i, j, w;
+	uint16_t *tags;
+	unsigned int i, j, w;
 
 	/*
 	 * Function overview:
 	 * 1. Loop through all worker ID's
-	 * 2. Compare the current inflights to the incoming tags
-	 * 3. Compare the current backlog to the incoming tags
-	 * 4. Add any matches to the output
+	 * 2. Compare the current inflights and backlog to the incoming tags
+	 * 3. Add any matches to the output
 	 */
 
 	for (j = 0 ; j < RTE_DIST_BURST_SIZE; j++)
 		output_ptr[j] = 0;
 
 	for (i = 0; i < d->num_workers; i++) {
-		bl = &d->backlog[i];
+		tags = dist_tags(d, i);
 
-		for (j = 0; j < RTE_DIST_BURST_SIZE ; j++)
+		for (j = 0; j < d->burst_size * 2; j++)
 			for (w = 0; w < RTE_DIST_BURST_SIZE; w++)
-				if (d->in_flight_tags[i][j] == data_ptr[w]) {
-					output_ptr[j] = i+1;
-					break;
-				}
-		for (j = 0; j < RTE_DIST_BURST_SIZE; j++)
-			for (w = 0; w < RTE_DIST_BURST_SIZE; w++)
-				if (bl->tags[j] == data_ptr[w]) {
-					output_ptr[j] = i+1;
-					break;
-				}
+				if (tags[j] == data_ptr[w])
+					output_ptr[w] = i+1;
 	}
 
 	/*
@@ -253,7 +256,6 @@ find_match_scalar(struct rte_distributor *d,
 	 */
 }
 
-
 /*
  * When the handshake bits indicate that there are packets coming
  * back from the worker, this function is called to copy and store
@@ -272,7 +274,7 @@ handle_returns(struct rte_distributor *d, unsigned int wkr)
 	/* Sync on GET_BUF flag. Acquire retptrs. */
 	if (__atomic_load_n(&(buf->retptr64[0]), __ATOMIC_ACQUIRE)
 		& RTE_DISTRIB_GET_BUF) {
-		for (i = 0; i < RTE_DIST_BURST_SIZE; i++) {
+		for (i = 0; i < d->burst_size; i++) {
 			if (buf->retptr64[i] & RTE_DISTRIB_RETURN_BUF) {
 				oldbuf = ((uintptr_t)(buf->retptr64[i] >>
 					RTE_DISTRIB_FLAG_BITS));
@@ -284,6 +286,17 @@ handle_returns(struct rte_distributor *d, unsigned int wkr)
 		}
 		d->returns.start = ret_start;
 		d->returns.count = ret_count;
+
+		if (unlikely(buf->retptr64[0] & RTE_DISTRIB_LEAVE)) {
+			handle_worker_leave(d, wkr);
+			return count;
+		}
+		if (unlikely(buf->left)) {
+			/* the worker is back, give it its flows again */
+			buf->left = 0;
+			dist_update_flow_tables(d);
+		}
+
 		/* Clear for the worker to populate with more returns.
 		 * Sync with distributor on GET_BUF flag. Release retptrs.
 		 */
@@ -305,26 +318,41 @@ static unsigned int
 release(struct rte_distributor *d, unsigned int wkr)
 {
 	struct rte_distributor_buffer *buf = &(d->bufs[wkr]);
-	unsigned int i;
+	unsigned int i, prev_count;
+	uint16_t *tags;
 
 	/* Sync with worker on GET_BUF flag */
 	while (!(__atomic_load_n(&(d->bufs[wkr].bufptr64[0]), __ATOMIC_ACQUIRE)
-		& RTE_DISTRIB_GET_BUF))
+		& RTE_DISTRIB_GET_BUF)) {
+		/* a worker leaving never reads the burst it was sent */
+		if (d->flags & RTE_DIST_FLAG_FLOW_TABLE)
+			handle_returns(d, wkr);
 		rte_pause();
+	}
 
 	handle_returns(d, wkr);
 
+	/*
+	 * The packets queued for a worker which left go to the workers now
+	 * owning their flows, or wait in its buffer if none is left.
+	 */
+	if (unlikely(buf->left) && redirect_backlog(d, wkr) == 0)
+		return 0;
+
+	prev_count = RTE_MAX(buf->count, 1);
 	buf->count = 0;
 
+	tags = dist_tags(d, wkr);
 	for (i = 0; i < d->backlog[wkr].count; i++) {
 		d->bufs[wkr].bufptr64[i] = d->backlog[wkr].pkts[i] |
 				RTE_DISTRIB_GET_BUF | RTE_DISTRIB_VALID_BUF;
-		d->in_flight_tags[wkr][i] = d->backlog[wkr].tags[i];
+		tags[i] = d->backlog[wkr].tags[i];
 	}
 	buf->count = i;
-	for ( ; i < RTE_DIST_BURST_SIZE ; i++) {
+	/* only the buffers of the previous burst need to be invalidated */
+	for ( ; i < prev_count ; i++) {
 		buf->bufptr64[i] = RTE_DISTRIB_GET_BUF;
-		d->in_flight_tags[wkr][i] = 0;
+		tags[i] = 0;
 	}
 
 	d->backlog[wkr].count = 0;
@@ -339,18 +367,149 @@ release(struct rte_distributor *d, unsigned int wkr)
 }
 
 
+/* worker group among which the new flows of a packet are distributed */
+static inline struct rte_distributor_group *
+dist_group(struct rte_distributor *d, const struct rte_mbuf *mb)
+{
+	int socket;
+
+	if (likely(!d->numa_grouping))
+		return &d->groups[RTE_DIST_GROUP_ALL];
+
+	/* packets stay on the node they were received on, if it has workers */
+	socket = mb->pool->socket_id;
+	if (socket < 0 || socket >= RTE_MAX_NUMA_NODES ||
+			d->groups[socket].count == 0)
+		return &d->groups[RTE_DIST_GROUP_ALL];
+
+	return &d->groups[socket];
+}
+
+/* queues a packet for a worker, releasing its backlog first if full */
+static inline void
+add_to_backlog(struct rte_distributor *d, unsigned int wkr,
+		int64_t value, uint16_t tag)
+{
+	struct rte_distributor_backlog *bl = &d->backlog[wkr];
+	unsigned int idx;
+
+	if (unlikely(bl->count == d->burst_size))
+		release(d, wkr);
+
+	idx = bl->count++;
+	bl->tags[idx] = tag;
+	bl->pkts[idx] = value;
+}
+
+/* flow table bucket of a flow id, by multiplicative hashing */
+static inline uint32_t
+flow_bucket(uint32_t flow_id)
+{
+	return (flow_id * 2654435761u) >> (32 - RTE_DIST_FLOW_TABLE_BITS);
+}
+
+/* worker the flow of a packet is mapped to, in flow table mode */
+static inline unsigned int
+flow_worker(struct rte_distributor *d, const struct rte_mbuf *mb)
+{
+	return dist_group(d, mb)->flow_table[flow_bucket(mb->hash.usr)];
+}
+
+/*
+ * Flow table mode: hands the packets queued for a worker which left over to
+ * the workers now owning their flows. Those still mapped to it, when no
+ * worker of their group is left, stay in its backlog whose size is returned.
+ */
+static unsigned int
+redirect_backlog(struct rte_distributor *d, unsigned int wkr)
+{
+	struct rte_distributor_backlog *bl = &d->backlog[wkr];
+	int64_t pkts[RTE_DIST_BURST_SIZE_MAX];
+	unsigned int i, count = bl->count;
+
+	for (i = 0; i < count; i++)
+		pkts[i] = bl->pkts[i];
+	bl->count = 0;
+
+	for (i = 0; i < count; i++)
+		add_to_backlog(d, flow_worker(d, (struct rte_mbuf *)(uintptr_t)
+			(pkts[i] >> RTE_DISTRIB_FLAG_BITS)), pkts[i], 0);
+
+	return bl->count;
+}
+
+/*
+ * Flow table mode: a worker returned its packets without requesting new ones.
+ * Its flows are moved to the other workers and the packets it was sent but
+ * did not read, followed by its backlog, are redistributed.
+ */
+static void
+handle_worker_leave(struct rte_distributor *d, unsigned int wkr)
+{
+	struct rte_distributor_buffer *buf = &d->bufs[wkr];
+	struct rte_distributor_backlog *bl = &d->backlog[wkr];
+	int64_t pkts[RTE_DIST_BURST_SIZE_MAX * 2];
+	unsigned int i, count = 0;
+
+	buf->left = 1;
+	dist_update_flow_tables(d);
+
+	/* the burst was sent after the last request of the worker */
+	if (!(__atomic_load_n(&(buf->bufptr64[0]), __ATOMIC_ACQUIRE)
+			& RTE_DISTRIB_GET_BUF))
+		for (i = 0; i < d->burst_size &&
+				(buf->bufptr64[i] & RTE_DISTRIB_VALID_BUF); i++)
+			pkts[count++] = buf->bufptr64[i] &
+				~(int64_t)RTE_DISTRIB_FLAGS_MASK;
+
+	/* the buffer can be written again, it is not read until a request */
+	__atomic_store_n(&(buf->bufptr64[0]), RTE_DISTRIB_GET_BUF,
+		__ATOMIC_RELEASE);
+
+	for (i = 0; i < bl->count; i++)
+		pkts[count++] = bl->pkts[i];
+	bl->count = 0;
+
+	/* Let the worker request packets again. Release retptrs. */
+	__atomic_store_n(&(buf->retptr64[0]), 0, __ATOMIC_RELEASE);
+
+	for (i = 0; i < count; i++)
+		add_to_backlog(d, flow_worker(d, (struct rte_mbuf *)(uintptr_t)
+			(pkts[i] >> RTE_DISTRIB_FLAG_BITS)), pkts[i], 0);
+}
+
+/*
+ * Flow table mode: each packet goes to the worker its flow bucket is mapped
+ * to, no matching against the flows in flight is needed.
+ */
+static void
+process_flow_table(struct rte_distributor *d,
+		struct rte_mbuf **mbufs, unsigned int num_mbufs)
+{
+	struct rte_mbuf *next_mb;
+	unsigned int i;
+
+	for (i = 0; i < num_mbufs; i++) {
+		next_mb = mbufs[i];
+		add_to_backlog(d, flow_worker(d, next_mb),
+			((int64_t)(uintptr_t)next_mb) << RTE_DISTRIB_FLAG_BITS,
+			0);
+	}
+}
+
 /* process a set of packets to distribute them to workers */
 int
 rte_distributor_process(struct rte_distributor *d,
 		struct rte_mbuf **mbufs, unsigned int num_mbufs)
 {
 	unsigned int next_idx = 0;
-	static unsigned int wkr;
+	struct rte_distributor_group *g;
 	struct rte_mbuf *next_mb = NULL;
 	int64_t next_value = 0;
 	uint16_t new_tag = 0;
 	uint16_t flows[RTE_DIST_BURST_SIZE] __rte_cache_aligned;
-	unsigned int i, j, w, wid;
+	uint64_t new_flow_groups;
+	unsigned int i, j, w, wid, wkr;
 
 	if (d->alg_type == RTE_DIST_ALG_SINGLE) {
 		/* Call the old API */
@@ -366,20 +525,23 @@ rte_distributor_process(struct rte_distributor *d,
 				__ATOMIC_ACQUIRE) & RTE_DISTRIB_GET_BUF) {
 				release(d, wid);
 				handle_returns(d, wid);
+			} else if (d->flags & RTE_DIST_FLAG_FLOW_TABLE) {
+				/* catch the workers leaving with a burst */
+				handle_returns(d, wid);
 			}
 		}
 		return 0;
 	}
 
+	if (d->flags & RTE_DIST_FLAG_FLOW_TABLE) {
+		process_flow_table(d, mbufs, num_mbufs);
+		next_idx = num_mbufs;
+	}
+
 	while (next_idx < num_mbufs) {
 		uint16_t matches[RTE_DIST_BURST_SIZE];
 		unsigned int pkts;
 
-		/* Sync with worker on GET_BUF flag. */
-		if (__atomic_load_n(&(d->bufs[wkr].bufptr64[0]),
-			__ATOMIC_ACQUIRE) & RTE_DISTRIB_GET_BUF)
-			d->bufs[wkr].count = 0;
-
 		if ((num_mbufs - next_idx) < RTE_DIST_BURST_SIZE)
 			pkts = num_mbufs - next_idx;
 		else
@@ -408,6 +570,7 @@ rte_distributor_process(struct rte_distributor *d,
 		 * the incoming packets. Any zeroes need to be assigned
 		 * workers.
 		 */
+		new_flow_groups = 0;
 
 		for (j = 0; j < pkts; j++) {
 
@@ -431,32 +594,16 @@ rte_distributor_process(struct rte_distributor *d,
 			/* matches[j] = 0; */
 
 			if (matches[j]) {
-				struct rte_distributor_backlog *bl =
-						&d->backlog[matches[j]-1];
-				if (unlikely(bl->count ==
-						RTE_DIST_BURST_SIZE)) {
-					release(d, matches[j]-1);
-				}
-
 				/* Add to worker that already has flow */
-				unsigned int idx = bl->count++;
-
-				bl->tags[idx] = new_tag;
-				bl->pkts[idx] = next_value;
-
+				add_to_backlog(d, matches[j] - 1,
+						next_value, new_tag);
 			} else {
-				struct rte_distributor_backlog *bl =
-						&d->backlog[wkr];
-				if (unlikely(bl->count ==
-						RTE_DIST_BURST_SIZE)) {
-					release(d, wkr);
-				}
-
-				/* Add to current worker worker */
-				unsigned int idx = bl->count++;
-
-				bl->tags[idx] = new_tag;
-				bl->pkts[idx] = next_value;
+				/* Add to current worker of the group */
+				g = dist_group(d, next_mb);
+				wkr = g->workers[g->next];
+				new_flow_groups |= 1ULL << (g - d->groups);
+
+				add_to_backlog(d, wkr, next_value, new_tag);
 				/*
 				 * Now that we've just added an unpinned flow
 				 * to a worker, we need to ensure that all
@@ -468,9 +615,14 @@ rte_distributor_process(struct rte_distributor *d,
 						matches[w] = wkr+1;
 			}
 		}
-		wkr++;
-		if (wkr >= d->num_workers)
-			wkr = 0;
+
+		/* next new flows go to the next worker of their group */
+		while (new_flow_groups != 0) {
+			g = &d->groups[__builtin_ctzll(new_flow_groups)];
+			new_flow_groups &= new_flow_groups - 1;
+			if (++g->next >= g->count)
+				g->next = 0;
+		}
 	}
 
 	/* Flush out all non-full cache-lines to workers. */
@@ -543,20 +695,26 @@ rte_distributor_flush(struct rte_distributor *d)
 
 	flushed = total_outstanding(d);
 
-	while (total_outstanding(d) > 0)
-		rte_distributor_process(d, NULL, 0);
-
-	/* wait 10ms to allow all worker drain the pkts */
-	rte_delay_us(10000);
-
 	/*
-	 * Send empty burst to all workers to allow them to exit
-	 * gracefully, should they need to.
+	 * In flow table mode, the packets of the workers leaving meanwhile
+	 * are queued again for the other ones.
 	 */
-	rte_distributor_process(d, NULL, 0);
+	do {
+		while (total_outstanding(d) > 0)
+			rte_distributor_process(d, NULL, 0);
 
-	for (wkr = 0; wkr < d->num_workers; wkr++)
-		handle_returns(d, wkr);
+		/* wait 10ms to allow all worker drain the pkts */
+		rte_delay_us(10000);
+
+		/*
+		 * Send empty burst to all workers to allow them to exit
+		 * gracefully, should they need to.
+		 */
+		rte_distributor_process(d, NULL, 0);
+
+		for (wkr = 0; wkr < d->num_workers; wkr++)
+			handle_returns(d, wkr);
+	} while (total_outstanding(d) > 0);
 
 	return flushed;
 }
@@ -580,59 +738,257 @@ rte_distributor_clear_returns(struct rte_distributor *d)
 				__ATOMIC_RELEASE);
 }
 
+/*
+ * Jump consistent hash (Lamping and Veach): maps a key to one of num_buckets
+ * buckets, only moving 1/num_buckets of the keys when adding a bucket.
+ */
+static unsigned int
+jump_consistent_hash(uint64_t key, unsigned int num_buckets)
+{
+	int64_t b = -1, j = 0;
+
+	while (j < num_buckets) {
+		b = j;
+		key = key * 2862933555777941757ULL + 1;
+		j = (b + 1) * ((double)(1LL << 31) / (double)((key >> 33) + 1));
+	}
+
+	return b;
+}
+
+/* maps the flow buckets of a group onto the workers which have not left */
+static void
+dist_update_flow_table(struct rte_distributor *d,
+		struct rte_distributor_group *g)
+{
+	const uint16_t *all = d->groups[RTE_DIST_GROUP_ALL].flow_table;
+	uint16_t active[RTE_MAX_LCORE];
+	unsigned int i, b, num = 0;
+	uint16_t wkr;
+
+	for (i = 0; i < g->count; i++)
+		if (!d->bufs[g->workers[i]].left)
+			active[num++] = g->workers[i];
+
+	for (b = 0; b < RTE_DIST_FLOW_TABLE_SIZE; b++) {
+		/*
+		 * Each bucket stays on its worker while it is there, the
+		 * buckets of the workers which left are spread on the others.
+		 */
+		wkr = g->workers[jump_consistent_hash(b, g->count)];
+		if (!d->bufs[wkr].left)
+			g->flow_table[b] = wkr;
+		else if (num != 0)
+			g->flow_table[b] = active[jump_consistent_hash(b, num)];
+		else if (g->flow_table != all)
+			/* all the workers of the node left */
+			g->flow_table[b] = all[b];
+		/* else no worker is left, the mapping is kept */
+	}
+}
+
+/*
+ * Flow table mode: (re)builds the flow tables, when setting up the instance
+ * and whenever a worker leaves or comes back.
+ */
+static void
+dist_update_flow_tables(struct rte_distributor *d)
+{
+	struct rte_distributor_group *g;
+
+	/* the node groups fall back on the table of all the workers */
+	dist_update_flow_table(d, &d->groups[RTE_DIST_GROUP_ALL]);
+	for (g = d->groups; g != &d->groups[RTE_DIST_GROUP_ALL]; g++)
+		if (g->flow_table != NULL)
+			dist_update_flow_table(d, g);
+}
+
+/* sets up the worker groups, and their flow table in flow table mode */
+static void
+dist_setup_groups(struct rte_distributor *d, const int *worker_socket_id,
+		uint16_t *workers, uint16_t *flow_table)
+{
+	struct rte_distributor_group *g;
+	unsigned int i;
+	int socket;
+
+	g = &d->groups[RTE_DIST_GROUP_ALL];
+	g->workers = workers;
+	for (i = 0; i < d->num_workers; i++)
+		g->workers[g->count++] = i;
+	workers += g->count;
+
+	if (worker_socket_id != NULL) {
+		d->numa_grouping = 1;
+		for (socket = 0; socket < RTE_MAX_NUMA_NODES; socket++) {
+			g = &d->groups[socket];
+			g->workers = workers;
+			for (i = 0; i < d->num_workers; i++)
+				if (worker_socket_id[i] == socket)
+					g->workers[g->count++] = i;
+			workers += g->count;
+		}
+	}
+
+	if (!(d->flags & RTE_DIST_FLAG_FLOW_TABLE))
+		return;
+
+	for (g = d->groups; g != &d->groups[RTE_DIST_NUM_GROUPS]; g++) {
+		if (g->count == 0)
+			continue;
+		g->flow_table = flow_table;
+		flow_table += RTE_DIST_FLOW_TABLE_SIZE;
+	}
+
+	dist_update_flow_tables(d);
+}
+
+/* checks the parameters of a distributor instance */
+static int
+dist_check_params(const struct rte_distributor_params *params)
+{
+	unsigned int burst_size = params->burst_size;
+	unsigned int i;
+
+	if (params->name == NULL)
+		return -EINVAL;
+
+	if (params->alg_type == RTE_DIST_ALG_SINGLE) {
+		if (params->num_workers >= (unsigned int)RTE_MIN(
+				RTE_DISTRIB_MAX_WORKERS, RTE_MAX_LCORE))
+			return -EINVAL;
+		/* the single packet algorithm has none of the options */
+		if (burst_size > 1 || params->flags != 0 ||
+				params->worker_socket_id != NULL)
+			return -EINVAL;
+		return 0;
+	}
+
+	if (params->alg_type != RTE_DIST_ALG_BURST)
+		return -EINVAL;
+	if (params->num_workers == 0 ||
+			params->num_workers >= RTE_MAX_LCORE)
+		return -EINVAL;
+	if (burst_size != 0 && (!rte_is_power_of_2(burst_size) ||
+			burst_size < RTE_DIST_BURST_SIZE ||
+			burst_size > RTE_DIST_BURST_SIZE_MAX))
+		return -EINVAL;
+	if (params->flags & ~RTE_DIST_FLAG_FLOW_TABLE)
+		return -EINVAL;
+
+	if (params->worker_socket_id != NULL)
+		for (i = 0; i < params->num_workers; i++)
+			if (params->worker_socket_id[i] < 0 ||
+					params->worker_socket_id[i] >=
+					RTE_MAX_NUMA_NODES)
+				return -EINVAL;
+
+	return 0;
+}
+
 /* creates a distributor instance */
 struct rte_distributor *
-rte_distributor_create(const char *name,
-		unsigned int socket_id,
-		unsigned int num_workers,
-		unsigned int alg_type)
+rte_distributor_create_with_params(const struct rte_distributor_params *params)
 {
 	struct rte_distributor *d;
 	struct rte_dist_burst_list *dist_burst_list;
 	char mz_name[RTE_MEMZONE_NAMESIZE];
 	const struct rte_memzone *mz;
+	size_t size, tags_off, backlog_off, bufs_off, workers_off, table_off;
+	unsigned int num_workers, burst_size, num_tables;
 	unsigned int i;
+	int ret;
 
 	/* TODO Reorganise function properly around RTE_DIST_ALG_SINGLE/BURST */
 
 	/* compilation-time checks */
 	RTE_BUILD_BUG_ON((sizeof(*d) & RTE_CACHE_LINE_MASK) != 0);
 	RTE_BUILD_BUG_ON((RTE_DISTRIB_MAX_WORKERS & 7) != 0);
+	RTE_BUILD_BUG_ON(RTE_DIST_NUM_GROUPS > 64);
+	RTE_BUILD_BUG_ON(RTE_MAX_LCORE > UINT16_MAX);
 
-	if (name == NULL || num_workers >=
-		(unsigned int)RTE_MIN(RTE_DISTRIB_MAX_WORKERS, RTE_MAX_LCORE)) {
+	if (params == NULL) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
 
-	if (alg_type == RTE_DIST_ALG_SINGLE) {
+	ret = dist_check_params(params);
+	if (ret < 0) {
+		rte_errno = -ret;
+		return NULL;
+	}
+
+	num_workers = params->num_workers;
+
+	if (params->alg_type == RTE_DIST_ALG_SINGLE) {
 		d = malloc(sizeof(struct rte_distributor));
 		if (d == NULL) {
 			rte_errno = ENOMEM;
 			return NULL;
 		}
-		d->d_single = rte_distributor_create_single(name,
-				socket_id, num_workers);
+		d->d_single = rte_distributor_create_single(params->name,
+				params->socket_id, num_workers);
 		if (d->d_single == NULL) {
 			free(d);
 			/* rte_errno will have been set */
 			return NULL;
 		}
-		d->alg_type = alg_type;
+		d->alg_type = params->alg_type;
 		return d;
 	}
 
-	snprintf(mz_name, sizeof(mz_name), RTE_DISTRIB_PREFIX"%s", name);
-	mz = rte_memzone_reserve(mz_name, sizeof(*d), socket_id, NO_FLAGS);
+	burst_size = params->burst_size != 0 ?
+			params->burst_size : RTE_DIST_BURST_SIZE;
+
+	/* the per worker arrays and the flow tables follow the instance */
+	num_tables = 0;
+	if (params->flags & RTE_DIST_FLAG_FLOW_TABLE) {
+		num_tables = 1;
+		for (i = 0; params->worker_socket_id != NULL &&
+				i < RTE_MAX_NUMA_NODES; i++) {
+			unsigned int w = 0;
+
+			while (w < num_workers &&
+					params->worker_socket_id[w] != (int)i)
+				w++;
+			num_tables += w < num_workers;
+		}
+	}
+
+	size = sizeof(*d);
+	tags_off = size;
+	size += RTE_CACHE_LINE_ROUNDUP(num_workers * burst_size * 2 *
+			sizeof(uint16_t));
+	backlog_off = size;
+	size += num_workers * sizeof(struct rte_distributor_backlog);
+	bufs_off = size;
+	size += num_workers * sizeof(struct rte_distributor_buffer);
+	workers_off = size;
+	size += RTE_CACHE_LINE_ROUNDUP(num_workers * 2 * sizeof(uint16_t));
+	table_off = size;
+	size += num_tables * RTE_DIST_FLOW_TABLE_SIZE * sizeof(uint16_t);
+
+	snprintf(mz_name, sizeof(mz_name), RTE_DISTRIB_PREFIX"%s",
+			params->name);
+	mz = rte_memzone_reserve(mz_name, size, params->socket_id, NO_FLAGS);
 	if (mz == NULL) {
 		rte_errno = ENOMEM;
 		return NULL;
 	}
 
 	d = mz->addr;
-	strlcpy(d->name, name, sizeof(d->name));
+	memset(d, 0, size);
+	strlcpy(d->name, params->name, sizeof(d->name));
 	d->num_workers = num_workers;
-	d->alg_type = alg_type;
+	d->alg_type = params->alg_type;
+	d->burst_size = burst_size;
+	d->flags = params->flags;
+
+	d->in_flight_tags = RTE_PTR_ADD(d, tags_off);
+	d->backlog = RTE_PTR_ADD(d, backlog_off);
+	d->bufs = RTE_PTR_ADD(d, bufs_off);
+	dist_setup_groups(d, params->worker_socket_id,
+			RTE_PTR_ADD(d, workers_off), RTE_PTR_ADD(d, table_off));
 
 	d->dist_match_fn = RTE_DIST_MATCH_SCALAR;
 #if defined(RTE_ARCH_X86)
@@ -640,11 +996,11 @@ rte_distributor_create(const char *name,
 #endif
 
 	/*
-	 * Set up the backlog tags so they're pointing at the second cache
-	 * line for performance during flow matching
+	 * Set up the backlog tags so they're pointing at the second half
+	 * of the worker tags for performance during flow matching
 	 */
 	for (i = 0 ; i < num_workers ; i++)
-		d->backlog[i].tags = &d->in_flight_tags[i][RTE_DIST_BURST_SIZE];
+		d->backlog[i].tags = &dist_tags(d, i)[burst_size];
 
 	dist_burst_list = RTE_TAILQ_CAST(rte_dist_burst_tailq.head,
 					  rte_dist_burst_list);
@@ -656,3 +1012,19 @@ rte_distributor_create(const char *name,
 
 	return d;
 }
+
+struct rte_distributor *
+rte_distributor_create(const char *name,
+		unsigned int socket_id,
+		unsigned int num_workers,
+		unsigned int alg_type)
+{
+	struct rte_distributor_params params = {
+		.name = name,
+		.socket_id = socket_id,
+		.num_workers = num_workers,
+		.alg_type = alg_type,
+	};
+
+	return rte_distributor_create_with_params(&params);
+}
@@ -13,6 +13,10 @@
  * one-at-a-time to workers, with dynamic load balancing.
  */
 
+#include <stdint.h>
+
+#include <rte_compat.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,6 +56,84 @@ rte_distributor_create(const char *name, unsigned int socket_id,
 		unsigned int num_workers,
 		unsigned int alg_type);
 
+/** Maximum number of packets passed at a time to and from a worker */
+#define RTE_DIST_BURST_SIZE_MAX 64
+
+/**
+ * Distributor flag: pin each flow to a worker through a flow table, rather
+ * than matching the flows against the flows in flight on the workers.
+ *
+ * The flow id, the full 32 bits of the tag, is hashed to one of the buckets
+ * of a table mapping each bucket to a worker. The buckets are shared among
+ * the workers by consistent hashing. The cost of distributing a packet does
+ * not depend on the number of workers, but the load is balanced by flow and
+ * no longer at run time: a busy worker holds back the flows mapped to it.
+ * The packets of a flow are always processed by the same worker, in order.
+ *
+ * When a worker stops with rte_distributor_return_pkt(), its buckets and
+ * the packets queued for it are moved to the other workers of its group,
+ * until it requests packets again. The packets of the flows moved may then
+ * be processed out of order. If no worker is left, the packets wait for
+ * one to come back.
+ */
+#define RTE_DIST_FLAG_FLOW_TABLE (1 << 0)
+
+/**
+ * Parameters of a distributor instance, see
+ * rte_distributor_create_with_params().
+ */
+struct rte_distributor_params {
+	const char *name;
+	/**< The name to be given to the distributor instance. */
+	int socket_id;
+	/**< The NUMA node on which the memory is to be allocated. */
+	unsigned int num_workers;
+	/**< The maximum number of workers that will request packets. */
+	unsigned int alg_type;
+	/**< The distribution algorithm, one of enum rte_distributor_alg_type. */
+	unsigned int burst_size;
+	/**<
+	 * Burst algorithm: maximum number of packets passed at a time to a
+	 * worker, a power of 2 between 8 and RTE_DIST_BURST_SIZE_MAX, or 0
+	 * for the default of 8. The packet arrays of the workers must have
+	 * room for this many packets.
+	 */
+	uint32_t flags;
+	/**< Burst algorithm: RTE_DIST_FLAG_* flags. */
+	const int *worker_socket_id;
+	/**<
+	 * Burst algorithm: NUMA node of each of the num_workers workers, or
+	 * NULL. When given, the new flows are distributed to the workers of
+	 * the node of the packet mempool, if any, so that packets are
+	 * processed on the node they were received on.
+	 */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Function to create a new distributor instance from a set of parameters
+ *
+ * Same as rte_distributor_create(), with the burst size, flow table mode and
+ * NUMA grouping of the workers of the burst algorithm configurable.
+ *
+ * The burst algorithm supports up to RTE_MAX_LCORE - 1 workers, that is
+ * 127 with the default build configuration: more workers require a bigger
+ * CONFIG_RTE_MAX_LCORE (meson option max_lcores). The single packet
+ * algorithm supports up to 63 workers.
+ *
+ * @param params
+ *   The parameters of the distributor instance.
+ * @return
+ *   The newly created distributor instance, or NULL with rte_errno set:
+ *    - EINVAL - invalid parameters
+ *    - ENOMEM - no memory for the distributor instance
+ */
+__rte_experimental
+struct rte_distributor *
+rte_distributor_create_with_params(const struct rte_distributor_params *params);
+
 /*  *** APIS to be called on the distributor lcore ***  */
 /*
  * The following APIs are the public APIs which are designed for use on a
@@ -153,7 +235,8 @@ rte_distributor_clear_returns(struct rte_distributor *d);
  *   The worker instance number to use - must be less that num_workers passed
  *   at distributor creation time.
  * @param pkts
- *   The mbufs pointer array to be filled in (up to 8 packets)
+ *   The mbufs pointer array to be filled in (up to 8 packets, or the
+ *   burst size given at distributor creation time)
  * @param oldpkt
  *   The previous packet, if any, being processed by the worker
  * @param retcount
@@ -171,6 +254,9 @@ rte_distributor_get_pkt(struct rte_distributor *d,
  * API called by a worker to return a completed packet without requesting a
  * new packet, for example, because a worker thread is shutting down
  *
+ * In flow table mode, see RTE_DIST_FLAG_FLOW_TABLE, the flows of the worker
+ * are moved to the other workers until it requests packets again.
+ *
  * @param d
  *   The distributor instance to be used
  * @param worker_id
@@ -224,7 +310,8 @@ rte_distributor_request_pkt(struct rte_distributor *d,
  *   The worker instance number to use - must be less that num_workers passed
  *   at distributor creation time.
  * @param mbufs
- *   The array of mbufs being given to the worker
+ *   The array of mbufs being given to the worker (up to 8 packets, or the
+ *   burst size given at distributor creation time)
  *
  * @return
  *   The number of packets being given to the worker thread, zero if no
@@ -16,22 +16,20 @@ find_match_vec(struct rte_distributor *d,
 {
 	/* Setup */
 	__m128i incoming_fids;
-	__m128i inflight_fids;
-	__m128i preflight_fids;
+	__m128i worker_fids;
 	__m128i wkr;
-	__m128i mask1;
-	__m128i mask2;
+	__m128i mask;
 	__m128i output;
-	struct rte_distributor_backlog *bl;
-	uint16_t i;
+	uint16_t *tags;
+	uint16_t i, j;
 
 	/*
 	 * Function overview:
 	 * 2. Loop through all worker ID's
-	 *  2a. Load the current inflights for that worker into an xmm reg
-	 *  2b. Load the current backlog for that worker into an xmm reg
-	 *  2c. use cmpestrm to intersect flow_ids with backlog and inflights
-	 *  2d. Add any matches to the output
+	 *  2a. Load the current inflights and backlog for that worker into
+	 *      xmm regs, 8 at a time
+	 *  2b. use cmpestrm to intersect flow_ids with backlog and inflights
+	 *  2c. Add any matches to the output
 	 * 3. Write the output xmm (matching worker ids).
 	 */
 
@@ -40,32 +38,28 @@ find_match_vec(struct rte_distributor *d,
 	incoming_fids = _mm_load_si128((__m128i *)data_ptr);
 
 	for (i = 0; i < d->num_workers; i++) {
-		bl = &d->backlog[i];
+		tags = dist_tags(d, i);
+		mask = _mm_set1_epi16(0);
 
-		inflight_fids =
-			_mm_load_si128((__m128i *)&(d->in_flight_tags[i]));
-		preflight_fids =
-			_mm_load_si128((__m128i *)(bl->tags));
+		for (j = 0; j < d->burst_size * 2; j += 8) {
+			worker_fids = _mm_load_si128((__m128i *)&tags[j]);
 
-		/*
-		 * Any incoming_fid that exists anywhere in inflight_fids will
-		 * have 0xffff in same position of the mask as the incoming fid
-		 * Example (shortened to bytes for brevity):
-		 * incoming_fids   0x01 0x02 0x03 0x04 0x05 0x06 0x07 0x08
-		 * inflight_fids   0x03 0x05 0x07 0x00 0x00 0x00 0x00 0x00
-		 * mask            0x00 0x00 0xff 0x00 0xff 0x00 0xff 0x00
-		 */
-
-		mask1 = _mm_cmpestrm(inflight_fids, 8, incoming_fids, 8,
-			_SIDD_UWORD_OPS |
-			_SIDD_CMP_EQUAL_ANY |
-			_SIDD_UNIT_MASK);
-		mask2 = _mm_cmpestrm(preflight_fids, 8, incoming_fids, 8,
-			_SIDD_UWORD_OPS |
-			_SIDD_CMP_EQUAL_ANY |
-			_SIDD_UNIT_MASK);
+			/*
+			 * Any incoming_fid that exists anywhere in worker_fids
+			 * will have 0xffff in same position of the mask as the
+			 * incoming fid
+			 * Example (shortened to bytes for brevity):
+			 * incoming_fids   0x01 0x02 0x03 0x04 0x05 0x06 0x07 0x08
+			 * worker_fids     0x03 0x05 0x07 0x00 0x00 0x00 0x00 0x00
+			 * mask            0x00 0x00 0xff 0x00 0xff 0x00 0xff 0x00
+			 */
+			mask = _mm_or_si128(mask, _mm_cmpestrm(worker_fids, 8,
+					incoming_fids, 8,
+					_SIDD_UWORD_OPS |
+					_SIDD_CMP_EQUAL_ANY |
+					_SIDD_UNIT_MASK));
+		}
 
-		mask1 = _mm_or_si128(mask1, mask2);
 		/*
 		 * Now mask contains 0xffff where there's a match.
 		 * Next we need to store the worker_id in the relevant position
@@ -73,8 +67,8 @@ find_match_vec(struct rte_distributor *d,
 		 */
 
 		wkr = _mm_set1_epi16(i+1);
-		mask1 = _mm_and_si128(mask1, wkr);
-		output = _mm_or_si128(mask1, output);
+		mask = _mm_and_si128(mask, wkr);
+		output = _mm_or_si128(mask, output);
 	}
 
 	/*
@@ -4,15 +4,22 @@
 
 #include <unistd.h>
 #include <limits.h>
+#include <ctype.h>
 #include <string.h>
+#include <stdlib.h>
+#include <errno.h>
 
 #include <rte_common.h>
+#include <rte_cycles.h>
 #include <rte_debug.h>
 #include <rte_eal.h>
 #include <rte_errno.h>
 #include <rte_lcore.h>
 #include <rte_log.h>
 #include <rte_rwlock.h>
+#ifndef RTE_EXEC_ENV_WINDOWS
+#include <rte_telemetry.h>
+#endif
 
 #include "eal_memcfg.h"
 #include "eal_private.h"
@@ -460,3 +467,114 @@ rte_lcore_dump(FILE *f)
 {
 	rte_lcore_iterate(lcore_dump_cb, f);
 }
+
+/* busy/idle accounting of an lcore, only updated by the lcore itself */
+struct lcore_busy {
+	uint64_t last_tsc;      /* time of the previous poll report */
+	unsigned int last_work; /* work found by the previous poll */
+	struct rte_lcore_busy_stats stats;
+} __rte_cache_aligned;
+
+static struct lcore_busy lcore_busy[RTE_MAX_LCORE];
+
+void
+rte_lcore_busy_report(unsigned int work)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	struct lcore_busy *lb;
+	uint64_t now, *cycles, *polls;
+
+	if (unlikely(lcore_id >= RTE_MAX_LCORE))
+		return;
+
+	lb = &lcore_busy[lcore_id];
+	now = rte_rdtsc();
+
+	/* the time since the previous poll was spent on its result */
+	if (lb->last_work != 0) {
+		cycles = &lb->stats.busy_cycles;
+		polls = &lb->stats.busy_polls;
+	} else {
+		cycles = &lb->stats.idle_cycles;
+		polls = &lb->stats.idle_polls;
+	}
+	if (likely(lb->last_tsc != 0)) {
+		/* single writer, stores are atomic for the readers only */
+		__atomic_store_n(cycles, *cycles + now - lb->last_tsc,
+			__ATOMIC_RELAXED);
+		__atomic_store_n(polls, *polls + 1, __ATOMIC_RELAXED);
+	}
+
+	lb->last_tsc = now;
+	lb->last_work = work;
+}
+
+int
+rte_lcore_busy_stats_get(unsigned int lcore_id,
+		struct rte_lcore_busy_stats *stats)
+{
+	const struct rte_lcore_busy_stats *s;
+
+	if (lcore_id >= RTE_MAX_LCORE || stats == NULL)
+		return -EINVAL;
+
+	s = &lcore_busy[lcore_id].stats;
+	stats->busy_cycles = __atomic_load_n(&s->busy_cycles, __ATOMIC_RELAXED);
+	stats->idle_cycles = __atomic_load_n(&s->idle_cycles, __ATOMIC_RELAXED);
+	stats->busy_polls = __atomic_load_n(&s->busy_polls, __ATOMIC_RELAXED);
+	stats->idle_polls = __atomic_load_n(&s->idle_polls, __ATOMIC_RELAXED);
+	return 0;
+}
+
+#ifndef RTE_EXEC_ENV_WINDOWS
+static int
+lcore_list_cb(unsigned int lcore_id, void *arg)
+{
+	rte_tel_data_add_array_int(arg, lcore_id);
+	return 0;
+}
+
+static int
+handle_lcore_list(const char *cmd __rte_unused,
+		const char *params __rte_unused,
+		struct rte_tel_data *d)
+{
+	rte_tel_data_start_array(d, RTE_TEL_INT_VAL);
+	return rte_lcore_iterate(lcore_list_cb, d);
+}
+
+static int
+handle_lcore_busy(const char *cmd __rte_unused, const char *params,
+		struct rte_tel_data *d)
+{
+	struct rte_lcore_busy_stats stats;
+	unsigned long lcore_id;
+	char *end;
+
+	if (params == NULL || strlen(params) == 0 || !isdigit(*params))
+		return -1;
+
+	lcore_id = strtoul(params, &end, 10);
+	if (*end != '\0' || lcore_id >= RTE_MAX_LCORE ||
+			rte_eal_lcore_role(lcore_id) == ROLE_OFF)
+		return -1;
+
+	rte_lcore_busy_stats_get(lcore_id, &stats);
+
+	rte_tel_data_start_dict(d);
+	rte_tel_data_add_dict_u64(d, "busy_cycles", stats.busy_cycles);
+	rte_tel_data_add_dict_u64(d, "idle_cycles", stats.idle_cycles);
+	rte_tel_data_add_dict_u64(d, "busy_polls", stats.busy_polls);
+	rte_tel_data_add_dict_u64(d, "idle_polls", stats.idle_polls);
+	rte_tel_data_add_dict_u64(d, "tsc_hz", rte_get_tsc_hz());
+	return 0;
+}
+
+RTE_INIT(lcore_init_telemetry)
+{
+	rte_telemetry_register_cmd("/eal/lcore/list", handle_lcore_list,
+			"Returns list of available lcores. Takes no parameters");
+	rte_telemetry_register_cmd("/eal/lcore/busy", handle_lcore_busy,
+			"Returns busy/idle cycles of an lcore. Parameters: int lcore_id");
+}
+#endif
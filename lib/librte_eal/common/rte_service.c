@@ -364,15 +364,20 @@ service_runner_do_callback(struct rte_service_spec_impl *s,
 {
 	void *userdata = s->spec.callback_userdata;
 
+	int32_t ret;
+
 	if (service_stats_enabled(s)) {
 		uint64_t start = rte_rdtsc();
-		s->spec.callback(userdata);
+		ret = s->spec.callback(userdata);
 		uint64_t end = rte_rdtsc();
 		s->cycles_spent += end - start;
 		cs->calls_per_service[service_idx]++;
 		s->calls++;
 	} else
-		s->spec.callback(userdata);
+		ret = s->spec.callback(userdata);
+
+	/* services return -EAGAIN when they had nothing to do */
+	RTE_LCORE_BUSY_REPORT(ret != -EAGAIN);
 }
 
 
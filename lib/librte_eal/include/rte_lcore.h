@@ -342,6 +342,71 @@ __rte_experimental
 void
 rte_lcore_dump(FILE *f);
 
+/**
+ * Busy/idle cycle counters of an lcore.
+ *
+ * The time between two polls reported by an lcore is accounted as busy
+ * when the first of them found work to do, and as idle otherwise.
+ */
+struct rte_lcore_busy_stats {
+	uint64_t busy_cycles; /**< TSC cycles spent after polls with work. */
+	uint64_t idle_cycles; /**< TSC cycles spent after empty polls. */
+	uint64_t busy_polls;  /**< Number of polls which found work. */
+	uint64_t idle_polls;  /**< Number of empty polls. */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Report the result of a poll done by the calling lcore, for its busy/idle
+ * accounting. This is called from rte_eth_rx_burst() and for each service
+ * run when RTE_LCORE_BUSY_STATS is enabled in the build configuration.
+ * Applications polling other sources, e.g. rings, can call it from their
+ * own loops. Calls from threads without an lcore id are ignored.
+ *
+ * @param work
+ *   Amount of work found by the poll, e.g. number of packets received,
+ *   0 for an empty poll.
+ */
+__rte_experimental
+void
+rte_lcore_busy_report(unsigned int work);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Get the busy/idle counters of an lcore.
+ *
+ * The counters are never reset, the utilization over a time period
+ * is obtained from the difference of two samples.
+ *
+ * @param lcore_id
+ *   The lcore identifier.
+ * @param stats
+ *   The structure filled with the counters.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid lcore id or NULL stats.
+ */
+__rte_experimental
+int
+rte_lcore_busy_stats_get(unsigned int lcore_id,
+		struct rte_lcore_busy_stats *stats);
+
+/**
+ * @internal
+ *
+ * Report a poll result from the fast path functions of the libraries,
+ * only when the busy/idle accounting is enabled at build time.
+ */
+#if defined(RTE_LCORE_BUSY_STATS) && defined(ALLOW_EXPERIMENTAL_API)
+#define RTE_LCORE_BUSY_REPORT(work) rte_lcore_busy_report(work)
+#else
+#define RTE_LCORE_BUSY_REPORT(work) ((void)(work))
+#endif
+
 /**
  * Set core affinity of the current thread.
  * Support both EAL and non-EAL thread and update TLS.
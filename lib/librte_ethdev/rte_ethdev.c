@@ -556,6 +556,16 @@ rte_eth_dev_release_port(struct rte_eth_dev *eth_dev)
 
 	eth_dev->state = RTE_ETH_DEV_UNUSED;
 
+	/*
+	 * The port may be reused by another driver, which may not set the
+	 * fast path functions it doesn't support.
+	 */
+	eth_dev->rx_pkt_burst = NULL;
+	eth_dev->tx_pkt_burst = NULL;
+	eth_dev->tx_pkt_prepare = NULL;
+	eth_dev->recycle_tx_mbufs_reuse = NULL;
+	eth_dev->recycle_rx_descriptors_refill = NULL;
+
 	if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
 		rte_free(eth_dev->data->rx_queues);
 		rte_free(eth_dev->data->tx_queues);
@@ -4716,6 +4726,49 @@ rte_eth_tx_queue_info_get(uint16_t port_id, uint16_t queue_id,
 	return 0;
 }
 
+int
+rte_eth_recycle_rx_queue_info_get(uint16_t port_id, uint16_t queue_id,
+	struct rte_eth_recycle_rxq_info *recycle_rxq_info)
+{
+	struct rte_eth_dev *dev;
+
+	RTE_ETH_VALID_PORTID_OR_ERR_RET(port_id, -ENODEV);
+
+	if (recycle_rxq_info == NULL)
+		return -EINVAL;
+
+	dev = &rte_eth_devices[port_id];
+	if (queue_id >= dev->data->nb_rx_queues) {
+		RTE_ETHDEV_LOG(ERR, "Invalid RX queue_id=%u\n", queue_id);
+		return -EINVAL;
+	}
+
+	if (dev->data->rx_queues == NULL ||
+			dev->data->rx_queues[queue_id] == NULL) {
+		RTE_ETHDEV_LOG(ERR,
+			"Rx queue %"PRIu16" of device with port_id=%"
+			PRIu16" has not been setup\n", queue_id, port_id);
+		return -EINVAL;
+	}
+
+	if (rte_eth_dev_is_rx_hairpin_queue(dev, queue_id)) {
+		RTE_ETHDEV_LOG(INFO,
+			"Can't get hairpin Rx queue %"PRIu16" info of device with port_id=%"PRIu16"\n",
+			queue_id, port_id);
+		return -EINVAL;
+	}
+
+	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->recycle_rxq_info_get, -ENOTSUP);
+	/* The Rx burst function in use must be able to refill from recycled
+	 * mbufs.
+	 */
+	RTE_FUNC_PTR_OR_ERR_RET(*dev->recycle_rx_descriptors_refill, -ENOTSUP);
+
+	memset(recycle_rxq_info, 0, sizeof(*recycle_rxq_info));
+	dev->dev_ops->recycle_rxq_info_get(dev, queue_id, recycle_rxq_info);
+	return 0;
+}
+
 int
 rte_eth_rx_burst_mode_get(uint16_t port_id, uint16_t queue_id,
 			  struct rte_eth_burst_mode *mode)
@@ -312,6 +312,11 @@ typedef void (*eth_txq_info_get_t)(struct rte_eth_dev *dev,
 typedef int (*eth_burst_mode_get_t)(struct rte_eth_dev *dev,
 	uint16_t queue_id, struct rte_eth_burst_mode *mode);
 
+typedef void (*eth_recycle_rxq_info_get_t)(struct rte_eth_dev *dev,
+	uint16_t rx_queue_id,
+	struct rte_eth_recycle_rxq_info *recycle_rxq_info);
+/**< @internal Get Rx queue information for recycling mbufs. */
+
 typedef int (*mtu_set_t)(struct rte_eth_dev *dev, uint16_t mtu);
 /**< @internal Set MTU. */
 
@@ -352,6 +357,14 @@ typedef uint16_t (*eth_tx_prep_t)(void *txq,
 				   uint16_t nb_pkts);
 /**< @internal Prepare output packets on a transmit queue of an Ethernet device. */
 
+typedef uint16_t (*eth_recycle_tx_mbufs_reuse_t)(void *txq,
+	struct rte_eth_recycle_rxq_info *recycle_rxq_info);
+/**< @internal Move used mbufs of a transmit queue into a receive mbuf ring. */
+
+typedef void (*eth_recycle_rx_descriptors_refill_t)(void *rxq,
+	uint16_t nb);
+/**< @internal Refill receive descriptors with the recycled mbufs. */
+
 typedef int (*flow_ctrl_get_t)(struct rte_eth_dev *dev,
 			       struct rte_eth_fc_conf *fc_conf);
 /**< @internal Get current flow control parameter on an Ethernet device */
@@ -642,6 +655,8 @@ struct eth_dev_ops {
 	eth_txq_info_get_t         txq_info_get; /**< retrieve TX queue information. */
 	eth_burst_mode_get_t       rx_burst_mode_get; /**< Get RX burst mode */
 	eth_burst_mode_get_t       tx_burst_mode_get; /**< Get TX burst mode */
+	eth_recycle_rxq_info_get_t recycle_rxq_info_get;
+	/**< Get Rx queue information for recycling mbufs. */
 	eth_fw_version_get_t       fw_version_get; /**< Get firmware version. */
 	eth_dev_supported_ptypes_get_t dev_supported_ptypes_get;
 	/**< Get packet types supported and identified by device. */
@@ -806,9 +821,13 @@ struct rte_eth_dev {
 	struct rte_eth_rxtx_callback *pre_tx_burst_cbs[RTE_MAX_QUEUES_PER_PORT];
 	enum rte_eth_dev_state state; /**< Flag indicating the port state */
 	void *security_ctx; /**< Context for security ops */
+	eth_recycle_tx_mbufs_reuse_t recycle_tx_mbufs_reuse;
+	/**< Pointer to PMD Tx mbufs reuse function. */
+	eth_recycle_rx_descriptors_refill_t recycle_rx_descriptors_refill;
+	/**< Pointer to PMD Rx descriptors refill function. */
 
 	uint64_t reserved_64s[4]; /**< Reserved for future fields */
-	void *reserved_ptrs[4];   /**< Reserved for future fields */
+	void *reserved_ptrs[2];   /**< Reserved for future fields */
 } __rte_cache_aligned;
 
 struct rte_eth_dev_sriov;
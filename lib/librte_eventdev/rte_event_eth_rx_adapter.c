@@ -5,6 +5,7 @@
 #if defined(LINUX)
 #include <sys/epoll.h>
 #endif
+#include <sys/queue.h>
 #include <unistd.h>
 
 #include <rte_cycles.h>
@@ -15,7 +16,9 @@
 #include <rte_log.h>
 #include <rte_malloc.h>
 #include <rte_service_component.h>
+#include <rte_tailq.h>
 #include <rte_thash.h>
+#include <rte_time.h>
 #include <rte_interrupts.h>
 
 #include "rte_eventdev.h"
@@ -31,6 +34,11 @@
 #define ETH_RX_ADAPTER_MEM_NAME_LEN	32
 
 #define RSS_KEY_SIZE	40
+/* Limits of the event vectors built by the service function */
+#define RXA_VECTOR_SZ_MIN	4
+#define RXA_VECTOR_SZ_MAX	1024
+#define RXA_VECTOR_NS_MIN	10000
+#define RXA_VECTOR_NS_MAX	1000000000
 /* value written to intr thread pipe to signal thread exit */
 #define ETH_BRIDGE_INTR_THREAD_EXIT	1
 /* Sentinel value to detect initialized file handle */
@@ -59,6 +67,31 @@ struct eth_rx_poll_entry {
 	uint16_t eth_rx_qid;
 };
 
+/*
+ * Event vector being filled from a polled Rx queue, linked in the adapter's
+ * list of vectors waiting for their timeout while not empty
+ */
+struct eth_rx_vector_data {
+	TAILQ_ENTRY(eth_rx_vector_data) next;
+	/* Eth port and Rx queue of the vector elements */
+	uint16_t port;
+	uint16_t queue;
+	/* Vector size */
+	uint16_t max_vector_count;
+	/* Event word of the vector events */
+	uint64_t event;
+	/* Timestamp of the vector allocation */
+	uint64_t ts;
+	/* Timeout of a vector in TSC cycles */
+	uint64_t vector_timeout_ticks;
+	/* Mempool the vectors come from */
+	struct rte_mempool *vector_pool;
+	/* Vector being filled, NULL if none */
+	struct rte_event_vector *vector_ev;
+};
+
+TAILQ_HEAD(eth_rx_vector_data_list, eth_rx_vector_data);
+
 /* Instance per adapter */
 struct rte_eth_event_enqueue_buffer {
 	/* Count of events in this buffer */
@@ -92,6 +125,14 @@ struct rte_event_eth_rx_adapter {
 	uint32_t wrr_pos;
 	/* Event burst buffer */
 	struct rte_eth_event_enqueue_buffer event_enqueue_buffer;
+	/* Vectors being filled, in allocation order */
+	struct eth_rx_vector_data_list vector_list;
+	/* Smallest vector timeout of the Rx queues, in TSC cycles */
+	uint64_t vector_tmo_ticks;
+	/* Last time the vector timeouts were checked */
+	uint64_t prev_expiry_ts;
+	/* Set if event vectors are enabled on any Rx queue */
+	uint8_t ena_vector;
 	/* Per adapter stats */
 	struct rte_event_eth_rx_adapter_stats stats;
 	/* Block count, counts up to BLOCK_CNT_THRESHOLD */
@@ -201,6 +242,8 @@ struct eth_rx_queue_info {
 	uint16_t wt;		/* Polling weight */
 	uint32_t flow_id_mask;	/* Set to ~0 if app provides flow id else 0 */
 	uint64_t event;
+	int ena_vector;		/* True if mbufs are aggregated into vectors */
+	struct eth_rx_vector_data vector_data;
 };
 
 static struct rte_event_eth_rx_adapter **event_eth_rx_adapter;
@@ -742,6 +785,124 @@ rxa_flush_event_buffer(struct rte_event_eth_rx_adapter *rx_adapter)
 	return n;
 }
 
+static inline int
+rxa_init_vector(struct rte_event_eth_rx_adapter *rx_adapter,
+		struct eth_rx_vector_data *vec)
+{
+	struct rte_event_vector *vector_ev;
+
+	if (rte_mempool_get(vec->vector_pool, (void **)&vector_ev) < 0)
+		return -ENOMEM;
+
+	vector_ev->nb_elem = 0;
+	vector_ev->rsvd = 0;
+	vector_ev->attr_valid = 1;
+	vector_ev->port = vec->port;
+	vector_ev->queue = vec->queue;
+	vec->vector_ev = vector_ev;
+	vec->ts = rte_get_tsc_cycles();
+	TAILQ_INSERT_TAIL(&rx_adapter->vector_list, vec, next);
+	return 0;
+}
+
+/* Move the vector being filled to the event buffer */
+static inline void
+rxa_enq_vector(struct rte_event_eth_rx_adapter *rx_adapter,
+	       struct eth_rx_vector_data *vec, struct rte_event *ev)
+{
+	ev->event = vec->event;
+	ev->vec = vec->vector_ev;
+	vec->vector_ev = NULL;
+	TAILQ_REMOVE(&rx_adapter->vector_list, vec, next);
+}
+
+/* Drop the vector being filled along with its mbufs */
+static void
+rxa_free_vector(struct rte_event_eth_rx_adapter *rx_adapter,
+		struct eth_rx_vector_data *vec)
+{
+	struct rte_event_vector *vector_ev = vec->vector_ev;
+
+	if (vector_ev == NULL)
+		return;
+
+	rx_adapter->stats.rx_dropped += vector_ev->nb_elem;
+	rte_pktmbuf_free_bulk(vector_ev->mbufs, vector_ev->nb_elem);
+	rte_mempool_put(vec->vector_pool, vector_ev);
+	vec->vector_ev = NULL;
+	TAILQ_REMOVE(&rx_adapter->vector_list, vec, next);
+}
+
+/*
+ * Add mbufs to the vector of the Rx queue, returns the number of full
+ * vectors added to the event buffer
+ */
+static inline uint16_t
+rxa_create_event_vector(struct rte_event_eth_rx_adapter *rx_adapter,
+			struct eth_rx_queue_info *queue_info,
+			struct rte_eth_event_enqueue_buffer *buf,
+			struct rte_mbuf **mbufs, uint16_t num)
+{
+	struct eth_rx_vector_data *vec = &queue_info->vector_data;
+	struct rte_event *ev = &buf->events[buf->count];
+	struct rte_event_vector *vector_ev;
+	uint16_t filled = 0;
+	uint16_t n;
+
+	while (num) {
+		if (vec->vector_ev == NULL &&
+		    rxa_init_vector(rx_adapter, vec) < 0) {
+			rx_adapter->stats.rx_dropped += num;
+			rte_pktmbuf_free_bulk(mbufs, num);
+			break;
+		}
+
+		vector_ev = vec->vector_ev;
+		n = RTE_MIN(num, (uint16_t)(vec->max_vector_count -
+					    vector_ev->nb_elem));
+		memcpy(&vector_ev->mbufs[vector_ev->nb_elem], mbufs,
+		       n * sizeof(*mbufs));
+		vector_ev->nb_elem += n;
+		mbufs += n;
+		num -= n;
+
+		if (vector_ev->nb_elem == vec->max_vector_count) {
+			rxa_enq_vector(rx_adapter, vec, ev++);
+			filled++;
+		}
+	}
+
+	return filled;
+}
+
+/* Enqueue the vectors whose timeout has expired, even if not full */
+static void
+rxa_vector_expire(struct rte_event_eth_rx_adapter *rx_adapter)
+{
+	struct rte_eth_event_enqueue_buffer *buf =
+					&rx_adapter->event_enqueue_buffer;
+	struct eth_rx_vector_data *vec, *tvec;
+	uint64_t now = rte_get_tsc_cycles();
+
+	if (now - rx_adapter->prev_expiry_ts < rx_adapter->vector_tmo_ticks)
+		return;
+	rx_adapter->prev_expiry_ts = now;
+
+	TAILQ_FOREACH_SAFE(vec, &rx_adapter->vector_list, next, tvec) {
+		if (now - vec->ts < vec->vector_timeout_ticks)
+			continue;
+		if (buf->count == ETH_EVENT_BUFFER_SIZE) {
+			rxa_flush_event_buffer(rx_adapter);
+			if (buf->count == ETH_EVENT_BUFFER_SIZE)
+				break;
+		}
+		rxa_enq_vector(rx_adapter, vec, &buf->events[buf->count++]);
+	}
+
+	if (buf->count > 0)
+		rxa_flush_event_buffer(rx_adapter);
+}
+
 static inline void
 rxa_buffer_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
 		uint16_t eth_dev_id,
@@ -757,6 +918,7 @@ rxa_buffer_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
 	struct rte_eth_event_enqueue_buffer *buf =
 					&rx_adapter->event_enqueue_buffer;
 	struct rte_event *ev = &buf->events[buf->count];
+	struct rte_event *new_ev = ev;
 	uint64_t event = eth_rx_queue_info->event;
 	uint32_t flow_id_mask = eth_rx_queue_info->flow_id_mask;
 	struct rte_mbuf *m = mbufs[0];
@@ -781,25 +943,31 @@ rxa_buffer_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
 		}
 	}
 
-	for (i = 0; i < num; i++) {
-		m = mbufs[i];
+	if (eth_rx_queue_info->ena_vector) {
+		num = rxa_create_event_vector(rx_adapter, eth_rx_queue_info,
+					      buf, mbufs, num);
+	} else {
+		for (i = 0; i < num; i++) {
+			m = mbufs[i];
 
-		rss = do_rss ?
-			rxa_do_softrss(m, rx_adapter->rss_key_be) :
-			m->hash.rss;
-		ev->event = event;
-		ev->flow_id = (rss & ~flow_id_mask) |
-				(ev->flow_id & flow_id_mask);
-		ev->mbuf = m;
-		ev++;
+			rss = do_rss ?
+				rxa_do_softrss(m, rx_adapter->rss_key_be) :
+				m->hash.rss;
+			ev->event = event;
+			ev->flow_id = (rss & ~flow_id_mask) |
+					(ev->flow_id & flow_id_mask);
+			ev->mbuf = m;
+			ev++;
+		}
 	}
 
-	if (dev_info->cb_fn) {
+	if (num && dev_info->cb_fn) {
 
 		dropped = 0;
 		nb_cb = dev_info->cb_fn(eth_dev_id, rx_queue_id,
-					ETH_EVENT_BUFFER_SIZE, buf->count, ev,
-					num, dev_info->cb_arg, &dropped);
+					ETH_EVENT_BUFFER_SIZE, buf->count,
+					new_ev, num, dev_info->cb_arg,
+					&dropped);
 		if (unlikely(nb_cb > num))
 			RTE_EDEV_LOG_ERR("Rx CB returned %d (> %d) events",
 				nb_cb, num);
@@ -1149,6 +1317,8 @@ rxa_service_func(void *args)
 	}
 
 	stats = &rx_adapter->stats;
+	if (rx_adapter->ena_vector)
+		rxa_vector_expire(rx_adapter);
 	stats->rx_packets += rxa_intr_ring_dequeue(rx_adapter);
 	stats->rx_packets += rxa_poll(rx_adapter);
 	rte_spinlock_unlock(&rx_adapter->rx_lock);
@@ -1677,6 +1847,8 @@ rxa_sw_del(struct rte_event_eth_rx_adapter *rx_adapter,
 	pollq = rxa_polled_queue(dev_info, rx_queue_id);
 	intrq = rxa_intr_queue(dev_info, rx_queue_id);
 	sintrq = rxa_shared_intr(dev_info, rx_queue_id);
+	rxa_free_vector(rx_adapter,
+			&dev_info->rx_queue[rx_queue_id].vector_data);
 	rxa_update_queue(rx_adapter, dev_info, rx_queue_id, 0);
 	rx_adapter->num_rx_polled -= pollq;
 	dev_info->nb_rx_poll -= pollq;
@@ -1685,6 +1857,40 @@ rxa_sw_del(struct rte_event_eth_rx_adapter *rx_adapter,
 	dev_info->nb_shared_intr -= intrq && sintrq;
 }
 
+static void
+rxa_set_vector_data(struct rte_event_eth_rx_adapter *rx_adapter,
+		    struct eth_rx_queue_info *queue_info,
+		    uint16_t port_id, uint16_t rx_queue_id,
+		    const struct rte_event_eth_rx_adapter_queue_conf *conf)
+{
+	struct eth_rx_vector_data *vec = &queue_info->vector_data;
+	struct rte_event *vec_ev = (struct rte_event *)&vec->event;
+	uint64_t tmo_ticks;
+
+	vec->port = port_id;
+	vec->queue = rx_queue_id;
+	vec->max_vector_count = conf->vector_sz;
+	vec->vector_pool = conf->vector_mp;
+
+	/*
+	 * The elements of a vector come from a single Rx queue, unless the
+	 * application provides it, the flow id is derived from the queue.
+	 */
+	vec_ev->event = queue_info->event;
+	vec_ev->event_type = RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR;
+	if (!queue_info->flow_id_mask)
+		vec_ev->flow_id = (rx_queue_id & 0xFFF) |
+			((uint32_t)(port_id & 0xFF) << 12);
+
+	tmo_ticks = RTE_MAX(conf->vector_timeout_ns * rte_get_tsc_hz() /
+			    NSEC_PER_SEC, 1ULL);
+	vec->vector_timeout_ticks = tmo_ticks;
+	if (!rx_adapter->ena_vector ||
+	    tmo_ticks < rx_adapter->vector_tmo_ticks)
+		rx_adapter->vector_tmo_ticks = tmo_ticks;
+	rx_adapter->ena_vector = 1;
+}
+
 static void
 rxa_add_queue(struct rte_event_eth_rx_adapter *rx_adapter,
 	struct eth_device_info *dev_info,
@@ -1727,6 +1933,15 @@ rxa_add_queue(struct rte_event_eth_rx_adapter *rx_adapter,
 	} else
 		qi_ev->flow_id = 0;
 
+	/* a partly filled vector may not match the new configuration */
+	rxa_free_vector(rx_adapter, &queue_info->vector_data);
+	queue_info->ena_vector = !!(conf->rx_queue_flags &
+			RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR);
+	if (queue_info->ena_vector)
+		rxa_set_vector_data(rx_adapter, queue_info,
+				dev_info->dev->data->port_id, rx_queue_id,
+				conf);
+
 	rxa_update_queue(rx_adapter, dev_info, rx_queue_id, 1);
 	if (rxa_polled_queue(dev_info, rx_queue_id)) {
 		rx_adapter->num_rx_polled += !pollq;
@@ -1993,6 +2208,7 @@ rte_event_eth_rx_adapter_create_ext(uint8_t id, uint8_t dev_id,
 		return -ENOMEM;
 	}
 	rte_spinlock_init(&rx_adapter->rx_lock);
+	TAILQ_INIT(&rx_adapter->vector_list);
 	for (i = 0; i < RTE_MAX_ETHPORTS; i++)
 		rx_adapter->eth_devices[i].dev = &rte_eth_devices[i];
 
@@ -2054,6 +2270,43 @@ rte_event_eth_rx_adapter_free(uint8_t id)
 	return 0;
 }
 
+static void
+rxa_vector_limits(struct rte_event_eth_rx_adapter_vector_limits *limits)
+{
+	limits->min_sz = RXA_VECTOR_SZ_MIN;
+	limits->max_sz = RXA_VECTOR_SZ_MAX;
+	limits->log2_sz = 0;
+	limits->min_timeout_ns = RXA_VECTOR_NS_MIN;
+	limits->max_timeout_ns = RXA_VECTOR_NS_MAX;
+}
+
+static int
+rxa_check_vector_conf(uint32_t cap,
+		const struct rte_event_eth_rx_adapter_queue_conf *queue_conf)
+{
+	struct rte_event_eth_rx_adapter_vector_limits limits;
+	struct rte_event_vector_pool_private *priv;
+
+	/* vectors are built by the service function */
+	if (cap & RTE_EVENT_ETH_RX_ADAPTER_CAP_INTERNAL_PORT)
+		return -ENOTSUP;
+
+	rxa_vector_limits(&limits);
+	if (queue_conf->vector_mp == NULL ||
+	    queue_conf->vector_sz < limits.min_sz ||
+	    queue_conf->vector_sz > limits.max_sz ||
+	    queue_conf->vector_timeout_ns < limits.min_timeout_ns ||
+	    queue_conf->vector_timeout_ns > limits.max_timeout_ns)
+		return -EINVAL;
+
+	priv = rte_mempool_get_priv(queue_conf->vector_mp);
+	if (queue_conf->vector_mp->private_data_size < sizeof(*priv) ||
+	    queue_conf->vector_sz > priv->nb_elem)
+		return -EINVAL;
+
+	return 0;
+}
+
 int
 rte_event_eth_rx_adapter_queue_add(uint8_t id,
 		uint16_t eth_dev_id,
@@ -2092,6 +2345,17 @@ rte_event_eth_rx_adapter_queue_add(uint8_t id,
 		return -EINVAL;
 	}
 
+	if (queue_conf->rx_queue_flags &
+			RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR) {
+		ret = rxa_check_vector_conf(cap, queue_conf);
+		if (ret) {
+			RTE_EDEV_LOG_ERR("Invalid event vector configuration,"
+					" eth port: %" PRIu16 " adapter id: %"
+					PRIu8, eth_dev_id, id);
+			return ret;
+		}
+	}
+
 	if ((cap & RTE_EVENT_ETH_RX_ADAPTER_CAP_MULTI_EVENTQ) == 0 &&
 		(rx_queue_id != -1)) {
 		RTE_EDEV_LOG_ERR("Rx queues can only be connected to single "
@@ -2154,6 +2418,34 @@ rte_event_eth_rx_adapter_queue_add(uint8_t id,
 	return 0;
 }
 
+int
+rte_event_eth_rx_adapter_vector_limits_get(uint8_t dev_id,
+		uint16_t eth_port_id,
+		struct rte_event_eth_rx_adapter_vector_limits *limits)
+{
+	uint32_t cap;
+	int ret;
+
+	RTE_EVENTDEV_VALID_DEVID_OR_ERR_RET(dev_id, -EINVAL);
+	RTE_ETH_VALID_PORTID_OR_ERR_RET(eth_port_id, -EINVAL);
+
+	if (limits == NULL)
+		return -EINVAL;
+
+	ret = rte_event_eth_rx_adapter_caps_get(dev_id, eth_port_id, &cap);
+	if (ret) {
+		RTE_EDEV_LOG_ERR("Failed to get adapter caps edev %" PRIu8
+			"eth port %" PRIu16, dev_id, eth_port_id);
+		return ret;
+	}
+
+	if (cap & RTE_EVENT_ETH_RX_ADAPTER_CAP_INTERNAL_PORT)
+		return -ENOTSUP;
+
+	rxa_vector_limits(limits);
+	return 0;
+}
+
 int
 rte_event_eth_rx_adapter_queue_del(uint8_t id, uint16_t eth_dev_id,
 				int32_t rx_queue_id)
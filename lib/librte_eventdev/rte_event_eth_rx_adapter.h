@@ -37,6 +37,7 @@
  *  - rte_event_eth_rx_adapter_stop()
  *  - rte_event_eth_rx_adapter_stats_get()
  *  - rte_event_eth_rx_adapter_stats_reset()
+ *  - rte_event_eth_rx_adapter_vector_limits_get()
  *
  * The application creates an ethernet to event adapter using
  * rte_event_eth_rx_adapter_create_ext() or rte_event_eth_rx_adapter_create()
@@ -77,6 +78,11 @@
  * allows the application to register a callback that selects which packets are
  * enqueued to the event device by the SW adapter. The callback interface is
  * event based so the callback can also modify the event data if it needs to.
+ *
+ * The SW adapter can also aggregate the mbufs of an Rx queue into vector
+ * events, see RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR, so that the event
+ * device schedules a vector of packets at once instead of every packet. A
+ * vector is enqueued when it is full or when its timeout has expired.
  */
 
 #ifdef __cplusplus
@@ -96,6 +102,17 @@ extern "C" {
 /**< This flag indicates the flow identifier is valid
  * @see rte_event_eth_rx_adapter_queue_conf::rx_queue_flags
  */
+#define RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR	0x2
+/**< @warning
+ * @b EXPERIMENTAL: this flag may change without prior notice.
+ *
+ * This flag indicates that the mbufs of the Rx queue are aggregated into
+ * event vectors of type RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR, configured by
+ * the vector_sz, vector_timeout_ns and vector_mp fields of the queue
+ * configuration.
+ * It is only supported when the adapter uses a service function.
+ * @see rte_event_eth_rx_adapter_queue_conf::rx_queue_flags
+ */
 
 /**
  * Adapter configuration structure that the adapter configuration callback
@@ -171,6 +188,49 @@ struct rte_event_eth_rx_adapter_queue_conf {
 	 * The event adapter sets ev.event_type to RTE_EVENT_TYPE_ETHDEV in the
 	 * enqueued event.
 	 */
+	uint16_t vector_sz;
+	/**< @warning
+	 * @b EXPERIMENTAL: this field may change without prior notice.
+	 *
+	 * Maximum number of mbufs in an event vector, within the limits
+	 * given by rte_event_eth_rx_adapter_vector_limits_get() and at most
+	 * the vector size of *vector_mp*.
+	 * Only read if RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR is set.
+	 */
+	uint64_t vector_timeout_ns;
+	/**< @warning
+	 * @b EXPERIMENTAL: this field may change without prior notice.
+	 *
+	 * Maximum time in nanoseconds a vector waits for *vector_sz* mbufs
+	 * before it is enqueued with fewer.
+	 * Only read if RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR is set.
+	 */
+	struct rte_mempool *vector_mp;
+	/**< @warning
+	 * @b EXPERIMENTAL: this field may change without prior notice.
+	 *
+	 * Mempool of the event vectors, created with
+	 * rte_event_vector_pool_create().
+	 * Only read if RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR is set.
+	 */
+};
+
+/**
+ * A structure used to retrieve the limits of the event vectors an adapter
+ * can build.
+ * @see rte_event_eth_rx_adapter_vector_limits_get()
+ */
+struct rte_event_eth_rx_adapter_vector_limits {
+	uint16_t min_sz;
+	/**< Minimum vector size */
+	uint16_t max_sz;
+	/**< Maximum vector size */
+	uint8_t log2_sz;
+	/**< Set if the vector size must be a power of 2 */
+	uint64_t min_timeout_ns;
+	/**< Minimum vector timeout in nanoseconds */
+	uint64_t max_timeout_ns;
+	/**< Maximum vector timeout in nanoseconds */
 };
 
 /**
@@ -471,6 +531,32 @@ int rte_event_eth_rx_adapter_cb_register(uint8_t id, uint16_t eth_dev_id,
 					 rte_event_eth_rx_adapter_cb_fn cb_fn,
 					 void *cb_arg);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Retrieve the limits of the event vectors built for the Rx queues of an
+ * ethernet device.
+ * @see RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR
+ *
+ * @param dev_id
+ *  Event device identifier.
+ * @param eth_port_id
+ *  Port identifier of the Ethernet device.
+ * @param [out] limits
+ *  A pointer to the structure filled with the vector limits.
+ *
+ * @return
+ *  - 0: Success.
+ *  - -ENOTSUP: event vectors are not supported for this ethernet device,
+ *    i.e. its packets are transferred by the event device itself.
+ *  - <0: Error code on failure.
+ */
+__rte_experimental
+int rte_event_eth_rx_adapter_vector_limits_get(uint8_t dev_id,
+		uint16_t eth_port_id,
+		struct rte_event_eth_rx_adapter_vector_limits *limits);
+
 #ifdef __cplusplus
 }
 #endif
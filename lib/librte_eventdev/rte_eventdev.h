@@ -951,6 +951,21 @@ rte_event_dev_close(uint8_t dev_id);
  */
 #define RTE_EVENT_TYPE_ETH_RX_ADAPTER   0x4
 /**< The event generated from event eth Rx adapter */
+#define RTE_EVENT_TYPE_VECTOR           0x8
+/**< Indicates that the event carries a vector of objects, pointed to by
+ * *rte_event::vec*, rather than a single one. It is ORed with the type of the
+ * event source.
+ * @see struct rte_event_vector
+ */
+#define RTE_EVENT_TYPE_ETHDEV_VECTOR \
+	(RTE_EVENT_TYPE_VECTOR | RTE_EVENT_TYPE_ETHDEV)
+/**< The event vector generated from ethdev subsystem */
+#define RTE_EVENT_TYPE_CPU_VECTOR \
+	(RTE_EVENT_TYPE_VECTOR | RTE_EVENT_TYPE_CPU)
+/**< The event vector generated from cpu for pipelining. */
+#define RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR \
+	(RTE_EVENT_TYPE_VECTOR | RTE_EVENT_TYPE_ETH_RX_ADAPTER)
+/**< The event vector generated from event eth Rx adapter */
 #define RTE_EVENT_TYPE_MAX              0x10
 /**< Maximum number of event types */
 
@@ -1000,6 +1015,61 @@ rte_event_dev_close(uint8_t dev_id);
  *
  */
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this structure may change without prior notice.
+ *
+ * Vector of objects carried by a single event, so that the event device
+ * schedules them once rather than once per object. It is allocated from a
+ * mempool created by rte_event_vector_pool_create(), and whoever consumes the
+ * event is responsible for freeing the objects and returning the vector to
+ * its mempool.
+ *
+ * @see RTE_EVENT_TYPE_VECTOR
+ */
+RTE_STD_C11
+struct rte_event_vector {
+	uint16_t nb_elem;
+	/**< Number of elements in this vector. */
+	uint16_t rsvd:15;
+	/**< Reserved for future use */
+	uint16_t attr_valid:1;
+	/**< Set when *port* and *queue* below are valid, e.g. on vectors
+	 * built by the Rx adapter, whose elements all come from the same
+	 * ethdev Rx queue.
+	 */
+	uint16_t port;
+	/**< Ethernet device port identifier of the elements. */
+	uint16_t queue;
+	/**< Ethernet device queue identifier of the elements. */
+	uint64_t impl_opaque;
+	/**< Implementation specific opaque value, the application should not
+	 * modify this field.
+	 */
+	union {
+		struct rte_mbuf *mbufs[0];
+		void *ptrs[0];
+		uint64_t u64s[0];
+	} __rte_aligned(16);
+	/**< Start of the element array, mbufs for the vectors of an ethdev
+	 * event type, pointers or opaque values otherwise.
+	 */
+};
+
+/**
+ * Iterate over the mbufs of an event vector.
+ *
+ * @param vec
+ *   Pointer to the *rte_event_vector*.
+ * @param m
+ *   *struct rte_mbuf* pointer set to each element in turn.
+ * @param i
+ *   Index of *m* in the vector.
+ */
+#define RTE_EVENT_VECTOR_FOREACH_MBUF(vec, m, i) \
+	for ((i) = 0; (i) < (vec)->nb_elem && \
+			(((m) = (vec)->mbufs[(i)]), 1); (i)++)
+
 /**
  * The generic *rte_event* structure to hold the event attributes
  * for dequeue and enqueue operation
@@ -1073,6 +1143,10 @@ struct rte_event {
 		/**< Opaque event pointer */
 		struct rte_mbuf *mbuf;
 		/**< mbuf pointer if dequeued event is associated with mbuf */
+		struct rte_event_vector *vec;
+		/**< Event vector pointer if the event type has
+		 * RTE_EVENT_TYPE_VECTOR set.
+		 */
 	};
 };
 
@@ -1988,6 +2062,42 @@ rte_event_dev_xstats_reset(uint8_t dev_id,
  */
 int rte_event_dev_selftest(uint8_t dev_id);
 
+struct rte_mempool;
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Create a mempool of event vectors, each able to hold up to *nb_elem*
+ * objects.
+ *
+ * @param name
+ *   The name of the mempool.
+ * @param n
+ *   The number of vectors in the mempool.
+ * @param cache_size
+ *   Size of the per-lcore object cache, see rte_mempool_create().
+ * @param nb_elem
+ *   The maximum number of elements of a vector.
+ * @param socket_id
+ *   The socket identifier where the memory should be allocated, or
+ *   SOCKET_ID_ANY.
+ * @return
+ *   The pointer to the new mempool on success, NULL on error with rte_errno
+ *   set:
+ *   - EINVAL - *nb_elem* is 0.
+ *   - ENOSPC - the maximum number of memzones has already been allocated.
+ *   - EEXIST - a memzone with the same name already exists.
+ *   - ENOMEM - no appropriate memory area found.
+ *
+ * @see struct rte_event_vector
+ */
+__rte_experimental
+struct rte_mempool *
+rte_event_vector_pool_create(const char *name, unsigned int n,
+			     unsigned int cache_size, uint16_t nb_elem,
+			     int socket_id);
+
 #ifdef __cplusplus
 }
 #endif
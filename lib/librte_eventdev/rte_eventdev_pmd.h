@@ -77,6 +77,12 @@ extern "C" {
  * the ethdev to eventdev use a SW service function
  */
 
+/** @internal Private data of the mempools of event vectors */
+struct rte_event_vector_pool_private {
+	uint16_t nb_elem;
+	/**< Maximum number of elements of a vector */
+};
+
 #define RTE_EVENTDEV_DETACHED  (0)
 #define RTE_EVENTDEV_ATTACHED  (1)
 
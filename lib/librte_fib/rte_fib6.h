@@ -20,6 +20,7 @@
  */
 
 #include <rte_compat.h>
+#include <rte_rcu_qsbr.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,6 +30,9 @@ extern "C" {
 /** Maximum depth value possible for IPv6 FIB. */
 #define RTE_FIB6_MAXDEPTH       128
 
+/** @internal Default RCU defer queue entries to reclaim in one go. */
+#define RTE_FIB6_RCU_DQ_RECLAIM_MAX	16
+
 struct rte_fib6;
 struct rte_rib6;
 
@@ -59,6 +63,24 @@ enum rte_fib_trie_nh_sz {
 	RTE_FIB6_TRIE_8B
 };
 
+/** Type of lookup function implementation */
+enum rte_fib6_lookup_type {
+	RTE_FIB6_LOOKUP_DEFAULT,
+	/**< Selects the best implementation available on the CPU */
+	RTE_FIB6_LOOKUP_TRIE_SCALAR,
+	/**< Scalar lookup function implementation */
+	RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512
+	/**< Vector implementation using AVX512 */
+};
+
+/** RCU reclamation modes */
+enum rte_fib6_qsbr_mode {
+	/** Create defer queue for reclaim. */
+	RTE_FIB6_QSBR_MODE_DQ = 0,
+	/** Use blocking mode reclaim. No defer queue created. */
+	RTE_FIB6_QSBR_MODE_SYNC
+};
+
 /** FIB configuration structure */
 struct rte_fib6_conf {
 	enum rte_fib6_type type; /**< Type of FIB struct */
@@ -73,6 +95,22 @@ struct rte_fib6_conf {
 	};
 };
 
+/** FIB6 RCU QSBR configuration structure. */
+struct rte_fib6_rcu_config {
+	struct rte_rcu_qsbr *v;	/* RCU QSBR variable. */
+	/* Mode of RCU QSBR. RTE_FIB6_QSBR_MODE_xxx
+	 * '0' for default: create defer queue for reclaim.
+	 */
+	enum rte_fib6_qsbr_mode mode;
+	uint32_t dq_size;	/* RCU defer queue size.
+				 * default: number of tbl8s.
+				 */
+	uint32_t reclaim_thd;	/* Threshold to trigger auto reclaim. */
+	uint32_t reclaim_max;	/* Max entries to reclaim in one go.
+				 * default: RTE_FIB6_RCU_DQ_RECLAIM_MAX.
+				 */
+};
+
 /**
  * Create FIB
  *
@@ -201,6 +239,47 @@ __rte_experimental
 struct rte_rib6 *
 rte_fib6_get_rib(struct rte_fib6 *fib);
 
+/**
+ * Associate RCU QSBR variable with a FIB6 object.
+ *
+ * Once associated, tbl8 groups released by rte_fib6_delete() (or by an
+ * rte_fib6_add() that makes a tbl8 group redundant) are not reused until
+ * all the reader threads registered with the QSBR variable have reported
+ * a quiescent state.
+ *
+ * @param fib
+ *   FIB6 object handle
+ * @param cfg
+ *   RCU QSBR configuration
+ * @return
+ *   0 on success, negative value otherwise:
+ *   - -EINVAL - invalid pointer
+ *   - -EEXIST - already added QSBR
+ *   - -ENOMEM - memory allocation failure
+ *   - -ENOTSUP - not supported by the FIB6 type
+ */
+__rte_experimental
+int
+rte_fib6_rcu_qsbr_add(struct rte_fib6 *fib, struct rte_fib6_rcu_config *cfg);
+
+/**
+ * Set lookup function based on type
+ *
+ * @param fib
+ *   FIB object handle
+ * @param type
+ *   type of lookup function
+ *
+ * @return
+ *    -EINVAL on failure: the requested type is not supported by
+ *    the FIB type, the next hop size or the CPU
+ *    0 on success
+ */
+__rte_experimental
+int
+rte_fib6_set_lookup_fn(struct rte_fib6 *fib,
+	enum rte_fib6_lookup_type type);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,205 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <rte_vect.h>
+#include <rte_fib6.h>
+
+#include "trie.h"
+#include "trie_avx512.h"
+
+/*
+ * Build tbl24 indexes out of the first dword (or qword) of the
+ * addresses: the three most significant bytes of the address
+ * in the host byte order.
+ */
+static __rte_always_inline __m512i
+get_tbl24_idx_x16(__m512i first)
+{
+	const __m512i lsbyte_msk = _mm512_set1_epi32(UINT8_MAX);
+	const __m512i byte1_msk = _mm512_set1_epi32(UINT8_MAX << 8);
+	__m512i idxes;
+
+	idxes = _mm512_slli_epi32(_mm512_and_epi32(first, lsbyte_msk), 16);
+	idxes = _mm512_or_epi32(idxes, _mm512_and_epi32(first, byte1_msk));
+	return _mm512_or_epi32(idxes,
+		_mm512_and_epi32(_mm512_srli_epi32(first, 16), lsbyte_msk));
+}
+
+/*
+ * Resolve 16 IPv6 addresses with 2 or 4 byte next hops.
+ * Every iteration walks one more tbl8 level only for the addresses
+ * still pointing to an extended entry.
+ */
+static __rte_always_inline void
+trie_vec_lookup_x16(void *p, uint8_t ips[16][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, int size)
+{
+	struct rte_trie_tbl *dp = (struct rte_trie_tbl *)p;
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i lsb = _mm512_set1_epi32(1);
+	const __m512i lsbyte_msk = _mm512_set1_epi32(UINT8_MAX);
+	/* offsets of the 16 addresses from the first one */
+	const __m512i addr_ofs = _mm512_set_epi32(
+		15 * RTE_FIB6_IPV6_ADDR_SIZE, 14 * RTE_FIB6_IPV6_ADDR_SIZE,
+		13 * RTE_FIB6_IPV6_ADDR_SIZE, 12 * RTE_FIB6_IPV6_ADDR_SIZE,
+		11 * RTE_FIB6_IPV6_ADDR_SIZE, 10 * RTE_FIB6_IPV6_ADDR_SIZE,
+		9 * RTE_FIB6_IPV6_ADDR_SIZE, 8 * RTE_FIB6_IPV6_ADDR_SIZE,
+		7 * RTE_FIB6_IPV6_ADDR_SIZE, 6 * RTE_FIB6_IPV6_ADDR_SIZE,
+		5 * RTE_FIB6_IPV6_ADDR_SIZE, 4 * RTE_FIB6_IPV6_ADDR_SIZE,
+		3 * RTE_FIB6_IPV6_ADDR_SIZE, 2 * RTE_FIB6_IPV6_ADDR_SIZE,
+		RTE_FIB6_IPV6_ADDR_SIZE, 0);
+	const uint8_t *base = &ips[0][0];
+	__mmask16 msk_ext;
+	__m512i dwords, idxes, bytes, res, res_msk;
+	int i;
+
+	/* used to mask gathered values if size is 2 (16 bit next hops) */
+	if (size == sizeof(uint16_t))
+		res_msk = _mm512_set1_epi32(UINT16_MAX);
+	else
+		res_msk = _mm512_set1_epi32(UINT32_MAX);
+
+	/* first 4 bytes of every address */
+	dwords = _mm512_i32gather_epi32(addr_ofs, (const int *)base, 1);
+	idxes = get_tbl24_idx_x16(dwords);
+
+	/**
+	 * lookup in tbl24
+	 * Put it inside branch to make compiler happy with -O0
+	 */
+	if (size == sizeof(uint16_t))
+		res = _mm512_i32gather_epi32(idxes, (const int *)dp->tbl24, 2);
+	else
+		res = _mm512_i32gather_epi32(idxes, (const int *)dp->tbl24, 4);
+	res = _mm512_and_epi32(res, res_msk);
+
+	/* walk tbl8 levels starting from the 4th byte of the addresses */
+	msk_ext = _mm512_test_epi32_mask(res, lsb);
+	for (i = 3; msk_ext != 0 && i < RTE_FIB6_IPV6_ADDR_SIZE; i++) {
+		if ((i & 3) == 0)
+			dwords = _mm512_mask_i32gather_epi32(zero, msk_ext,
+				addr_ofs, (const int *)(base + i), 1);
+		bytes = _mm512_srlv_epi32(dwords,
+			_mm512_set1_epi32((i & 3) * CHAR_BIT));
+		bytes = _mm512_and_epi32(bytes, lsbyte_msk);
+
+		idxes = _mm512_srli_epi32(res, 1);
+		idxes = _mm512_slli_epi32(idxes, 8);
+		idxes = _mm512_add_epi32(idxes, bytes);
+		if (size == sizeof(uint16_t))
+			res = _mm512_mask_i32gather_epi32(res, msk_ext,
+				idxes, (const int *)dp->tbl8, 2);
+		else
+			res = _mm512_mask_i32gather_epi32(res, msk_ext,
+				idxes, (const int *)dp->tbl8, 4);
+		res = _mm512_and_epi32(res, res_msk);
+		msk_ext = _mm512_test_epi32_mask(res, lsb);
+	}
+
+	res = _mm512_srli_epi32(res, 1);
+
+	/* zero extend 32-bit next hops into 64-bit ones */
+	_mm512_storeu_si512(next_hops,
+		_mm512_cvtepu32_epi64(_mm512_castsi512_si256(res)));
+	_mm512_storeu_si512(next_hops + 8,
+		_mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(res, 1)));
+}
+
+/*
+ * Resolve 8 IPv6 addresses with 8 byte next hops.
+ */
+static __rte_always_inline void
+trie_vec_lookup_x8_8b(void *p, uint8_t ips[8][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops)
+{
+	struct rte_trie_tbl *dp = (struct rte_trie_tbl *)p;
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i lsb = _mm512_set1_epi64(1);
+	const __m512i lsbyte_msk = _mm512_set1_epi64(UINT8_MAX);
+	const __m512i byte1_msk = _mm512_set1_epi64(UINT8_MAX << 8);
+	/* offsets of the 8 addresses from the first one */
+	const __m256i addr_ofs = _mm256_set_epi32(
+		7 * RTE_FIB6_IPV6_ADDR_SIZE, 6 * RTE_FIB6_IPV6_ADDR_SIZE,
+		5 * RTE_FIB6_IPV6_ADDR_SIZE, 4 * RTE_FIB6_IPV6_ADDR_SIZE,
+		3 * RTE_FIB6_IPV6_ADDR_SIZE, 2 * RTE_FIB6_IPV6_ADDR_SIZE,
+		RTE_FIB6_IPV6_ADDR_SIZE, 0);
+	const uint8_t *base = &ips[0][0];
+	__mmask8 msk_ext;
+	__m512i qwords, idxes, bytes, res;
+	int i;
+
+	/* first 8 bytes of every address */
+	qwords = _mm512_i32gather_epi64(addr_ofs, (const void *)base, 1);
+
+	idxes = _mm512_slli_epi64(_mm512_and_epi64(qwords, lsbyte_msk), 16);
+	idxes = _mm512_or_epi64(idxes, _mm512_and_epi64(qwords, byte1_msk));
+	idxes = _mm512_or_epi64(idxes,
+		_mm512_and_epi64(_mm512_srli_epi64(qwords, 16), lsbyte_msk));
+
+	/* lookup in tbl24 */
+	res = _mm512_i64gather_epi64(idxes, (const void *)dp->tbl24, 8);
+
+	/* walk tbl8 levels starting from the 4th byte of the addresses */
+	msk_ext = _mm512_test_epi64_mask(res, lsb);
+	for (i = 3; msk_ext != 0 && i < RTE_FIB6_IPV6_ADDR_SIZE; i++) {
+		if ((i & 7) == 0)
+			qwords = _mm512_mask_i32gather_epi64(zero, msk_ext,
+				addr_ofs, (const void *)(base + i), 1);
+		bytes = _mm512_srlv_epi64(qwords,
+			_mm512_set1_epi64((i & 7) * CHAR_BIT));
+		bytes = _mm512_and_epi64(bytes, lsbyte_msk);
+
+		idxes = _mm512_srli_epi64(res, 1);
+		idxes = _mm512_slli_epi64(idxes, 8);
+		idxes = _mm512_add_epi64(idxes, bytes);
+		res = _mm512_mask_i64gather_epi64(res, msk_ext, idxes,
+			(const void *)dp->tbl8, 8);
+		msk_ext = _mm512_test_epi64_mask(res, lsb);
+	}
+
+	res = _mm512_srli_epi64(res, 1);
+	_mm512_storeu_si512(next_hops, res);
+}
+
+void
+rte_trie_vec_lookup_bulk_2b(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+
+	for (i = 0; i < (n / 16); i++)
+		trie_vec_lookup_x16(p, (uint8_t (*)[16])&ips[i * 16][0],
+			next_hops + i * 16, sizeof(uint16_t));
+
+	rte_trie_lookup_bulk_2b(p, (uint8_t (*)[16])&ips[i * 16][0],
+		next_hops + i * 16, n - i * 16);
+}
+
+void
+rte_trie_vec_lookup_bulk_4b(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+
+	for (i = 0; i < (n / 16); i++)
+		trie_vec_lookup_x16(p, (uint8_t (*)[16])&ips[i * 16][0],
+			next_hops + i * 16, sizeof(uint32_t));
+
+	rte_trie_lookup_bulk_4b(p, (uint8_t (*)[16])&ips[i * 16][0],
+		next_hops + i * 16, n - i * 16);
+}
+
+void
+rte_trie_vec_lookup_bulk_8b(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+
+	for (i = 0; i < (n / 8); i++)
+		trie_vec_lookup_x8_8b(p, (uint8_t (*)[16])&ips[i * 8][0],
+			next_hops + i * 8);
+
+	rte_trie_lookup_bulk_8b(p, (uint8_t (*)[16])&ips[i * 8][0],
+		next_hops + i * 8, n - i * 8);
+}
@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#ifndef _GRO_UDP6_H_
+#define _GRO_UDP6_H_
+
+#include "gro_udp4.h"
+
+#define GRO_UDP6_TBL_MAX_ITEM_NUM (1024UL * 1024UL)
+
+/*
+ * The max length of a IPv6 packet, which includes the length of the
+ * fixed L3 header, the extension headers and the data payload.
+ */
+#define MAX_IPV6_PKT_LENGTH (UINT16_MAX + sizeof(struct rte_ipv6_hdr))
+
+/* IPv6 fragment extension header */
+struct gro_ipv6_frag_hdr {
+	uint8_t next_header;
+	uint8_t reserved;
+	/* fragment offset in 8 bytes units and M flag */
+	rte_be16_t frag_data;
+	rte_be32_t id;
+} __rte_packed;
+
+#define GRO_IPV6_FRAG_MF_FLAG		0x0001
+#define GRO_IPV6_FRAG_OFFSET_MASK	0xfff8
+
+/* Header fields representing the fragments of a UDP/IPv6 datagram */
+struct udp6_flow_key {
+	struct rte_ether_addr eth_saddr;
+	struct rte_ether_addr eth_daddr;
+	uint8_t ip_src_addr[16];
+	uint8_t ip_dst_addr[16];
+
+	uint32_t frag_id;
+};
+
+struct gro_udp6_flow {
+	struct udp6_flow_key key;
+	/*
+	 * The index of the first packet in the flow.
+	 * INVALID_ARRAY_INDEX indicates an empty flow.
+	 */
+	uint32_t start_index;
+};
+
+/*
+ * UDP/IPv6 reassembly table structure. Items are the same as the ones
+ * of UDP/IPv4 tables.
+ */
+struct gro_udp6_tbl {
+	/* item array */
+	struct gro_udp4_item *items;
+	/* flow array */
+	struct gro_udp6_flow *flows;
+	/* current item number */
+	uint32_t item_num;
+	/* current flow num */
+	uint32_t flow_num;
+	/* item array size */
+	uint32_t max_item_num;
+	/* flow array size */
+	uint32_t max_flow_num;
+};
+
+/**
+ * This function creates a UDP/IPv6 reassembly table.
+ *
+ * @param socket_id
+ *  Socket index for allocating the UDP/IPv6 reassemble table
+ * @param max_flow_num
+ *  The maximum number of flows in the UDP/IPv6 GRO table
+ * @param max_item_per_flow
+ *  The maximum number of packets per flow
+ *
+ * @return
+ *  - Return the table pointer on success.
+ *  - Return NULL on failure.
+ */
+void *gro_udp6_tbl_create(uint16_t socket_id,
+		uint16_t max_flow_num,
+		uint16_t max_item_per_flow);
+
+/**
+ * This function destroys a UDP/IPv6 reassembly table.
+ *
+ * @param tbl
+ *  Pointer pointing to the UDP/IPv6 reassembly table.
+ */
+void gro_udp6_tbl_destroy(void *tbl);
+
+/**
+ * This function merges an IPv6 fragment of a UDP datagram with the
+ * neighbouring fragments of the same datagram. Only packets whose sole
+ * extension header is a fragment header, which carries UDP, are
+ * processed.
+ *
+ * Fragments are merged in offset order, the merged packet is a larger
+ * fragment of the original datagram, or the whole datagram once all
+ * fragments are merged; the fragment header is kept in the latter case.
+ * This function doesn't check if the packet has correct checksums and
+ * doesn't re-calculate checksums for the merged packet.
+ *
+ * @param pkt
+ *  Packet to reassemble
+ * @param tbl
+ *  Pointer pointing to the UDP/IPv6 reassembly table
+ * @start_time
+ *  The time when the packet is inserted into the table
+ *
+ * @return
+ *  - Return a positive value if the packet is merged.
+ *  - Return zero if the packet isn't merged but stored in the table.
+ *  - Return a negative value for invalid parameters or no available
+ *    space in the table.
+ */
+int32_t gro_udp6_reassemble(struct rte_mbuf *pkt,
+		struct gro_udp6_tbl *tbl,
+		uint64_t start_time);
+
+/**
+ * This function flushes timeout packets in a UDP/IPv6 reassembly table,
+ * and without updating checksums.
+ *
+ * @param tbl
+ *  UDP/IPv6 reassembly table pointer
+ * @param flush_timestamp
+ *  Flush packets which are inserted into the table before or at the
+ *  flush_timestamp.
+ * @param out
+ *  Pointer array used to keep flushed packets
+ * @param nb_out
+ *  The element number in 'out'. It also determines the maximum number of
+ *  packets that can be flushed finally.
+ *
+ * @return
+ *  The number of flushed packets
+ */
+uint16_t gro_udp6_tbl_timeout_flush(struct gro_udp6_tbl *tbl,
+		uint64_t flush_timestamp,
+		struct rte_mbuf **out,
+		uint16_t nb_out);
+
+/**
+ * This function returns the number of the packets in a UDP/IPv6
+ * reassembly table.
+ *
+ * @param tbl
+ *  UDP/IPv6 reassembly table pointer
+ *
+ * @return
+ *  The number of packets in the table
+ */
+uint32_t gro_udp6_tbl_pkt_count(void *tbl);
+
+/*
+ * Check if two UDP/IPv6 fragments belong to the same datagram.
+ */
+static inline int
+is_same_udp6_flow(const struct udp6_flow_key *k1,
+		const struct udp6_flow_key *k2)
+{
+	return (rte_is_same_ether_addr(&k1->eth_saddr, &k2->eth_saddr) &&
+			rte_is_same_ether_addr(&k1->eth_daddr,
+				&k2->eth_daddr) &&
+			(memcmp(k1->ip_src_addr, k2->ip_src_addr,
+				sizeof(k1->ip_src_addr)) == 0) &&
+			(memcmp(k1->ip_dst_addr, k2->ip_dst_addr,
+				sizeof(k1->ip_dst_addr)) == 0) &&
+			(k1->frag_id == k2->frag_id));
+}
+#endif
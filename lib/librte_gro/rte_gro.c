@@ -9,6 +9,9 @@
 
 #include "rte_gro.h"
 #include "gro_tcp4.h"
+#include "gro_tcp6.h"
+#include "gro_udp4.h"
+#include "gro_udp6.h"
 #include "gro_vxlan_tcp4.h"
 
 typedef void *(*gro_tbl_create_fn)(uint16_t socket_id,
@@ -18,17 +21,40 @@ typedef void (*gro_tbl_destroy_fn)(void *tbl);
 typedef uint32_t (*gro_tbl_pkt_count_fn)(void *tbl);
 
 static gro_tbl_create_fn tbl_create_fn[RTE_GRO_TYPE_MAX_NUM] = {
-		gro_tcp4_tbl_create, gro_vxlan_tcp4_tbl_create, NULL};
+		gro_tcp4_tbl_create, gro_vxlan_tcp4_tbl_create,
+		gro_udp4_tbl_create, gro_tcp6_tbl_create,
+		gro_udp6_tbl_create, NULL};
 static gro_tbl_destroy_fn tbl_destroy_fn[RTE_GRO_TYPE_MAX_NUM] = {
 			gro_tcp4_tbl_destroy, gro_vxlan_tcp4_tbl_destroy,
-			NULL};
+			gro_udp4_tbl_destroy, gro_tcp6_tbl_destroy,
+			gro_udp6_tbl_destroy, NULL};
 static gro_tbl_pkt_count_fn tbl_pkt_count_fn[RTE_GRO_TYPE_MAX_NUM] = {
 			gro_tcp4_tbl_pkt_count, gro_vxlan_tcp4_tbl_pkt_count,
-			NULL};
+			gro_udp4_tbl_pkt_count, gro_tcp6_tbl_pkt_count,
+			gro_udp6_tbl_pkt_count, NULL};
+
+#define GRO_SUPPORTED_TYPES (RTE_GRO_TCP_IPV4 | \
+		RTE_GRO_IPV4_VXLAN_TCP_IPV4 | RTE_GRO_UDP_IPV4 | \
+		RTE_GRO_TCP_IPV6 | RTE_GRO_UDP_IPV6)
 
 #define IS_IPV4_TCP_PKT(ptype) (RTE_ETH_IS_IPV4_HDR(ptype) && \
 		((ptype & RTE_PTYPE_L4_TCP) == RTE_PTYPE_L4_TCP))
 
+#define IS_IPV6_TCP_PKT(ptype) (RTE_ETH_IS_IPV6_HDR(ptype) && \
+		((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_TCP) && \
+		(RTE_ETH_IS_TUNNEL_PKT(ptype) == 0))
+
+/* UDP fragments may be reported with either L4 packet type */
+#define IS_UDP_FRAG_L4(ptype) \
+		(((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_UDP) || \
+		 ((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_FRAG))
+
+#define IS_IPV4_UDP_PKT(ptype) (RTE_ETH_IS_IPV4_HDR(ptype) && \
+		IS_UDP_FRAG_L4(ptype) && (RTE_ETH_IS_TUNNEL_PKT(ptype) == 0))
+
+#define IS_IPV6_UDP_PKT(ptype) (RTE_ETH_IS_IPV6_HDR(ptype) && \
+		IS_UDP_FRAG_L4(ptype) && (RTE_ETH_IS_TUNNEL_PKT(ptype) == 0))
+
 #define IS_IPV4_VXLAN_TCP4_PKT(ptype) (RTE_ETH_IS_IPV4_HDR(ptype) && \
 		((ptype & RTE_PTYPE_L4_UDP) == RTE_PTYPE_L4_UDP) && \
 		((ptype & RTE_PTYPE_TUNNEL_VXLAN) == \
@@ -129,14 +155,29 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 	struct gro_vxlan_tcp4_item vxlan_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {
 		{{0}, 0, 0} };
 
+	/* allocate a reassembly table for UDP/IPv4 GRO */
+	struct gro_udp4_tbl udp_tbl;
+	struct gro_udp4_flow udp_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_udp4_item udp_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {{0} };
+
+	/* allocate a reassembly table for TCP/IPv6 GRO */
+	struct gro_tcp6_tbl tcp6_tbl;
+	struct gro_tcp6_flow tcp6_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_tcp4_item tcp6_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {{0} };
+
+	/* allocate a reassembly table for UDP/IPv6 GRO */
+	struct gro_udp6_tbl udp6_tbl;
+	struct gro_udp6_flow udp6_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_udp4_item udp6_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {{0} };
+
 	struct rte_mbuf *unprocess_pkts[nb_pkts];
 	uint32_t item_num;
 	int32_t ret;
 	uint16_t i, unprocess_num = 0, nb_after_gro = nb_pkts;
-	uint8_t do_tcp4_gro = 0, do_vxlan_gro = 0;
+	uint8_t do_tcp4_gro = 0, do_vxlan_gro = 0, do_udp4_gro = 0,
+		do_tcp6_gro = 0, do_udp6_gro = 0;
 
-	if (unlikely((param->gro_types & (RTE_GRO_IPV4_VXLAN_TCP_IPV4 |
-					RTE_GRO_TCP_IPV4)) == 0))
+	if (unlikely((param->gro_types & GRO_SUPPORTED_TYPES) == 0))
 		return nb_pkts;
 
 	/* Get the maximum number of packets */
@@ -170,6 +211,45 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 		do_tcp4_gro = 1;
 	}
 
+	if (param->gro_types & RTE_GRO_UDP_IPV4) {
+		for (i = 0; i < item_num; i++)
+			udp_flows[i].start_index = INVALID_ARRAY_INDEX;
+
+		udp_tbl.flows = udp_flows;
+		udp_tbl.items = udp_items;
+		udp_tbl.flow_num = 0;
+		udp_tbl.item_num = 0;
+		udp_tbl.max_flow_num = item_num;
+		udp_tbl.max_item_num = item_num;
+		do_udp4_gro = 1;
+	}
+
+	if (param->gro_types & RTE_GRO_TCP_IPV6) {
+		for (i = 0; i < item_num; i++)
+			tcp6_flows[i].start_index = INVALID_ARRAY_INDEX;
+
+		tcp6_tbl.flows = tcp6_flows;
+		tcp6_tbl.items = tcp6_items;
+		tcp6_tbl.flow_num = 0;
+		tcp6_tbl.item_num = 0;
+		tcp6_tbl.max_flow_num = item_num;
+		tcp6_tbl.max_item_num = item_num;
+		do_tcp6_gro = 1;
+	}
+
+	if (param->gro_types & RTE_GRO_UDP_IPV6) {
+		for (i = 0; i < item_num; i++)
+			udp6_flows[i].start_index = INVALID_ARRAY_INDEX;
+
+		udp6_tbl.flows = udp6_flows;
+		udp6_tbl.items = udp6_items;
+		udp6_tbl.flow_num = 0;
+		udp6_tbl.item_num = 0;
+		udp6_tbl.max_flow_num = item_num;
+		udp6_tbl.max_item_num = item_num;
+		do_udp6_gro = 1;
+	}
+
 	for (i = 0; i < nb_pkts; i++) {
 		/*
 		 * The timestamp is ignored, since all packets
@@ -178,20 +258,25 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 		if (IS_IPV4_VXLAN_TCP4_PKT(pkts[i]->packet_type) &&
 				do_vxlan_gro) {
 			ret = gro_vxlan_tcp4_reassemble(pkts[i], &vxlan_tbl, 0);
-			if (ret > 0)
-				/* Merge successfully */
-				nb_after_gro--;
-			else if (ret < 0)
-				unprocess_pkts[unprocess_num++] = pkts[i];
+		} else if (IS_IPV4_UDP_PKT(pkts[i]->packet_type) &&
+				do_udp4_gro) {
+			ret = gro_udp4_reassemble(pkts[i], &udp_tbl, 0);
 		} else if (IS_IPV4_TCP_PKT(pkts[i]->packet_type) &&
 				do_tcp4_gro) {
 			ret = gro_tcp4_reassemble(pkts[i], &tcp_tbl, 0);
-			if (ret > 0)
-				/* merge successfully */
-				nb_after_gro--;
-			else if (ret < 0)
-				unprocess_pkts[unprocess_num++] = pkts[i];
+		} else if (IS_IPV6_UDP_PKT(pkts[i]->packet_type) &&
+				do_udp6_gro) {
+			ret = gro_udp6_reassemble(pkts[i], &udp6_tbl, 0);
+		} else if (IS_IPV6_TCP_PKT(pkts[i]->packet_type) &&
+				do_tcp6_gro) {
+			ret = gro_tcp6_reassemble(pkts[i], &tcp6_tbl, 0);
 		} else
+			ret = -1;
+
+		if (ret > 0)
+			/* merge successfully */
+			nb_after_gro--;
+		else if (ret < 0)
 			unprocess_pkts[unprocess_num++] = pkts[i];
 	}
 
@@ -206,6 +291,18 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 			i += gro_tcp4_tbl_timeout_flush(&tcp_tbl, 0,
 					&pkts[i], nb_pkts - i);
 		}
+		if (do_udp4_gro) {
+			i += gro_udp4_tbl_timeout_flush(&udp_tbl, 0,
+					&pkts[i], nb_pkts - i);
+		}
+		if (do_tcp6_gro) {
+			i += gro_tcp6_tbl_timeout_flush(&tcp6_tbl, 0,
+					&pkts[i], nb_pkts - i);
+		}
+		if (do_udp6_gro) {
+			i += gro_udp6_tbl_timeout_flush(&udp6_tbl, 0,
+					&pkts[i], nb_pkts - i);
+		}
 		/* Copy unprocessed packets */
 		if (unprocess_num > 0) {
 			memcpy(&pkts[i], unprocess_pkts,
@@ -224,37 +321,60 @@ rte_gro_reassemble(struct rte_mbuf **pkts,
 {
 	struct rte_mbuf *unprocess_pkts[nb_pkts];
 	struct gro_ctx *gro_ctx = ctx;
-	void *tcp_tbl, *vxlan_tbl;
+	void *tcp_tbl, *vxlan_tbl, *udp_tbl, *tcp6_tbl, *udp6_tbl;
 	uint64_t current_time;
 	uint16_t i, unprocess_num = 0;
-	uint8_t do_tcp4_gro, do_vxlan_gro;
+	uint8_t do_tcp4_gro, do_vxlan_gro, do_udp4_gro, do_tcp6_gro,
+		do_udp6_gro;
+	int32_t ret;
 
-	if (unlikely((gro_ctx->gro_types & (RTE_GRO_IPV4_VXLAN_TCP_IPV4 |
-					RTE_GRO_TCP_IPV4)) == 0))
+	if (unlikely((gro_ctx->gro_types & GRO_SUPPORTED_TYPES) == 0))
 		return nb_pkts;
 
 	tcp_tbl = gro_ctx->tbls[RTE_GRO_TCP_IPV4_INDEX];
 	vxlan_tbl = gro_ctx->tbls[RTE_GRO_IPV4_VXLAN_TCP_IPV4_INDEX];
+	udp_tbl = gro_ctx->tbls[RTE_GRO_UDP_IPV4_INDEX];
+	tcp6_tbl = gro_ctx->tbls[RTE_GRO_TCP_IPV6_INDEX];
+	udp6_tbl = gro_ctx->tbls[RTE_GRO_UDP_IPV6_INDEX];
 
 	do_tcp4_gro = (gro_ctx->gro_types & RTE_GRO_TCP_IPV4) ==
 		RTE_GRO_TCP_IPV4;
 	do_vxlan_gro = (gro_ctx->gro_types & RTE_GRO_IPV4_VXLAN_TCP_IPV4) ==
 		RTE_GRO_IPV4_VXLAN_TCP_IPV4;
+	do_udp4_gro = (gro_ctx->gro_types & RTE_GRO_UDP_IPV4) ==
+		RTE_GRO_UDP_IPV4;
+	do_tcp6_gro = (gro_ctx->gro_types & RTE_GRO_TCP_IPV6) ==
+		RTE_GRO_TCP_IPV6;
+	do_udp6_gro = (gro_ctx->gro_types & RTE_GRO_UDP_IPV6) ==
+		RTE_GRO_UDP_IPV6;
 
 	current_time = rte_rdtsc();
 
 	for (i = 0; i < nb_pkts; i++) {
 		if (IS_IPV4_VXLAN_TCP4_PKT(pkts[i]->packet_type) &&
 				do_vxlan_gro) {
-			if (gro_vxlan_tcp4_reassemble(pkts[i], vxlan_tbl,
-						current_time) < 0)
-				unprocess_pkts[unprocess_num++] = pkts[i];
+			ret = gro_vxlan_tcp4_reassemble(pkts[i], vxlan_tbl,
+					current_time);
+		} else if (IS_IPV4_UDP_PKT(pkts[i]->packet_type) &&
+				do_udp4_gro) {
+			ret = gro_udp4_reassemble(pkts[i], udp_tbl,
+					current_time);
 		} else if (IS_IPV4_TCP_PKT(pkts[i]->packet_type) &&
 				do_tcp4_gro) {
-			if (gro_tcp4_reassemble(pkts[i], tcp_tbl,
-						current_time) < 0)
-				unprocess_pkts[unprocess_num++] = pkts[i];
+			ret = gro_tcp4_reassemble(pkts[i], tcp_tbl,
+					current_time);
+		} else if (IS_IPV6_UDP_PKT(pkts[i]->packet_type) &&
+				do_udp6_gro) {
+			ret = gro_udp6_reassemble(pkts[i], udp6_tbl,
+					current_time);
+		} else if (IS_IPV6_TCP_PKT(pkts[i]->packet_type) &&
+				do_tcp6_gro) {
+			ret = gro_tcp6_reassemble(pkts[i], tcp6_tbl,
+					current_time);
 		} else
+			ret = -1;
+
+		if (ret < 0)
 			unprocess_pkts[unprocess_num++] = pkts[i];
 	}
 	if (unprocess_num > 0) {
@@ -283,15 +403,35 @@ rte_gro_timeout_flush(void *ctx,
 		num = gro_vxlan_tcp4_tbl_timeout_flush(gro_ctx->tbls[
 				RTE_GRO_IPV4_VXLAN_TCP_IPV4_INDEX],
 				flush_timestamp, out, max_nb_out);
-		max_nb_out -= num;
 	}
 
 	/* If no available space in 'out', stop flushing. */
-	if ((gro_types & RTE_GRO_TCP_IPV4) && max_nb_out > 0) {
+	if ((gro_types & RTE_GRO_TCP_IPV4) && num < max_nb_out) {
 		num += gro_tcp4_tbl_timeout_flush(
 				gro_ctx->tbls[RTE_GRO_TCP_IPV4_INDEX],
 				flush_timestamp,
-				&out[num], max_nb_out);
+				&out[num], max_nb_out - num);
+	}
+
+	if ((gro_types & RTE_GRO_UDP_IPV4) && num < max_nb_out) {
+		num += gro_udp4_tbl_timeout_flush(
+				gro_ctx->tbls[RTE_GRO_UDP_IPV4_INDEX],
+				flush_timestamp,
+				&out[num], max_nb_out - num);
+	}
+
+	if ((gro_types & RTE_GRO_TCP_IPV6) && num < max_nb_out) {
+		num += gro_tcp6_tbl_timeout_flush(
+				gro_ctx->tbls[RTE_GRO_TCP_IPV6_INDEX],
+				flush_timestamp,
+				&out[num], max_nb_out - num);
+	}
+
+	if ((gro_types & RTE_GRO_UDP_IPV6) && num < max_nb_out) {
+		num += gro_udp6_tbl_timeout_flush(
+				gro_ctx->tbls[RTE_GRO_UDP_IPV6_INDEX],
+				flush_timestamp,
+				&out[num], max_nb_out - num);
 	}
 
 	return num;
@@ -34,6 +34,44 @@
 #define IS_IPV4_UDP(flag) (((flag) & (PKT_TX_UDP_SEG | PKT_TX_IPV4)) == \
 		(PKT_TX_UDP_SEG | PKT_TX_IPV4))
 
+#define IS_IPV6_TCP(flag) (((flag) & (PKT_TX_TCP_SEG | PKT_TX_IPV6 | \
+				PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_TCP_SEG | PKT_TX_IPV6))
+
+#define IS_IPV6_UDP(flag) (((flag) & (PKT_TX_UDP_SEG | PKT_TX_IPV6 | \
+				PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_UDP_SEG | PKT_TX_IPV6))
+
+#define IS_IPV6_VXLAN_TCP4(flag) (((flag) & (PKT_TX_TCP_SEG | PKT_TX_IPV4 | \
+				PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_TCP_SEG | PKT_TX_IPV4 | PKT_TX_OUTER_IPV6 | \
+		 PKT_TX_TUNNEL_VXLAN))
+
+#define IS_IPV6_GRE_TCP4(flag) (((flag) & (PKT_TX_TCP_SEG | PKT_TX_IPV4 | \
+				PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_TCP_SEG | PKT_TX_IPV4 | PKT_TX_OUTER_IPV6 | \
+		 PKT_TX_TUNNEL_GRE))
+
+#define IS_IPV4_VXLAN_UDP4(flag) (((flag) & (PKT_TX_UDP_SEG | PKT_TX_IPV4 | \
+				PKT_TX_OUTER_IPV4 | PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_UDP_SEG | PKT_TX_IPV4 | PKT_TX_OUTER_IPV4 | \
+		 PKT_TX_TUNNEL_VXLAN))
+
+#define IS_IPV4_GRE_UDP4(flag) (((flag) & (PKT_TX_UDP_SEG | PKT_TX_IPV4 | \
+				PKT_TX_OUTER_IPV4 | PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_UDP_SEG | PKT_TX_IPV4 | PKT_TX_OUTER_IPV4 | \
+		 PKT_TX_TUNNEL_GRE))
+
+#define IS_IPV6_VXLAN_UDP4(flag) (((flag) & (PKT_TX_UDP_SEG | PKT_TX_IPV4 | \
+				PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_UDP_SEG | PKT_TX_IPV4 | PKT_TX_OUTER_IPV6 | \
+		 PKT_TX_TUNNEL_VXLAN))
+
+#define IS_IPV6_GRE_UDP4(flag) (((flag) & (PKT_TX_UDP_SEG | PKT_TX_IPV4 | \
+				PKT_TX_OUTER_IPV6 | PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_UDP_SEG | PKT_TX_IPV4 | PKT_TX_OUTER_IPV6 | \
+		 PKT_TX_TUNNEL_GRE))
+
 /**
  * Internal function which updates the UDP header of a packet, following
  * segmentation. This is required to update the header's datagram length field.
@@ -106,6 +144,27 @@ update_ipv4_header(struct rte_mbuf *pkt, uint16_t l3_offset, uint16_t id)
 	ipv4_hdr->packet_id = rte_cpu_to_be_16(id);
 }
 
+/**
+ * Internal function which updates the IPv6 header of a packet, following
+ * segmentation. This is required to update the header's 'payload_len'
+ * field, to reflect the reduced length of the now-segmented packet.
+ *
+ * @param pkt
+ *  The packet containing the IPv6 header.
+ * @param l3_offset
+ *  The offset of the IPv6 header from the start of the packet.
+ */
+static inline void
+update_ipv6_header(struct rte_mbuf *pkt, uint16_t l3_offset)
+{
+	struct rte_ipv6_hdr *ipv6_hdr;
+
+	ipv6_hdr = (struct rte_ipv6_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+			l3_offset);
+	ipv6_hdr->payload_len = rte_cpu_to_be_16(pkt->pkt_len - l3_offset -
+			sizeof(struct rte_ipv6_hdr));
+}
+
 /**
  * Internal function which divides the input packet into small segments.
  * Each of the newly-created segments is organized as a two-segment MBUF,
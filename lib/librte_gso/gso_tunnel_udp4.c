@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <errno.h>
+
+#include "gso_common.h"
+#include "gso_tunnel_udp4.h"
+
+#define IPV4_HDR_MF_BIT (1U << 13)
+#define IPV4_FRAG_OFFSET_ALIGN 8U
+
+static void
+update_tunnel_ipv4_udp_headers(struct rte_mbuf *pkt, struct rte_mbuf **segs,
+		uint16_t nb_segs)
+{
+	struct rte_ipv4_hdr *ipv4_hdr;
+	uint16_t outer_id = 0, frag_offset = 0, is_mf, length;
+	uint16_t outer_l3_offset, inner_ipv4_offset, udp_gre_offset;
+	uint16_t tail_idx = nb_segs - 1, i;
+	uint8_t update_udp_hdr, outer_ipv4;
+
+	outer_l3_offset = pkt->outer_l2_len;
+	udp_gre_offset = outer_l3_offset + pkt->outer_l3_len;
+	inner_ipv4_offset = udp_gre_offset + pkt->l2_len;
+
+	/* Outer IPv4 header. IPv6 has no ID to update. */
+	outer_ipv4 = (pkt->ol_flags & PKT_TX_OUTER_IPV4) ? 1 : 0;
+	if (outer_ipv4) {
+		ipv4_hdr = (struct rte_ipv4_hdr *)(rte_pktmbuf_mtod(pkt,
+					char *) + outer_l3_offset);
+		outer_id = rte_be_to_cpu_16(ipv4_hdr->packet_id);
+	}
+
+	/* Only update UDP header for VxLAN packets. */
+	update_udp_hdr = (pkt->ol_flags & PKT_TX_TUNNEL_VXLAN) ? 1 : 0;
+
+	/*
+	 * The inner IPv4 header keeps the same IP id in all output
+	 * segments, with updated fragment offset and total length.
+	 */
+	for (i = 0; i < nb_segs; i++) {
+		if (outer_ipv4)
+			update_ipv4_header(segs[i], outer_l3_offset, outer_id);
+		else
+			update_ipv6_header(segs[i], outer_l3_offset);
+		if (update_udp_hdr)
+			update_udp_header(segs[i], udp_gre_offset);
+
+		ipv4_hdr = rte_pktmbuf_mtod_offset(segs[i],
+				struct rte_ipv4_hdr *, inner_ipv4_offset);
+		length = segs[i]->pkt_len - inner_ipv4_offset;
+		ipv4_hdr->total_length = rte_cpu_to_be_16(length);
+
+		is_mf = i < tail_idx ? IPV4_HDR_MF_BIT : 0;
+		ipv4_hdr->fragment_offset =
+			rte_cpu_to_be_16(frag_offset | is_mf);
+		frag_offset += ((length - pkt->l3_len) >> 3);
+		outer_id++;
+	}
+}
+
+int
+gso_tunnel_udp4_segment(struct rte_mbuf *pkt,
+		uint16_t gso_size,
+		struct rte_mempool *direct_pool,
+		struct rte_mempool *indirect_pool,
+		struct rte_mbuf **pkts_out,
+		uint16_t nb_pkts_out)
+{
+	struct rte_ipv4_hdr *inner_ipv4_hdr;
+	uint16_t pyld_unit_size, hdr_offset, frag_off;
+	int ret;
+
+	hdr_offset = pkt->outer_l2_len + pkt->outer_l3_len + pkt->l2_len;
+	inner_ipv4_hdr = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv4_hdr *,
+			hdr_offset);
+	/*
+	 * Don't process the packet whose MF bit or offset in the inner
+	 * IPv4 header are non-zero.
+	 */
+	frag_off = rte_be_to_cpu_16(inner_ipv4_hdr->fragment_offset);
+	if (unlikely(IS_FRAGMENTED(frag_off))) {
+		pkts_out[0] = pkt;
+		return 1;
+	}
+
+	/*
+	 * The inner UDP header is a part of the payload, as for
+	 * UDP/IPv4 GSO.
+	 */
+	hdr_offset += pkt->l3_len;
+	/* Don't process the packet without data */
+	if (unlikely(hdr_offset + pkt->l4_len >= pkt->pkt_len)) {
+		pkts_out[0] = pkt;
+		return 1;
+	}
+	if (unlikely(gso_size < hdr_offset + IPV4_FRAG_OFFSET_ALIGN))
+		return -EINVAL;
+
+	/* Non-tail fragments must carry a multiple of 8 bytes */
+	pyld_unit_size = RTE_ALIGN_FLOOR(gso_size - hdr_offset,
+			IPV4_FRAG_OFFSET_ALIGN);
+
+	/* Segment the payload */
+	ret = gso_do_segment(pkt, hdr_offset, pyld_unit_size, direct_pool,
+			indirect_pool, pkts_out, nb_pkts_out);
+	if (ret > 1)
+		update_tunnel_ipv4_udp_headers(pkt, pkts_out, ret);
+
+	return ret;
+}
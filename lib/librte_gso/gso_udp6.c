@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <errno.h>
+
+#include <rte_random.h>
+
+#include "gso_common.h"
+#include "gso_udp6.h"
+
+#define IPV6_FRAG_MF_BIT 1U
+#define IPV6_FRAG_OFFSET_ALIGN 8U
+
+/* IPv6 fragment extension header */
+struct gso_ipv6_frag_hdr {
+	uint8_t next_header;
+	uint8_t reserved;
+	rte_be16_t frag_data;
+	rte_be32_t id;
+} __rte_packed;
+
+/*
+ * Insert a fragment header between the fixed IPv6 header and the payload
+ * of an output segment. The first part of the segment is a direct MBUF
+ * which only holds a copy of the packet headers, so the fragment header
+ * is simply appended to it.
+ */
+static inline void
+insert_ipv6_frag_header(struct rte_mbuf *seg, uint16_t hdr_len,
+		uint16_t frag_data, uint32_t id)
+{
+	struct rte_ipv6_hdr *ipv6_hdr;
+	struct gso_ipv6_frag_hdr *frag_hdr;
+	char *hdr;
+
+	hdr = rte_pktmbuf_mtod(seg, char *);
+	seg->data_len += sizeof(*frag_hdr);
+	seg->pkt_len += sizeof(*frag_hdr);
+
+	ipv6_hdr = (struct rte_ipv6_hdr *)(hdr + seg->l2_len);
+	frag_hdr = (struct gso_ipv6_frag_hdr *)(hdr + hdr_len);
+	frag_hdr->next_header = ipv6_hdr->proto;
+	frag_hdr->reserved = 0;
+	frag_hdr->frag_data = rte_cpu_to_be_16(frag_data);
+	frag_hdr->id = id;
+	ipv6_hdr->proto = IPPROTO_FRAGMENT;
+	seg->l3_len += sizeof(*frag_hdr);
+}
+
+static inline void
+update_ipv6_udp_headers(struct rte_mbuf *pkt, struct rte_mbuf **segs,
+		uint16_t nb_segs)
+{
+	uint16_t hdr_len = pkt->l2_len + pkt->l3_len;
+	uint16_t frag_offset = 0, is_mf, tail_idx = nb_segs - 1, i;
+	uint32_t id = (uint32_t)rte_rand();
+
+	/*
+	 * All output segments share one fragment ID. Offsets are counted
+	 * in bytes of the fragmentable part, which starts at the UDP header.
+	 */
+	for (i = 0; i < nb_segs; i++) {
+		is_mf = i < tail_idx ? IPV6_FRAG_MF_BIT : 0;
+		insert_ipv6_frag_header(segs[i], hdr_len, frag_offset | is_mf,
+				id);
+		update_ipv6_header(segs[i], pkt->l2_len);
+		frag_offset += segs[i]->pkt_len - hdr_len -
+			sizeof(struct gso_ipv6_frag_hdr);
+	}
+}
+
+int
+gso_udp6_segment(struct rte_mbuf *pkt,
+		uint16_t gso_size,
+		struct rte_mempool *direct_pool,
+		struct rte_mempool *indirect_pool,
+		struct rte_mbuf **pkts_out,
+		uint16_t nb_pkts_out)
+{
+	uint16_t pyld_unit_size, hdr_offset;
+	int ret;
+
+	/* Don't process the packet with extension headers */
+	if (unlikely(pkt->l3_len != sizeof(struct rte_ipv6_hdr))) {
+		pkts_out[0] = pkt;
+		return 1;
+	}
+
+	/*
+	 * UDP fragmentation is the same as IP fragmentation. Except the
+	 * first one, other output packets just have l2, l3 and fragment
+	 * headers.
+	 */
+	hdr_offset = pkt->l2_len + pkt->l3_len;
+
+	/* Don't process the packet without data. */
+	if (unlikely(hdr_offset + pkt->l4_len >= pkt->pkt_len)) {
+		pkts_out[0] = pkt;
+		return 1;
+	}
+
+	if (unlikely(gso_size < hdr_offset + sizeof(struct gso_ipv6_frag_hdr) +
+				IPV6_FRAG_OFFSET_ALIGN))
+		return -EINVAL;
+
+	/* Non-tail fragments must carry a multiple of 8 bytes */
+	pyld_unit_size = RTE_ALIGN_FLOOR(gso_size - hdr_offset -
+			sizeof(struct gso_ipv6_frag_hdr),
+			IPV6_FRAG_OFFSET_ALIGN);
+
+	/* Segment the payload */
+	ret = gso_do_segment(pkt, hdr_offset, pyld_unit_size, direct_pool,
+			indirect_pool, pkts_out, nb_pkts_out);
+	if (ret > 1)
+		update_ipv6_udp_headers(pkt, pkts_out, ret);
+
+	return ret;
+}
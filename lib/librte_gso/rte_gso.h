@@ -56,7 +56,9 @@ struct rte_gso_ctx {
 	 * gso_types.
 	 *
 	 * For example, if applications want to segment TCP/IPv4
-	 * packets, set DEV_TX_OFFLOAD_TCP_TSO in gso_types.
+	 * packets, set DEV_TX_OFFLOAD_TCP_TSO in gso_types. Tunnel
+	 * packets with inner UDP/IPv4 headers require both the tunnel
+	 * type and DEV_TX_OFFLOAD_UDP_TSO.
 	 */
 	uint16_t gso_size;
 	/**< maximum size of an output GSO segment, including packet
@@ -78,8 +80,14 @@ struct rte_gso_ctx {
  * Before calling rte_gso_segment(), applications must set proper ol_flags
  * for the packet. The GSO library uses the same macros as that of TSO.
  * For example, set PKT_TX_TCP_SEG and PKT_TX_IPV4 in ol_flags to segment
- * a TCP/IPv4 packet. If rte_gso_segment() succeeds, the PKT_TX_TCP_SEG
- * flag is removed for all GSO segments and the input packet.
+ * a TCP/IPv4 packet, or PKT_TX_UDP_SEG and PKT_TX_IPV6 to segment a
+ * UDP/IPv6 packet. If rte_gso_segment() succeeds, the PKT_TX_TCP_SEG
+ * or PKT_TX_UDP_SEG flag is removed for all GSO segments and the input
+ * packet.
+ *
+ * UDP packets are segmented by IP fragmentation. For UDP/IPv6 packets,
+ * a fragment header is inserted in each GSO segment, and packets with
+ * IPv6 extension headers are not processed.
  *
  * Each of the newly-created GSO segments is organized as a two-segment
  * MBUF, where the first segment is a standard MBUF, which stores a copy
@@ -38,7 +38,8 @@
 				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY | \
 				   RTE_HASH_EXTRA_FLAGS_EXT_TABLE |	\
 				   RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL | \
-				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF | \
+				   RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY)
 
 #define FOR_EACH_BUCKET(CURRENT_BKT, START_BUCKET)                            \
 	for (CURRENT_BKT = START_BUCKET;                                      \
@@ -153,6 +154,8 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	uint32_t *tbl_chng_cnt = NULL;
 	struct lcore_cache *local_free_slots = NULL;
 	unsigned int readwrite_concur_lf_support = 0;
+	unsigned int writer_bkt_lock = 0;
+	rte_spinlock_t *bkt_locks = NULL;
 	uint32_t i;
 
 	rte_hash_function default_hash_func = (rte_hash_function)rte_jhash;
@@ -188,6 +191,16 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		return NULL;
 	}
 
+	if ((params->extra_flag &
+			RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY) &&
+			(params->extra_flag & (RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY |
+				RTE_HASH_EXTRA_FLAGS_EXT_TABLE))) {
+		rte_errno = EINVAL;
+		RTE_LOG(ERR, HASH, "rte_hash_create: multi writer concurrency "
+			"does not support rw concurrency or ext table\n");
+		return NULL;
+	}
+
 	/* Check extra flags field to check extra options. */
 	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_TRANS_MEM_SUPPORT)
 		hw_trans_mem_support = 1;
@@ -214,6 +227,17 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		no_free_on_del = 1;
 	}
 
+	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY) {
+		/* Writers lock only the buckets they modify and readers
+		 * do not take any lock.
+		 */
+		use_local_cache = 1;
+		writer_takes_lock = 0;
+		writer_bkt_lock = 1;
+		readwrite_concur_lf_support = 1;
+		no_free_on_del = 1;
+	}
+
 	/* Store all keys and leave the first entry as a dummy entry for lookup_bulk */
 	if (use_local_cache)
 		/*
@@ -294,6 +318,19 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		goto err_unlock;
 	}
 
+	if (writer_bkt_lock) {
+		bkt_locks = rte_zmalloc_socket(NULL,
+				num_buckets * sizeof(rte_spinlock_t),
+				RTE_CACHE_LINE_SIZE, params->socket_id);
+		if (bkt_locks == NULL) {
+			RTE_LOG(ERR, HASH, "bucket locks memory allocation "
+							"failed\n");
+			goto err_unlock;
+		}
+		for (i = 0; i < num_buckets; i++)
+			rte_spinlock_init(&bkt_locks[i]);
+	}
+
 	/* Allocate same number of extendable buckets */
 	if (ext_table_support) {
 		buckets_ext = rte_zmalloc_socket(NULL,
@@ -425,6 +462,8 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->readwrite_concur_support = readwrite_concur_support;
 	h->ext_table_support = ext_table_support;
 	h->writer_takes_lock = writer_takes_lock;
+	h->writer_bkt_lock = writer_bkt_lock;
+	h->bkt_locks = bkt_locks;
 	h->no_free_on_del = no_free_on_del;
 	h->readwrite_concur_lf_support = readwrite_concur_lf_support;
 
@@ -471,6 +510,7 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	rte_free(h);
 	rte_free(buckets);
 	rte_free(buckets_ext);
+	rte_free(bkt_locks);
 	rte_free(k);
 	rte_free(tbl_chng_cnt);
 	rte_free(ext_bkt_to_free);
@@ -505,6 +545,9 @@ rte_hash_free(struct rte_hash *h)
 
 	rte_mcfg_tailq_write_unlock();
 
+	if (h->dq)
+		rte_rcu_qsbr_dq_delete(h->dq);
+
 	if (h->use_local_cache)
 		rte_free(h->local_free_slots);
 	if (h->writer_takes_lock)
@@ -514,8 +557,10 @@ rte_hash_free(struct rte_hash *h)
 	rte_free(h->key_store);
 	rte_free(h->buckets);
 	rte_free(h->buckets_ext);
+	rte_free(h->bkt_locks);
 	rte_free(h->tbl_chng_cnt);
 	rte_free(h->ext_bkt_to_free);
+	rte_free(h->hash_rcu_cfg);
 	rte_free(h);
 	rte_free(te);
 }
@@ -603,15 +648,86 @@ __hash_rw_reader_unlock(const struct rte_hash *h)
 		rte_rwlock_read_unlock(h->readwrite_lock);
 }
 
+/*
+ * Sort and remove duplicates from a set of bucket indexes to be locked
+ * by a writer. Buckets are always locked in ascending index order, so
+ * that writers locking overlapping sets of buckets cannot deadlock.
+ * Returns the number of unique bucket indexes.
+ */
+static inline unsigned int
+__hash_bkt_lock_set(uint32_t *bkt_idx, unsigned int n)
+{
+	unsigned int i, j, k;
+	uint32_t tmp;
+
+	for (i = 1; i < n; i++) {
+		tmp = bkt_idx[i];
+		for (j = i; j > 0 && bkt_idx[j - 1] > tmp; j--)
+			bkt_idx[j] = bkt_idx[j - 1];
+		bkt_idx[j] = tmp;
+	}
+
+	for (i = 1, k = 1; i < n; i++) {
+		if (bkt_idx[i] != bkt_idx[k - 1])
+			bkt_idx[k++] = bkt_idx[i];
+	}
+
+	return (n == 0) ? 0 : k;
+}
+
+/*
+ * Writer side locking. With RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_CONCURRENCY
+ * only the buckets in @bkt_idx (as returned by __hash_bkt_lock_set()) are
+ * locked, otherwise the table wide lock is taken.
+ */
+static inline void
+__hash_writer_lock(const struct rte_hash *h, const uint32_t *bkt_idx,
+		unsigned int n)
+{
+	unsigned int i;
+
+	if (!h->writer_bkt_lock) {
+		__hash_rw_writer_lock(h);
+		return;
+	}
+
+	for (i = 0; i < n; i++)
+		rte_spinlock_lock(&h->bkt_locks[bkt_idx[i]]);
+}
+
+static inline void
+__hash_writer_unlock(const struct rte_hash *h, const uint32_t *bkt_idx,
+		unsigned int n)
+{
+	unsigned int i;
+
+	if (!h->writer_bkt_lock) {
+		__hash_rw_writer_unlock(h);
+		return;
+	}
+
+	for (i = n; i > 0; i--)
+		rte_spinlock_unlock(&h->bkt_locks[bkt_idx[i - 1]]);
+}
+
 void
 rte_hash_reset(struct rte_hash *h)
 {
 	uint32_t tot_ring_cnt, i;
+	unsigned int pending;
 
 	if (h == NULL)
 		return;
 
 	__hash_rw_writer_lock(h);
+
+	if (h->dq) {
+		/* Reclaim all the resources */
+		rte_rcu_qsbr_dq_reclaim(h->dq, ~0, NULL, &pending, NULL);
+		if (pending != 0)
+			RTE_LOG(ERR, HASH, "RCU reclaim all resources failed\n");
+	}
+
 	memset(h->buckets, 0, h->num_buckets * sizeof(struct rte_hash_bucket));
 	memset(h->key_store, 0, h->key_entry_size * (h->entries + 1));
 	*h->tbl_chng_cnt = 0;
@@ -669,6 +785,42 @@ enqueue_slot_back(const struct rte_hash *h,
 						sizeof(uint32_t));
 }
 
+/*
+ * Function called to get a free key index from the cache/ring.
+ * Returns EMPTY_SLOT if no free index is available.
+ */
+static inline uint32_t
+alloc_slot(const struct rte_hash *h, struct lcore_cache *cached_free_slots)
+{
+	unsigned int n_slots;
+	uint32_t slot_id;
+
+	if (h->use_local_cache) {
+		/* Try to get a free slot from the local cache */
+		if (cached_free_slots->len == 0) {
+			/* Need to get another burst of free slots from global ring */
+			n_slots = rte_ring_mc_dequeue_burst_elem(h->free_slots,
+					cached_free_slots->objs,
+					sizeof(uint32_t),
+					LCORE_CACHE_SIZE, NULL);
+			if (n_slots == 0)
+				return EMPTY_SLOT;
+
+			cached_free_slots->len += n_slots;
+		}
+
+		/* Get a free slot from the local cache */
+		cached_free_slots->len--;
+		slot_id = cached_free_slots->objs[cached_free_slots->len];
+	} else {
+		if (rte_ring_sc_dequeue_elem(h->free_slots, &slot_id,
+						sizeof(uint32_t)) != 0)
+			return EMPTY_SLOT;
+	}
+
+	return slot_id;
+}
+
 /* Search a key from bucket and update its data.
  * Writer holds the lock before calling this.
  */
@@ -713,6 +865,7 @@ static inline int32_t
 rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 		struct rte_hash_bucket *prim_bkt,
 		struct rte_hash_bucket *sec_bkt,
+		const uint32_t *lock_idx, unsigned int n_locks,
 		const struct rte_hash_key *key, void *data,
 		uint16_t sig, uint32_t new_idx,
 		int32_t *ret_val)
@@ -721,13 +874,13 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 	struct rte_hash_bucket *cur_bkt;
 	int32_t ret;
 
-	__hash_rw_writer_lock(h);
+	__hash_writer_lock(h, lock_idx, n_locks);
 	/* Check if key was inserted after last check but before this
 	 * protected region in case of inserting duplicated keys.
 	 */
 	ret = search_and_update(h, data, key, prim_bkt, sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_writer_unlock(h, lock_idx, n_locks);
 		*ret_val = ret;
 		return 1;
 	}
@@ -735,7 +888,7 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_writer_unlock(h, lock_idx, n_locks);
 			*ret_val = ret;
 			return 1;
 		}
@@ -759,7 +912,7 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 			break;
 		}
 	}
-	__hash_rw_writer_unlock(h);
+	__hash_writer_unlock(h, lock_idx, n_locks);
 
 	if (i != RTE_HASH_BUCKET_ENTRIES)
 		return 0;
@@ -787,13 +940,30 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	struct queue_node *prev_node, *curr_node = leaf;
 	struct rte_hash_bucket *prev_bkt, *curr_bkt = leaf->bkt;
 	uint32_t prev_slot, curr_slot = leaf_slot;
+	uint32_t lock_idx[RTE_HASH_WRITER_LOCK_MAX_BKTS];
+	unsigned int n_locks = 0;
 	int32_t ret;
 
-	__hash_rw_writer_lock(h);
+	if (h->writer_bkt_lock) {
+		/* Lock the buckets of the new key and all the buckets
+		 * on the cuckoo path.
+		 */
+		lock_idx[n_locks++] = bkt - h->buckets;
+		lock_idx[n_locks++] = alt_bkt - h->buckets;
+		for (prev_node = leaf; prev_node != NULL;
+				prev_node = prev_node->prev) {
+			if (n_locks == RTE_HASH_WRITER_LOCK_MAX_BKTS)
+				return -1;
+			lock_idx[n_locks++] = prev_node->cur_bkt_idx;
+		}
+		n_locks = __hash_bkt_lock_set(lock_idx, n_locks);
+	}
+
+	__hash_writer_lock(h, lock_idx, n_locks);
 
 	/* In case empty slot was gone before entering protected region */
 	if (curr_bkt->key_idx[curr_slot] != EMPTY_SLOT) {
-		__hash_rw_writer_unlock(h);
+		__hash_writer_unlock(h, lock_idx, n_locks);
 		return -1;
 	}
 
@@ -802,7 +972,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	 */
 	ret = search_and_update(h, data, key, bkt, sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_writer_unlock(h, lock_idx, n_locks);
 		*ret_val = ret;
 		return 1;
 	}
@@ -810,7 +980,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	FOR_EACH_BUCKET(cur_bkt, alt_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_writer_unlock(h, lock_idx, n_locks);
 			*ret_val = ret;
 			return 1;
 		}
@@ -831,7 +1001,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			__atomic_store_n(&curr_bkt->key_idx[curr_slot],
 				EMPTY_SLOT,
 				__ATOMIC_RELEASE);
-			__hash_rw_writer_unlock(h);
+			__hash_writer_unlock(h, lock_idx, n_locks);
 			return -1;
 		}
 
@@ -839,12 +1009,12 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			/* Inform the previous move. The current move need
 			 * not be informed now as the current bucket entry
 			 * is present in both primary and secondary.
-			 * Since there is one writer, load acquires on
-			 * tbl_chng_cnt are not required.
+			 * Several writers may move keys concurrently
+			 * when the per bucket locks are used, hence the
+			 * atomic increment.
 			 */
-			__atomic_store_n(h->tbl_chng_cnt,
-					 *h->tbl_chng_cnt + 1,
-					 __ATOMIC_RELEASE);
+			__atomic_fetch_add(h->tbl_chng_cnt, 1,
+					   __ATOMIC_RELEASE);
 			/* The store to sig_current should not
 			 * move above the store to tbl_chng_cnt.
 			 */
@@ -871,12 +1041,8 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 		/* Inform the previous move. The current move need
 		 * not be informed now as the current bucket entry
 		 * is present in both primary and secondary.
-		 * Since there is one writer, load acquires on
-		 * tbl_chng_cnt are not required.
 		 */
-		__atomic_store_n(h->tbl_chng_cnt,
-				 *h->tbl_chng_cnt + 1,
-				 __ATOMIC_RELEASE);
+		__atomic_fetch_add(h->tbl_chng_cnt, 1, __ATOMIC_RELEASE);
 		/* The store to sig_current should not
 		 * move above the store to tbl_chng_cnt.
 		 */
@@ -889,7 +1055,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			 new_idx,
 			 __ATOMIC_RELEASE);
 
-	__hash_rw_writer_unlock(h);
+	__hash_writer_unlock(h, lock_idx, n_locks);
 
 	return 0;
 
@@ -963,12 +1129,13 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	uint32_t ext_bkt_id = 0;
 	uint32_t slot_id;
 	int ret;
-	unsigned n_slots;
 	unsigned lcore_id;
 	unsigned int i;
 	struct lcore_cache *cached_free_slots = NULL;
 	int32_t ret_val;
 	struct rte_hash_bucket *last;
+	uint32_t lock_idx[2];
+	unsigned int n_locks;
 
 	short_sig = get_short_sig(sig);
 	prim_bucket_idx = get_prim_bucket_index(h, sig);
@@ -978,11 +1145,15 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	rte_prefetch0(prim_bkt);
 	rte_prefetch0(sec_bkt);
 
+	lock_idx[0] = prim_bucket_idx;
+	lock_idx[1] = sec_bucket_idx;
+	n_locks = __hash_bkt_lock_set(lock_idx, 2);
+
 	/* Check if key is already inserted in primary location */
-	__hash_rw_writer_lock(h);
+	__hash_writer_lock(h, lock_idx, n_locks);
 	ret = search_and_update(h, data, key, prim_bkt, short_sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_writer_unlock(h, lock_idx, n_locks);
 		return ret;
 	}
 
@@ -990,39 +1161,32 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, short_sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_writer_unlock(h, lock_idx, n_locks);
 			return ret;
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
+	__hash_writer_unlock(h, lock_idx, n_locks);
 
 	/* Did not find a match, so get a new slot for storing the new key */
 	if (h->use_local_cache) {
 		lcore_id = rte_lcore_id();
 		cached_free_slots = &h->local_free_slots[lcore_id];
-		/* Try to get a free slot from the local cache */
-		if (cached_free_slots->len == 0) {
-			/* Need to get another burst of free slots from global ring */
-			n_slots = rte_ring_mc_dequeue_burst_elem(h->free_slots,
-					cached_free_slots->objs,
-					sizeof(uint32_t),
-					LCORE_CACHE_SIZE, NULL);
-			if (n_slots == 0) {
-				return -ENOSPC;
-			}
-
-			cached_free_slots->len += n_slots;
+	}
+	slot_id = alloc_slot(h, cached_free_slots);
+	if (slot_id == EMPTY_SLOT) {
+		if (h->dq) {
+			/* No free slots, try to reclaim deleted ones */
+			__hash_rw_writer_lock(h);
+			ret = rte_rcu_qsbr_dq_reclaim(h->dq,
+					h->hash_rcu_cfg->max_reclaim_size,
+					NULL, NULL, NULL);
+			__hash_rw_writer_unlock(h);
+			if (ret == 0)
+				slot_id = alloc_slot(h, cached_free_slots);
 		}
-
-		/* Get a free slot from the local cache */
-		cached_free_slots->len--;
-		slot_id = cached_free_slots->objs[cached_free_slots->len];
-	} else {
-		if (rte_ring_sc_dequeue_elem(h->free_slots, &slot_id,
-						sizeof(uint32_t)) != 0) {
+		if (slot_id == EMPTY_SLOT)
 			return -ENOSPC;
-		}
 	}
 
 	new_k = RTE_PTR_ADD(keys, slot_id * h->key_entry_size);
@@ -1037,8 +1201,9 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	memcpy(new_k->key, key, h->key_len);
 
 	/* Find an empty slot and insert */
-	ret = rte_hash_cuckoo_insert_mw(h, prim_bkt, sec_bkt, key, data,
-					short_sig, slot_id, &ret_val);
+	ret = rte_hash_cuckoo_insert_mw(h, prim_bkt, sec_bkt, lock_idx,
+					n_locks, key, data, short_sig, slot_id,
+					&ret_val);
 	if (ret == 0)
 		return slot_id - 1;
 	else if (ret == 1) {
@@ -1395,10 +1560,14 @@ rte_hash_lookup_data(const struct rte_hash *h, const void *key, void **data)
 	return __rte_hash_lookup_with_hash(h, key, rte_hash_hash(h, key), data);
 }
 
-static inline void
-remove_entry(const struct rte_hash *h, struct rte_hash_bucket *bkt, unsigned i)
+/*
+ * Function called to return a key index to the cache/ring.
+ * Returns -EFAULT if the lcore cache could not be flushed.
+ */
+static inline int
+free_slot(const struct rte_hash *h, uint32_t slot_id)
 {
-	unsigned lcore_id, n_slots;
+	unsigned int lcore_id, n_slots;
 	struct lcore_cache *cached_free_slots;
 
 	if (h->use_local_cache) {
@@ -1411,21 +1580,138 @@ remove_entry(const struct rte_hash *h, struct rte_hash_bucket *bkt, unsigned i)
 						cached_free_slots->objs,
 						sizeof(uint32_t),
 						LCORE_CACHE_SIZE, NULL);
-			ERR_IF_TRUE((n_slots == 0),
-				"%s: could not enqueue free slots in global ring\n",
-				__func__);
+			if (n_slots == 0)
+				return -EFAULT;
 			cached_free_slots->len -= n_slots;
 		}
 		/* Put index of new free slot in cache. */
-		cached_free_slots->objs[cached_free_slots->len] =
-							bkt->key_idx[i];
+		cached_free_slots->objs[cached_free_slots->len] = slot_id;
 		cached_free_slots->len++;
 	} else {
-		rte_ring_sp_enqueue_elem(h->free_slots,
-				&bkt->key_idx[i], sizeof(uint32_t));
+		rte_ring_sp_enqueue_elem(h->free_slots, &slot_id,
+						sizeof(uint32_t));
+	}
+
+	return 0;
+}
+
+static inline void
+remove_entry(const struct rte_hash *h, struct rte_hash_bucket *bkt, unsigned i)
+{
+	if (free_slot(h, bkt->key_idx[i]) < 0)
+		RTE_LOG(ERR, HASH,
+			"%s: could not enqueue free slots in global ring\n",
+			__func__);
+}
+
+/* Called by the RCU QSBR defer queue (or directly in blocking mode) once
+ * all readers have stopped referencing a deleted key.
+ */
+static void
+__hash_rcu_qsbr_free_resource(void *p, void *e, unsigned int n)
+{
+	void *key_data = NULL;
+	int ret;
+	struct rte_hash_key *keys, *k;
+	struct rte_hash *h = (struct rte_hash *)p;
+	struct __rte_hash_rcu_dq_entry rcu_dq_entry =
+			*((struct __rte_hash_rcu_dq_entry *)e);
+
+	RTE_SET_USED(n);
+	keys = h->key_store;
+
+	k = (struct rte_hash_key *) ((char *)keys +
+				rcu_dq_entry.key_idx * h->key_entry_size);
+	key_data = k->pdata;
+	if (h->hash_rcu_cfg->free_key_data_func)
+		h->hash_rcu_cfg->free_key_data_func(h->hash_rcu_cfg->key_data_ptr,
+						    key_data);
+
+	if (h->ext_table_support && rcu_dq_entry.ext_bkt_idx != EMPTY_SLOT)
+		/* Recycle empty ext bkt to free list. */
+		rte_ring_sp_enqueue_elem(h->free_ext_bkts,
+			&rcu_dq_entry.ext_bkt_idx, sizeof(uint32_t));
+
+	/* Return key indexes to free slot ring */
+	ret = free_slot(h, rcu_dq_entry.key_idx);
+	if (ret < 0) {
+		RTE_LOG(ERR, HASH,
+			"%s: could not enqueue free slots in global ring\n",
+				__func__);
 	}
 }
 
+int
+rte_hash_rcu_qsbr_add(struct rte_hash *h, struct rte_hash_rcu_config *cfg)
+{
+	struct rte_rcu_qsbr_dq_parameters params = {0};
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+	struct rte_hash_rcu_config *hash_rcu_cfg = NULL;
+
+	if (h == NULL || cfg == NULL || cfg->v == NULL) {
+		rte_errno = EINVAL;
+		return 1;
+	}
+
+	const uint32_t total_entries = h->use_local_cache ?
+		h->entries + (RTE_MAX_LCORE - 1) * (LCORE_CACHE_SIZE - 1) + 1
+							: h->entries + 1;
+
+	if (h->hash_rcu_cfg) {
+		rte_errno = EEXIST;
+		return 1;
+	}
+
+	hash_rcu_cfg = rte_zmalloc(NULL, sizeof(struct rte_hash_rcu_config), 0);
+	if (hash_rcu_cfg == NULL) {
+		RTE_LOG(ERR, HASH, "memory allocation failed\n");
+		rte_errno = ENOMEM;
+		return 1;
+	}
+
+	if (cfg->mode == RTE_HASH_QSBR_MODE_SYNC) {
+		/* No other things to do. */
+	} else if (cfg->mode == RTE_HASH_QSBR_MODE_DQ) {
+		/* Init QSBR defer queue. */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name),
+					"HASH_RCU_%s", h->name);
+		params.name = rcu_dq_name;
+		params.size = cfg->dq_size;
+		if (params.size == 0)
+			params.size = total_entries;
+		params.trigger_reclaim_limit = cfg->trigger_reclaim_limit;
+		params.max_reclaim_size = cfg->max_reclaim_size;
+		if (params.max_reclaim_size == 0)
+			params.max_reclaim_size = RTE_HASH_RCU_DQ_RECLAIM_MAX;
+		params.esize = sizeof(struct __rte_hash_rcu_dq_entry);
+		params.free_fn = __hash_rcu_qsbr_free_resource;
+		params.p = h;
+		params.v = cfg->v;
+		h->dq = rte_rcu_qsbr_dq_create(&params);
+		if (h->dq == NULL) {
+			rte_free(hash_rcu_cfg);
+			RTE_LOG(ERR, HASH, "HASH defer queue creation failed\n");
+			return 1;
+		}
+	} else {
+		rte_free(hash_rcu_cfg);
+		rte_errno = EINVAL;
+		return 1;
+	}
+
+	hash_rcu_cfg->v = cfg->v;
+	hash_rcu_cfg->mode = cfg->mode;
+	hash_rcu_cfg->dq_size = params.size;
+	hash_rcu_cfg->trigger_reclaim_limit = params.trigger_reclaim_limit;
+	hash_rcu_cfg->max_reclaim_size = params.max_reclaim_size;
+	hash_rcu_cfg->free_key_data_func = cfg->free_key_data_func;
+	hash_rcu_cfg->key_data_ptr = cfg->key_data_ptr;
+
+	h->hash_rcu_cfg = hash_rcu_cfg;
+
+	return 0;
+}
+
 /* Compact the linked list by moving key from last entry in linked list to the
  * empty slot.
  */
@@ -1490,9 +1776,11 @@ search_and_remove(const struct rte_hash *h, const void *key,
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
 				bkt->sig_current[i] = NULL_SIGNATURE;
 				/* Free the key store index if
-				 * no_free_on_del is disabled.
+				 * no_free_on_del is disabled and
+				 * internal RCU is not in use.
 				 */
-				if (!h->no_free_on_del)
+				if (!h->no_free_on_del &&
+						h->hash_rcu_cfg == NULL)
 					remove_entry(h, bkt, i);
 
 				__atomic_store_n(&bkt->key_idx[i],
@@ -1521,13 +1809,21 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 	int pos;
 	int32_t ret, i;
 	uint16_t short_sig;
+	uint32_t index = EMPTY_SLOT;
+	struct __rte_hash_rcu_dq_entry rcu_dq_entry;
+	uint32_t lock_idx[2];
+	unsigned int n_locks;
 
 	short_sig = get_short_sig(sig);
 	prim_bucket_idx = get_prim_bucket_index(h, sig);
 	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
 	prim_bkt = &h->buckets[prim_bucket_idx];
 
-	__hash_rw_writer_lock(h);
+	lock_idx[0] = prim_bucket_idx;
+	lock_idx[1] = sec_bucket_idx;
+	n_locks = __hash_bkt_lock_set(lock_idx, 2);
+
+	__hash_writer_lock(h, lock_idx, n_locks);
 	/* look for key in primary bucket */
 	ret = search_and_remove(h, key, prim_bkt, short_sig, &pos);
 	if (ret != -1) {
@@ -1550,15 +1846,14 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
+	__hash_writer_unlock(h, lock_idx, n_locks);
 	return -ENOENT;
 
 /* Search last bucket to see if empty to be recycled */
 return_bkt:
-	if (!last_bkt) {
-		__hash_rw_writer_unlock(h);
-		return ret;
-	}
+	if (!last_bkt)
+		goto return_key;
+
 	while (last_bkt->next) {
 		prev_bkt = last_bkt;
 		last_bkt = last_bkt->next;
@@ -1571,11 +1866,15 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 	/* found empty bucket and recycle */
 	if (i == RTE_HASH_BUCKET_ENTRIES) {
 		prev_bkt->next = NULL;
-		uint32_t index = last_bkt - h->buckets_ext + 1;
+		index = last_bkt - h->buckets_ext + 1;
 		/* Recycle the empty bkt if
 		 * no_free_on_del is disabled.
 		 */
-		if (h->no_free_on_del)
+		if (h->hash_rcu_cfg != NULL) {
+			/* The empty ext bkt is recycled together with
+			 * the key index once the RCU grace period ends.
+			 */
+		} else if (h->no_free_on_del)
 			/* Store index of an empty ext bkt to be recycled
 			 * on calling rte_hash_del_xxx APIs.
 			 * When lock free read-write concurrency is enabled,
@@ -1589,7 +1888,28 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 			rte_ring_sp_enqueue_elem(h->free_ext_bkts, &index,
 							sizeof(uint32_t));
 	}
-	__hash_rw_writer_unlock(h);
+
+return_key:
+	/* Using internal RCU QSBR */
+	if (h->hash_rcu_cfg) {
+		/* Key index where key is stored, adding the first dummy index */
+		rcu_dq_entry.key_idx = ret + 1;
+		rcu_dq_entry.ext_bkt_idx = index;
+		if (h->dq == NULL) {
+			/* Wait for quiescent state change if using
+			 * RTE_HASH_QSBR_MODE_SYNC
+			 */
+			rte_rcu_qsbr_synchronize(h->hash_rcu_cfg->v,
+						 RTE_QSBR_THRID_INVALID);
+			__hash_rcu_qsbr_free_resource((void *)((uintptr_t)h),
+						      &rcu_dq_entry, 1);
+		} else {
+			/* Push into QSBR FIFO if using RTE_HASH_QSBR_MODE_DQ */
+			if (rte_rcu_qsbr_dq_enqueue(h->dq, &rcu_dq_entry) != 0)
+				RTE_LOG(ERR, HASH, "Failed to push QSBR FIFO\n");
+		}
+	}
+	__hash_writer_unlock(h, lock_idx, n_locks);
 	return ret;
 }
 
@@ -1637,8 +1957,6 @@ rte_hash_free_key_with_position(const struct rte_hash *h,
 
 	RETURN_IF_TRUE(((h == NULL) || (key_idx == EMPTY_SLOT)), -EINVAL);
 
-	unsigned int lcore_id, n_slots;
-	struct lcore_cache *cached_free_slots;
 	const uint32_t total_entries = h->use_local_cache ?
 		h->entries + (RTE_MAX_LCORE - 1) * (LCORE_CACHE_SIZE - 1) + 1
 							: h->entries + 1;
@@ -1656,28 +1974,7 @@ rte_hash_free_key_with_position(const struct rte_hash *h,
 		}
 	}
 
-	if (h->use_local_cache) {
-		lcore_id = rte_lcore_id();
-		cached_free_slots = &h->local_free_slots[lcore_id];
-		/* Cache full, need to free it. */
-		if (cached_free_slots->len == LCORE_CACHE_SIZE) {
-			/* Need to enqueue the free slots in global ring. */
-			n_slots = rte_ring_mp_enqueue_burst_elem(h->free_slots,
-						cached_free_slots->objs,
-						sizeof(uint32_t),
-						LCORE_CACHE_SIZE, NULL);
-			RETURN_IF_TRUE((n_slots == 0), -EFAULT);
-			cached_free_slots->len -= n_slots;
-		}
-		/* Put index of new free slot in cache. */
-		cached_free_slots->objs[cached_free_slots->len] = key_idx;
-		cached_free_slots->len++;
-	} else {
-		rte_ring_sp_enqueue_elem(h->free_slots, &key_idx,
-						sizeof(uint32_t));
-	}
-
-	return 0;
+	return free_slot(h, key_idx);
 }
 
 static inline void
@@ -118,6 +118,11 @@ const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
 
 #define RTE_HASH_BFS_QUEUE_MAX_LEN       1000
 
+/* Max number of buckets locked at once by a writer: the buckets on a
+ * cuckoo path plus the primary and secondary buckets of the new key.
+ */
+#define RTE_HASH_WRITER_LOCK_MAX_BKTS    16
+
 #define RTE_XABORT_CUCKOO_PATH_INVALIDED 0x4
 
 #define RTE_HASH_TSX_MAX_RETRY  10
@@ -191,6 +196,10 @@ struct rte_hash {
 	/**< If read-write concurrency lock free support is enabled */
 	uint8_t writer_takes_lock;
 	/**< Indicates if the writer threads need to take lock */
+	uint8_t writer_bkt_lock;
+	/**< Indicates if the writer threads take per bucket locks instead
+	 * of the table wide lock.
+	 */
 	rte_hash_function hash_func;    /**< Function used to calculate hash. */
 	uint32_t hash_func_init_val;    /**< Init value used by hash_func. */
 	rte_hash_cmp_eq_t rte_hash_custom_cmp_eq;
@@ -209,6 +218,7 @@ struct rte_hash {
 	 * to the key table.
 	 */
 	rte_rwlock_t *readwrite_lock; /**< Read-write lock thread-safety. */
+	rte_spinlock_t *bkt_locks;	/**< Per bucket writer locks. */
 	struct rte_hash_bucket *buckets_ext; /**< Extra buckets array */
 	struct rte_ring *free_ext_bkts; /**< Ring of indexes of free buckets */
 	/* Stores index of an empty ext bkt to be recycled on calling
@@ -220,8 +230,17 @@ struct rte_hash {
 	uint32_t *ext_bkt_to_free;
 	uint32_t *tbl_chng_cnt;
 	/**< Indicates if the hash table changed from last read. */
+	struct rte_hash_rcu_config *hash_rcu_cfg;
+	/**< HASH RCU QSBR configuration structure */
+	struct rte_rcu_qsbr_dq *dq;	/**< RCU QSBR defer queue. */
 } __rte_cache_aligned;
 
+/* Entry stored in the RCU QSBR defer queue on key deletion */
+struct __rte_hash_rcu_dq_entry {
+	uint32_t key_idx;
+	uint32_t ext_bkt_idx;
+};
+
 struct queue_node {
 	struct rte_hash_bucket *bkt; /* Current bucket on the bfs search */
 	uint32_t cur_bkt_idx;
@@ -18,7 +18,7 @@
 #define IPV6_KEYLEN 4
 
 /* helper macros */
-#define	IP_FRAG_MBUF2DR(dr, mb)	((dr)->row[(dr)->cnt++] = (mb))
+#define	IP_FRAG_MBUF2DR(dr, mb)	ip_frag_dr_add(dr, mb)
 
 #define IPv6_KEY_BYTES(key) \
 	(key)[0], (key)[1], (key)[2], (key)[3]
@@ -32,18 +32,27 @@
 #endif /* IP_FRAG_TBL_STAT */
 
 /* internal functions declarations */
-struct rte_mbuf * ip_frag_process(struct ip_frag_pkt *fp,
-		struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb,
-		uint16_t ofs, uint16_t len, uint16_t more_frags);
+struct rte_mbuf * ip_frag_process(const struct rte_ip_frag_tbl *tbl,
+		struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
+		struct rte_mbuf *mb, uint16_t ofs, uint16_t len,
+		uint16_t more_frags);
 
 struct ip_frag_pkt * ip_frag_find(struct rte_ip_frag_tbl *tbl,
 		struct rte_ip_frag_death_row *dr,
 		const struct ip_frag_key *key, uint64_t tms);
 
+struct ip_frag_pkt * ip_frag_find_sig(struct rte_ip_frag_tbl *tbl,
+		struct rte_ip_frag_death_row *dr,
+		const struct ip_frag_key *key, uint32_t sig1, uint32_t sig2,
+		uint64_t tms);
+
 struct ip_frag_pkt * ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 	const struct ip_frag_key *key, uint64_t tms,
 	struct ip_frag_pkt **free, struct ip_frag_pkt **stale);
 
+void ip_frag_key_hash(const struct ip_frag_key *key,
+	uint32_t *sig1, uint32_t *sig2);
+
 /* these functions need to be declared here as ip_frag_process relies on them */
 struct rte_mbuf *ipv4_frag_reassemble(struct ip_frag_pkt *fp);
 struct rte_mbuf *ipv6_frag_reassemble(struct ip_frag_pkt *fp);
@@ -80,26 +89,69 @@ ip_frag_key_cmp(const struct ip_frag_key * k1, const struct ip_frag_key * k2)
 	return val;
 }
 
+/*
+ * misc table entry functions
+ */
+
+/* first entry of the bucket selected by a hash value */
+static inline struct ip_frag_pkt *
+ip_frag_tbl_pos(const struct rte_ip_frag_tbl *tbl, uint32_t sig)
+{
+	return RTE_PTR_ADD(tbl->pkt,
+		(size_t)(sig & tbl->entry_mask) * tbl->entry_size);
+}
+
+/* i-th entry from fp */
+static inline struct ip_frag_pkt *
+ip_frag_tbl_entry(const struct rte_ip_frag_tbl *tbl, struct ip_frag_pkt *fp,
+	uint32_t i)
+{
+	return RTE_PTR_ADD(fp, (size_t)i * tbl->entry_size);
+}
+
+/*
+ * fragments of an entry: the table entries are sized for its max_frags
+ * fragments, which may be more than the IP_MAX_FRAG_NUM ones of the frags[]
+ * array, so indexing that array directly past its declared size is avoided.
+ */
+static inline struct ip_frag *
+ip_frag_pkt_frags(struct ip_frag_pkt *fp)
+{
+	return RTE_PTR_ADD(fp, offsetof(struct ip_frag_pkt, frags));
+}
+
 /*
  * misc fragment functions
  */
 
+/*
+ * put mbuf on death row, free it at once if the row is full, as an entry
+ * may hold more fragments than the row was sized for.
+ */
+static inline void
+ip_frag_dr_add(struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb)
+{
+	if (likely(dr->cnt < RTE_DIM(dr->row)))
+		dr->row[dr->cnt++] = mb;
+	else
+		rte_pktmbuf_free(mb);
+}
+
 /* put fragment on death row */
 static inline void
 ip_frag_free(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr)
 {
-	uint32_t i, k;
+	uint32_t i;
+	struct ip_frag *frags = ip_frag_pkt_frags(fp);
 
-	k = dr->cnt;
 	for (i = 0; i != fp->last_idx; i++) {
-		if (fp->frags[i].mb != NULL) {
-			dr->row[k++] = fp->frags[i].mb;
-			fp->frags[i].mb = NULL;
+		if (frags[i].mb != NULL) {
+			ip_frag_dr_add(dr, frags[i].mb);
+			frags[i].mb = NULL;
 		}
 	}
 
 	fp->last_idx = 0;
-	dr->cnt = k;
 }
 
 /* delete fragment's mbufs immediately instead of using death row */
@@ -107,15 +159,16 @@ static inline void
 ip_frag_free_immediate(struct ip_frag_pkt *fp)
 {
 	uint32_t i;
+	struct ip_frag *frags = ip_frag_pkt_frags(fp);
 
 	for (i = 0; i < fp->last_idx; i++) {
-		if (fp->frags[i].mb != NULL) {
+		if (frags[i].mb != NULL) {
 			IP_FRAG_LOG(DEBUG, "%s:%d\n"
 			    "mbuf: %p, tms: %" PRIu64", key: <%" PRIx64 ", %#x>\n",
-			    __func__, __LINE__, fp->frags[i].mb, fp->start,
+			    __func__, __LINE__, frags[i].mb, fp->start,
 			    fp->key.src_dst[0], fp->key.id);
-			rte_pktmbuf_free(fp->frags[i].mb);
-			fp->frags[i].mb = NULL;
+			rte_pktmbuf_free(frags[i].mb);
+			frags[i].mb = NULL;
 		}
 	}
 
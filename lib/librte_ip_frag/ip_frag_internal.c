@@ -11,8 +11,9 @@
 
 #define	PRIME_VALUE	0xeaad8405
 
-#define	IP_FRAG_TBL_POS(tbl, sig)	\
-	((tbl)->pkt + ((sig) & (tbl)->entry_mask))
+static struct ip_frag_pkt *ip_frag_lookup_sig(struct rte_ip_frag_tbl *tbl,
+	const struct ip_frag_key *key, uint32_t sig1, uint32_t sig2,
+	uint64_t tms, struct ip_frag_pkt **free, struct ip_frag_pkt **stale);
 
 static inline void
 ip_frag_tbl_add(struct rte_ip_frag_tbl *tbl,  struct ip_frag_pkt *fp,
@@ -87,11 +88,23 @@ ipv6_frag_hash(const struct ip_frag_key *key, uint32_t *v1, uint32_t *v2)
 	*v2 = (v << 7) + (v >> 14);
 }
 
+/* different hashing methods for IPv4 and IPv6 */
+void
+ip_frag_key_hash(const struct ip_frag_key *key, uint32_t *sig1, uint32_t *sig2)
+{
+	if (key->key_len == IPV4_KEYLEN)
+		ipv4_frag_hash(key, sig1, sig2);
+	else
+		ipv6_frag_hash(key, sig1, sig2);
+}
+
 struct rte_mbuf *
-ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
-	struct rte_mbuf *mb, uint16_t ofs, uint16_t len, uint16_t more_frags)
+ip_frag_process(const struct rte_ip_frag_tbl *tbl, struct ip_frag_pkt *fp,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb, uint16_t ofs,
+	uint16_t len, uint16_t more_frags)
 {
 	uint32_t idx;
+	struct ip_frag *frags = ip_frag_pkt_frags(fp);
 
 	fp->frag_size += len;
 
@@ -107,7 +120,7 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
 				IP_LAST_FRAG_IDX : UINT32_MAX;
 
 	/* this is the intermediate fragment. */
-	} else if ((idx = fp->last_idx) < RTE_DIM(fp->frags)) {
+	} else if ((idx = fp->last_idx) < tbl->max_frags) {
 		fp->last_idx++;
 	}
 
@@ -115,7 +128,7 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
 	 * erroneous packet: either exceed max allowed number of fragments,
 	 * or duplicate first/last fragment encountered.
 	 */
-	if (idx >= RTE_DIM(fp->frags)) {
+	if (idx >= tbl->max_frags) {
 
 		/* report an error. */
 		if (fp->key.key_len == IPV4_KEYLEN)
@@ -153,9 +166,9 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
 		return NULL;
 	}
 
-	fp->frags[idx].ofs = ofs;
-	fp->frags[idx].len = len;
-	fp->frags[idx].mb = mb;
+	frags[idx].ofs = ofs;
+	frags[idx].len = len;
+	frags[idx].mb = mb;
 
 	mb = NULL;
 
@@ -218,24 +231,18 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
  * If such entry is not present, then allocate a new one.
  * If the entry is stale, then free and reuse it.
  */
-struct ip_frag_pkt *
-ip_frag_find(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
-	const struct ip_frag_key *key, uint64_t tms)
+static inline struct ip_frag_pkt *
+ip_frag_find_entry(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, const struct ip_frag_key *key,
+	uint64_t tms, struct ip_frag_pkt *pkt, struct ip_frag_pkt *free,
+	struct ip_frag_pkt *stale)
 {
-	struct ip_frag_pkt *pkt, *free, *stale, *lru;
+	struct ip_frag_pkt *lru;
 	uint64_t max_cycles;
 
-	/*
-	 * Actually the two line below are totally redundant.
-	 * they are here, just to make gcc 4.6 happy.
-	 */
-	free = NULL;
-	stale = NULL;
 	max_cycles = tbl->max_cycles;
 
-	IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, find_num, 1);
-
-	if ((pkt = ip_frag_lookup(tbl, key, tms, &free, &stale)) == NULL) {
+	if (pkt == NULL) {
 
 		/*timed-out entry, free and invalidate it*/
 		if (stale != NULL) {
@@ -281,14 +288,57 @@ ip_frag_find(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 }
 
 struct ip_frag_pkt *
-ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
-	const struct ip_frag_key *key, uint64_t tms,
-	struct ip_frag_pkt **free, struct ip_frag_pkt **stale)
+ip_frag_find(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
+	const struct ip_frag_key *key, uint64_t tms)
 {
-	struct ip_frag_pkt *p1, *p2;
+	struct ip_frag_pkt *pkt, *free, *stale;
+
+	/*
+	 * Actually the two line below are totally redundant.
+	 * they are here, just to make gcc 4.6 happy.
+	 */
+	free = NULL;
+	stale = NULL;
+
+	IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, find_num, 1);
+
+	pkt = ip_frag_lookup(tbl, key, tms, &free, &stale);
+	return ip_frag_find_entry(tbl, dr, key, tms, pkt, free, stale);
+}
+
+/*
+ * Same as ip_frag_find(), for a key whose hash values were computed
+ * beforehand.
+ */
+struct ip_frag_pkt *
+ip_frag_find_sig(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
+	const struct ip_frag_key *key, uint32_t sig1, uint32_t sig2,
+	uint64_t tms)
+{
+	struct ip_frag_pkt *pkt, *free, *stale;
+
+	free = NULL;
+	stale = NULL;
+
+	IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, find_num, 1);
+
+	if (tbl->last != NULL && ip_frag_key_cmp(key, &tbl->last->key) == 0)
+		pkt = tbl->last;
+	else
+		pkt = ip_frag_lookup_sig(tbl, key, sig1, sig2, tms,
+			&free, &stale);
+	return ip_frag_find_entry(tbl, dr, key, tms, pkt, free, stale);
+}
+
+static struct ip_frag_pkt *
+ip_frag_lookup_sig(struct rte_ip_frag_tbl *tbl,
+	const struct ip_frag_key *key, uint32_t sig1, uint32_t sig2,
+	uint64_t tms, struct ip_frag_pkt **free, struct ip_frag_pkt **stale)
+{
+	struct ip_frag_pkt *b1, *b2, *p1, *p2;
 	struct ip_frag_pkt *empty, *old;
 	uint64_t max_cycles;
-	uint32_t i, assoc, sig1, sig2;
+	uint32_t i, assoc;
 
 	empty = NULL;
 	old = NULL;
@@ -296,19 +346,13 @@ ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 	max_cycles = tbl->max_cycles;
 	assoc = tbl->bucket_entries;
 
-	if (tbl->last != NULL && ip_frag_key_cmp(key, &tbl->last->key) == 0)
-		return tbl->last;
-
-	/* different hashing methods for IPv4 and IPv6 */
-	if (key->key_len == IPV4_KEYLEN)
-		ipv4_frag_hash(key, &sig1, &sig2);
-	else
-		ipv6_frag_hash(key, &sig1, &sig2);
-
-	p1 = IP_FRAG_TBL_POS(tbl, sig1);
-	p2 = IP_FRAG_TBL_POS(tbl, sig2);
+	b1 = ip_frag_tbl_pos(tbl, sig1);
+	b2 = ip_frag_tbl_pos(tbl, sig2);
 
 	for (i = 0; i != assoc; i++) {
+		p1 = ip_frag_tbl_entry(tbl, b1, i);
+		p2 = ip_frag_tbl_entry(tbl, b2, i);
+
 		if (p1->key.key_len == IPV4_KEYLEN)
 			IP_FRAG_LOG(DEBUG, "%s:%d:\n"
 					"tbl: %p, max_entries: %u, use_entries: %u\n"
@@ -317,7 +361,7 @@ ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 					__func__, __LINE__,
 					tbl, tbl->max_entries, tbl->use_entries,
 					p1, i, assoc,
-			p1[i].key.src_dst[0], p1[i].key.id, p1[i].start);
+			p1->key.src_dst[0], p1->key.id, p1->start);
 		else
 			IP_FRAG_LOG(DEBUG, "%s:%d:\n"
 					"tbl: %p, max_entries: %u, use_entries: %u\n"
@@ -326,14 +370,14 @@ ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 					__func__, __LINE__,
 					tbl, tbl->max_entries, tbl->use_entries,
 					p1, i, assoc,
-			IPv6_KEY_BYTES(p1[i].key.src_dst), p1[i].key.id, p1[i].start);
+			IPv6_KEY_BYTES(p1->key.src_dst), p1->key.id, p1->start);
 
-		if (ip_frag_key_cmp(key, &p1[i].key) == 0)
-			return p1 + i;
-		else if (ip_frag_key_is_empty(&p1[i].key))
-			empty = (empty == NULL) ? (p1 + i) : empty;
-		else if (max_cycles + p1[i].start < tms)
-			old = (old == NULL) ? (p1 + i) : old;
+		if (ip_frag_key_cmp(key, &p1->key) == 0)
+			return p1;
+		else if (ip_frag_key_is_empty(&p1->key))
+			empty = (empty == NULL) ? p1 : empty;
+		else if (max_cycles + p1->start < tms)
+			old = (old == NULL) ? p1 : old;
 
 		if (p2->key.key_len == IPV4_KEYLEN)
 			IP_FRAG_LOG(DEBUG, "%s:%d:\n"
@@ -343,7 +387,7 @@ ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 					__func__, __LINE__,
 					tbl, tbl->max_entries, tbl->use_entries,
 					p2, i, assoc,
-			p2[i].key.src_dst[0], p2[i].key.id, p2[i].start);
+			p2->key.src_dst[0], p2->key.id, p2->start);
 		else
 			IP_FRAG_LOG(DEBUG, "%s:%d:\n"
 					"tbl: %p, max_entries: %u, use_entries: %u\n"
@@ -352,17 +396,32 @@ ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 					__func__, __LINE__,
 					tbl, tbl->max_entries, tbl->use_entries,
 					p2, i, assoc,
-			IPv6_KEY_BYTES(p2[i].key.src_dst), p2[i].key.id, p2[i].start);
-
-		if (ip_frag_key_cmp(key, &p2[i].key) == 0)
-			return p2 + i;
-		else if (ip_frag_key_is_empty(&p2[i].key))
-			empty = (empty == NULL) ?( p2 + i) : empty;
-		else if (max_cycles + p2[i].start < tms)
-			old = (old == NULL) ? (p2 + i) : old;
+			IPv6_KEY_BYTES(p2->key.src_dst), p2->key.id, p2->start);
+
+		if (ip_frag_key_cmp(key, &p2->key) == 0)
+			return p2;
+		else if (ip_frag_key_is_empty(&p2->key))
+			empty = (empty == NULL) ?p2 : empty;
+		else if (max_cycles + p2->start < tms)
+			old = (old == NULL) ? p2 : old;
 	}
 
 	*free = empty;
 	*stale = old;
 	return NULL;
 }
+
+struct ip_frag_pkt *
+ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
+	const struct ip_frag_key *key, uint64_t tms,
+	struct ip_frag_pkt **free, struct ip_frag_pkt **stale)
+{
+	uint32_t sig1, sig2;
+
+	if (tbl->last != NULL && ip_frag_key_cmp(key, &tbl->last->key) == 0)
+		return tbl->last;
+
+	ip_frag_key_hash(key, &sig1, &sig2);
+
+	return ip_frag_lookup_sig(tbl, key, sig1, sig2, tms, free, stale);
+}
@@ -20,6 +20,7 @@ extern "C" {
 #include <stdio.h>
 
 #include <rte_config.h>
+#include <rte_compat.h>
 #include <rte_malloc.h>
 #include <rte_memory.h>
 #include <rte_ip.h>
@@ -35,6 +36,9 @@ enum {
 	/**< maximum number of fragments per packet */
 };
 
+/** Upper limit of the maximum number of fragments per packet of a table */
+#define RTE_IP_FRAG_TBL_MAX_FRAGS 64
+
 /** @internal fragmented mbuf */
 struct ip_frag {
 	uint16_t ofs;          /**< offset into the packet */
@@ -60,6 +64,10 @@ struct ip_frag_key {
 /**
  * @internal Fragmented packet to reassemble.
  * First two entries in the frags[] array are for the last and first fragments.
+ * The array holds max_frags entries of the table, which may differ from
+ * IP_MAX_FRAG_NUM: the table entries are entry_size bytes apart and the
+ * library reaches the fragments past the declared array size through a
+ * pointer to the start of the array, rather than by indexing frags[].
  */
 struct ip_frag_pkt {
 	TAILQ_ENTRY(ip_frag_pkt) lru;   /**< LRU list */
@@ -106,8 +114,11 @@ struct rte_ip_frag_tbl {
 	uint32_t             nb_buckets;      /**< num of associativity lines. */
 	struct ip_frag_pkt *last;         /**< last used entry. */
 	struct ip_pkt_list lru;           /**< LRU list for table entries. */
+	uint32_t             entry_size;      /**< size of a table entry. */
+	uint32_t             max_frags;       /**< max fragments per packet. */
 	struct ip_frag_tbl_stat stat;     /**< statistics counters. */
-	__extension__ struct ip_frag_pkt pkt[0]; /**< hash table. */
+	__extension__ struct ip_frag_pkt pkt[0];
+	/**< hash table, entries are entry_size bytes apart. */
 };
 
 /** IPv6 fragment extension header */
@@ -158,6 +169,44 @@ struct rte_ip_frag_tbl * rte_ip_frag_table_create(uint32_t bucket_num,
 		uint32_t bucket_entries,  uint32_t max_entries,
 		uint64_t max_cycles, int socket_id);
 
+/** Parameters of an IP fragmentation table */
+struct rte_ip_frag_tbl_params {
+	uint32_t bucket_num;     /**< number of buckets in the hash table */
+	uint32_t bucket_entries;
+	/**< entries per bucket (hash associativity), power of two */
+	uint32_t max_entries;    /**< max entries stored in the table */
+	uint64_t max_cycles;     /**< max TTL in cycles of a fragmented packet */
+	int socket_id;           /**< NUMA socket of the table, or SOCKET_ID_ANY */
+	uint32_t max_frags;
+	/**<
+	 * Max fragments per packet, from IP_MIN_FRAG_NUM to
+	 * RTE_IP_FRAG_TBL_MAX_FRAGS, 0 for IP_MAX_FRAG_NUM.
+	 */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a new IP fragmentation table from a set of parameters.
+ *
+ * Unlike rte_ip_frag_table_create(), the maximum number of fragments per
+ * packet is set at runtime: the table entries are sized for max_frags
+ * fragments, packets with more fragments are dropped.
+ *
+ * @param params
+ *   Parameters of the table.
+ * @return
+ *   The pointer to the new allocated fragmentation table, on success.
+ *   NULL on error, with rte_errno set:
+ *   - EINVAL: invalid parameters
+ *   - ENOMEM: allocation failed
+ */
+__rte_experimental
+struct rte_ip_frag_tbl *
+rte_ip_frag_table_create_with_params(
+		const struct rte_ip_frag_tbl_params *params);
+
 /**
  * Free allocated IP fragmentation table.
  *
@@ -353,6 +402,151 @@ void
 rte_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
 	struct rte_ip_frag_death_row *dr, uint64_t tms);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Reassemble a burst of IPv4 and IPv6 packets.
+ *
+ * The headers of the whole burst are parsed and hashed first, prefetching
+ * the table buckets of every fragment, then the fragments are looked up
+ * and processed in order. Incoming mbufs should have their l2_len/l3_len
+ * fields setup correctly, l3_len including the IPv6 fragment extension
+ * header, which must follow the IPv6 header.
+ *
+ * Packets that are not fragments are kept as they are. Fragments are
+ * taken by the table, or put on the death row on error.
+ *
+ * @param tbl
+ *   Table where to lookup/add the fragmented packets.
+ * @param dr
+ *   Death row to free buffers to
+ * @param pkts
+ *   Array of packets to reassemble. On return, it holds the packets that
+ *   are not fragments and the reassembled packets, in arrival order.
+ * @param nb_pkts
+ *   Number of packets in the array.
+ * @param tms
+ *   Packets arrival timestamp.
+ * @return
+ *   Number of packets returned in the array.
+ */
+__rte_experimental
+uint16_t
+rte_ip_frag_reassemble_burst(struct rte_ip_frag_tbl *tbl,
+		struct rte_ip_frag_death_row *dr, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, uint64_t tms);
+
+/** Set of fragmentation tables reassembling packets on several lcores */
+struct rte_ip_frag_shards;
+
+/** Parameters of a set of fragmentation tables */
+struct rte_ip_frag_shards_params {
+	const char *name;      /**< name of the set, used to name its rings */
+	uint32_t nb_shards;    /**< number of shards, up to RTE_MAX_LCORE */
+	uint32_t ring_size;    /**< size of each shard ring, power of two */
+	struct rte_ip_frag_tbl_params tbl; /**< parameters of each shard table */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a set of fragmentation tables, one per shard.
+ *
+ * Each shard is meant to be used by a single lcore, typically the one
+ * polling a queue. A datagram is reassembled by the shard selected by the
+ * hash of its key, so that all of its fragments meet in the same table
+ * whatever the queue they were received on. The fragments received by
+ * another shard are handed over through a multi-producer ring of the
+ * owning shard, no table is shared and no lock is taken.
+ *
+ * @param params
+ *   Parameters of the set.
+ * @return
+ *   The pointer to the new set, on success.
+ *   NULL on error, with rte_errno set:
+ *   - EINVAL: invalid parameters
+ *   - ENOMEM: allocation failed
+ *   - EEXIST: a ring of the same name already exists
+ */
+__rte_experimental
+struct rte_ip_frag_shards *
+rte_ip_frag_shards_create(const struct rte_ip_frag_shards_params *params);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Free a set of fragmentation tables, and the fragments it holds.
+ *
+ * @param shards
+ *   Set of fragmentation tables to free.
+ */
+__rte_experimental
+void
+rte_ip_frag_shards_destroy(struct rte_ip_frag_shards *shards);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the fragmentation table of a shard, e.g. to dump its statistics or
+ * to delete its expired entries from the lcore using the shard.
+ *
+ * @param shards
+ *   Set of fragmentation tables.
+ * @param shard_id
+ *   Index of the shard.
+ * @return
+ *   The table of the shard, or NULL if shard_id is out of range.
+ */
+__rte_experimental
+struct rte_ip_frag_tbl *
+rte_ip_frag_shards_get_table(struct rte_ip_frag_shards *shards,
+		uint32_t shard_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Reassemble a burst of IPv4 and IPv6 packets on a shard.
+ *
+ * The fragments of the burst owned by another shard are handed over to it,
+ * or put on the death row if its ring is full. The other fragments of the
+ * burst, then the fragments handed over by the other shards, are
+ * reassembled in the shard table as with rte_ip_frag_reassemble_burst().
+ * Each shard must be used by one lcore at a time, and polled even without
+ * packets of its own to reassemble the fragments handed over to it.
+ *
+ * @param shards
+ *   Set of fragmentation tables.
+ * @param shard_id
+ *   Index of the shard of the calling lcore.
+ * @param dr
+ *   Death row to free buffers to
+ * @param pkts
+ *   Array of packets to reassemble.
+ * @param nb_pkts
+ *   Number of packets in the array, they are all consumed.
+ * @param out
+ *   Array receiving the packets that are not fragments and the reassembled
+ *   packets.
+ * @param nb_out
+ *   Size of the out array, at least nb_pkts. The fragments handed over
+ *   are dequeued up to the room left in the array.
+ * @param tms
+ *   Packets arrival timestamp.
+ * @return
+ *   Number of packets returned in the out array.
+ */
+__rte_experimental
+uint16_t
+rte_ip_frag_shards_reassemble_burst(struct rte_ip_frag_shards *shards,
+		uint32_t shard_id, struct rte_ip_frag_death_row *dr,
+		struct rte_mbuf **pkts, uint16_t nb_pkts,
+		struct rte_mbuf **out, uint16_t nb_out, uint64_t tms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,454 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <rte_errno.h>
+#include <rte_lcore.h>
+#include <rte_memcpy.h>
+#include <rte_prefetch.h>
+#include <rte_ring.h>
+
+#include "ip_frag_common.h"
+
+/* number of packets parsed, then looked up, at once */
+#define	IP_FRAG_BURST_SIZE	32U
+
+/* how many packets ahead the headers and buckets are prefetched */
+#define	IP_FRAG_PREFETCH_OFFSET	4U
+
+enum {
+	IP_FRAG_PKT_NONE,	/* not a fragment */
+	IP_FRAG_PKT_FRAG,	/* fragment to reassemble */
+	IP_FRAG_PKT_INVALID,	/* fragment to drop */
+};
+
+/* fragment fields, parsed once per packet */
+struct ip_frag_burst_pkt {
+	struct ip_frag_key key;
+	uint32_t sig1;
+	uint32_t sig2;
+	uint16_t ofs;
+	uint16_t len;
+	uint16_t more_frags;
+	uint16_t type;
+};
+
+struct ip_frag_shard {
+	struct rte_ip_frag_tbl *tbl;
+	struct rte_ring *ring;	/* fragments handed over by other shards */
+} __rte_cache_aligned;
+
+struct rte_ip_frag_shards {
+	uint32_t nb_shards;
+	__extension__ struct ip_frag_shard shard[0];
+};
+
+static inline void
+ipv4_frag_burst_parse(struct rte_mbuf *mb, struct ip_frag_burst_pkt *p)
+{
+	const struct rte_ipv4_hdr *ip_hdr;
+	const unaligned_uint64_t *psd;
+	uint16_t flag_offset, ip_ofs, ip_flag;
+	int32_t ip_len;
+
+	ip_hdr = rte_pktmbuf_mtod_offset(mb, const struct rte_ipv4_hdr *,
+		mb->l2_len);
+
+	flag_offset = rte_be_to_cpu_16(ip_hdr->fragment_offset);
+	ip_ofs = (uint16_t)(flag_offset & RTE_IPV4_HDR_OFFSET_MASK);
+	ip_flag = (uint16_t)(flag_offset & RTE_IPV4_HDR_MF_FLAG);
+
+	if (ip_flag == 0 && ip_ofs == 0) {
+		p->type = IP_FRAG_PKT_NONE;
+		return;
+	}
+
+	psd = (const unaligned_uint64_t *)&ip_hdr->src_addr;
+	/* use first 8 bytes only */
+	p->key.src_dst[0] = psd[0];
+	p->key.id = ip_hdr->packet_id;
+	p->key.key_len = IPV4_KEYLEN;
+
+	ip_len = rte_be_to_cpu_16(ip_hdr->total_length) - mb->l3_len;
+
+	p->ofs = (uint16_t)(ip_ofs * RTE_IPV4_HDR_OFFSET_UNITS);
+	p->len = (uint16_t)ip_len;
+	p->more_frags = ip_flag;
+	p->type = (ip_len > 0) ? IP_FRAG_PKT_FRAG : IP_FRAG_PKT_INVALID;
+}
+
+static inline void
+ipv6_frag_burst_parse(struct rte_mbuf *mb, struct ip_frag_burst_pkt *p)
+{
+	const struct rte_ipv6_hdr *ip_hdr;
+	const struct ipv6_extension_fragment *frag_hdr;
+	uint16_t frag_data;
+	int32_t ip_len;
+
+	ip_hdr = rte_pktmbuf_mtod_offset(mb, const struct rte_ipv6_hdr *,
+		mb->l2_len);
+
+	if (ip_hdr->proto != IPPROTO_FRAGMENT) {
+		p->type = IP_FRAG_PKT_NONE;
+		return;
+	}
+
+	frag_hdr = (const struct ipv6_extension_fragment *)(ip_hdr + 1);
+	frag_data = rte_be_to_cpu_16(frag_hdr->frag_data);
+
+	rte_memcpy(&p->key.src_dst[0], ip_hdr->src_addr, 16);
+	rte_memcpy(&p->key.src_dst[2], ip_hdr->dst_addr, 16);
+	p->key.id = frag_hdr->id;
+	p->key.key_len = IPV6_KEYLEN;
+
+	/* only the fragment header is expected in the payload */
+	ip_len = rte_be_to_cpu_16(ip_hdr->payload_len) - sizeof(*frag_hdr);
+
+	p->ofs = (uint16_t)(RTE_IPV6_GET_FO(frag_data) *
+		RTE_IPV6_EHDR_FO_ALIGN);
+	p->len = (uint16_t)ip_len;
+	p->more_frags = RTE_IPV6_GET_MF(frag_data);
+	p->type = (ip_len > 0) ? IP_FRAG_PKT_FRAG : IP_FRAG_PKT_INVALID;
+}
+
+/* parse and hash the fragments of a burst, prefetching the next headers */
+static void
+ip_frag_burst_parse(struct rte_mbuf **pkts, struct ip_frag_burst_pkt *p,
+	uint32_t n)
+{
+	const uint8_t *hdr;
+	uint32_t i;
+
+	for (i = 0; i != RTE_MIN(n, IP_FRAG_PREFETCH_OFFSET); i++)
+		rte_prefetch0(rte_pktmbuf_mtod(pkts[i], void *));
+
+	for (i = 0; i != n; i++) {
+		if (i + IP_FRAG_PREFETCH_OFFSET < n)
+			rte_prefetch0(rte_pktmbuf_mtod(
+				pkts[i + IP_FRAG_PREFETCH_OFFSET], void *));
+
+		hdr = rte_pktmbuf_mtod_offset(pkts[i], const uint8_t *,
+			pkts[i]->l2_len);
+
+		/* the version is in the high nibble of the first byte */
+		switch (hdr[0] >> 4) {
+		case 4:
+			ipv4_frag_burst_parse(pkts[i], &p[i]);
+			break;
+		case 6:
+			ipv6_frag_burst_parse(pkts[i], &p[i]);
+			break;
+		default:
+			p[i].type = IP_FRAG_PKT_NONE;
+			break;
+		}
+
+		if (p[i].type == IP_FRAG_PKT_FRAG)
+			ip_frag_key_hash(&p[i].key, &p[i].sig1, &p[i].sig2);
+	}
+}
+
+/* prefetch the keys of the two buckets a fragment may be found in */
+static inline void
+ip_frag_burst_prefetch(const struct rte_ip_frag_tbl *tbl,
+	const struct ip_frag_burst_pkt *p)
+{
+	struct ip_frag_pkt *b1, *b2;
+	uint32_t i;
+
+	if (p->type != IP_FRAG_PKT_FRAG)
+		return;
+
+	b1 = ip_frag_tbl_pos(tbl, p->sig1);
+	b2 = ip_frag_tbl_pos(tbl, p->sig2);
+
+	for (i = 0; i != tbl->bucket_entries; i++) {
+		rte_prefetch0(&ip_frag_tbl_entry(tbl, b1, i)->key);
+		rte_prefetch0(&ip_frag_tbl_entry(tbl, b2, i)->key);
+	}
+}
+
+/*
+ * Look up and process the parsed fragments of a burst in order. The out
+ * array may be the pkts one, as at most one packet is returned per input.
+ */
+static uint32_t
+ip_frag_burst_reassemble(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf **pkts,
+	const struct ip_frag_burst_pkt *p, uint32_t n,
+	struct rte_mbuf **out, uint64_t tms)
+{
+	struct ip_frag_pkt *fp;
+	struct rte_mbuf *mb;
+	uint32_t i, k;
+
+	for (i = 0; i != RTE_MIN(n, IP_FRAG_PREFETCH_OFFSET); i++)
+		ip_frag_burst_prefetch(tbl, &p[i]);
+
+	k = 0;
+	for (i = 0; i != n; i++) {
+		if (i + IP_FRAG_PREFETCH_OFFSET < n)
+			ip_frag_burst_prefetch(tbl,
+				&p[i + IP_FRAG_PREFETCH_OFFSET]);
+
+		mb = pkts[i];
+
+		switch (p[i].type) {
+		case IP_FRAG_PKT_NONE:
+			out[k++] = mb;
+			break;
+		case IP_FRAG_PKT_INVALID:
+			IP_FRAG_MBUF2DR(dr, mb);
+			break;
+		default:
+			/* try to find/add entry into the fragment's table. */
+			fp = ip_frag_find_sig(tbl, dr, &p[i].key,
+				p[i].sig1, p[i].sig2, tms);
+			if (fp == NULL) {
+				IP_FRAG_MBUF2DR(dr, mb);
+				break;
+			}
+
+			/* process the fragmented packet. */
+			mb = ip_frag_process(tbl, fp, dr, mb, p[i].ofs,
+				p[i].len, p[i].more_frags);
+			ip_frag_inuse(tbl, fp);
+
+			if (mb != NULL)
+				out[k++] = mb;
+			break;
+		}
+	}
+
+	return k;
+}
+
+uint16_t
+rte_ip_frag_reassemble_burst(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf **pkts,
+	uint16_t nb_pkts, uint64_t tms)
+{
+	struct ip_frag_burst_pkt p[IP_FRAG_BURST_SIZE];
+	uint32_t i, k, n;
+
+	k = 0;
+	for (i = 0; i < nb_pkts; i += n) {
+		n = RTE_MIN(nb_pkts - i, IP_FRAG_BURST_SIZE);
+		ip_frag_burst_parse(pkts + i, p, n);
+		k += ip_frag_burst_reassemble(tbl, dr, pkts + i, p, n,
+			pkts + k, tms);
+	}
+
+	return k;
+}
+
+/* shard reassembling the datagrams of a hash value */
+static inline uint32_t
+ip_frag_shard_of(const struct rte_ip_frag_shards *shards, uint32_t sig)
+{
+	/* the high bits, the tables use the low ones */
+	return ((uint64_t)sig * shards->nb_shards) >> 32;
+}
+
+/* enqueue the fragments to their shards, one ring burst per shard */
+static void
+ip_frag_shards_hand_over(struct rte_ip_frag_shards *shards,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf **pkts,
+	uint32_t *dst, uint32_t n)
+{
+	struct rte_mbuf *batch[IP_FRAG_BURST_SIZE];
+	uint32_t i, k, m, d, sent;
+
+	while (n != 0) {
+		d = dst[0];
+		k = 0;
+		m = 0;
+		for (i = 0; i != n; i++) {
+			if (dst[i] == d) {
+				batch[k++] = pkts[i];
+			} else {
+				pkts[m] = pkts[i];
+				dst[m] = dst[i];
+				m++;
+			}
+		}
+
+		sent = rte_ring_enqueue_burst(shards->shard[d].ring,
+			(void **)batch, k, NULL);
+		for (i = sent; i != k; i++)
+			IP_FRAG_MBUF2DR(dr, batch[i]);
+
+		n = m;
+	}
+}
+
+uint16_t
+rte_ip_frag_shards_reassemble_burst(struct rte_ip_frag_shards *shards,
+	uint32_t shard_id, struct rte_ip_frag_death_row *dr,
+	struct rte_mbuf **pkts, uint16_t nb_pkts,
+	struct rte_mbuf **out, uint16_t nb_out, uint64_t tms)
+{
+	struct ip_frag_burst_pkt p[IP_FRAG_BURST_SIZE];
+	struct rte_mbuf *local[IP_FRAG_BURST_SIZE];
+	struct rte_mbuf *remote[IP_FRAG_BURST_SIZE];
+	uint32_t dst[IP_FRAG_BURST_SIZE];
+	struct ip_frag_shard *shard;
+	uint32_t i, j, k, n, d, nb_local, nb_remote, room;
+
+	shard = &shards->shard[shard_id];
+
+	/* fragments of this burst, kept or handed over */
+	k = 0;
+	for (i = 0; i < nb_pkts; i += n) {
+		n = RTE_MIN(nb_pkts - i, IP_FRAG_BURST_SIZE);
+		ip_frag_burst_parse(pkts + i, p, n);
+
+		nb_local = 0;
+		nb_remote = 0;
+		for (j = 0; j != n; j++) {
+			if (p[j].type == IP_FRAG_PKT_FRAG) {
+				d = ip_frag_shard_of(shards, p[j].sig1);
+				if (d != shard_id) {
+					remote[nb_remote] = pkts[i + j];
+					dst[nb_remote] = d;
+					nb_remote++;
+					continue;
+				}
+			}
+
+			local[nb_local] = pkts[i + j];
+			if (nb_local != j)
+				p[nb_local] = p[j];
+			nb_local++;
+		}
+
+		ip_frag_shards_hand_over(shards, dr, remote, dst, nb_remote);
+		k += ip_frag_burst_reassemble(shard->tbl, dr, local, p,
+			nb_local, out + k, tms);
+	}
+
+	/*
+	 * fragments handed over by the other shards, as many as out fits,
+	 * none if the caller gave less room than nb_pkts
+	 */
+	room = (k < nb_out) ? nb_out - k : 0;
+	while (room != 0) {
+		n = rte_ring_sc_dequeue_burst(shard->ring, (void **)local,
+			RTE_MIN(room, IP_FRAG_BURST_SIZE), NULL);
+		if (n == 0)
+			break;
+
+		ip_frag_burst_parse(local, p, n);
+		k += ip_frag_burst_reassemble(shard->tbl, dr, local, p, n,
+			out + k, tms);
+		room -= n;
+	}
+
+	return k;
+}
+
+/* create a set of fragmentation tables */
+struct rte_ip_frag_shards *
+rte_ip_frag_shards_create(const struct rte_ip_frag_shards_params *params)
+{
+	struct rte_ip_frag_shards *shards;
+	char name[RTE_RING_NAMESIZE];
+	uint32_t i;
+	size_t sz;
+	int ret;
+
+	if (params == NULL || params->name == NULL ||
+			params->nb_shards == 0 ||
+			params->nb_shards > RTE_MAX_LCORE ||
+			rte_is_power_of_2(params->ring_size) == 0) {
+		RTE_LOG(ERR, USER1, "%s: invalid input parameter\n", __func__);
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	sz = sizeof(*shards) + params->nb_shards * sizeof(shards->shard[0]);
+	shards = rte_zmalloc_socket(__func__, sz, RTE_CACHE_LINE_SIZE,
+		params->tbl.socket_id);
+	if (shards == NULL) {
+		RTE_LOG(ERR, USER1,
+			"%s: allocation of %zu bytes at socket %d failed\n",
+			__func__, sz, params->tbl.socket_id);
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	shards->nb_shards = params->nb_shards;
+
+	for (i = 0; i != params->nb_shards; i++) {
+		shards->shard[i].tbl =
+			rte_ip_frag_table_create_with_params(&params->tbl);
+		if (shards->shard[i].tbl == NULL)
+			goto error;
+
+		ret = snprintf(name, sizeof(name), "%s_%u", params->name, i);
+		if (ret < 0 || ret >= (int)sizeof(name)) {
+			RTE_LOG(ERR, USER1, "%s: name %s too long\n",
+				__func__, params->name);
+			rte_errno = EINVAL;
+			goto error;
+		}
+
+		/* any shard enqueues, only the owner dequeues */
+		shards->shard[i].ring = rte_ring_create(name,
+			params->ring_size, params->tbl.socket_id,
+			RING_F_SC_DEQ);
+		if (shards->shard[i].ring == NULL) {
+			RTE_LOG(ERR, USER1, "%s: cannot create ring %s\n",
+				__func__, name);
+			goto error;
+		}
+	}
+
+	return shards;
+
+error:
+	ret = rte_errno;
+	rte_ip_frag_shards_destroy(shards);
+	rte_errno = ret;
+	return NULL;
+}
+
+/* delete a set of fragmentation tables */
+void
+rte_ip_frag_shards_destroy(struct rte_ip_frag_shards *shards)
+{
+	struct ip_frag_shard *shard;
+	void *mb;
+	uint32_t i;
+
+	if (shards == NULL)
+		return;
+
+	for (i = 0; i != shards->nb_shards; i++) {
+		shard = &shards->shard[i];
+
+		if (shard->ring != NULL) {
+			while (rte_ring_sc_dequeue(shard->ring, &mb) == 0)
+				rte_pktmbuf_free(mb);
+			rte_ring_free(shard->ring);
+		}
+
+		if (shard->tbl != NULL)
+			rte_ip_frag_table_destroy(shard->tbl);
+	}
+
+	rte_free(shards);
+}
+
+struct rte_ip_frag_tbl *
+rte_ip_frag_shards_get_table(struct rte_ip_frag_shards *shards,
+	uint32_t shard_id)
+{
+	if (shards == NULL || shard_id >= shards->nb_shards)
+		return NULL;
+
+	return shards->shard[shard_id].tbl;
+}
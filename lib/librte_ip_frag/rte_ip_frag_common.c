@@ -5,6 +5,7 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include <rte_errno.h>
 #include <rte_memory.h>
 #include <rte_log.h>
 
@@ -38,48 +39,85 @@ rte_ip_frag_free_death_row(struct rte_ip_frag_death_row *dr,
 
 /* create fragmentation table */
 struct rte_ip_frag_tbl *
-rte_ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
-	uint32_t max_entries, uint64_t max_cycles, int socket_id)
+rte_ip_frag_table_create_with_params(
+	const struct rte_ip_frag_tbl_params *params)
 {
 	struct rte_ip_frag_tbl *tbl;
-	size_t sz;
+	size_t sz, entry_size;
 	uint64_t nb_entries;
+	uint32_t max_frags;
+
+	if (params == NULL) {
+		RTE_LOG(ERR, USER1, "%s: invalid input parameter\n", __func__);
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	max_frags = params->max_frags;
+	if (max_frags == 0)
+		max_frags = IP_MAX_FRAG_NUM;
 
-	nb_entries = rte_align32pow2(bucket_num);
-	nb_entries *= bucket_entries;
+	nb_entries = rte_align32pow2(params->bucket_num);
+	nb_entries *= params->bucket_entries;
 	nb_entries *= IP_FRAG_HASH_FNUM;
 
 	/* check input parameters. */
-	if (rte_is_power_of_2(bucket_entries) == 0 ||
+	if (rte_is_power_of_2(params->bucket_entries) == 0 ||
 			nb_entries > UINT32_MAX || nb_entries == 0 ||
-			nb_entries < max_entries) {
+			nb_entries < params->max_entries ||
+			max_frags < IP_MIN_FRAG_NUM ||
+			max_frags > RTE_IP_FRAG_TBL_MAX_FRAGS) {
 		RTE_LOG(ERR, USER1, "%s: invalid input parameter\n", __func__);
+		rte_errno = EINVAL;
 		return NULL;
 	}
 
-	sz = sizeof (*tbl) + nb_entries * sizeof (tbl->pkt[0]);
+	/* entries only hold max_frags fragments, each in its cache lines */
+	entry_size = RTE_CACHE_LINE_ROUNDUP(offsetof(struct ip_frag_pkt, frags) +
+		max_frags * sizeof(struct ip_frag));
+
+	sz = sizeof (*tbl) + nb_entries * entry_size;
 	if ((tbl = rte_zmalloc_socket(__func__, sz, RTE_CACHE_LINE_SIZE,
-			socket_id)) == NULL) {
+			params->socket_id)) == NULL) {
 		RTE_LOG(ERR, USER1,
 			"%s: allocation of %zu bytes at socket %d failed do\n",
-			__func__, sz, socket_id);
+			__func__, sz, params->socket_id);
+		rte_errno = ENOMEM;
 		return NULL;
 	}
 
 	RTE_LOG(INFO, USER1, "%s: allocated of %zu bytes at socket %d\n",
-		__func__, sz, socket_id);
+		__func__, sz, params->socket_id);
 
-	tbl->max_cycles = max_cycles;
-	tbl->max_entries = max_entries;
+	tbl->max_cycles = params->max_cycles;
+	tbl->max_entries = params->max_entries;
 	tbl->nb_entries = (uint32_t)nb_entries;
-	tbl->nb_buckets = bucket_num;
-	tbl->bucket_entries = bucket_entries;
+	tbl->nb_buckets = params->bucket_num;
+	tbl->bucket_entries = params->bucket_entries;
 	tbl->entry_mask = (tbl->nb_entries - 1) & ~(tbl->bucket_entries  - 1);
+	tbl->entry_size = entry_size;
+	tbl->max_frags = max_frags;
 
 	TAILQ_INIT(&(tbl->lru));
 	return tbl;
 }
 
+struct rte_ip_frag_tbl *
+rte_ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
+	uint32_t max_entries, uint64_t max_cycles, int socket_id)
+{
+	struct rte_ip_frag_tbl_params params = {
+		.bucket_num = bucket_num,
+		.bucket_entries = bucket_entries,
+		.max_entries = max_entries,
+		.max_cycles = max_cycles,
+		.socket_id = socket_id,
+		.max_frags = IP_MAX_FRAG_NUM,
+	};
+
+	return rte_ip_frag_table_create_with_params(&params);
+}
+
 /* delete fragmentation table */
 void
 rte_ip_frag_table_destroy(struct rte_ip_frag_tbl *tbl)
@@ -38,6 +38,7 @@ ipv6_frag_reassemble(struct ip_frag_pkt *fp)
 	uint32_t i, n, ofs, first_len;
 	uint32_t last_len, move_len, payload_len;
 	uint32_t curr_idx = 0;
+	struct ip_frag *frags = ip_frag_pkt_frags(fp);
 
 	first_len = fp->frags[IP_FIRST_FRAG_IDX].len;
 	n = fp->last_idx - 1;
@@ -57,22 +58,22 @@ ipv6_frag_reassemble(struct ip_frag_pkt *fp)
 		for (i = n; i != IP_FIRST_FRAG_IDX && ofs != first_len; i--) {
 
 			/* previous fragment found. */
-			if (fp->frags[i].ofs + fp->frags[i].len == ofs) {
+			if (frags[i].ofs + frags[i].len == ofs) {
 
 				RTE_ASSERT(curr_idx != i);
 
 				/* adjust start of the last fragment data. */
 				rte_pktmbuf_adj(m,
 					(uint16_t)(m->l2_len + m->l3_len));
-				rte_pktmbuf_chain(fp->frags[i].mb, m);
+				rte_pktmbuf_chain(frags[i].mb, m);
 
 				/* this mbuf should not be accessed directly */
-				fp->frags[curr_idx].mb = NULL;
+				frags[curr_idx].mb = NULL;
 				curr_idx = i;
 
 				/* update our last fragment and offset. */
-				m = fp->frags[i].mb;
-				ofs = fp->frags[i].ofs;
+				m = frags[i].mb;
+				ofs = frags[i].ofs;
 			}
 		}
 
@@ -85,7 +86,7 @@ ipv6_frag_reassemble(struct ip_frag_pkt *fp)
 	/* chain with the first fragment. */
 	rte_pktmbuf_adj(m, (uint16_t)(m->l2_len + m->l3_len));
 	rte_pktmbuf_chain(fp->frags[IP_FIRST_FRAG_IDX].mb, m);
-	fp->frags[curr_idx].mb = NULL;
+	frags[curr_idx].mb = NULL;
 	m = fp->frags[IP_FIRST_FRAG_IDX].mb;
 	fp->frags[IP_FIRST_FRAG_IDX].mb = NULL;
 
@@ -195,7 +196,7 @@ rte_ipv6_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 
 
 	/* process the fragmented packet. */
-	mb = ip_frag_process(fp, dr, mb, ip_ofs, ip_len,
+	mb = ip_frag_process(tbl, fp, dr, mb, ip_ofs, ip_len,
 			MORE_FRAGS(frag_hdr->frag_data));
 	ip_frag_inuse(tbl, fp);
 
@@ -15,6 +15,8 @@
 #include <rte_metrics.h>
 #include <rte_memzone.h>
 #include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_telemetry.h>
 
 #include "rte_latencystats.h"
 
@@ -22,7 +24,7 @@
 #define NS_PER_SEC 1E9
 
 /** Clock cycles per nano second */
-static uint64_t
+static double
 latencystat_cycles_per_ns(void)
 {
 	return rte_get_timer_hz() / NS_PER_SEC;
@@ -31,22 +33,53 @@ latencystat_cycles_per_ns(void)
 /* Macros for printing using RTE_LOG */
 #define RTE_LOGTYPE_LATENCY_STATS RTE_LOGTYPE_USER1
 
+/*
+ * Latencies are recorded in log-linear histograms: latencies lower than
+ * LAT_HIST_SUB_BUCKETS cycles have one bucket each, and each following
+ * power of two range is split in LAT_HIST_SUB_BUCKETS buckets, so that the
+ * bucket width is at most 1/LAT_HIST_SUB_BUCKETS of the latency.
+ */
+#define LAT_HIST_SUB_BITS 5
+#define LAT_HIST_SUB_BUCKETS (1 << LAT_HIST_SUB_BITS)
+/* Latencies of 2^LAT_HIST_MAX_BITS cycles or more share the last bucket */
+#define LAT_HIST_MAX_BITS 40
+#define LAT_HIST_BUCKETS \
+	((LAT_HIST_MAX_BITS - LAT_HIST_SUB_BITS + 1) << LAT_HIST_SUB_BITS)
+
 static const char *MZ_RTE_LATENCY_STATS = "rte_latencystats";
 static int latency_stats_index;
 static uint64_t samp_intvl;
-static uint64_t timer_tsc;
-static uint64_t prev_tsc;
+
+/*
+ * Latency samples of one Tx queue. A Tx queue is used by one lcore at a
+ * time, so its histogram has a single writer and is updated without lock.
+ * Readers merge the histograms of all queues.
+ */
+struct latency_hist {
+	uint64_t count; /**< Number of samples */
+	uint64_t sum; /**< Sum of latencies in cycles */
+	uint64_t min; /**< Minimum latency in cycles */
+	uint64_t max; /**< Maximum latency in cycles */
+	float jitter; /**< Latency variation in cycles */
+	float prev_latency; /**< Latency of the previous sample */
+	uint64_t buckets[LAT_HIST_BUCKETS];
+} __rte_cache_aligned;
 
 struct rte_latency_stats {
-	float min_latency; /**< Minimum latency in nano seconds */
-	float avg_latency; /**< Average latency in nano seconds */
-	float max_latency; /**< Maximum latency in nano seconds */
-	float jitter; /** Latency variation */
-	rte_spinlock_t lock; /** Latency calculation lock */
+	uint32_t nb_hists; /**< Number of Tx queue histograms */
+	struct latency_hist hists[]; /**< Tx queue histograms */
 };
 
 static struct rte_latency_stats *glob_stats;
 
+/* Time stamping state of one Rx queue */
+struct latency_sampler {
+	uint64_t prev_tsc;
+	uint64_t timer_tsc;
+} __rte_cache_aligned;
+
+static struct latency_sampler *samplers;
+
 struct rxtx_cbs {
 	const struct rte_eth_rxtx_callback *cb;
 };
@@ -54,35 +87,209 @@ struct rxtx_cbs {
 static struct rxtx_cbs rx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
 static struct rxtx_cbs tx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
 
+/* Latency statistics of all queues, in nano seconds */
+struct latency_stats_values {
+	uint64_t min_latency;
+	uint64_t avg_latency;
+	uint64_t max_latency;
+	uint64_t jitter;
+	uint64_t p50_latency;
+	uint64_t p90_latency;
+	uint64_t p99_latency;
+	uint64_t p999_latency;
+	uint64_t p9999_latency;
+};
+
 struct latency_stats_nameoff {
 	char name[RTE_ETH_XSTATS_NAME_SIZE];
 	unsigned int offset;
 };
 
 static const struct latency_stats_nameoff lat_stats_strings[] = {
-	{"min_latency_ns", offsetof(struct rte_latency_stats, min_latency)},
-	{"avg_latency_ns", offsetof(struct rte_latency_stats, avg_latency)},
-	{"max_latency_ns", offsetof(struct rte_latency_stats, max_latency)},
-	{"jitter_ns", offsetof(struct rte_latency_stats, jitter)},
+	{"min_latency_ns", offsetof(struct latency_stats_values, min_latency)},
+	{"avg_latency_ns", offsetof(struct latency_stats_values, avg_latency)},
+	{"max_latency_ns", offsetof(struct latency_stats_values, max_latency)},
+	{"jitter_ns", offsetof(struct latency_stats_values, jitter)},
+	{"p50_latency_ns", offsetof(struct latency_stats_values, p50_latency)},
+	{"p90_latency_ns", offsetof(struct latency_stats_values, p90_latency)},
+	{"p99_latency_ns", offsetof(struct latency_stats_values, p99_latency)},
+	{"p999_latency_ns",
+		offsetof(struct latency_stats_values, p999_latency)},
+	{"p9999_latency_ns",
+		offsetof(struct latency_stats_values, p9999_latency)},
 };
 
 #define NUM_LATENCY_STATS (sizeof(lat_stats_strings) / \
 				sizeof(lat_stats_strings[0]))
 
+/* Percentiles in parts per million, in increasing order */
+static const struct {
+	uint32_t ppm;
+	unsigned int offset;
+} lat_percentiles[] = {
+	{500000, offsetof(struct latency_stats_values, p50_latency)},
+	{900000, offsetof(struct latency_stats_values, p90_latency)},
+	{990000, offsetof(struct latency_stats_values, p99_latency)},
+	{999000, offsetof(struct latency_stats_values, p999_latency)},
+	{999900, offsetof(struct latency_stats_values, p9999_latency)},
+};
+
+static inline uint32_t
+latency_hist_index(uint64_t latency)
+{
+	uint32_t msb, shift;
+
+	if (latency < LAT_HIST_SUB_BUCKETS)
+		return latency;
+
+	msb = 63 - __builtin_clzll(latency);
+	if (msb >= LAT_HIST_MAX_BITS)
+		return LAT_HIST_BUCKETS - 1;
+
+	shift = msb - LAT_HIST_SUB_BITS;
+	return ((shift + 1) << LAT_HIST_SUB_BITS) +
+		(latency >> shift) - LAT_HIST_SUB_BUCKETS;
+}
+
+/* Highest latency in cycles recorded in a histogram bucket */
+static uint64_t
+latency_hist_bucket_max(uint32_t idx)
+{
+	uint32_t shift;
+
+	if (idx < LAT_HIST_SUB_BUCKETS)
+		return idx;
+
+	shift = (idx >> LAT_HIST_SUB_BITS) - 1;
+	return (((uint64_t)LAT_HIST_SUB_BUCKETS +
+		(idx & (LAT_HIST_SUB_BUCKETS - 1))) << shift) +
+		(1ULL << shift) - 1;
+}
+
+static inline void
+latency_hist_add(struct latency_hist *hist, uint64_t latency)
+{
+	uint32_t idx = latency_hist_index(latency);
+	float diff;
+
+	/*
+	 * The jitter is calculated as statistical mean of interpacket
+	 * delay variation. The "jitter estimate" is computed by taking
+	 * the absolute values of the ipdv sequence and applying an
+	 * exponential filter with parameter 1/16 to generate the
+	 * estimate. i.e J=J+(|D(i-1,i)|-J)/16. Where J is jitter,
+	 * D(i-1,i) is difference in latency of two consecutive packets
+	 * i-1 and i.
+	 * Reference: Calculated as per RFC 5481, sec 4.1,
+	 * RFC 3393 sec 4.5, RFC 1889 sec.
+	 */
+	diff = fabsf(hist->prev_latency - (float)latency);
+	hist->jitter += (diff - hist->jitter) / 16;
+	hist->prev_latency = latency;
+
+	/* only this lcore writes, stores just need to be atomic for readers */
+	if (hist->count == 0 || latency < hist->min)
+		__atomic_store_n(&hist->min, latency, __ATOMIC_RELAXED);
+	if (latency > hist->max)
+		__atomic_store_n(&hist->max, latency, __ATOMIC_RELAXED);
+	__atomic_store_n(&hist->sum, hist->sum + latency, __ATOMIC_RELAXED);
+	__atomic_store_n(&hist->buckets[idx], hist->buckets[idx] + 1,
+			__ATOMIC_RELAXED);
+	__atomic_store_n(&hist->count, hist->count + 1, __ATOMIC_RELEASE);
+}
+
+/* Merge the histograms of all queues and compute the statistics */
+static void
+latency_stats_calc(const struct rte_latency_stats *stats,
+		struct latency_stats_values *v)
+{
+	uint64_t buckets[LAT_HIST_BUCKETS];
+	const struct latency_hist *hist;
+	double cycles_per_ns = latencystat_cycles_per_ns();
+	uint64_t count = 0, sum = 0, min = UINT64_MAX, max = 0;
+	uint64_t n, total, rank, cur;
+	double jitter = 0;
+	unsigned int i, j;
+
+	memset(v, 0, sizeof(*v));
+	memset(buckets, 0, sizeof(buckets));
+	for (i = 0; i < stats->nb_hists; i++) {
+		hist = &stats->hists[i];
+		n = __atomic_load_n(&hist->count, __ATOMIC_ACQUIRE);
+		if (n == 0)
+			continue;
+		count += n;
+		sum += __atomic_load_n(&hist->sum, __ATOMIC_RELAXED);
+		min = RTE_MIN(min, __atomic_load_n(&hist->min,
+					__ATOMIC_RELAXED));
+		max = RTE_MAX(max, __atomic_load_n(&hist->max,
+					__ATOMIC_RELAXED));
+		/* jitter of the queues weighted by their sample count */
+		jitter += (double)hist->jitter * n;
+		for (j = 0; j < LAT_HIST_BUCKETS; j++)
+			buckets[j] += __atomic_load_n(&hist->buckets[j],
+					__ATOMIC_RELAXED);
+	}
+	if (count == 0)
+		return;
+
+	v->min_latency = floor(min / cycles_per_ns);
+	v->avg_latency = floor(sum / count / cycles_per_ns);
+	v->max_latency = floor(max / cycles_per_ns);
+	v->jitter = floor(jitter / count / cycles_per_ns);
+
+	/* the buckets may have been updated after the sample counts */
+	total = 0;
+	for (j = 0; j < LAT_HIST_BUCKETS; j++)
+		total += buckets[j];
+
+	cur = 0;
+	j = 0;
+	for (i = 0; i < RTE_DIM(lat_percentiles); i++) {
+		rank = (total * lat_percentiles[i].ppm + 999999) / 1000000;
+		while (j < LAT_HIST_BUCKETS - 1 && cur + buckets[j] < rank)
+			cur += buckets[j++];
+		*(uint64_t *)RTE_PTR_ADD(v, lat_percentiles[i].offset) =
+			floor(RTE_MIN(latency_hist_bucket_max(j), max) /
+				cycles_per_ns);
+	}
+}
+
+static struct rte_latency_stats *
+latency_stats_lookup(void)
+{
+	const struct rte_memzone *mz;
+
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
+		mz = rte_memzone_lookup(MZ_RTE_LATENCY_STATS);
+		if (mz == NULL) {
+			RTE_LOG(ERR, LATENCY_STATS,
+				"Latency stats memzone not found\n");
+			return NULL;
+		}
+		glob_stats = mz->addr;
+	}
+
+	return glob_stats;
+}
+
 int32_t
 rte_latencystats_update(void)
 {
 	unsigned int i;
-	float *stats_ptr = NULL;
+	struct latency_stats_values v;
 	uint64_t values[NUM_LATENCY_STATS] = {0};
+	struct rte_latency_stats *stats;
 	int ret;
 
-	for (i = 0; i < NUM_LATENCY_STATS; i++) {
-		stats_ptr = RTE_PTR_ADD(glob_stats,
+	stats = latency_stats_lookup();
+	if (stats == NULL)
+		return -ENOMEM;
+
+	latency_stats_calc(stats, &v);
+	for (i = 0; i < NUM_LATENCY_STATS; i++)
+		values[i] = *(uint64_t *)RTE_PTR_ADD(&v,
 				lat_stats_strings[i].offset);
-		values[i] = (uint64_t)floor((*stats_ptr)/
-				latencystat_cycles_per_ns());
-	}
 
 	ret = rte_metrics_update_values(RTE_METRICS_GLOBAL,
 					latency_stats_index,
@@ -97,14 +304,13 @@ static void
 rte_latencystats_fill_values(struct rte_metric_value *values)
 {
 	unsigned int i;
-	float *stats_ptr = NULL;
+	struct latency_stats_values v;
 
+	latency_stats_calc(glob_stats, &v);
 	for (i = 0; i < NUM_LATENCY_STATS; i++) {
-		stats_ptr = RTE_PTR_ADD(glob_stats,
-				lat_stats_strings[i].offset);
 		values[i].key = i;
-		values[i].value = (uint64_t)floor((*stats_ptr)/
-						latencystat_cycles_per_ns());
+		values[i].value = *(uint64_t *)RTE_PTR_ADD(&v,
+				lat_stats_strings[i].offset);
 	}
 }
 
@@ -114,27 +320,28 @@ add_time_stamps(uint16_t pid __rte_unused,
 		struct rte_mbuf **pkts,
 		uint16_t nb_pkts,
 		uint16_t max_pkts __rte_unused,
-		void *user_cb __rte_unused)
+		void *user_cb)
 {
+	struct latency_sampler *sampler = user_cb;
 	unsigned int i;
 	uint64_t diff_tsc, now;
 
 	/*
 	 * For every sample interval,
-	 * time stamp is marked on one received packet.
+	 * time stamp is marked on one received packet of the queue.
 	 */
 	now = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
-		diff_tsc = now - prev_tsc;
-		timer_tsc += diff_tsc;
+		diff_tsc = now - sampler->prev_tsc;
+		sampler->timer_tsc += diff_tsc;
 
 		if ((pkts[i]->ol_flags & PKT_RX_TIMESTAMP) == 0
-				&& (timer_tsc >= samp_intvl)) {
+				&& (sampler->timer_tsc >= samp_intvl)) {
 			pkts[i]->timestamp = now;
 			pkts[i]->ol_flags |= PKT_RX_TIMESTAMP;
-			timer_tsc = 0;
+			sampler->timer_tsc = 0;
 		}
-		prev_tsc = now;
+		sampler->prev_tsc = now;
 		now = rte_rdtsc();
 	}
 
@@ -146,67 +353,55 @@ calc_latency(uint16_t pid __rte_unused,
 		uint16_t qid __rte_unused,
 		struct rte_mbuf **pkts,
 		uint16_t nb_pkts,
-		void *_ __rte_unused)
+		void *user_cb)
 {
-	unsigned int i, cnt = 0;
+	struct latency_hist *hist = user_cb;
+	unsigned int i;
 	uint64_t now;
-	float latency[nb_pkts];
-	static float prev_latency;
-	/*
-	 * Alpha represents degree of weighting decrease in EWMA,
-	 * a constant smoothing factor between 0 and 1. The value
-	 * is used below for measuring average latency.
-	 */
-	const float alpha = 0.2;
 
 	now = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
-		if (pkts[i]->ol_flags & PKT_RX_TIMESTAMP)
-			latency[cnt++] = now - pkts[i]->timestamp;
-	}
-
-	rte_spinlock_lock(&glob_stats->lock);
-	for (i = 0; i < cnt; i++) {
-		/*
-		 * The jitter is calculated as statistical mean of interpacket
-		 * delay variation. The "jitter estimate" is computed by taking
-		 * the absolute values of the ipdv sequence and applying an
-		 * exponential filter with parameter 1/16 to generate the
-		 * estimate. i.e J=J+(|D(i-1,i)|-J)/16. Where J is jitter,
-		 * D(i-1,i) is difference in latency of two consecutive packets
-		 * i-1 and i.
-		 * Reference: Calculated as per RFC 5481, sec 4.1,
-		 * RFC 3393 sec 4.5, RFC 1889 sec.
-		 */
-		glob_stats->jitter +=  (fabsf(prev_latency - latency[i])
-					- glob_stats->jitter)/16;
-		if (glob_stats->min_latency == 0)
-			glob_stats->min_latency = latency[i];
-		else if (latency[i] < glob_stats->min_latency)
-			glob_stats->min_latency = latency[i];
-		else if (latency[i] > glob_stats->max_latency)
-			glob_stats->max_latency = latency[i];
-		/*
-		 * The average latency is measured using exponential moving
-		 * average, i.e. using EWMA
-		 * https://en.wikipedia.org/wiki/Moving_average
-		 */
-		glob_stats->avg_latency +=
-			alpha * (latency[i] - glob_stats->avg_latency);
-		prev_latency = latency[i];
+		if ((pkts[i]->ol_flags & PKT_RX_TIMESTAMP) == 0)
+			continue;
+		/* the packet may have been stamped by an lcore ahead of us */
+		latency_hist_add(hist, now > pkts[i]->timestamp ?
+				now - pkts[i]->timestamp : 0);
 	}
-	rte_spinlock_unlock(&glob_stats->lock);
 
 	return nb_pkts;
 }
 
+static int
+latencystats_handle_info(const char *cmd __rte_unused,
+		const char *params __rte_unused,
+		struct rte_tel_data *d)
+{
+	struct rte_latency_stats *stats;
+	struct latency_stats_values v;
+	unsigned int i;
+
+	stats = latency_stats_lookup();
+	if (stats == NULL)
+		return -1;
+
+	latency_stats_calc(stats, &v);
+	rte_tel_data_start_dict(d);
+	for (i = 0; i < NUM_LATENCY_STATS; i++)
+		rte_tel_data_add_dict_u64(d, lat_stats_strings[i].name,
+			*(uint64_t *)RTE_PTR_ADD(&v,
+				lat_stats_strings[i].offset));
+
+	return 0;
+}
+
 int
 rte_latencystats_init(uint64_t app_samp_intvl,
-		rte_latency_stats_flow_type_fn user_cb)
+		rte_latency_stats_flow_type_fn user_cb __rte_unused)
 {
 	unsigned int i;
 	uint16_t pid;
 	uint16_t qid;
+	uint32_t nb_rxq = 0, nb_txq = 0;
 	struct rxtx_cbs *cbs = NULL;
 	const char *ptr_strings[NUM_LATENCY_STATS] = {0};
 	const struct rte_memzone *mz = NULL;
@@ -216,8 +411,19 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 	if (rte_memzone_lookup(MZ_RTE_LATENCY_STATS))
 		return -EEXIST;
 
+	/** Count the queues which get a histogram or a time stamper */
+	RTE_ETH_FOREACH_DEV(pid) {
+		struct rte_eth_dev_info dev_info;
+
+		if (rte_eth_dev_info_get(pid, &dev_info) != 0)
+			continue;
+		nb_rxq += dev_info.nb_rx_queues;
+		nb_txq += dev_info.nb_tx_queues;
+	}
+
 	/** Allocate stats in shared memory fo multi process support */
-	mz = rte_memzone_reserve(MZ_RTE_LATENCY_STATS, sizeof(*glob_stats),
+	mz = rte_memzone_reserve(MZ_RTE_LATENCY_STATS, sizeof(*glob_stats) +
+					nb_txq * sizeof(glob_stats->hists[0]),
 					rte_socket_id(), flags);
 	if (mz == NULL) {
 		RTE_LOG(ERR, LATENCY_STATS, "Cannot reserve memory: %s:%d\n",
@@ -226,9 +432,21 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 	}
 
 	glob_stats = mz->addr;
-	rte_spinlock_init(&glob_stats->lock);
+	memset(glob_stats, 0, mz->len);
+	glob_stats->nb_hists = nb_txq;
 	samp_intvl = app_samp_intvl * latencystat_cycles_per_ns();
 
+	samplers = rte_zmalloc("latency_samplers",
+			RTE_MAX(nb_rxq, 1U) * sizeof(*samplers),
+			RTE_CACHE_LINE_SIZE);
+	if (samplers == NULL) {
+		RTE_LOG(ERR, LATENCY_STATS, "Cannot reserve memory: %s:%d\n",
+			__func__, __LINE__);
+		rte_memzone_free(mz);
+		glob_stats = NULL;
+		return -ENOMEM;
+	}
+
 	/** Register latency stats with stats library */
 	for (i = 0; i < NUM_LATENCY_STATS; i++)
 		ptr_strings[i] = lat_stats_strings[i].name;
@@ -242,6 +460,8 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 	}
 
 	/** Register Rx/Tx callbacks */
+	nb_rxq = 0;
+	nb_txq = 0;
 	RTE_ETH_FOREACH_DEV(pid) {
 		struct rte_eth_dev_info dev_info;
 
@@ -257,7 +477,7 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 		for (qid = 0; qid < dev_info.nb_rx_queues; qid++) {
 			cbs = &rx_cbs[pid][qid];
 			cbs->cb = rte_eth_add_first_rx_callback(pid, qid,
-					add_time_stamps, user_cb);
+					add_time_stamps, &samplers[nb_rxq++]);
 			if (!cbs->cb)
 				RTE_LOG(INFO, LATENCY_STATS, "Failed to "
 					"register Rx callback for pid=%d, "
@@ -266,7 +486,7 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 		for (qid = 0; qid < dev_info.nb_tx_queues; qid++) {
 			cbs = &tx_cbs[pid][qid];
 			cbs->cb =  rte_eth_add_tx_callback(pid, qid,
-					calc_latency, user_cb);
+					calc_latency, &glob_stats->hists[nb_txq++]);
 			if (!cbs->cb)
 				RTE_LOG(INFO, LATENCY_STATS, "Failed to "
 					"register Tx callback for pid=%d, "
@@ -316,10 +536,14 @@ rte_latencystats_uninit(void)
 		}
 	}
 
+	rte_free(samplers);
+	samplers = NULL;
+
 	/* free up the memzone */
 	mz = rte_memzone_lookup(MZ_RTE_LATENCY_STATS);
 	if (mz)
 		rte_memzone_free(mz);
+	glob_stats = NULL;
 
 	return 0;
 }
@@ -345,19 +569,17 @@ rte_latencystats_get(struct rte_metric_value *values, uint16_t size)
 	if (size < NUM_LATENCY_STATS || values == NULL)
 		return NUM_LATENCY_STATS;
 
-	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
-		const struct rte_memzone *mz;
-		mz = rte_memzone_lookup(MZ_RTE_LATENCY_STATS);
-		if (mz == NULL) {
-			RTE_LOG(ERR, LATENCY_STATS,
-				"Latency stats memzone not found\n");
-			return -ENOMEM;
-		}
-		glob_stats =  mz->addr;
-	}
+	if (latency_stats_lookup() == NULL)
+		return -ENOMEM;
 
 	/* Retrieve latency stats */
 	rte_latencystats_fill_values(values);
 
 	return NUM_LATENCY_STATS;
 }
+
+RTE_INIT(latencystats_init_telemetry)
+{
+	rte_telemetry_register_cmd("/latencystats", latencystats_handle_info,
+		"Returns the latency stats of all ports and queues. Takes no parameters");
+}
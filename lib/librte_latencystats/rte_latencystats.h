@@ -10,6 +10,18 @@
  * RTE latency stats
  *
  * library to provide application and flow based latency stats.
+ *
+ * One received packet per sample interval and Rx queue is time stamped,
+ * and its latency is recorded when it is transmitted, in a log-linear
+ * histogram of the Tx queue. As a Tx queue is only used by one lcore at a
+ * time, no lock is taken on the data path. The histograms of all queues
+ * are merged when the statistics are read, giving the minimum, average and
+ * maximum latency, the jitter, and the 50th, 90th, 99th, 99.9th and
+ * 99.99th latency percentiles, in nano seconds. Percentiles are accurate
+ * to about 3%.
+ *
+ * The statistics are exposed through the rte_metrics library and the
+ * "/latencystats" telemetry command.
  */
 
 #include <stdint.h>
@@ -42,6 +54,7 @@ typedef uint16_t (*rte_latency_stats_flow_type_fn)(struct rte_mbuf *pkt,
 
 /**
  *  Registers Rx/Tx callbacks for each active port, queue.
+ *  Queues configured later are not measured.
  *
  * @param samp_intvl
  *  Sampling time period in nano seconds, at which packet
@@ -9,6 +9,8 @@
 #include <rte_log.h>
 #include <rte_errno.h>
 #include <rte_string_fns.h>
+#include <rte_pause.h>
+#include <rte_bpf.h>
 
 #include "rte_pdump.h"
 
@@ -43,7 +45,8 @@ struct pdump_request {
 			uint16_t queue;
 			struct rte_ring *ring;
 			struct rte_mempool *mp;
-			void *filter;
+			const struct rte_bpf_prm *prm;
+			uint32_t snaplen;
 		} en_v1;
 		struct disable_v1 {
 			char device[DEVICE_ID_SIZE];
@@ -65,10 +68,115 @@ static struct pdump_rxtx_cbs {
 	struct rte_ring *ring;
 	struct rte_mempool *mp;
 	const struct rte_eth_rxtx_callback *cb;
-	void *filter;
+	struct rte_bpf *filter;
+	struct rte_bpf_jit jit;
+	struct rte_bpf_jit_burst jit_burst;
+	/* filter takes the packet data instead of the mbuf */
+	uint32_t filter_data;
+	uint32_t snaplen;
+	uint32_t zero_copy;
+	/* odd while the callback runs, see pdump_cb_wait() */
+	uint32_t use_count;
 } rx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT],
 tx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
 
+static inline void
+pdump_cb_hold(struct pdump_rxtx_cbs *cbs)
+{
+	__atomic_store_n(&cbs->use_count, cbs->use_count + 1,
+			__ATOMIC_RELAXED);
+	/* keep the callback accesses after the use count update */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void
+pdump_cb_release(struct pdump_rxtx_cbs *cbs)
+{
+	__atomic_store_n(&cbs->use_count, cbs->use_count + 1,
+			__ATOMIC_RELEASE);
+}
+
+/*
+ * Wait for a data path thread which was running the callback when it
+ * was removed to leave it, so that its filter can be freed.
+ */
+static void
+pdump_cb_wait(struct pdump_rxtx_cbs *cbs)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	while ((__atomic_load_n(&cbs->use_count, __ATOMIC_ACQUIRE) & 1) != 0)
+		rte_pause();
+}
+
+/*
+ * Run the capture filter on a burst, rc[i] is zero for the packets
+ * which don't match it.
+ */
+static inline void
+pdump_filter(const struct pdump_rxtx_cbs *cbs, const struct rte_bpf *filter,
+	struct rte_mbuf **pkts, uint64_t rc[], uint16_t nb_pkts)
+{
+	void *ctx[nb_pkts];
+	uint64_t (*jit_burst)(void *ctx[], uint32_t num);
+	uint64_t (*jit)(void *ctx);
+	uint64_t msk;
+	uint16_t i, j, n;
+
+	for (i = 0; i < nb_pkts; i++)
+		ctx[i] = cbs->filter_data ?
+			rte_pktmbuf_mtod(pkts[i], void *) : pkts[i];
+
+	/*
+	 * The JIT code may be cleared while the filter is being released,
+	 * the filter itself stays valid until this callback returns.
+	 */
+	jit_burst = __atomic_load_n(&cbs->jit_burst.func, __ATOMIC_RELAXED);
+	jit = __atomic_load_n(&cbs->jit.func, __ATOMIC_RELAXED);
+
+	if (jit_burst != NULL) {
+		for (i = 0; i < nb_pkts; i += n) {
+			n = RTE_MIN(nb_pkts - i, RTE_BPF_JIT_BURST_MAX);
+			msk = jit_burst(ctx + i, n);
+			for (j = 0; j < n; j++)
+				rc[i + j] = (msk >> j) & 1;
+		}
+	} else if (jit != NULL) {
+		for (i = 0; i < nb_pkts; i++)
+			rc[i] = jit(ctx[i]);
+	} else
+		rte_bpf_exec_burst(filter, ctx, rc, nb_pkts);
+}
+
+/*
+ * Clone the first snaplen bytes of a packet. The clone references the
+ * packet data through the mbuf reference count instead of copying it.
+ */
+static inline struct rte_mbuf *
+pdump_clone(struct rte_mbuf *md, struct rte_mempool *mp, uint32_t snaplen)
+{
+	struct rte_mbuf *mc = NULL, *mi, **prev = &mc;
+	uint32_t pkt_len = 0;
+	uint16_t nb_segs = 0;
+
+	for (; md != NULL && pkt_len < snaplen; md = md->next) {
+		mi = rte_pktmbuf_alloc(mp);
+		if (unlikely(mi == NULL)) {
+			rte_pktmbuf_free(mc);
+			return NULL;
+		}
+		rte_pktmbuf_attach(mi, md);
+		mi->data_len = RTE_MIN((uint32_t)md->data_len,
+				snaplen - pkt_len);
+		pkt_len += mi->data_len;
+		nb_segs++;
+		*prev = mi;
+		prev = &mi->next;
+	}
+
+	mc->pkt_len = pkt_len;
+	mc->nb_segs = nb_segs;
+	return mc;
+}
 
 static inline void
 pdump_copy(struct rte_mbuf **pkts, uint16_t nb_pkts, void *user_params)
@@ -77,16 +185,28 @@ pdump_copy(struct rte_mbuf **pkts, uint16_t nb_pkts, void *user_params)
 	int ring_enq;
 	uint16_t d_pkts = 0;
 	struct rte_mbuf *dup_bufs[nb_pkts];
+	uint64_t rc[nb_pkts];
 	struct pdump_rxtx_cbs *cbs;
 	struct rte_ring *ring;
 	struct rte_mempool *mp;
+	struct rte_bpf *filter;
 	struct rte_mbuf *p;
 
 	cbs  = user_params;
+	pdump_cb_hold(cbs);
 	ring = cbs->ring;
 	mp = cbs->mp;
+	/* read once, the filter may be cleared concurrently */
+	filter = __atomic_load_n(&cbs->filter, __ATOMIC_RELAXED);
+	if (filter != NULL)
+		pdump_filter(cbs, filter, pkts, rc, nb_pkts);
 	for (i = 0; i < nb_pkts; i++) {
-		p = rte_pktmbuf_copy(pkts[i], mp, 0, UINT32_MAX);
+		if (filter != NULL && rc[i] == 0)
+			continue;
+		if (cbs->zero_copy)
+			p = pdump_clone(pkts[i], mp, cbs->snaplen);
+		else
+			p = rte_pktmbuf_copy(pkts[i], mp, 0, cbs->snaplen);
 		if (p)
 			dup_bufs[d_pkts++] = p;
 	}
@@ -99,6 +219,7 @@ pdump_copy(struct rte_mbuf **pkts, uint16_t nb_pkts, void *user_params)
 			rte_pktmbuf_free(dup_bufs[ring_enq]);
 		} while (++ring_enq < d_pkts);
 	}
+	pdump_cb_release(cbs);
 }
 
 static uint16_t
@@ -119,13 +240,61 @@ pdump_tx(uint16_t port __rte_unused, uint16_t qidx __rte_unused,
 	return nb_pkts;
 }
 
+static int
+pdump_cbs_setup(struct pdump_rxtx_cbs *cbs, struct rte_ring *ring,
+		struct rte_mempool *mp, const struct rte_bpf_prm *prm,
+		uint32_t snaplen, uint32_t zero_copy)
+{
+	cbs->ring = ring;
+	cbs->mp = mp;
+	cbs->snaplen = snaplen;
+	cbs->zero_copy = zero_copy;
+	cbs->filter = NULL;
+	memset(&cbs->jit, 0, sizeof(cbs->jit));
+	memset(&cbs->jit_burst, 0, sizeof(cbs->jit_burst));
+	if (prm == NULL)
+		return 0;
+
+	cbs->filter = rte_bpf_load(prm);
+	if (cbs->filter == NULL) {
+		PDUMP_LOG(ERR, "failed to load filter, errno=%d\n",
+			rte_errno);
+		return -rte_errno;
+	}
+	rte_bpf_get_jit(cbs->filter, &cbs->jit);
+	rte_bpf_get_jit_burst(cbs->filter, &cbs->jit_burst);
+	cbs->filter_data = (prm->prog_arg.type == RTE_BPF_ARG_PTR);
+
+	return 0;
+}
+
+/*
+ * A data path thread may have fetched the callback before it was removed
+ * without having updated the use count yet. The filter is cleared first,
+ * so such a thread either sees it cleared, or is waited for before the
+ * filter is destroyed.
+ */
+static void
+pdump_cbs_release(struct pdump_rxtx_cbs *cbs)
+{
+	struct rte_bpf *filter = cbs->filter;
+
+	__atomic_store_n(&cbs->filter, NULL, __ATOMIC_RELAXED);
+	__atomic_store_n(&cbs->jit_burst.func, NULL, __ATOMIC_RELAXED);
+	__atomic_store_n(&cbs->jit.func, NULL, __ATOMIC_RELAXED);
+	pdump_cb_wait(cbs);
+	rte_bpf_destroy(filter);
+}
+
 static int
 pdump_register_rx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 				struct rte_ring *ring, struct rte_mempool *mp,
-				uint16_t operation)
+				const struct rte_bpf_prm *prm, uint32_t snaplen,
+				uint32_t zero_copy, uint16_t operation)
 {
 	uint16_t qid;
 	struct pdump_rxtx_cbs *cbs = NULL;
+	int ret;
 
 	qid = (queue == RTE_PDUMP_ALL_QUEUES) ? 0 : queue;
 	for (; qid < end_q; qid++) {
@@ -138,20 +307,21 @@ pdump_register_rx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 					port, qid);
 				return -EEXIST;
 			}
-			cbs->ring = ring;
-			cbs->mp = mp;
+			ret = pdump_cbs_setup(cbs, ring, mp, prm, snaplen,
+					zero_copy);
+			if (ret < 0)
+				return ret;
 			cbs->cb = rte_eth_add_first_rx_callback(port, qid,
 								pdump_rx, cbs);
 			if (cbs->cb == NULL) {
 				PDUMP_LOG(ERR,
 					"failed to add rx callback, errno=%d\n",
 					rte_errno);
+				pdump_cbs_release(cbs);
 				return rte_errno;
 			}
 		}
 		if (cbs && operation == DISABLE) {
-			int ret;
-
 			if (cbs->cb == NULL) {
 				PDUMP_LOG(ERR,
 					"failed to delete non existing rx "
@@ -167,6 +337,7 @@ pdump_register_rx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 				return ret;
 			}
 			cbs->cb = NULL;
+			pdump_cbs_release(cbs);
 		}
 	}
 
@@ -176,11 +347,13 @@ pdump_register_rx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 static int
 pdump_register_tx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 				struct rte_ring *ring, struct rte_mempool *mp,
+				const struct rte_bpf_prm *prm, uint32_t snaplen,
 				uint16_t operation)
 {
 
 	uint16_t qid;
 	struct pdump_rxtx_cbs *cbs = NULL;
+	int ret;
 
 	qid = (queue == RTE_PDUMP_ALL_QUEUES) ? 0 : queue;
 	for (; qid < end_q; qid++) {
@@ -193,20 +366,20 @@ pdump_register_tx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 					port, qid);
 				return -EEXIST;
 			}
-			cbs->ring = ring;
-			cbs->mp = mp;
+			ret = pdump_cbs_setup(cbs, ring, mp, prm, snaplen, 0);
+			if (ret < 0)
+				return ret;
 			cbs->cb = rte_eth_add_tx_callback(port, qid, pdump_tx,
 								cbs);
 			if (cbs->cb == NULL) {
 				PDUMP_LOG(ERR,
 					"failed to add tx callback, errno=%d\n",
 					rte_errno);
+				pdump_cbs_release(cbs);
 				return rte_errno;
 			}
 		}
 		if (cbs && operation == DISABLE) {
-			int ret;
-
 			if (cbs->cb == NULL) {
 				PDUMP_LOG(ERR,
 					"failed to delete non existing tx "
@@ -222,6 +395,7 @@ pdump_register_tx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 				return ret;
 			}
 			cbs->cb = NULL;
+			pdump_cbs_release(cbs);
 		}
 	}
 
@@ -238,6 +412,8 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 	uint16_t operation;
 	struct rte_ring *ring;
 	struct rte_mempool *mp;
+	const struct rte_bpf_prm *prm = NULL;
+	uint32_t snaplen = 0;
 
 	flags = p->flags;
 	operation = p->op;
@@ -253,6 +429,8 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 		queue = p->data.en_v1.queue;
 		ring = p->data.en_v1.ring;
 		mp = p->data.en_v1.mp;
+		prm = p->data.en_v1.prm;
+		snaplen = p->data.en_v1.snaplen;
 	} else {
 		ret = rte_eth_dev_get_port_by_name(p->data.dis_v1.device,
 				&port);
@@ -292,7 +470,7 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 			return -EINVAL;
 		}
 		if ((nb_tx_q == 0 || nb_rx_q == 0) &&
-			flags == RTE_PDUMP_FLAG_RXTX) {
+			(flags & RTE_PDUMP_FLAG_RXTX) == RTE_PDUMP_FLAG_RXTX) {
 			PDUMP_LOG(ERR,
 				"both tx&rx queues must be non zero\n");
 			return -EINVAL;
@@ -303,7 +481,9 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 	if (flags & RTE_PDUMP_FLAG_RX) {
 		end_q = (queue == RTE_PDUMP_ALL_QUEUES) ? nb_rx_q : queue + 1;
 		ret = pdump_register_rx_callbacks(end_q, port, queue, ring, mp,
-							operation);
+				prm, snaplen,
+				(flags & RTE_PDUMP_FLAG_ZERO_COPY) != 0,
+				operation);
 		if (ret < 0)
 			return ret;
 	}
@@ -312,7 +492,7 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 	if (flags & RTE_PDUMP_FLAG_TX) {
 		end_q = (queue == RTE_PDUMP_ALL_QUEUES) ? nb_tx_q : queue + 1;
 		ret = pdump_register_tx_callbacks(end_q, port, queue, ring, mp,
-							operation);
+				prm, snaplen, operation);
 		if (ret < 0)
 			return ret;
 	}
@@ -394,6 +574,7 @@ pdump_validate_ring_mp(struct rte_ring *ring, struct rte_mempool *mp)
 static int
 pdump_validate_flags(uint32_t flags)
 {
+	flags &= ~RTE_PDUMP_FLAG_ZERO_COPY;
 	if (flags != RTE_PDUMP_FLAG_RX && flags != RTE_PDUMP_FLAG_TX &&
 		flags != RTE_PDUMP_FLAG_RXTX) {
 		PDUMP_LOG(ERR,
@@ -428,12 +609,27 @@ pdump_validate_port(uint16_t port, char *name)
 }
 
 static int
-pdump_prepare_client_request(char *device, uint16_t queue,
+pdump_validate_prm(const struct rte_bpf_prm *prm)
+{
+	if (prm != NULL && prm->prog_arg.type != RTE_BPF_ARG_PTR &&
+		prm->prog_arg.type != RTE_BPF_ARG_PTR_MBUF) {
+		PDUMP_LOG(ERR, "filter argument should be a packet data or"
+			" mbuf pointer\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+pdump_prepare_client_request(const char *device, uint16_t queue,
 				uint32_t flags,
 				uint16_t operation,
 				struct rte_ring *ring,
 				struct rte_mempool *mp,
-				void *filter)
+				const struct rte_bpf_prm *prm,
+				uint32_t snaplen)
 {
 	int ret = -1;
 	struct rte_mp_msg mp_req, *mp_rep;
@@ -451,7 +647,8 @@ pdump_prepare_client_request(char *device, uint16_t queue,
 		req->data.en_v1.queue = queue;
 		req->data.en_v1.ring = ring;
 		req->data.en_v1.mp = mp;
-		req->data.en_v1.filter = filter;
+		req->data.en_v1.prm = prm;
+		req->data.en_v1.snaplen = (snaplen == 0) ? UINT32_MAX : snaplen;
 	} else {
 		strlcpy(req->data.dis_v1.device, device,
 			sizeof(req->data.dis_v1.device));
@@ -483,34 +680,47 @@ int
 rte_pdump_enable(uint16_t port, uint16_t queue, uint32_t flags,
 			struct rte_ring *ring,
 			struct rte_mempool *mp,
-			void *filter)
+			void *filter __rte_unused)
+{
+	return rte_pdump_enable_bpf(port, queue, flags, 0, ring, mp, NULL);
+}
+
+int
+rte_pdump_enable_by_deviceid(char *device_id, uint16_t queue,
+				uint32_t flags,
+				struct rte_ring *ring,
+				struct rte_mempool *mp,
+				void *filter __rte_unused)
 {
+	return rte_pdump_enable_bpf_by_deviceid(device_id, queue, flags, 0,
+			ring, mp, NULL);
+}
 
+int
+rte_pdump_enable_bpf(uint16_t port, uint16_t queue, uint32_t flags,
+			uint32_t snaplen,
+			struct rte_ring *ring,
+			struct rte_mempool *mp,
+			const struct rte_bpf_prm *prm)
+{
 	int ret = 0;
 	char name[DEVICE_ID_SIZE];
 
 	ret = pdump_validate_port(port, name);
 	if (ret < 0)
 		return ret;
-	ret = pdump_validate_ring_mp(ring, mp);
-	if (ret < 0)
-		return ret;
-	ret = pdump_validate_flags(flags);
-	if (ret < 0)
-		return ret;
-
-	ret = pdump_prepare_client_request(name, queue, flags,
-						ENABLE, ring, mp, filter);
 
-	return ret;
+	return rte_pdump_enable_bpf_by_deviceid(name, queue, flags, snaplen,
+			ring, mp, prm);
 }
 
 int
-rte_pdump_enable_by_deviceid(char *device_id, uint16_t queue,
+rte_pdump_enable_bpf_by_deviceid(const char *device_id, uint16_t queue,
 				uint32_t flags,
+				uint32_t snaplen,
 				struct rte_ring *ring,
 				struct rte_mempool *mp,
-				void *filter)
+				const struct rte_bpf_prm *prm)
 {
 	int ret = 0;
 
@@ -518,11 +728,14 @@ rte_pdump_enable_by_deviceid(char *device_id, uint16_t queue,
 	if (ret < 0)
 		return ret;
 	ret = pdump_validate_flags(flags);
+	if (ret < 0)
+		return ret;
+	ret = pdump_validate_prm(prm);
 	if (ret < 0)
 		return ret;
 
 	ret = pdump_prepare_client_request(device_id, queue, flags,
-						ENABLE, ring, mp, filter);
+						ENABLE, ring, mp, prm, snaplen);
 
 	return ret;
 }
@@ -541,7 +754,7 @@ rte_pdump_disable(uint16_t port, uint16_t queue, uint32_t flags)
 		return ret;
 
 	ret = pdump_prepare_client_request(name, queue, flags,
-						DISABLE, NULL, NULL, NULL);
+						DISABLE, NULL, NULL, NULL, 0);
 
 	return ret;
 }
@@ -557,7 +770,7 @@ rte_pdump_disable_by_deviceid(char *device_id, uint16_t queue,
 		return ret;
 
 	ret = pdump_prepare_client_request(device_id, queue, flags,
-						DISABLE, NULL, NULL, NULL);
+						DISABLE, NULL, NULL, NULL, 0);
 
 	return ret;
 }
@@ -26,9 +26,13 @@ enum {
 	RTE_PDUMP_FLAG_RX = 1,  /* receive direction */
 	RTE_PDUMP_FLAG_TX = 2,  /* transmit direction */
 	/* both receive and transmit directions */
-	RTE_PDUMP_FLAG_RXTX = (RTE_PDUMP_FLAG_RX|RTE_PDUMP_FLAG_TX)
+	RTE_PDUMP_FLAG_RXTX = (RTE_PDUMP_FLAG_RX|RTE_PDUMP_FLAG_TX),
+	/* reference received packet data instead of copying it */
+	RTE_PDUMP_FLAG_ZERO_COPY = 4
 };
 
+struct rte_bpf_prm;
+
 /**
  * Initialize packet capturing handling
  *
@@ -80,6 +84,59 @@ rte_pdump_enable(uint16_t port, uint16_t queue, uint32_t flags,
 		struct rte_mempool *mp,
 		void *filter);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Enables filtered and truncated packet capturing on given port and queue.
+ *
+ * Packets are matched against the filter before being duplicated, and
+ * only the first snaplen bytes of the matching packets are duplicated.
+ *
+ * With RTE_PDUMP_FLAG_ZERO_COPY, received packets are not copied: each
+ * captured mbuf is an indirect mbuf attached to the received packet data,
+ * which is kept valid by the mbuf reference count until the capture frees
+ * it. The captured data is then modified along with the received packet,
+ * and the application must not return received mbufs to their pool
+ * without checking their reference count, e.g. by transmitting them on a
+ * queue with DEV_TX_OFFLOAD_MBUF_FAST_FREE. Transmitted packets are
+ * always copied.
+ *
+ * @param port
+ *  port on which packet capturing should be enabled.
+ * @param queue
+ *  queue of a given port on which packet capturing should be enabled.
+ *  users should pass on value UINT16_MAX to enable packet capturing on all
+ *  queues of a given port.
+ * @param flags
+ *  flags specifies RTE_PDUMP_FLAG_RX/RTE_PDUMP_FLAG_TX/RTE_PDUMP_FLAG_RXTX
+ *  on which packet capturing should be enabled for a given port and queue,
+ *  optionally ORed with RTE_PDUMP_FLAG_ZERO_COPY.
+ * @param snaplen
+ *  maximum number of bytes captured from each packet, 0 to capture whole
+ *  packets.
+ * @param ring
+ *  ring on which captured packets will be enqueued for user.
+ * @param mp
+ *  mempool on to which original packets will be mirrored or duplicated.
+ * @param prm
+ *  eBPF program capturing the packets for which it returns non-zero, or
+ *  NULL to capture all packets. Its argument is either the packet data
+ *  (RTE_BPF_ARG_PTR) or the mbuf (RTE_BPF_ARG_PTR_MBUF). The program is
+ *  loaded by the primary process, so prm and the memory it points to must
+ *  be shared with it, e.g. allocated with rte_malloc().
+ *
+ * @return
+ *    0 on success, -1 on error, rte_errno is set accordingly.
+ */
+__rte_experimental
+int
+rte_pdump_enable_bpf(uint16_t port, uint16_t queue, uint32_t flags,
+		uint32_t snaplen,
+		struct rte_ring *ring,
+		struct rte_mempool *mp,
+		const struct rte_bpf_prm *prm);
+
 /**
  * Disables packet capturing on given port and queue.
  *
@@ -131,6 +188,46 @@ rte_pdump_enable_by_deviceid(char *device_id, uint16_t queue,
 				struct rte_mempool *mp,
 				void *filter);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Enables filtered and truncated packet capturing on given device id and
+ * queue. device_id can be name or pci address of device.
+ * See rte_pdump_enable_bpf() for the filtering and zero-copy behaviour.
+ *
+ * @param device_id
+ *  device id on which packet capturing should be enabled.
+ * @param queue
+ *  queue of a given device id on which packet capturing should be enabled.
+ *  users should pass on value UINT16_MAX to enable packet capturing on all
+ *  queues of a given device id.
+ * @param flags
+ *  flags specifies RTE_PDUMP_FLAG_RX/RTE_PDUMP_FLAG_TX/RTE_PDUMP_FLAG_RXTX
+ *  on which packet capturing should be enabled for a given port and queue,
+ *  optionally ORed with RTE_PDUMP_FLAG_ZERO_COPY.
+ * @param snaplen
+ *  maximum number of bytes captured from each packet, 0 to capture whole
+ *  packets.
+ * @param ring
+ *  ring on which captured packets will be enqueued for user.
+ * @param mp
+ *  mempool on to which original packets will be mirrored or duplicated.
+ * @param prm
+ *  eBPF program filtering the captured packets, or NULL.
+ *
+ * @return
+ *    0 on success, -1 on error, rte_errno is set accordingly.
+ */
+__rte_experimental
+int
+rte_pdump_enable_bpf_by_deviceid(const char *device_id, uint16_t queue,
+				uint32_t flags,
+				uint32_t snaplen,
+				struct rte_ring *ring,
+				struct rte_mempool *mp,
+				const struct rte_bpf_prm *prm);
+
 /**
  * Disables packet capturing on given device_id and queue.
  * device_id can be name or pci address of device.
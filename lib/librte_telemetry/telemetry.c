@@ -4,6 +4,8 @@
 
 #include <unistd.h>
 #include <pthread.h>
+#include <poll.h>
+#include <time.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <dlfcn.h>
@@ -13,17 +15,25 @@
 #include <rte_string_fns.h>
 #include <rte_common.h>
 #include <rte_spinlock.h>
+#include <rte_per_lcore.h>
 #include <rte_version.h>
 
 #include "rte_telemetry.h"
-#include "telemetry_json.h"
 #include "telemetry_data.h"
+#include "telemetry_output.h"
 #include "rte_telemetry_legacy.h"
 
 #define MAX_CMD_LEN 56
 #define MAX_HELP_LEN 64
-#define MAX_OUTPUT_LEN (1024 * 16)
+#define MAX_PARAM_LEN 128
+/*
+ * replies are sized to their content, this is the upper bound of a
+ * JSON reply for the largest data a callback can return.
+ */
+#define MAX_OUTPUT_LEN (1024 * 64)
 #define MAX_CONNECTIONS 10
+#define MAX_SUBSCRIPTIONS 16
+#define MIN_PERIOD_MS 10
 
 static void *
 client_handler(void *socket);
@@ -34,6 +44,24 @@ struct cmd_callback {
 	char help[MAX_HELP_LEN];
 };
 
+/* command reply pushed periodically to a client */
+struct subscription {
+	char cmd[MAX_CMD_LEN];
+	char params[MAX_PARAM_LEN];
+	telemetry_cb fn;
+	uint64_t period; /* in ms */
+	uint64_t next;   /* time of the next push, in ms */
+};
+
+/* state of a v2 client connection, owned by its handler thread */
+struct client {
+	int s;
+	enum tel_output_format fmt;
+	unsigned int num_subs;
+	struct subscription subs[MAX_SUBSCRIPTIONS];
+	struct tel_buf out; /* reused for all replies on the connection */
+};
+
 struct socket {
 	int sock;
 	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
@@ -49,6 +77,8 @@ static int num_callbacks; /* How many commands are registered */
 /* Used when accessing or modifying list of command callbacks */
 static rte_spinlock_t callback_sl = RTE_SPINLOCK_INITIALIZER;
 static uint16_t v2_clients;
+/* connection served by the current thread, for per connection commands */
+static RTE_DEFINE_PER_LCORE(struct client *, client);
 
 int
 rte_telemetry_register_cmd(const char *cmd, telemetry_cb fn, const char *help)
@@ -124,102 +154,219 @@ command_help(const char *cmd __rte_unused, const char *params,
 }
 
 static void
-output_json(const char *cmd, const struct rte_tel_data *d, int s)
+perform_command(struct client *c, telemetry_cb fn, const char *cmd,
+		const char *param)
+{
+	struct rte_tel_data data;
+
+	int ret = fn(cmd, param, &data);
+	if (ret < 0)
+		data.type = RTE_TEL_NULL;
+	if (cmd == NULL)
+		cmd = "none";
+
+	if (tel_output(&c->out, c->fmt, cmd, &data) != 0) {
+		/* no memory for the reply, send null instead */
+		data.type = RTE_TEL_NULL;
+		if (tel_output(&c->out, c->fmt, cmd, &data) != 0)
+			return;
+	}
+	if (write(c->s, c->out.data, c->out.len) < 0)
+		perror("Error writing to socket");
+}
+
+static telemetry_cb
+find_command(const char *cmd)
+{
+	telemetry_cb fn = NULL;
+	int i;
+
+	if (cmd == NULL || strlen(cmd) >= MAX_CMD_LEN)
+		return NULL;
+
+	rte_spinlock_lock(&callback_sl);
+	for (i = 0; i < num_callbacks; i++)
+		if (strcmp(cmd, callbacks[i].cmd) == 0) {
+			fn = callbacks[i].fn;
+			break;
+		}
+	rte_spinlock_unlock(&callback_sl);
+	return fn;
+}
+
+static uint64_t
+time_ms(void)
 {
-	char out_buf[MAX_OUTPUT_LEN];
+	struct timespec ts;
 
-	char *cb_data_buf;
-	size_t buf_len, prefix_used, used = 0;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int
+output_format(const char *cmd __rte_unused, const char *params,
+		struct rte_tel_data *d)
+{
+	static const char * const names[] = {
+		[TEL_OUTPUT_JSON] = "json",
+		[TEL_OUTPUT_CBOR] = "cbor",
+	};
+	struct client *c = RTE_PER_LCORE(client);
 	unsigned int i;
 
-	RTE_BUILD_BUG_ON(sizeof(out_buf) < MAX_CMD_LEN +
-			RTE_TEL_MAX_SINGLE_STRING_LEN + 10);
-	switch (d->type) {
-	case RTE_TEL_NULL:
-		used = snprintf(out_buf, sizeof(out_buf), "{\"%.*s\":null}",
-				MAX_CMD_LEN, cmd ? cmd : "none");
-		break;
-	case RTE_TEL_STRING:
-		used = snprintf(out_buf, sizeof(out_buf), "{\"%.*s\":\"%.*s\"}",
-				MAX_CMD_LEN, cmd,
-				RTE_TEL_MAX_SINGLE_STRING_LEN, d->data.str);
-		break;
-	case RTE_TEL_DICT:
-		prefix_used = snprintf(out_buf, sizeof(out_buf), "{\"%.*s\":",
-				MAX_CMD_LEN, cmd);
-		cb_data_buf = &out_buf[prefix_used];
-		buf_len = sizeof(out_buf) - prefix_used - 1; /* space for '}' */
-
-		used = rte_tel_json_empty_obj(cb_data_buf, buf_len, 0);
-		for (i = 0; i < d->data_len; i++) {
-			const struct tel_dict_entry *v = &d->data.dict[i];
-			switch (v->type) {
-			case RTE_TEL_STRING_VAL:
-				used = rte_tel_json_add_obj_str(cb_data_buf,
-						buf_len, used,
-						v->name, v->value.sval);
-				break;
-			case RTE_TEL_INT_VAL:
-				used = rte_tel_json_add_obj_int(cb_data_buf,
-						buf_len, used,
-						v->name, v->value.ival);
-				break;
-			case RTE_TEL_U64_VAL:
-				used = rte_tel_json_add_obj_u64(cb_data_buf,
-						buf_len, used,
-						v->name, v->value.u64val);
+	if (c == NULL)
+		return -1;
+
+	if (params != NULL) {
+		for (i = 0; i < RTE_DIM(names); i++)
+			if (strcmp(params, names[i]) == 0)
 				break;
-			}
+		if (i == RTE_DIM(names))
+			return -1;
+		/* this reply is already sent in the new format */
+		c->fmt = i;
+	}
+	rte_tel_data_string(d, names[c->fmt]);
+	return 0;
+}
+
+static int
+unsubscribe(const char *cmd, const char *params, struct rte_tel_data *d);
+
+/*
+ * split "<command>[,<params>]" into the subscription,
+ * params are left empty when not given.
+ */
+static int
+parse_subscription(struct subscription *sub, const char *str)
+{
+	size_t len;
+
+	len = strcspn(str, ",");
+	if (len == 0 || len >= sizeof(sub->cmd))
+		return -1;
+	memcpy(sub->cmd, str, len);
+	sub->cmd[len] = 0;
+
+	sub->params[0] = 0;
+	if (str[len] == ',' && strlcpy(sub->params, str + len + 1,
+			sizeof(sub->params)) >= sizeof(sub->params))
+		return -1;
+	return 0;
+}
+
+static int
+subscribe(const char *cmd __rte_unused, const char *params,
+		struct rte_tel_data *d)
+{
+	struct client *c = RTE_PER_LCORE(client);
+	struct subscription *sub;
+	unsigned long period;
+	char *end;
+
+	if (c == NULL || params == NULL || c->num_subs == MAX_SUBSCRIPTIONS)
+		return -1;
+
+	period = strtoul(params, &end, 10);
+	if (end == params || *end != ',' || period < MIN_PERIOD_MS)
+		return -1;
+
+	sub = &c->subs[c->num_subs];
+	if (parse_subscription(sub, end + 1) != 0)
+		return -1;
+
+	/* commands managing the connection can't be pushed */
+	sub->fn = find_command(sub->cmd);
+	if (sub->fn == NULL || sub->fn == subscribe ||
+			sub->fn == unsubscribe || sub->fn == output_format)
+		return -1;
+
+	sub->period = period;
+	sub->next = time_ms() + period;
+	c->num_subs++;
+
+	rte_tel_data_start_dict(d);
+	rte_tel_data_add_dict_string(d, "command", sub->cmd);
+	rte_tel_data_add_dict_u64(d, "period_ms", period);
+	rte_tel_data_add_dict_int(d, "subscriptions", c->num_subs);
+	return 0;
+}
+
+static int
+unsubscribe(const char *cmd __rte_unused, const char *params,
+		struct rte_tel_data *d)
+{
+	struct client *c = RTE_PER_LCORE(client);
+	struct subscription key;
+	unsigned int i, n;
+
+	if (c == NULL)
+		return -1;
+
+	/* no params, drop all subscriptions */
+	if (params == NULL)
+		c->num_subs = 0;
+	else {
+		if (parse_subscription(&key, params) != 0)
+			return -1;
+		for (i = 0, n = 0; i < c->num_subs; i++) {
+			if (strcmp(c->subs[i].cmd, key.cmd) == 0 &&
+					strcmp(c->subs[i].params,
+					key.params) == 0)
+				continue;
+			if (n != i)
+				c->subs[n] = c->subs[i];
+			n++;
 		}
-		used += prefix_used;
-		used += strlcat(out_buf + used, "}", sizeof(out_buf) - used);
-		break;
-	case RTE_TEL_ARRAY_STRING:
-	case RTE_TEL_ARRAY_INT:
-	case RTE_TEL_ARRAY_U64:
-		prefix_used = snprintf(out_buf, sizeof(out_buf), "{\"%.*s\":",
-				MAX_CMD_LEN, cmd);
-		cb_data_buf = &out_buf[prefix_used];
-		buf_len = sizeof(out_buf) - prefix_used - 1; /* space for '}' */
-
-		used = rte_tel_json_empty_array(cb_data_buf, buf_len, 0);
-		for (i = 0; i < d->data_len; i++)
-			if (d->type == RTE_TEL_ARRAY_STRING)
-				used = rte_tel_json_add_array_string(
-						cb_data_buf,
-						buf_len, used,
-						d->data.array[i].sval);
-			else if (d->type == RTE_TEL_ARRAY_INT)
-				used = rte_tel_json_add_array_int(cb_data_buf,
-						buf_len, used,
-						d->data.array[i].ival);
-			else if (d->type == RTE_TEL_ARRAY_U64)
-				used = rte_tel_json_add_array_u64(cb_data_buf,
-						buf_len, used,
-						d->data.array[i].u64val);
-		used += prefix_used;
-		used += strlcat(out_buf + used, "}", sizeof(out_buf) - used);
-		break;
+		if (n == c->num_subs)
+			return -1;
+		c->num_subs = n;
 	}
-	if (write(s, out_buf, used) < 0)
-		perror("Error writing to socket");
+
+	rte_tel_data_start_dict(d);
+	rte_tel_data_add_dict_int(d, "subscriptions", c->num_subs);
+	return 0;
+}
+
+/* time to wait for the next subscription push, -1 if there is none */
+static int
+push_timeout(const struct client *c)
+{
+	uint64_t next, now;
+	unsigned int i;
+
+	if (c->num_subs == 0)
+		return -1;
+
+	next = c->subs[0].next;
+	for (i = 1; i < c->num_subs; i++)
+		next = RTE_MIN(next, c->subs[i].next);
+
+	now = time_ms();
+	return next > now ? (int)(next - now) : 0;
 }
 
 static void
-perform_command(telemetry_cb fn, const char *cmd, const char *param, int s)
+push_subscriptions(struct client *c)
 {
-	struct rte_tel_data data;
+	struct subscription *sub;
+	unsigned int i;
+	uint64_t now;
 
-	int ret = fn(cmd, param, &data);
-	if (ret < 0) {
-		char out_buf[MAX_CMD_LEN + 10];
-		int used = snprintf(out_buf, sizeof(out_buf), "{\"%.*s\":null}",
-				MAX_CMD_LEN, cmd ? cmd : "none");
-		if (write(s, out_buf, used) < 0)
-			perror("Error writing to socket");
-		return;
+	now = time_ms();
+	for (i = 0; i < c->num_subs; i++) {
+		sub = &c->subs[i];
+		if (now < sub->next)
+			continue;
+
+		perform_command(c, sub->fn, sub->cmd,
+				sub->params[0] != 0 ? sub->params : NULL);
+
+		/* skip the periods missed while busy, don't push in bursts */
+		sub->next += sub->period;
+		if (sub->next <= now)
+			sub->next = now + sub->period;
 	}
-	output_json(cmd, &data, s);
 }
 
 static int
@@ -232,40 +379,56 @@ unknown_command(const char *cmd __rte_unused, const char *params __rte_unused,
 static void *
 client_handler(void *sock_id)
 {
-	int s = (int)(uintptr_t)sock_id;
+	struct client c = {
+		.s = (int)(uintptr_t)sock_id,
+		.fmt = TEL_OUTPUT_JSON,
+	};
+	struct pollfd pfd = {
+		.fd = c.s,
+		.events = POLLIN,
+	};
 	char buffer[1024];
 	char info_str[1024];
+	int bytes, ret;
+
 	snprintf(info_str, sizeof(info_str),
 			"{\"version\":\"%s\",\"pid\":%d,\"max_output_len\":%d}",
 			rte_version(), getpid(), MAX_OUTPUT_LEN);
-	if (write(s, info_str, strlen(info_str)) < 0) {
-		close(s);
-		return NULL;
-	}
+	if (write(c.s, info_str, strlen(info_str)) < 0)
+		goto exit;
+
+	RTE_PER_LCORE(client) = &c;
 
-	/* receive data is not null terminated */
-	int bytes = read(s, buffer, sizeof(buffer) - 1);
-	while (bytes > 0) {
-		buffer[bytes] = 0;
-		const char *cmd = strtok(buffer, ",");
-		const char *param = strtok(NULL, ",");
-		telemetry_cb fn = unknown_command;
-		int i;
-
-		if (cmd && strlen(cmd) < MAX_CMD_LEN) {
-			rte_spinlock_lock(&callback_sl);
-			for (i = 0; i < num_callbacks; i++)
-				if (strcmp(cmd, callbacks[i].cmd) == 0) {
-					fn = callbacks[i].fn;
-					break;
-				}
-			rte_spinlock_unlock(&callback_sl);
+	/* serve requests, pushing subscribed replies when they are due */
+	while (1) {
+		ret = poll(&pfd, 1, push_timeout(&c));
+		if (ret < 0 && errno != EINTR)
+			break;
+
+		if (ret > 0) {
+			/* receive data is not null terminated */
+			bytes = read(c.s, buffer, sizeof(buffer) - 1);
+			if (bytes <= 0)
+				break;
+			buffer[bytes] = 0;
+
+			/* params are everything after the first comma */
+			const char *cmd = strtok(buffer, ",");
+			const char *param = strtok(NULL, "");
+			telemetry_cb fn = find_command(cmd);
+
+			if (fn == NULL)
+				fn = unknown_command;
+			perform_command(&c, fn, cmd, param);
 		}
-		perform_command(fn, cmd, param, s);
 
-		bytes = read(s, buffer, sizeof(buffer) - 1);
+		push_subscriptions(&c);
 	}
-	close(s);
+
+	RTE_PER_LCORE(client) = NULL;
+	tel_buf_free(&c.out);
+exit:
+	close(c.s);
 	__atomic_sub_fetch(&v2_clients, 1, __ATOMIC_RELAXED);
 	return NULL;
 }
@@ -394,6 +557,12 @@ telemetry_v2_init(const char *runtime_dir, rte_cpuset_t *cpuset)
 			"Returns DPDK Telemetry information. Takes no parameters");
 	rte_telemetry_register_cmd("/help", command_help,
 			"Returns help text for a command. Parameters: string command");
+	rte_telemetry_register_cmd("/format", output_format,
+			"Sets reply encoding. Parameters: json or cbor");
+	rte_telemetry_register_cmd("/subscribe", subscribe,
+			"Pushes replies. Parameters: period_ms,command[,params]");
+	rte_telemetry_register_cmd("/unsubscribe", unsubscribe,
+			"Stops pushes. Parameters: [command[,params]]");
 	v2_socket.fn = client_handler;
 	if (strlcpy(v2_socket.path, get_socket_path(runtime_dir, 2),
 			sizeof(v2_socket.path)) >= sizeof(v2_socket.path)) {
@@ -0,0 +1,282 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+
+#include "telemetry_output.h"
+
+/* initial size of a reply buffer, enough for most replies */
+#define TEL_BUF_MIN_SIZE 4096
+
+/* CBOR major types, RFC 7049 */
+enum {
+	CBOR_UINT = 0,
+	CBOR_NINT = 1,
+	CBOR_TEXT = 3,
+	CBOR_ARRAY = 4,
+	CBOR_MAP = 5,
+	CBOR_SIMPLE = 7,
+};
+
+/* CBOR additional information values */
+#define CBOR_SHORT_MAX 23
+#define CBOR_UINT8 24
+#define CBOR_NULL 22
+
+void
+tel_buf_free(struct tel_buf *b)
+{
+	free(b->data);
+	memset(b, 0, sizeof(*b));
+}
+
+/* make sure there is room for len more bytes */
+static int
+tel_buf_reserve(struct tel_buf *b, size_t len)
+{
+	uint8_t *p;
+	size_t sz;
+
+	if (b->err != 0)
+		return -b->err;
+	if (b->size - b->len >= len)
+		return 0;
+
+	sz = RTE_MAX(b->size, (size_t)TEL_BUF_MIN_SIZE);
+	while (sz - b->len < len)
+		sz *= 2;
+
+	p = realloc(b->data, sz);
+	if (p == NULL) {
+		b->err = ENOMEM;
+		return -ENOMEM;
+	}
+	b->data = p;
+	b->size = sz;
+	return 0;
+}
+
+static void
+tel_buf_put(struct tel_buf *b, const void *p, size_t len)
+{
+	if (tel_buf_reserve(b, len) != 0)
+		return;
+	memcpy(b->data + b->len, p, len);
+	b->len += len;
+}
+
+/* format directly into the buffer, growing it when the output doesn't fit */
+__rte_format_printf(2, 3)
+static void
+tel_buf_printf(struct tel_buf *b, const char *format, ...)
+{
+	va_list ap;
+	size_t avail;
+	int ret;
+
+	if (b->err != 0)
+		return;
+
+	avail = b->size - b->len;
+	va_start(ap, format);
+	ret = vsnprintf((char *)b->data + b->len, avail, format, ap);
+	va_end(ap);
+	if (ret < 0) {
+		b->err = EINVAL;
+		return;
+	}
+
+	/* vsnprintf() needs room for the terminating nul as well */
+	if ((size_t)ret >= avail) {
+		if (tel_buf_reserve(b, ret + 1) != 0)
+			return;
+		va_start(ap, format);
+		vsnprintf((char *)b->data + b->len, b->size - b->len,
+				format, ap);
+		va_end(ap);
+	}
+	b->len += ret;
+}
+
+/* type of the values stored in an array container */
+static enum rte_tel_value_type
+array_value_type(enum tel_container_types type)
+{
+	if (type == RTE_TEL_ARRAY_STRING)
+		return RTE_TEL_STRING_VAL;
+	if (type == RTE_TEL_ARRAY_INT)
+		return RTE_TEL_INT_VAL;
+	return RTE_TEL_U64_VAL;
+}
+
+static void
+json_value(struct tel_buf *b, enum rte_tel_value_type type,
+		const union tel_value *v)
+{
+	switch (type) {
+	case RTE_TEL_STRING_VAL:
+		tel_buf_printf(b, "\"%s\"", v->sval);
+		break;
+	case RTE_TEL_INT_VAL:
+		tel_buf_printf(b, "%d", v->ival);
+		break;
+	case RTE_TEL_U64_VAL:
+		tel_buf_printf(b, "%"PRIu64, v->u64val);
+		break;
+	}
+}
+
+static void
+output_json(struct tel_buf *b, const char *cmd, const struct rte_tel_data *d)
+{
+	enum rte_tel_value_type type;
+	unsigned int i;
+
+	tel_buf_printf(b, "{\"%s\":", cmd);
+
+	switch (d->type) {
+	case RTE_TEL_NULL:
+		tel_buf_printf(b, "null");
+		break;
+	case RTE_TEL_STRING:
+		tel_buf_printf(b, "\"%s\"", d->data.str);
+		break;
+	case RTE_TEL_DICT:
+		tel_buf_printf(b, "{");
+		for (i = 0; i < d->data_len; i++) {
+			const struct tel_dict_entry *v = &d->data.dict[i];
+
+			tel_buf_printf(b, "%s\"%s\":", i == 0 ? "" : ",",
+					v->name);
+			json_value(b, v->type, &v->value);
+		}
+		tel_buf_printf(b, "}");
+		break;
+	case RTE_TEL_ARRAY_STRING:
+	case RTE_TEL_ARRAY_INT:
+	case RTE_TEL_ARRAY_U64:
+		type = array_value_type(d->type);
+		tel_buf_printf(b, "[");
+		for (i = 0; i < d->data_len; i++) {
+			if (i != 0)
+				tel_buf_printf(b, ",");
+			json_value(b, type, &d->data.array[i]);
+		}
+		tel_buf_printf(b, "]");
+		break;
+	}
+
+	tel_buf_printf(b, "}");
+}
+
+/* encode CBOR data item head: major type and its argument */
+static void
+cbor_head(struct tel_buf *b, uint8_t major, uint64_t val)
+{
+	uint8_t h[1 + sizeof(uint64_t)];
+	uint32_t i, n;
+
+	if (val <= CBOR_SHORT_MAX) {
+		h[0] = major << 5 | val;
+		tel_buf_put(b, h, 1);
+		return;
+	}
+
+	/* argument follows in 1, 2, 4 or 8 bytes, in network order */
+	for (i = 0, n = 1; n != sizeof(uint64_t) && (val >> (n * 8)) != 0;
+			i++, n *= 2)
+		;
+
+	h[0] = major << 5 | (CBOR_UINT8 + i);
+	for (i = 0; i != n; i++)
+		h[1 + i] = val >> ((n - 1 - i) * 8);
+	tel_buf_put(b, h, 1 + n);
+}
+
+static void
+cbor_text(struct tel_buf *b, const char *s)
+{
+	size_t len = strlen(s);
+
+	cbor_head(b, CBOR_TEXT, len);
+	tel_buf_put(b, s, len);
+}
+
+static void
+cbor_value(struct tel_buf *b, enum rte_tel_value_type type,
+		const union tel_value *v)
+{
+	switch (type) {
+	case RTE_TEL_STRING_VAL:
+		cbor_text(b, v->sval);
+		break;
+	case RTE_TEL_INT_VAL:
+		if (v->ival >= 0)
+			cbor_head(b, CBOR_UINT, v->ival);
+		else
+			cbor_head(b, CBOR_NINT, -1 - (int64_t)v->ival);
+		break;
+	case RTE_TEL_U64_VAL:
+		cbor_head(b, CBOR_UINT, v->u64val);
+		break;
+	}
+}
+
+static void
+output_cbor(struct tel_buf *b, const char *cmd, const struct rte_tel_data *d)
+{
+	enum rte_tel_value_type type;
+	unsigned int i;
+
+	cbor_head(b, CBOR_MAP, 1);
+	cbor_text(b, cmd);
+
+	switch (d->type) {
+	case RTE_TEL_NULL:
+		cbor_head(b, CBOR_SIMPLE, CBOR_NULL);
+		break;
+	case RTE_TEL_STRING:
+		cbor_text(b, d->data.str);
+		break;
+	case RTE_TEL_DICT:
+		cbor_head(b, CBOR_MAP, d->data_len);
+		for (i = 0; i < d->data_len; i++) {
+			const struct tel_dict_entry *v = &d->data.dict[i];
+
+			cbor_text(b, v->name);
+			cbor_value(b, v->type, &v->value);
+		}
+		break;
+	case RTE_TEL_ARRAY_STRING:
+	case RTE_TEL_ARRAY_INT:
+	case RTE_TEL_ARRAY_U64:
+		type = array_value_type(d->type);
+		cbor_head(b, CBOR_ARRAY, d->data_len);
+		for (i = 0; i < d->data_len; i++)
+			cbor_value(b, type, &d->data.array[i]);
+		break;
+	}
+}
+
+int
+tel_output(struct tel_buf *b, enum tel_output_format fmt, const char *cmd,
+		const struct rte_tel_data *d)
+{
+	b->len = 0;
+	b->err = 0;
+
+	if (fmt == TEL_OUTPUT_CBOR)
+		output_cbor(b, cmd, d);
+	else
+		output_json(b, cmd, d);
+
+	return -b->err;
+}
@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#ifndef _TELEMETRY_OUTPUT_H_
+#define _TELEMETRY_OUTPUT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "telemetry_data.h"
+
+/* encodings a client can select for the replies on its connection */
+enum tel_output_format {
+	TEL_OUTPUT_JSON,
+	TEL_OUTPUT_CBOR,
+};
+
+/*
+ * Growable buffer holding one encoded reply. It is kept by the client
+ * connection and reused across replies, so it only gets reallocated
+ * when a reply bigger than any previous one is produced.
+ */
+struct tel_buf {
+	uint8_t *data;
+	size_t len;  /* bytes used */
+	size_t size; /* bytes allocated */
+	int err;     /* set when growing the buffer failed */
+};
+
+void
+tel_buf_free(struct tel_buf *b);
+
+/*
+ * Encode the reply to a command, i.e. a single element object/map
+ * with the command as the key and the data as the value, into the buffer.
+ * Returns 0 on success, -ENOMEM if the buffer could not be grown.
+ */
+int
+tel_output(struct tel_buf *b, enum tel_output_format fmt, const char *cmd,
+		const struct rte_tel_data *d);
+
+#endif
@@ -28,6 +28,36 @@
 
 #include "rte_timer.h"
 
+#define TIMER_WHEEL_LEVELS	4
+#define TIMER_WHEEL_BITS	8
+#define TIMER_WHEEL_SLOTS	(1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK	(TIMER_WHEEL_SLOTS - 1)
+/* number of ticks covered by the whole wheel */
+#define TIMER_WHEEL_SPAN	(1ULL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS))
+/* default tick length, in fractions of a second */
+#define TIMER_WHEEL_DEFAULT_TICK_HZ	100000
+
+/**
+ * Per-lcore hierarchical timing wheel.
+ *
+ * Slots of level n are TIMER_WHEEL_SLOTS^n ticks wide. A timer is linked
+ * in the lowest level slot able to hold its expiry tick, and each time the
+ * slots of a level wrap around, the current slot of the level above is
+ * cascaded into the lower levels.
+ *
+ * Timers are doubly linked in their slot: sl_next[0] points to the next
+ * timer and sl_next[1] stores the address of the pointer referencing the
+ * timer, or NULL when the timer is not linked in the wheel.
+ */
+struct timer_wheel {
+	uint64_t cur_tick;      /**< next tick to process */
+	uint64_t nb_pending;    /**< number of timers linked in the wheel */
+	unsigned int tick_shift; /**< log2 of tick length in timer cycles */
+	/** slots which may be non-empty, cleared when the slot is processed */
+	uint64_t occupied[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS / 64];
+	struct rte_timer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} __rte_cache_aligned;
+
 /**
  * Per-lcore info for timers.
  */
@@ -35,6 +65,9 @@ struct priv_timer {
 	struct rte_timer pending_head;  /**< dummy timer instance to head up list */
 	rte_spinlock_t list_lock;       /**< lock to protect list access */
 
+	/** timing wheel, NULL if pending timers are kept in the skiplist */
+	struct timer_wheel *wheel;
+
 	/** per-core variable that true if a timer was updated on this
 	 *  core since last reset of the variable */
 	int updated;
@@ -115,12 +148,62 @@ rte_timer_data_alloc(uint32_t *id_ptr)
 	return -ENOSPC;
 }
 
+int
+rte_timer_data_alloc_wheel(uint32_t *id_ptr, uint64_t tick_cycles)
+{
+	struct rte_timer_data *timer_data;
+	struct timer_wheel *wheels;
+	unsigned int lcore_id, tick_shift;
+	uint64_t cur_time;
+	uint32_t id;
+	int ret;
+
+	if (!rte_timer_subsystem_initialized)
+		return -ENOMEM;
+
+	if (tick_cycles == 0)
+		tick_cycles = rte_get_timer_hz() / TIMER_WHEEL_DEFAULT_TICK_HZ;
+	tick_shift = tick_cycles == 0 ? 0 : rte_fls_u64(tick_cycles) - 1;
+
+	wheels = rte_zmalloc("rte_timer_wheel",
+			RTE_MAX_LCORE * sizeof(*wheels), RTE_CACHE_LINE_SIZE);
+	if (wheels == NULL)
+		return -ENOMEM;
+
+	ret = rte_timer_data_alloc(&id);
+	if (ret < 0) {
+		rte_free(wheels);
+		return ret;
+	}
+
+	timer_data = &rte_timer_data_arr[id];
+	cur_time = rte_get_timer_cycles();
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		wheels[lcore_id].tick_shift = tick_shift;
+		wheels[lcore_id].cur_tick = cur_time >> tick_shift;
+		timer_data->priv_timer[lcore_id].wheel = &wheels[lcore_id];
+	}
+
+	if (id_ptr)
+		*id_ptr = id;
+
+	return 0;
+}
+
 int
 rte_timer_data_dealloc(uint32_t id)
 {
 	struct rte_timer_data *timer_data;
+	unsigned int lcore_id;
 	TIMER_DATA_VALID_GET_OR_ERR_RET(id, timer_data, -EINVAL);
 
+	/* wheels of all lcores are allocated as a single array */
+	if (timer_data->priv_timer[0].wheel != NULL) {
+		rte_free(timer_data->priv_timer[0].wheel);
+		for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+			timer_data->priv_timer[lcore_id].wheel = NULL;
+	}
+
 	timer_data->internal_flags &= ~(FL_ALLOCATED);
 
 	return 0;
@@ -389,6 +472,80 @@ timer_get_prev_entries_for_node(struct rte_timer *tim, unsigned tim_lcore,
 	}
 }
 
+/* link timer at the head of a wheel slot */
+static inline void
+timer_wheel_link(struct timer_wheel *wheel, unsigned int lvl,
+		 unsigned int idx, struct rte_timer *tim)
+{
+	struct rte_timer **head = &wheel->slots[lvl][idx];
+
+	tim->sl_next[0] = *head;
+	tim->sl_next[1] = (struct rte_timer *)(void *)head;
+	if (*head != NULL)
+		(*head)->sl_next[1] = (struct rte_timer *)(void *)&tim->sl_next[0];
+	*head = tim;
+	wheel->occupied[lvl][idx / 64] |= 1ULL << (idx % 64);
+}
+
+/* unlink timer from its wheel slot, the slot may be left flagged occupied */
+static inline void
+timer_wheel_unlink(struct rte_timer *tim)
+{
+	struct rte_timer **pprev = (struct rte_timer **)(void *)tim->sl_next[1];
+
+	*pprev = tim->sl_next[0];
+	if (tim->sl_next[0] != NULL)
+		tim->sl_next[0]->sl_next[1] = (struct rte_timer *)(void *)pprev;
+	tim->sl_next[1] = NULL;
+}
+
+/* detach and return the list of timers of a wheel slot */
+static inline struct rte_timer *
+timer_wheel_take_slot(struct timer_wheel *wheel, unsigned int lvl,
+		      unsigned int idx)
+{
+	struct rte_timer *tim;
+
+	if (!(wheel->occupied[lvl][idx / 64] & (1ULL << (idx % 64))))
+		return NULL;
+
+	wheel->occupied[lvl][idx / 64] &= ~(1ULL << (idx % 64));
+	tim = wheel->slots[lvl][idx];
+	wheel->slots[lvl][idx] = NULL;
+
+	return tim;
+}
+
+/* link timer in the wheel slot matching its expiry time, O(1) */
+static void
+timer_wheel_insert(struct timer_wheel *wheel, struct rte_timer *tim)
+{
+	uint64_t tick, delta;
+	unsigned int lvl;
+
+	/* round up, a timer must never run before its expiry time */
+	tick = tim->expire >> wheel->tick_shift;
+	if (tim->expire & ((1ULL << wheel->tick_shift) - 1))
+		tick++;
+
+	/* already expired timers are run on next tick */
+	if (tick < wheel->cur_tick)
+		tick = wheel->cur_tick;
+
+	/* timers beyond the wheel span are parked in the farthest slot and
+	 * placed again when it is cascaded
+	 */
+	delta = tick - wheel->cur_tick;
+	if (delta >= TIMER_WHEEL_SPAN) {
+		delta = TIMER_WHEEL_SPAN - 1;
+		tick = wheel->cur_tick + delta;
+	}
+
+	lvl = delta == 0 ? 0 : (rte_fls_u64(delta) - 1) / TIMER_WHEEL_BITS;
+	timer_wheel_link(wheel, lvl,
+		(tick >> (lvl * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK, tim);
+}
+
 /* call with lock held as necessary
  * add in list
  * timer must be in config state
@@ -400,6 +557,17 @@ timer_add(struct rte_timer *tim, unsigned int tim_lcore,
 {
 	unsigned lvl;
 	struct rte_timer *prev[MAX_SKIPLIST_DEPTH+1];
+	struct timer_wheel *wheel = priv_timer[tim_lcore].wheel;
+
+	if (wheel != NULL) {
+		/* the wheel was idle, catch up with current time */
+		if (wheel->nb_pending == 0)
+			wheel->cur_tick =
+				rte_get_timer_cycles() >> wheel->tick_shift;
+		timer_wheel_insert(wheel, tim);
+		wheel->nb_pending++;
+		return;
+	}
 
 	/* find where exactly this element goes in the list of elements
 	 * for each depth. */
@@ -446,6 +614,17 @@ timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
 	if (prev_owner != lcore_id || !local_is_locked)
 		rte_spinlock_lock(&priv_timer[prev_owner].list_lock);
 
+	if (priv_timer[prev_owner].wheel != NULL) {
+		/* periodic timers re-armed by the manager are marked
+		 * pending but are not linked in the wheel anymore
+		 */
+		if (tim->sl_next[1] != NULL) {
+			timer_wheel_unlink(tim);
+			priv_timer[prev_owner].wheel->nb_pending--;
+		}
+		goto unlock;
+	}
+
 	/* save the lowest list entry into the expire field of the dummy hdr.
 	 * NOTE: this is not atomic on 32-bit */
 	if (tim == priv_timer[prev_owner].pending_head.sl_next[0])
@@ -466,6 +645,7 @@ timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
 		else
 			break;
 
+unlock:
 	if (prev_owner != lcore_id || !local_is_locked)
 		rte_spinlock_unlock(&priv_timer[prev_owner].list_lock);
 }
@@ -657,59 +837,57 @@ rte_timer_pending(struct rte_timer *tim)
 				__ATOMIC_RELAXED) == RTE_TIMER_PENDING;
 }
 
-/* must be called periodically, run all timer that expired */
-static void
-__rte_timer_manage(struct rte_timer_data *timer_data)
+/*
+ * Detach expired timers from the skiplist of a lcore and mark them as
+ * running. Return the run list, ordered by expiry time and linked through
+ * sl_next[0].
+ */
+static struct rte_timer *
+timer_skiplist_get_expired(unsigned int lcore_id,
+			   struct priv_timer *priv_timer)
 {
-	union rte_timer_status status;
 	struct rte_timer *tim, *next_tim;
 	struct rte_timer *run_first_tim, **pprev;
-	unsigned lcore_id = rte_lcore_id();
 	struct rte_timer *prev[MAX_SKIPLIST_DEPTH + 1];
+	struct priv_timer *privp = &priv_timer[lcore_id];
 	uint64_t cur_time;
 	int i, ret;
-	struct priv_timer *priv_timer = timer_data->priv_timer;
-
-	/* timer manager only runs on EAL thread with valid lcore_id */
-	assert(lcore_id < RTE_MAX_LCORE);
 
-	__TIMER_STAT_ADD(priv_timer, manage, 1);
 	/* optimize for the case where per-cpu list is empty */
-	if (priv_timer[lcore_id].pending_head.sl_next[0] == NULL)
-		return;
+	if (privp->pending_head.sl_next[0] == NULL)
+		return NULL;
 	cur_time = rte_get_timer_cycles();
 
 #ifdef RTE_ARCH_64
 	/* on 64-bit the value cached in the pending_head.expired will be
 	 * updated atomically, so we can consult that for a quick check here
 	 * outside the lock */
-	if (likely(priv_timer[lcore_id].pending_head.expire > cur_time))
-		return;
+	if (likely(privp->pending_head.expire > cur_time))
+		return NULL;
 #endif
 
 	/* browse ordered list, add expired timers in 'expired' list */
-	rte_spinlock_lock(&priv_timer[lcore_id].list_lock);
+	rte_spinlock_lock(&privp->list_lock);
 
 	/* if nothing to do just unlock and return */
-	if (priv_timer[lcore_id].pending_head.sl_next[0] == NULL ||
-	    priv_timer[lcore_id].pending_head.sl_next[0]->expire > cur_time) {
-		rte_spinlock_unlock(&priv_timer[lcore_id].list_lock);
-		return;
+	if (privp->pending_head.sl_next[0] == NULL ||
+	    privp->pending_head.sl_next[0]->expire > cur_time) {
+		rte_spinlock_unlock(&privp->list_lock);
+		return NULL;
 	}
 
 	/* save start of list of expired timers */
-	tim = priv_timer[lcore_id].pending_head.sl_next[0];
+	tim = privp->pending_head.sl_next[0];
 
 	/* break the existing list at current time point */
 	timer_get_prev_entries(cur_time, lcore_id, prev, priv_timer);
-	for (i = priv_timer[lcore_id].curr_skiplist_depth -1; i >= 0; i--) {
-		if (prev[i] == &priv_timer[lcore_id].pending_head)
+	for (i = privp->curr_skiplist_depth - 1; i >= 0; i--) {
+		if (prev[i] == &privp->pending_head)
 			continue;
-		priv_timer[lcore_id].pending_head.sl_next[i] =
-		    prev[i]->sl_next[i];
+		privp->pending_head.sl_next[i] = prev[i]->sl_next[i];
 		if (prev[i]->sl_next[i] == NULL)
-			priv_timer[lcore_id].curr_skiplist_depth--;
-		prev[i] ->sl_next[i] = NULL;
+			privp->curr_skiplist_depth--;
+		prev[i]->sl_next[i] = NULL;
 	}
 
 	/* transition run-list from PENDING to RUNNING */
@@ -731,11 +909,158 @@ __rte_timer_manage(struct rte_timer_data *timer_data)
 	}
 
 	/* update the next to expire timer value */
-	priv_timer[lcore_id].pending_head.expire =
-	    (priv_timer[lcore_id].pending_head.sl_next[0] == NULL) ? 0 :
-		priv_timer[lcore_id].pending_head.sl_next[0]->expire;
+	privp->pending_head.expire =
+	    (privp->pending_head.sl_next[0] == NULL) ? 0 :
+		privp->pending_head.sl_next[0]->expire;
 
-	rte_spinlock_unlock(&priv_timer[lcore_id].list_lock);
+	rte_spinlock_unlock(&privp->list_lock);
+
+	return run_first_tim;
+}
+
+/*
+ * Move the timers of the current slot of each upper level into the lower
+ * levels. Called when the lowest level wraps around.
+ */
+static void
+timer_wheel_cascade(struct timer_wheel *wheel)
+{
+	struct rte_timer *tim, *next_tim;
+	unsigned int lvl, idx;
+
+	for (lvl = 1; lvl < TIMER_WHEEL_LEVELS; lvl++) {
+		idx = (wheel->cur_tick >> (lvl * TIMER_WHEEL_BITS)) &
+			TIMER_WHEEL_MASK;
+
+		for (tim = timer_wheel_take_slot(wheel, lvl, idx); tim != NULL;
+		     tim = next_tim) {
+			next_tim = tim->sl_next[0];
+			timer_wheel_insert(wheel, tim);
+		}
+
+		/* upper level wraps around too */
+		if (idx != 0)
+			break;
+	}
+}
+
+/*
+ * Advance the timing wheel of a lcore up to the current tick, detach the
+ * timers of all elapsed slots and mark them as running. Return the run list,
+ * linked through sl_next[0].
+ */
+static struct rte_timer *
+timer_wheel_get_expired(struct priv_timer *privp)
+{
+	struct timer_wheel *wheel = privp->wheel;
+	struct rte_timer *tim, *next_tim;
+	struct rte_timer *run_first_tim, **pprev;
+	uint64_t now_tick, next_tick, word;
+	unsigned int idx;
+	int ret;
+
+	/* optimize for the case where the wheel is empty */
+	if (wheel->nb_pending == 0)
+		return NULL;
+	now_tick = rte_get_timer_cycles() >> wheel->tick_shift;
+
+#ifdef RTE_ARCH_64
+	/* on 64-bit cur_tick is updated atomically, so we can consult it for
+	 * a quick check here outside the lock
+	 */
+	if (likely(wheel->cur_tick > now_tick))
+		return NULL;
+#endif
+
+	run_first_tim = NULL;
+	pprev = &run_first_tim;
+
+	rte_spinlock_lock(&privp->list_lock);
+
+	while (wheel->cur_tick <= now_tick) {
+		/* nothing left, jump to current time */
+		if (wheel->nb_pending == 0) {
+			wheel->cur_tick = now_tick + 1;
+			break;
+		}
+
+		idx = wheel->cur_tick & TIMER_WHEEL_MASK;
+		if (idx == 0)
+			timer_wheel_cascade(wheel);
+
+		/* transition the whole slot from PENDING to RUNNING */
+		for (tim = timer_wheel_take_slot(wheel, 0, idx); tim != NULL;
+		     tim = next_tim) {
+			next_tim = tim->sl_next[0];
+			tim->sl_next[1] = NULL;
+			wheel->nb_pending--;
+
+			ret = timer_set_running_state(tim);
+			if (likely(ret == 0)) {
+				*pprev = tim;
+				pprev = &tim->sl_next[0];
+			} else {
+				/* another core is trying to re-config this
+				 * one and will unlink it, keep it in the wheel
+				 */
+				timer_wheel_link(wheel, 0, idx, tim);
+				wheel->nb_pending++;
+			}
+		}
+
+		wheel->cur_tick++;
+
+		/* skip the empty slots up to the next wrap around */
+		idx = wheel->cur_tick & TIMER_WHEEL_MASK;
+		if (idx == 0)
+			continue;
+		next_tick = (wheel->cur_tick | TIMER_WHEEL_MASK) + 1;
+		for (; idx < TIMER_WHEEL_SLOTS; idx = (idx | 63) + 1) {
+			word = wheel->occupied[0][idx / 64] >> (idx % 64);
+			if (word != 0) {
+				next_tick = (wheel->cur_tick &
+					~(uint64_t)TIMER_WHEEL_MASK) +
+					idx + rte_bsf64(word);
+				break;
+			}
+		}
+		wheel->cur_tick = RTE_MIN(next_tick, now_tick + 1);
+	}
+
+	*pprev = NULL;
+
+	rte_spinlock_unlock(&privp->list_lock);
+
+	return run_first_tim;
+}
+
+static inline struct rte_timer *
+timer_get_expired(unsigned int lcore_id, struct priv_timer *priv_timer)
+{
+	if (priv_timer[lcore_id].wheel != NULL)
+		return timer_wheel_get_expired(&priv_timer[lcore_id]);
+
+	return timer_skiplist_get_expired(lcore_id, priv_timer);
+}
+
+/* must be called periodically, run all timer that expired */
+static void
+__rte_timer_manage(struct rte_timer_data *timer_data)
+{
+	union rte_timer_status status;
+	struct rte_timer *tim, *next_tim;
+	struct rte_timer *run_first_tim;
+	unsigned lcore_id = rte_lcore_id();
+	struct priv_timer *priv_timer = timer_data->priv_timer;
+
+	/* timer manager only runs on EAL thread with valid lcore_id */
+	assert(lcore_id < RTE_MAX_LCORE);
+
+	__TIMER_STAT_ADD(priv_timer, manage, 1);
+
+	run_first_tim = timer_get_expired(lcore_id, priv_timer);
+	if (run_first_tim == NULL)
+		return;
 
 	/* now scan expired list and call callbacks */
 	for (tim = run_first_tim; tim != NULL; tim = next_tim) {
@@ -804,16 +1129,12 @@ rte_timer_alt_manage(uint32_t timer_data_id,
 {
 	unsigned int default_poll_lcores[] = {rte_lcore_id()};
 	union rte_timer_status status;
-	struct rte_timer *tim, *next_tim, **pprev;
+	struct rte_timer *tim;
 	struct rte_timer *run_first_tims[RTE_MAX_LCORE];
 	unsigned int this_lcore = rte_lcore_id();
-	struct rte_timer *prev[MAX_SKIPLIST_DEPTH + 1];
-	uint64_t cur_time;
-	int i, j, ret;
+	int i;
 	int nb_runlists = 0;
 	struct rte_timer_data *data;
-	struct priv_timer *privp;
-	uint32_t poll_lcore;
 
 	TIMER_DATA_VALID_GET_OR_ERR_RET(timer_data_id, data, -EINVAL);
 
@@ -828,75 +1149,9 @@ rte_timer_alt_manage(uint32_t timer_data_id,
 	}
 
 	for (i = 0; i < nb_poll_lcores; i++) {
-		poll_lcore = poll_lcores[i];
-		privp = &data->priv_timer[poll_lcore];
-
-		/* optimize for the case where per-cpu list is empty */
-		if (privp->pending_head.sl_next[0] == NULL)
-			continue;
-		cur_time = rte_get_timer_cycles();
-
-#ifdef RTE_ARCH_64
-		/* on 64-bit the value cached in the pending_head.expired will
-		 * be updated atomically, so we can consult that for a quick
-		 * check here outside the lock
-		 */
-		if (likely(privp->pending_head.expire > cur_time))
-			continue;
-#endif
-
-		/* browse ordered list, add expired timers in 'expired' list */
-		rte_spinlock_lock(&privp->list_lock);
-
-		/* if nothing to do just unlock and return */
-		if (privp->pending_head.sl_next[0] == NULL ||
-		    privp->pending_head.sl_next[0]->expire > cur_time) {
-			rte_spinlock_unlock(&privp->list_lock);
-			continue;
-		}
-
-		/* save start of list of expired timers */
-		tim = privp->pending_head.sl_next[0];
-
-		/* break the existing list at current time point */
-		timer_get_prev_entries(cur_time, poll_lcore, prev,
-				       data->priv_timer);
-		for (j = privp->curr_skiplist_depth - 1; j >= 0; j--) {
-			if (prev[j] == &privp->pending_head)
-				continue;
-			privp->pending_head.sl_next[j] =
-				prev[j]->sl_next[j];
-			if (prev[j]->sl_next[j] == NULL)
-				privp->curr_skiplist_depth--;
-
-			prev[j]->sl_next[j] = NULL;
-		}
-
-		/* transition run-list from PENDING to RUNNING */
-		run_first_tims[nb_runlists] = tim;
-		pprev = &run_first_tims[nb_runlists];
-		nb_runlists++;
-
-		for ( ; tim != NULL; tim = next_tim) {
-			next_tim = tim->sl_next[0];
-
-			ret = timer_set_running_state(tim);
-			if (likely(ret == 0)) {
-				pprev = &tim->sl_next[0];
-			} else {
-				/* another core is trying to re-config this one,
-				 * remove it from local expired list
-				 */
-				*pprev = next_tim;
-			}
-		}
-
-		/* update the next to expire timer value */
-		privp->pending_head.expire =
-		    (privp->pending_head.sl_next[0] == NULL) ? 0 :
-			privp->pending_head.sl_next[0]->expire;
-
-		rte_spinlock_unlock(&privp->list_lock);
+		tim = timer_get_expired(poll_lcores[i], data->priv_timer);
+		if (tim != NULL)
+			run_first_tims[nb_runlists++] = tim;
 	}
 
 	/* Now process the run lists */
@@ -976,6 +1231,24 @@ rte_timer_alt_manage(uint32_t timer_data_id,
 	return 0;
 }
 
+/* Stop the timers of a pending list, lock must be held */
+static void
+timer_stop_list(struct rte_timer *tim, struct rte_timer_data *timer_data,
+		rte_timer_stop_all_cb_t f, void *f_arg)
+{
+	struct rte_timer *next_tim;
+
+	for ( ; tim != NULL; tim = next_tim) {
+		next_tim = tim->sl_next[0];
+
+		/* Call timer_stop with lock held */
+		__rte_timer_stop(tim, 1, timer_data);
+
+		if (f)
+			f(tim, f_arg);
+	}
+}
+
 /* Walk pending lists, stopping timers and calling user-specified function */
 int
 rte_timer_stop_all(uint32_t timer_data_id, unsigned int *walk_lcores,
@@ -983,9 +1256,9 @@ rte_timer_stop_all(uint32_t timer_data_id, unsigned int *walk_lcores,
 		   rte_timer_stop_all_cb_t f, void *f_arg)
 {
 	int i;
+	unsigned int lvl, idx;
 	struct priv_timer *priv_timer;
 	uint32_t walk_lcore;
-	struct rte_timer *tim, *next_tim;
 	struct rte_timer_data *timer_data;
 
 	TIMER_DATA_VALID_GET_OR_ERR_RET(timer_data_id, timer_data, -EINVAL);
@@ -996,17 +1269,15 @@ rte_timer_stop_all(uint32_t timer_data_id, unsigned int *walk_lcores,
 
 		rte_spinlock_lock(&priv_timer->list_lock);
 
-		for (tim = priv_timer->pending_head.sl_next[0];
-		     tim != NULL;
-		     tim = next_tim) {
-			next_tim = tim->sl_next[0];
-
-			/* Call timer_stop with lock held */
-			__rte_timer_stop(tim, 1, timer_data);
-
-			if (f)
-				f(tim, f_arg);
-		}
+		if (priv_timer->wheel != NULL) {
+			for (lvl = 0; lvl < TIMER_WHEEL_LEVELS; lvl++)
+				for (idx = 0; idx < TIMER_WHEEL_SLOTS; idx++)
+					timer_stop_list(
+						priv_timer->wheel->slots[lvl][idx],
+						timer_data, f, f_arg);
+		} else
+			timer_stop_list(priv_timer->pending_head.sl_next[0],
+					timer_data, f, f_arg);
 
 		rte_spinlock_unlock(&priv_timer->list_lock);
 	}
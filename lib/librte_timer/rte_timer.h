@@ -150,6 +150,39 @@ struct rte_timer
 __rte_experimental
 int rte_timer_data_alloc(uint32_t *id_ptr);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Allocate a timer data instance whose pending timers are tracked in a
+ * per-lcore hierarchical timing wheel rather than in a sorted skiplist.
+ *
+ * Arming and stopping a timer of such an instance is O(1) regardless of the
+ * number of pending timers, and rte_timer_alt_manage() collects the expired
+ * timers one wheel slot at a time. In exchange, expiry is only as precise as
+ * the wheel tick: a timer is run by the first call to rte_timer_alt_manage()
+ * after the end of the tick containing its expiry time, and timers expiring
+ * within the same tick are run in no particular order.
+ *
+ * The instance is used with the same rte_timer_alt_*() functions as one
+ * allocated with rte_timer_data_alloc(), and is released with
+ * rte_timer_data_dealloc().
+ *
+ * @param id_ptr
+ *   Pointer to variable into which to write the identifier of the allocated
+ *   timer data instance.
+ * @param tick_cycles
+ *   Length of a wheel tick in timer cycles, rounded down to a power of two.
+ *   If 0, a tick of about 10 microseconds is used.
+ *
+ * @return
+ *   - 0: Success
+ *   - -ENOSPC: maximum number of timer data instances already allocated
+ *   - -ENOMEM: timer subsystem not initialized or wheel allocation failed
+ */
+__rte_experimental
+int rte_timer_data_alloc_wheel(uint32_t *id_ptr, uint64_t tick_cycles);
+
 /**
  * @warning
  * @b EXPERIMENTAL: this API may change without prior notice
@@ -48,6 +48,9 @@ struct rte_vhost_async_channel_ops {
 	/**
 	 * instruct async engines to perform copies for a batch of packets
 	 *
+	 * The iovec arrays are only valid during the call, engines must
+	 * save the segments to copy before returning.
+	 *
 	 * @param vid
 	 *  id of vhost device to perform data copies
 	 * @param queue_id
@@ -59,7 +62,8 @@ struct rte_vhost_async_channel_ops {
 	 * @param count
 	 *  number of elements in the "descs" array
 	 * @return
-	 *  number of descs processed
+	 *  number of descs processed, the packets of the descs not processed
+	 *  are given back to the virtqueue
 	 */
 	uint32_t (*transfer_data)(int vid, uint16_t queue_id,
 		struct rte_vhost_async_desc *descs,
@@ -173,4 +177,32 @@ __rte_experimental
 uint16_t rte_vhost_poll_enqueue_completed(int vid, uint16_t queue_id,
 		struct rte_mbuf **pkts, uint16_t count);
 
+/**
+ * This function submits the packets available in a guest Tx queue
+ * to the async engine, then returns the packets whose copies are done,
+ * in the order the guest sent them. A packet is only returned once all
+ * its data has been copied, so the burst may return fewer packets than
+ * were submitted, or packets submitted by earlier calls.
+ *
+ * @param vid
+ *  id of vhost device to dequeue data
+ * @param queue_id
+ *  queue id to dequeue data
+ * @param mbuf_pool
+ *  mbuf pool where host mbufs are allocated
+ * @param pkts
+ *  blank array to get return packet pointer
+ * @param count
+ *  size of the packet array, and maximum number of packets to submit
+ * @param nr_inflight
+ *  number of packets still being copied after the call, or -1 if the
+ *  queue has no async channel registered
+ * @return
+ *  num of packets returned
+ */
+__rte_experimental
+uint16_t rte_vhost_async_try_dequeue_burst(int vid, uint16_t queue_id,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count,
+	int *nr_inflight);
+
 #endif /* _RTE_VHOST_ASYNC_H_ */
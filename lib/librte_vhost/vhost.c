@@ -12,6 +12,7 @@
 #include <numaif.h>
 #endif
 
+#include <rte_cpuflags.h>
 #include <rte_errno.h>
 #include <rte_ethdev.h>
 #include <rte_log.h>
@@ -324,18 +325,27 @@ cleanup_device(struct virtio_net *dev, int destroy)
 	}
 }
 
+void
+vhost_free_async_mem(struct vhost_virtqueue *vq)
+{
+	rte_free(vq->async_pkts_pending);
+	rte_free(vq->async_pending_info);
+	rte_free(vq->async_pkts_hdr);
+	rte_free(vq->async_buffers_packed);
+	vq->async_pkts_pending = NULL;
+	vq->async_pending_info = NULL;
+	vq->async_pkts_hdr = NULL;
+	vq->async_buffers_packed = NULL;
+}
+
 void
 free_vq(struct virtio_net *dev, struct vhost_virtqueue *vq)
 {
 	if (vq_is_packed(dev))
 		rte_free(vq->shadow_used_packed);
-	else {
+	else
 		rte_free(vq->shadow_used_split);
-		if (vq->async_pkts_pending)
-			rte_free(vq->async_pkts_pending);
-		if (vq->async_pending_info)
-			rte_free(vq->async_pending_info);
-	}
+	vhost_free_async_mem(vq);
 	rte_free(vq->batch_copy_elems);
 	rte_mempool_free(vq->iotlb_pool);
 	rte_free(vq);
@@ -639,6 +649,13 @@ vhost_new_device(void)
 	dev->postcopy_ufd = -1;
 	rte_spinlock_init(&dev->slave_req_lock);
 
+#ifdef CC_AVX512_SUPPORT
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) &&
+	    rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512BW) &&
+	    rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512VL))
+		dev->vectorized = 1;
+#endif
+
 	return i;
 }
 
@@ -1538,8 +1555,10 @@ int rte_vhost_async_channel_register(int vid, uint16_t queue_id,
 	struct vhost_virtqueue *vq;
 	struct virtio_net *dev = get_device(vid);
 	struct rte_vhost_async_features f;
+	uint32_t size;
+	int ret = -1;
 
-	if (dev == NULL || ops == NULL)
+	if (dev == NULL || ops == NULL || queue_id >= VHOST_MAX_VRING)
 		return -1;
 
 	f.intval = features;
@@ -1549,10 +1568,17 @@ int rte_vhost_async_channel_register(int vid, uint16_t queue_id,
 	if (unlikely(vq == NULL || !dev->async_copy))
 		return -1;
 
-	/* packed queue is not supported */
-	if (unlikely(vq_is_packed(dev) || !f.async_inorder)) {
+	/* completions are reported in submission order only */
+	if (unlikely(!f.async_inorder)) {
 		VHOST_LOG_CONFIG(ERR,
-			"async copy is not supported on packed queue or non-inorder mode "
+			"async copy is not supported in non-inorder mode "
+			"(vid %d, qid: %d)\n", vid, queue_id);
+		return -1;
+	}
+
+	if (unlikely((queue_id & 1) && dev->dequeue_zero_copy)) {
+		VHOST_LOG_CONFIG(ERR,
+			"async copy is not supported with dequeue zero copy "
 			"(vid %d, qid: %d)\n", vid, queue_id);
 		return -1;
 	}
@@ -1570,18 +1596,29 @@ int rte_vhost_async_channel_register(int vid, uint16_t queue_id,
 		goto reg_out;
 	}
 
+	/*
+	 * A packet takes at least one descriptor, a ring of vq->size
+	 * packets is enough, rounded up as packed rings may have any size.
+	 */
+	size = rte_align32pow2(vq->size);
 	vq->async_pkts_pending = rte_malloc(NULL,
-			vq->size * sizeof(uintptr_t),
+			size * sizeof(uintptr_t),
 			RTE_CACHE_LINE_SIZE);
 	vq->async_pending_info = rte_malloc(NULL,
-			vq->size * sizeof(uint64_t),
+			size * sizeof(uint64_t),
 			RTE_CACHE_LINE_SIZE);
-	if (!vq->async_pkts_pending || !vq->async_pending_info) {
-		if (vq->async_pkts_pending)
-			rte_free(vq->async_pkts_pending);
-
-		if (vq->async_pending_info)
-			rte_free(vq->async_pending_info);
+	/* odd queues are the guest Tx queues, dequeued by the host */
+	if (queue_id & 1)
+		vq->async_pkts_hdr = rte_malloc(NULL,
+				size * sizeof(struct virtio_net_hdr), 0);
+	if (vq_is_packed(dev))
+		vq->async_buffers_packed = rte_malloc(NULL,
+				size * sizeof(struct vring_used_elem_packed),
+				RTE_CACHE_LINE_SIZE);
+	if (!vq->async_pkts_pending || !vq->async_pending_info ||
+			((queue_id & 1) && !vq->async_pkts_hdr) ||
+			(vq_is_packed(dev) && !vq->async_buffers_packed)) {
+		vhost_free_async_mem(vq);
 
 		VHOST_LOG_CONFIG(ERR,
 				"async register failed: cannot allocate memory for vq data "
@@ -1589,6 +1626,13 @@ int rte_vhost_async_channel_register(int vid, uint16_t queue_id,
 		goto reg_out;
 	}
 
+	vq->async_pkts_size = size;
+	vq->async_pkts_idx = 0;
+	vq->async_pkts_inflight_n = 0;
+	vq->async_last_seg_n = 0;
+	vq->async_buffer_idx = 0;
+	vq->async_last_buffer_idx = 0;
+
 	vq->async_ops.check_completed_copies = ops->check_completed_copies;
 	vq->async_ops.transfer_data = ops->transfer_data;
 
@@ -1596,11 +1640,12 @@ int rte_vhost_async_channel_register(int vid, uint16_t queue_id,
 	vq->async_threshold = f.async_threshold;
 
 	vq->async_registered = true;
+	ret = 0;
 
 reg_out:
 	rte_spinlock_unlock(&vq->access_lock);
 
-	return 0;
+	return ret;
 }
 
 int rte_vhost_async_channel_unregister(int vid, uint16_t queue_id)
@@ -1609,7 +1654,7 @@ int rte_vhost_async_channel_unregister(int vid, uint16_t queue_id)
 	struct virtio_net *dev = get_device(vid);
 	int ret = -1;
 
-	if (dev == NULL)
+	if (dev == NULL || queue_id >= VHOST_MAX_VRING)
 		return ret;
 
 	vq = dev->virtqueue[queue_id];
@@ -1630,15 +1675,7 @@ int rte_vhost_async_channel_unregister(int vid, uint16_t queue_id)
 		goto out;
 	}
 
-	if (vq->async_pkts_pending) {
-		rte_free(vq->async_pkts_pending);
-		vq->async_pkts_pending = NULL;
-	}
-
-	if (vq->async_pending_info) {
-		rte_free(vq->async_pending_info);
-		vq->async_pending_info = NULL;
-	}
+	vhost_free_async_mem(vq);
 
 	vq->async_ops.transfer_data = NULL;
 	vq->async_ops.check_completed_copies = NULL;
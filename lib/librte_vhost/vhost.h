@@ -228,9 +228,17 @@ struct vhost_virtqueue {
 	#define		ASYNC_PENDING_INFO_N_MSK 0xFFFF
 	#define		ASYNC_PENDING_INFO_N_SFT 16
 	uint64_t	*async_pending_info;
+	/* virtio-net headers of in-flight dequeued packets */
+	struct virtio_net_hdr *async_pkts_hdr;
+	/* used descriptors of in-flight packets, packed ring only */
+	struct vring_used_elem_packed *async_buffers_packed;
+	/* size of the async arrays above, power of 2 */
+	uint16_t	async_pkts_size;
 	uint16_t	async_pkts_idx;
 	uint16_t	async_pkts_inflight_n;
 	uint16_t	async_last_seg_n;
+	uint16_t	async_buffer_idx;
+	uint16_t	async_last_buffer_idx;
 
 	/* vq async features */
 	bool		async_inorder;
@@ -383,6 +391,8 @@ struct virtio_net {
 	int			async_copy;
 	int			extbuf;
 	int			linearbuf;
+	/* packed ring batches use the AVX512 helpers */
+	int			vectorized;
 	struct vhost_virtqueue	*virtqueue[VHOST_MAX_QUEUE_PAIRS * 2];
 	struct inflight_mem_info *inflight_info;
 #define IF_NAME_SZ (PATH_MAX > IFNAMSIZ ? PATH_MAX : IFNAMSIZ)
@@ -711,6 +721,7 @@ void vhost_destroy_device_notify(struct virtio_net *dev);
 void cleanup_vq(struct vhost_virtqueue *vq, int destroy);
 void cleanup_vq_inflight(struct virtio_net *dev, struct vhost_virtqueue *vq);
 void free_vq(struct virtio_net *dev, struct vhost_virtqueue *vq);
+void vhost_free_async_mem(struct vhost_virtqueue *vq);
 
 int alloc_vring_queue(struct virtio_net *dev, uint32_t vring_idx);
 
@@ -753,6 +764,16 @@ vhost_iova_to_vva(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	return __vhost_iova_to_vva(dev, vq, iova, len, perm);
 }
 
+#ifdef CC_AVX512_SUPPORT
+int vhost_fetch_batch_packed_avx(struct virtio_net *dev,
+			struct vhost_virtqueue *vq, uint16_t avail_idx,
+			uint16_t single_flags, uint64_t *desc_addrs,
+			uint64_t *lens, uint16_t *ids);
+void vhost_write_used_batch_packed_avx(struct vhost_virtqueue *vq,
+			uint16_t begin, const uint64_t *lens,
+			const uint16_t *ids, uint16_t flags);
+#endif
+
 #define vhost_avail_event(vr) \
 	(*(volatile uint16_t*)&(vr)->used->ring[(vr)->size])
 #define vhost_used_event(vr) \
@@ -2004,13 +2004,8 @@ vhost_user_get_vring_base(struct virtio_net **pdev,
 	} else {
 		rte_free(vq->shadow_used_split);
 		vq->shadow_used_split = NULL;
-		if (vq->async_pkts_pending)
-			rte_free(vq->async_pkts_pending);
-		if (vq->async_pending_info)
-			rte_free(vq->async_pending_info);
-		vq->async_pkts_pending = NULL;
-		vq->async_pending_info = NULL;
 	}
+	vhost_free_async_mem(vq);
 
 	rte_free(vq->batch_copy_elems);
 	vq->batch_copy_elems = NULL;
@@ -24,8 +24,6 @@
 
 #define MAX_BATCH_LEN 256
 
-#define VHOST_ASYNC_BATCH_THRESHOLD 32
-
 static  __rte_always_inline bool
 rxvq_is_mergeable(struct virtio_net *dev)
 {
@@ -232,13 +230,96 @@ vhost_flush_dequeue_shadow_packed(struct virtio_net *dev,
 	vhost_log_cache_sync(dev, vq);
 }
 
+/*
+ * Check that the batch of descriptors at avail_idx is available, none
+ * having one of single_flags set, and translate their buffers.
+ */
+static __rte_always_inline int
+vhost_fetch_batch_packed(struct virtio_net *dev,
+			 struct vhost_virtqueue *vq,
+			 uint16_t avail_idx,
+			 uint16_t single_flags,
+			 uint64_t *desc_addrs,
+			 uint64_t *lens,
+			 uint16_t *ids)
+{
+	bool wrap = vq->avail_wrap_counter;
+	struct vring_packed_desc *descs = vq->desc_packed;
+	uint16_t flags, i;
+
+#ifdef CC_AVX512_SUPPORT
+	if (dev->vectorized)
+		return vhost_fetch_batch_packed_avx(dev, vq, avail_idx,
+				single_flags, desc_addrs, lens, ids);
+#endif
+
+	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
+		flags = descs[avail_idx + i].flags;
+		if (unlikely((wrap != !!(flags & VRING_DESC_F_AVAIL)) ||
+			     (wrap == !!(flags & VRING_DESC_F_USED))  ||
+			     (flags & single_flags)))
+			return -1;
+	}
+
+	rte_smp_rmb();
+
+	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE)
+		lens[i] = descs[avail_idx + i].len;
+
+	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
+		desc_addrs[i] = vhost_iova_to_vva(dev, vq,
+						  descs[avail_idx + i].addr,
+						  &lens[i], VHOST_ACCESS_RW);
+	}
+
+	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
+		if (unlikely(!desc_addrs[i]))
+			return -1;
+		if (unlikely(lens[i] != descs[avail_idx + i].len))
+			return -1;
+	}
+
+	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE)
+		ids[i] = descs[avail_idx + i].id;
+
+	return 0;
+}
+
+/* write the used elements of a batch, from descriptor begin on */
+static __rte_always_inline void
+vhost_write_used_batch_packed(struct virtio_net *dev,
+			      struct vhost_virtqueue *vq,
+			      uint16_t begin,
+			      uint64_t *lens,
+			      uint16_t *ids,
+			      uint16_t flags)
+{
+	uint16_t i;
+
+#ifdef CC_AVX512_SUPPORT
+	if (dev->vectorized) {
+		vhost_write_used_batch_packed_avx(vq, begin, lens, ids, flags);
+		return;
+	}
+#endif
+
+	vhost_for_each_try_unroll(i, begin, PACKED_BATCH_SIZE) {
+		vq->desc_packed[vq->last_used_idx + i].id = ids[i];
+		vq->desc_packed[vq->last_used_idx + i].len = lens[i];
+	}
+
+	rte_smp_wmb();
+
+	vhost_for_each_try_unroll(i, begin, PACKED_BATCH_SIZE)
+		vq->desc_packed[vq->last_used_idx + i].flags = flags;
+}
+
 static __rte_always_inline void
 vhost_flush_enqueue_batch_packed(struct virtio_net *dev,
 				 struct vhost_virtqueue *vq,
 				 uint64_t *lens,
 				 uint16_t *ids)
 {
-	uint16_t i;
 	uint16_t flags;
 
 	if (vq->shadow_used_idx) {
@@ -248,15 +329,7 @@ vhost_flush_enqueue_batch_packed(struct virtio_net *dev,
 
 	flags = PACKED_DESC_ENQUEUE_USED_FLAG(vq->used_wrap_counter);
 
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
-		vq->desc_packed[vq->last_used_idx + i].id = ids[i];
-		vq->desc_packed[vq->last_used_idx + i].len = lens[i];
-	}
-
-	rte_smp_wmb();
-
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE)
-		vq->desc_packed[vq->last_used_idx + i].flags = flags;
+	vhost_write_used_batch_packed(dev, vq, 0, lens, ids, flags);
 
 	vhost_log_cache_used_vring(dev, vq, vq->last_used_idx *
 				   sizeof(struct vring_packed_desc),
@@ -290,8 +363,8 @@ vhost_shadow_dequeue_batch_packed(struct virtio_net *dev,
 				  struct vhost_virtqueue *vq,
 				  uint16_t *ids)
 {
+	uint64_t lens[PACKED_BATCH_SIZE] = {0};
 	uint16_t flags;
-	uint16_t i;
 	uint16_t begin;
 
 	flags = PACKED_DESC_DEQUEUE_USED_FLAG(vq->used_wrap_counter);
@@ -307,14 +380,7 @@ vhost_shadow_dequeue_batch_packed(struct virtio_net *dev,
 	} else
 		begin = 0;
 
-	vhost_for_each_try_unroll(i, begin, PACKED_BATCH_SIZE) {
-		vq->desc_packed[vq->last_used_idx + i].id = ids[i];
-		vq->desc_packed[vq->last_used_idx + i].len = 0;
-	}
-
-	rte_smp_wmb();
-	vhost_for_each_try_unroll(i, begin, PACKED_BATCH_SIZE)
-		vq->desc_packed[vq->last_used_idx + i].flags = flags;
+	vhost_write_used_batch_packed(dev, vq, begin, lens, ids, flags);
 
 	vhost_log_cache_used_vring(dev, vq, vq->last_used_idx *
 				   sizeof(struct vring_packed_desc),
@@ -967,7 +1033,7 @@ async_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 			struct rte_mbuf *m, struct buf_vector *buf_vec,
 			uint16_t nr_vec, uint16_t num_buffers,
 			struct iovec *src_iovec, struct iovec *dst_iovec,
-			struct rte_vhost_iov_iter *src_it,
+			uint32_t nr_iovec, struct rte_vhost_iov_iter *src_it,
 			struct rte_vhost_iov_iter *dst_it)
 {
 	uint32_t vec_idx = 0;
@@ -983,7 +1049,7 @@ async_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	uint64_t mapped_len;
 
 	uint32_t tlen = 0;
-	int tvec_idx = 0;
+	uint32_t tvec_idx = 0;
 	void *hpa;
 
 	if (unlikely(m == NULL)) {
@@ -1073,7 +1139,9 @@ async_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 		cpy_len = RTE_MIN(buf_avail, mbuf_avail);
 
-		while (unlikely(cpy_len && cpy_len >= cpy_threshold)) {
+		/* the CPU copies what does not fit in the iovec pool */
+		while (unlikely(cpy_len && cpy_len >= cpy_threshold &&
+				tvec_idx < nr_iovec)) {
 			hpa = (void *)(uintptr_t)gpa_to_first_hpa(dev,
 					buf_iova + buf_offset,
 					cpy_len, &mapped_len);
@@ -1257,7 +1325,6 @@ virtio_dev_rx_batch_packed(struct virtio_net *dev,
 			   struct vhost_virtqueue *vq,
 			   struct rte_mbuf **pkts)
 {
-	bool wrap_counter = vq->avail_wrap_counter;
 	struct vring_packed_desc *descs = vq->desc_packed;
 	uint16_t avail_idx = vq->last_avail_idx;
 	uint64_t desc_addrs[PACKED_BATCH_SIZE];
@@ -1276,34 +1343,17 @@ virtio_dev_rx_batch_packed(struct virtio_net *dev,
 	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
 		if (unlikely(pkts[i]->next != NULL))
 			return -1;
-		if (unlikely(!desc_is_avail(&descs[avail_idx + i],
-					    wrap_counter)))
-			return -1;
 	}
 
-	rte_smp_rmb();
-
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE)
-		lens[i] = descs[avail_idx + i].len;
+	if (vhost_fetch_batch_packed(dev, vq, avail_idx, 0, desc_addrs,
+				     lens, ids))
+		return -1;
 
 	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
 		if (unlikely(pkts[i]->pkt_len > (lens[i] - buf_offset)))
 			return -1;
 	}
 
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE)
-		desc_addrs[i] = vhost_iova_to_vva(dev, vq,
-						  descs[avail_idx + i].addr,
-						  &lens[i],
-						  VHOST_ACCESS_RW);
-
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
-		if (unlikely(!desc_addrs[i]))
-			return -1;
-		if (unlikely(lens[i] != descs[avail_idx + i].len))
-			return -1;
-	}
-
 	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
 		rte_prefetch0((void *)(uintptr_t)desc_addrs[i]);
 		hdrs[i] = (struct virtio_net_hdr_mrg_rxbuf *)
@@ -1326,9 +1376,6 @@ virtio_dev_rx_batch_packed(struct virtio_net *dev,
 		vhost_log_cache_write_iova(dev, vq, descs[avail_idx + i].addr,
 					   lens[i]);
 
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE)
-		ids[i] = descs[avail_idx + i].id;
-
 	vhost_flush_enqueue_batch_packed(dev, vq, lens, ids);
 
 	return 0;
@@ -1465,171 +1512,327 @@ rte_vhost_enqueue_burst(int vid, uint16_t queue_id,
 	return virtio_dev_rx(dev, queue_id, pkts, count);
 }
 
+/*
+ * Ring state before a packet is taken by an async burst, restored when
+ * the copy engine refuses the packet.
+ */
+struct async_pkt_state {
+	uint16_t last_avail_idx;
+	bool avail_wrap_counter;
+	/* shadow_used_idx, or async_buffer_idx on packed rings */
+	uint16_t used_idx;
+	uint16_t batch_copy_nb_elems;
+	/* async descriptors built for the previous packets of the burst */
+	uint16_t nr_async_descs;
+};
+
+static __rte_always_inline void
+async_pkt_state_save(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct async_pkt_state *state, uint16_t nr_async_descs)
+{
+	state->last_avail_idx = vq->last_avail_idx;
+	state->avail_wrap_counter = vq->avail_wrap_counter;
+	state->used_idx = vq_is_packed(dev) ? vq->async_buffer_idx :
+		vq->shadow_used_idx;
+	state->batch_copy_nb_elems = vq->batch_copy_nb_elems;
+	state->nr_async_descs = nr_async_descs;
+}
+
+static __rte_always_inline void
+async_pkt_state_restore(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	const struct async_pkt_state *state)
+{
+	vq->last_avail_idx = state->last_avail_idx;
+	vq->avail_wrap_counter = state->avail_wrap_counter;
+	if (vq_is_packed(dev))
+		vq->async_buffer_idx = state->used_idx;
+	else
+		vq->shadow_used_idx = state->used_idx;
+	vq->batch_copy_nb_elems = state->batch_copy_nb_elems;
+}
+
+/*
+ * Submit the async descriptors of a burst of nr_pkts packets, whose
+ * states are in states[0..nr_pkts]. Returns the number of packets kept,
+ * the ring is rolled back to the first packet the engine refused.
+ */
 static __rte_always_inline uint16_t
-virtio_dev_rx_async_get_info_idx(uint16_t pkts_idx,
-	uint16_t vq_size, uint16_t n_inflight)
+async_transfer_burst(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint16_t queue_id, struct rte_vhost_async_desc *tdes,
+	const struct async_pkt_state *states, uint16_t nr_pkts)
 {
-	return pkts_idx > n_inflight ? (pkts_idx - n_inflight) :
-		(vq_size - n_inflight + pkts_idx) & (vq_size - 1);
+	uint16_t nr_async_descs = states[nr_pkts].nr_async_descs;
+	uint16_t pkt_idx;
+	int n;
+
+	if (nr_async_descs == 0)
+		return nr_pkts;
+
+	n = vq->async_ops.transfer_data(dev->vid, queue_id, tdes, 0,
+			nr_async_descs);
+	if (likely(n == nr_async_descs))
+		return nr_pkts;
+
+	if (n < 0)
+		n = 0;
+	/* find the packet holding the first refused descriptor */
+	for (pkt_idx = 0; states[pkt_idx + 1].nr_async_descs <= n; pkt_idx++)
+		;
+
+	VHOST_LOG_DATA(DEBUG, "(%d) %s: %d of %u copies accepted\n",
+		dev->vid, __func__, n, nr_async_descs);
+	async_pkt_state_restore(dev, vq, &states[pkt_idx]);
+
+	return pkt_idx;
 }
 
 static __rte_always_inline void
-virtio_dev_rx_async_submit_split_err(struct virtio_net *dev,
-	struct vhost_virtqueue *vq, uint16_t queue_id,
-	uint16_t last_idx, uint16_t shadow_idx)
+async_store_pkts(struct vhost_virtqueue *vq, struct rte_mbuf **pkts,
+	uint16_t count)
+{
+	uint16_t n_free_slot = vq->async_pkts_size - vq->async_pkts_idx;
+
+	if (n_free_slot > count) {
+		rte_memcpy(&vq->async_pkts_pending[vq->async_pkts_idx],
+			pkts, count * sizeof(uintptr_t));
+		vq->async_pkts_idx += count;
+	} else {
+		rte_memcpy(&vq->async_pkts_pending[vq->async_pkts_idx],
+			pkts, n_free_slot * sizeof(uintptr_t));
+		rte_memcpy(&vq->async_pkts_pending[0],
+			&pkts[n_free_slot],
+			(count - n_free_slot) * sizeof(uintptr_t));
+		vq->async_pkts_idx = count - n_free_slot;
+	}
+
+	vq->async_pkts_inflight_n += count;
+}
+
+/*
+ * Take up to count in-flight packets whose copies are all done, in
+ * submission order. Returns their number, with the slot of the first
+ * one and the number of used ring elements they hold.
+ */
+static __rte_always_inline uint16_t
+async_poll_completed(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint16_t queue_id, uint16_t count, uint16_t *start_idx,
+	uint16_t *n_descs)
 {
-	uint16_t start_idx, pkts_idx, vq_size;
-	uint64_t *async_pending_info;
+	uint16_t mask = vq->async_pkts_size - 1;
+	uint16_t n_inflight = vq->async_pkts_inflight_n;
+	uint16_t n_segs_cpl, n_pkts_put = 0;
+	uint64_t *async_pending_info = vq->async_pending_info;
+
+	*start_idx = (vq->async_pkts_idx - n_inflight) & mask;
+	*n_descs = 0;
+	if (n_inflight == 0)
+		return 0;
 
-	pkts_idx = vq->async_pkts_idx;
-	async_pending_info = vq->async_pending_info;
-	vq_size = vq->size;
-	start_idx = virtio_dev_rx_async_get_info_idx(pkts_idx,
-		vq_size, vq->async_pkts_inflight_n);
+	n_segs_cpl = vq->async_ops.check_completed_copies(dev->vid, queue_id,
+		0, ASYNC_MAX_POLL_SEG - vq->async_last_seg_n) +
+		vq->async_last_seg_n;
+
+	rte_smp_wmb();
 
-	while (likely((start_idx & (vq_size - 1)) != pkts_idx)) {
-		uint64_t n_seg =
-			async_pending_info[(start_idx) & (vq_size - 1)] >>
-			ASYNC_PENDING_INFO_N_SFT;
+	while (likely(n_pkts_put < count && n_inflight)) {
+		uint64_t *info = &async_pending_info[
+			(*start_idx + n_pkts_put) & mask];
+		uint64_t n_segs = *info >> ASYNC_PENDING_INFO_N_SFT;
 
-		while (n_seg)
-			n_seg -= vq->async_ops.check_completed_copies(dev->vid,
-				queue_id, 0, 1);
+		if (unlikely(n_segs_cpl < n_segs)) {
+			/* partly copied, account for it on the next poll */
+			*info -= (uint64_t)n_segs_cpl <<
+				ASYNC_PENDING_INFO_N_SFT;
+			n_segs_cpl = 0;
+			break;
+		}
+
+		n_segs_cpl -= n_segs;
+		*n_descs += *info & ASYNC_PENDING_INFO_N_MSK;
+		n_pkts_put++;
+		n_inflight--;
 	}
 
-	vq->async_pkts_inflight_n = 0;
-	vq->batch_copy_nb_elems = 0;
+	vq->async_last_seg_n = n_segs_cpl;
+	vq->async_pkts_inflight_n = n_inflight;
+
+	return n_pkts_put;
+}
+
+/* hand the used elements of completed packets to the guest */
+static __rte_always_inline void
+async_flush_used(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint16_t n_descs)
+{
+	uint16_t mask = vq->async_pkts_size - 1;
+	uint16_t i;
+
+	if (n_descs == 0)
+		return;
+
+	if (!vq_is_packed(dev)) {
+		/* split ring elements are written at submit time */
+		if (likely(vq->enabled && vq->access_ok)) {
+			__atomic_add_fetch(&vq->used->idx,
+					n_descs, __ATOMIC_RELEASE);
+			vhost_vring_call_split(dev, vq);
+		}
+		return;
+	}
+
+	if (likely(vq->enabled && vq->access_ok)) {
+		for (i = 0; i < n_descs; i++)
+			vq->shadow_used_packed[i] = vq->async_buffers_packed[
+				(vq->async_last_buffer_idx + i) & mask];
+		vq->shadow_used_idx = n_descs;
+		vhost_flush_enqueue_shadow_packed(dev, vq);
+		vhost_vring_call_packed(dev, vq);
+	}
+	vq->async_last_buffer_idx = (vq->async_last_buffer_idx + n_descs) &
+		mask;
+}
+
+static __rte_always_inline int
+async_reserve_buf_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint32_t size, struct buf_vector *buf_vec, uint16_t *num_buffers,
+	uint16_t *nr_vec)
+{
+	struct vring_used_elem_packed *elem;
+	uint16_t mask = vq->async_pkts_size - 1;
+	uint16_t max_tries, tries = 0;
+	uint16_t buf_id = 0;
+	uint16_t desc_count;
+	uint32_t len = 0;
+
+	*num_buffers = 0;
+
+	if (rxvq_is_mergeable(dev))
+		max_tries = vq->size - 1;
+	else
+		max_tries = 1;
+
+	while (size > 0) {
+		if (unlikely(++tries > max_tries))
+			return -1;
+
+		if (unlikely(fill_vec_buf_packed(dev, vq,
+						vq->last_avail_idx,
+						&desc_count, buf_vec, nr_vec,
+						&buf_id, &len,
+						VHOST_ACCESS_RW) < 0))
+			return -1;
 
-	vq->shadow_used_idx = shadow_idx;
-	vq->last_avail_idx = last_idx;
+		len = RTE_MIN(len, size);
+		size -= len;
+
+		elem = &vq->async_buffers_packed[vq->async_buffer_idx];
+		elem->id = buf_id;
+		elem->len = len;
+		elem->count = desc_count;
+		vq->async_buffer_idx = (vq->async_buffer_idx + 1) & mask;
+
+		*num_buffers += 1;
+		vq_inc_last_avail_packed(vq, desc_count);
+	}
+
+	return 0;
 }
 
 static __rte_noinline uint32_t
-virtio_dev_rx_async_submit_split(struct virtio_net *dev,
+virtio_dev_rx_async_burst(struct virtio_net *dev,
 	struct vhost_virtqueue *vq, uint16_t queue_id,
 	struct rte_mbuf **pkts, uint32_t count)
 {
-	uint32_t pkt_idx = 0, pkt_burst_idx = 0;
+	uint32_t pkt_idx = 0;
 	uint16_t num_buffers;
 	struct buf_vector buf_vec[BUF_VECTOR_MAX];
-	uint16_t avail_head, last_idx, shadow_idx;
+	uint16_t avail_head = 0;
 
 	struct rte_vhost_iov_iter *it_pool = vq->it_pool;
 	struct iovec *vec_pool = vq->vec_pool;
 	struct rte_vhost_async_desc tdes[MAX_PKT_BURST];
+	struct async_pkt_state states[MAX_PKT_BURST + 1];
 	struct iovec *src_iovec = vec_pool;
 	struct iovec *dst_iovec = vec_pool + (VHOST_MAX_ASYNC_VEC >> 1);
-	struct rte_vhost_iov_iter *src_it = it_pool;
-	struct rte_vhost_iov_iter *dst_it = it_pool + 1;
-	uint16_t n_free_slot, slot_idx;
-	int n_pkts = 0;
+	uint32_t nr_iovec = VHOST_MAX_ASYNC_VEC >> 1;
+	uint16_t mask = vq->async_pkts_size - 1;
+	uint16_t nr_async = 0;
 
-	avail_head = __atomic_load_n(&vq->avail->idx, __ATOMIC_ACQUIRE);
-	last_idx = vq->last_avail_idx;
-	shadow_idx = vq->shadow_used_idx;
+	if (vq_is_packed(dev)) {
+		rte_smp_rmb();
+	} else {
+		avail_head = __atomic_load_n(&vq->avail->idx,
+				__ATOMIC_ACQUIRE);
 
-	/*
-	 * The ordering between avail index and
-	 * desc reads needs to be enforced.
-	 */
-	rte_smp_rmb();
+		/*
+		 * The ordering between avail index and
+		 * desc reads needs to be enforced.
+		 */
+		rte_smp_rmb();
 
-	rte_prefetch0(&vq->avail->ring[vq->last_avail_idx & (vq->size - 1)]);
+		rte_prefetch0(&vq->avail->ring[vq->last_avail_idx &
+				(vq->size - 1)]);
+	}
 
 	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
 		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
+		struct rte_vhost_iov_iter *src_it = &it_pool[nr_async * 2];
+		struct rte_vhost_iov_iter *dst_it = src_it + 1;
 		uint16_t nr_vec = 0;
+		int ret;
 
-		if (unlikely(reserve_avail_buf_split(dev, vq,
-						pkt_len, buf_vec, &num_buffers,
-						avail_head, &nr_vec) < 0)) {
+		async_pkt_state_save(dev, vq, &states[pkt_idx], nr_async);
+
+		if (vq_is_packed(dev))
+			ret = async_reserve_buf_packed(dev, vq, pkt_len,
+					buf_vec, &num_buffers, &nr_vec);
+		else
+			ret = reserve_avail_buf_split(dev, vq, pkt_len,
+					buf_vec, &num_buffers, avail_head,
+					&nr_vec);
+		if (unlikely(ret < 0)) {
 			VHOST_LOG_DATA(DEBUG,
 				"(%d) failed to get enough desc from vring\n",
 				dev->vid);
-			vq->shadow_used_idx -= num_buffers;
+			async_pkt_state_restore(dev, vq, &states[pkt_idx]);
 			break;
 		}
 
 		VHOST_LOG_DATA(DEBUG, "(%d) current index %d | end index %d\n",
-			dev->vid, vq->last_avail_idx,
-			vq->last_avail_idx + num_buffers);
+			dev->vid, states[pkt_idx].last_avail_idx,
+			states[pkt_idx].last_avail_idx + num_buffers);
 
 		if (async_mbuf_to_desc(dev, vq, pkts[pkt_idx],
 				buf_vec, nr_vec, num_buffers,
-				src_iovec, dst_iovec, src_it, dst_it) < 0) {
-			vq->shadow_used_idx -= num_buffers;
+				src_iovec, dst_iovec, nr_iovec,
+				src_it, dst_it) < 0) {
+			async_pkt_state_restore(dev, vq, &states[pkt_idx]);
 			break;
 		}
 
-		slot_idx = (vq->async_pkts_idx + pkt_idx) & (vq->size - 1);
+		vq->async_pending_info[(vq->async_pkts_idx + pkt_idx) & mask] =
+			num_buffers |
+			((uint64_t)src_it->nr_segs << ASYNC_PENDING_INFO_N_SFT);
 		if (src_it->count) {
-			async_fill_desc(&tdes[pkt_burst_idx], src_it, dst_it);
-			pkt_burst_idx++;
-			vq->async_pending_info[slot_idx] =
-				num_buffers | (src_it->nr_segs << 16);
+			async_fill_desc(&tdes[nr_async++], src_it, dst_it);
 			src_iovec += src_it->nr_segs;
 			dst_iovec += dst_it->nr_segs;
-			src_it += 2;
-			dst_it += 2;
-		} else {
-			vq->async_pending_info[slot_idx] = num_buffers;
-			vq->async_pkts_inflight_n++;
+			nr_iovec -= src_it->nr_segs;
 		}
 
-		vq->last_avail_idx += num_buffers;
-
-		if (pkt_burst_idx >= VHOST_ASYNC_BATCH_THRESHOLD ||
-				(pkt_idx == count - 1 && pkt_burst_idx)) {
-			n_pkts = vq->async_ops.transfer_data(dev->vid,
-					queue_id, tdes, 0, pkt_burst_idx);
-			src_iovec = vec_pool;
-			dst_iovec = vec_pool + (VHOST_MAX_ASYNC_VEC >> 1);
-			src_it = it_pool;
-			dst_it = it_pool + 1;
-
-			if (unlikely(n_pkts < (int)pkt_burst_idx)) {
-				vq->async_pkts_inflight_n +=
-					n_pkts > 0 ? n_pkts : 0;
-				virtio_dev_rx_async_submit_split_err(dev,
-					vq, queue_id, last_idx, shadow_idx);
-				return 0;
-			}
-
-			pkt_burst_idx = 0;
-			vq->async_pkts_inflight_n += n_pkts;
-		}
+		/* split ring reservation does not move the avail index */
+		if (!vq_is_packed(dev))
+			vq->last_avail_idx += num_buffers;
 	}
 
-	if (pkt_burst_idx) {
-		n_pkts = vq->async_ops.transfer_data(dev->vid,
-				queue_id, tdes, 0, pkt_burst_idx);
-		if (unlikely(n_pkts < (int)pkt_burst_idx)) {
-			vq->async_pkts_inflight_n += n_pkts > 0 ? n_pkts : 0;
-			virtio_dev_rx_async_submit_split_err(dev, vq, queue_id,
-				last_idx, shadow_idx);
-			return 0;
-		}
-
-		vq->async_pkts_inflight_n += n_pkts;
-	}
+	async_pkt_state_save(dev, vq, &states[pkt_idx], nr_async);
+	pkt_idx = async_transfer_burst(dev, vq, queue_id, tdes, states,
+			pkt_idx);
 
 	do_data_copy_enqueue(dev, vq);
+	async_store_pkts(vq, pkts, pkt_idx);
 
-	n_free_slot = vq->size - vq->async_pkts_idx;
-	if (n_free_slot > pkt_idx) {
-		rte_memcpy(&vq->async_pkts_pending[vq->async_pkts_idx],
-			pkts, pkt_idx * sizeof(uintptr_t));
-		vq->async_pkts_idx += pkt_idx;
-	} else {
-		rte_memcpy(&vq->async_pkts_pending[vq->async_pkts_idx],
-			pkts, n_free_slot * sizeof(uintptr_t));
-		rte_memcpy(&vq->async_pkts_pending[0],
-			&pkts[n_free_slot],
-			(pkt_idx - n_free_slot) * sizeof(uintptr_t));
-		vq->async_pkts_idx = pkt_idx - n_free_slot;
-	}
-
-	if (likely(vq->shadow_used_idx))
+	if (!vq_is_packed(dev) && likely(vq->shadow_used_idx))
 		async_flush_shadow_used_ring_split(dev, vq);
 
 	return pkt_idx;
@@ -1640,10 +1843,8 @@ uint16_t rte_vhost_poll_enqueue_completed(int vid, uint16_t queue_id,
 {
 	struct virtio_net *dev = get_device(vid);
 	struct vhost_virtqueue *vq;
-	uint16_t n_segs_cpl, n_pkts_put = 0, n_descs = 0;
-	uint16_t start_idx, pkts_idx, vq_size;
-	uint16_t n_inflight;
-	uint64_t *async_pending_info;
+	uint16_t n_pkts_put, n_descs;
+	uint16_t start_idx, vq_size;
 
 	if (!dev)
 		return 0;
@@ -1659,59 +1860,16 @@ uint16_t rte_vhost_poll_enqueue_completed(int vid, uint16_t queue_id,
 
 	rte_spinlock_lock(&vq->access_lock);
 
-	n_inflight = vq->async_pkts_inflight_n;
-	pkts_idx = vq->async_pkts_idx;
-	async_pending_info = vq->async_pending_info;
-	vq_size = vq->size;
-	start_idx = virtio_dev_rx_async_get_info_idx(pkts_idx,
-		vq_size, vq->async_pkts_inflight_n);
-
-	n_segs_cpl = vq->async_ops.check_completed_copies(vid, queue_id,
-		0, ASYNC_MAX_POLL_SEG - vq->async_last_seg_n) +
-		vq->async_last_seg_n;
-
-	rte_smp_wmb();
-
-	while (likely((n_pkts_put < count) && n_inflight)) {
-		uint64_t info = async_pending_info[
-			(start_idx + n_pkts_put) & (vq_size - 1)];
-		uint64_t n_segs;
-		n_pkts_put++;
-		n_inflight--;
-		n_descs += info & ASYNC_PENDING_INFO_N_MSK;
-		n_segs = info >> ASYNC_PENDING_INFO_N_SFT;
-
-		if (n_segs) {
-			if (unlikely(n_segs_cpl < n_segs)) {
-				n_pkts_put--;
-				n_inflight++;
-				n_descs -= info & ASYNC_PENDING_INFO_N_MSK;
-				if (n_segs_cpl) {
-					async_pending_info[
-						(start_idx + n_pkts_put) &
-						(vq_size - 1)] =
-					((n_segs - n_segs_cpl) <<
-					 ASYNC_PENDING_INFO_N_SFT) |
-					(info & ASYNC_PENDING_INFO_N_MSK);
-					n_segs_cpl = 0;
-				}
-				break;
-			}
-			n_segs_cpl -= n_segs;
-		}
+	if (unlikely(!vq->async_registered)) {
+		rte_spinlock_unlock(&vq->access_lock);
+		return 0;
 	}
 
-	vq->async_last_seg_n = n_segs_cpl;
-
-	if (n_pkts_put) {
-		vq->async_pkts_inflight_n = n_inflight;
-		if (likely(vq->enabled && vq->access_ok)) {
-			__atomic_add_fetch(&vq->used->idx,
-					n_descs, __ATOMIC_RELEASE);
-			vhost_vring_call_split(dev, vq);
-		}
-	}
+	n_pkts_put = async_poll_completed(dev, vq, queue_id, count,
+			&start_idx, &n_descs);
+	async_flush_used(dev, vq, n_descs);
 
+	vq_size = vq->async_pkts_size;
 	if (start_idx + n_pkts_put <= vq_size) {
 		rte_memcpy(pkts, &vq->async_pkts_pending[start_idx],
 			n_pkts_put * sizeof(uintptr_t));
@@ -1765,12 +1923,7 @@ virtio_dev_rx_async_submit(struct virtio_net *dev, uint16_t queue_id,
 	if (count == 0)
 		goto out;
 
-	/* TODO: packed queue not implemented */
-	if (vq_is_packed(dev))
-		nb_tx = 0;
-	else
-		nb_tx = virtio_dev_rx_async_submit_split(dev,
-				vq, queue_id, pkts, count);
+	nb_tx = virtio_dev_rx_async_burst(dev, vq, queue_id, pkts, count);
 
 out:
 	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
@@ -2382,47 +2535,24 @@ vhost_reserve_avail_batch_packed(struct virtio_net *dev,
 				 struct rte_mempool *mbuf_pool,
 				 struct rte_mbuf **pkts,
 				 uint16_t avail_idx,
-				 uintptr_t *desc_addrs,
+				 uint64_t *desc_addrs,
 				 uint16_t *ids)
 {
-	bool wrap = vq->avail_wrap_counter;
-	struct vring_packed_desc *descs = vq->desc_packed;
 	struct virtio_net_hdr *hdr;
 	uint64_t lens[PACKED_BATCH_SIZE];
 	uint64_t buf_lens[PACKED_BATCH_SIZE];
 	uint32_t buf_offset = dev->vhost_hlen;
-	uint16_t flags, i;
+	uint16_t i;
 
 	if (unlikely(avail_idx & PACKED_BATCH_MASK))
 		return -1;
 	if (unlikely((avail_idx + PACKED_BATCH_SIZE) > vq->size))
 		return -1;
 
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
-		flags = descs[avail_idx + i].flags;
-		if (unlikely((wrap != !!(flags & VRING_DESC_F_AVAIL)) ||
-			     (wrap == !!(flags & VRING_DESC_F_USED))  ||
-			     (flags & PACKED_DESC_SINGLE_DEQUEUE_FLAG)))
-			return -1;
-	}
-
-	rte_smp_rmb();
-
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE)
-		lens[i] = descs[avail_idx + i].len;
-
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
-		desc_addrs[i] = vhost_iova_to_vva(dev, vq,
-						  descs[avail_idx + i].addr,
-						  &lens[i], VHOST_ACCESS_RW);
-	}
-
-	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
-		if (unlikely(!desc_addrs[i]))
-			return -1;
-		if (unlikely((lens[i] != descs[avail_idx + i].len)))
-			return -1;
-	}
+	if (vhost_fetch_batch_packed(dev, vq, avail_idx,
+				     PACKED_DESC_SINGLE_DEQUEUE_FLAG,
+				     desc_addrs, lens, ids))
+		return -1;
 
 	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
 		pkts[i] = virtio_dev_pktmbuf_alloc(dev, mbuf_pool, lens[i]);
@@ -2439,14 +2569,13 @@ vhost_reserve_avail_batch_packed(struct virtio_net *dev,
 	}
 
 	vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
-		pkts[i]->pkt_len = descs[avail_idx + i].len - buf_offset;
+		pkts[i]->pkt_len = lens[i] - buf_offset;
 		pkts[i]->data_len = pkts[i]->pkt_len;
-		ids[i] = descs[avail_idx + i].id;
 	}
 
 	if (virtio_net_with_host_offload(dev)) {
 		vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
-			hdr = (struct virtio_net_hdr *)(desc_addrs[i]);
+			hdr = (struct virtio_net_hdr *)(uintptr_t)desc_addrs[i];
 			vhost_dequeue_offload(hdr, pkts[i]);
 		}
 	}
@@ -2468,7 +2597,7 @@ virtio_dev_tx_batch_packed(struct virtio_net *dev,
 {
 	uint16_t avail_idx = vq->last_avail_idx;
 	uint32_t buf_offset = dev->vhost_hlen;
-	uintptr_t desc_addrs[PACKED_BATCH_SIZE];
+	uint64_t desc_addrs[PACKED_BATCH_SIZE];
 	uint16_t ids[PACKED_BATCH_SIZE];
 	uint16_t i;
 
@@ -2577,7 +2706,7 @@ virtio_dev_tx_batch_packed_zmbuf(struct virtio_net *dev,
 				 struct rte_mbuf **pkts)
 {
 	struct zcopy_mbuf *zmbufs[PACKED_BATCH_SIZE];
-	uintptr_t desc_addrs[PACKED_BATCH_SIZE];
+	uint64_t desc_addrs[PACKED_BATCH_SIZE];
 	uint16_t ids[PACKED_BATCH_SIZE];
 	uint16_t i;
 
@@ -2870,3 +2999,445 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 
 	return count;
 }
+
+static __rte_always_inline int
+async_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		  struct buf_vector *buf_vec, uint16_t nr_vec,
+		  struct rte_mbuf *m, struct rte_mempool *mbuf_pool,
+		  struct virtio_net_hdr *hdr,
+		  struct iovec *src_iovec, struct iovec *dst_iovec,
+		  uint32_t nr_iovec, struct rte_vhost_iov_iter *src_it,
+		  struct rte_vhost_iov_iter *dst_it)
+{
+	uint32_t buf_avail, buf_offset;
+	uint64_t buf_addr, buf_iova, buf_len;
+	uint32_t mbuf_avail, mbuf_offset;
+	uint32_t cpy_len, cpy_threshold;
+	struct rte_mbuf *cur = m, *prev = m;
+	/* A counter to avoid desc dead loop chain */
+	uint16_t vec_idx = 0;
+	struct batch_copy_elem *batch_copy = vq->batch_copy_elems;
+	int error = 0;
+	uint64_t mapped_len;
+
+	uint32_t tlen = 0;
+	uint32_t tvec_idx = 0;
+	void *hpa;
+
+	cpy_threshold = vq->async_threshold;
+
+	buf_addr = buf_vec[vec_idx].buf_addr;
+	buf_iova = buf_vec[vec_idx].buf_iova;
+	buf_len = buf_vec[vec_idx].buf_len;
+
+	if (unlikely(buf_len < dev->vhost_hlen && nr_vec <= 1)) {
+		error = -1;
+		goto out;
+	}
+
+	/*
+	 * The offloads are parsed from the packet headers, they are set
+	 * when the copy is done, keep the virtio-net header until then.
+	 */
+	if (virtio_net_with_host_offload(dev)) {
+		if (unlikely(buf_len < sizeof(struct virtio_net_hdr)))
+			copy_vnet_hdr_from_desc(hdr, buf_vec);
+		else
+			*hdr = *(struct virtio_net_hdr *)(uintptr_t)buf_addr;
+	}
+
+	if (unlikely(buf_len < dev->vhost_hlen)) {
+		buf_offset = dev->vhost_hlen - buf_len;
+		vec_idx++;
+		buf_addr = buf_vec[vec_idx].buf_addr;
+		buf_iova = buf_vec[vec_idx].buf_iova;
+		buf_len = buf_vec[vec_idx].buf_len;
+		buf_avail  = buf_len - buf_offset;
+	} else if (buf_len == dev->vhost_hlen) {
+		if (unlikely(++vec_idx >= nr_vec))
+			goto out;
+		buf_addr = buf_vec[vec_idx].buf_addr;
+		buf_iova = buf_vec[vec_idx].buf_iova;
+		buf_len = buf_vec[vec_idx].buf_len;
+
+		buf_offset = 0;
+		buf_avail = buf_len;
+	} else {
+		buf_offset = dev->vhost_hlen;
+		buf_avail = buf_vec[vec_idx].buf_len - dev->vhost_hlen;
+	}
+
+	mbuf_offset = 0;
+	mbuf_avail  = m->buf_len - RTE_PKTMBUF_HEADROOM;
+	while (1) {
+		cpy_len = RTE_MIN(buf_avail, mbuf_avail);
+
+		/* the CPU copies what does not fit in the iovec pool */
+		while (unlikely(cpy_len && cpy_len >= cpy_threshold &&
+				tvec_idx < nr_iovec)) {
+			hpa = (void *)(uintptr_t)gpa_to_first_hpa(dev,
+					buf_iova + buf_offset,
+					cpy_len, &mapped_len);
+
+			if (unlikely(!hpa || mapped_len < cpy_threshold))
+				break;
+
+			async_fill_vec(src_iovec + tvec_idx, hpa,
+				(size_t)mapped_len);
+			async_fill_vec(dst_iovec + tvec_idx,
+				(void *)(uintptr_t)rte_pktmbuf_iova_offset(cur,
+				mbuf_offset), (size_t)mapped_len);
+
+			tlen += (uint32_t)mapped_len;
+			cpy_len -= (uint32_t)mapped_len;
+			mbuf_avail  -= (uint32_t)mapped_len;
+			mbuf_offset += (uint32_t)mapped_len;
+			buf_avail  -= (uint32_t)mapped_len;
+			buf_offset += (uint32_t)mapped_len;
+			tvec_idx++;
+		}
+
+		if (likely(cpy_len)) {
+			if (cpy_len > MAX_BATCH_LEN ||
+					vq->batch_copy_nb_elems >= vq->size) {
+				rte_memcpy(rte_pktmbuf_mtod_offset(cur, void *,
+								   mbuf_offset),
+					   (void *)((uintptr_t)(buf_addr +
+							   buf_offset)),
+					   cpy_len);
+			} else {
+				batch_copy[vq->batch_copy_nb_elems].dst =
+					rte_pktmbuf_mtod_offset(cur, void *,
+								mbuf_offset);
+				batch_copy[vq->batch_copy_nb_elems].src =
+					(void *)((uintptr_t)(buf_addr +
+								buf_offset));
+				batch_copy[vq->batch_copy_nb_elems].len =
+					cpy_len;
+				vq->batch_copy_nb_elems++;
+			}
+
+			mbuf_avail  -= cpy_len;
+			mbuf_offset += cpy_len;
+			buf_avail -= cpy_len;
+			buf_offset += cpy_len;
+		}
+
+		/* This buf reaches to its end, get the next one */
+		if (buf_avail == 0) {
+			if (++vec_idx >= nr_vec)
+				break;
+
+			buf_addr = buf_vec[vec_idx].buf_addr;
+			buf_iova = buf_vec[vec_idx].buf_iova;
+			buf_len = buf_vec[vec_idx].buf_len;
+
+			buf_offset = 0;
+			buf_avail  = buf_len;
+		}
+
+		/*
+		 * This mbuf reaches to its end, get a new one
+		 * to hold more data.
+		 */
+		if (mbuf_avail == 0) {
+			cur = rte_pktmbuf_alloc(mbuf_pool);
+			if (unlikely(cur == NULL)) {
+				VHOST_LOG_DATA(ERR, "Failed to "
+					"allocate memory for mbuf.\n");
+				error = -1;
+				goto out;
+			}
+
+			prev->next = cur;
+			prev->data_len = mbuf_offset;
+			m->nb_segs += 1;
+			m->pkt_len += mbuf_offset;
+			prev = cur;
+
+			mbuf_offset = 0;
+			mbuf_avail  = cur->buf_len - RTE_PKTMBUF_HEADROOM;
+		}
+	}
+
+	prev->data_len = mbuf_offset;
+	m->pkt_len    += mbuf_offset;
+
+out:
+	async_fill_iter(src_it, tlen, src_iovec, tvec_idx);
+	async_fill_iter(dst_it, tlen, dst_iovec, tvec_idx);
+
+	return error;
+}
+
+/* take the next available descriptor chain, already marked as used */
+static __rte_always_inline int
+async_reserve_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct buf_vector *buf_vec, uint16_t *nr_vec, uint32_t *buf_len)
+{
+	struct vring_used_elem_packed *elem;
+	uint16_t buf_id, desc_count;
+
+	if (!vq_is_packed(dev)) {
+		if (unlikely(fill_vec_buf_split(dev, vq, vq->last_avail_idx,
+						nr_vec, buf_vec, &buf_id,
+						buf_len, VHOST_ACCESS_RO) < 0))
+			return -1;
+
+		update_shadow_used_ring_split(vq, buf_id, 0);
+		vq->last_avail_idx++;
+		return 0;
+	}
+
+	if (unlikely(fill_vec_buf_packed(dev, vq, vq->last_avail_idx,
+					&desc_count, buf_vec, nr_vec,
+					&buf_id, buf_len,
+					VHOST_ACCESS_RO) < 0))
+		return -1;
+
+	elem = &vq->async_buffers_packed[vq->async_buffer_idx];
+	elem->id = buf_id;
+	elem->len = 0;
+	elem->count = desc_count;
+	vq->async_buffer_idx = (vq->async_buffer_idx + 1) &
+		(vq->async_pkts_size - 1);
+
+	vq_inc_last_avail_packed(vq, desc_count);
+
+	return 0;
+}
+
+static __rte_noinline uint16_t
+virtio_dev_tx_async_burst(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint16_t queue_id, struct rte_mempool *mbuf_pool, uint16_t count)
+{
+	struct buf_vector buf_vec[BUF_VECTOR_MAX];
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	uint16_t pkt_idx, i;
+	static bool allocerr_warned;
+
+	struct rte_vhost_iov_iter *it_pool = vq->it_pool;
+	struct iovec *vec_pool = vq->vec_pool;
+	struct rte_vhost_async_desc tdes[MAX_PKT_BURST];
+	struct async_pkt_state states[MAX_PKT_BURST + 1];
+	struct iovec *src_iovec = vec_pool;
+	struct iovec *dst_iovec = vec_pool + (VHOST_MAX_ASYNC_VEC >> 1);
+	uint32_t nr_iovec = VHOST_MAX_ASYNC_VEC >> 1;
+	uint16_t mask = vq->async_pkts_size - 1;
+	uint16_t nr_async = 0;
+
+	if (!vq_is_packed(dev)) {
+		/*
+		 * The ordering between avail index and
+		 * desc reads needs to be enforced.
+		 */
+		uint16_t free_entries = __atomic_load_n(&vq->avail->idx,
+				__ATOMIC_ACQUIRE) - vq->last_avail_idx;
+
+		if (free_entries == 0)
+			return 0;
+		count = RTE_MIN(count, free_entries);
+
+		rte_prefetch0(&vq->avail->ring[vq->last_avail_idx &
+				(vq->size - 1)]);
+	}
+	count = RTE_MIN(count, MAX_PKT_BURST);
+
+	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
+		uint16_t slot_idx = (vq->async_pkts_idx + pkt_idx) & mask;
+		struct rte_vhost_iov_iter *src_it = &it_pool[nr_async * 2];
+		struct rte_vhost_iov_iter *dst_it = src_it + 1;
+		uint16_t nr_vec = 0;
+		uint32_t buf_len;
+		int err;
+
+		async_pkt_state_save(dev, vq, &states[pkt_idx], nr_async);
+
+		if (unlikely(async_reserve_desc(dev, vq, buf_vec, &nr_vec,
+						&buf_len) < 0))
+			break;
+
+		pkts[pkt_idx] = virtio_dev_pktmbuf_alloc(dev, mbuf_pool,
+				buf_len);
+		if (unlikely(pkts[pkt_idx] == NULL)) {
+			if (!allocerr_warned) {
+				VHOST_LOG_DATA(ERR,
+					"Failed mbuf alloc of size %d from %s on %s.\n",
+					buf_len, mbuf_pool->name, dev->ifname);
+				allocerr_warned = true;
+			}
+			err = -1;
+		} else {
+			err = async_desc_to_mbuf(dev, vq, buf_vec, nr_vec,
+					pkts[pkt_idx], mbuf_pool,
+					&vq->async_pkts_hdr[slot_idx],
+					src_iovec, dst_iovec, nr_iovec,
+					src_it, dst_it);
+			if (unlikely(err) && !allocerr_warned) {
+				VHOST_LOG_DATA(ERR,
+					"Failed to copy desc to mbuf on %s.\n",
+					dev->ifname);
+				allocerr_warned = true;
+			}
+		}
+
+		vq->async_pending_info[slot_idx] = 1;
+		if (unlikely(err)) {
+			/*
+			 * Drop the packet, its descriptor is still given
+			 * back so that the ring does not stall on it.
+			 */
+			vq->batch_copy_nb_elems =
+				states[pkt_idx].batch_copy_nb_elems;
+			rte_pktmbuf_free(pkts[pkt_idx]);
+			pkts[pkt_idx++] = NULL;
+			break;
+		}
+
+		vq->async_pending_info[slot_idx] |=
+			(uint64_t)src_it->nr_segs << ASYNC_PENDING_INFO_N_SFT;
+		if (src_it->count) {
+			async_fill_desc(&tdes[nr_async++], src_it, dst_it);
+			src_iovec += src_it->nr_segs;
+			dst_iovec += dst_it->nr_segs;
+			nr_iovec -= src_it->nr_segs;
+		}
+	}
+
+	async_pkt_state_save(dev, vq, &states[pkt_idx], nr_async);
+	i = async_transfer_burst(dev, vq, queue_id, tdes, states, pkt_idx);
+	while (pkt_idx > i)
+		rte_pktmbuf_free(pkts[--pkt_idx]);
+
+	do_data_copy_dequeue(vq);
+	async_store_pkts(vq, pkts, pkt_idx);
+
+	if (!vq_is_packed(dev) && likely(vq->shadow_used_idx))
+		async_flush_shadow_used_ring_split(dev, vq);
+
+	return pkt_idx;
+}
+
+static __rte_always_inline uint16_t
+virtio_dev_tx_async_poll(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint16_t queue_id, struct rte_mbuf **pkts, uint16_t count)
+{
+	uint16_t mask = vq->async_pkts_size - 1;
+	uint16_t start_idx, n_descs, n_pkts_put, i;
+	uint16_t nb_pkts = 0;
+	bool offload = virtio_net_with_host_offload(dev);
+
+	n_pkts_put = async_poll_completed(dev, vq, queue_id, count,
+			&start_idx, &n_descs);
+	async_flush_used(dev, vq, n_descs);
+
+	for (i = 0; i < n_pkts_put; i++) {
+		uint16_t slot_idx = (start_idx + i) & mask;
+		struct rte_mbuf *m =
+			(struct rte_mbuf *)vq->async_pkts_pending[slot_idx];
+
+		/* dropped on submit */
+		if (unlikely(m == NULL))
+			continue;
+
+		if (offload)
+			vhost_dequeue_offload(&vq->async_pkts_hdr[slot_idx], m);
+		pkts[nb_pkts++] = m;
+	}
+
+	return nb_pkts;
+}
+
+uint16_t
+rte_vhost_async_try_dequeue_burst(int vid, uint16_t queue_id,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count,
+	int *nr_inflight)
+{
+	struct virtio_net *dev;
+	struct rte_mbuf *rarp_mbuf = NULL;
+	struct vhost_virtqueue *vq;
+	int16_t success = 1;
+
+	*nr_inflight = -1;
+
+	dev = get_device(vid);
+	if (!dev)
+		return 0;
+
+	if (unlikely(!(dev->flags & VIRTIO_DEV_BUILTIN_VIRTIO_NET))) {
+		VHOST_LOG_DATA(ERR,
+			"(%d) %s: built-in vhost net backend is disabled.\n",
+			dev->vid, __func__);
+		return 0;
+	}
+
+	if (unlikely(!is_valid_virt_queue_idx(queue_id, 1, dev->nr_vring))) {
+		VHOST_LOG_DATA(ERR,
+			"(%d) %s: invalid virtqueue idx %d.\n",
+			dev->vid, __func__, queue_id);
+		return 0;
+	}
+
+	vq = dev->virtqueue[queue_id];
+
+	if (unlikely(rte_spinlock_trylock(&vq->access_lock) == 0))
+		return 0;
+
+	if (unlikely(!vq->async_registered)) {
+		VHOST_LOG_DATA(ERR,
+			"(%d) %s: async not registered for queue id %d.\n",
+			dev->vid, __func__, queue_id);
+		count = 0;
+		goto out_access_unlock;
+	}
+
+	/* copies in flight complete even when the ring is stopped */
+	if (unlikely(vq->enabled == 0))
+		goto out_poll;
+
+	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+		vhost_user_iotlb_rd_lock(vq);
+
+	if (unlikely(vq->access_ok == 0))
+		if (unlikely(vring_translate(dev, vq) < 0))
+			goto out;
+
+	/* See rte_vhost_dequeue_burst() */
+	if (unlikely(__atomic_load_n(&dev->broadcast_rarp, __ATOMIC_ACQUIRE) &&
+			__atomic_compare_exchange_n(&dev->broadcast_rarp,
+			&success, 0, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))) {
+
+		rarp_mbuf = rte_net_make_rarp_packet(mbuf_pool, &dev->mac);
+		if (rarp_mbuf == NULL) {
+			VHOST_LOG_DATA(ERR, "Failed to make RARP packet.\n");
+			count = 0;
+			goto out;
+		}
+		count -= 1;
+	}
+
+	virtio_dev_tx_async_burst(dev, vq, queue_id, mbuf_pool, count);
+
+out:
+	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+		vhost_user_iotlb_rd_unlock(vq);
+
+out_poll:
+	count = virtio_dev_tx_async_poll(dev, vq, queue_id, pkts, count);
+	*nr_inflight = vq->async_pkts_inflight_n;
+
+out_access_unlock:
+	rte_spinlock_unlock(&vq->access_lock);
+
+	if (unlikely(rarp_mbuf != NULL)) {
+		/*
+		 * Inject it to the head of "pkts" array, so that switch's mac
+		 * learning table will get updated first.
+		 */
+		memmove(&pkts[1], pkts, count * sizeof(struct rte_mbuf *));
+		pkts[0] = rarp_mbuf;
+		count += 1;
+	}
+
+	return count;
+}
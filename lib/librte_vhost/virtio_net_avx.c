@@ -0,0 +1,167 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 agent
+ */
+
+#include <stdint.h>
+
+#include <rte_vect.h>
+
+#include "vhost.h"
+
+/*
+ * A batch of PACKED_BATCH_SIZE packed descriptors fills one cache line,
+ * it is loaded and stored with a single 512 bits access. Each descriptor
+ * is two 64 bits words: the address, then len, id and flags.
+ */
+#define BYTE_SIZE 8
+
+#define DESC_ID_BITS_OFFSET ((offsetof(struct vring_packed_desc, id) - \
+	offsetof(struct vring_packed_desc, len)) * BYTE_SIZE)
+#define DESC_FLAGS_BITS_OFFSET ((offsetof(struct vring_packed_desc, flags) - \
+	offsetof(struct vring_packed_desc, len)) * BYTE_SIZE)
+
+/* 16 bits lanes of the descriptor flags, len and id in a batch */
+#define DESC_FLAGS_LANES 0x80808080
+#define DESC_LEN_ID_LANES 0x70707070
+#define DESC_LANES_PER_DESC 8
+
+/* 64 bits lanes of the descriptor addresses and of len, id and flags */
+#define DESC_ADDR_QWORDS 0x55
+#define DESC_INFO_QWORDS 0xaa
+
+#define BATCH_LANES_MASK ((1 << PACKED_BATCH_SIZE) - 1)
+
+/*
+ * Check that the batch of descriptors at avail_idx is available, none
+ * having one of single_flags set, then get their ids, lengths and
+ * host addresses. Descriptors crossing a memory region are refused, as
+ * in the scalar path.
+ */
+int
+vhost_fetch_batch_packed_avx(struct virtio_net *dev,
+			     struct vhost_virtqueue *vq,
+			     uint16_t avail_idx,
+			     uint16_t single_flags,
+			     uint64_t *desc_addrs,
+			     uint64_t *lens,
+			     uint16_t *ids)
+{
+	struct vring_packed_desc *descs = vq->desc_packed;
+	struct rte_vhost_mem_region *reg;
+	uint16_t flags_mask, flags_expected;
+	__mmask8 in_reg, found;
+	uint32_t i;
+
+	RTE_BUILD_BUG_ON(PACKED_BATCH_SIZE * sizeof(struct vring_packed_desc)
+			!= sizeof(__m512i));
+	RTE_BUILD_BUG_ON(DESC_ID_BITS_OFFSET != 32);
+	RTE_BUILD_BUG_ON(DESC_FLAGS_BITS_OFFSET != 48);
+
+	flags_mask = VRING_DESC_F_AVAIL | VRING_DESC_F_USED | single_flags;
+	flags_expected = vq->avail_wrap_counter ? VRING_DESC_F_AVAIL :
+		VRING_DESC_F_USED;
+
+	__m512i v_desc = _mm512_loadu_si512((void *)&descs[avail_idx]);
+	__m512i v_flags = _mm512_and_si512(v_desc,
+			_mm512_set1_epi16(flags_mask));
+	if (unlikely(_mm512_mask_cmpneq_epu16_mask(DESC_FLAGS_LANES, v_flags,
+					_mm512_set1_epi16(flags_expected))))
+		return -1;
+
+	rte_smp_rmb();
+
+	/* the other fields are only valid once the flags are seen */
+	v_desc = _mm512_loadu_si512((void *)&descs[avail_idx]);
+
+	__m256i v_addr = _mm512_castsi512_si256(
+			_mm512_maskz_compress_epi64(DESC_ADDR_QWORDS, v_desc));
+	__m256i v_info = _mm512_castsi512_si256(
+			_mm512_maskz_compress_epi64(DESC_INFO_QWORDS, v_desc));
+	__m256i v_len = _mm256_and_si256(v_info,
+			_mm256_set1_epi64x(UINT32_MAX));
+
+	_mm256_storeu_si256((void *)lens, v_len);
+	_mm_storel_epi64((void *)ids, _mm256_cvtepi64_epi16(
+			_mm256_srli_epi64(v_info, DESC_ID_BITS_OFFSET)));
+
+	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM)) {
+		vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
+			desc_addrs[i] = vhost_iova_to_vva(dev, vq,
+					descs[avail_idx + i].addr,
+					&lens[i], VHOST_ACCESS_RW);
+		}
+
+		vhost_for_each_try_unroll(i, 0, PACKED_BATCH_SIZE) {
+			if (unlikely(!desc_addrs[i]))
+				return -1;
+			if (unlikely(lens[i] != descs[avail_idx + i].len))
+				return -1;
+		}
+
+		return 0;
+	}
+
+	/* look up the regions of the four buffers at once */
+	__m256i v_offset = _mm256_setzero_si256();
+	found = 0;
+	for (i = 0; i < dev->mem->nregions; i++) {
+		reg = &dev->mem->regions[i];
+
+		__m256i v_size = _mm256_set1_epi64x(reg->size);
+		__m256i v_rel = _mm256_sub_epi64(v_addr,
+				_mm256_set1_epi64x(reg->guest_phys_addr));
+
+		in_reg = _mm256_cmplt_epu64_mask(v_rel, v_size);
+		in_reg = _mm256_mask_cmple_epu64_mask(in_reg, v_len,
+				_mm256_sub_epi64(v_size, v_rel));
+		v_offset = _mm256_mask_mov_epi64(v_offset, in_reg,
+				_mm256_set1_epi64x(reg->host_user_addr -
+					reg->guest_phys_addr));
+
+		found |= in_reg;
+		if (found == BATCH_LANES_MASK)
+			break;
+	}
+
+	if (unlikely(found != BATCH_LANES_MASK))
+		return -1;
+
+	_mm256_storeu_si256((void *)desc_addrs,
+			_mm256_add_epi64(v_addr, v_offset));
+
+	return 0;
+}
+
+/*
+ * Write the used ring elements of a batch from descriptor begin on, the
+ * flags being written after the ids and lengths.
+ */
+void
+vhost_write_used_batch_packed_avx(struct vhost_virtqueue *vq,
+				  uint16_t begin,
+				  const uint64_t *lens,
+				  const uint16_t *ids,
+				  uint16_t flags)
+{
+	__mmask32 lanes = UINT32_MAX << (begin * DESC_LANES_PER_DESC);
+
+	__m256i v_len = _mm256_and_si256(_mm256_loadu_si256((const void *)lens),
+			_mm256_set1_epi64x(UINT32_MAX));
+	__m256i v_id = _mm256_cvtepu16_epi64(
+			_mm_loadl_epi64((const void *)ids));
+	__m256i v_info = _mm256_or_si256(v_len,
+			_mm256_slli_epi64(v_id, DESC_ID_BITS_OFFSET));
+	v_info = _mm256_or_si256(v_info,
+			_mm256_set1_epi64x((uint64_t)flags <<
+				DESC_FLAGS_BITS_OFFSET));
+
+	__m512i v_desc = _mm512_maskz_expand_epi64(DESC_INFO_QWORDS,
+			_mm512_castsi256_si512(v_info));
+	void *used = &vq->desc_packed[vq->last_used_idx];
+
+	_mm512_mask_storeu_epi16(used, lanes & DESC_LEN_ID_LANES, v_desc);
+
+	rte_smp_wmb();
+
+	_mm512_mask_storeu_epi16(used, lanes & DESC_FLAGS_LANES, v_desc);
+}